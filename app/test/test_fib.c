@@ -0,0 +1,447 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include <rte_ip.h>
+#include <rte_random.h>
+#include <rte_rib.h>
+#include <rte_fib.h>
+
+#include "test.h"
+
+#define MAX_ROUTES	(1 << 16)
+#define MAX_TBL8	(1 << 14)
+#define NUM_CHECK_ROUTES	1024
+#define NUM_CHECK_IPS	(NUM_CHECK_ROUTES * 4 + 1024)
+
+/*
+ * Check that rte_fib_create fails gracefully for incorrect user input
+ * arguments
+ */
+static int32_t
+test_create_invalid(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = 0;
+	config.type = RTE_FIB_DUMMY;
+
+	/* rte_fib_create: fib name == NULL */
+	fib = rte_fib_create(NULL, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	/* rte_fib_create: config == NULL */
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, NULL);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	/* rte_fib_create: max_routes = 0 */
+	config.max_routes = 0;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+	config.max_routes = MAX_ROUTES;
+
+	config.type = RTE_FIB_TYPE_MAX;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	config.type = RTE_FIB_DIR24_8;
+	config.dir24_8.num_tbl8 = MAX_TBL8;
+
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_8B + 1;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_8B;
+
+	config.dir24_8.num_tbl8 = 0;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	/* the number of tbl8s must fit into a next hop entry */
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_1B;
+	config.dir24_8.num_tbl8 = MAX_TBL8;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	/* as well as the default next hop */
+	config.dir24_8.num_tbl8 = 127;
+	config.default_nh = 128;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Create fib table then delete fib table 10 times
+ * Use a slightly different rules size each time
+ */
+static int32_t
+test_multiple_create(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	int32_t i;
+
+	config.default_nh = 0;
+	config.type = RTE_FIB_DUMMY;
+
+	for (i = 0; i < 10; i++) {
+		config.max_routes = MAX_ROUTES - i;
+		fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+		RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+		rte_fib_free(fib);
+	}
+	/* Can not test free so return success */
+	return TEST_SUCCESS;
+}
+
+/*
+ * Call rte_fib_free for NULL pointer user input. Note: free has no return and
+ * therefore it is impossible to check for failure but this test is added to
+ * increase function coverage metrics and to validate that freeing null does
+ * not crash.
+ */
+static int32_t
+test_free_null(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = 0;
+	config.type = RTE_FIB_DUMMY;
+
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	rte_fib_free(fib);
+	rte_fib_free(NULL);
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check that rte_fib_add and rte_fib_delete fails gracefully
+ * for incorrect user input arguments
+ */
+static int32_t
+test_add_del_invalid(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	uint64_t nh = 100;
+	uint32_t ip = RTE_IPV4(0, 0, 0, 0);
+	int ret;
+	uint8_t depth = 24;
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = 0;
+	config.type = RTE_FIB_DUMMY;
+
+	/* rte_fib_add: fib == NULL */
+	ret = rte_fib_add(NULL, ip, depth, nh);
+	RTE_TEST_ASSERT(ret < 0,
+		"Call succeeded with invalid parameters\n");
+
+	/* rte_fib_delete: fib == NULL */
+	ret = rte_fib_delete(NULL, ip, depth);
+	RTE_TEST_ASSERT(ret < 0,
+		"Call succeeded with invalid parameters\n");
+
+	/*Create valid fib to use in rest of test. */
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* rte_fib_add: depth > RTE_FIB_MAXDEPTH */
+	ret = rte_fib_add(fib, ip, RTE_FIB_MAXDEPTH + 1, nh);
+	RTE_TEST_ASSERT(ret < 0,
+		"Call succeeded with invalid parameters\n");
+
+	/* rte_fib_delete: depth > RTE_FIB_MAXDEPTH */
+	ret = rte_fib_delete(fib, ip, RTE_FIB_MAXDEPTH + 1);
+	RTE_TEST_ASSERT(ret < 0,
+		"Call succeeded with invalid parameters\n");
+
+	rte_fib_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check that rte_fib_get_dp and rte_fib_get_rib fails gracefully
+ * for incorrect user input arguments
+ */
+static int32_t
+test_get_invalid(void)
+{
+	void *p;
+
+	p = rte_fib_get_dp(NULL);
+	RTE_TEST_ASSERT(p == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	p = rte_fib_get_rib(NULL);
+	RTE_TEST_ASSERT(p == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	return TEST_SUCCESS;
+}
+
+struct check_route {
+	uint32_t ip;
+	uint8_t depth;
+	uint64_t nh;
+};
+
+static struct check_route check_routes[NUM_CHECK_ROUTES];
+static uint32_t check_ips[NUM_CHECK_IPS];
+static uint64_t check_nh[NUM_CHECK_IPS];
+
+static const enum rte_fib_lookup_type check_lookup_types[] = {
+	RTE_FIB_LOOKUP_DIR24_8_SCALAR,
+	RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX2,
+	RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512,
+};
+
+/*
+ * Generate routes nested into each other, so that the more specific
+ * ones split the less specific ones across tbl24 and tbl8 levels.
+ */
+static void
+generate_check_routes(uint64_t max_nh)
+{
+	struct check_route *base;
+	uint32_t i, j;
+	uint8_t depth;
+
+	for (i = 0; i < NUM_CHECK_ROUTES; i++) {
+		if ((i != 0) && (rte_rand() & 1)) {
+			base = &check_routes[rte_rand() % i];
+			depth = base->depth + rte_rand() %
+				(RTE_FIB_MAXDEPTH - base->depth + 1);
+			check_routes[i].ip = (base->ip |
+				((uint32_t)rte_rand() &
+				~rte_rib_depth_to_mask(base->depth))) &
+				rte_rib_depth_to_mask(depth);
+		} else {
+			/* keep the short prefixes rare, they are costly */
+			depth = (i == 0) ? 0 :
+				12 + rte_rand() % (RTE_FIB_MAXDEPTH - 11);
+			check_routes[i].ip = (uint32_t)rte_rand() &
+				rte_rib_depth_to_mask(depth);
+		}
+		check_routes[i].depth = depth;
+		check_routes[i].nh = rte_rand() % (max_nh + 1);
+	}
+
+	/* probe the edges of every route as well as random addresses */
+	for (i = 0, j = 0; i < NUM_CHECK_ROUTES; i++) {
+		check_ips[j++] = check_routes[i].ip;
+		check_ips[j++] = check_routes[i].ip - 1;
+		check_ips[j++] = check_routes[i].ip +
+			~rte_rib_depth_to_mask(check_routes[i].depth);
+		check_ips[j++] = check_routes[i].ip +
+			~rte_rib_depth_to_mask(check_routes[i].depth) + 1;
+	}
+	for (; j < NUM_CHECK_IPS; j++)
+		check_ips[j] = rte_rand();
+}
+
+/*
+ * Compare the results of all the available lookup functions
+ * with the most specific route found in the RIB.
+ */
+static int
+check_fib(struct rte_fib *fib, uint64_t def_nh)
+{
+	struct rte_rib *rib = rte_fib_get_rib(fib);
+	struct rte_rib_node *node;
+	uint64_t nh;
+	uint32_t i, t;
+	int ret;
+
+	for (t = 0; t < RTE_DIM(check_lookup_types); t++) {
+		if (rte_fib_select_lookup(fib, check_lookup_types[t]) != 0)
+			continue;
+		ret = rte_fib_lookup_bulk(fib, check_ips, check_nh,
+			NUM_CHECK_IPS);
+		RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+		for (i = 0; i < NUM_CHECK_IPS; i++) {
+			node = rte_rib_lookup(rib, check_ips[i]);
+			if (node != NULL)
+				rte_rib_get_nh(node, &nh);
+			else
+				nh = def_nh;
+			RTE_TEST_ASSERT(check_nh[i] == nh,
+				"Lookup type %d of %08x returned %" PRIu64
+				" instead of %" PRIu64 "\n",
+				check_lookup_types[t], check_ips[i],
+				check_nh[i], nh);
+		}
+	}
+
+	return TEST_SUCCESS;
+}
+
+static int
+check_fib_nh_sz(enum rte_fib_dir24_8_nh_sz nh_sz, uint32_t num_tbl8)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	uint64_t max_nh = (1ULL << ((8 << nh_sz) - 1)) - 1;
+	uint32_t i;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.type = RTE_FIB_DIR24_8;
+	config.default_nh = rte_rand() % (max_nh + 1);
+	config.dir24_8.nh_sz = nh_sz;
+	config.dir24_8.num_tbl8 = num_tbl8;
+
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	generate_check_routes(max_nh);
+
+	for (i = 0; i < NUM_CHECK_ROUTES; i++) {
+		ret = rte_fib_add(fib, check_routes[i].ip,
+			check_routes[i].depth, check_routes[i].nh);
+		RTE_TEST_ASSERT((ret == 0) || (ret == -ENOSPC),
+			"Failed to add a route\n");
+	}
+	ret = check_fib(fib, config.default_nh);
+	if (ret != TEST_SUCCESS)
+		goto out;
+
+	/* delete every other route, then the rest of them */
+	for (i = 0; i < NUM_CHECK_ROUTES; i += 2)
+		rte_fib_delete(fib, check_routes[i].ip, check_routes[i].depth);
+	ret = check_fib(fib, config.default_nh);
+	if (ret != TEST_SUCCESS)
+		goto out;
+
+	for (i = 1; i < NUM_CHECK_ROUTES; i += 2)
+		rte_fib_delete(fib, check_routes[i].ip, check_routes[i].depth);
+	ret = check_fib(fib, config.default_nh);
+
+out:
+	rte_fib_free(fib);
+	return ret;
+}
+
+/*
+ * Add and remove a set of overlapping routes and check that all the
+ * lookup implementations agree with the RIB for every next hop size.
+ */
+static int32_t
+test_lookup(void)
+{
+	int ret;
+
+	ret = check_fib_nh_sz(RTE_FIB_DIR24_8_1B, 127);
+	if (ret != TEST_SUCCESS)
+		return ret;
+	ret = check_fib_nh_sz(RTE_FIB_DIR24_8_2B, MAX_TBL8);
+	if (ret != TEST_SUCCESS)
+		return ret;
+	ret = check_fib_nh_sz(RTE_FIB_DIR24_8_4B, MAX_TBL8);
+	if (ret != TEST_SUCCESS)
+		return ret;
+	return check_fib_nh_sz(RTE_FIB_DIR24_8_8B, MAX_TBL8);
+}
+
+/*
+ * Check that running out of tbl8 groups is reported at add time
+ * and leaves the FIB consistent.
+ */
+static int32_t
+test_tbl8_exhaustion(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	uint32_t i, num_tbl8;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.type = RTE_FIB_DIR24_8;
+	config.default_nh = 0;
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_4B;
+	config.dir24_8.num_tbl8 = 64;
+
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* every /32 in a distinct /24 takes a tbl8 group */
+	for (i = 0; ; i++) {
+		ret = rte_fib_add(fib, RTE_IPV4(10, 0, i, 1), 32, i + 1);
+		if (ret != 0)
+			break;
+	}
+	num_tbl8 = i;
+	RTE_TEST_ASSERT(ret == -ENOSPC, "Unexpected error %d\n", ret);
+	RTE_TEST_ASSERT(num_tbl8 == 64, "Only %u tbl8 groups available\n",
+		num_tbl8);
+
+	/* more routes inside the already extended /24s still fit */
+	ret = rte_fib_add(fib, RTE_IPV4(10, 0, 0, 128), 25, 1000);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+
+	/* and a tbl8 group is available again once a /24 is released */
+	ret = rte_fib_delete(fib, RTE_IPV4(10, 0, 1, 1), 32);
+	RTE_TEST_ASSERT(ret == 0, "Failed to delete a route\n");
+	ret = rte_fib_add(fib, RTE_IPV4(10, 1, 0, 1), 32, 1001);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+
+	for (i = 0; i < 256; i++) {
+		check_ips[i] = RTE_IPV4(10, 0, i, 1);
+		check_ips[i + 256] = RTE_IPV4(10, 0, 0, i);
+	}
+	check_ips[512] = RTE_IPV4(10, 1, 0, 1);
+	for (i = 513; i < NUM_CHECK_IPS; i++)
+		check_ips[i] = rte_rand();
+	ret = check_fib(fib, 0);
+
+	rte_fib_free(fib);
+	return ret;
+}
+
+static struct unit_test_suite fib_tests = {
+	.suite_name = "fib autotest",
+	.setup = NULL,
+	.teardown = NULL,
+	.unit_test_cases = {
+		TEST_CASE(test_create_invalid),
+		TEST_CASE(test_multiple_create),
+		TEST_CASE(test_free_null),
+		TEST_CASE(test_add_del_invalid),
+		TEST_CASE(test_get_invalid),
+		TEST_CASE(test_lookup),
+		TEST_CASE(test_tbl8_exhaustion),
+		TEST_CASES_END()
+	}
+};
+
+/*
+ * Do all unit tests.
+ */
+static int
+test_fib(void)
+{
+	return unit_test_suite_runner(&fib_tests);
+}
+
+REGISTER_TEST_COMMAND(fib_autotest, test_fib);
@@ -0,0 +1,488 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <rte_memory.h>
+#include <rte_random.h>
+#include <rte_rib6.h>
+#include <rte_fib6.h>
+
+#include "test.h"
+
+#define MAX_ROUTES	(1 << 16)
+#define MAX_TBL8	(1 << 14)
+#define NUM_CHECK_ROUTES	1024
+#define NUM_CHECK_IPS	(NUM_CHECK_ROUTES * 4 + 1024)
+
+/*
+ * Check that rte_fib6_create fails gracefully for incorrect user input
+ * arguments
+ */
+static int32_t
+test_create_invalid(void)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config;
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = 0;
+	config.type = RTE_FIB6_DUMMY;
+
+	/* rte_fib6_create: fib name == NULL */
+	fib = rte_fib6_create(NULL, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	/* rte_fib6_create: config == NULL */
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, NULL);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	/* rte_fib6_create: max_routes = 0 */
+	config.max_routes = 0;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+	config.max_routes = MAX_ROUTES;
+
+	config.type = RTE_FIB6_TYPE_MAX;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	config.type = RTE_FIB6_TRIE;
+	config.trie.num_tbl8 = MAX_TBL8;
+
+	config.trie.nh_sz = RTE_FIB6_TRIE_8B + 1;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+	config.trie.nh_sz = RTE_FIB6_TRIE_8B;
+
+	config.trie.num_tbl8 = 0;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	/* the number of tbl8s must fit into a next hop entry */
+	config.trie.nh_sz = RTE_FIB6_TRIE_2B;
+	config.trie.num_tbl8 = 1 << 15;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	/* as well as the default next hop */
+	config.trie.num_tbl8 = MAX_TBL8;
+	config.default_nh = 1 << 15;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Create fib table then delete fib table 10 times
+ * Use a slightly different rules size each time
+ */
+static int32_t
+test_multiple_create(void)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config;
+	int32_t i;
+
+	config.default_nh = 0;
+	config.type = RTE_FIB6_DUMMY;
+
+	for (i = 0; i < 10; i++) {
+		config.max_routes = MAX_ROUTES - i;
+		fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+		RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+		rte_fib6_free(fib);
+	}
+	/* Can not test free so return success */
+	return TEST_SUCCESS;
+}
+
+/*
+ * Call rte_fib6_free for NULL pointer user input. Note: free has no return and
+ * therefore it is impossible to check for failure but this test is added to
+ * increase function coverage metrics and to validate that freeing null does
+ * not crash.
+ */
+static int32_t
+test_free_null(void)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config;
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = 0;
+	config.type = RTE_FIB6_DUMMY;
+
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	rte_fib6_free(fib);
+	rte_fib6_free(NULL);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check that rte_fib6_add and rte_fib6_delete fails gracefully
+ * for incorrect user input arguments
+ */
+static int32_t
+test_add_del_invalid(void)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config;
+	uint64_t nh = 100;
+	uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE] = {0};
+	int ret;
+	uint8_t depth = 24;
+
+	config.max_routes = MAX_ROUTES;
+	config.default_nh = 0;
+	config.type = RTE_FIB6_DUMMY;
+
+	/* rte_fib6_add: fib == NULL */
+	ret = rte_fib6_add(NULL, ip, depth, nh);
+	RTE_TEST_ASSERT(ret < 0,
+		"Call succeeded with invalid parameters\n");
+
+	/* rte_fib6_delete: fib == NULL */
+	ret = rte_fib6_delete(NULL, ip, depth);
+	RTE_TEST_ASSERT(ret < 0,
+		"Call succeeded with invalid parameters\n");
+
+	/*Create valid fib to use in rest of test. */
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* rte_fib6_add: depth > RTE_FIB6_MAXDEPTH */
+	ret = rte_fib6_add(fib, ip, RTE_FIB6_MAXDEPTH + 1, nh);
+	RTE_TEST_ASSERT(ret < 0,
+		"Call succeeded with invalid parameters\n");
+
+	/* rte_fib6_delete: depth > RTE_FIB6_MAXDEPTH */
+	ret = rte_fib6_delete(fib, ip, RTE_FIB6_MAXDEPTH + 1);
+	RTE_TEST_ASSERT(ret < 0,
+		"Call succeeded with invalid parameters\n");
+
+	rte_fib6_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check that rte_fib6_get_dp and rte_fib6_get_rib fails gracefully
+ * for incorrect user input arguments
+ */
+static int32_t
+test_get_invalid(void)
+{
+	void *p;
+
+	p = rte_fib6_get_dp(NULL);
+	RTE_TEST_ASSERT(p == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	p = rte_fib6_get_rib(NULL);
+	RTE_TEST_ASSERT(p == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	return TEST_SUCCESS;
+}
+
+struct check_route {
+	uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE];
+	uint8_t depth;
+	uint64_t nh;
+};
+
+static struct check_route check_routes[NUM_CHECK_ROUTES];
+static uint8_t check_ips[NUM_CHECK_IPS][RTE_FIB6_IPV6_ADDR_SIZE];
+static uint64_t check_nh[NUM_CHECK_IPS];
+
+static const enum rte_fib6_lookup_type check_lookup_types[] = {
+	RTE_FIB6_LOOKUP_TRIE_SCALAR,
+	RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512,
+};
+
+static void
+random_ip(uint8_t *ip)
+{
+	int i;
+
+	for (i = 0; i < RTE_FIB6_IPV6_ADDR_SIZE; i++)
+		ip[i] = rte_rand();
+}
+
+/* add (or subtract when neg is set) one to the address */
+static void
+ip_step(uint8_t *ip, int neg)
+{
+	int i;
+
+	for (i = RTE_FIB6_IPV6_ADDR_SIZE - 1; i >= 0; i--) {
+		ip[i] += neg ? -1 : 1;
+		if (ip[i] != (neg ? UINT8_MAX : 0))
+			break;
+	}
+}
+
+/*
+ * Generate routes nested into each other, so that the more specific
+ * ones split the less specific ones across the trie levels.
+ */
+static void
+generate_check_routes(uint64_t max_nh)
+{
+	struct check_route *base;
+	uint32_t i, j, k;
+	uint8_t depth;
+
+	for (i = 0; i < NUM_CHECK_ROUTES; i++) {
+		random_ip(check_routes[i].ip);
+		if ((i != 0) && (rte_rand() & 1)) {
+			base = &check_routes[rte_rand() % i];
+			depth = base->depth + rte_rand() %
+				(RTE_FIB6_MAXDEPTH - base->depth + 1);
+			for (k = 0; k < RTE_FIB6_IPV6_ADDR_SIZE; k++)
+				check_routes[i].ip[k] = (base->ip[k] &
+					rte_rib6_get_msk_part(base->depth, k)) |
+					(check_routes[i].ip[k] &
+					~rte_rib6_get_msk_part(base->depth, k));
+		} else {
+			/* keep the short prefixes rare, they are costly */
+			depth = (i == 0) ? 0 :
+				12 + rte_rand() % (RTE_FIB6_MAXDEPTH - 11);
+		}
+		for (k = 0; k < RTE_FIB6_IPV6_ADDR_SIZE; k++)
+			check_routes[i].ip[k] &= rte_rib6_get_msk_part(depth, k);
+		check_routes[i].depth = depth;
+		check_routes[i].nh = rte_rand() % (max_nh + 1);
+	}
+
+	/* probe the edges of every route as well as random addresses */
+	for (i = 0, j = 0; i < NUM_CHECK_ROUTES; i++) {
+		rte_rib6_copy_addr(check_ips[j], check_routes[i].ip);
+		rte_rib6_copy_addr(check_ips[j + 1], check_routes[i].ip);
+		ip_step(check_ips[j + 1], 1);
+		for (k = 0; k < RTE_FIB6_IPV6_ADDR_SIZE; k++)
+			check_ips[j + 2][k] = check_routes[i].ip[k] |
+				(uint8_t)~rte_rib6_get_msk_part(
+				check_routes[i].depth, k);
+		rte_rib6_copy_addr(check_ips[j + 3], check_ips[j + 2]);
+		ip_step(check_ips[j + 3], 0);
+		j += 4;
+	}
+	for (; j < NUM_CHECK_IPS; j++)
+		random_ip(check_ips[j]);
+}
+
+/*
+ * Compare the results of all the available lookup functions
+ * with the most specific route found in the RIB.
+ */
+static int
+check_fib(struct rte_fib6 *fib, uint64_t def_nh)
+{
+	struct rte_rib6 *rib = rte_fib6_get_rib(fib);
+	struct rte_rib6_node *node;
+	uint64_t nh;
+	uint32_t i, t;
+	int ret;
+
+	for (t = 0; t < RTE_DIM(check_lookup_types); t++) {
+		if (rte_fib6_select_lookup(fib, check_lookup_types[t]) != 0)
+			continue;
+		ret = rte_fib6_lookup_bulk(fib, check_ips, check_nh,
+			NUM_CHECK_IPS);
+		RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+		for (i = 0; i < NUM_CHECK_IPS; i++) {
+			node = rte_rib6_lookup(rib, check_ips[i]);
+			if (node != NULL)
+				rte_rib6_get_nh(node, &nh);
+			else
+				nh = def_nh;
+			RTE_TEST_ASSERT(check_nh[i] == nh,
+				"Lookup type %d of address %u returned %"
+				PRIu64 " instead of %" PRIu64 "\n",
+				check_lookup_types[t], i, check_nh[i], nh);
+		}
+	}
+
+	return TEST_SUCCESS;
+}
+
+static int
+check_fib_nh_sz(enum rte_fib6_trie_nh_sz nh_sz)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config;
+	uint64_t max_nh = (1ULL << ((8 << nh_sz) - 1)) - 1;
+	uint32_t i;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.type = RTE_FIB6_TRIE;
+	config.default_nh = rte_rand() % (max_nh + 1);
+	config.trie.nh_sz = nh_sz;
+	config.trie.num_tbl8 = MAX_TBL8;
+
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	generate_check_routes(max_nh);
+
+	for (i = 0; i < NUM_CHECK_ROUTES; i++) {
+		ret = rte_fib6_add(fib, check_routes[i].ip,
+			check_routes[i].depth, check_routes[i].nh);
+		RTE_TEST_ASSERT((ret == 0) || (ret == -ENOSPC),
+			"Failed to add a route\n");
+	}
+	ret = check_fib(fib, config.default_nh);
+	if (ret != TEST_SUCCESS)
+		goto out;
+
+	/* delete every other route, then the rest of them */
+	for (i = 0; i < NUM_CHECK_ROUTES; i += 2)
+		rte_fib6_delete(fib, check_routes[i].ip,
+			check_routes[i].depth);
+	ret = check_fib(fib, config.default_nh);
+	if (ret != TEST_SUCCESS)
+		goto out;
+
+	for (i = 1; i < NUM_CHECK_ROUTES; i += 2)
+		rte_fib6_delete(fib, check_routes[i].ip,
+			check_routes[i].depth);
+	ret = check_fib(fib, config.default_nh);
+
+out:
+	rte_fib6_free(fib);
+	return ret;
+}
+
+/*
+ * Add and remove a set of overlapping routes and check that all the
+ * lookup implementations agree with the RIB for every next hop size.
+ */
+static int32_t
+test_lookup(void)
+{
+	int ret;
+
+	ret = check_fib_nh_sz(RTE_FIB6_TRIE_2B);
+	if (ret != TEST_SUCCESS)
+		return ret;
+	ret = check_fib_nh_sz(RTE_FIB6_TRIE_4B);
+	if (ret != TEST_SUCCESS)
+		return ret;
+	return check_fib_nh_sz(RTE_FIB6_TRIE_8B);
+}
+
+/*
+ * Check that running out of tbl8 groups is reported at add time
+ * and leaves the FIB consistent.
+ */
+static int32_t
+test_tbl8_exhaustion(void)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config;
+	uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE] = {0x20, 0x01, 0};
+	uint32_t i, num_tbl8;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.type = RTE_FIB6_TRIE;
+	config.default_nh = 0;
+	config.trie.nh_sz = RTE_FIB6_TRIE_4B;
+	config.trie.num_tbl8 = 64;
+
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	/* every /32 in a distinct /24 takes a tbl8 group */
+	for (i = 0; ; i++) {
+		ip[2] = i;
+		ret = rte_fib6_add(fib, ip, 32, i + 1);
+		if (ret != 0)
+			break;
+	}
+	num_tbl8 = i;
+	RTE_TEST_ASSERT(ret == -ENOSPC, "Unexpected error %d\n", ret);
+	RTE_TEST_ASSERT(num_tbl8 == 64, "Only %u tbl8 groups available\n",
+		num_tbl8);
+
+	/* more routes inside the already extended /24s still fit */
+	ip[2] = 0;
+	ip[3] = 0x80;
+	ret = rte_fib6_add(fib, ip, 25, 1000);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+
+	/* while a /40 needs one more level */
+	ret = rte_fib6_add(fib, ip, 40, 1001);
+	RTE_TEST_ASSERT(ret == -ENOSPC, "Unexpected error %d\n", ret);
+
+	/* which is available again once a /24 is released */
+	ip[2] = 1;
+	ip[3] = 0;
+	ret = rte_fib6_delete(fib, ip, 32);
+	RTE_TEST_ASSERT(ret == 0, "Failed to delete a route\n");
+	ip[2] = 0;
+	ip[3] = 0x80;
+	ret = rte_fib6_add(fib, ip, 40, 1001);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+
+	for (i = 0; i < NUM_CHECK_IPS; i++) {
+		random_ip(check_ips[i]);
+		if (i < 512) {
+			check_ips[i][0] = 0x20;
+			check_ips[i][1] = 0x01;
+			check_ips[i][2] = i & 0xff;
+			check_ips[i][3] = (i & 0x100) ? 0x80 : 0;
+		}
+	}
+	ret = check_fib(fib, 0);
+
+	rte_fib6_free(fib);
+	return ret;
+}
+
+static struct unit_test_suite fib6_tests = {
+	.suite_name = "fib6 autotest",
+	.setup = NULL,
+	.teardown = NULL,
+	.unit_test_cases = {
+		TEST_CASE(test_create_invalid),
+		TEST_CASE(test_multiple_create),
+		TEST_CASE(test_free_null),
+		TEST_CASE(test_add_del_invalid),
+		TEST_CASE(test_get_invalid),
+		TEST_CASE(test_lookup),
+		TEST_CASE(test_tbl8_exhaustion),
+		TEST_CASES_END()
+	}
+};
+
+/*
+ * Do all unit tests.
+ */
+static int
+test_fib6(void)
+{
+	return unit_test_suite_runner(&fib6_tests);
+}
+
+REGISTER_TEST_COMMAND(fib6_autotest, test_fib6);
@@ -0,0 +1,963 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_byteorder.h>
+#include <rte_gro.h>
+
+#include "test.h"
+
+#define MBUF_DATA_SIZE (RTE_PKTMBUF_HEADROOM + 256)
+#define PAYLOAD_LEN 100
+#define HDR_LEN (sizeof(struct rte_ether_hdr) + \
+		sizeof(struct rte_ipv4_hdr) + sizeof(struct rte_tcp_hdr))
+#define FIRST_SEQ 1000
+#define HDR6_LEN (sizeof(struct rte_ether_hdr) + \
+		sizeof(struct rte_ipv6_hdr) + sizeof(struct rte_tcp_hdr))
+
+/* UDP/IPv4 datagrams are sent as NB_FRAGS fragments of FRAG_LEN bytes */
+#define FRAG_LEN 104
+#define NB_FRAGS 3
+#define FRAG_HDR_LEN (sizeof(struct rte_ether_hdr) + \
+		sizeof(struct rte_ipv4_hdr))
+#define VXLAN_HDR_LEN (FRAG_HDR_LEN + sizeof(struct rte_udp_hdr) + \
+		sizeof(struct rte_vxlan_hdr))
+#define VXLAN_PORT 4789
+#define BURST 32
+
+/* perf test: per-packet cost for a growing number of concurrent flows */
+#define PERF_SEGS_PER_FLOW 4
+#define PERF_MIN_FLOWS 8
+#define PERF_MAX_FLOWS 4096
+#define PERF_TOTAL_PKTS (64 * PERF_MAX_FLOWS)
+/* the cost with PERF_MAX_FLOWS may grow with cache misses only */
+#define PERF_MAX_COST_RATIO 8
+
+#define NB_MBUF (PERF_MAX_FLOWS * PERF_SEGS_PER_FLOW + 1024)
+
+static struct rte_mempool *gro_pool;
+
+/*
+ * Build the seg-th full sized segment of a TCP/IPv4 flow. The flows
+ * differ in their IPv4 source address and TCP source port.
+ */
+static struct rte_mbuf *
+build_tcp4_pkt(uint32_t flow, uint32_t seg)
+{
+	struct rte_ether_hdr *eth_hdr;
+	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_tcp_hdr *tcp_hdr;
+	struct rte_mbuf *pkt;
+	char *data;
+
+	pkt = rte_pktmbuf_alloc(gro_pool);
+	if (pkt == NULL)
+		return NULL;
+	data = rte_pktmbuf_append(pkt, HDR_LEN + PAYLOAD_LEN);
+	if (data == NULL) {
+		rte_pktmbuf_free(pkt);
+		return NULL;
+	}
+	memset(data, 0, HDR_LEN + PAYLOAD_LEN);
+
+	eth_hdr = (struct rte_ether_hdr *)data;
+	eth_hdr->s_addr.addr_bytes[5] = 1;
+	eth_hdr->d_addr.addr_bytes[5] = 2;
+	eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+
+	ipv4_hdr = (struct rte_ipv4_hdr *)(eth_hdr + 1);
+	ipv4_hdr->version_ihl = RTE_IPV4_VHL_DEF;
+	ipv4_hdr->total_length = rte_cpu_to_be_16(sizeof(*ipv4_hdr) +
+			sizeof(*tcp_hdr) + PAYLOAD_LEN);
+	ipv4_hdr->fragment_offset = rte_cpu_to_be_16(RTE_IPV4_HDR_DF_FLAG);
+	ipv4_hdr->time_to_live = 64;
+	ipv4_hdr->next_proto_id = IPPROTO_TCP;
+	ipv4_hdr->src_addr = rte_cpu_to_be_32(RTE_IPV4(10, 0, 0, 0) + flow);
+	ipv4_hdr->dst_addr = rte_cpu_to_be_32(RTE_IPV4(192, 168, 0, 1));
+
+	tcp_hdr = (struct rte_tcp_hdr *)(ipv4_hdr + 1);
+	tcp_hdr->src_port = rte_cpu_to_be_16(1024 + (flow & 0x7fff));
+	tcp_hdr->dst_port = rte_cpu_to_be_16(80);
+	tcp_hdr->sent_seq = rte_cpu_to_be_32(FIRST_SEQ + seg * PAYLOAD_LEN);
+	tcp_hdr->recv_ack = rte_cpu_to_be_32(1);
+	tcp_hdr->data_off = (sizeof(*tcp_hdr) / 4) << 4;
+	tcp_hdr->tcp_flags = RTE_TCP_ACK_FLAG;
+	tcp_hdr->rx_win = rte_cpu_to_be_16(0xffff);
+
+	pkt->packet_type = RTE_PTYPE_L2_ETHER | RTE_PTYPE_L3_IPV4 |
+		RTE_PTYPE_L4_TCP;
+	pkt->l2_len = sizeof(*eth_hdr);
+	pkt->l3_len = sizeof(*ipv4_hdr);
+	pkt->l4_len = sizeof(*tcp_hdr);
+
+	return pkt;
+}
+
+/* Build nb_segs segments of nb_flows flows, segment by segment. */
+static int
+build_tcp4_pkts(struct rte_mbuf **pkts, uint32_t nb_flows, uint32_t nb_segs)
+{
+	uint32_t flow, seg, n = 0;
+
+	for (seg = 0; seg < nb_segs; seg++) {
+		for (flow = 0; flow < nb_flows; flow++) {
+			pkts[n] = build_tcp4_pkt(flow, seg);
+			if (pkts[n] == NULL) {
+				rte_pktmbuf_free_bulk(pkts, n);
+				return -1;
+			}
+			n++;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Check that a packet coming out of GRO holds nb_segs segments of a
+ * flow, starting from the first one, and hasn't been seen before.
+ */
+static int
+check_merged_pkt(struct rte_mbuf *pkt, uint32_t nb_segs, uint8_t *seen,
+		uint32_t nb_flows)
+{
+	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_tcp_hdr *tcp_hdr;
+	uint32_t flow;
+
+	ipv4_hdr = rte_pktmbuf_mtod_offset(pkt, struct rte_ipv4_hdr *,
+			sizeof(struct rte_ether_hdr));
+	tcp_hdr = (struct rte_tcp_hdr *)(ipv4_hdr + 1);
+	flow = rte_be_to_cpu_32(ipv4_hdr->src_addr) - RTE_IPV4(10, 0, 0, 0);
+
+	if (flow >= nb_flows || seen[flow]) {
+		printf("unexpected or duplicated flow %u\n", flow);
+		return -1;
+	}
+	seen[flow] = 1;
+
+	if (pkt->nb_segs != nb_segs ||
+			pkt->pkt_len != HDR_LEN + nb_segs * PAYLOAD_LEN) {
+		printf("flow %u: %u segments, %u bytes\n",
+			flow, pkt->nb_segs, pkt->pkt_len);
+		return -1;
+	}
+	if (rte_be_to_cpu_16(ipv4_hdr->total_length) !=
+			pkt->pkt_len - sizeof(struct rte_ether_hdr)) {
+		printf("flow %u: wrong IPv4 length\n", flow);
+		return -1;
+	}
+	if (rte_be_to_cpu_32(tcp_hdr->sent_seq) != FIRST_SEQ) {
+		printf("flow %u: wrong TCP sequence number\n", flow);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_gro_burst(void)
+{
+	struct rte_gro_param param = {
+		.gro_types = RTE_GRO_TCP_IPV4,
+		.max_flow_num = 8,
+		.max_item_per_flow = 4,
+	};
+	struct rte_mbuf *pkts[BURST];
+	uint8_t seen[8] = {0};
+	uint16_t nb_pkts, i;
+	int ret = 0;
+
+	if (build_tcp4_pkts(pkts, 8, 4) < 0)
+		return -1;
+
+	nb_pkts = rte_gro_reassemble_burst(pkts, BURST, &param);
+	if (nb_pkts != 8) {
+		printf("%u packets after GRO, expected 8\n", nb_pkts);
+		ret = -1;
+	}
+	for (i = 0; i < nb_pkts && ret == 0; i++)
+		ret = check_merged_pkt(pkts[i], 4, seen, 8);
+
+	rte_pktmbuf_free_bulk(pkts, nb_pkts);
+	return ret;
+}
+
+/* Store nb_flows flows of nb_segs segments in a GRO context. */
+static int
+fill_gro_ctx(void *ctx, uint32_t nb_flows, uint32_t nb_segs)
+{
+	struct rte_mbuf *pkts[nb_flows * nb_segs];
+	uint32_t i, n;
+	uint16_t nb_unprocessed = 0;
+
+	if (build_tcp4_pkts(pkts, nb_flows, nb_segs) < 0)
+		return -1;
+
+	for (i = 0; i < nb_flows * nb_segs; i += n) {
+		n = RTE_MIN((uint32_t)BURST, nb_flows * nb_segs - i);
+		nb_unprocessed = rte_gro_reassemble(&pkts[i], n, ctx);
+		if (nb_unprocessed != 0)
+			break;
+	}
+	if (nb_unprocessed != 0) {
+		printf("%u packets not processed\n", nb_unprocessed);
+		rte_pktmbuf_free_bulk(&pkts[i], nb_unprocessed);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Flush a context a few packets at a time, so that flows get deleted
+ * in the middle of the flow array.
+ */
+static int
+flush_gro_ctx(void *ctx, uint32_t nb_flows, uint32_t nb_segs)
+{
+	struct rte_mbuf *pkts[BURST];
+	uint8_t seen[nb_flows];
+	uint32_t total = 0;
+	uint16_t nb_pkts, i;
+	int ret = 0;
+
+	memset(seen, 0, sizeof(seen));
+	do {
+		nb_pkts = rte_gro_timeout_flush(ctx, 0, RTE_GRO_TCP_IPV4,
+				pkts, 7);
+		for (i = 0; i < nb_pkts && ret == 0; i++)
+			ret = check_merged_pkt(pkts[i], nb_segs, seen,
+					nb_flows);
+		rte_pktmbuf_free_bulk(pkts, nb_pkts);
+		total += nb_pkts;
+	} while (nb_pkts > 0);
+
+	if (ret == 0 && total != nb_flows) {
+		printf("%u packets flushed, expected %u\n", total, nb_flows);
+		ret = -1;
+	}
+	if (rte_gro_get_pkt_count(ctx) != 0) {
+		printf("packets left after flushing\n");
+		ret = -1;
+	}
+	return ret;
+}
+
+static int
+test_gro_ctx(void)
+{
+	struct rte_gro_param param = {
+		.gro_types = RTE_GRO_TCP_IPV4,
+		.max_flow_num = 1024,
+		.max_item_per_flow = 2,
+		.socket_id = rte_socket_id(),
+	};
+	void *ctx;
+	int ret;
+
+	ctx = rte_gro_ctx_create(&param);
+	if (ctx == NULL) {
+		printf("cannot create GRO context\n");
+		return -1;
+	}
+
+	ret = fill_gro_ctx(ctx, 1024, 2);
+	if (ret == 0 && rte_gro_get_pkt_count(ctx) != 1024) {
+		printf("%"PRIu64" packets in the table, expected 1024\n",
+			rte_gro_get_pkt_count(ctx));
+		ret = -1;
+	}
+	if (ret == 0)
+		ret = flush_gro_ctx(ctx, 1024, 2);
+
+	/* refill the table, reusing the released flows and items */
+	if (ret == 0)
+		ret = fill_gro_ctx(ctx, 512, 4);
+	if (ret == 0)
+		ret = flush_gro_ctx(ctx, 512, 4);
+
+	rte_gro_ctx_destroy(ctx);
+	return ret;
+}
+
+static int
+test_gro_reorder(void)
+{
+	struct rte_gro_param param = {
+		.gro_types = RTE_GRO_TCP_IPV4,
+		.max_flow_num = 4,
+		.max_item_per_flow = 4,
+		.socket_id = rte_socket_id(),
+	};
+	struct rte_mbuf *pkts[3];
+	uint8_t seen[1] = {0};
+	uint16_t nb_pkts;
+	void *ctx;
+	int ret = 0;
+
+	ctx = rte_gro_ctx_create(&param);
+	if (ctx == NULL) {
+		printf("cannot create GRO context\n");
+		return -1;
+	}
+
+	/* segments 1 and 2 are merged, then segment 0 is pre-pended */
+	pkts[0] = build_tcp4_pkt(0, 1);
+	pkts[1] = build_tcp4_pkt(0, 2);
+	pkts[2] = build_tcp4_pkt(0, 0);
+	if (pkts[0] == NULL || pkts[1] == NULL || pkts[2] == NULL) {
+		rte_pktmbuf_free(pkts[0]);
+		rte_pktmbuf_free(pkts[1]);
+		rte_pktmbuf_free(pkts[2]);
+		rte_gro_ctx_destroy(ctx);
+		return -1;
+	}
+
+	if (rte_gro_reassemble(pkts, 3, ctx) != 0) {
+		printf("packets not processed\n");
+		ret = -1;
+	}
+	nb_pkts = rte_gro_timeout_flush(ctx, 0, RTE_GRO_TCP_IPV4, pkts, 3);
+	if (ret == 0 && nb_pkts != 1) {
+		printf("%u packets flushed, expected 1\n", nb_pkts);
+		ret = -1;
+	}
+	if (ret == 0)
+		ret = check_merged_pkt(pkts[0], 3, seen, 1);
+	rte_pktmbuf_free_bulk(pkts, nb_pkts);
+
+	rte_gro_ctx_destroy(ctx);
+	return ret;
+}
+
+static int
+test_gro_tbl_full(void)
+{
+	struct rte_gro_param param = {
+		.gro_types = RTE_GRO_TCP_IPV4,
+		.max_flow_num = 4,
+		.max_item_per_flow = 1,
+		.socket_id = rte_socket_id(),
+	};
+	struct rte_mbuf *pkts[5];
+	uint16_t nb_pkts;
+	void *ctx;
+	int ret = 0;
+
+	ctx = rte_gro_ctx_create(&param);
+	if (ctx == NULL) {
+		printf("cannot create GRO context\n");
+		return -1;
+	}
+	if (build_tcp4_pkts(pkts, 5, 1) < 0) {
+		rte_gro_ctx_destroy(ctx);
+		return -1;
+	}
+
+	/* the table holds 4 packets, the 5th flow is given back */
+	nb_pkts = rte_gro_reassemble(pkts, 5, ctx);
+	if (nb_pkts != 1 || rte_gro_get_pkt_count(ctx) != 4) {
+		printf("%u packets not processed, expected 1\n", nb_pkts);
+		ret = -1;
+	}
+	rte_pktmbuf_free_bulk(pkts, nb_pkts);
+
+	nb_pkts = rte_gro_timeout_flush(ctx, 0, RTE_GRO_TCP_IPV4, pkts, 5);
+	if (ret == 0 && nb_pkts != 4) {
+		printf("%u packets flushed, expected 4\n", nb_pkts);
+		ret = -1;
+	}
+	rte_pktmbuf_free_bulk(pkts, nb_pkts);
+
+	rte_gro_ctx_destroy(ctx);
+	return ret;
+}
+
+/*
+ * Build the frag-th fragment of a UDP/IPv4 datagram, optionally
+ * encapsulated in VxLAN. The datagrams differ in their IPv4 ID.
+ */
+static struct rte_mbuf *
+build_udp4_frag(uint16_t ip_id, uint32_t frag, int vxlan)
+{
+	struct rte_ether_hdr *eth_hdr;
+	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_udp_hdr *udp_hdr;
+	struct rte_vxlan_hdr *vxlan_hdr;
+	struct rte_mbuf *pkt;
+	uint16_t outer_len = vxlan ? VXLAN_HDR_LEN : 0;
+	uint16_t frag_offset;
+	char *data;
+
+	pkt = rte_pktmbuf_alloc(gro_pool);
+	if (pkt == NULL)
+		return NULL;
+	data = rte_pktmbuf_append(pkt, outer_len + FRAG_HDR_LEN + FRAG_LEN);
+	if (data == NULL) {
+		rte_pktmbuf_free(pkt);
+		return NULL;
+	}
+	memset(data, 0, outer_len + FRAG_HDR_LEN + FRAG_LEN);
+
+	if (vxlan) {
+		eth_hdr = (struct rte_ether_hdr *)data;
+		eth_hdr->s_addr.addr_bytes[5] = 3;
+		eth_hdr->d_addr.addr_bytes[5] = 4;
+		eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+
+		ipv4_hdr = (struct rte_ipv4_hdr *)(eth_hdr + 1);
+		ipv4_hdr->version_ihl = RTE_IPV4_VHL_DEF;
+		ipv4_hdr->total_length = rte_cpu_to_be_16(outer_len -
+				sizeof(*eth_hdr) + FRAG_HDR_LEN + FRAG_LEN);
+		ipv4_hdr->time_to_live = 64;
+		ipv4_hdr->next_proto_id = IPPROTO_UDP;
+		ipv4_hdr->src_addr = rte_cpu_to_be_32(RTE_IPV4(172, 16, 0, 1));
+		ipv4_hdr->dst_addr = rte_cpu_to_be_32(RTE_IPV4(172, 16, 0, 2));
+
+		udp_hdr = (struct rte_udp_hdr *)(ipv4_hdr + 1);
+		udp_hdr->src_port = rte_cpu_to_be_16(49152 + frag);
+		udp_hdr->dst_port = rte_cpu_to_be_16(VXLAN_PORT);
+		udp_hdr->dgram_len = rte_cpu_to_be_16(sizeof(*udp_hdr) +
+				sizeof(*vxlan_hdr) + FRAG_HDR_LEN + FRAG_LEN);
+
+		vxlan_hdr = (struct rte_vxlan_hdr *)(udp_hdr + 1);
+		vxlan_hdr->vx_flags = rte_cpu_to_be_32(0x08000000);
+		vxlan_hdr->vx_vni = rte_cpu_to_be_32(100 << 8);
+		data += outer_len;
+	}
+
+	eth_hdr = (struct rte_ether_hdr *)data;
+	eth_hdr->s_addr.addr_bytes[5] = 1;
+	eth_hdr->d_addr.addr_bytes[5] = 2;
+	eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+
+	ipv4_hdr = (struct rte_ipv4_hdr *)(eth_hdr + 1);
+	ipv4_hdr->version_ihl = RTE_IPV4_VHL_DEF;
+	ipv4_hdr->total_length = rte_cpu_to_be_16(sizeof(*ipv4_hdr) +
+			FRAG_LEN);
+	ipv4_hdr->packet_id = rte_cpu_to_be_16(ip_id);
+	frag_offset = frag * FRAG_LEN / 8;
+	if (frag != NB_FRAGS - 1)
+		frag_offset |= RTE_IPV4_HDR_MF_FLAG;
+	ipv4_hdr->fragment_offset = rte_cpu_to_be_16(frag_offset);
+	ipv4_hdr->time_to_live = 64;
+	ipv4_hdr->next_proto_id = IPPROTO_UDP;
+	ipv4_hdr->src_addr = rte_cpu_to_be_32(RTE_IPV4(10, 0, 0, 1));
+	ipv4_hdr->dst_addr = rte_cpu_to_be_32(RTE_IPV4(192, 168, 0, 1));
+
+	if (vxlan) {
+		pkt->packet_type = RTE_PTYPE_L2_ETHER | RTE_PTYPE_L3_IPV4 |
+			RTE_PTYPE_L4_UDP | RTE_PTYPE_TUNNEL_VXLAN |
+			RTE_PTYPE_INNER_L2_ETHER | RTE_PTYPE_INNER_L3_IPV4 |
+			RTE_PTYPE_INNER_L4_FRAG;
+		pkt->outer_l2_len = sizeof(*eth_hdr);
+		pkt->outer_l3_len = sizeof(*ipv4_hdr);
+		pkt->l2_len = sizeof(*udp_hdr) + sizeof(*vxlan_hdr) +
+			sizeof(*eth_hdr);
+	} else {
+		pkt->packet_type = RTE_PTYPE_L2_ETHER | RTE_PTYPE_L3_IPV4 |
+			RTE_PTYPE_L4_FRAG;
+		pkt->l2_len = sizeof(*eth_hdr);
+	}
+	pkt->l3_len = sizeof(*ipv4_hdr);
+
+	return pkt;
+}
+
+/*
+ * Build the fragments of nb_dgrams datagrams. The middle fragments are
+ * sent last, so that they have to fill the gap between two fragments
+ * already in the table.
+ */
+static int
+build_udp4_frags(struct rte_mbuf **pkts, uint16_t nb_dgrams, int vxlan)
+{
+	static const uint32_t frag_order[NB_FRAGS] = {2, 0, 1};
+	uint32_t n = 0, i;
+	uint16_t dgram;
+
+	for (i = 0; i < NB_FRAGS; i++) {
+		for (dgram = 0; dgram < nb_dgrams; dgram++) {
+			pkts[n] = build_udp4_frag(dgram, frag_order[i], vxlan);
+			if (pkts[n] == NULL) {
+				rte_pktmbuf_free_bulk(pkts, n);
+				return -1;
+			}
+			n++;
+		}
+	}
+	return 0;
+}
+
+/* Check that a packet coming out of GRO is a complete datagram. */
+static int
+check_udp4_dgram(struct rte_mbuf *pkt, uint8_t *seen, uint16_t nb_dgrams,
+		int vxlan)
+{
+	struct rte_ipv4_hdr *ipv4_hdr, *outer_ipv4_hdr;
+	struct rte_udp_hdr *udp_hdr;
+	uint16_t outer_len = vxlan ? VXLAN_HDR_LEN : 0;
+	uint16_t dgram;
+
+	ipv4_hdr = rte_pktmbuf_mtod_offset(pkt, struct rte_ipv4_hdr *,
+			outer_len + sizeof(struct rte_ether_hdr));
+	dgram = rte_be_to_cpu_16(ipv4_hdr->packet_id);
+	if (dgram >= nb_dgrams || seen[dgram]) {
+		printf("unexpected or duplicated datagram %u\n", dgram);
+		return -1;
+	}
+	seen[dgram] = 1;
+
+	if (pkt->nb_segs != NB_FRAGS || pkt->pkt_len !=
+			outer_len + FRAG_HDR_LEN + NB_FRAGS * FRAG_LEN) {
+		printf("datagram %u: %u segments, %u bytes\n",
+			dgram, pkt->nb_segs, pkt->pkt_len);
+		return -1;
+	}
+	if (rte_be_to_cpu_16(ipv4_hdr->total_length) !=
+			sizeof(*ipv4_hdr) + NB_FRAGS * FRAG_LEN ||
+			ipv4_hdr->fragment_offset != 0) {
+		printf("datagram %u: wrong IPv4 header\n", dgram);
+		return -1;
+	}
+	if (vxlan) {
+		outer_ipv4_hdr = rte_pktmbuf_mtod_offset(pkt,
+				struct rte_ipv4_hdr *,
+				sizeof(struct rte_ether_hdr));
+		udp_hdr = (struct rte_udp_hdr *)(outer_ipv4_hdr + 1);
+		if (rte_be_to_cpu_16(outer_ipv4_hdr->total_length) !=
+				pkt->pkt_len - sizeof(struct rte_ether_hdr) ||
+				rte_be_to_cpu_16(udp_hdr->dgram_len) !=
+				pkt->pkt_len - FRAG_HDR_LEN) {
+			printf("datagram %u: wrong outer headers\n", dgram);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Reassemble 4 datagrams whose fragments arrive out of order, in burst
+ * mode or with a GRO context.
+ */
+static int
+test_gro_udp4(int vxlan, int use_ctx)
+{
+	struct rte_gro_param param = {
+		.gro_types = vxlan ? RTE_GRO_IPV4_VXLAN_UDP_IPV4 :
+			RTE_GRO_UDP_IPV4,
+		.max_flow_num = 4,
+		.max_item_per_flow = NB_FRAGS,
+		.socket_id = rte_socket_id(),
+	};
+	struct rte_mbuf *pkts[4 * NB_FRAGS];
+	uint8_t seen[4] = {0};
+	uint16_t nb_pkts, i;
+	void *ctx = NULL;
+	int ret = 0;
+
+	if (use_ctx) {
+		ctx = rte_gro_ctx_create(&param);
+		if (ctx == NULL) {
+			printf("cannot create GRO context\n");
+			return -1;
+		}
+	}
+	if (build_udp4_frags(pkts, 4, vxlan) < 0) {
+		if (ctx != NULL)
+			rte_gro_ctx_destroy(ctx);
+		return -1;
+	}
+
+	if (use_ctx) {
+		nb_pkts = rte_gro_reassemble(pkts, RTE_DIM(pkts), ctx);
+		if (nb_pkts != 0) {
+			printf("%u packets not processed\n", nb_pkts);
+			rte_pktmbuf_free_bulk(pkts, nb_pkts);
+			ret = -1;
+		}
+		nb_pkts = rte_gro_timeout_flush(ctx, 0, param.gro_types,
+				pkts, RTE_DIM(pkts));
+	} else
+		nb_pkts = rte_gro_reassemble_burst(pkts, RTE_DIM(pkts),
+				&param);
+
+	if (ret == 0 && nb_pkts != 4) {
+		printf("%u packets after GRO, expected 4\n", nb_pkts);
+		ret = -1;
+	}
+	for (i = 0; i < nb_pkts && ret == 0; i++)
+		ret = check_udp4_dgram(pkts[i], seen, 4, vxlan);
+	rte_pktmbuf_free_bulk(pkts, nb_pkts);
+
+	if (ctx != NULL)
+		rte_gro_ctx_destroy(ctx);
+	return ret;
+}
+
+/* Build the seg-th full sized segment of a TCP/IPv6 flow. */
+static struct rte_mbuf *
+build_tcp6_pkt(uint32_t flow, uint32_t seg)
+{
+	struct rte_ether_hdr *eth_hdr;
+	struct rte_ipv6_hdr *ipv6_hdr;
+	struct rte_tcp_hdr *tcp_hdr;
+	struct rte_mbuf *pkt;
+	char *data;
+
+	pkt = rte_pktmbuf_alloc(gro_pool);
+	if (pkt == NULL)
+		return NULL;
+	data = rte_pktmbuf_append(pkt, HDR6_LEN + PAYLOAD_LEN);
+	if (data == NULL) {
+		rte_pktmbuf_free(pkt);
+		return NULL;
+	}
+	memset(data, 0, HDR6_LEN + PAYLOAD_LEN);
+
+	eth_hdr = (struct rte_ether_hdr *)data;
+	eth_hdr->s_addr.addr_bytes[5] = 1;
+	eth_hdr->d_addr.addr_bytes[5] = 2;
+	eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+
+	ipv6_hdr = (struct rte_ipv6_hdr *)(eth_hdr + 1);
+	ipv6_hdr->vtc_flow = rte_cpu_to_be_32(6 << 28);
+	ipv6_hdr->payload_len = rte_cpu_to_be_16(sizeof(*tcp_hdr) +
+			PAYLOAD_LEN);
+	ipv6_hdr->proto = IPPROTO_TCP;
+	ipv6_hdr->hop_limits = 64;
+	ipv6_hdr->src_addr[0] = 0xfd;
+	ipv6_hdr->src_addr[14] = flow >> 8;
+	ipv6_hdr->src_addr[15] = flow & 0xff;
+	ipv6_hdr->dst_addr[0] = 0xfd;
+	ipv6_hdr->dst_addr[15] = 1;
+
+	tcp_hdr = (struct rte_tcp_hdr *)(ipv6_hdr + 1);
+	tcp_hdr->src_port = rte_cpu_to_be_16(1024);
+	tcp_hdr->dst_port = rte_cpu_to_be_16(80);
+	tcp_hdr->sent_seq = rte_cpu_to_be_32(FIRST_SEQ + seg * PAYLOAD_LEN);
+	tcp_hdr->recv_ack = rte_cpu_to_be_32(1);
+	tcp_hdr->data_off = (sizeof(*tcp_hdr) / 4) << 4;
+	tcp_hdr->tcp_flags = RTE_TCP_ACK_FLAG;
+	tcp_hdr->rx_win = rte_cpu_to_be_16(0xffff);
+
+	pkt->packet_type = RTE_PTYPE_L2_ETHER | RTE_PTYPE_L3_IPV6 |
+		RTE_PTYPE_L4_TCP;
+	pkt->l2_len = sizeof(*eth_hdr);
+	pkt->l3_len = sizeof(*ipv6_hdr);
+	pkt->l4_len = sizeof(*tcp_hdr);
+
+	return pkt;
+}
+
+/* Check a TCP/IPv6 packet, like check_merged_pkt() for TCP/IPv4. */
+static int
+check_tcp6_pkt(struct rte_mbuf *pkt, uint32_t nb_segs, uint8_t *seen,
+		uint32_t nb_flows)
+{
+	struct rte_ipv6_hdr *ipv6_hdr;
+	struct rte_tcp_hdr *tcp_hdr;
+	uint32_t flow;
+
+	ipv6_hdr = rte_pktmbuf_mtod_offset(pkt, struct rte_ipv6_hdr *,
+			sizeof(struct rte_ether_hdr));
+	tcp_hdr = (struct rte_tcp_hdr *)(ipv6_hdr + 1);
+	flow = (ipv6_hdr->src_addr[14] << 8) | ipv6_hdr->src_addr[15];
+
+	if (flow >= nb_flows || seen[flow]) {
+		printf("unexpected or duplicated flow %u\n", flow);
+		return -1;
+	}
+	seen[flow] = 1;
+
+	if (pkt->nb_segs != nb_segs ||
+			pkt->pkt_len != HDR6_LEN + nb_segs * PAYLOAD_LEN) {
+		printf("flow %u: %u segments, %u bytes\n",
+			flow, pkt->nb_segs, pkt->pkt_len);
+		return -1;
+	}
+	if (rte_be_to_cpu_16(ipv6_hdr->payload_len) !=
+			sizeof(*tcp_hdr) + nb_segs * PAYLOAD_LEN) {
+		printf("flow %u: wrong IPv6 payload length\n", flow);
+		return -1;
+	}
+	if (rte_be_to_cpu_32(tcp_hdr->sent_seq) != FIRST_SEQ) {
+		printf("flow %u: wrong TCP sequence number\n", flow);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Merge 8 TCP/IPv6 flows of 4 segments, with a GRO context. Segment 0
+ * is sent last, to be pre-pended.
+ */
+static int
+test_gro_tcp6(void)
+{
+	struct rte_gro_param param = {
+		.gro_types = RTE_GRO_TCP_IPV6,
+		.max_flow_num = 8,
+		.max_item_per_flow = 4,
+		.socket_id = rte_socket_id(),
+	};
+	struct rte_mbuf *pkts[BURST];
+	uint8_t seen[8] = {0};
+	uint32_t flow, seg, n = 0;
+	uint16_t nb_pkts, i;
+	void *ctx;
+	int ret = 0;
+
+	ctx = rte_gro_ctx_create(&param);
+	if (ctx == NULL) {
+		printf("cannot create GRO context\n");
+		return -1;
+	}
+	for (seg = 1; seg <= 4; seg++) {
+		for (flow = 0; flow < 8; flow++) {
+			pkts[n] = build_tcp6_pkt(flow, seg & 3);
+			if (pkts[n] == NULL) {
+				rte_pktmbuf_free_bulk(pkts, n);
+				rte_gro_ctx_destroy(ctx);
+				return -1;
+			}
+			n++;
+		}
+	}
+
+	nb_pkts = rte_gro_reassemble(pkts, BURST, ctx);
+	if (nb_pkts != 0) {
+		printf("%u packets not processed\n", nb_pkts);
+		rte_pktmbuf_free_bulk(pkts, nb_pkts);
+		ret = -1;
+	}
+	nb_pkts = rte_gro_timeout_flush(ctx, 0, RTE_GRO_TCP_IPV6, pkts,
+			BURST);
+	if (ret == 0 && nb_pkts != 8) {
+		printf("%u packets flushed, expected 8\n", nb_pkts);
+		ret = -1;
+	}
+	for (i = 0; i < nb_pkts && ret == 0; i++)
+		ret = check_tcp6_pkt(pkts[i], 4, seen, 8);
+	rte_pktmbuf_free_bulk(pkts, nb_pkts);
+
+	rte_gro_ctx_destroy(ctx);
+	return ret;
+}
+
+/*
+ * Merge TCP/IPv4, TCP/IPv6 and UDP/IPv4 packets in a single burst.
+ * IPv4 fragments must not be taken for TCP/IPv4 packets, whatever
+ * their L4 protocol.
+ */
+static int
+test_gro_mixed_burst(void)
+{
+	struct rte_gro_param param = {
+		.gro_types = RTE_GRO_TCP_IPV4 | RTE_GRO_UDP_IPV4 |
+			RTE_GRO_TCP_IPV6,
+		.max_flow_num = 8,
+		.max_item_per_flow = 4,
+	};
+	struct rte_mbuf *pkts[BURST];
+	uint8_t seen_tcp4[4] = {0}, seen_udp4[2] = {0}, seen_tcp6[4] = {0};
+	uint32_t flow, seg, n = 0;
+	uint16_t nb_pkts, i;
+	int ret = 0;
+
+	if (build_udp4_frags(pkts, 2, 0) < 0)
+		return -1;
+	n = 2 * NB_FRAGS;
+	for (seg = 0; seg < 2; seg++) {
+		for (flow = 0; flow < 4; flow++) {
+			pkts[n++] = build_tcp4_pkt(flow, seg);
+			pkts[n++] = build_tcp6_pkt(flow, seg);
+		}
+	}
+	for (i = 2 * NB_FRAGS; i < n; i++) {
+		if (pkts[i] == NULL)
+			ret = -1;
+	}
+	if (ret < 0) {
+		for (i = 0; i < n; i++)
+			rte_pktmbuf_free(pkts[i]);
+		return -1;
+	}
+
+	nb_pkts = rte_gro_reassemble_burst(pkts, n, &param);
+	if (nb_pkts != 10) {
+		printf("%u packets after GRO, expected 10\n", nb_pkts);
+		ret = -1;
+	}
+	for (i = 0; i < nb_pkts && ret == 0; i++) {
+		if (RTE_ETH_IS_IPV6_HDR(pkts[i]->packet_type))
+			ret = check_tcp6_pkt(pkts[i], 2, seen_tcp6, 4);
+		else if ((pkts[i]->packet_type & RTE_PTYPE_L4_MASK) ==
+				RTE_PTYPE_L4_FRAG)
+			ret = check_udp4_dgram(pkts[i], seen_udp4, 2, 0);
+		else
+			ret = check_merged_pkt(pkts[i], 2, seen_tcp4, 4);
+	}
+
+	rte_pktmbuf_free_bulk(pkts, nb_pkts);
+	return ret;
+}
+
+static int
+gro_pool_create(void)
+{
+	if (gro_pool != NULL)
+		return 0;
+
+	gro_pool = rte_pktmbuf_pool_create("test_gro_pool", NB_MBUF,
+			256, 0, MBUF_DATA_SIZE, SOCKET_ID_ANY);
+	if (gro_pool == NULL) {
+		printf("cannot create mbuf pool\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_gro(void)
+{
+	if (gro_pool_create() < 0)
+		return TEST_FAILED;
+
+	if (test_gro_burst() < 0) {
+		printf("GRO burst mode test failed\n");
+		return TEST_FAILED;
+	}
+	if (test_gro_ctx() < 0) {
+		printf("GRO context test failed\n");
+		return TEST_FAILED;
+	}
+	if (test_gro_reorder() < 0) {
+		printf("GRO reorder test failed\n");
+		return TEST_FAILED;
+	}
+	if (test_gro_tbl_full() < 0) {
+		printf("GRO full table test failed\n");
+		return TEST_FAILED;
+	}
+	if (test_gro_udp4(0, 0) < 0 || test_gro_udp4(0, 1) < 0) {
+		printf("GRO UDP/IPv4 fragment test failed\n");
+		return TEST_FAILED;
+	}
+	if (test_gro_udp4(1, 0) < 0 || test_gro_udp4(1, 1) < 0) {
+		printf("GRO VxLAN UDP/IPv4 fragment test failed\n");
+		return TEST_FAILED;
+	}
+	if (test_gro_tcp6() < 0) {
+		printf("GRO TCP/IPv6 test failed\n");
+		return TEST_FAILED;
+	}
+	if (test_gro_mixed_burst() < 0) {
+		printf("GRO mixed burst test failed\n");
+		return TEST_FAILED;
+	}
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Measure the cycles spent in GRO per packet when nb_flows flows are
+ * merged at the same time. The segments are sent segment by segment,
+ * so that all flows are in the table before the first one is flushed.
+ */
+static int
+gro_perf_run(uint32_t nb_flows, double *cost)
+{
+	struct rte_gro_param param = {
+		.gro_types = RTE_GRO_TCP_IPV4,
+		.max_flow_num = nb_flows,
+		.max_item_per_flow = PERF_SEGS_PER_FLOW,
+		.socket_id = rte_socket_id(),
+	};
+	const uint32_t nb_pkts = nb_flows * PERF_SEGS_PER_FLOW;
+	static struct rte_mbuf *pkts[PERF_MAX_FLOWS * PERF_SEGS_PER_FLOW];
+	uint64_t start, cycles = 0;
+	uint32_t round, i, n;
+	uint16_t nb_out;
+	void *ctx;
+	int ret = 0;
+
+	ctx = rte_gro_ctx_create(&param);
+	if (ctx == NULL) {
+		printf("cannot create GRO context\n");
+		return -1;
+	}
+
+	for (round = 0; round < PERF_TOTAL_PKTS / nb_pkts && ret == 0;
+			round++) {
+		if (build_tcp4_pkts(pkts, nb_flows, PERF_SEGS_PER_FLOW) < 0) {
+			ret = -1;
+			break;
+		}
+
+		start = rte_rdtsc();
+		for (i = 0; i < nb_pkts; i += BURST) {
+			n = RTE_MIN((uint32_t)BURST, nb_pkts - i);
+			if (rte_gro_reassemble(&pkts[i], n, ctx) != 0)
+				ret = -1;
+		}
+		nb_out = rte_gro_timeout_flush(ctx, 0, RTE_GRO_TCP_IPV4,
+				pkts, RTE_DIM(pkts));
+		cycles += rte_rdtsc() - start;
+
+		if (nb_out != nb_flows)
+			ret = -1;
+		rte_pktmbuf_free_bulk(pkts, nb_out);
+	}
+	rte_gro_ctx_destroy(ctx);
+
+	if (ret < 0) {
+		printf("GRO failed with %u flows\n", nb_flows);
+		return -1;
+	}
+
+	*cost = (double)cycles / PERF_TOTAL_PKTS;
+	printf("flows=%-5u %8.2f cycles/pkt\n", nb_flows, *cost);
+	return 0;
+}
+
+static int
+test_gro_perf(void)
+{
+	double cost, min_cost = 0;
+	uint32_t nb_flows;
+
+	if (gro_pool_create() < 0)
+		return TEST_FAILED;
+
+	for (nb_flows = PERF_MIN_FLOWS; nb_flows <= PERF_MAX_FLOWS;
+			nb_flows *= 2) {
+		if (gro_perf_run(nb_flows, &cost) < 0)
+			return TEST_FAILED;
+		if (nb_flows == PERF_MIN_FLOWS)
+			min_cost = cost;
+	}
+
+	/* finding a flow must not depend on the number of flows */
+	if (cost > min_cost * PERF_MAX_COST_RATIO) {
+		printf("GRO cost grows with the number of flows\n");
+		return TEST_FAILED;
+	}
+
+	return TEST_SUCCESS;
+}
+
+REGISTER_TEST_COMMAND(gro_autotest, test_gro);
+REGISTER_TEST_COMMAND(gro_perf_autotest, test_gro_perf);
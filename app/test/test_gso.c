@@ -0,0 +1,383 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_ethdev.h>
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_byteorder.h>
+#include <rte_gso.h>
+
+#include "test.h"
+
+#define NB_MBUF 1024
+#define PAYLOAD_LEN 1000
+#define SEG_PAYLOAD_LEN 300
+#define FIRST_SEQ 1000
+#define OUTER_IP_ID 100
+#define INNER_IP_ID 7
+#define VXLAN_PORT 4789
+#define GRE_HDR_LEN 4
+#define MAX_SEGS 8
+
+enum gso_test_type {
+	GSO_TCP6,
+	GSO_VXLAN_TCP6,
+	GSO_GRE_TCP6,
+	GSO_VXLAN_UDP4,
+};
+
+static const char * const gso_test_names[] = {
+	[GSO_TCP6] = "TCP/IPv6",
+	[GSO_VXLAN_TCP6] = "VxLAN TCP/IPv6",
+	[GSO_GRE_TCP6] = "GRE TCP/IPv6",
+	[GSO_VXLAN_UDP4] = "VxLAN UDP/IPv4",
+};
+
+static struct rte_mempool *gso_pool;
+
+/* Write the outer Ethernet, IPv4 and UDP/VxLAN or GRE headers. */
+static char *
+build_outer_hdrs(struct rte_mbuf *pkt, char *data, enum gso_test_type type)
+{
+	struct rte_ether_hdr *eth_hdr;
+	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_udp_hdr *udp_hdr;
+	struct rte_vxlan_hdr *vxlan_hdr;
+	uint16_t *gre_hdr;
+
+	eth_hdr = (struct rte_ether_hdr *)data;
+	eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+
+	ipv4_hdr = (struct rte_ipv4_hdr *)(eth_hdr + 1);
+	ipv4_hdr->version_ihl = RTE_IPV4_VHL_DEF;
+	ipv4_hdr->total_length = rte_cpu_to_be_16(pkt->pkt_len -
+			sizeof(*eth_hdr));
+	ipv4_hdr->packet_id = rte_cpu_to_be_16(OUTER_IP_ID);
+	ipv4_hdr->time_to_live = 64;
+	ipv4_hdr->src_addr = rte_cpu_to_be_32(RTE_IPV4(172, 16, 0, 1));
+	ipv4_hdr->dst_addr = rte_cpu_to_be_32(RTE_IPV4(172, 16, 0, 2));
+
+	pkt->outer_l2_len = sizeof(*eth_hdr);
+	pkt->outer_l3_len = sizeof(*ipv4_hdr);
+	pkt->ol_flags |= PKT_TX_OUTER_IPV4;
+
+	if (type == GSO_GRE_TCP6) {
+		ipv4_hdr->next_proto_id = IPPROTO_GRE;
+		gre_hdr = (uint16_t *)(ipv4_hdr + 1);
+		gre_hdr[1] = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+		pkt->l2_len = GRE_HDR_LEN;
+		pkt->ol_flags |= PKT_TX_TUNNEL_GRE;
+		return (char *)gre_hdr + GRE_HDR_LEN;
+	}
+
+	ipv4_hdr->next_proto_id = IPPROTO_UDP;
+	udp_hdr = (struct rte_udp_hdr *)(ipv4_hdr + 1);
+	udp_hdr->src_port = rte_cpu_to_be_16(49152);
+	udp_hdr->dst_port = rte_cpu_to_be_16(VXLAN_PORT);
+	udp_hdr->dgram_len = rte_cpu_to_be_16(pkt->pkt_len -
+			sizeof(*eth_hdr) - sizeof(*ipv4_hdr));
+
+	vxlan_hdr = (struct rte_vxlan_hdr *)(udp_hdr + 1);
+	vxlan_hdr->vx_flags = rte_cpu_to_be_32(0x08000000);
+	vxlan_hdr->vx_vni = rte_cpu_to_be_32(100 << 8);
+
+	eth_hdr = (struct rte_ether_hdr *)(vxlan_hdr + 1);
+	eth_hdr->ether_type = rte_cpu_to_be_16(type == GSO_VXLAN_UDP4 ?
+			RTE_ETHER_TYPE_IPV4 : RTE_ETHER_TYPE_IPV6);
+	pkt->l2_len = sizeof(*udp_hdr) + sizeof(*vxlan_hdr) +
+		sizeof(*eth_hdr);
+	pkt->ol_flags |= PKT_TX_TUNNEL_VXLAN;
+	return (char *)(eth_hdr + 1);
+}
+
+/*
+ * Build a packet of the given type, with PAYLOAD_LEN bytes of L4
+ * payload filled with a byte counter.
+ */
+static struct rte_mbuf *
+build_pkt(enum gso_test_type type)
+{
+	struct rte_ether_hdr *eth_hdr;
+	struct rte_ipv6_hdr *ipv6_hdr;
+	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_tcp_hdr *tcp_hdr;
+	struct rte_udp_hdr *udp_hdr;
+	struct rte_mbuf *pkt;
+	uint16_t hdr_len, i;
+	char *data, *l3_hdr;
+
+	if (type == GSO_TCP6)
+		hdr_len = sizeof(*eth_hdr);
+	else if (type == GSO_GRE_TCP6)
+		hdr_len = sizeof(*eth_hdr) + sizeof(*ipv4_hdr) + GRE_HDR_LEN;
+	else
+		hdr_len = 2 * sizeof(*eth_hdr) + sizeof(*ipv4_hdr) +
+			sizeof(*udp_hdr) + sizeof(struct rte_vxlan_hdr);
+	if (type == GSO_VXLAN_UDP4)
+		hdr_len += sizeof(*ipv4_hdr) + sizeof(*udp_hdr);
+	else
+		hdr_len += sizeof(*ipv6_hdr) + sizeof(*tcp_hdr);
+
+	pkt = rte_pktmbuf_alloc(gso_pool);
+	if (pkt == NULL)
+		return NULL;
+	data = rte_pktmbuf_append(pkt, hdr_len + PAYLOAD_LEN);
+	if (data == NULL) {
+		rte_pktmbuf_free(pkt);
+		return NULL;
+	}
+	memset(data, 0, hdr_len);
+	for (i = 0; i < PAYLOAD_LEN; i++)
+		data[hdr_len + i] = i & 0xff;
+
+	if (type == GSO_TCP6) {
+		eth_hdr = (struct rte_ether_hdr *)data;
+		eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+		pkt->l2_len = sizeof(*eth_hdr);
+		l3_hdr = (char *)(eth_hdr + 1);
+	} else
+		l3_hdr = build_outer_hdrs(pkt, data, type);
+
+	if (type == GSO_VXLAN_UDP4) {
+		ipv4_hdr = (struct rte_ipv4_hdr *)l3_hdr;
+		ipv4_hdr->version_ihl = RTE_IPV4_VHL_DEF;
+		ipv4_hdr->total_length = rte_cpu_to_be_16(sizeof(*ipv4_hdr) +
+				sizeof(*udp_hdr) + PAYLOAD_LEN);
+		ipv4_hdr->packet_id = rte_cpu_to_be_16(INNER_IP_ID);
+		ipv4_hdr->time_to_live = 64;
+		ipv4_hdr->next_proto_id = IPPROTO_UDP;
+
+		udp_hdr = (struct rte_udp_hdr *)(ipv4_hdr + 1);
+		udp_hdr->src_port = rte_cpu_to_be_16(5000);
+		udp_hdr->dst_port = rte_cpu_to_be_16(5001);
+		udp_hdr->dgram_len = rte_cpu_to_be_16(sizeof(*udp_hdr) +
+				PAYLOAD_LEN);
+
+		pkt->l3_len = sizeof(*ipv4_hdr);
+		pkt->l4_len = sizeof(*udp_hdr);
+		pkt->ol_flags |= PKT_TX_IPV4 | PKT_TX_UDP_SEG;
+		return pkt;
+	}
+
+	ipv6_hdr = (struct rte_ipv6_hdr *)l3_hdr;
+	ipv6_hdr->vtc_flow = rte_cpu_to_be_32(6 << 28);
+	ipv6_hdr->payload_len = rte_cpu_to_be_16(sizeof(*tcp_hdr) +
+			PAYLOAD_LEN);
+	ipv6_hdr->proto = IPPROTO_TCP;
+	ipv6_hdr->hop_limits = 64;
+	ipv6_hdr->src_addr[0] = 0xfd;
+	ipv6_hdr->dst_addr[0] = 0xfd;
+	ipv6_hdr->dst_addr[15] = 1;
+
+	tcp_hdr = (struct rte_tcp_hdr *)(ipv6_hdr + 1);
+	tcp_hdr->src_port = rte_cpu_to_be_16(1024);
+	tcp_hdr->dst_port = rte_cpu_to_be_16(80);
+	tcp_hdr->sent_seq = rte_cpu_to_be_32(FIRST_SEQ);
+	tcp_hdr->data_off = (sizeof(*tcp_hdr) / 4) << 4;
+	tcp_hdr->tcp_flags = RTE_TCP_ACK_FLAG | RTE_TCP_PSH_FLAG;
+
+	pkt->l3_len = sizeof(*ipv6_hdr);
+	pkt->l4_len = sizeof(*tcp_hdr);
+	pkt->ol_flags |= PKT_TX_IPV6 | PKT_TX_TCP_SEG;
+	return pkt;
+}
+
+/* Check the outer headers of a GSO segment of a tunneled packet. */
+static int
+check_outer_hdrs(struct rte_mbuf *seg, uint16_t i, enum gso_test_type type)
+{
+	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_udp_hdr *udp_hdr;
+
+	ipv4_hdr = rte_pktmbuf_mtod_offset(seg, struct rte_ipv4_hdr *,
+			seg->outer_l2_len);
+	if (rte_be_to_cpu_16(ipv4_hdr->total_length) !=
+			seg->pkt_len - seg->outer_l2_len ||
+			rte_be_to_cpu_16(ipv4_hdr->packet_id) !=
+			OUTER_IP_ID + i) {
+		printf("segment %u: wrong outer IPv4 header\n", i);
+		return -1;
+	}
+	if (type == GSO_GRE_TCP6)
+		return 0;
+
+	udp_hdr = (struct rte_udp_hdr *)(ipv4_hdr + 1);
+	if (rte_be_to_cpu_16(udp_hdr->dgram_len) != seg->pkt_len -
+			seg->outer_l2_len - seg->outer_l3_len) {
+		printf("segment %u: wrong outer UDP header\n", i);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Check the headers of the GSO segments, and that their payload is
+ * taken from the input packet, without copy.
+ */
+static int
+check_segs(struct rte_mbuf *pkt, struct rte_mbuf **segs, uint16_t nb_segs,
+		enum gso_test_type type)
+{
+	struct rte_ipv6_hdr *ipv6_hdr;
+	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_tcp_hdr *tcp_hdr;
+	uint16_t l3_offset, hdr_len, pyld_len, frag_offset, i;
+	uint32_t offset = 0, total_len = PAYLOAD_LEN;
+	uint8_t *pyld;
+
+	l3_offset = pkt->l2_len;
+	if (type != GSO_TCP6)
+		l3_offset += pkt->outer_l2_len + pkt->outer_l3_len;
+	/* the inner UDP header is a part of the fragmented payload */
+	hdr_len = l3_offset + pkt->l3_len;
+	if (type == GSO_VXLAN_UDP4)
+		total_len += pkt->l4_len;
+	else
+		hdr_len += pkt->l4_len;
+
+	for (i = 0; i < nb_segs; i++) {
+		if (segs[i]->nb_segs != 2 || segs[i]->data_len != hdr_len ||
+				!RTE_MBUF_CLONED(segs[i]->next) ||
+				rte_mbuf_from_indirect(segs[i]->next) != pkt) {
+			printf("segment %u: wrong layout\n", i);
+			return -1;
+		}
+		pyld_len = segs[i]->pkt_len - hdr_len;
+		pyld = rte_pktmbuf_mtod(segs[i]->next, uint8_t *);
+		if (pyld != rte_pktmbuf_mtod_offset(pkt, uint8_t *,
+					hdr_len + offset)) {
+			printf("segment %u: wrong payload\n", i);
+			return -1;
+		}
+		if (type != GSO_TCP6 && check_outer_hdrs(segs[i], i, type) < 0)
+			return -1;
+
+		if (type == GSO_VXLAN_UDP4) {
+			ipv4_hdr = rte_pktmbuf_mtod_offset(segs[i],
+					struct rte_ipv4_hdr *, l3_offset);
+			frag_offset = offset / 8;
+			if (i < nb_segs - 1)
+				frag_offset |= RTE_IPV4_HDR_MF_FLAG;
+			if (rte_be_to_cpu_16(ipv4_hdr->total_length) !=
+					pkt->l3_len + pyld_len ||
+					rte_be_to_cpu_16(ipv4_hdr->packet_id) !=
+					INNER_IP_ID ||
+					rte_be_to_cpu_16(
+						ipv4_hdr->fragment_offset) !=
+					frag_offset ||
+					(i < nb_segs - 1 && pyld_len % 8)) {
+				printf("segment %u: wrong inner IPv4 header\n",
+					i);
+				return -1;
+			}
+		} else {
+			ipv6_hdr = rte_pktmbuf_mtod_offset(segs[i],
+					struct rte_ipv6_hdr *, l3_offset);
+			tcp_hdr = (struct rte_tcp_hdr *)(ipv6_hdr + 1);
+			if (rte_be_to_cpu_16(ipv6_hdr->payload_len) !=
+					pkt->l4_len + pyld_len) {
+				printf("segment %u: wrong IPv6 header\n", i);
+				return -1;
+			}
+			if (rte_be_to_cpu_32(tcp_hdr->sent_seq) !=
+					FIRST_SEQ + offset ||
+					((tcp_hdr->tcp_flags &
+					  RTE_TCP_PSH_FLAG) != 0) !=
+					(i == nb_segs - 1)) {
+				printf("segment %u: wrong TCP header\n", i);
+				return -1;
+			}
+		}
+		offset += pyld_len;
+	}
+
+	if (offset != total_len) {
+		printf("%u payload bytes in the segments, expected %u\n",
+			offset, total_len);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_gso_type(enum gso_test_type type)
+{
+	struct rte_gso_ctx ctx = {
+		.direct_pool = gso_pool,
+		.indirect_pool = gso_pool,
+		.gso_types = DEV_TX_OFFLOAD_TCP_TSO | DEV_TX_OFFLOAD_UDP_TSO |
+			DEV_TX_OFFLOAD_VXLAN_TNL_TSO |
+			DEV_TX_OFFLOAD_GRE_TNL_TSO,
+		.flag = 0,
+	};
+	struct rte_mbuf *segs[MAX_SEGS];
+	struct rte_mbuf *pkt;
+	unsigned int avail;
+	int nb_segs, ret;
+
+	avail = rte_mempool_avail_count(gso_pool);
+	pkt = build_pkt(type);
+	if (pkt == NULL)
+		return -1;
+
+	ctx.gso_size = pkt->pkt_len - PAYLOAD_LEN + SEG_PAYLOAD_LEN;
+	nb_segs = rte_gso_segment(pkt, &ctx, segs, MAX_SEGS);
+	if (nb_segs <= 1) {
+		printf("%s: segmentation failed: %d\n",
+			gso_test_names[type], nb_segs);
+		rte_pktmbuf_free(pkt);
+		return -1;
+	}
+
+	/* each segment holds a reference to the input packet */
+	ret = check_segs(pkt, segs, nb_segs, type);
+	if (ret == 0 && rte_mbuf_refcnt_read(pkt) != nb_segs) {
+		printf("input packet refcnt %u, expected %d\n",
+			rte_mbuf_refcnt_read(pkt), nb_segs);
+		ret = -1;
+	}
+	if (ret < 0)
+		printf("%s: wrong GSO segments\n", gso_test_names[type]);
+
+	rte_pktmbuf_free_bulk(segs, nb_segs);
+	if (rte_mempool_avail_count(gso_pool) != avail) {
+		printf("%s: mbufs leaked\n", gso_test_names[type]);
+		ret = -1;
+	}
+	return ret;
+}
+
+static int
+test_gso(void)
+{
+	enum gso_test_type type;
+
+	if (gso_pool == NULL) {
+		gso_pool = rte_pktmbuf_pool_create("test_gso_pool", NB_MBUF,
+				0, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+				SOCKET_ID_ANY);
+		if (gso_pool == NULL) {
+			printf("cannot create mbuf pool\n");
+			return TEST_FAILED;
+		}
+	}
+
+	for (type = GSO_TCP6; type <= GSO_VXLAN_UDP4; type++) {
+		if (test_gso_type(type) < 0)
+			return TEST_FAILED;
+	}
+
+	return TEST_SUCCESS;
+}
+
+REGISTER_TEST_COMMAND(gso_autotest, test_gso);
@@ -995,6 +995,523 @@ static int test_extendable_bucket(void)
 }
 
 /******************************************************************************/
+/*
+ * Aging test
+ * Use pseudo_hash for the extendable bucket table, so that all the keys
+ * end up in the same chain of buckets.
+ *
+ * - add the first half of the keys, wait, then add the second half
+ * - touch one key of the first half
+ * - scan a bucket at a time with a small output, the first half minus
+ *   the touched key must expire exactly once
+ * - scan with a zero timeout, all the remaining keys must expire
+ */
+#define AGING_KEYS 64
+#define AGING_MAX_OUT 4
+static int test_hash_aging(uint32_t ext_table)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_hash_aging",
+		.entries = AGING_KEYS * 2,
+		.key_len = sizeof(struct flow_key), /* 13 */
+		.hash_func = ext_table ? pseudo_hash : rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_AGING |
+			(ext_table ? RTE_HASH_EXTRA_FLAGS_EXT_TABLE : 0),
+	};
+	struct rte_hash *handle;
+	struct flow_key rand_keys[AGING_KEYS];
+	uint8_t expired[AGING_KEYS] = {0};
+	const void *keys_out[AGING_MAX_OUT];
+	void *data_out[AGING_MAX_OUT];
+	int32_t pos_out[AGING_MAX_OUT];
+	const uint64_t timeout = rte_get_tsc_hz() / 10;
+	const struct flow_key *k;
+	unsigned int i, j, num_expired = 0;
+	int32_t pos, ret;
+
+	memset(rand_keys, 0, sizeof(rand_keys));
+	for (i = 0; i < AGING_KEYS; i++) {
+		rand_keys[i].port_dst = i;
+		rand_keys[i].port_src = i + 1;
+	}
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < AGING_KEYS; i++) {
+		/* let the first half get older than the timeout */
+		if (i == AGING_KEYS / 2)
+			rte_delay_ms(200);
+		pos = rte_hash_add_key_data(handle, &rand_keys[i],
+				(void *)(uintptr_t)i);
+		RETURN_IF_ERROR(pos < 0, "failed to add key %u", i);
+	}
+
+	pos = rte_hash_lookup(handle, &rand_keys[0]);
+	RETURN_IF_ERROR(pos < 0, "failed to find key 0");
+	RETURN_IF_ERROR(rte_hash_age_touch(handle, pos) != 0,
+			"failed to touch key 0");
+	RETURN_IF_ERROR(rte_hash_age_touch(handle, -1) != -EINVAL,
+			"touch succeeded with a negative position");
+	RETURN_IF_ERROR(rte_hash_age_touch(handle, INT32_MAX) != -EINVAL,
+			"touch succeeded out of the key store");
+
+	/* more calls than buckets, to go around the table */
+	for (i = 0; i < AGING_KEYS * 2; i++) {
+		ret = rte_hash_age_scan(handle, timeout, 1, keys_out,
+				data_out, pos_out, AGING_MAX_OUT);
+		RETURN_IF_ERROR(ret < 0 || ret > AGING_MAX_OUT,
+				"aging scan failed (%d)", ret);
+		for (j = 0; j < (unsigned int)ret; j++) {
+			k = keys_out[j];
+			RETURN_IF_ERROR(k->port_dst >= AGING_KEYS / 2 ||
+					k->port_dst == 0,
+					"key %u should not expire", k->port_dst);
+			RETURN_IF_ERROR(expired[k->port_dst]++ != 0,
+					"key %u expired twice", k->port_dst);
+			RETURN_IF_ERROR(data_out[j] !=
+					(void *)(uintptr_t)k->port_dst,
+					"wrong data for key %u", k->port_dst);
+			RETURN_IF_ERROR(pos_out[j] < 0,
+					"wrong position for key %u",
+					k->port_dst);
+			num_expired++;
+		}
+	}
+	RETURN_IF_ERROR(num_expired != AGING_KEYS / 2 - 1,
+			"%u keys expired, expected %u", num_expired,
+			AGING_KEYS / 2 - 1);
+
+	for (i = 0; i < AGING_KEYS; i++) {
+		pos = rte_hash_lookup(handle, &rand_keys[i]);
+		RETURN_IF_ERROR((pos < 0) != (expired[i] != 0),
+				"wrong lookup result for key %u (%d)", i, pos);
+	}
+
+	/* a zero timeout expires all the keys */
+	for (i = 0; i < AGING_KEYS * 2; i++) {
+		ret = rte_hash_age_scan(handle, 0, 1, keys_out, NULL, NULL,
+				AGING_MAX_OUT);
+		RETURN_IF_ERROR(ret < 0, "aging scan failed (%d)", ret);
+		num_expired += ret;
+	}
+	RETURN_IF_ERROR(num_expired != AGING_KEYS,
+			"%u keys expired, expected %u", num_expired,
+			AGING_KEYS);
+	RETURN_IF_ERROR(rte_hash_count(handle) != 0,
+			"table not empty after aging");
+
+	rte_hash_free(handle);
+
+	/* aging must be enabled at creation */
+	params.extra_flag &= ~RTE_HASH_EXTRA_FLAGS_AGING;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	pos = rte_hash_add_key(handle, &rand_keys[0]);
+	RETURN_IF_ERROR(pos < 0, "failed to add key 0");
+	RETURN_IF_ERROR(rte_hash_age_touch(handle, pos) != -EINVAL,
+			"touch succeeded without aging");
+	RETURN_IF_ERROR(rte_hash_age_scan(handle, 0, 1, keys_out, NULL, NULL,
+			AGING_MAX_OUT) != -EINVAL,
+			"scan succeeded without aging");
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+/*
+ * Touch a key from another lcore while expired keys are scanned: it must
+ * never be removed, even when it is touched after the scan started.
+ */
+#define AGING_SCAN_KEYS 1024
+struct aging_touch_args {
+	struct rte_hash *h;
+	int32_t pos;
+	volatile int started;
+	volatile int stop;
+};
+
+static int
+aging_touch_lcore(void *arg)
+{
+	struct aging_touch_args *args = arg;
+
+	while (!args->stop) {
+		rte_hash_age_touch(args->h, args->pos);
+		args->started = 1;
+	}
+	return 0;
+}
+
+static int test_hash_aging_touch_during_scan(void)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_hash_aging_touch",
+		.entries = AGING_SCAN_KEYS * 2,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_AGING,
+	};
+	static const void *keys_out[AGING_SCAN_KEYS];
+	struct aging_touch_args args;
+	struct rte_hash *handle;
+	const uint64_t timeout = rte_get_tsc_hz() / 10;
+	const uint32_t *k;
+	unsigned int lcore_id, round, num_expired = 0;
+	uint32_t i;
+	int32_t ret;
+
+	lcore_id = rte_get_next_lcore(-1, 1, 0);
+	if (lcore_id == RTE_MAX_LCORE) {
+		printf("skipping touch during scan test, needs 2 lcores\n");
+		return 0;
+	}
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < AGING_SCAN_KEYS; i++) {
+		ret = rte_hash_add_key(handle, &i);
+		RETURN_IF_ERROR(ret < 0, "failed to add key %u", i);
+		if (i == 0)
+			args.pos = ret;
+	}
+	rte_delay_ms(200);
+
+	args.h = handle;
+	args.started = 0;
+	args.stop = 0;
+	rte_eal_remote_launch(aging_touch_lcore, &args, lcore_id);
+	while (!args.started)
+		rte_pause();
+
+	/* more buckets than the table has, several times */
+	for (round = 0; round < 4; round++) {
+		ret = rte_hash_age_scan(handle, timeout, AGING_SCAN_KEYS,
+				keys_out, NULL, NULL, AGING_SCAN_KEYS);
+		if (ret < 0)
+			break;
+		for (i = 0; i < (uint32_t)ret; i++) {
+			k = keys_out[i];
+			if (*k == 0)
+				break;
+		}
+		if (i != (uint32_t)ret)
+			break;
+		num_expired += ret;
+	}
+
+	args.stop = 1;
+	rte_eal_wait_lcore(lcore_id);
+
+	RETURN_IF_ERROR(ret < 0, "aging scan failed (%d)", ret);
+	RETURN_IF_ERROR(round != 4, "touched key expired");
+	RETURN_IF_ERROR(num_expired != AGING_SCAN_KEYS - 1,
+			"%u keys expired, expected %u", num_expired,
+			AGING_SCAN_KEYS - 1);
+	i = 0;
+	RETURN_IF_ERROR(rte_hash_lookup(handle, &i) != args.pos,
+			"touched key not found");
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+/******************************************************************************/
+/*
+ * Resizable table test
+ * Use a small table with a migrate budget of one bucket, so that most
+ * adds happen while a resize is in progress.
+ *
+ * - add keys, the table must grow, the keys keep their position and are
+ *   found by lookups and bulk lookups during the migrations
+ * - delete half of the keys, complete the migration, iterate the rest
+ * - reset, then fill a table up to its maximum size
+ */
+#define RESIZE_KEYS 2048
+#define RESIZE_ENTRIES 64
+static int test_hash_resize(uint8_t extra_flag)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_hash_resize",
+		.entries = RESIZE_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.extra_flag = extra_flag,
+	};
+	struct rte_hash_resize_params rparams = {
+		.max_entries = RESIZE_KEYS * 2,
+		.migrate_budget = 1,
+	};
+	static uint32_t keys[RESIZE_KEYS];
+	static int32_t positions[RESIZE_KEYS];
+	const void *key_ptrs[RTE_HASH_LOOKUP_BULK_MAX];
+	int32_t bulk_pos[RTE_HASH_LOOKUP_BULK_MAX];
+	struct rte_hash *handle;
+	const void *next_key;
+	void *data;
+	uint32_t i, j, iter = 0, found = 0;
+	int32_t pos, ret;
+
+	for (i = 0; i < RESIZE_KEYS; i++)
+		keys[i] = i;
+
+	handle = rte_hash_create_resizable(&params, &rparams);
+	RETURN_IF_ERROR(handle == NULL, "resizable hash creation failed");
+
+	for (i = 0; i < RESIZE_KEYS; i++) {
+		pos = rte_hash_add_key_data(handle, &keys[i],
+				(void *)(uintptr_t)i);
+		RETURN_IF_ERROR(pos != 0, "failed to add key %u", i);
+		positions[i] = rte_hash_lookup(handle, &keys[i]);
+		RETURN_IF_ERROR(positions[i] < 0, "failed to find key %u", i);
+
+		if ((i + 1) % RTE_HASH_LOOKUP_BULK_MAX != 0)
+			continue;
+
+		/* all the keys added so far, wherever they are */
+		for (j = 0; j <= i; j++) {
+			ret = rte_hash_lookup_data(handle, &keys[j], &data);
+			RETURN_IF_ERROR(ret != positions[j] ||
+					data != (void *)(uintptr_t)j,
+					"key %u not found after %u adds", j, i);
+		}
+		for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++)
+			key_ptrs[j] = &keys[i - j];
+		ret = rte_hash_lookup_bulk(handle, key_ptrs,
+				RTE_HASH_LOOKUP_BULK_MAX, bulk_pos);
+		RETURN_IF_ERROR(ret != 0, "bulk lookup failed");
+		for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++)
+			RETURN_IF_ERROR(bulk_pos[j] != positions[i - j],
+					"bulk lookup missed key %u", i - j);
+	}
+	RETURN_IF_ERROR(rte_hash_count(handle) != RESIZE_KEYS,
+			"wrong key count %d", rte_hash_count(handle));
+
+	/* delete the odd keys, some of them are not migrated yet */
+	for (i = 1; i < RESIZE_KEYS; i += 2) {
+		pos = rte_hash_del_key(handle, &keys[i]);
+		RETURN_IF_ERROR(pos != positions[i],
+				"failed to delete key %u", i);
+		if (extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF)
+			RETURN_IF_ERROR(rte_hash_free_key_with_position(handle,
+					pos) != 0, "failed to free key %u", i);
+	}
+
+	ret = rte_hash_resize_step(handle, UINT32_MAX);
+	RETURN_IF_ERROR(ret != 0, "migration not completed (%d)", ret);
+
+	while ((pos = rte_hash_iterate(handle, &next_key, &data, &iter)) >= 0) {
+		i = *(const uint32_t *)next_key;
+		RETURN_IF_ERROR(i % 2 != 0 || pos != positions[i] ||
+				data != (void *)(uintptr_t)i,
+				"wrong key %u iterated", i);
+		found++;
+	}
+	RETURN_IF_ERROR(found != RESIZE_KEYS / 2, "%u keys iterated", found);
+
+	rte_hash_reset(handle);
+	RETURN_IF_ERROR(rte_hash_count(handle) != 0,
+			"table not empty after reset");
+	for (i = 0; i < RESIZE_KEYS; i++)
+		RETURN_IF_ERROR(rte_hash_lookup(handle, &keys[i]) != -ENOENT,
+				"key %u found after reset", i);
+	rte_hash_free(handle);
+
+	/* a table does not grow beyond max_entries */
+	rparams.max_entries = RESIZE_ENTRIES * 2;
+	handle = rte_hash_create_resizable(&params, &rparams);
+	RETURN_IF_ERROR(handle == NULL, "resizable hash creation failed");
+	for (i = 0; i < RESIZE_KEYS; i++) {
+		pos = rte_hash_add_key(handle, &keys[i]);
+		if (pos < 0)
+			break;
+		RETURN_IF_ERROR(pos >= RESIZE_ENTRIES * 2,
+				"position %d out of the table", pos);
+	}
+	RETURN_IF_ERROR(pos != -ENOSPC || i <= RESIZE_ENTRIES ||
+			i > RESIZE_ENTRIES * 2,
+			"table full after %u keys (%d)", i, pos);
+	for (j = 0; j < i; j++)
+		RETURN_IF_ERROR(rte_hash_lookup(handle, &keys[j]) < 0,
+				"key %u lost", j);
+	rte_hash_free(handle);
+
+	/* unsupported modes */
+	params.extra_flag = extra_flag | RTE_HASH_EXTRA_FLAGS_EXT_TABLE;
+	handle = rte_hash_create_resizable(&params, &rparams);
+	RETURN_IF_ERROR(handle != NULL,
+			"resizable hash created with ext table");
+	params.extra_flag = extra_flag;
+	rparams.max_entries = RESIZE_ENTRIES / 2;
+	handle = rte_hash_create_resizable(&params, &rparams);
+	RETURN_IF_ERROR(handle != NULL,
+			"resizable hash created with max_entries < entries");
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	RETURN_IF_ERROR(rte_hash_resize_step(handle, 1) != -EINVAL,
+			"resize step succeeded on a fixed size table");
+	rte_hash_free(handle);
+
+	return 0;
+}
+
+#define INLINE_KEYS 768
+#define INLINE_ENTRIES 1024
+
+/* Fill an inline test key, with different bytes after key_len each time */
+static void
+inline_key_fill(uint8_t *key, uint32_t i, uint32_t key_len)
+{
+	unsigned int j;
+
+	for (j = 0; j < RTE_HASH_INLINE_KEY_LEN; j++)
+		key[j] = rte_rand();
+	memset(key, 0xa5, key_len);
+	memcpy(key, &i, sizeof(i));
+}
+
+/*
+ * Add, look up, update, delete and iterate keys stored inline, of 13 and
+ * 16 bytes. The bytes of the key buffers after the key length differ
+ * between the adds and the lookups.
+ */
+static int test_hash_inline(uint32_t extra_flag)
+{
+	static const uint32_t key_lens[] = { 13, RTE_HASH_INLINE_KEY_LEN };
+	struct rte_hash_parameters params = {
+		.name = "test_hash_inline",
+		.entries = INLINE_ENTRIES,
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.extra_flag = extra_flag,
+		.extra_flag2 = RTE_HASH_EXTRA_FLAGS2_INLINE_KEY,
+	};
+	static uint8_t keys[INLINE_KEYS][RTE_HASH_INLINE_KEY_LEN];
+	static int32_t positions[INLINE_KEYS];
+	const void *key_ptrs[RTE_HASH_LOOKUP_BULK_MAX];
+	void *bulk_data[RTE_HASH_LOOKUP_BULK_MAX];
+	uint8_t other[RTE_HASH_INLINE_KEY_LEN];
+	struct rte_hash *handle;
+	const void *next_key;
+	uint64_t hit_mask;
+	uint32_t i, j, k, iter, found;
+	void *data;
+	int32_t pos;
+
+	for (k = 0; k < RTE_DIM(key_lens); k++) {
+		params.key_len = key_lens[k];
+		handle = rte_hash_create(&params);
+		RETURN_IF_ERROR(handle == NULL, "inline hash creation failed");
+
+		for (i = 0; i < INLINE_KEYS; i++) {
+			inline_key_fill(keys[i], i, params.key_len);
+			positions[i] = rte_hash_add_key_data(handle, keys[i],
+					(void *)(uintptr_t)i);
+			RETURN_IF_ERROR(positions[i] != 0,
+					"failed to add key %u", i);
+			positions[i] = rte_hash_lookup(handle, keys[i]);
+			RETURN_IF_ERROR(positions[i] < 0,
+					"failed to find key %u", i);
+		}
+
+		/* Update the data of a key */
+		pos = rte_hash_add_key_data(handle, keys[0],
+				(void *)(uintptr_t)INLINE_KEYS);
+		RETURN_IF_ERROR(pos != 0, "failed to update key 0");
+		pos = rte_hash_lookup_data(handle, keys[0], &data);
+		RETURN_IF_ERROR(pos != positions[0] ||
+				data != (void *)(uintptr_t)INLINE_KEYS,
+				"key 0 not updated");
+		rte_hash_add_key_data(handle, keys[0], (void *)(uintptr_t)0);
+
+		/* Keys differing in the last byte only are different */
+		memcpy(other, keys[1], sizeof(other));
+		other[params.key_len - 1] ^= 1;
+		RETURN_IF_ERROR(rte_hash_lookup(handle, other) != -ENOENT,
+				"key found with a different last byte");
+
+		/* Delete the odd keys */
+		for (i = 1; i < INLINE_KEYS; i += 2) {
+			pos = rte_hash_del_key(handle, keys[i]);
+			RETURN_IF_ERROR(pos != positions[i],
+					"failed to delete key %u", i);
+			if (extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF)
+				rte_hash_free_key_with_position(handle, pos);
+		}
+
+		for (i = 0; i < INLINE_KEYS; i++) {
+			/* Lookups do not depend on the bytes after the key */
+			inline_key_fill(keys[i], i, params.key_len);
+			pos = rte_hash_lookup_data(handle, keys[i], &data);
+			if (i % 2 != 0) {
+				RETURN_IF_ERROR(pos != -ENOENT,
+						"deleted key %u found", i);
+				continue;
+			}
+			RETURN_IF_ERROR(pos != positions[i] ||
+					data != (void *)(uintptr_t)i,
+					"key %u not found", i);
+		}
+
+		for (i = 0; i < INLINE_KEYS; i += RTE_HASH_LOOKUP_BULK_MAX) {
+			for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++)
+				key_ptrs[j] = keys[i + j];
+			RETURN_IF_ERROR(rte_hash_lookup_bulk_data(handle,
+					key_ptrs, RTE_HASH_LOOKUP_BULK_MAX,
+					&hit_mask, bulk_data) !=
+					RTE_HASH_LOOKUP_BULK_MAX / 2,
+					"wrong bulk lookup hits");
+			for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++) {
+				RETURN_IF_ERROR(!!(hit_mask & (1ULL << j)) ==
+						(i + j) % 2,
+						"wrong bulk lookup of key %u",
+						i + j);
+				RETURN_IF_ERROR((i + j) % 2 == 0 &&
+						bulk_data[j] !=
+						(void *)(uintptr_t)(i + j),
+						"wrong data of key %u", i + j);
+			}
+		}
+
+		iter = 0;
+		found = 0;
+		while ((pos = rte_hash_iterate(handle, &next_key, &data,
+				&iter)) >= 0) {
+			memcpy(&i, next_key, sizeof(i));
+			RETURN_IF_ERROR(i % 2 != 0 || pos != positions[i],
+					"wrong key %u iterated", i);
+			found++;
+		}
+		RETURN_IF_ERROR(found != INLINE_KEYS / 2,
+				"%u keys iterated", found);
+
+		rte_hash_reset(handle);
+		RETURN_IF_ERROR(rte_hash_lookup(handle, keys[0]) != -ENOENT,
+				"key found after reset");
+		rte_hash_free(handle);
+	}
+
+	/* unsupported modes */
+	params.key_len = RTE_HASH_INLINE_KEY_LEN + 1;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle != NULL, "inline hash created with long keys");
+	params.key_len = RTE_HASH_INLINE_KEY_LEN;
+	params.extra_flag |= RTE_HASH_EXTRA_FLAGS_EXT_TABLE;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle != NULL, "inline hash created with ext table");
+
+	return 0;
+}
+
 static int
 fbk_hash_unit_test(void)
 {
@@ -1378,6 +1895,16 @@ static int test_hash_creation_with_bad_parameters(void)
 		return -1;
 	}
 
+	memcpy(&params, &ut_params, sizeof(params));
+	params.name = "creation_with_bad_parameters_5";
+	params.extra_flag2 = RTE_HASH_EXTRA_FLAGS2_BKT_LOCK;
+	handle = rte_hash_create(&params);
+	if (handle != NULL) {
+		rte_hash_free(handle);
+		printf("Impossible creating hash successfully with bucket locks and a single writer\n");
+		return -1;
+	}
+
 	/* test with same name should fail */
 	memcpy(&params, &ut_params, sizeof(params));
 	params.name = "same_name";
@@ -1843,6 +2370,22 @@ test_hash(void)
 		return -1;
 	if (test_extendable_bucket() < 0)
 		return -1;
+	if (test_hash_aging(0) < 0)
+		return -1;
+	if (test_hash_aging(1) < 0)
+		return -1;
+	if (test_hash_aging_touch_during_scan() < 0)
+		return -1;
+	if (test_hash_resize(0) < 0)
+		return -1;
+	if (test_hash_resize(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF |
+			RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD) < 0)
+		return -1;
+	if (test_hash_inline(0) < 0)
+		return -1;
+	if (test_hash_inline(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF |
+			RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD) < 0)
+		return -1;
 
 	if (test_fbk_hash_find_existing() < 0)
 		return -1;
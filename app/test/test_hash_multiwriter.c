@@ -4,6 +4,7 @@
 
 #include <inttypes.h>
 #include <locale.h>
+#include <string.h>
 
 #include <rte_cycles.h>
 #include <rte_hash.h>
@@ -47,6 +48,7 @@ static rte_atomic64_t gcycles;
 static rte_atomic64_t ginsertions;
 
 static int use_htm;
+static int use_bkt_lock;
 
 static int
 test_hash_multiwriter_worker(void *arg)
@@ -120,6 +122,8 @@ test_hash_multiwriter(void)
 	else
 		hash_params.extra_flag =
 			RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD;
+	if (use_bkt_lock)
+		hash_params.extra_flag2 = RTE_HASH_EXTRA_FLAGS2_BKT_LOCK;
 
 	struct rte_hash *handle;
 	char name[RTE_HASH_NAMESIZE];
@@ -257,6 +261,146 @@ err1:
 	return -1;
 }
 
+/* Keys added, and table size, of the scaling test */
+#define SCALING_KEYS		(1024 * 1024)
+#define SCALING_ENTRIES		(2 * SCALING_KEYS)
+
+static struct {
+	struct rte_hash *h;
+	uint32_t *keys;
+	unsigned int nb_writers;
+	uint64_t cycles[RTE_MAX_LCORE];
+} scaling_params;
+
+static int
+test_hash_multiwriter_scaling_worker(void *arg)
+{
+	unsigned int pos = (uintptr_t)arg;
+	uint32_t nb_keys = SCALING_KEYS / scaling_params.nb_writers;
+	uint32_t *keys = scaling_params.keys + pos * nb_keys;
+	uint64_t begin;
+	uint32_t i;
+
+	begin = rte_rdtsc_precise();
+	for (i = 0; i < nb_keys; i++)
+		if (rte_hash_add_key(scaling_params.h, &keys[i]) < 0)
+			return -1;
+	scaling_params.cycles[pos] = rte_rdtsc_precise() - begin;
+
+	return 0;
+}
+
+/*
+ * Add the same keys with 1 to all the lcores, sharing them evenly, and
+ * report the insertion rate, with bucket locks and with the table lock.
+ */
+static int
+test_hash_multiwriter_scaling(void)
+{
+	static const uint32_t flags2[] = {
+		RTE_HASH_EXTRA_FLAGS2_BKT_LOCK,
+		0,
+	};
+	struct rte_hash_parameters hash_params = {
+		.name = "test_scaling",
+		.entries = SCALING_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = rte_socket_id(),
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD,
+	};
+	double rate[RTE_DIM(flags2)];
+	struct rte_hash *handle = NULL;
+	unsigned int nb_writers, pos, lcore_id, f;
+	uint64_t cycles;
+	uint32_t i;
+	int ret;
+
+	scaling_params.keys = rte_malloc(NULL,
+			sizeof(uint32_t) * SCALING_KEYS, 0);
+	if (scaling_params.keys == NULL) {
+		printf("RTE_MALLOC failed\n");
+		return -1;
+	}
+	for (i = 0; i < SCALING_KEYS; i++)
+		scaling_params.keys[i] = rte_rand();
+
+	printf("\n%-10s%-22s%-22s%-22s\n", "Writers", "Bucket locks",
+		"Table lock", "Bucket locks/core");
+	printf("%-10s%-22s%-22s%-22s\n", "", "(Minserts/s)",
+		"(Minserts/s)", "(Minserts/s)");
+
+	for (nb_writers = 1; nb_writers <= rte_lcore_count(); nb_writers++) {
+		for (f = 0; f < RTE_DIM(flags2); f++) {
+			hash_params.extra_flag2 = flags2[f];
+			handle = rte_hash_create(&hash_params);
+			if (handle == NULL) {
+				printf("hash creation failed\n");
+				goto err;
+			}
+
+			scaling_params.h = handle;
+			scaling_params.nb_writers = nb_writers;
+			memset(scaling_params.cycles, 0,
+				sizeof(scaling_params.cycles));
+
+			pos = 1;
+			RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+				if (pos == nb_writers)
+					break;
+				rte_eal_remote_launch(
+					test_hash_multiwriter_scaling_worker,
+					(void *)(uintptr_t)pos++, lcore_id);
+			}
+			ret = test_hash_multiwriter_scaling_worker(0);
+			pos = 1;
+			RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+				if (pos++ == nb_writers)
+					break;
+				if (rte_eal_wait_lcore(lcore_id) < 0)
+					ret = -1;
+			}
+			if (ret < 0) {
+				printf("failed to add the keys with %u "
+					"writers\n", nb_writers);
+				goto err;
+			}
+
+			/* The keys are random, some may be duplicated */
+			if (rte_hash_count(handle) >
+					(int32_t)(SCALING_KEYS / nb_writers *
+						nb_writers)) {
+				printf("wrong key count %d with %u writers\n",
+					rte_hash_count(handle), nb_writers);
+				goto err;
+			}
+
+			cycles = 0;
+			for (pos = 0; pos < nb_writers; pos++)
+				cycles = RTE_MAX(cycles,
+						scaling_params.cycles[pos]);
+			rate[f] = (double)(SCALING_KEYS / nb_writers *
+					nb_writers) * rte_get_tsc_hz() /
+					cycles / 1E6;
+
+			rte_hash_free(handle);
+			handle = NULL;
+		}
+
+		printf("%-10u%-22.2f%-22.2f%-22.2f\n", nb_writers, rate[0],
+			rate[1], rate[0] / nb_writers);
+	}
+
+	rte_free(scaling_params.keys);
+	return 0;
+
+err:
+	rte_hash_free(handle);
+	rte_free(scaling_params.keys);
+	return -1;
+}
+
 static int
 test_hash_multiwriter_main(void)
 {
@@ -287,6 +431,16 @@ test_hash_multiwriter_main(void)
 	if (test_hash_multiwriter() < 0)
 		return -1;
 
+	printf("Test multi-writer with bucket locks\n");
+	use_bkt_lock = 1;
+	if (test_hash_multiwriter() < 0)
+		return -1;
+	use_bkt_lock = 0;
+
+	printf("Test multi-writer scaling\n");
+	if (test_hash_multiwriter_scaling() < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -585,6 +585,337 @@ run_all_tbl_perf_tests(unsigned int with_pushes, unsigned int with_locks,
 	return 0;
 }
 
+/* Key sizes used to compare the signature compare paths of bulk lookups */
+static uint32_t sig_cmp_key_lens[] = { 13, 16, 36, 40 };
+
+/*
+ * Compare the bulk lookup performance of the default signature compare,
+ * which is AVX512 when supported by the compiler and the CPU, with the one
+ * used when AVX512 is disabled (SSE on x86).
+ */
+static int
+bulk_lookup_sig_cmp_perf_test(void)
+{
+	struct rte_hash_parameters params = ut_params;
+	const unsigned int max_keys = KEYS_TO_ADD * ADD_PERCENT;
+	const void *keys_burst[BURST_SIZE];
+	int32_t positions_burst[BURST_SIZE];
+	struct rte_hash *handle;
+	unsigned int i, j, k, no_avx512, num_keys, num_lookups;
+	uint64_t start_tsc, time_taken;
+
+	printf("\n BULK LOOKUP SIGNATURE COMPARE PERFORMANCE\n");
+	printf("\n%-18s%-18s%-18s%-18s\n",
+		"Keysize", "Compare", "Cycles/lookup", "Mlookups/s");
+
+	for (i = 0; i < RTE_DIM(sig_cmp_key_lens); i++) {
+		params.key_len = sig_cmp_key_lens[i];
+		params.socket_id = rte_socket_id();
+		for (j = 0; j < max_keys; j++)
+			for (k = 0; k < params.key_len; k++)
+				keys[j][k] = rte_rand();
+
+		for (no_avx512 = 0; no_avx512 <= 1; no_avx512++) {
+			params.name = "test_hash_sig_cmp";
+			params.extra_flag = no_avx512 ?
+				RTE_HASH_EXTRA_FLAGS_NO_AVX512 : 0;
+			handle = rte_hash_create(&params);
+			if (handle == NULL) {
+				printf("Error creating table\n");
+				return -1;
+			}
+
+			/* Stop at the first key which cannot be added */
+			for (num_keys = 0; num_keys < max_keys; num_keys++) {
+				positions[num_keys] = rte_hash_add_key(handle,
+						keys[num_keys]);
+				if (positions[num_keys] < 0)
+					break;
+			}
+			num_keys -= num_keys % BURST_SIZE;
+
+			/* Check the lookup results before timing them */
+			for (j = 0; j < num_keys; j += BURST_SIZE) {
+				for (k = 0; k < BURST_SIZE; k++)
+					keys_burst[k] = keys[j + k];
+				rte_hash_lookup_bulk(handle, keys_burst,
+						BURST_SIZE, positions_burst);
+				for (k = 0; k < BURST_SIZE; k++) {
+					if (positions_burst[k] !=
+							positions[j + k]) {
+						printf("Key looked up in %d, "
+							"should be in %d\n",
+							positions_burst[k],
+							positions[j + k]);
+						rte_hash_free(handle);
+						return -1;
+					}
+				}
+			}
+
+			num_lookups = 0;
+			start_tsc = rte_rdtsc();
+			while (num_lookups < NUM_LOOKUPS * ADD_PERCENT) {
+				for (j = 0; j < num_keys; j += BURST_SIZE) {
+					for (k = 0; k < BURST_SIZE; k++)
+						keys_burst[k] = keys[j + k];
+					rte_hash_lookup_bulk(handle, keys_burst,
+						BURST_SIZE, positions_burst);
+				}
+				num_lookups += num_keys;
+			}
+			time_taken = rte_rdtsc() - start_tsc;
+
+			printf("%-18u%-18s%-18.1f%-18.1f\n", params.key_len,
+				no_avx512 ? "no AVX512" : "default",
+				(double)time_taken / num_lookups,
+				(double)num_lookups * rte_get_tsc_hz() /
+					time_taken / 1E6);
+
+			rte_hash_free(handle);
+		}
+	}
+
+	return 0;
+}
+
+/* Initial size of the resizable table of the resize performance test */
+#define RESIZE_ENTRIES (MAX_ENTRIES / 4)
+
+/*
+ * Run bulk lookups of the first num_keys keys and check their positions.
+ * If step is set, the resize of the table is advanced by one bucket after
+ * each burst, and the lookups stop when it is complete. Only the lookups
+ * are timed. Returns the number of lookups, or 0 on error.
+ */
+static unsigned int
+timed_resize_lookups(struct rte_hash *handle, unsigned int num_keys,
+		unsigned int step, uint64_t *time_taken)
+{
+	const void *keys_burst[BURST_SIZE];
+	int32_t positions_burst[BURST_SIZE];
+	unsigned int j, k, num_lookups = 0;
+	uint64_t start_tsc;
+	int32_t ret = 1;
+
+	*time_taken = 0;
+	while (step ? ret > 0 : num_lookups < NUM_LOOKUPS * ADD_PERCENT) {
+		for (j = 0; j + BURST_SIZE <= num_keys; j += BURST_SIZE) {
+			for (k = 0; k < BURST_SIZE; k++)
+				keys_burst[k] = keys[j + k];
+
+			start_tsc = rte_rdtsc();
+			rte_hash_lookup_bulk(handle, keys_burst, BURST_SIZE,
+					positions_burst);
+			*time_taken += rte_rdtsc() - start_tsc;
+			num_lookups += BURST_SIZE;
+
+			for (k = 0; k < BURST_SIZE; k++) {
+				if (positions_burst[k] != positions[j + k]) {
+					printf("Key looked up in %d, should be "
+						"in %d\n", positions_burst[k],
+						positions[j + k]);
+					return 0;
+				}
+			}
+
+			if (!step)
+				continue;
+			ret = rte_hash_resize_step(handle, 1);
+			if (ret < 0) {
+				printf("Resize step failed (%d)\n", ret);
+				return 0;
+			}
+			if (ret == 0)
+				break;
+		}
+	}
+
+	return num_lookups;
+}
+
+/*
+ * Compare the bulk lookup performance of a resizable table before, during
+ * and after it doubles its size. During the resize, the keys are in the
+ * old or in the new bucket array, and lookups search both.
+ */
+static int
+resize_lookup_perf_test(void)
+{
+	struct rte_hash_parameters params = ut_params;
+	struct rte_hash_resize_params rparams = {
+		.max_entries = MAX_ENTRIES,
+		.migrate_budget = 1,
+	};
+	static const char * const phases[] = {
+		"before resize", "during resize", "after resize"
+	};
+	const unsigned int num_keys = RESIZE_ENTRIES * ADD_PERCENT;
+	const int32_t grow_keys =
+		RESIZE_ENTRIES / 100 * RTE_HASH_RESIZE_GROW_LOAD;
+	struct rte_hash *handle;
+	unsigned int i, k, num_lookups;
+	uint64_t time_taken;
+
+	printf("\n RESIZE LOOKUP PERFORMANCE\n");
+	printf("\n%-18s%-18s%-18s\n", "Phase", "Cycles/lookup", "Mlookups/s");
+
+	params.name = "test_hash_resize";
+	params.entries = RESIZE_ENTRIES;
+	params.key_len = 16;
+	params.socket_id = rte_socket_id();
+	params.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF;
+	handle = rte_hash_create_resizable(&params, &rparams);
+	if (handle == NULL) {
+		printf("Error creating table\n");
+		return -1;
+	}
+
+	for (i = 0; i < KEYS_TO_ADD; i++)
+		for (k = 0; k < params.key_len; k++)
+			keys[i][k] = rte_rand();
+
+	/* Fill the table below its grow load */
+	for (k = 0; k < num_keys; k++) {
+		positions[k] = rte_hash_add_key(handle, keys[k]);
+		if (positions[k] < 0)
+			goto err_add;
+	}
+
+	for (i = 0; i < RTE_DIM(phases); i++) {
+		/* Reach the grow load, the next add starts the resize */
+		for (; i == 1 && rte_hash_count(handle) <= grow_keys; k++) {
+			positions[k] = rte_hash_add_key(handle, keys[k]);
+			if (positions[k] < 0)
+				goto err_add;
+		}
+
+		num_lookups = timed_resize_lookups(handle, num_keys, i == 1,
+				&time_taken);
+		if (num_lookups == 0)
+			goto err;
+
+		printf("%-18s%-18.1f%-18.1f\n", phases[i],
+			(double)time_taken / num_lookups,
+			(double)num_lookups * rte_get_tsc_hz() /
+				time_taken / 1E6);
+	}
+
+	rte_hash_free(handle);
+	return 0;
+err_add:
+	printf("Error adding key\n");
+err:
+	rte_hash_free(handle);
+	return -1;
+}
+
+/*
+ * Compare the lookup performance of tables storing 13 and 16-byte keys in
+ * the key store and inline, in the buckets.
+ */
+static int
+inline_lookup_perf_test(void)
+{
+	static const uint32_t key_lens[] = { 13, 16 };
+	struct rte_hash_parameters params = ut_params;
+	const unsigned int num_keys = KEYS_TO_ADD * ADD_PERCENT;
+	const void *keys_burst[BURST_SIZE];
+	int32_t positions_burst[BURST_SIZE];
+	struct rte_hash *handle;
+	unsigned int i, j, k, l, inline_key, num_lookups;
+	uint64_t start_tsc, single_cycles, bulk_cycles;
+
+	printf("\n INLINE KEYS LOOKUP PERFORMANCE\n");
+	printf("\n%-10s%-12s%-18s%-18s%-18s\n", "Key len", "Keys",
+		"Cycles/lookup", "Cycles/lookup", "Bulk");
+	printf("%-10s%-12s%-18s%-18s%-18s\n", "", "", "(single)", "(bulk)",
+		"Mlookups/s");
+
+	params.name = "test_hash_inline";
+	params.socket_id = rte_socket_id();
+
+	for (l = 0; l < RTE_DIM(key_lens); l++) {
+		params.key_len = key_lens[l];
+		for (i = 0; i < num_keys; i++)
+			for (k = 0; k < params.key_len; k++)
+				keys[i][k] = rte_rand();
+
+		for (inline_key = 0; inline_key < 2; inline_key++) {
+			params.extra_flag2 = inline_key ?
+				RTE_HASH_EXTRA_FLAGS2_INLINE_KEY : 0;
+			handle = rte_hash_create(&params);
+			if (handle == NULL) {
+				printf("Error creating table\n");
+				return -1;
+			}
+
+			for (i = 0; i < num_keys; i++) {
+				positions[i] = rte_hash_add_key(handle,
+						keys[i]);
+				if (positions[i] < 0) {
+					printf("Error adding key\n");
+					rte_hash_free(handle);
+					return -1;
+				}
+			}
+
+			num_lookups = 0;
+			start_tsc = rte_rdtsc();
+			for (j = 0; j < NUM_LOOKUPS / num_keys; j++)
+				for (i = 0; i < num_keys; i++)
+					if (rte_hash_lookup(handle, keys[i]) ==
+							positions[i])
+						num_lookups++;
+			single_cycles = rte_rdtsc() - start_tsc;
+			if (num_lookups != NUM_LOOKUPS / num_keys * num_keys) {
+				printf("Key looked up in the wrong position\n");
+				rte_hash_free(handle);
+				return -1;
+			}
+
+			num_lookups = 0;
+			bulk_cycles = 0;
+			for (j = 0; j < NUM_LOOKUPS / num_keys; j++) {
+				for (i = 0; i + BURST_SIZE <= num_keys;
+						i += BURST_SIZE) {
+					for (k = 0; k < BURST_SIZE; k++)
+						keys_burst[k] = keys[i + k];
+
+					start_tsc = rte_rdtsc();
+					rte_hash_lookup_bulk(handle, keys_burst,
+						BURST_SIZE, positions_burst);
+					bulk_cycles += rte_rdtsc() - start_tsc;
+
+					for (k = 0; k < BURST_SIZE; k++)
+						if (positions_burst[k] ==
+								positions[i + k])
+							num_lookups++;
+				}
+			}
+			if (num_lookups != NUM_LOOKUPS / num_keys *
+					(num_keys / BURST_SIZE * BURST_SIZE)) {
+				printf("Key looked up in the wrong position\n");
+				rte_hash_free(handle);
+				return -1;
+			}
+
+			printf("%-10u%-12s%-18.1f%-18.1f%-18.1f\n",
+				params.key_len,
+				inline_key ? "inline" : "key store",
+				(double)single_cycles /
+					(NUM_LOOKUPS / num_keys * num_keys),
+				(double)bulk_cycles / num_lookups,
+				(double)num_lookups * rte_get_tsc_hz() /
+					bulk_cycles / 1E6);
+
+			rte_hash_free(handle);
+		}
+	}
+
+	return 0;
+}
+
 /* Control operation of performance testing of fbk hash. */
 #define LOAD_FACTOR 0.667	/* How full to make the hash table. */
 #define TEST_SIZE 1000000	/* How many operations to time. */
@@ -692,6 +1023,15 @@ test_hash_perf(void)
 	if (run_all_tbl_perf_tests(1, 0, 1) < 0)
 		return -1;
 
+	if (bulk_lookup_sig_cmp_perf_test() < 0)
+		return -1;
+
+	if (resize_lookup_perf_test() < 0)
+		return -1;
+
+	if (inline_lookup_perf_test() < 0)
+		return -1;
+
 	if (fbk_hash_perf_test() < 0)
 		return -1;
 
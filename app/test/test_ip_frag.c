@@ -0,0 +1,459 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_byteorder.h>
+#include <rte_ip_frag.h>
+
+#include "test.h"
+
+#define NB_MBUF 2048
+#define FRAG_LEN 64U
+#define BUCKET_NUM 64
+#define BUCKET_ENTRIES 4
+#define MAX_ENTRIES (BUCKET_NUM * BUCKET_ENTRIES)
+#define MAX_CYCLES 1000
+
+/* flood test parameters */
+#define FLOOD_ROUNDS 64
+#define FLOOD_FRAGS_PER_ROUND 16
+#define FLOOD_LEGIT_SRCS 16
+#define FLOOD_SRC_LIMIT 8
+
+static struct rte_mempool *frag_pool;
+static struct rte_ip_frag_death_row death_row;
+
+/*
+ * Build an IPv4 fragment carrying FRAG_LEN bytes at offset ofs of the
+ * datagram id from src.
+ */
+static struct rte_mbuf *
+build_ipv4_frag(uint32_t src, uint16_t id, uint16_t ofs, int more_frags)
+{
+	struct rte_mbuf *pkt;
+	struct rte_ether_hdr *eth_hdr;
+	struct rte_ipv4_hdr *ip_hdr;
+	uint16_t flag_offset;
+	char *data;
+
+	pkt = rte_pktmbuf_alloc(frag_pool);
+	if (pkt == NULL)
+		return NULL;
+
+	data = rte_pktmbuf_append(pkt, sizeof(*eth_hdr) + sizeof(*ip_hdr) +
+			FRAG_LEN);
+	if (data == NULL) {
+		rte_pktmbuf_free(pkt);
+		return NULL;
+	}
+	memset(data, 0, pkt->pkt_len);
+
+	eth_hdr = (struct rte_ether_hdr *)data;
+	eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+
+	flag_offset = ofs / RTE_IPV4_HDR_OFFSET_UNITS;
+	if (more_frags)
+		flag_offset |= RTE_IPV4_HDR_MF_FLAG;
+
+	ip_hdr = (struct rte_ipv4_hdr *)(eth_hdr + 1);
+	ip_hdr->version_ihl = RTE_IPV4_VHL_DEF;
+	ip_hdr->total_length = rte_cpu_to_be_16(sizeof(*ip_hdr) + FRAG_LEN);
+	ip_hdr->packet_id = rte_cpu_to_be_16(id);
+	ip_hdr->fragment_offset = rte_cpu_to_be_16(flag_offset);
+	ip_hdr->time_to_live = 64;
+	ip_hdr->next_proto_id = IPPROTO_UDP;
+	ip_hdr->src_addr = rte_cpu_to_be_32(src);
+	ip_hdr->dst_addr = rte_cpu_to_be_32(RTE_IPV4(192, 168, 0, 1));
+
+	pkt->l2_len = sizeof(*eth_hdr);
+	pkt->l3_len = sizeof(*ip_hdr);
+	return pkt;
+}
+
+/* Build an IPv6 fragment, the last byte of the source address is src. */
+static struct rte_mbuf *
+build_ipv6_frag(uint8_t src, uint32_t id, uint16_t ofs, int more_frags)
+{
+	struct rte_mbuf *pkt;
+	struct rte_ether_hdr *eth_hdr;
+	struct rte_ipv6_hdr *ip_hdr;
+	struct ipv6_extension_fragment *frag_hdr;
+	char *data;
+
+	pkt = rte_pktmbuf_alloc(frag_pool);
+	if (pkt == NULL)
+		return NULL;
+
+	data = rte_pktmbuf_append(pkt, sizeof(*eth_hdr) + sizeof(*ip_hdr) +
+			sizeof(*frag_hdr) + FRAG_LEN);
+	if (data == NULL) {
+		rte_pktmbuf_free(pkt);
+		return NULL;
+	}
+	memset(data, 0, pkt->pkt_len);
+
+	eth_hdr = (struct rte_ether_hdr *)data;
+	eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+
+	ip_hdr = (struct rte_ipv6_hdr *)(eth_hdr + 1);
+	ip_hdr->vtc_flow = rte_cpu_to_be_32(6 << 28);
+	ip_hdr->payload_len = rte_cpu_to_be_16(sizeof(*frag_hdr) + FRAG_LEN);
+	ip_hdr->proto = IPPROTO_FRAGMENT;
+	ip_hdr->hop_limits = 64;
+	/* addresses only differ in their last bytes */
+	ip_hdr->src_addr[0] = 0x20;
+	ip_hdr->src_addr[1] = 0x01;
+	ip_hdr->src_addr[15] = src;
+	ip_hdr->dst_addr[0] = 0x20;
+	ip_hdr->dst_addr[1] = 0x01;
+	ip_hdr->dst_addr[15] = 1;
+
+	frag_hdr = (struct ipv6_extension_fragment *)(ip_hdr + 1);
+	frag_hdr->next_header = IPPROTO_UDP;
+	frag_hdr->frag_data = rte_cpu_to_be_16(
+			RTE_IPV6_SET_FRAG_DATA(ofs, more_frags));
+	frag_hdr->id = rte_cpu_to_be_32(id);
+
+	pkt->l2_len = sizeof(*eth_hdr);
+	pkt->l3_len = sizeof(*ip_hdr) + sizeof(*frag_hdr);
+	return pkt;
+}
+
+static struct rte_mbuf *
+reassemble_ipv4(struct rte_ip_frag_tbl *tbl, struct rte_mbuf *pkt,
+	uint64_t tms)
+{
+	struct rte_ipv4_hdr *ip_hdr;
+
+	ip_hdr = rte_pktmbuf_mtod_offset(pkt, struct rte_ipv4_hdr *,
+			pkt->l2_len);
+	return rte_ipv4_frag_reassemble_packet(tbl, &death_row, pkt, tms,
+			ip_hdr);
+}
+
+static struct rte_mbuf *
+reassemble_ipv6(struct rte_ip_frag_tbl *tbl, struct rte_mbuf *pkt,
+	uint64_t tms)
+{
+	struct rte_ipv6_hdr *ip_hdr;
+	struct ipv6_extension_fragment *frag_hdr;
+
+	ip_hdr = rte_pktmbuf_mtod_offset(pkt, struct rte_ipv6_hdr *,
+			pkt->l2_len);
+	frag_hdr = rte_ipv6_frag_get_ipv6_fragment_header(ip_hdr);
+	return rte_ipv6_frag_reassemble_packet(tbl, &death_row, pkt, tms,
+			ip_hdr, frag_hdr);
+}
+
+static struct rte_ip_frag_tbl *
+create_tbl(void)
+{
+	struct rte_ip_frag_tbl *tbl;
+
+	tbl = rte_ip_frag_table_create(BUCKET_NUM, BUCKET_ENTRIES,
+			MAX_ENTRIES, MAX_CYCLES, SOCKET_ID_ANY);
+	if (tbl == NULL)
+		printf("cannot create fragment table\n");
+	return tbl;
+}
+
+/* Reassemble two IPv4 datagrams whose fragments arrive out of order. */
+static int
+test_ip_frag_ipv4(void)
+{
+	static const uint16_t ofs[] = {2 * FRAG_LEN, 0, FRAG_LEN};
+	struct rte_ip_frag_tbl *tbl;
+	struct rte_mbuf *pkt, *out;
+	unsigned int i, nb_out;
+	uint16_t id;
+	int ret = 0;
+
+	tbl = create_tbl();
+	if (tbl == NULL)
+		return -1;
+
+	nb_out = 0;
+	for (i = 0; i != RTE_DIM(ofs); i++) {
+		for (id = 1; id <= 2; id++) {
+			pkt = build_ipv4_frag(RTE_IPV4(10, 0, 0, 1), id,
+					ofs[i], ofs[i] != 2 * FRAG_LEN);
+			if (pkt == NULL) {
+				ret = -1;
+				goto exit;
+			}
+			out = reassemble_ipv4(tbl, pkt, 0);
+			rte_ip_frag_free_death_row(&death_row, 0);
+			if (out == NULL)
+				continue;
+
+			if (i != RTE_DIM(ofs) - 1 || out->pkt_len !=
+					out->l2_len + out->l3_len +
+					RTE_DIM(ofs) * FRAG_LEN) {
+				printf("IPv4 datagram %u wrongly reassembled\n",
+					id);
+				ret = -1;
+			}
+			nb_out++;
+			rte_pktmbuf_free(out);
+		}
+	}
+
+	if (nb_out != 2 || tbl->use_entries != 0) {
+		printf("%u IPv4 datagrams reassembled, %u entries in use\n",
+			nb_out, tbl->use_entries);
+		ret = -1;
+	}
+exit:
+	rte_ip_frag_table_destroy(tbl);
+	return ret;
+}
+
+/*
+ * Reassemble IPv6 datagrams with the same ID, whose keys only differ in
+ * the last word of the source address.
+ */
+static int
+test_ip_frag_ipv6(void)
+{
+	struct rte_ip_frag_tbl *tbl;
+	struct rte_mbuf *pkt, *out;
+	unsigned int nb_out;
+	uint16_t ofs;
+	uint8_t src;
+	int ret = 0;
+
+	tbl = create_tbl();
+	if (tbl == NULL)
+		return -1;
+
+	nb_out = 0;
+	for (ofs = 0; ofs <= FRAG_LEN; ofs += FRAG_LEN) {
+		for (src = 2; src <= 3; src++) {
+			pkt = build_ipv6_frag(src, 1, ofs, ofs == 0);
+			if (pkt == NULL) {
+				ret = -1;
+				goto exit;
+			}
+			out = reassemble_ipv6(tbl, pkt, 0);
+			rte_ip_frag_free_death_row(&death_row, 0);
+			if (out == NULL)
+				continue;
+
+			/* the fragment header is removed */
+			if (ofs == 0 || out->pkt_len != out->l2_len +
+					sizeof(struct rte_ipv6_hdr) +
+					2 * FRAG_LEN) {
+				printf("IPv6 datagram %u wrongly reassembled\n",
+					src);
+				ret = -1;
+			}
+			nb_out++;
+			rte_pktmbuf_free(out);
+		}
+	}
+
+	if (nb_out != 2 || tbl->use_entries != 0) {
+		printf("%u IPv6 datagrams reassembled, %u entries in use\n",
+			nb_out, tbl->use_entries);
+		ret = -1;
+	}
+exit:
+	rte_ip_frag_table_destroy(tbl);
+	return ret;
+}
+
+/* Check that expired entries are released at most max_num at a time. */
+static int
+test_ip_frag_del_expired_bulk(void)
+{
+	struct rte_ip_frag_tbl *tbl;
+	struct rte_mbuf *pkt;
+	uint32_t n, total;
+	uint16_t id;
+	int ret = 0;
+
+	tbl = create_tbl();
+	if (tbl == NULL)
+		return -1;
+
+	/* incomplete datagrams, the last two of them don't expire */
+	for (id = 0; id != 8; id++) {
+		pkt = build_ipv4_frag(RTE_IPV4(10, 0, 0, 1), id, 0, 1);
+		if (pkt == NULL) {
+			ret = -1;
+			goto exit;
+		}
+		if (reassemble_ipv4(tbl, pkt, id * MAX_CYCLES / 8) != NULL)
+			ret = -1;
+	}
+
+	total = 0;
+	do {
+		n = rte_ip_frag_table_del_expired_bulk(tbl, &death_row,
+				MAX_CYCLES + MAX_CYCLES * 7 / 10, 4);
+		if (n > 4)
+			ret = -1;
+		total += n;
+		rte_ip_frag_free_death_row(&death_row, 0);
+	} while (n != 0);
+
+	if (total != 6 || tbl->use_entries != 2) {
+		printf("%u entries expired, %u entries in use\n",
+			total, tbl->use_entries);
+		ret = -1;
+	}
+
+	rte_frag_table_del_expired_entries(tbl, &death_row, 4 * MAX_CYCLES);
+	rte_ip_frag_free_death_row(&death_row, 0);
+	if (tbl->use_entries != 0) {
+		printf("%u entries left after expiry\n", tbl->use_entries);
+		ret = -1;
+	}
+exit:
+	rte_ip_frag_table_destroy(tbl);
+	return ret;
+}
+
+/*
+ * One source floods the table with first fragments which are never
+ * completed, while legitimate sources send complete datagrams.
+ * Return the number of reassembled legitimate datagrams.
+ */
+static int
+ip_frag_flood(uint32_t src_limit)
+{
+	struct rte_ip_frag_tbl *tbl;
+	struct rte_mbuf *pkt, *out;
+	uint32_t round, i, src;
+	uint16_t attack_id;
+	int nb_out = 0;
+
+	tbl = create_tbl();
+	if (tbl == NULL)
+		return -1;
+	if (rte_ip_frag_table_set_src_limit(tbl, src_limit) != 0) {
+		rte_ip_frag_table_destroy(tbl);
+		return -1;
+	}
+
+	attack_id = 0;
+	for (round = 0; round != FLOOD_ROUNDS; round++) {
+		for (i = 0; i != FLOOD_FRAGS_PER_ROUND; i++) {
+			pkt = build_ipv4_frag(RTE_IPV4(10, 66, 6, 6),
+					attack_id++, 0, 1);
+			if (pkt == NULL)
+				goto error;
+			reassemble_ipv4(tbl, pkt, round);
+			rte_ip_frag_free_death_row(&death_row, 0);
+		}
+
+		for (src = 0; src != FLOOD_LEGIT_SRCS; src++) {
+			for (i = 0; i != 2; i++) {
+				pkt = build_ipv4_frag(RTE_IPV4(10, 1, 0, src),
+						round, i * FRAG_LEN, i == 0);
+				if (pkt == NULL)
+					goto error;
+				out = reassemble_ipv4(tbl, pkt, round);
+				rte_ip_frag_free_death_row(&death_row, 0);
+				if (out != NULL) {
+					nb_out++;
+					rte_pktmbuf_free(out);
+				}
+			}
+		}
+	}
+
+#ifdef RTE_LIBRTE_IP_FRAG_TBL_STAT
+	if (tbl->stat.reassembled_num != (uint64_t)nb_out ||
+			(src_limit != 0 && tbl->stat.fail_src_limit == 0)) {
+		printf("wrong fragment table statistics\n");
+		rte_ip_frag_table_statistics_dump(stdout, tbl);
+		goto error;
+	}
+#endif
+
+	rte_ip_frag_table_destroy(tbl);
+	return nb_out;
+
+error:
+	rte_ip_frag_table_destroy(tbl);
+	return -1;
+}
+
+static int
+test_ip_frag_flood(void)
+{
+	int nb_legit, nb_unlimited, nb_limited;
+
+	nb_legit = FLOOD_ROUNDS * FLOOD_LEGIT_SRCS;
+	nb_unlimited = ip_frag_flood(0);
+	nb_limited = ip_frag_flood(FLOOD_SRC_LIMIT);
+	if (nb_unlimited < 0 || nb_limited < 0)
+		return -1;
+
+	printf("flood goodput: %d/%d datagrams without source limit, "
+		"%d/%d with a limit of %u entries per source\n",
+		nb_unlimited, nb_legit, nb_limited, nb_legit,
+		FLOOD_SRC_LIMIT);
+
+	/* per source counters may be shared, allow a few losses */
+	if (nb_limited <= nb_unlimited || nb_limited < nb_legit * 9 / 10)
+		return -1;
+	return 0;
+}
+
+static int
+test_ip_frag(void)
+{
+	unsigned int avail;
+
+	if (frag_pool == NULL) {
+		frag_pool = rte_pktmbuf_pool_create("test_ip_frag_pool",
+				NB_MBUF, 0, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+				SOCKET_ID_ANY);
+		if (frag_pool == NULL) {
+			printf("cannot create mbuf pool\n");
+			return TEST_FAILED;
+		}
+	}
+	avail = rte_mempool_avail_count(frag_pool);
+
+	if (rte_ip_frag_table_set_src_limit(NULL, 1) != -EINVAL)
+		return TEST_FAILED;
+
+	if (test_ip_frag_ipv4() < 0) {
+		printf("IPv4 reassembly failed\n");
+		return TEST_FAILED;
+	}
+	if (test_ip_frag_ipv6() < 0) {
+		printf("IPv6 reassembly failed\n");
+		return TEST_FAILED;
+	}
+	if (test_ip_frag_del_expired_bulk() < 0) {
+		printf("bulk expiry failed\n");
+		return TEST_FAILED;
+	}
+	if (test_ip_frag_flood() < 0) {
+		printf("reassembly under flood failed\n");
+		return TEST_FAILED;
+	}
+
+	if (rte_mempool_avail_count(frag_pool) != avail) {
+		printf("mbufs leaked\n");
+		return TEST_FAILED;
+	}
+	return TEST_SUCCESS;
+}
+
+REGISTER_TEST_COMMAND(ip_frag_autotest, test_ip_frag);
@@ -8,6 +8,7 @@
 
 #include <rte_ip.h>
 #include <rte_lpm.h>
+#include <rte_malloc.h>
 
 #include "test.h"
 #include "test_xmmt_ops.h"
@@ -40,6 +41,8 @@ static int32_t test15(void);
 static int32_t test16(void);
 static int32_t test17(void);
 static int32_t test18(void);
+static int32_t test19(void);
+static int32_t test20(void);
 
 rte_lpm_test tests[] = {
 /* Test Cases */
@@ -61,7 +64,9 @@ rte_lpm_test tests[] = {
 	test15,
 	test16,
 	test17,
-	test18
+	test18,
+	test19,
+	test20
 };
 
 #define NUM_LPM_TESTS (sizeof(tests)/sizeof(tests[0]))
@@ -1266,6 +1271,147 @@ test18(void)
 	return PASS;
 }
 
+/*
+ * Test for RCU QSBR config: check that rte_lpm_rcu_qsbr_add fails
+ * gracefully for incorrect user input arguments and cannot be called
+ * twice.
+ */
+int32_t
+test19(void)
+{
+	struct rte_lpm *lpm = NULL;
+	struct rte_lpm_config config;
+	size_t sz;
+	struct rte_rcu_qsbr *qsv;
+	struct rte_rcu_qsbr *qsv2;
+	int32_t status;
+	struct rte_lpm_rcu_config rcu_cfg = {0};
+
+	config.max_rules = MAX_RULES;
+	config.number_tbl8s = NUMBER_TBL8S;
+	config.flags = 0;
+
+	lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	/* Create RCU QSBR variable */
+	sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+					RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	TEST_LPM_ASSERT(qsv != NULL);
+
+	status = rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE);
+	TEST_LPM_ASSERT(status == 0);
+
+	/* Invalid QSBR mode */
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = 2;
+	status = rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg, NULL);
+	TEST_LPM_ASSERT(status == -EINVAL);
+
+	/* NULL QSBR variable */
+	rcu_cfg.v = NULL;
+	rcu_cfg.mode = RTE_LPM_QSBR_MODE_DQ;
+	status = rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg, NULL);
+	TEST_LPM_ASSERT(status == -EINVAL);
+
+	rcu_cfg.v = qsv;
+	status = rte_lpm_rcu_qsbr_add(NULL, &rcu_cfg, NULL);
+	TEST_LPM_ASSERT(status == -EINVAL);
+
+	/* Attach RCU QSBR to LPM table */
+	status = rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg, NULL);
+	TEST_LPM_ASSERT(status == 0);
+
+	/* Create and attach another RCU QSBR to LPM table */
+	qsv2 = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+					RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	TEST_LPM_ASSERT(qsv2 != NULL);
+
+	rcu_cfg.v = qsv2;
+	rcu_cfg.mode = RTE_LPM_QSBR_MODE_SYNC;
+	status = rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg, NULL);
+	TEST_LPM_ASSERT(status == -EEXIST);
+
+	rte_lpm_free(lpm);
+	rte_free(qsv);
+	rte_free(qsv2);
+
+	return PASS;
+}
+
+/*
+ * Test for RCU QSBR defer queue mode: a freed tbl8 group is not reused
+ * until the reader reported a quiescent state.
+ */
+int32_t
+test20(void)
+{
+	struct rte_lpm *lpm = NULL;
+	struct rte_lpm_config config;
+	size_t sz;
+	struct rte_rcu_qsbr *qsv;
+	struct rte_rcu_qsbr_dq *dq = NULL;
+	int32_t status;
+	uint32_t ip1 = RTE_IPV4(192, 0, 2, 100);
+	uint32_t ip2 = RTE_IPV4(198, 51, 100, 100);
+	uint32_t next_hop;
+	uint8_t depth = 28;
+	struct rte_lpm_rcu_config rcu_cfg = {0};
+
+	/* Only one tbl8 group is available */
+	config.max_rules = MAX_RULES;
+	config.number_tbl8s = 1;
+	config.flags = 0;
+
+	lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+					RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	TEST_LPM_ASSERT(qsv != NULL);
+
+	status = rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE);
+	TEST_LPM_ASSERT(status == 0);
+
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_LPM_QSBR_MODE_DQ;
+	status = rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg, &dq);
+	TEST_LPM_ASSERT(status == 0);
+	TEST_LPM_ASSERT(dq != NULL);
+
+	/* Register a reader that does not report quiescent state yet */
+	status = rte_rcu_qsbr_thread_register(qsv, 0);
+	TEST_LPM_ASSERT(status == 0);
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	status = rte_lpm_add(lpm, ip1, depth, 1);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_delete(lpm, ip1, depth);
+	TEST_LPM_ASSERT(status == 0);
+
+	/* The only tbl8 group is still parked on the defer queue */
+	status = rte_lpm_add(lpm, ip2, depth, 2);
+	TEST_LPM_ASSERT(status == -ENOSPC);
+
+	/* Once the reader is quiescent the tbl8 group is reclaimed */
+	rte_rcu_qsbr_quiescent(qsv, 0);
+	status = rte_lpm_add(lpm, ip2, depth, 2);
+	TEST_LPM_ASSERT(status == 0);
+
+	status = rte_lpm_lookup(lpm, ip2, &next_hop);
+	TEST_LPM_ASSERT((status == 0) && (next_hop == 2));
+
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	rte_rcu_qsbr_thread_unregister(qsv, 0);
+
+	rte_lpm_free(lpm);
+	rte_free(qsv);
+
+	return PASS;
+}
+
 /*
  * Do all unit tests.
  */
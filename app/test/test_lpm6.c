@@ -8,6 +8,7 @@
 #include <string.h>
 
 #include <rte_memory.h>
+#include <rte_malloc.h>
 #include <rte_lpm6.h>
 
 #include "test.h"
@@ -51,6 +52,7 @@ static int32_t test25(void);
 static int32_t test26(void);
 static int32_t test27(void);
 static int32_t test28(void);
+static int32_t test29(void);
 
 rte_lpm6_test tests6[] = {
 /* Test Cases */
@@ -83,6 +85,7 @@ rte_lpm6_test tests6[] = {
 	test26,
 	test27,
 	test28,
+	test29,
 };
 
 #define NUM_LPM6_TESTS                (sizeof(tests6)/sizeof(tests6[0]))
@@ -1771,6 +1774,79 @@ test28(void)
 	return PASS;
 }
 
+/*
+ * Attach an RCU QSBR variable in defer queue mode and check that a
+ * released tbl8 is reused only after the reader reported a quiescent
+ * state.
+ */
+int32_t
+test29(void)
+{
+	struct rte_lpm6 *lpm = NULL;
+	struct rte_lpm6_config config;
+	struct rte_lpm6_rcu_config rcu_cfg = {0};
+	struct rte_rcu_qsbr *qsv;
+	uint8_t ip1[] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+			0, 0, 0, 0, 0, 0, 0, 0};
+	uint8_t ip2[] = {0x20, 0x01, 0x0d, 0xb9, 0, 0, 0, 0,
+			0, 0, 0, 0, 0, 0, 0, 0};
+	uint8_t depth = 32;
+	uint32_t next_hop_return = 0;
+	int32_t status = 0;
+	size_t sz;
+
+	/* A /32 prefix needs exactly one tbl8 */
+	config.max_rules = MAX_RULES;
+	config.number_tbl8s = 1;
+	config.flags = 0;
+
+	lpm = rte_lpm6_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+	qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+					RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	TEST_LPM_ASSERT(qsv != NULL);
+	TEST_LPM_ASSERT(rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE) == 0);
+
+	status = rte_lpm6_rcu_qsbr_add(lpm, NULL, NULL);
+	TEST_LPM_ASSERT(status == -EINVAL);
+
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_LPM6_QSBR_MODE_DQ;
+	status = rte_lpm6_rcu_qsbr_add(lpm, &rcu_cfg, NULL);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm6_rcu_qsbr_add(lpm, &rcu_cfg, NULL);
+	TEST_LPM_ASSERT(status == -EEXIST);
+
+	TEST_LPM_ASSERT(rte_rcu_qsbr_thread_register(qsv, 0) == 0);
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	status = rte_lpm6_add(lpm, ip1, depth, 1);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm6_delete(lpm, ip1, depth);
+	TEST_LPM_ASSERT(status == 0);
+
+	/* The tbl8 is still waiting for the reader */
+	status = rte_lpm6_add(lpm, ip2, depth, 2);
+	TEST_LPM_ASSERT(status == -ENOSPC);
+
+	rte_rcu_qsbr_quiescent(qsv, 0);
+	status = rte_lpm6_add(lpm, ip2, depth, 2);
+	TEST_LPM_ASSERT(status == 0);
+
+	status = rte_lpm6_lookup(lpm, ip2, &next_hop_return);
+	TEST_LPM_ASSERT((status == 0) && (next_hop_return == 2));
+
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	rte_rcu_qsbr_thread_unregister(qsv, 0);
+
+	rte_lpm6_free(lpm);
+	rte_free(qsv);
+
+	return PASS;
+}
+
 /*
  * Do all unit tests.
  */
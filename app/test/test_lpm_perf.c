@@ -5,13 +5,17 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include <rte_cycles.h>
 #include <rte_random.h>
 #include <rte_branch_prediction.h>
+#include <rte_launch.h>
+#include <rte_malloc.h>
 #include <rte_ip.h>
 #include <rte_lpm.h>
+#include <rte_rcu_qsbr.h>
 
 #include "test.h"
 #include "test_xmmt_ops.h"
@@ -316,6 +320,162 @@ print_route_distribution(const struct route_rule *table, uint32_t n)
 	printf("\n");
 }
 
+/* Concurrent reader/writer test with RCU QSBR */
+#define RCU_WRITER_ITERATIONS 4
+#define RCU_MAX_DEPTH_ROUTES (1 << 16)
+
+static struct rte_lpm *rcu_lpm;
+static struct rte_rcu_qsbr *rcu_qsv;
+static volatile uint8_t rcu_writer_done;
+static uint64_t rcu_lookups[RTE_MAX_LCORE];
+static uint32_t rcu_route_idx[RCU_MAX_DEPTH_ROUTES];
+static uint32_t rcu_num_routes;
+
+/* Reader thread: bulk lookups, reporting quiescent state after every
+ * burst so that the writer can reclaim tbl8 groups.
+ */
+static int
+test_lpm_rcu_qsbr_reader(__attribute__((unused)) void *arg)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	uint32_t ip_batch[BULK_SIZE];
+	uint32_t next_hops[BULK_SIZE];
+	uint64_t lookups = 0;
+	unsigned int i;
+
+	rte_rcu_qsbr_thread_register(rcu_qsv, lcore_id);
+	rte_rcu_qsbr_thread_online(rcu_qsv, lcore_id);
+
+	do {
+		for (i = 0; i < BULK_SIZE; i++)
+			ip_batch[i] = large_route_table[
+				rcu_route_idx[rte_rand() % rcu_num_routes]].ip;
+
+		rte_lpm_lookup_bulk(rcu_lpm, ip_batch, next_hops, BULK_SIZE);
+		lookups += BULK_SIZE;
+
+		/* Update quiescent state */
+		rte_rcu_qsbr_quiescent(rcu_qsv, lcore_id);
+	} while (!rcu_writer_done);
+
+	rte_rcu_qsbr_thread_offline(rcu_qsv, lcore_id);
+	rte_rcu_qsbr_thread_unregister(rcu_qsv, lcore_id);
+
+	rcu_lookups[lcore_id] = lookups;
+
+	return 0;
+}
+
+/*
+ * Measure lookup rate on all slave lcores while the master lcore keeps
+ * adding and deleting the routes which need tbl8 groups.
+ */
+static int
+test_lpm_rcu_perf_mode(const char *name, enum rte_lpm_qsbr_mode mode)
+{
+	struct rte_lpm_config config;
+	struct rte_lpm_rcu_config rcu_cfg = {0};
+	uint64_t begin, add_cycles = 0, del_cycles = 0, total_lookups = 0;
+	uint64_t hz = rte_get_tsc_hz();
+	unsigned int i, j, lcore_id, num_readers = 0;
+	uint32_t next_hop_add = 0xAA;
+	size_t sz;
+
+	config.max_rules = 2000000;
+	config.number_tbl8s = 2048;
+	config.flags = 0;
+
+	rcu_lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(rcu_lpm != NULL);
+
+	sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+	rcu_qsv = (struct rte_rcu_qsbr *)rte_zmalloc_socket(NULL, sz,
+			RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	TEST_LPM_ASSERT(rcu_qsv != NULL);
+	rte_rcu_qsbr_init(rcu_qsv, RTE_MAX_LCORE);
+
+	rcu_cfg.v = rcu_qsv;
+	rcu_cfg.mode = mode;
+	TEST_LPM_ASSERT(rte_lpm_rcu_qsbr_add(rcu_lpm, &rcu_cfg, NULL) == 0);
+
+	/* Routes of depth <= 24 stay in the table for the whole test */
+	for (i = 0; i < NUM_ROUTE_ENTRIES; i++)
+		if (large_route_table[i].depth <= 24)
+			rte_lpm_add(rcu_lpm, large_route_table[i].ip,
+				large_route_table[i].depth, next_hop_add);
+
+	rcu_writer_done = 0;
+	memset(rcu_lookups, 0, sizeof(rcu_lookups));
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		rte_eal_remote_launch(test_lpm_rcu_qsbr_reader, NULL, lcore_id);
+		num_readers++;
+	}
+
+	begin = rte_rdtsc();
+	for (i = 0; i < RCU_WRITER_ITERATIONS; i++) {
+		uint64_t start = rte_rdtsc();
+
+		for (j = 0; j < rcu_num_routes; j++)
+			rte_lpm_add(rcu_lpm,
+				large_route_table[rcu_route_idx[j]].ip,
+				large_route_table[rcu_route_idx[j]].depth,
+				next_hop_add);
+		add_cycles += rte_rdtsc() - start;
+
+		start = rte_rdtsc();
+		for (j = 0; j < rcu_num_routes; j++)
+			rte_lpm_delete(rcu_lpm,
+				large_route_table[rcu_route_idx[j]].ip,
+				large_route_table[rcu_route_idx[j]].depth);
+		del_cycles += rte_rdtsc() - start;
+	}
+	begin = rte_rdtsc() - begin;
+
+	rcu_writer_done = 1;
+	rte_eal_mp_wait_lcore();
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+		total_lookups += rcu_lookups[lcore_id];
+
+	printf("RCU %s: %u readers, %u routes with tbl8 added/deleted %u times\n",
+		name, num_readers, rcu_num_routes, RCU_WRITER_ITERATIONS);
+	printf("  Average LPM Add: %g cycles, Average LPM Delete: %g cycles\n",
+		(double)add_cycles / (RCU_WRITER_ITERATIONS * rcu_num_routes),
+		(double)del_cycles / (RCU_WRITER_ITERATIONS * rcu_num_routes));
+	printf("  Lookups: %.2f Mlookups/s per reader\n",
+		(double)total_lookups * hz / begin / num_readers / 1E6);
+
+	rte_lpm_free(rcu_lpm);
+	rte_free(rcu_qsv);
+	rcu_lpm = NULL;
+	rcu_qsv = NULL;
+
+	return 0;
+}
+
+static int
+test_lpm_rcu_perf(void)
+{
+	unsigned int i;
+
+	if (rte_lcore_count() < 2) {
+		printf("Not enough cores for LPM RCU perf test, expecting at least 2\n");
+		return 0;
+	}
+
+	rcu_num_routes = 0;
+	for (i = 0; i < NUM_ROUTE_ENTRIES &&
+			rcu_num_routes < RCU_MAX_DEPTH_ROUTES; i++)
+		if (large_route_table[i].depth > 24)
+			rcu_route_idx[rcu_num_routes++] = i;
+	TEST_LPM_ASSERT(rcu_num_routes != 0);
+
+	if (test_lpm_rcu_perf_mode("defer queue", RTE_LPM_QSBR_MODE_DQ) < 0)
+		return -1;
+
+	return test_lpm_rcu_perf_mode("blocking", RTE_LPM_QSBR_MODE_SYNC);
+}
+
 static int
 test_lpm_perf(void)
 {
@@ -478,7 +638,7 @@ test_lpm_perf(void)
 	rte_lpm_delete_all(lpm);
 	rte_lpm_free(lpm);
 
-	return 0;
+	return test_lpm_rcu_perf();
 }
 
 REGISTER_TEST_COMMAND(lpm_perf_autotest, test_lpm_perf);
@@ -372,6 +372,72 @@ test_multi_alloc_statistics(void)
 	return 0;
 }
 
+static int
+test_lcore_cache(void)
+{
+	struct rte_malloc_socket_stats pre_stats, post_stats;
+	int socket = rte_socket_id();
+	const size_t size = 200;
+	char *p1, *p2;
+	size_t i;
+
+	/* make enough requests of this size to get it served by the cache */
+	for (i = 0; i < 1024; i++) {
+		p1 = rte_malloc(NULL, size, 0);
+		if (p1 == NULL)
+			return -1;
+		rte_free(p1);
+	}
+
+	rte_malloc_cache_flush();
+	rte_malloc_get_socket_stats(socket, &pre_stats);
+
+	p1 = rte_malloc(NULL, size, 0);
+	if (p1 == NULL)
+		return -1;
+	memset(p1, 0xa5, size);
+	rte_free(p1);
+
+	/* a freed pointer is no longer valid, even if its element is cached */
+	if (rte_malloc_validate(p1, NULL) != -1) {
+		printf("Freed pointer is still valid\n");
+		return -1;
+	}
+
+	/* a recycled element must be cleared by rte_zmalloc() */
+	p2 = rte_zmalloc(NULL, size, 0);
+	if (p2 == NULL)
+		return -1;
+	for (i = 0; i < size; i++) {
+		if (p2[i] != 0) {
+			printf("Zeroed memory is not zero\n");
+			rte_free(p2);
+			return -1;
+		}
+	}
+	rte_free(p2);
+
+	/* cached elements are accounted as free memory */
+	rte_malloc_get_socket_stats(socket, &post_stats);
+	if (post_stats.alloc_count != pre_stats.alloc_count ||
+			post_stats.heap_freesz_bytes !=
+				pre_stats.heap_freesz_bytes) {
+		printf("Incorrect heap statistics with cached elements\n");
+		return -1;
+	}
+
+	/* once flushed, the heap gets its original layout back */
+	rte_malloc_cache_flush();
+	rte_malloc_get_socket_stats(socket, &post_stats);
+	if (post_stats.greatest_free_size != pre_stats.greatest_free_size ||
+			post_stats.free_count != pre_stats.free_count) {
+		printf("Incorrect heap statistics after cache flush\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 static int
 test_realloc(void)
 {
@@ -963,6 +1029,14 @@ test_malloc(void)
 	else
 		printf("test_multi_alloc_statistics() passed\n");
 
+	ret = test_lcore_cache();
+	if (ret < 0) {
+		printf("test_lcore_cache() failed\n");
+		return ret;
+	}
+	else
+		printf("test_lcore_cache() passed\n");
+
 	return 0;
 }
 
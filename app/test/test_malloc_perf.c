@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+#include <rte_atomic.h>
+#include <rte_pause.h>
+#include <rte_malloc.h>
+
+#include "test.h"
+
+/*
+ * Malloc
+ * ======
+ *
+ * Measures the rate of rte_malloc()/rte_free() calls, for a few object
+ * sizes, when 1, 2, 4, ... lcores allocate and free objects at the same
+ * time. Each lcore allocates a burst of objects, then frees them, in a
+ * loop. Objects of up to 4 KiB are served by the per-lcore caches; bigger
+ * objects always go to the heap, as a reference.
+ */
+
+#define N_ITER 10000
+#define BURST 32
+
+static const size_t obj_sizes[] = { 64, 256, 1024, 4096, 16384 };
+
+static rte_atomic32_t synchro;
+static size_t obj_size;
+static uint64_t lcore_cycles[RTE_MAX_LCORE];
+
+static int
+alloc_free_loop(__rte_unused void *arg)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	void *objs[BURST];
+	uint64_t start;
+	unsigned int i, j;
+	int ret = 0;
+
+	/* wait for the master lcore to start all lcores together */
+	while (rte_atomic32_read(&synchro) == 0)
+		rte_pause();
+
+	start = rte_rdtsc();
+	for (i = 0; i < N_ITER && ret == 0; i++) {
+		for (j = 0; j < BURST; j++) {
+			objs[j] = rte_malloc(NULL, obj_size, 0);
+			if (objs[j] == NULL) {
+				ret = -1;
+				break;
+			}
+		}
+		while (j > 0)
+			rte_free(objs[--j]);
+	}
+	lcore_cycles[lcore_id] = rte_rdtsc() - start;
+
+	/* give the cached objects back for the next run */
+	rte_malloc_cache_flush();
+
+	return ret;
+}
+
+static int
+run_on_lcores(unsigned int n_lcores)
+{
+	unsigned int lcore_id, n = 1;
+	uint64_t cycles, max_cycles = 0;
+	double mops;
+	int ret = 0;
+
+	rte_atomic32_set(&synchro, 0);
+	memset(lcore_cycles, 0, sizeof(lcore_cycles));
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (n == n_lcores)
+			break;
+		rte_eal_remote_launch(alloc_free_loop, NULL, lcore_id);
+		n++;
+	}
+
+	rte_atomic32_set(&synchro, 1);
+	if (alloc_free_loop(NULL) < 0)
+		ret = -1;
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (rte_eal_wait_lcore(lcore_id) < 0)
+			ret = -1;
+	}
+	if (ret < 0) {
+		printf("allocation of %zu bytes failed\n", obj_size);
+		return -1;
+	}
+
+	cycles = 0;
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		cycles += lcore_cycles[lcore_id];
+		max_cycles = RTE_MAX(max_cycles, lcore_cycles[lcore_id]);
+	}
+
+	/* one operation is either an allocation or a free */
+	mops = (double)n_lcores * N_ITER * BURST * 2 /
+		((double)max_cycles / rte_get_tsc_hz()) / 1000000;
+	printf("size=%-6zu lcores=%-3u %8.2f cycles/op %8.2f Mops/s\n",
+		obj_size, n_lcores,
+		(double)cycles / (n_lcores * N_ITER * BURST * 2), mops);
+
+	return 0;
+}
+
+static int
+test_malloc_perf(void)
+{
+	unsigned int i, n_lcores;
+
+	for (i = 0; i < RTE_DIM(obj_sizes); i++) {
+		obj_size = obj_sizes[i];
+		for (n_lcores = 1; n_lcores <= rte_lcore_count();
+				n_lcores *= 2) {
+			if (run_on_lcores(n_lcores) < 0)
+				return TEST_FAILED;
+		}
+		if (!rte_is_power_of_2(rte_lcore_count()) &&
+				run_on_lcores(rte_lcore_count()) < 0)
+			return TEST_FAILED;
+	}
+
+	return TEST_SUCCESS;
+}
+
+REGISTER_TEST_COMMAND(malloc_perf_autotest, test_malloc_perf);
@@ -28,6 +28,8 @@
 #include <rte_random.h>
 #include <rte_cycles.h>
 #include <rte_malloc.h>
+#include <rte_errno.h>
+#include <rte_mbuf_dyn.h>
 
 #include "test.h"
 
@@ -502,6 +504,212 @@ fail:
 		rte_pktmbuf_free(clone2);
 	return -1;
 }
+
+/*
+ * Test the registration of dynamic fields and flags, and check that
+ * they are copied to a clone. The registrations cannot be undone, so
+ * the test must succeed when run several times.
+ */
+static int
+test_mbuf_dyn(struct rte_mempool *pktmbuf_pool)
+{
+	const struct rte_mbuf_dynfield dynfield = {
+		.name = "test-dynfield",
+		.size = sizeof(uint8_t),
+		.align = __alignof__(uint8_t),
+		.flags = 0,
+	};
+	const struct rte_mbuf_dynfield dynfield2 = {
+		.name = "test-dynfield2",
+		.size = sizeof(uint16_t),
+		.align = __alignof__(uint16_t),
+		.flags = 0,
+	};
+	const struct rte_mbuf_dynfield dynfield3 = {
+		.name = "test-dynfield3",
+		.size = sizeof(uint32_t),
+		.align = __alignof__(uint32_t),
+		.flags = 0,
+	};
+	const struct rte_mbuf_dynfield dynfield_fail_big = {
+		.name = "test-dynfield-fail-big",
+		.size = sizeof(uint64_t),
+		.align = __alignof__(uint64_t),
+		.flags = 0,
+	};
+	const struct rte_mbuf_dynfield dynfield_fail_align = {
+		.name = "test-dynfield-fail-align",
+		.size = 1,
+		.align = 3,
+		.flags = 0,
+	};
+	const struct rte_mbuf_dynflag dynflag = {
+		.name = "test-dynflag",
+		.flags = 0,
+	};
+	const struct rte_mbuf_dynflag dynflag2 = {
+		.name = "test-dynflag2",
+		.flags = 0,
+	};
+	const struct rte_mbuf_dynflag dynflag3 = {
+		.name = "test-dynflag3",
+		.flags = 0,
+	};
+	struct rte_mbuf_dynfield dynfield_dup;
+	struct rte_mbuf_dynfield params;
+	struct rte_mbuf *m = NULL, *clone = NULL;
+	int offset, offset2, offset3;
+	int flag, flag2, flag3;
+	int ret;
+
+	printf("Test mbuf dynamic fields and flags\n");
+
+	offset = rte_mbuf_dynfield_register(&dynfield);
+	if (offset == -1)
+		GOTO_FAIL("failed to register dynamic field, offset=%d: %s",
+			offset, strerror(rte_errno));
+
+	ret = rte_mbuf_dynfield_register(&dynfield);
+	if (ret != offset)
+		GOTO_FAIL("failed to lookup dynamic field, ret=%d: %s",
+			ret, strerror(rte_errno));
+
+	/* the last 8 bytes of the reserved area are split */
+	offset2 = rte_mbuf_dynfield_register_offset(&dynfield2,
+		offsetof(struct rte_mbuf, dynfield1[1]));
+	if (offset2 != offsetof(struct rte_mbuf, dynfield1[1]))
+		GOTO_FAIL("failed to register dynamic field 2, offset2=%d: %s",
+			offset2, strerror(rte_errno));
+
+	offset3 = rte_mbuf_dynfield_register(&dynfield3);
+	if (offset3 == -1 || (offset3 % __alignof__(uint32_t)) != 0 ||
+			offset3 < offset + (int)sizeof(uint8_t) ||
+			offset3 + (int)sizeof(uint32_t) > offset2)
+		GOTO_FAIL("failed to register dynamic field 3, offset3=%d: %s",
+			offset3, strerror(rte_errno));
+
+	printf("dynfield: offset=%d, offset2=%d, offset3=%d\n",
+		offset, offset2, offset3);
+
+	/* same name, different parameters */
+	dynfield_dup = dynfield;
+	dynfield_dup.size = sizeof(uint16_t);
+	ret = rte_mbuf_dynfield_register(&dynfield_dup);
+	if (ret != -1 || rte_errno != EEXIST)
+		GOTO_FAIL("dynamic field registered with different size");
+
+	/* same name, different offset */
+	ret = rte_mbuf_dynfield_register_offset(&dynfield2,
+		offsetof(struct rte_mbuf, dynfield1[0]));
+	if (ret != -1 || rte_errno != EEXIST)
+		GOTO_FAIL("dynamic field registered at a different offset");
+
+	/* offset already in use */
+	ret = rte_mbuf_dynfield_register_offset(&dynfield_fail_big, offset2);
+	if (ret != -1 || rte_errno != EBUSY)
+		GOTO_FAIL("dynamic field registered on a used offset");
+
+	/* offset of a static field */
+	ret = rte_mbuf_dynfield_register_offset(&dynfield_fail_big,
+		offsetof(struct rte_mbuf, ol_flags));
+	if (ret != -1 || rte_errno != EBUSY)
+		GOTO_FAIL("dynamic field registered on a static field");
+
+	/* no room left for 8 aligned bytes */
+	ret = rte_mbuf_dynfield_register(&dynfield_fail_big);
+	if (ret != -1 || rte_errno != ENOENT)
+		GOTO_FAIL("dynamic field registered while mbuf is full");
+
+	ret = rte_mbuf_dynfield_register(&dynfield_fail_align);
+	if (ret != -1 || rte_errno != EINVAL)
+		GOTO_FAIL("dynamic field registered with invalid alignment");
+
+	ret = rte_mbuf_dynfield_lookup("test-dynfield2", &params);
+	if (ret != offset2 || strcmp(params.name, dynfield2.name) != 0 ||
+			params.size != dynfield2.size ||
+			params.align != dynfield2.align)
+		GOTO_FAIL("failed to lookup dynamic field 2");
+
+	ret = rte_mbuf_dynfield_lookup("test-dynfield-fail-big", NULL);
+	if (ret != -1 || rte_errno != ENOENT)
+		GOTO_FAIL("unregistered dynamic field found");
+
+	flag = rte_mbuf_dynflag_register(&dynflag);
+	if (flag == -1)
+		GOTO_FAIL("failed to register dynamic flag, flag=%d: %s",
+			flag, strerror(rte_errno));
+
+	ret = rte_mbuf_dynflag_register(&dynflag);
+	if (ret != flag)
+		GOTO_FAIL("failed to lookup dynamic flag, ret=%d: %s",
+			ret, strerror(rte_errno));
+
+	flag2 = rte_mbuf_dynflag_register_bitnum(&dynflag2,
+		rte_bsf64(PKT_LAST_FREE));
+	if (flag2 != rte_bsf64(PKT_LAST_FREE))
+		GOTO_FAIL("failed to register dynamic flag 2, flag2=%d: %s",
+			flag2, strerror(rte_errno));
+
+	printf("dynflag: flag=%d, flag2=%d\n", flag, flag2);
+
+	/* bit already in use, or used by a static flag */
+	ret = rte_mbuf_dynflag_register_bitnum(&dynflag3, flag);
+	if (ret != -1 || rte_errno != EBUSY)
+		GOTO_FAIL("dynamic flag registered on a used bit");
+
+	ret = rte_mbuf_dynflag_register_bitnum(&dynflag3,
+		rte_bsf64(PKT_RX_VLAN));
+	if (ret != -1 || rte_errno != EBUSY)
+		GOTO_FAIL("dynamic flag registered on a static flag");
+
+	ret = rte_mbuf_dynflag_register_bitnum(&dynflag3, 64);
+	if (ret != -1 || rte_errno != EINVAL)
+		GOTO_FAIL("dynamic flag registered with invalid bitnum");
+
+	ret = rte_mbuf_dynflag_lookup("test-dynflag2", NULL);
+	if (ret != flag2)
+		GOTO_FAIL("failed to lookup dynamic flag 2");
+
+	flag3 = rte_mbuf_dynflag_lookup("test-dynflag3", NULL);
+	if (flag3 != -1 || rte_errno != ENOENT)
+		GOTO_FAIL("unregistered dynamic flag found");
+
+	rte_mbuf_dyn_dump(stdout);
+
+	/* set the dynamic fields and flags and check they are cloned */
+	m = rte_pktmbuf_alloc(pktmbuf_pool);
+	if (m == NULL)
+		GOTO_FAIL("Cannot allocate mbuf");
+
+	*RTE_MBUF_DYNFIELD(m, offset, uint8_t *) = 1;
+	*RTE_MBUF_DYNFIELD(m, offset2, uint16_t *) = 1000;
+	*RTE_MBUF_DYNFIELD(m, offset3, uint32_t *) = MAGIC_DATA;
+	m->ol_flags |= 1ULL << flag;
+
+	clone = rte_pktmbuf_clone(m, pktmbuf_pool);
+	if (clone == NULL)
+		GOTO_FAIL("cannot clone data");
+
+	if (*RTE_MBUF_DYNFIELD(clone, offset, uint8_t *) != 1 ||
+			*RTE_MBUF_DYNFIELD(clone, offset2, uint16_t *) != 1000 ||
+			*RTE_MBUF_DYNFIELD(clone, offset3, uint32_t *) !=
+				MAGIC_DATA)
+		GOTO_FAIL("dynamic fields not copied to clone");
+
+	if ((clone->ol_flags & (1ULL << flag)) == 0 ||
+			(clone->ol_flags & (1ULL << flag2)) != 0)
+		GOTO_FAIL("dynamic flags not copied to clone");
+
+	rte_pktmbuf_free(clone);
+	rte_pktmbuf_free(m);
+
+	return 0;
+
+fail:
+	rte_pktmbuf_free(clone);
+	rte_pktmbuf_free(m);
+	return -1;
+}
 #undef GOTO_FAIL
 
 /*
@@ -637,6 +845,120 @@ test_pktmbuf_free_segment(struct rte_mempool *pktmbuf_pool)
 	return ret;
 }
 
+/* allocate mbufs one by one, so that the ones in the cache are used too */
+static int
+test_pktmbuf_alloc_n(struct rte_mempool *pktmbuf_pool, struct rte_mbuf **m,
+		     unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		m[i] = rte_pktmbuf_alloc(pktmbuf_pool);
+		if (m[i] == NULL) {
+			printf("cannot allocate mbuf %u\n", i);
+			rte_pktmbuf_free_bulk(m, i);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * test bulk free of mbufs: single segment, chained, indirect and shared
+ * mbufs from two pools, with NULL entries in the array
+ */
+static int
+test_pktmbuf_free_bulk(struct rte_mempool *pktmbuf_pool,
+		       struct rte_mempool *pktmbuf_pool2)
+{
+	struct rte_mbuf *m[NB_MBUF];
+	unsigned int i, n;
+
+	/* single segment mbufs of one pool */
+	if (test_pktmbuf_alloc_n(pktmbuf_pool, m, NB_MBUF) < 0)
+		return -1;
+	rte_pktmbuf_free_bulk(m, NB_MBUF);
+	if (rte_mempool_avail_count(pktmbuf_pool) != NB_MBUF) {
+		printf("mbufs not freed (single segment)\n");
+		return -1;
+	}
+
+	/* runs of mbufs from both pools, with holes */
+	for (i = 0; i < NB_MBUF; i++) {
+		if (i % 7 == 3)
+			m[i] = NULL;
+		else if ((i / 5) % 2 == 0)
+			m[i] = rte_pktmbuf_alloc(pktmbuf_pool);
+		else
+			m[i] = rte_pktmbuf_alloc(pktmbuf_pool2);
+		if (i % 7 != 3 && m[i] == NULL) {
+			printf("cannot allocate mbuf %u\n", i);
+			rte_pktmbuf_free_bulk(m, i);
+			return -1;
+		}
+	}
+	rte_pktmbuf_free_bulk(m, NB_MBUF);
+	if (rte_mempool_avail_count(pktmbuf_pool) != NB_MBUF ||
+	    rte_mempool_avail_count(pktmbuf_pool2) != NB_MBUF) {
+		printf("mbufs not freed (two pools)\n");
+		return -1;
+	}
+
+	/* chains of 4 segments */
+	if (test_pktmbuf_alloc_n(pktmbuf_pool, m, NB_MBUF) < 0)
+		return -1;
+	for (i = 0, n = 0; i < NB_MBUF; i += 4, n++) {
+		m[n] = m[i];
+		if (rte_pktmbuf_chain(m[n], m[i + 1]) != 0 ||
+		    rte_pktmbuf_chain(m[n], m[i + 2]) != 0 ||
+		    rte_pktmbuf_chain(m[n], m[i + 3]) != 0) {
+			printf("cannot chain mbufs\n");
+			return -1;
+		}
+	}
+	rte_pktmbuf_free_bulk(m, n);
+	if (rte_mempool_avail_count(pktmbuf_pool) != NB_MBUF) {
+		printf("mbufs not freed (chained)\n");
+		return -1;
+	}
+
+	/* indirect mbufs of the second pool attached to the first one */
+	for (i = 0; i < NB_MBUF / 2; i++) {
+		m[2 * i] = rte_pktmbuf_alloc(pktmbuf_pool);
+		m[2 * i + 1] = rte_pktmbuf_alloc(pktmbuf_pool2);
+		if (m[2 * i] == NULL || m[2 * i + 1] == NULL) {
+			printf("cannot allocate mbufs\n");
+			return -1;
+		}
+		rte_pktmbuf_attach(m[2 * i + 1], m[2 * i]);
+	}
+	rte_pktmbuf_free_bulk(m, NB_MBUF);
+	if (rte_mempool_avail_count(pktmbuf_pool) != NB_MBUF ||
+	    rte_mempool_avail_count(pktmbuf_pool2) != NB_MBUF) {
+		printf("mbufs not freed (indirect)\n");
+		return -1;
+	}
+
+	/* shared mbufs are only freed with the last reference */
+	if (test_pktmbuf_alloc_n(pktmbuf_pool, m, 8) < 0)
+		return -1;
+	rte_mbuf_refcnt_update(m[5], 1);
+	rte_pktmbuf_free_bulk(m, 8);
+	if (rte_mempool_avail_count(pktmbuf_pool) != NB_MBUF - 1 ||
+	    rte_mbuf_refcnt_read(m[5]) != 1) {
+		printf("shared mbuf freed too early\n");
+		return -1;
+	}
+	rte_pktmbuf_free_bulk(&m[5], 1);
+	if (rte_mempool_avail_count(pktmbuf_pool) != NB_MBUF) {
+		printf("mbufs not freed (shared)\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * Stress test for rte_mbuf atomic refcnt.
  * Implies that RTE_MBUF_REFCNT_ATOMIC is defined.
@@ -1195,6 +1517,12 @@ test_mbuf(void)
 		goto err;
 	}
 
+	/* test bulk free of single segment, chained and indirect mbufs */
+	if (test_pktmbuf_free_bulk(pktmbuf_pool, pktmbuf_pool2) < 0) {
+		printf("test_pktmbuf_free_bulk() failed\n");
+		goto err;
+	}
+
 	if (testclone_testupdate_testdetach(pktmbuf_pool) < 0) {
 		printf("testclone_and_testupdate() failed \n");
 		goto err;
@@ -1225,6 +1553,11 @@ test_mbuf(void)
 		goto err;
 	}
 
+	if (test_mbuf_dyn(pktmbuf_pool) < 0) {
+		printf("test_mbuf_dyn() failed\n");
+		goto err;
+	}
+
 	ret = 0;
 err:
 	rte_mempool_free(pktmbuf_pool);
@@ -447,6 +447,83 @@ test_mempool_same_name_twice_creation(void)
 	return 0;
 }
 
+/*
+ * Adaptive cache test: objects are taken through the cache of this lcore
+ * and returned through the cache of another lcore id, as when packets
+ * are received on one lcore and freed on another one.
+ */
+static int
+test_mempool_adaptive_cache(void)
+{
+	const unsigned int cache_size = 64, n = MEMPOOL_SIZE;
+	struct rte_mempool_cache *cons, *prod;
+	unsigned int lcore_id = rte_lcore_id();
+	void *objs[32];
+	const unsigned int bulk = RTE_DIM(objs);
+	struct rte_mempool *mp;
+	unsigned int i;
+	int ret = -1;
+
+	mp = rte_mempool_create("test_adaptive", n, MEMPOOL_ELT_SIZE,
+		cache_size, 0, NULL, NULL, my_obj_init, NULL,
+		SOCKET_ID_ANY, MEMPOOL_F_CACHE_ADAPTIVE);
+	if (mp == NULL)
+		RET_ERR();
+
+	if (test_mempool_basic(mp, 0) < 0)
+		GOTO_ERR(ret, err);
+
+	cons = rte_mempool_default_cache(mp, lcore_id);
+	prod = rte_mempool_default_cache(mp, (lcore_id + 1) % RTE_MAX_LCORE);
+	if (cons == NULL || prod == NULL || !cons->adaptive ||
+			cons->xfer == NULL)
+		GOTO_ERR(ret, err);
+
+	for (i = 0; i < 1000; i++) {
+		if (rte_mempool_generic_get(mp, objs, bulk, cons) < 0)
+			GOTO_ERR(ret, err);
+		rte_mempool_generic_put(mp, objs, bulk, prod);
+	}
+
+	/* the consumer refills in large batches and receives the objects */
+	if (cons->size != cache_size * 2 || mp->xfer_lcore != lcore_id)
+		GOTO_ERR(ret, err);
+	if (cons->stats.get_hit == 0 || cons->stats.get_miss == 0 ||
+			cons->stats.xfer_in == 0)
+		GOTO_ERR(ret, err);
+
+	/* the producer keeps few objects and flushes in large batches */
+	if (prod->size != cache_size / 4 ||
+			prod->flushthresh != cache_size * 2)
+		GOTO_ERR(ret, err);
+	if (prod->stats.put_miss == 0 || prod->stats.xfer_out == 0)
+		GOTO_ERR(ret, err);
+
+	/* no object is lost in the caches or the transfer rings */
+	if (rte_mempool_avail_count(mp) != n)
+		GOTO_ERR(ret, err);
+
+	rte_mempool_dump(stdout, mp);
+
+	/* back to a symmetric load: the producer gets its size back */
+	for (i = 0; i < 1000; i++) {
+		if (rte_mempool_generic_get(mp, objs, bulk, prod) < 0)
+			GOTO_ERR(ret, err);
+		rte_mempool_generic_put(mp, objs, bulk, prod);
+	}
+	if (prod->size != cache_size ||
+			prod->flushthresh != cache_size * 3 / 2)
+		GOTO_ERR(ret, err);
+	if (rte_mempool_avail_count(mp) != n)
+		GOTO_ERR(ret, err);
+
+	ret = 0;
+
+err:
+	rte_mempool_free(mp);
+	return ret;
+}
+
 static void
 walk_cb(struct rte_mempool *mp, void *userdata __rte_unused)
 {
@@ -571,6 +648,9 @@ test_mempool(void)
 	if (test_mempool_same_name_twice_creation() < 0)
 		goto err;
 
+	if (test_mempool_adaptive_cache() < 0)
+		goto err;
+
 	/* test the stack handler */
 	if (test_mempool_basic(mp_stack, 1) < 0)
 		goto err;
@@ -23,6 +23,7 @@
 #include <rte_atomic.h>
 #include <rte_branch_prediction.h>
 #include <rte_mempool.h>
+#include <rte_ring.h>
 #include <rte_spinlock.h>
 #include <rte_malloc.h>
 #include <rte_mbuf_pool_ops.h>
@@ -61,6 +62,11 @@
  *
  *      - 32
  *      - 128
+ *
+ *    An asymmetric test is also done with and without
+ *    MEMPOOL_F_CACHE_ADAPTIVE: the master core gets objects per bulk of
+ *    *ASYM_BULK* and passes them through a ring to another core, which
+ *    puts them back in the pool.
  */
 
 #define N 65536
@@ -69,6 +75,11 @@
 #define MAX_KEEP 128
 #define MEMPOOL_SIZE ((rte_lcore_count()*(MAX_KEEP+RTE_MEMPOOL_CACHE_MAX_SIZE))-1)
 
+#define ASYM_POOL_SIZE 8191
+#define ASYM_CACHE_SIZE 256
+#define ASYM_RING_SIZE 1024
+#define ASYM_BULK 32
+
 #define LOG_ERR() printf("test failed at %s():%d\n", __func__, __LINE__)
 #define RET_ERR() do {							\
 		LOG_ERR();						\
@@ -279,6 +290,124 @@ do_one_mempool_test(struct rte_mempool *mp, unsigned int cores)
 	return 0;
 }
 
+static struct rte_ring *asym_ring;
+static volatile int asym_quit;
+
+/* put back the objects received from the master core */
+static int
+asym_put_lcore(void *arg)
+{
+	struct rte_mempool *mp = arg;
+	struct rte_mempool_cache *cache;
+	void *obj_table[ASYM_BULK];
+	unsigned int n;
+
+	cache = rte_mempool_default_cache(mp, rte_lcore_id());
+
+	while (!asym_quit || !rte_ring_empty(asym_ring)) {
+		n = rte_ring_sc_dequeue_burst(asym_ring, obj_table,
+					      ASYM_BULK, NULL);
+		if (n != 0)
+			rte_mempool_generic_put(mp, obj_table, n, cache);
+	}
+
+	return 0;
+}
+
+/* get objects on the master core, put them back on another one */
+static int
+launch_asym_cores(struct rte_mempool *mp, unsigned int put_lcore)
+{
+	struct rte_mempool_cache *get_cache, *put_cache;
+	void *obj_table[ASYM_BULK];
+	uint64_t start_cycles, time_diff = 0, hz = rte_get_timer_hz();
+	uint64_t count = 0, get_miss, put_miss;
+	unsigned int n;
+
+	get_cache = rte_mempool_default_cache(mp, rte_lcore_id());
+	put_cache = rte_mempool_default_cache(mp, put_lcore);
+	get_miss = get_cache->stats.get_miss;
+	put_miss = put_cache->stats.put_miss;
+
+	asym_quit = 0;
+	rte_eal_remote_launch(asym_put_lcore, mp, put_lcore);
+
+	start_cycles = rte_get_timer_cycles();
+	while (time_diff / hz < TIME_S) {
+		if (rte_mempool_generic_get(mp, obj_table, ASYM_BULK,
+					    get_cache) == 0) {
+			n = 0;
+			while (n < ASYM_BULK)
+				n += rte_ring_sp_enqueue_burst(asym_ring,
+					&obj_table[n], ASYM_BULK - n, NULL);
+			count += ASYM_BULK;
+		}
+		time_diff = rte_get_timer_cycles() - start_cycles;
+	}
+
+	asym_quit = 1;
+	if (rte_eal_wait_lcore(put_lcore) < 0)
+		return -1;
+
+	get_miss = get_cache->stats.get_miss - get_miss;
+	put_miss = put_cache->stats.put_miss - put_miss;
+	printf("mempool_autotest asymmetric cache=%u adaptive=%d "
+	       "n_bulk=%u rate_persec=%" PRIu64, mp->cache_size,
+	       !!(mp->flags & MEMPOOL_F_CACHE_ADAPTIVE), ASYM_BULK,
+	       count / TIME_S);
+	/* the regular caches only count their misses in debug mode */
+	if (get_cache->adaptive)
+		printf(" get_miss_persec=%" PRIu64 " put_miss_persec=%" PRIu64,
+		       get_miss / TIME_S, put_miss / TIME_S);
+	printf("\n");
+
+	return 0;
+}
+
+/* asymmetric producer/consumer test, with and without adaptive cache */
+static int
+do_asym_mempool_test(void)
+{
+	struct rte_mempool *mp = NULL;
+	unsigned int put_lcore, flags;
+	int ret = -1;
+
+	put_lcore = rte_get_next_lcore(rte_lcore_id(), 1, 0);
+	if (put_lcore >= RTE_MAX_LCORE) {
+		printf("asymmetric test needs 2 cores, skipped\n");
+		return 0;
+	}
+
+	asym_ring = rte_ring_create("perf_test_asym", ASYM_RING_SIZE,
+				   SOCKET_ID_ANY, RING_F_SP_ENQ | RING_F_SC_DEQ);
+	if (asym_ring == NULL)
+		RET_ERR();
+
+	for (flags = 0; flags <= MEMPOOL_F_CACHE_ADAPTIVE;
+			flags += MEMPOOL_F_CACHE_ADAPTIVE) {
+		mp = rte_mempool_create("perf_test_asym", ASYM_POOL_SIZE,
+					MEMPOOL_ELT_SIZE, ASYM_CACHE_SIZE, 0,
+					NULL, NULL, my_obj_init, NULL,
+					SOCKET_ID_ANY, flags);
+		if (mp == NULL)
+			GOTO_ERR(ret, err);
+
+		if (launch_asym_cores(mp, put_lcore) < 0)
+			GOTO_ERR(ret, err);
+
+		rte_mempool_dump(stdout, mp);
+		rte_mempool_free(mp);
+		mp = NULL;
+	}
+
+	ret = 0;
+
+err:
+	rte_mempool_free(mp);
+	rte_ring_free(asym_ring);
+	return ret;
+}
+
 static int
 test_mempool_perf(void)
 {
@@ -385,6 +514,12 @@ test_mempool_perf(void)
 	if (do_one_mempool_test(mp_nocache, rte_lcore_count()) < 0)
 		goto err;
 
+	/* performance test with asymmetric producer and consumer cores */
+	printf("start performance test (asymmetric cores)\n");
+
+	if (do_asym_mempool_test() < 0)
+		goto err;
+
 	rte_mempool_list_dump(stdout);
 
 	ret = 0;
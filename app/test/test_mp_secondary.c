@@ -50,6 +50,62 @@
 #define launch_proc(ARGV) process_dup(ARGV, \
 		sizeof(ARGV)/(sizeof(ARGV[0])), __func__)
 
+/* memzone filled by the primary, spanning several pages */
+#define MP_PATTERN_MZ "test_mp_pattern"
+#define MP_PATTERN_LEN (4 << 20)
+#define MP_PATTERN_BYTE 0xa5
+
+/* mempool objects enqueued in a ring by the primary, spanning several pages */
+#define MP_OBJ_POOL "test_mp_obj_pool"
+#define MP_OBJ_RING "test_mp_obj_ring"
+#define MP_OBJ_POOL_SIZE 2047
+#define MP_OBJ_SIZE 4096
+#define MP_OBJ_NUM 1024
+
+/*
+ * This function is called in the primary to fill a ring with objects of a
+ * mempool, whose content depends on their position in the ring
+ */
+static int
+create_ring_mempool_data(void)
+{
+	void *objs[MP_OBJ_NUM];
+	struct rte_mempool *mp;
+	struct rte_ring *r;
+	unsigned int i;
+
+	mp = rte_mempool_create(MP_OBJ_POOL, MP_OBJ_POOL_SIZE, MP_OBJ_SIZE, 0,
+			0, NULL, NULL, NULL, NULL, rte_socket_id(), 0);
+	r = rte_ring_create(MP_OBJ_RING, MP_OBJ_NUM, rte_socket_id(),
+			RING_F_EXACT_SZ);
+	if (mp == NULL || r == NULL ||
+			rte_mempool_get_bulk(mp, objs, MP_OBJ_NUM) < 0) {
+		printf("Error: cannot create %s and %s\n", MP_OBJ_POOL,
+			MP_OBJ_RING);
+		rte_ring_free(r);
+		rte_mempool_free(mp);
+		return -1;
+	}
+	for (i = 0; i < MP_OBJ_NUM; i++)
+		memset(objs[i], i & 0xff, MP_OBJ_SIZE);
+	rte_ring_enqueue_bulk(r, objs, MP_OBJ_NUM, NULL);
+
+	return 0;
+}
+
+static void
+free_ring_mempool_data(void)
+{
+	struct rte_mempool *mp = rte_mempool_lookup(MP_OBJ_POOL);
+	struct rte_ring *r = rte_ring_lookup(MP_OBJ_RING);
+	void *obj;
+
+	while (rte_ring_dequeue(r, &obj) == 0)
+		rte_mempool_put(mp, obj);
+	rte_ring_free(r);
+	rte_mempool_free(mp);
+}
+
 /*
  * This function is called in the primary i.e. main test, to spawn off secondary
  * processes to run actual mp tests. Uses fork() and exec pair
@@ -57,6 +113,7 @@
 static int
 run_secondary_instances(void)
 {
+	const struct rte_memzone *mz;
 	int ret = 0;
 	char coremask[10];
 
@@ -92,22 +149,133 @@ run_secondary_instances(void)
 			prgname, "-c", coremask, "--proc-type=secondary",
 					"--file-prefix=ERROR"
 	};
+	/* good case, mapping memory of the primary on lookup */
+	const char *argv5[] = {
+			prgname, "-c", coremask, "--proc-type=secondary",
+			"--lazy-mem-attach", prefix
+	};
 #endif
 
 	snprintf(coremask, sizeof(coremask), "%x", \
 			(1 << rte_get_master_lcore()));
 
+	mz = rte_memzone_reserve(MP_PATTERN_MZ, MP_PATTERN_LEN,
+			rte_socket_id(), 0);
+	if (mz == NULL) {
+		printf("Error: cannot reserve %s\n", MP_PATTERN_MZ);
+		return -1;
+	}
+	memset(mz->addr, MP_PATTERN_BYTE, MP_PATTERN_LEN);
+	if (create_ring_mempool_data() < 0) {
+		rte_memzone_free(mz);
+		return -1;
+	}
+
 	ret |= launch_proc(argv1);
 	ret |= launch_proc(argv2);
 
 	ret |= !(launch_proc(argv3));
 #ifdef RTE_EXEC_ENV_LINUX
 	ret |= !(launch_proc(argv4));
+	ret |= launch_proc(argv5);
 #endif
 
+	free_ring_mempool_data();
+	rte_memzone_free(mz);
+
 	return ret;
 }
 
+/*
+ * This function is run in the secondary instance to test that the memory of
+ * the primary is accessible, whether it was mapped at startup or not
+ */
+static int
+run_memzone_data_tests(void)
+{
+	const struct rte_memzone *mz;
+	const uint8_t *data;
+	size_t i;
+
+	mz = rte_memzone_lookup(MP_PATTERN_MZ);
+	if (mz == NULL) {
+		printf("Error: cannot find %s\n", MP_PATTERN_MZ);
+		return -1;
+	}
+	data = mz->addr;
+	for (i = 0; i < MP_PATTERN_LEN; i++) {
+		if (data[i] != MP_PATTERN_BYTE) {
+			printf("Error: unexpected data in %s at %zu\n",
+				MP_PATTERN_MZ, i);
+			return -1;
+		}
+	}
+	printf("# Checked memzone data OK\n");
+
+	return 0;
+}
+
+/*
+ * This function is run in the secondary instance to test that the objects
+ * held by a ring, the mempool they come from and its pool data are accessible
+ * once the ring and the mempool are looked up. The objects are put back in
+ * the ring for the next secondary.
+ */
+static int
+run_ring_mempool_data_tests(void)
+{
+	void *objs[MP_OBJ_NUM];
+	struct rte_mempool *mp;
+	struct rte_ring *r;
+	unsigned int i, j;
+	void *obj;
+
+	mp = rte_mempool_lookup(MP_OBJ_POOL);
+	r = rte_ring_lookup(MP_OBJ_RING);
+	if (mp == NULL || r == NULL) {
+		printf("Error: cannot find %s or %s\n", MP_OBJ_POOL,
+			MP_OBJ_RING);
+		return -1;
+	}
+	if (rte_ring_dequeue_bulk(r, objs, MP_OBJ_NUM, NULL) != MP_OBJ_NUM) {
+		printf("Error: cannot dequeue objects from %s\n", MP_OBJ_RING);
+		return -1;
+	}
+	for (i = 0; i < MP_OBJ_NUM; i++) {
+		const uint8_t *data = objs[i];
+
+		if (rte_mempool_from_obj(objs[i]) != mp) {
+			printf("Error: object %u is not from %s\n", i,
+				MP_OBJ_POOL);
+			goto fail;
+		}
+		for (j = 0; j < MP_OBJ_SIZE; j++) {
+			if (data[j] != (i & 0xff)) {
+				printf("Error: unexpected data in object %u\n",
+					i);
+				goto fail;
+			}
+		}
+	}
+	printf("# Checked ring objects OK\n");
+
+	if (rte_mempool_avail_count(mp) != MP_OBJ_POOL_SIZE - MP_OBJ_NUM ||
+			rte_mempool_get(mp, &obj) < 0) {
+		printf("Error: unexpected objects available in %s\n",
+			MP_OBJ_POOL);
+		goto fail;
+	}
+	rte_mempool_put(mp, obj);
+	printf("# Checked mempool objects OK\n");
+
+	rte_ring_enqueue_bulk(r, objs, MP_OBJ_NUM, NULL);
+	return 0;
+
+fail:
+	rte_ring_enqueue_bulk(r, objs, MP_OBJ_NUM, NULL);
+	return -1;
+}
+
 /*
  * This function is run in the secondary instance to test that creation of
  * objects fails in a secondary
@@ -203,6 +371,9 @@ test_mp_secondary(void)
 
 	printf("IN SECONDARY PROCESS\n");
 
+	if (run_memzone_data_tests() < 0 ||
+			run_ring_mempool_data_tests() < 0)
+		return -1;
 	return run_object_creation_tests();
 }
 
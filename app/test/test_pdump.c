@@ -72,8 +72,8 @@ run_pdump_client_tests(void)
 	}
 	rte_eth_dev_probing_finish(eth_dev);
 
-	ring_client->prod.single = 0;
-	ring_client->cons.single = 0;
+	ring_client->prod.sync_type = RTE_RING_SYNC_MT;
+	ring_client->cons.sync_type = RTE_RING_SYNC_MT;
 
 	printf("\n***** flags = RTE_PDUMP_FLAG_TX *****\n");
 
@@ -3,12 +3,14 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <rte_pause.h>
 #include <rte_rcu_qsbr.h>
 #include <rte_hash.h>
 #include <rte_hash_crc.h>
 #include <rte_malloc.h>
 #include <rte_cycles.h>
+#include <rte_errno.h>
 #include <unistd.h>
 
 #include "test.h"
@@ -614,6 +616,169 @@ test_rcu_qsbr_dump(void)
 	return 0;
 }
 
+static uint32_t dq_freed[8];
+static uint32_t dq_freed_cnt;
+
+static void
+test_rcu_qsbr_free_resource(void *p, void *e, unsigned int n)
+{
+	RTE_SET_USED(p);
+	RTE_SET_USED(n);
+
+	if (dq_freed_cnt < RTE_DIM(dq_freed))
+		dq_freed[dq_freed_cnt] = *(uint32_t *)e;
+	dq_freed_cnt++;
+}
+
+/*
+ * rte_rcu_qsbr_dq_create: create a defer queue
+ */
+static int
+test_rcu_qsbr_dq_create(void)
+{
+	struct rte_rcu_qsbr_dq_parameters params;
+	struct rte_rcu_qsbr_dq *dq;
+
+	printf("\nTest rte_rcu_qsbr_dq_create()\n");
+
+	/* Negative tests */
+	dq = rte_rcu_qsbr_dq_create(NULL);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((dq != NULL), "dq create NULL params");
+
+	memset(&params, 0, sizeof(params));
+	params.name = "TEST_RCU";
+	dq = rte_rcu_qsbr_dq_create(&params);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((dq != NULL), "dq create NULL free_fn");
+
+	params.free_fn = test_rcu_qsbr_free_resource;
+	dq = rte_rcu_qsbr_dq_create(&params);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((dq != NULL), "dq create NULL QS var");
+
+	params.v = t[0];
+	dq = rte_rcu_qsbr_dq_create(&params);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((dq != NULL), "dq create size 0");
+
+	params.size = 4;
+	params.esize = 3;
+	dq = rte_rcu_qsbr_dq_create(&params);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((dq != NULL), "dq create esize 3");
+
+	params.esize = 4;
+	params.trigger_reclaim_limit = 2;
+	dq = rte_rcu_qsbr_dq_create(&params);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((dq != NULL),
+		"dq create without max reclaim size");
+
+	/* Valid parameters */
+	params.max_reclaim_size = 1;
+	dq = rte_rcu_qsbr_dq_create(&params);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((dq == NULL), "dq create valid");
+
+	TEST_RCU_QSBR_RETURN_IF_ERROR((rte_rcu_qsbr_dq_delete(dq) != 0),
+		"dq delete");
+	TEST_RCU_QSBR_RETURN_IF_ERROR((rte_rcu_qsbr_dq_delete(NULL) != 0),
+		"dq delete NULL");
+
+	return 0;
+}
+
+/*
+ * rte_rcu_qsbr_dq_enqueue/reclaim/delete: resources are freed only
+ * after the reader reported the quiescent state.
+ */
+static int
+test_rcu_qsbr_dq_functional(void)
+{
+	struct rte_rcu_qsbr_dq_parameters params;
+	struct rte_rcu_qsbr_dq *dq;
+	unsigned int freed, pending, available;
+	uint32_t i, e;
+	int ret;
+
+	printf("\nTest rte_rcu_qsbr_dq_enqueue/reclaim/delete()\n");
+
+	rte_rcu_qsbr_init(t[0], RTE_MAX_LCORE);
+	rte_rcu_qsbr_thread_register(t[0], enabled_core_ids[0]);
+	rte_rcu_qsbr_thread_online(t[0], enabled_core_ids[0]);
+
+	memset(&params, 0, sizeof(params));
+	params.name = "TEST_RCU";
+	params.free_fn = test_rcu_qsbr_free_resource;
+	params.v = t[0];
+	params.size = 4;
+	params.esize = sizeof(uint32_t);
+	params.flags = RTE_RCU_QSBR_DQ_MT_UNSAFE;
+	dq = rte_rcu_qsbr_dq_create(&params);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((dq == NULL), "dq create");
+
+	dq_freed_cnt = 0;
+
+	/* Negative tests */
+	e = 0;
+	ret = rte_rcu_qsbr_dq_enqueue(NULL, &e);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((ret == 0), "dq enqueue NULL dq");
+	ret = rte_rcu_qsbr_dq_enqueue(dq, NULL);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((ret == 0), "dq enqueue NULL element");
+	ret = rte_rcu_qsbr_dq_reclaim(NULL, 1, NULL, NULL, NULL);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((ret == 0), "dq reclaim NULL dq");
+
+	/* Fill the defer queue */
+	for (i = 0; i < params.size; i++) {
+		e = i + 1;
+		ret = rte_rcu_qsbr_dq_enqueue(dq, &e);
+		TEST_RCU_QSBR_RETURN_IF_ERROR((ret != 0), "dq enqueue");
+	}
+
+	/* The reader has not reported quiescent state */
+	e = params.size + 1;
+	ret = rte_rcu_qsbr_dq_enqueue(dq, &e);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((ret == 0 || rte_errno != ENOSPC),
+		"dq enqueue on full queue");
+
+	ret = rte_rcu_qsbr_dq_reclaim(dq, params.size, &freed, &pending,
+			&available);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((ret != 0 || freed != 0 ||
+		pending != params.size || available != 0 || dq_freed_cnt != 0),
+		"dq reclaim before quiescent state");
+
+	ret = rte_rcu_qsbr_dq_delete(dq);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((ret == 0 || rte_errno != EAGAIN),
+		"dq delete with pending resources");
+
+	/* Report quiescent state, all resources can be freed in order */
+	rte_rcu_qsbr_quiescent(t[0], enabled_core_ids[0]);
+
+	ret = rte_rcu_qsbr_dq_reclaim(dq, params.size, &freed, &pending,
+			&available);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((ret != 0 || freed != params.size ||
+		pending != 0 || available != params.size),
+		"dq reclaim after quiescent state");
+	for (i = 0; i < params.size; i++)
+		TEST_RCU_QSBR_RETURN_IF_ERROR((dq_freed[i] != i + 1),
+			"dq reclaim order, freed %u", dq_freed[i]);
+
+	/* Enqueue reclaims by itself when the queue is full */
+	for (i = 0; i < params.size; i++) {
+		e = i;
+		rte_rcu_qsbr_dq_enqueue(dq, &e);
+	}
+	rte_rcu_qsbr_quiescent(t[0], enabled_core_ids[0]);
+	ret = rte_rcu_qsbr_dq_enqueue(dq, &e);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((ret != 0 ||
+		dq_freed_cnt != params.size + 1),
+		"dq enqueue reclaim on full queue");
+
+	rte_rcu_qsbr_quiescent(t[0], enabled_core_ids[0]);
+	ret = rte_rcu_qsbr_dq_delete(dq);
+	TEST_RCU_QSBR_RETURN_IF_ERROR((ret != 0 ||
+		dq_freed_cnt != 2 * params.size + 1), "dq delete");
+
+	rte_rcu_qsbr_thread_offline(t[0], enabled_core_ids[0]);
+	rte_rcu_qsbr_thread_unregister(t[0], enabled_core_ids[0]);
+
+	return 0;
+}
+
 static int
 test_rcu_qsbr_reader(void *arg)
 {
@@ -1025,6 +1190,12 @@ test_rcu_qsbr_main(void)
 	if (test_rcu_qsbr_thread_offline() < 0)
 		goto test_fail;
 
+	if (test_rcu_qsbr_dq_create() < 0)
+		goto test_fail;
+
+	if (test_rcu_qsbr_dq_functional() < 0)
+		goto test_fail;
+
 	printf("\nFunctional tests\n");
 
 	if (test_rcu_qsbr_sw_sv_3qs() < 0)
@@ -47,6 +47,14 @@
  *      - Dequeue one object, two objects, MAX_BULK objects
  *      - Check that dequeued pointers are correct
  *
+ *    - Using zero-copy functions, with single and multi producers/consumers:
+ *
+ *      - Fill and read reserved slots wrapping around the end of the ring
+ *      - Commit less than reserved on single producer/consumer rings
+ *
+ *    - Using the default functions on rings created with every sync mode
+ *      (MP/MC, SP/SC, HTS, RTS) and checking the conflicting flags
+ *
  * #. Performance tests.
  *
  * Tests done in test_ring_perf.c
@@ -807,6 +815,252 @@ end:
 	return ret;
 }
 
+/*
+ * write/read objects in place through a zero-copy reservation
+ */
+static void
+test_ring_zc_fill(const struct rte_ring_zc_data *zcd, unsigned int n,
+		uintptr_t first)
+{
+	unsigned int i;
+
+	for (i = 0; i < zcd->n1; i++)
+		zcd->ptr1[i] = (void *)(first + i);
+	for (; i < n; i++)
+		zcd->ptr2[i - zcd->n1] = (void *)(first + i);
+}
+
+static int
+test_ring_zc_check(const struct rte_ring_zc_data *zcd, unsigned int n,
+		uintptr_t first)
+{
+	unsigned int i;
+	void *obj;
+
+	for (i = 0; i < n; i++) {
+		obj = (i < zcd->n1) ? zcd->ptr1[i] : zcd->ptr2[i - zcd->n1];
+		if (obj != (void *)(first + i))
+			return -1;
+	}
+	return 0;
+}
+
+static int
+test_ring_zc_flags(unsigned int flags, int partial)
+{
+	struct rte_ring_zc_data zcd;
+	struct rte_ring *r;
+	void *obj[16];
+	unsigned int i, n;
+
+	r = rte_ring_create("test_ring_zc", RTE_DIM(obj), SOCKET_ID_ANY,
+			flags);
+	if (r == NULL) {
+		printf("%s: error, can't create ring\n", __func__);
+		return -1;
+	}
+
+	/* move the indexes so that the reservations wrap around */
+	TEST_RING_VERIFY(rte_ring_enqueue_bulk(r, obj, 10, NULL) == 10);
+	TEST_RING_VERIFY(rte_ring_dequeue_bulk(r, obj, 10, NULL) == 10);
+
+	/* more than the free space */
+	n = rte_ring_enqueue_zc_bulk_start(r, 16, &zcd, NULL);
+	TEST_RING_VERIFY(n == 0);
+	rte_ring_enqueue_zc_finish(r, &zcd, 0);
+	TEST_RING_VERIFY(rte_ring_empty(r));
+
+	/* enqueue in place, dequeue with a copy */
+	n = rte_ring_enqueue_zc_burst_start(r, 12, &zcd, NULL);
+	TEST_RING_VERIFY(n == 12);
+	TEST_RING_VERIFY(zcd.n1 == 6 && zcd.ptr2 != NULL);
+	test_ring_zc_fill(&zcd, n, 1);
+	TEST_RING_VERIFY(rte_ring_count(r) == 0);
+	rte_ring_enqueue_zc_finish(r, &zcd, n);
+	TEST_RING_VERIFY(rte_ring_count(r) == 12);
+	TEST_RING_VERIFY(rte_ring_dequeue_bulk(r, obj, 12, NULL) == 12);
+	for (i = 0; i < 12; i++)
+		TEST_RING_VERIFY(obj[i] == (void *)(uintptr_t)(i + 1));
+
+	/* enqueue with a copy, dequeue in place */
+	for (i = 0; i < 12; i++)
+		obj[i] = (void *)(uintptr_t)(i + 100);
+	TEST_RING_VERIFY(rte_ring_enqueue_bulk(r, obj, 12, NULL) == 12);
+	n = rte_ring_dequeue_zc_bulk_start(r, 12, &zcd, NULL);
+	TEST_RING_VERIFY(n == 12);
+	TEST_RING_VERIFY(test_ring_zc_check(&zcd, n, 100) == 0);
+	rte_ring_dequeue_zc_finish(r, &zcd, n);
+	TEST_RING_VERIFY(rte_ring_empty(r));
+
+	/* burst reservations are limited by the ring content */
+	n = rte_ring_dequeue_zc_burst_start(r, 12, &zcd, NULL);
+	TEST_RING_VERIFY(n == 0);
+	rte_ring_dequeue_zc_finish(r, &zcd, 0);
+
+	if (partial) {
+		/* commit less than reserved */
+		n = rte_ring_enqueue_zc_burst_start(r, 8, &zcd, NULL);
+		TEST_RING_VERIFY(n == 8);
+		test_ring_zc_fill(&zcd, 5, 200);
+		rte_ring_enqueue_zc_finish(r, &zcd, 5);
+		TEST_RING_VERIFY(rte_ring_count(r) == 5);
+
+		/* peek, then consume part of the objects */
+		n = rte_ring_dequeue_zc_burst_start(r, 8, &zcd, NULL);
+		TEST_RING_VERIFY(n == 5);
+		TEST_RING_VERIFY(test_ring_zc_check(&zcd, n, 200) == 0);
+		rte_ring_dequeue_zc_finish(r, &zcd, 0);
+		TEST_RING_VERIFY(rte_ring_count(r) == 5);
+		n = rte_ring_dequeue_zc_bulk_start(r, 5, &zcd, NULL);
+		TEST_RING_VERIFY(n == 5);
+		TEST_RING_VERIFY(test_ring_zc_check(&zcd, n, 200) == 0);
+		rte_ring_dequeue_zc_finish(r, &zcd, 2);
+		TEST_RING_VERIFY(rte_ring_count(r) == 3);
+		TEST_RING_VERIFY(rte_ring_dequeue_burst(r, obj, 8, NULL) == 3);
+		for (i = 0; i < 3; i++)
+			TEST_RING_VERIFY(obj[i] == (void *)(uintptr_t)(i + 202));
+	}
+
+	rte_ring_free(r);
+	return 0;
+}
+
+/*
+ * zero-copy enqueue/dequeue in all the producer/consumer sync modes
+ */
+static int
+test_ring_zc(void)
+{
+	if (test_ring_zc_flags(RING_F_SP_ENQ | RING_F_SC_DEQ, 1) < 0)
+		return -1;
+	if (test_ring_zc_flags(0, 0) < 0)
+		return -1;
+	if (test_ring_zc_flags(RING_F_MP_HTS_ENQ | RING_F_MC_HTS_DEQ, 1) < 0)
+		return -1;
+	return test_ring_zc_flags(RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ, 0);
+}
+
+/*
+ * check the enqueue/dequeue calls which follow the sync modes given
+ * at ring creation time
+ */
+static int
+test_ring_sync_mode(unsigned int flags, enum rte_ring_sync_type prod_st,
+		enum rte_ring_sync_type cons_st)
+{
+	struct rte_ring *r;
+	void *src[MAX_BULK], *dst[MAX_BULK];
+	unsigned int i, j, n;
+
+	r = rte_ring_create("test_ring_sync", 64, SOCKET_ID_ANY, flags);
+	if (r == NULL) {
+		printf("%s: error, can't create ring with flags %#x\n",
+				__func__, flags);
+		return -1;
+	}
+
+	TEST_RING_VERIFY(rte_ring_get_prod_sync_type(r) == prod_st);
+	TEST_RING_VERIFY(rte_ring_get_cons_sync_type(r) == cons_st);
+
+	for (i = 0; i < RTE_DIM(src); i++)
+		src[i] = (void *)(uintptr_t)(i + 1);
+
+	/* go around the ring several times */
+	for (i = 0; i < 16; i++) {
+		TEST_RING_VERIFY(rte_ring_enqueue_bulk(r, src, MAX_BULK,
+				NULL) == MAX_BULK);
+		TEST_RING_VERIFY(rte_ring_enqueue_bulk(r, src, MAX_BULK,
+				NULL) == 0);
+		TEST_RING_VERIFY(rte_ring_enqueue_burst(r, src, MAX_BULK,
+				NULL) == 63 - MAX_BULK);
+		TEST_RING_VERIFY(rte_ring_full(r));
+		TEST_RING_VERIFY(rte_ring_enqueue(r, src[0]) == -ENOBUFS);
+
+		TEST_RING_VERIFY(rte_ring_dequeue_bulk(r, dst, MAX_BULK,
+				&n) == MAX_BULK);
+		TEST_RING_VERIFY(n == 63 - MAX_BULK);
+		for (j = 0; j < MAX_BULK; j++)
+			TEST_RING_VERIFY(dst[j] == src[j]);
+		TEST_RING_VERIFY(rte_ring_dequeue_bulk(r, dst, MAX_BULK,
+				NULL) == 0);
+		TEST_RING_VERIFY(rte_ring_dequeue_burst(r, dst, MAX_BULK,
+				NULL) == 63 - MAX_BULK);
+		for (j = 0; j < 63 - MAX_BULK; j++)
+			TEST_RING_VERIFY(dst[j] == src[j]);
+		TEST_RING_VERIFY(rte_ring_empty(r));
+		TEST_RING_VERIFY(rte_ring_dequeue(r, dst) == -ENOENT);
+
+		/* shift the indexes so that the next copies wrap around */
+		TEST_RING_VERIFY(rte_ring_enqueue(r, src[0]) == 0);
+		TEST_RING_VERIFY(rte_ring_dequeue(r, dst) == 0);
+	}
+
+	rte_ring_reset(r);
+	TEST_RING_VERIFY(rte_ring_empty(r));
+	TEST_RING_VERIFY(rte_ring_enqueue_bulk(r, src, MAX_BULK,
+			NULL) == MAX_BULK);
+	TEST_RING_VERIFY(rte_ring_count(r) == MAX_BULK);
+
+	rte_ring_free(r);
+	return 0;
+}
+
+static int
+test_ring_sync_modes(void)
+{
+	struct rte_ring *r;
+
+	if (test_ring_sync_mode(0, RTE_RING_SYNC_MT, RTE_RING_SYNC_MT) < 0)
+		return -1;
+	if (test_ring_sync_mode(RING_F_SP_ENQ | RING_F_SC_DEQ,
+			RTE_RING_SYNC_ST, RTE_RING_SYNC_ST) < 0)
+		return -1;
+	if (test_ring_sync_mode(RING_F_MP_HTS_ENQ | RING_F_MC_HTS_DEQ,
+			RTE_RING_SYNC_MT_HTS, RTE_RING_SYNC_MT_HTS) < 0)
+		return -1;
+	if (test_ring_sync_mode(RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ,
+			RTE_RING_SYNC_MT_RTS, RTE_RING_SYNC_MT_RTS) < 0)
+		return -1;
+	if (test_ring_sync_mode(RING_F_MP_HTS_ENQ | RING_F_MC_RTS_DEQ,
+			RTE_RING_SYNC_MT_HTS, RTE_RING_SYNC_MT_RTS) < 0)
+		return -1;
+	if (test_ring_sync_mode(RING_F_SP_ENQ | RING_F_MC_HTS_DEQ,
+			RTE_RING_SYNC_ST, RTE_RING_SYNC_MT_HTS) < 0)
+		return -1;
+
+	/* only one sync mode per producer/consumer */
+	r = rte_ring_create("test_ring_sync", 64, SOCKET_ID_ANY,
+			RING_F_SP_ENQ | RING_F_MP_HTS_ENQ);
+	if (r != NULL) {
+		printf("%s: error, created ring with conflicting flags\n",
+				__func__);
+		rte_ring_free(r);
+		return -1;
+	}
+	r = rte_ring_create("test_ring_sync", 64, SOCKET_ID_ANY,
+			RING_F_MC_RTS_DEQ | RING_F_MC_HTS_DEQ);
+	if (r != NULL) {
+		printf("%s: error, created ring with conflicting flags\n",
+				__func__);
+		rte_ring_free(r);
+		return -1;
+	}
+
+	/* the head/tail distance can only be set in RTS mode */
+	r = rte_ring_create("test_ring_sync", 64, SOCKET_ID_ANY,
+			RING_F_MP_RTS_ENQ);
+	if (r == NULL)
+		return -1;
+	TEST_RING_VERIFY(rte_ring_get_prod_htd_max(r) == 63 / 8);
+	TEST_RING_VERIFY(rte_ring_set_prod_htd_max(r, 4) == 0);
+	TEST_RING_VERIFY(rte_ring_get_prod_htd_max(r) == 4);
+	TEST_RING_VERIFY(rte_ring_get_cons_htd_max(r) == UINT32_MAX);
+	TEST_RING_VERIFY(rte_ring_set_cons_htd_max(r, 4) == -ENOTSUP);
+	rte_ring_free(r);
+
+	return 0;
+}
+
 static int
 test_ring(void)
 {
@@ -860,6 +1114,12 @@ test_ring(void)
 	if (test_ring_with_exact_size() < 0)
 		goto test_fail;
 
+	if (test_ring_zc() < 0)
+		goto test_fail;
+
+	if (test_ring_sync_modes() < 0)
+		goto test_fail;
+
 	/* dump the ring status */
 	rte_ring_list_dump(stdout);
 
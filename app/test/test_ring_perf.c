@@ -9,6 +9,7 @@
 #include <rte_cycles.h>
 #include <rte_launch.h>
 #include <rte_pause.h>
+#include <rte_malloc.h>
 
 #include "test.h"
 
@@ -20,6 +21,7 @@
  *  * Empty ring dequeue
  *  * Enqueue/dequeue of bursts in 1 threads
  *  * Enqueue/dequeue of bursts in 2 threads
+ *  * Enqueue/dequeue of bursts on all lcores, for each multi-thread sync mode
  */
 
 #define RING_NAME "RING_PERF"
@@ -372,6 +374,106 @@ test_bulk_enqueue_dequeue(struct rte_ring *r)
 	}
 }
 
+/*
+ * Parameters of the enqueue/dequeue run on all lcores at once
+ */
+struct sync_mode_params {
+	struct rte_ring *r;
+	unsigned int size;     /* input value, the burst size */
+	double cycles[RTE_MAX_LCORE]; /* output value, per lcore timing */
+};
+
+/*
+ * Function that enqueues and dequeues bursts using the default functions,
+ * i.e. the sync mode the ring was created with. Runs on all lcores.
+ */
+static int
+enqueue_dequeue_sync_mode(void *p)
+{
+	const unsigned int iter_shift = 16;
+	const unsigned int iterations = 1 << iter_shift;
+	struct sync_mode_params *params = p;
+	struct rte_ring *r = params->r;
+	const unsigned int size = params->size;
+	const unsigned int lcores = rte_lcore_count();
+	unsigned int i;
+	void *burst[MAX_BURST] = {0};
+
+#ifdef RTE_USE_C11_MEM_MODEL
+	if (__atomic_add_fetch(&lcore_count, 1, __ATOMIC_RELAXED) != lcores)
+#else
+	if (__sync_add_and_fetch(&lcore_count, 1) != lcores)
+#endif
+		while (lcore_count != lcores)
+			rte_pause();
+
+	const uint64_t start = rte_rdtsc();
+	for (i = 0; i < iterations; i++) {
+		while (rte_ring_enqueue_bulk(r, burst, size, NULL) == 0)
+			rte_pause();
+		while (rte_ring_dequeue_bulk(r, burst, size, NULL) == 0)
+			rte_pause();
+	}
+	const uint64_t end = rte_rdtsc();
+
+	params->cycles[rte_lcore_id()] = ((double)(end - start)) /
+			(iterations * size);
+	return 0;
+}
+
+/*
+ * Compare the multi-thread sync modes with all the lcores hammering the
+ * same ring. Start the test with more lcores than CPUs, e.g.
+ * --lcores='(0-7)@0', to see how the modes behave when the ring users
+ * get preempted in the middle of an enqueue/dequeue.
+ */
+static int
+test_sync_modes(void)
+{
+	static const struct {
+		const char *name;
+		unsigned int flags;
+	} modes[] = {
+		{ "MP/MC", 0 },
+		{ "MP/MC HTS", RING_F_MP_HTS_ENQ | RING_F_MC_HTS_DEQ },
+		{ "MP/MC RTS", RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ },
+	};
+	struct sync_mode_params *params;
+	unsigned int i, j, lcore_id;
+	double total;
+
+	params = rte_zmalloc(NULL, sizeof(*params), 0);
+	if (params == NULL)
+		return -1;
+
+	for (i = 0; i < RTE_DIM(modes); i++) {
+		params->r = rte_ring_create(RING_NAME "_SYNC", RING_SIZE,
+				rte_socket_id(), modes[i].flags);
+		if (params->r == NULL) {
+			rte_free(params);
+			return -1;
+		}
+		for (j = 0; j < RTE_DIM(bulk_sizes); j++) {
+			lcore_count = 0;
+			params->size = bulk_sizes[j];
+			rte_eal_mp_remote_launch(enqueue_dequeue_sync_mode,
+					params, CALL_MASTER);
+			rte_eal_mp_wait_lcore();
+
+			total = 0;
+			RTE_LCORE_FOREACH(lcore_id)
+				total += params->cycles[lcore_id];
+			printf("%s bulk enq/dequeue on %u lcores (size: %u): %.2F\n",
+					modes[i].name, rte_lcore_count(),
+					bulk_sizes[j], total / rte_lcore_count());
+		}
+		rte_ring_free(params->r);
+	}
+
+	rte_free(params);
+	return 0;
+}
+
 static int
 test_ring_perf(void)
 {
@@ -405,6 +507,12 @@ test_ring_perf(void)
 		run_on_core_pair(&cores, r, enqueue_bulk, dequeue_bulk);
 	}
 	rte_ring_free(r);
+
+	if (rte_lcore_count() > 1) {
+		printf("\n### Testing sync modes using all lcores ###\n");
+		if (test_sync_modes() < 0)
+			return -1;
+	}
 	return 0;
 }
 
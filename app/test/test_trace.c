@@ -0,0 +1,236 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#include <stdio.h>
+
+#include <rte_eal_trace.h>
+#include <rte_trace.h>
+
+#include "test.h"
+#include "test_trace.h"
+
+static int32_t
+test_trace_point_globbing(void)
+{
+	int rc;
+
+	rc = rte_trace_pattern("app.dpdk.test*", false);
+	if (rc != 1)
+		goto failed;
+
+	if (rte_trace_point_is_enabled(&__app_dpdk_test_tp))
+		goto failed;
+
+	rc = rte_trace_pattern("app.dpdk.test*", true);
+	if (rc != 1)
+		goto failed;
+
+	if (!rte_trace_point_is_enabled(&__app_dpdk_test_tp))
+		goto failed;
+
+	rc = rte_trace_pattern("invalid_testpoint.*", true);
+	if (rc != 0)
+		goto failed;
+
+	return TEST_SUCCESS;
+
+failed:
+	return TEST_FAILED;
+}
+
+static int32_t
+test_trace_point_regex(void)
+{
+	int rc;
+
+	rc = rte_trace_regexp("app.dpdk.test*", false);
+	if (rc != 1)
+		goto failed;
+
+	if (rte_trace_point_is_enabled(&__app_dpdk_test_tp))
+		goto failed;
+
+	rc = rte_trace_regexp("app.dpdk.test*", true);
+	if (rc != 1)
+		goto failed;
+
+	if (!rte_trace_point_is_enabled(&__app_dpdk_test_tp))
+		goto failed;
+
+	rc = rte_trace_regexp("invalid_testpoint.*", true);
+	if (rc != 0)
+		goto failed;
+
+	rc = rte_trace_regexp("app.dpdk.test[", true);
+	if (rc != -EINVAL)
+		goto failed;
+
+	return TEST_SUCCESS;
+
+failed:
+	return TEST_FAILED;
+}
+
+static int32_t
+test_trace_point_disable_enable(void)
+{
+	int rc;
+
+	rc = rte_trace_point_disable(&__app_dpdk_test_tp);
+	if (rc < 0)
+		goto failed;
+
+	if (rte_trace_point_is_enabled(&__app_dpdk_test_tp))
+		goto failed;
+
+	/* Emit the trace */
+	app_dpdk_test_tp("app.dpdk.test.tp");
+
+	rc = rte_trace_point_enable(&__app_dpdk_test_tp);
+	if (rc < 0)
+		goto failed;
+
+	if (!rte_trace_point_is_enabled(&__app_dpdk_test_tp))
+		goto failed;
+
+	/* Emit the trace */
+	app_dpdk_test_tp("app.dpdk.test.tp");
+
+	/* Unknown handles are rejected */
+	if (rte_trace_point_enable(NULL) != -ERANGE)
+		goto failed;
+
+	return TEST_SUCCESS;
+
+failed:
+	return TEST_FAILED;
+}
+
+static int
+test_trace_mode(void)
+{
+	enum rte_trace_mode current;
+
+	current = rte_trace_mode_get();
+
+	rte_trace_mode_set(RTE_TRACE_MODE_DISCARD);
+	if (rte_trace_mode_get() != RTE_TRACE_MODE_DISCARD)
+		goto failed;
+
+	rte_trace_mode_set(RTE_TRACE_MODE_OVERWRITE);
+	if (rte_trace_mode_get() != RTE_TRACE_MODE_OVERWRITE)
+		goto failed;
+
+	rte_trace_mode_set(current);
+	return TEST_SUCCESS;
+
+failed:
+	return TEST_FAILED;
+}
+
+static int
+test_trace_points_lookup(void)
+{
+	rte_trace_point_t *trace;
+
+	trace = rte_trace_point_lookup("app.dpdk.test.tp");
+	if (trace == NULL)
+		goto fail;
+	if (trace != &__app_dpdk_test_tp)
+		goto fail;
+
+	trace = rte_trace_point_lookup("lib.eal.generic.void");
+	if (trace == NULL)
+		goto fail;
+
+	trace = rte_trace_point_lookup("this_trace_point_does_not_exist");
+	if (trace != NULL)
+		goto fail;
+
+	return TEST_SUCCESS;
+fail:
+	return TEST_FAILED;
+}
+
+static int
+test_trace_fastpath_point(void)
+{
+	/* Emitting a fast path trace point compiled out must be harmless */
+	if (rte_trace_point_enable(&__app_dpdk_test_fp) < 0)
+		return TEST_FAILED;
+
+	app_dpdk_test_fp();
+
+	if (rte_trace_point_disable(&__app_dpdk_test_fp) < 0)
+		return TEST_FAILED;
+
+	return TEST_SUCCESS;
+}
+
+static int
+test_generic_trace_points(void)
+{
+	int tmp;
+
+	if (rte_trace_pattern("lib.eal.generic.*", true) != 1)
+		return TEST_FAILED;
+
+	rte_eal_trace_generic_void();
+	rte_eal_trace_generic_u64(0x10000000000000);
+	rte_eal_trace_generic_ptr(&tmp);
+	rte_eal_trace_generic_str("my string");
+	RTE_EAL_TRACE_GENERIC_FUNC;
+
+	if (rte_trace_pattern("lib.eal.generic.*", false) != 1)
+		return TEST_FAILED;
+
+	return TEST_SUCCESS;
+}
+
+static int
+test_trace_dump(void)
+{
+	rte_trace_dump(stdout);
+	return 0;
+}
+
+static int
+test_trace_metadata_dump(void)
+{
+	return rte_trace_metadata_dump(stdout);
+}
+
+static int
+test_trace_save(void)
+{
+	/* Save the events emitted by the previous test cases */
+	return rte_trace_save();
+}
+
+static struct unit_test_suite trace_tests = {
+	.suite_name = "trace autotest",
+	.setup = NULL,
+	.teardown = NULL,
+	.unit_test_cases = {
+		TEST_CASE(test_trace_mode),
+		TEST_CASE(test_generic_trace_points),
+		TEST_CASE(test_trace_point_disable_enable),
+		TEST_CASE(test_trace_point_globbing),
+		TEST_CASE(test_trace_point_regex),
+		TEST_CASE(test_trace_points_lookup),
+		TEST_CASE(test_trace_fastpath_point),
+		TEST_CASE(test_trace_dump),
+		TEST_CASE(test_trace_metadata_dump),
+		TEST_CASE(test_trace_save),
+		TEST_CASES_END()
+	}
+};
+
+static int
+test_trace(void)
+{
+	return unit_test_suite_runner(&trace_tests);
+}
+
+REGISTER_TEST_COMMAND(trace_autotest, test_trace);
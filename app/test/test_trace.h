@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#include <rte_trace_point.h>
+
+RTE_TRACE_POINT(
+	app_dpdk_test_tp,
+	RTE_TRACE_POINT_ARGS(const char *str),
+	rte_trace_point_emit_string(str);
+)
+
+RTE_TRACE_POINT_FP(
+	app_dpdk_test_fp,
+	RTE_TRACE_POINT_ARGS(void),
+)
@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <rte_cycles.h>
+#include <rte_eal_trace.h>
+#include <rte_trace.h>
+
+#include "test.h"
+
+/*
+ * Trace
+ * =====
+ *
+ * Measures the cost of emitting the generic trace points using rdtsc
+ *  * when the trace points are disabled, i.e. the cost left in the
+ *    application once the trace points are compiled in
+ *  * when the trace points are enabled, i.e. the cost of an event
+ */
+
+#define ITERATIONS (1 << 22)
+
+/*
+ * the value emitted by the trace points
+ * (marked volatile so it won't be seen as a compile-time constant)
+ */
+static volatile uint64_t trace_val = 0x10000000000000;
+
+static double
+empty_loop_cycles(void)
+{
+	uint64_t start, end;
+	unsigned int i;
+
+	start = rte_rdtsc_precise();
+	for (i = 0; i < ITERATIONS; i++)
+		rte_compiler_barrier();
+	end = rte_rdtsc_precise();
+
+	return (double)(end - start) / ITERATIONS;
+}
+
+#define MEASURE(fn) \
+do { \
+	uint64_t start, end; \
+	unsigned int i; \
+	start = rte_rdtsc_precise(); \
+	for (i = 0; i < ITERATIONS; i++) { \
+		fn; \
+		rte_compiler_barrier(); \
+	} \
+	end = rte_rdtsc_precise(); \
+	printf("%-10s %-40s %6.2f cycles/call\n", state, #fn, \
+		(double)(end - start) / ITERATIONS - empty); \
+} while (0)
+
+static void
+measure(const char *state, double empty)
+{
+	MEASURE(rte_eal_trace_generic_void());
+	MEASURE(rte_eal_trace_generic_u64(trace_val));
+	MEASURE(rte_eal_trace_generic_str(__func__));
+}
+
+static int
+test_trace_perf(void)
+{
+	enum rte_trace_mode mode;
+	double empty;
+
+	empty = empty_loop_cycles();
+	printf("Empty loop: %.2f cycles/iteration\n", empty);
+
+	if (rte_trace_pattern("lib.eal.generic.*", false) < 0)
+		return TEST_FAILED;
+	measure("disabled", empty);
+
+	/* Overwrite mode, so that the buffer never fills up */
+	mode = rte_trace_mode_get();
+	rte_trace_mode_set(RTE_TRACE_MODE_OVERWRITE);
+	if (rte_trace_pattern("lib.eal.generic.*", true) < 0)
+		return TEST_FAILED;
+	measure("enabled", empty);
+
+	if (rte_trace_pattern("lib.eal.generic.*", false) < 0)
+		return TEST_FAILED;
+	rte_trace_mode_set(mode);
+
+	return TEST_SUCCESS;
+}
+
+REGISTER_TEST_COMMAND(trace_perf_autotest, test_trace_perf);
@@ -8,12 +8,14 @@
 
 #include <rte_string_fns.h>
 #include <rte_mbuf.h>
+#include <rte_memcpy.h>
 #include <rte_ethdev_driver.h>
 #include <rte_ethdev_vdev.h>
 #include <rte_malloc.h>
 #include <rte_kvargs.h>
 #include <rte_bus_vdev.h>
 
+#include <ctype.h>
 #include <errno.h>
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
@@ -22,6 +24,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -33,8 +36,11 @@
 #define ETH_AF_PACKET_FRAMESIZE_ARG	"framesz"
 #define ETH_AF_PACKET_FRAMECOUNT_ARG	"framecnt"
 #define ETH_AF_PACKET_QDISC_BYPASS_ARG	"qdisc_bypass"
+#define ETH_AF_PACKET_TPACKET_V3_ARG	"tpacket_v3"
+#define ETH_AF_PACKET_BLOCKTMO_ARG	"blocktmo"
 
 #define DFLT_FRAME_SIZE		(1 << 11)
+#define AF_PACKET_MAX_BLOCKTMO	60000 /* ms */
 #define DFLT_FRAME_COUNT	(1 << 9)
 
 #define RTE_PMD_AF_PACKET_MAX_RINGS 16
@@ -42,16 +48,24 @@
 struct pkt_rx_queue {
 	int sockfd;
 
+	/* with TPACKET_V3, rd holds the blocks and not the frames */
 	struct iovec *rd;
 	uint8_t *map;
 	unsigned int framecount;
 	unsigned int framenum;
 
+	/* TPACKET_V3: next frame and frames left in the current block */
+	struct tpacket3_hdr *frame;
+	unsigned int frames_left;
+
 	struct rte_mempool *mb_pool;
+	unsigned int buf_size;
 	uint16_t in_port;
 
 	volatile unsigned long rx_pkts;
 	volatile unsigned long rx_bytes;
+	volatile unsigned long rx_nombuf;
+	volatile unsigned long err_pkts;
 };
 
 struct pkt_tx_queue {
@@ -76,6 +90,7 @@ struct pmd_internals {
 	struct rte_ether_addr eth_addr;
 
 	struct tpacket_req req;
+	int tpver;
 
 	struct pkt_rx_queue rx_queue[RTE_PMD_AF_PACKET_MAX_RINGS];
 	struct pkt_tx_queue tx_queue[RTE_PMD_AF_PACKET_MAX_RINGS];
@@ -88,6 +103,8 @@ static const char *valid_arguments[] = {
 	ETH_AF_PACKET_FRAMESIZE_ARG,
 	ETH_AF_PACKET_FRAMECOUNT_ARG,
 	ETH_AF_PACKET_QDISC_BYPASS_ARG,
+	ETH_AF_PACKET_TPACKET_V3_ARG,
+	ETH_AF_PACKET_BLOCKTMO_ARG,
 	NULL
 };
 
@@ -137,8 +154,10 @@ eth_af_packet_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 
 		/* allocate the next mbuf */
 		mbuf = rte_pktmbuf_alloc(pkt_q->mb_pool);
-		if (unlikely(mbuf == NULL))
+		if (unlikely(mbuf == NULL)) {
+			pkt_q->rx_nombuf++;
 			break;
+		}
 
 		/* packet will fit in the mbuf, go ahead and receive it */
 		rte_pktmbuf_pkt_len(mbuf) = rte_pktmbuf_data_len(mbuf) = ppd->tp_snaplen;
@@ -168,6 +187,100 @@ eth_af_packet_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	return num_rx;
 }
 
+/*
+ * Receive from a TPACKET_V3 ring, where the kernel fills whole blocks of
+ * frames and hands them over at once. The mbufs for the frames of a block
+ * are allocated in bulk, and a block is released once all its frames
+ * are copied.
+ */
+static uint16_t
+eth_af_packet_rx_v3(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pkt_rx_queue *pkt_q = queue;
+	struct tpacket_block_desc *pbd;
+	struct tpacket3_hdr *ppd;
+	struct rte_mbuf *mbuf, **mbufs;
+	unsigned int i, j, n, frames_left, framecount, framenum;
+	uint16_t num_rx = 0;
+	unsigned long num_rx_bytes = 0;
+
+	framecount = pkt_q->framecount;
+	framenum = pkt_q->framenum;
+	ppd = pkt_q->frame;
+	frames_left = pkt_q->frames_left;
+
+	while (num_rx < nb_pkts) {
+		pbd = (struct tpacket_block_desc *)pkt_q->rd[framenum].iov_base;
+
+		/* get the frames of the next block filled by the kernel */
+		if (frames_left == 0) {
+			if ((pbd->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+				break;
+			rte_smp_rmb();
+			frames_left = pbd->hdr.bh1.num_pkts;
+			ppd = (struct tpacket3_hdr *)((uint8_t *)pbd +
+				pbd->hdr.bh1.offset_to_first_pkt);
+		}
+
+		n = RTE_MIN(frames_left, (unsigned int)(nb_pkts - num_rx));
+		mbufs = &bufs[num_rx];
+		if (n != 0 &&
+		    unlikely(rte_pktmbuf_alloc_bulk(pkt_q->mb_pool, mbufs, n))) {
+			pkt_q->rx_nombuf++;
+			break;
+		}
+
+		for (i = 0, j = 0; i != n; i++) {
+			mbuf = mbufs[i];
+
+			/* drop the frames which don't fit in an mbuf */
+			if (unlikely(ppd->tp_snaplen > pkt_q->buf_size)) {
+				rte_pktmbuf_free(mbuf);
+				pkt_q->err_pkts++;
+				ppd = (struct tpacket3_hdr *)((uint8_t *)ppd +
+					ppd->tp_next_offset);
+				continue;
+			}
+
+			rte_pktmbuf_pkt_len(mbuf) = ppd->tp_snaplen;
+			rte_pktmbuf_data_len(mbuf) = ppd->tp_snaplen;
+			rte_memcpy(rte_pktmbuf_mtod(mbuf, void *),
+				(uint8_t *)ppd + ppd->tp_mac,
+				ppd->tp_snaplen);
+
+			/* check for vlan info */
+			if (ppd->tp_status & TP_STATUS_VLAN_VALID) {
+				mbuf->vlan_tci = ppd->hv1.tp_vlan_tci;
+				mbuf->ol_flags |= (PKT_RX_VLAN |
+					PKT_RX_VLAN_STRIPPED);
+			}
+			mbuf->port = pkt_q->in_port;
+
+			mbufs[j++] = mbuf;
+			num_rx_bytes += mbuf->pkt_len;
+			ppd = (struct tpacket3_hdr *)((uint8_t *)ppd +
+				ppd->tp_next_offset);
+		}
+		num_rx += j;
+		frames_left -= n;
+
+		/* release the block and advance to the next one */
+		if (frames_left == 0) {
+			rte_smp_mb();
+			pbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+			if (++framenum >= framecount)
+				framenum = 0;
+		}
+	}
+
+	pkt_q->framenum = framenum;
+	pkt_q->frame = ppd;
+	pkt_q->frames_left = frames_left;
+	pkt_q->rx_pkts += num_rx;
+	pkt_q->rx_bytes += num_rx_bytes;
+	return num_rx;
+}
+
 /*
  * Callback to handle sending packets through a real NIC.
  */
@@ -318,6 +431,7 @@ eth_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *igb_stats)
 	unsigned i, imax;
 	unsigned long rx_total = 0, tx_total = 0, tx_err_total = 0;
 	unsigned long rx_bytes_total = 0, tx_bytes_total = 0;
+	unsigned long rx_nombuf_total = 0, rx_err_total = 0;
 	const struct pmd_internals *internal = dev->data->dev_private;
 
 	imax = (internal->nb_queues < RTE_ETHDEV_QUEUE_STAT_CNTRS ?
@@ -327,6 +441,8 @@ eth_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *igb_stats)
 		igb_stats->q_ibytes[i] = internal->rx_queue[i].rx_bytes;
 		rx_total += igb_stats->q_ipackets[i];
 		rx_bytes_total += igb_stats->q_ibytes[i];
+		rx_nombuf_total += internal->rx_queue[i].rx_nombuf;
+		rx_err_total += internal->rx_queue[i].err_pkts;
 	}
 
 	imax = (internal->nb_queues < RTE_ETHDEV_QUEUE_STAT_CNTRS ?
@@ -341,6 +457,8 @@ eth_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *igb_stats)
 
 	igb_stats->ipackets = rx_total;
 	igb_stats->ibytes = rx_bytes_total;
+	igb_stats->rx_nombuf = rx_nombuf_total;
+	igb_stats->ierrors = rx_err_total;
 	igb_stats->opackets = tx_total;
 	igb_stats->oerrors = tx_err_total;
 	igb_stats->obytes = tx_bytes_total;
@@ -356,6 +474,8 @@ eth_stats_reset(struct rte_eth_dev *dev)
 	for (i = 0; i < internal->nb_queues; i++) {
 		internal->rx_queue[i].rx_pkts = 0;
 		internal->rx_queue[i].rx_bytes = 0;
+		internal->rx_queue[i].rx_nombuf = 0;
+		internal->rx_queue[i].err_pkts = 0;
 	}
 
 	for (i = 0; i < internal->nb_queues; i++) {
@@ -399,10 +519,15 @@ eth_rx_queue_setup(struct rte_eth_dev *dev,
 	/* Now get the space available for data in the mbuf */
 	buf_size = rte_pktmbuf_data_room_size(pkt_q->mb_pool) -
 		RTE_PKTMBUF_HEADROOM;
+	pkt_q->buf_size = buf_size;
 	data_size = internals->req.tp_frame_size;
 	data_size -= TPACKET2_HDRLEN - sizeof(struct sockaddr_ll);
 
-	if (data_size > buf_size) {
+	/*
+	 * TPACKET_V3 frames aren't bounded by the frame size, the frames
+	 * larger than the mbufs are dropped on receive.
+	 */
+	if (internals->tpver == TPACKET_V2 && data_size > buf_size) {
 		PMD_LOG(ERR,
 			"%s: %d bytes will not fit in mbuf (%d bytes)",
 			dev->device->name, data_size, buf_size);
@@ -540,6 +665,8 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
                        unsigned int framesize,
                        unsigned int framecnt,
 		       unsigned int qdisc_bypass,
+		       int tpver,
+		       unsigned int blocktmo,
                        struct pmd_internals **internals,
                        struct rte_eth_dev **eth_dev,
                        struct rte_kvargs *kvlist)
@@ -553,11 +680,14 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 	unsigned k_idx;
 	struct sockaddr_ll sockaddr;
 	struct tpacket_req *req;
+	struct tpacket_req3 req3;
 	struct pkt_rx_queue *rx_queue;
 	struct pkt_tx_queue *tx_queue;
-	int rc, tpver, discard;
+	int rc, txver, discard;
 	int qsockfd = -1;
+	int txsockfd = -1;
 	unsigned int i, q, rdsize;
+	size_t mapsize;
 #if defined(PACKET_FANOUT)
 	int fanout_arg;
 #endif
@@ -594,6 +724,22 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 	req->tp_block_nr = blockcnt;
 	req->tp_frame_size = framesize;
 	req->tp_frame_nr = framecnt;
+	(*internals)->tpver = tpver;
+
+	memset(&req3, 0, sizeof(req3));
+	req3.tp_block_size = blocksize;
+	req3.tp_block_nr = blockcnt;
+	req3.tp_frame_size = framesize;
+	req3.tp_frame_nr = framecnt;
+	req3.tp_retire_blk_tov = blocktmo;
+
+	/*
+	 * Both rings are mapped at once with TPACKET_V2. TPACKET_V3 only
+	 * maps the Rx ring of its socket, the Tx ring has its own.
+	 */
+	mapsize = (size_t)req->tp_block_size * req->tp_block_nr;
+	if (tpver == TPACKET_V2)
+		mapsize *= 2;
 
 	ifnamelen = strlen(pair->value);
 	if (ifnamelen < sizeof(ifr.ifr_name)) {
@@ -634,6 +780,8 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 #endif
 
 	for (q = 0; q < nb_queues; q++) {
+		txsockfd = -1;
+
 		/* Open an AF_PACKET socket for this queue... */
 		qsockfd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
 		if (qsockfd == -1) {
@@ -643,7 +791,6 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 			return -1;
 		}
 
-		tpver = TPACKET_V2;
 		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_VERSION,
 				&tpver, sizeof(tpver));
 		if (rc == -1) {
@@ -653,8 +800,34 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 			goto error;
 		}
 
+		/*
+		 * TPACKET_V3 is only used for Rx, transmit on a TPACKET_V2
+		 * socket which doesn't receive anything.
+		 */
+		if (tpver == TPACKET_V3) {
+			txsockfd = socket(AF_PACKET, SOCK_RAW, 0);
+			if (txsockfd == -1) {
+				PMD_LOG_ERRNO(ERR,
+					"%s: could not open AF_PACKET socket",
+					name);
+				goto error;
+			}
+
+			txver = TPACKET_V2;
+			rc = setsockopt(txsockfd, SOL_PACKET, PACKET_VERSION,
+					&txver, sizeof(txver));
+			if (rc == -1) {
+				PMD_LOG_ERRNO(ERR,
+					"%s: could not set PACKET_VERSION on AF_PACKET socket for %s",
+					name, pair->value);
+				goto error;
+			}
+		} else {
+			txsockfd = qsockfd;
+		}
+
 		discard = 1;
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_LOSS,
+		rc = setsockopt(txsockfd, SOL_PACKET, PACKET_LOSS,
 				&discard, sizeof(discard));
 		if (rc == -1) {
 			PMD_LOG_ERRNO(ERR,
@@ -664,7 +837,7 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 		}
 
 #if defined(PACKET_QDISC_BYPASS)
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_QDISC_BYPASS,
+		rc = setsockopt(txsockfd, SOL_PACKET, PACKET_QDISC_BYPASS,
 				&qdisc_bypass, sizeof(qdisc_bypass));
 		if (rc == -1) {
 			PMD_LOG_ERRNO(ERR,
@@ -676,7 +849,12 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 		RTE_SET_USED(qdisc_bypass);
 #endif
 
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_RX_RING, req, sizeof(*req));
+		if (tpver == TPACKET_V3)
+			rc = setsockopt(qsockfd, SOL_PACKET, PACKET_RX_RING,
+					&req3, sizeof(req3));
+		else
+			rc = setsockopt(qsockfd, SOL_PACKET, PACKET_RX_RING,
+					req, sizeof(*req));
 		if (rc == -1) {
 			PMD_LOG_ERRNO(ERR,
 				"%s: could not set PACKET_RX_RING on AF_PACKET socket for %s",
@@ -684,7 +862,7 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 			goto error;
 		}
 
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_TX_RING, req, sizeof(*req));
+		rc = setsockopt(txsockfd, SOL_PACKET, PACKET_TX_RING, req, sizeof(*req));
 		if (rc == -1) {
 			PMD_LOG_ERRNO(ERR,
 				"%s: could not set PACKET_TX_RING on AF_PACKET "
@@ -695,7 +873,7 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 		rx_queue = &((*internals)->rx_queue[q]);
 		rx_queue->framecount = req->tp_frame_nr;
 
-		rx_queue->map = mmap(NULL, 2 * req->tp_block_size * req->tp_block_nr,
+		rx_queue->map = mmap(NULL, mapsize,
 				    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED,
 				    qsockfd, 0);
 		if (rx_queue->map == MAP_FAILED) {
@@ -711,9 +889,19 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 		rx_queue->rd = rte_zmalloc_socket(name, rdsize, 0, numa_node);
 		if (rx_queue->rd == NULL)
 			goto error;
-		for (i = 0; i < req->tp_frame_nr; ++i) {
-			rx_queue->rd[i].iov_base = rx_queue->map + (i * framesize);
-			rx_queue->rd[i].iov_len = req->tp_frame_size;
+		if (tpver == TPACKET_V3) {
+			rx_queue->framecount = req->tp_block_nr;
+			for (i = 0; i < req->tp_block_nr; ++i) {
+				rx_queue->rd[i].iov_base = rx_queue->map +
+					i * blocksize;
+				rx_queue->rd[i].iov_len = req->tp_block_size;
+			}
+		} else {
+			for (i = 0; i < req->tp_frame_nr; ++i) {
+				rx_queue->rd[i].iov_base = rx_queue->map +
+					i * framesize;
+				rx_queue->rd[i].iov_len = req->tp_frame_size;
+			}
 		}
 		rx_queue->sockfd = qsockfd;
 
@@ -723,7 +911,20 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 		tx_queue->frame_data_size -= TPACKET2_HDRLEN -
 			sizeof(struct sockaddr_ll);
 
-		tx_queue->map = rx_queue->map + req->tp_block_size * req->tp_block_nr;
+		if (tpver == TPACKET_V3) {
+			tx_queue->map = mmap(NULL, mapsize,
+					PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_LOCKED, txsockfd, 0);
+			if (tx_queue->map == MAP_FAILED) {
+				PMD_LOG_ERRNO(ERR,
+					"%s: call to mmap failed on AF_PACKET socket for %s",
+					name, pair->value);
+				goto error;
+			}
+		} else {
+			tx_queue->map = rx_queue->map +
+				req->tp_block_size * req->tp_block_nr;
+		}
 
 		tx_queue->rd = rte_zmalloc_socket(name, rdsize, 0, numa_node);
 		if (tx_queue->rd == NULL)
@@ -732,7 +933,7 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 			tx_queue->rd[i].iov_base = tx_queue->map + (i * framesize);
 			tx_queue->rd[i].iov_len = req->tp_frame_size;
 		}
-		tx_queue->sockfd = qsockfd;
+		tx_queue->sockfd = txsockfd;
 
 		rc = bind(qsockfd, (const struct sockaddr*)&sockaddr, sizeof(sockaddr));
 		if (rc == -1) {
@@ -742,6 +943,20 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 			goto error;
 		}
 
+		if (txsockfd != qsockfd) {
+			/* no protocol, the Tx socket must not receive */
+			sockaddr.sll_protocol = 0;
+			rc = bind(txsockfd, (const struct sockaddr *)&sockaddr,
+					sizeof(sockaddr));
+			sockaddr.sll_protocol = htons(ETH_P_ALL);
+			if (rc == -1) {
+				PMD_LOG_ERRNO(ERR,
+					"%s: could not bind AF_PACKET socket to %s",
+					name, pair->value);
+				goto error;
+			}
+		}
+
 #if defined(PACKET_FANOUT)
 		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_FANOUT,
 				&fanout_arg, sizeof(fanout_arg));
@@ -783,15 +998,23 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 error:
 	if (qsockfd != -1)
 		close(qsockfd);
+	if (txsockfd != -1 && txsockfd != qsockfd)
+		close(txsockfd);
 	for (q = 0; q < nb_queues; q++) {
-		munmap((*internals)->rx_queue[q].map,
-		       2 * req->tp_block_size * req->tp_block_nr);
+		munmap((*internals)->rx_queue[q].map, mapsize);
+		if (tpver == TPACKET_V3)
+			munmap((*internals)->tx_queue[q].map, mapsize);
 
 		rte_free((*internals)->rx_queue[q].rd);
 		rte_free((*internals)->tx_queue[q].rd);
 		if (((*internals)->rx_queue[q].sockfd != 0) &&
 			((*internals)->rx_queue[q].sockfd != qsockfd))
 			close((*internals)->rx_queue[q].sockfd);
+		if (((*internals)->tx_queue[q].sockfd != 0) &&
+			((*internals)->tx_queue[q].sockfd != txsockfd) &&
+			((*internals)->tx_queue[q].sockfd !=
+			 (*internals)->rx_queue[q].sockfd))
+			close((*internals)->tx_queue[q].sockfd);
 	}
 	free((*internals)->if_name);
 	rte_free(*internals);
@@ -814,6 +1037,9 @@ rte_eth_from_packet(struct rte_vdev_device *dev,
 	unsigned int framecount = DFLT_FRAME_COUNT;
 	unsigned int qpairs = 1;
 	unsigned int qdisc_bypass = 1;
+	unsigned int tpacket_v3 = 0;
+	unsigned long blocktmo = 0;
+	char *end;
 
 	/* do some parameter checking */
 	if (*sockfd < 0)
@@ -877,6 +1103,29 @@ rte_eth_from_packet(struct rte_vdev_device *dev,
 			}
 			continue;
 		}
+		if (strstr(pair->key, ETH_AF_PACKET_TPACKET_V3_ARG) != NULL) {
+			tpacket_v3 = atoi(pair->value);
+			if (tpacket_v3 > 1) {
+				PMD_LOG(ERR,
+					"%s: invalid tpacket_v3 value",
+					name);
+				return -1;
+			}
+			continue;
+		}
+		if (strstr(pair->key, ETH_AF_PACKET_BLOCKTMO_ARG) != NULL) {
+			errno = 0;
+			blocktmo = strtoul(pair->value, &end, 10);
+			if (errno != 0 || end == pair->value || *end != '\0' ||
+			    !isdigit((unsigned char)pair->value[0]) ||
+			    blocktmo > AF_PACKET_MAX_BLOCKTMO) {
+				PMD_LOG(ERR,
+					"%s: invalid blocktmo value",
+					name);
+				return -1;
+			}
+			continue;
+		}
 	}
 
 	if (framesize > blocksize) {
@@ -898,16 +1147,25 @@ rte_eth_from_packet(struct rte_vdev_device *dev,
 	PMD_LOG(INFO, "%s:\tblock count %d", name, blockcount);
 	PMD_LOG(INFO, "%s:\tframe size %d", name, framesize);
 	PMD_LOG(INFO, "%s:\tframe count %d", name, framecount);
+	if (tpacket_v3)
+		PMD_LOG(INFO, "%s:\tTPACKET_V3 Rx, block timeout %u ms%s",
+			name, (unsigned int)blocktmo,
+			blocktmo ? "" : " (kernel default)");
 
 	if (rte_pmd_init_internals(dev, *sockfd, qpairs,
 				   blocksize, blockcount,
 				   framesize, framecount,
 				   qdisc_bypass,
+				   tpacket_v3 ? TPACKET_V3 : TPACKET_V2,
+				   blocktmo,
 				   &internals, &eth_dev,
 				   kvlist) < 0)
 		return -1;
 
-	eth_dev->rx_pkt_burst = eth_af_packet_rx;
+	if (tpacket_v3)
+		eth_dev->rx_pkt_burst = eth_af_packet_rx_v3;
+	else
+		eth_dev->rx_pkt_burst = eth_af_packet_rx;
 	eth_dev->tx_pkt_burst = eth_af_packet_tx;
 
 	rte_eth_dev_probing_finish(eth_dev);
@@ -972,6 +1230,7 @@ rte_pmd_af_packet_remove(struct rte_vdev_device *dev)
 {
 	struct rte_eth_dev *eth_dev = NULL;
 	struct pmd_internals *internals;
+	size_t mapsize;
 	unsigned q;
 
 	PMD_LOG(INFO, "Closing AF_PACKET ethdev on numa socket %u",
@@ -992,7 +1251,16 @@ rte_pmd_af_packet_remove(struct rte_vdev_device *dev)
 		return rte_eth_dev_release_port(eth_dev);
 
 	internals = eth_dev->data->dev_private;
+	mapsize = (size_t)internals->req.tp_block_size *
+		internals->req.tp_block_nr;
 	for (q = 0; q < internals->nb_queues; q++) {
+		/* one map for both rings, except for TPACKET_V3 */
+		if (internals->tpver == TPACKET_V3) {
+			munmap(internals->rx_queue[q].map, mapsize);
+			munmap(internals->tx_queue[q].map, mapsize);
+		} else {
+			munmap(internals->rx_queue[q].map, 2 * mapsize);
+		}
 		rte_free(internals->rx_queue[q].rd);
 		rte_free(internals->tx_queue[q].rd);
 	}
@@ -1016,7 +1284,9 @@ RTE_PMD_REGISTER_PARAM_STRING(net_af_packet,
 	"blocksz=<int> "
 	"framesz=<int> "
 	"framecnt=<int> "
-	"qdisc_bypass=<0|1>");
+	"qdisc_bypass=<0|1> "
+	"tpacket_v3=<0|1> "
+	"blocktmo=<int>");
 
 RTE_INIT(af_packet_init_log)
 {
@@ -10,6 +10,7 @@
 #include <rte_timer.h>
 #include <rte_log.h>
 #include <rte_kni.h>
+#include <rte_rcu_qsbr.h>
 
 #include <stdio.h>
 #include <math.h>
@@ -40,17 +41,13 @@
 #define NUM_MBUFS (4096-1)
 
 #define BURST_SIZE	32
+// vector PMDs receive nothing into fewer slots than that
+#define RX_MIN_BURST	4
 #define RING_SIZE	1024
 #define MAX_PACKET_SIZE		2048
 #define TIMER_RESOLUTION_CYCLES 120000000000ULL // 10ms * 1000 = 10s * 6 
 
 
-#if ENABLE_ARP
-
-#define ARP_ENTRY_STATUS_DYNAMIC	0
-#define ARP_ENTRY_STATUS_STATIC		1
-
-
 #define LL_ADD(item, list) do {		\
 	item->prev = NULL;				\
 	item->next = list;				\
@@ -67,93 +64,14 @@
 } while(0)
 
 
-struct arp_entry {
-
-	uint32_t ip;
-	uint8_t hwaddr[RTE_ETHER_ADDR_LEN];
-
-	uint8_t type;
-	// 
-
-	struct arp_entry *next;
-	struct arp_entry *prev;
-
-	
-};
-
-struct arp_table {
-
-	struct arp_entry *entries;
-	int count;
-
-	pthread_spinlock_t spinlock;
-};
-
-
-
-static struct  arp_table *arpt = NULL;
-
-static struct  arp_table *arp_table_instance(void) {
-
-	if (arpt == NULL) {
-
-		arpt = rte_malloc("arp table", sizeof(struct  arp_table), 0);
-		if (arpt == NULL) {
-			rte_exit(EXIT_FAILURE, "rte_malloc arp table failed\n");
-		}
-		memset(arpt, 0, sizeof(struct  arp_table));
-
-		pthread_spin_init(&arpt->spinlock, PTHREAD_PROCESS_SHARED);
-	}
-
-	return arpt;
-
-}
-
-
-static uint8_t* ng_get_dst_macaddr(uint32_t dip) {
-
-	struct arp_entry *iter;
-	struct arp_table *table = arp_table_instance();
-
-	int count = table->count;
-	
-	for (iter = table->entries; count-- != 0 && iter != NULL;iter = iter->next) {
-		if (dip == iter->ip) {
-			return iter->hwaddr;
-		}
-	}
-
-	return NULL;
-}
-
-static int ng_arp_entry_insert(uint32_t ip, uint8_t *mac) {
-
-	struct arp_table *table = arp_table_instance();
-
-	uint8_t *hwaddr = ng_get_dst_macaddr(ip);
-	if (hwaddr == NULL) {
+#if ENABLE_ARP
 
-		struct arp_entry *entry = rte_malloc("arp_entry",sizeof(struct arp_entry), 0);
-		if (entry) {
-			memset(entry, 0, sizeof(struct arp_entry));
+#include "arp.h"
 
-			entry->ip = ip;
-			rte_memcpy(entry->hwaddr, mac, RTE_ETHER_ADDR_LEN);
-			entry->type = 0;
+// readers of the arp table: master lcore and pkt_process
+#define ARP_QSBR_THREADS	2
 
-			pthread_spin_lock(&table->spinlock);
-			LL_ADD(entry, table->entries);
-			table->count ++;
-			pthread_spin_unlock(&table->spinlock);
-			
-		}
-
-		return 1; //
-	}
-
-	return 0;
-}
+static struct rte_rcu_qsbr *gQsbr = NULL;
 
 #endif
 
@@ -507,6 +425,44 @@ static struct rte_mbuf *ng_send_arp(struct rte_mempool *mbuf_pool, uint16_t opco
 	return mbuf;
 }
 
+// ng_neigh solicit callback, runs on pkt_process
+static void
+arp_solicit(void *arg, uint32_t ip, const struct rte_ether_addr *mac) {
+
+	struct rte_mempool *mbuf_pool = (struct rte_mempool *)arg;
+	struct inout_ring *ring = ringInstance();
+
+	struct rte_mbuf *arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, 
+		mac != NULL ? (uint8_t *)(uintptr_t)mac->addr_bytes : gDefaultArpMac, gLocalIp, ip);
+
+	rte_ring_mp_enqueue_burst(ring->out, (void **)&arpbuf, 1, NULL);
+}
+
+// learn a neighbor, send what waited for its address
+static void
+arp_learn(uint32_t ip, struct rte_ether_addr *mac, unsigned int flags) {
+
+	struct rte_mbuf *pending[NG_NEIGH_MAX_PENDING];
+	int nb_pending = ng_neigh_update(arp_table_instance(), ip, mac, flags, pending);
+	if (nb_pending > 0) {
+		struct inout_ring *ring = ringInstance();
+		rte_ring_mp_enqueue_burst(ring->out, (void **)pending, nb_pending, NULL);
+	}
+}
+
+// set the destination mac of pkt, or keep it until the neighbor is resolved
+static void
+arp_output(uint32_t nexthop, struct rte_mbuf *pkt) {
+
+	int ret = ng_neigh_resolve(arp_table_instance(), nexthop, pkt);
+	if (ret == 0) {
+		struct inout_ring *ring = ringInstance();
+		rte_ring_mp_enqueue_burst(ring->out, (void **)&pkt, 1, NULL);
+	} else if (ret < 0) {
+		rte_pktmbuf_free(pkt); // arp table full
+	}
+}
+
 #endif
 
 
@@ -634,14 +590,14 @@ arp_request_timer_cb(__attribute__((unused)) struct rte_timer *tim,
 		printf("arp ---> src: %s \n", inet_ntoa(addr));
 */
 		struct rte_mbuf *arpbuf = NULL;
-		uint8_t *dstmac = ng_get_dst_macaddr(dstip);
-		if (dstmac == NULL) {
+		struct rte_ether_addr dstmac;
+		if (ng_neigh_lookup(arp_table_instance(), dstip, &dstmac) < NG_NEIGH_REACHABLE) {
 
 			arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, gDefaultArpMac, gLocalIp, dstip);
 		
 		} else {
 
-			arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, dstmac, gLocalIp, dstip);
+			arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, dstmac.addr_bytes, gLocalIp, dstip);
 		}
 
 		//rte_eth_tx_burst(gDpdkPortId, 0, &arpbuf, 1);
@@ -664,8 +620,21 @@ static int pkt_process(void *arg) {
 	struct rte_mempool *mbuf_pool = (struct rte_mempool *)arg;
 	struct inout_ring *ring = ringInstance();
 
+	uint64_t age_cycles = rte_get_timer_hz() * ARP_AGE_INTERVAL_MS / 1000;
+	uint64_t age_tsc = rte_get_timer_cycles();
+
+	rte_rcu_qsbr_thread_register(gQsbr, 1);
+	rte_rcu_qsbr_thread_online(gQsbr, 1);
+
 	while (1) {
 
+		rte_rcu_qsbr_quiescent(gQsbr, 1);
+
+		if (rte_get_timer_cycles() - age_tsc > age_cycles) {
+			ng_neigh_age(arp_table_instance(), ARP_AGE_BUDGET);
+			age_tsc = rte_get_timer_cycles();
+		}
+
 		struct rte_mbuf *mbufs[BURST_SIZE];
 		unsigned num_recvd = rte_ring_mc_dequeue_burst(ring->in, (void**)mbufs, BURST_SIZE, NULL);
 		
@@ -682,7 +651,7 @@ static int pkt_process(void *arg) {
 				
 #if 1 // arp table
 				
-				ng_arp_entry_insert(iphdr->src_addr, ehdr->s_addr.addr_bytes);
+				arp_learn(iphdr->src_addr, &ehdr->s_addr, NG_NEIGH_F_CREATE);
 				
 #endif
 			
@@ -708,6 +677,18 @@ static int pkt_process(void *arg) {
 			} else {
 			// ifconfig vEth0 192.168.0.119 up 
 
+				if (ehdr->ether_type == rte_cpu_to_be_16(RTE_ETHER_TYPE_ARP)) {
+
+					struct rte_arp_hdr *ahdr = rte_pktmbuf_mtod_offset(mbufs[i], 
+						struct rte_arp_hdr *, sizeof(struct rte_ether_hdr));
+
+					// learn the sender, the kernel answers through kni
+					if (ahdr->arp_data.arp_tip == gLocalIp) {
+						arp_learn(ahdr->arp_data.arp_sip, &ahdr->arp_data.arp_sha, NG_NEIGH_F_CREATE |
+							(ahdr->arp_opcode == rte_cpu_to_be_16(RTE_ARP_OP_REPLY) ? NG_NEIGH_F_CONFIRMED : 0));
+					}
+				}
+
 				rte_kni_tx_burst(global_kni, mbufs, num_recvd);
 				
 				printf("ip --> rte_kni_handle_request\n");
@@ -1014,27 +995,11 @@ static int udp_out(struct rte_mempool *mbuf_pool) {
 		addr.s_addr = ol->dip;
 		printf("udp_out ---> src: %s:%d \n", inet_ntoa(addr), ntohs(ol->dport));
 			
-		uint8_t *dstmac = ng_get_dst_macaddr(ol->dip); //
-		if (dstmac == NULL) {
-
-			struct rte_mbuf *arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, gDefaultArpMac, 
-				ol->sip, ol->dip);
-
-			struct inout_ring *ring = ringInstance();
-			rte_ring_mp_enqueue_burst(ring->out, (void **)&arpbuf, 1, NULL);
-
-			rte_ring_mp_enqueue(host->sndbuf, ol);
-			
-		} else {
-
-			struct rte_mbuf *udpbuf = ng_udp_pkt(mbuf_pool, ol->sip, ol->dip, ol->sport, ol->dport,
-				host->localmac, dstmac, ol->data, ol->length);
-
-			
-			struct inout_ring *ring = ringInstance();
-			rte_ring_mp_enqueue_burst(ring->out, (void **)&udpbuf, 1, NULL);
+		// dst mac set by arp_output
+		struct rte_mbuf *udpbuf = ng_udp_pkt(mbuf_pool, ol->sip, ol->dip, ol->sport, ol->dport,
+			host->localmac, gDefaultArpMac, ol->data, ol->length);
 
-		}
+		arp_output(ol->dip, udpbuf);
 		
 
 	}
@@ -2105,30 +2070,15 @@ static int ng_tcp_out(struct rte_mempool *mbuf_pool) {
 		int nb_snd = rte_ring_mc_dequeue(stream->sndbuf, (void**)&fragment);
 		if (nb_snd < 0) continue;
 
-		uint8_t *dstmac = ng_get_dst_macaddr(stream->sip); // 
-		if (dstmac == NULL) {
-
-			//printf("ng_send_arp\n");
-			struct rte_mbuf *arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, gDefaultArpMac, 
-				stream->dip, stream->sip);
-
-			struct inout_ring *ring = ringInstance();
-			rte_ring_mp_enqueue_burst(ring->out, (void **)&arpbuf, 1, NULL);
+		// dst mac set by arp_output
+		struct rte_mbuf *tcpbuf = ng_tcp_pkt(mbuf_pool, stream->dip, stream->sip, stream->localmac, gDefaultArpMac, fragment);
 
-			rte_ring_mp_enqueue(stream->sndbuf, fragment);
-
-		} else {
-
-			struct rte_mbuf *tcpbuf = ng_tcp_pkt(mbuf_pool, stream->dip, stream->sip, stream->localmac, dstmac, fragment);
+		arp_output(stream->sip, tcpbuf);
 
-			struct inout_ring *ring = ringInstance();
-			rte_ring_mp_enqueue_burst(ring->out, (void **)&tcpbuf, 1, NULL);
-
-			if (fragment->data != NULL)
-				rte_free(fragment->data);
-			
-			rte_free(fragment);
-		}
+		if (fragment->data != NULL)
+			rte_free(fragment->data);
+		
+		rte_free(fragment);
 
 	}
 
@@ -2447,6 +2397,22 @@ int main(int argc, char *argv[]) {
 
 	rte_eth_macaddr_get(gDpdkPortId, (struct rte_ether_addr *)gSrcMac);
 
+#if ENABLE_ARP
+
+	size_t qsbr_size = rte_rcu_qsbr_get_memsize(ARP_QSBR_THREADS);
+	gQsbr = rte_zmalloc("arp qsbr", qsbr_size, RTE_CACHE_LINE_SIZE);
+	if (gQsbr == NULL || rte_rcu_qsbr_init(gQsbr, ARP_QSBR_THREADS) != 0) {
+		rte_exit(EXIT_FAILURE, "arp qsbr init failed\n");
+	}
+
+	arp_table_create(gQsbr, arp_solicit, mbuf_pool);
+
+	// the master lcore runs arp_request_timer_cb
+	rte_rcu_qsbr_thread_register(gQsbr, 0);
+	rte_rcu_qsbr_thread_online(gQsbr, 0);
+
+#endif
+
 #if ENABLE_TIMER
 
 	rte_timer_subsystem_init();
@@ -2500,35 +2466,56 @@ int main(int argc, char *argv[]) {
 
 	while (1) {
 
-		// rx
-		struct rte_mbuf *rx[BURST_SIZE];
-		unsigned num_recvd = rte_eth_rx_burst(gDpdkPortId, 0, rx, BURST_SIZE);
-		if (num_recvd > BURST_SIZE) {
-			rte_exit(EXIT_FAILURE, "Error receiving from eth\n");
-		} else if (num_recvd > 0) {
+#if ENABLE_ARP
+		rte_rcu_qsbr_quiescent(gQsbr, 0);
+#endif
+
+		// rx, straight into the slots of the in ring
+		struct rte_ring_zc_data zcd;
+		unsigned nb_rsvd = rte_ring_enqueue_zc_burst_start(ring->in, BURST_SIZE, &zcd, NULL);
+		if (nb_rsvd > 0) {
+
+			unsigned num_recvd;
+			if (nb_rsvd > zcd.n1 && zcd.n1 < RX_MIN_BURST) {
+				// too few slots before the wrap, go through a local array
+				struct rte_mbuf *rx[BURST_SIZE];
+				num_recvd = rte_eth_rx_burst(gDpdkPortId, 0, rx, nb_rsvd);
+
+				unsigned i = 0;
+				for (i = 0;i < num_recvd;i ++) {
+					if (i < zcd.n1) zcd.ptr1[i] = rx[i];
+					else zcd.ptr2[i - zcd.n1] = rx[i];
+				}
+			} else {
+				num_recvd = rte_eth_rx_burst(gDpdkPortId, 0, (struct rte_mbuf **)zcd.ptr1, zcd.n1);
+				if (num_recvd == zcd.n1 && nb_rsvd > zcd.n1) {
+					num_recvd += rte_eth_rx_burst(gDpdkPortId, 0, (struct rte_mbuf **)zcd.ptr2, nb_rsvd - zcd.n1);
+				}
+			}
 #if ENABLE_DDOS_DETECT
 		
 			unsigned i = 0;
 			for (i = 0;i < num_recvd;i ++) {
-				ddos_detect(rx[i]);
+				ddos_detect(i < zcd.n1 ? zcd.ptr1[i] : zcd.ptr2[i - zcd.n1]);
 			}
 #endif
-			rte_ring_sp_enqueue_burst(ring->in, (void**)rx, num_recvd, NULL);
+			rte_ring_enqueue_zc_finish(ring->in, &zcd, num_recvd);
 		}
 
 		
-		// tx
-		struct rte_mbuf *tx[BURST_SIZE];
-		unsigned nb_tx = rte_ring_sc_dequeue_burst(ring->out, (void**)tx, BURST_SIZE, NULL);
+		// tx, straight from the slots of the out ring
+		unsigned nb_tx = rte_ring_dequeue_zc_burst_start(ring->out, BURST_SIZE, &zcd, NULL);
 		if (nb_tx > 0) {
 
-			rte_eth_tx_burst(gDpdkPortId, 0, tx, nb_tx);
-
-			unsigned i = 0;
-			for (i = 0;i < nb_tx;i ++) {
-				rte_pktmbuf_free(tx[i]);
+			// the PMD owns what it sent, drop only what did not fit
+			unsigned nb_sent = rte_eth_tx_burst(gDpdkPortId, 0, (struct rte_mbuf **)zcd.ptr1, zcd.n1);
+			rte_pktmbuf_free_bulk((struct rte_mbuf **)zcd.ptr1 + nb_sent, zcd.n1 - nb_sent);
+			if (nb_tx > zcd.n1) {
+				nb_sent = rte_eth_tx_burst(gDpdkPortId, 0, (struct rte_mbuf **)zcd.ptr2, nb_tx - zcd.n1);
+				rte_pktmbuf_free_bulk((struct rte_mbuf **)zcd.ptr2 + nb_sent, nb_tx - zcd.n1 - nb_sent);
 			}
-			
+
+			rte_ring_dequeue_zc_finish(ring->out, &zcd, nb_tx);
 		}
 		
 
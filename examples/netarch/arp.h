@@ -6,80 +6,46 @@
 #define __NG_ARP_H__
 
 #include <rte_ether.h>
+#include <rte_debug.h>
+#include <rte_lcore.h>
 
+#include "ng_neigh.h"
 
-#define ARP_ENTRY_STATUS_DYNAMIC	0
-#define ARP_ENTRY_STATUS_STATIC		1
 
+#define ARP_TABLE_ENTRIES	1024
 
-#define LL_ADD(item, list) do {		\
-	item->prev = NULL;				\
-	item->next = list;				\
-	if (list != NULL) list->prev = item; \
-	list = item;					\
-} while(0)
+// ng_neigh_age() every 100ms, a full pass over the table takes 400ms
+#define ARP_AGE_INTERVAL_MS	100
+#define ARP_AGE_BUDGET		256
 
 
-#define LL_REMOVE(item, list) do {		\
-	if (item->prev != NULL) item->prev->next = item->next;	\
-	if (item->next != NULL) item->next->prev = item->prev;	\
-	if (list == item) list = item->next;	\
-	item->prev = item->next = NULL;			\
-} while(0)
+static struct ng_neigh_table *arpt = NULL;
 
+// qsv: every lcore calling ng_neigh_lookup/resolve reports quiescent states on it
+// solicit: sends the ARP requests of the cache
+static struct ng_neigh_table *arp_table_create(struct rte_rcu_qsbr *qsv,
+	ng_neigh_solicit_t solicit, void *arg) {
 
-struct arp_entry {
-
-	uint32_t ip;
-	uint8_t hwaddr[RTE_ETHER_ADDR_LEN];
-
-	uint8_t type;
-	// 
-
-	struct arp_entry *next;
-	struct arp_entry *prev;
-	
-};
-
-struct arp_table {
-
-	struct arp_entry *entries;
-	int count;
-
-};
-
-
-
-static struct  arp_table *arpt = NULL;
-
-static struct  arp_table *arp_table_instance(void) {
+	struct ng_neigh_conf conf = {
+		.max_entries = ARP_TABLE_ENTRIES,
+		.socket_id = rte_socket_id(),
+		.qsv = qsv,
+		.solicit = solicit,
+		.arg = arg,
+	};
 
+	arpt = ng_neigh_create("arp table", &conf);
 	if (arpt == NULL) {
-
-		arpt = rte_malloc("arp table", sizeof(struct  arp_table), 0);
-		if (arpt == NULL) {
-			rte_exit(EXIT_FAILURE, "rte_malloc arp table failed\n");
-		}
-		memset(arpt, 0, sizeof(struct  arp_table));
+		rte_exit(EXIT_FAILURE, "ng_neigh_create arp table failed\n");
 	}
 
 	return arpt;
-
 }
 
+static inline struct ng_neigh_table *arp_table_instance(void) {
 
-static uint8_t* ng_get_dst_macaddr(uint32_t dip) {
-
-	struct arp_entry *iter;
-	struct arp_table *table = arp_table_instance();
-
-	for (iter = table->entries;iter != NULL;iter = iter->next) {
-		if (dip == iter->ip) {
-			return iter->hwaddr;
-		}
-	}
+	return arpt;
 
-	return NULL;
 }
 
 
@@ -5,6 +5,7 @@
 #include <rte_mbuf.h>
 #include <rte_malloc.h>
 #include <rte_timer.h>
+#include <rte_rcu_qsbr.h>
 
 
 #include <stdio.h>
@@ -55,6 +56,15 @@ static uint8_t gDefaultArpMac[RTE_ETHER_ADDR_LEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xF
 
 #endif
 
+#if ENABLE_ARP
+
+// readers of the arp table: master lcore and pkt_process
+#define ARP_QSBR_THREADS	2
+
+static struct rte_rcu_qsbr *gQsbr = NULL;
+
+#endif
+
 #if ENABLE_RINGBUFFER
 
 struct inout_ring {
@@ -345,14 +355,22 @@ static struct rte_mbuf *ng_send_icmp(struct rte_mempool *mbuf_pool, uint8_t *dst
 
 #endif
 
-static void 
-print_ethaddr(const char *name, const struct rte_ether_addr *eth_addr)
-{
-	char buf[RTE_ETHER_ADDR_FMT_SIZE];
-	rte_ether_format_addr(buf, RTE_ETHER_ADDR_FMT_SIZE, eth_addr);
-	printf("%s%s", name, buf);
+#if ENABLE_ARP
+
+// ng_neigh solicit callback, runs on pkt_process
+static void
+arp_solicit(void *arg, uint32_t ip, const struct rte_ether_addr *mac) {
+
+	struct rte_mempool *mbuf_pool = (struct rte_mempool *)arg;
+	struct inout_ring *ring = ringInstance();
+
+	struct rte_mbuf *arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, 
+		mac != NULL ? (uint8_t *)(uintptr_t)mac->addr_bytes : gDefaultArpMac, gLocalIp, ip);
+
+	rte_ring_mp_enqueue_burst(ring->out, (void**)&arpbuf, 1, NULL);
 }
 
+#endif
 
 #if ENABLE_TIMER
 
@@ -382,14 +400,14 @@ arp_request_timer_cb(__attribute__((unused)) struct rte_timer *tim,
 		printf("arp ---> src: %s \n", inet_ntoa(addr));
 
 		struct rte_mbuf *arpbuf = NULL;
-		uint8_t *dstmac = ng_get_dst_macaddr(dstip);
-		if (dstmac == NULL) {
+		struct rte_ether_addr dstmac;
+		if (ng_neigh_lookup(arp_table_instance(), dstip, &dstmac) < NG_NEIGH_REACHABLE) {
 
 			arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, gDefaultArpMac, gLocalIp, dstip);
 		
 		} else {
 
-			arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, dstmac, gLocalIp, dstip);
+			arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, dstmac.addr_bytes, gLocalIp, dstip);
 		}
 
 		//rte_eth_tx_burst(gDpdkPortId, 0, &arpbuf, 1);
@@ -410,8 +428,26 @@ static int pkt_process(void *arg) {
 	struct rte_mempool *mbuf_pool = (struct rte_mempool *)arg;
 	struct inout_ring *ring = ringInstance();
 
+#if ENABLE_ARP
+	struct ng_neigh_table *table = arp_table_instance();
+	uint64_t age_cycles = rte_get_timer_hz() * ARP_AGE_INTERVAL_MS / 1000;
+	uint64_t age_tsc = rte_get_timer_cycles();
+
+	rte_rcu_qsbr_thread_register(gQsbr, 1);
+	rte_rcu_qsbr_thread_online(gQsbr, 1);
+#endif
+
 	while (1) {
 
+#if ENABLE_ARP
+		rte_rcu_qsbr_quiescent(gQsbr, 1);
+
+		if (rte_get_timer_cycles() - age_tsc > age_cycles) {
+			ng_neigh_age(table, ARP_AGE_BUDGET);
+			age_tsc = rte_get_timer_cycles();
+		}
+#endif
+
 		// 从rx ring中取出数据包
 		struct rte_mbuf *mbufs[BURST_SIZE];
 		unsigned num_recvd = rte_ring_mc_dequeue_burst(ring->in, (void**)mbufs, BURST_SIZE, NULL);
@@ -442,6 +478,14 @@ static int pkt_process(void *arg) {
 
 						printf("arp --> request\n");
 
+						// the requester is our neighbor too
+						struct rte_mbuf *pending[NG_NEIGH_MAX_PENDING];
+						int nb_pending = ng_neigh_update(table, ahdr->arp_data.arp_sip, 
+							&ahdr->arp_data.arp_sha, NG_NEIGH_F_CREATE, pending);
+						if (nb_pending > 0) {
+							rte_ring_mp_enqueue_burst(ring->out, (void**)pending, nb_pending, NULL);
+						}
+
 						struct rte_mbuf *arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REPLY, ahdr->arp_data.arp_sha.addr_bytes, 
 							ahdr->arp_data.arp_tip, ahdr->arp_data.arp_sip);
 
@@ -455,36 +499,15 @@ static int pkt_process(void *arg) {
 
 						printf("arp --> reply\n");
 
-						struct arp_table *table = arp_table_instance();
-
-						uint8_t *hwaddr = ng_get_dst_macaddr(ahdr->arp_data.arp_sip);
-						if (hwaddr == NULL) {
-
-							struct arp_entry *entry = rte_malloc("arp_entry",sizeof(struct arp_entry), 0);
-							if (entry) {
-								memset(entry, 0, sizeof(struct arp_entry));
-
-								entry->ip = ahdr->arp_data.arp_sip;
-								rte_memcpy(entry->hwaddr, ahdr->arp_data.arp_sha.addr_bytes, RTE_ETHER_ADDR_LEN);
-								entry->type = 0;
-								
-								LL_ADD(entry, table->entries);
-								table->count ++;
-							}
-
+						// send what waited for the reply
+						struct rte_mbuf *pending[NG_NEIGH_MAX_PENDING];
+						int nb_pending = ng_neigh_update(table, ahdr->arp_data.arp_sip, 
+							&ahdr->arp_data.arp_sha, NG_NEIGH_F_CREATE | NG_NEIGH_F_CONFIRMED, pending);
+						if (nb_pending > 0) {
+							rte_ring_mp_enqueue_burst(ring->out, (void**)pending, nb_pending, NULL);
 						}
 #if ENABLE_DEBUG
-						struct arp_entry *iter;
-						for (iter = table->entries; iter != NULL; iter = iter->next) {
-					
-							struct in_addr addr;
-							addr.s_addr = iter->ip;
-
-							print_ethaddr("arp table --> mac: ", (struct rte_ether_addr *)iter->hwaddr);
-								
-							printf(" ip: %s \n", inet_ntoa(addr));
-					
-						}
+						ng_neigh_dump(stdout, table);
 #endif
 						rte_pktmbuf_free(mbufs[i]);
 					}
@@ -603,6 +626,22 @@ int main(int argc, char *argv[]) {
 
 	rte_eth_macaddr_get(gDpdkPortId, (struct rte_ether_addr *)gSrcMac);
 
+#if ENABLE_ARP
+
+	size_t qsbr_size = rte_rcu_qsbr_get_memsize(ARP_QSBR_THREADS);
+	gQsbr = rte_zmalloc("arp qsbr", qsbr_size, RTE_CACHE_LINE_SIZE);
+	if (gQsbr == NULL || rte_rcu_qsbr_init(gQsbr, ARP_QSBR_THREADS) != 0) {
+		rte_exit(EXIT_FAILURE, "arp qsbr init failed\n");
+	}
+
+	arp_table_create(gQsbr, arp_solicit, mbuf_pool);
+
+	// the master lcore runs arp_request_timer_cb
+	rte_rcu_qsbr_thread_register(gQsbr, 0);
+	rte_rcu_qsbr_thread_online(gQsbr, 0);
+
+#endif
+
 #if ENABLE_TIMER
 
 	rte_timer_subsystem_init();
@@ -644,6 +683,10 @@ int main(int argc, char *argv[]) {
 
 	while (1) {
 
+#if ENABLE_ARP
+		rte_rcu_qsbr_quiescent(gQsbr, 0);
+#endif
+
 		// rx --> ring buffer
 		// ring buffer -->  tx
 
@@ -0,0 +1,558 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_errno.h>
+#include <rte_hash.h>
+#include <rte_hash_crc.h>
+#include <rte_malloc.h>
+#include <rte_spinlock.h>
+
+#include "ng_neigh.h"
+
+#define NG_NEIGH_DEF_PENDING		4
+#define NG_NEIGH_DEF_REACHABLE_MS	30000
+#define NG_NEIGH_DEF_GC_MS		60000
+#define NG_NEIGH_DEF_RETRANS_MS		1000
+#define NG_NEIGH_DEF_PROBES		3
+
+/* Smallest table rte_hash_create() accepts. */
+#define NG_NEIGH_MIN_ENTRIES		8
+
+/* Address and state of an entry, loaded and stored as a whole. */
+union ng_neigh_addr {
+	uint64_t u64;
+	RTE_STD_C11
+	struct {
+		struct rte_ether_addr mac;
+		uint8_t pad;
+		uint8_t state;	/* enum ng_neigh_state */
+	};
+};
+
+struct ng_neigh_entry {
+	union ng_neigh_addr addr;	/* shared with the readers */
+	uint32_t used;		/* used while STALE, set by the readers */
+	uint32_t ip;
+	uint16_t probes;	/* requests sent since the last confirmation */
+	uint16_t nb_pending;
+	uint64_t updated;	/* TSC of the last state change */
+	uint64_t next;		/* TSC of the next request */
+};
+
+struct ng_neigh_table {
+	struct rte_hash *h;
+	struct rte_rcu_qsbr_dq *dq;
+	struct ng_neigh_entry *entries;	/* indexed by key position */
+	struct rte_mbuf **pending;	/* max_pending per entry */
+	rte_spinlock_t lock;		/* serializes the updates */
+	uint32_t max_entries;
+	uint32_t max_pending;
+	uint32_t max_probes;
+	uint32_t count;
+	uint32_t cursor;		/* next entry ng_neigh_age() looks at */
+	uint64_t reachable;		/* in TSC cycles */
+	uint64_t gc;
+	uint64_t retrans;
+	ng_neigh_solicit_t solicit;
+	void *arg;
+	struct rte_rcu_qsbr *qsv;
+};
+
+static inline int
+ng_neigh_usable(uint8_t state)
+{
+	return state >= NG_NEIGH_REACHABLE;
+}
+
+/* Readers note the use of STALE entries, which triggers their probing. */
+static inline void
+ng_neigh_touch(struct ng_neigh_entry *e, uint8_t state)
+{
+	if (state == NG_NEIGH_STALE &&
+			__atomic_load_n(&e->used, __ATOMIC_RELAXED) == 0)
+		__atomic_store_n(&e->used, 1, __ATOMIC_RELAXED);
+}
+
+/* Defer queue callback: the readers are done with a removed entry. */
+static void
+ng_neigh_free_position(void *p, void *data, unsigned int n)
+{
+	struct ng_neigh_table *t = p;
+	uint32_t pos = *(uint32_t *)data;
+
+	RTE_SET_USED(n);
+	rte_hash_free_key_with_position(t->h, pos);
+}
+
+struct ng_neigh_table *
+ng_neigh_create(const char *name, const struct ng_neigh_conf *conf)
+{
+	struct rte_rcu_qsbr_dq_parameters dq_params;
+	struct rte_hash_parameters hash_params;
+	struct ng_neigh_table *t;
+	uint64_t ms = rte_get_timer_hz() / 1000;
+
+	if (name == NULL || conf == NULL || conf->qsv == NULL ||
+			conf->solicit == NULL ||
+			conf->max_entries < NG_NEIGH_MIN_ENTRIES ||
+			conf->max_pending > NG_NEIGH_MAX_PENDING) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	t = rte_zmalloc_socket("ng_neigh", sizeof(*t), RTE_CACHE_LINE_SIZE,
+			conf->socket_id);
+	if (t == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	t->max_entries = conf->max_entries;
+	t->max_pending = conf->max_pending ? conf->max_pending :
+		NG_NEIGH_DEF_PENDING;
+	t->max_probes = conf->max_probes ? conf->max_probes :
+		NG_NEIGH_DEF_PROBES;
+	t->reachable = ms * (conf->reachable_ms ? conf->reachable_ms :
+		NG_NEIGH_DEF_REACHABLE_MS);
+	t->gc = ms * (conf->gc_ms ? conf->gc_ms : NG_NEIGH_DEF_GC_MS);
+	t->retrans = ms * (conf->retrans_ms ? conf->retrans_ms :
+		NG_NEIGH_DEF_RETRANS_MS);
+	t->solicit = conf->solicit;
+	t->arg = conf->arg;
+	t->qsv = conf->qsv;
+	rte_spinlock_init(&t->lock);
+
+	t->entries = rte_zmalloc_socket("ng_neigh_entries",
+			sizeof(*t->entries) * t->max_entries,
+			RTE_CACHE_LINE_SIZE, conf->socket_id);
+	t->pending = rte_zmalloc_socket("ng_neigh_pending",
+			sizeof(*t->pending) * t->max_entries * t->max_pending,
+			RTE_CACHE_LINE_SIZE, conf->socket_id);
+	if (t->entries == NULL || t->pending == NULL) {
+		rte_errno = ENOMEM;
+		goto fail;
+	}
+
+	/*
+	 * Lock-free readers: a deleted key keeps its position, and its entry,
+	 * until ng_neigh_free_position() runs.
+	 */
+	memset(&hash_params, 0, sizeof(hash_params));
+	hash_params.name = name;
+	hash_params.entries = t->max_entries;
+	hash_params.key_len = sizeof(uint32_t);
+	hash_params.hash_func = rte_hash_crc;
+	hash_params.socket_id = conf->socket_id;
+	hash_params.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF;
+	t->h = rte_hash_create(&hash_params);
+	if (t->h == NULL)
+		goto fail;
+
+	memset(&dq_params, 0, sizeof(dq_params));
+	dq_params.name = name;
+	dq_params.flags = RTE_RCU_QSBR_DQ_MT_UNSAFE;	/* under t->lock */
+	dq_params.size = t->max_entries;
+	dq_params.esize = sizeof(uint32_t);
+	dq_params.trigger_reclaim_limit = RTE_MAX(t->max_entries >> 3, 1U);
+	dq_params.max_reclaim_size = dq_params.trigger_reclaim_limit;
+	dq_params.free_fn = ng_neigh_free_position;
+	dq_params.p = t;
+	dq_params.v = t->qsv;
+	t->dq = rte_rcu_qsbr_dq_create(&dq_params);
+	if (t->dq == NULL)
+		goto fail;
+
+	return t;
+
+fail:
+	rte_hash_free(t->h);
+	rte_free(t->pending);
+	rte_free(t->entries);
+	rte_free(t);
+	return NULL;
+}
+
+static void
+ng_neigh_drop_pending(struct ng_neigh_table *t, uint32_t pos)
+{
+	struct ng_neigh_entry *e = &t->entries[pos];
+	struct rte_mbuf **pending = &t->pending[pos * t->max_pending];
+	unsigned int i;
+
+	for (i = 0; i < e->nb_pending; i++)
+		rte_pktmbuf_free(pending[i]);
+	e->nb_pending = 0;
+}
+
+/*
+ * Remove an entry, with the lock held. Readers finding the key before the
+ * deletion see the entry without state; its position is reused once they
+ * all went through a quiescent state.
+ */
+static void
+ng_neigh_remove(struct ng_neigh_table *t, uint32_t pos)
+{
+	struct ng_neigh_entry *e = &t->entries[pos];
+
+	__atomic_store_n(&e->addr.u64, 0, __ATOMIC_RELEASE);
+	ng_neigh_drop_pending(t, pos);
+	rte_hash_del_key(t->h, &e->ip);
+	t->count--;
+
+	/* cannot fail, the queue has room for all the positions */
+	rte_rcu_qsbr_dq_enqueue(t->dq, &pos);
+}
+
+void
+ng_neigh_free(struct ng_neigh_table *t)
+{
+	uint32_t pos;
+
+	if (t == NULL)
+		return;
+
+	for (pos = 0; pos < t->max_entries; pos++)
+		ng_neigh_drop_pending(t, pos);
+
+	rte_rcu_qsbr_synchronize(t->qsv, RTE_QSBR_THRID_INVALID);
+	rte_rcu_qsbr_dq_delete(t->dq);
+	rte_hash_free(t->h);
+	rte_free(t->pending);
+	rte_free(t->entries);
+	rte_free(t);
+}
+
+enum ng_neigh_state
+ng_neigh_lookup(struct ng_neigh_table *t, uint32_t ip,
+	struct rte_ether_addr *mac)
+{
+	struct ng_neigh_entry *e;
+	union ng_neigh_addr addr;
+	int32_t pos;
+
+	pos = rte_hash_lookup(t->h, &ip);
+	if (pos < 0)
+		return NG_NEIGH_NONE;
+
+	e = &t->entries[pos];
+	addr.u64 = __atomic_load_n(&e->addr.u64, __ATOMIC_ACQUIRE);
+	if (ng_neigh_usable(addr.state)) {
+		*mac = addr.mac;
+		ng_neigh_touch(e, addr.state);
+	}
+
+	return addr.state;
+}
+
+uint64_t
+ng_neigh_lookup_bulk(struct ng_neigh_table *t, const uint32_t *ips,
+	unsigned int n, struct rte_ether_addr *macs)
+{
+	const void *keys[NG_NEIGH_LOOKUP_BULK_MAX];
+	int32_t positions[NG_NEIGH_LOOKUP_BULK_MAX];
+	union ng_neigh_addr addr;
+	uint64_t hits = 0;
+	unsigned int i;
+
+	if (n == 0 || n > NG_NEIGH_LOOKUP_BULK_MAX)
+		return 0;
+
+	for (i = 0; i < n; i++)
+		keys[i] = &ips[i];
+
+	if (rte_hash_lookup_bulk(t->h, keys, n, positions) < 0)
+		return 0;
+
+	for (i = 0; i < n; i++) {
+		struct ng_neigh_entry *e;
+
+		if (positions[i] < 0)
+			continue;
+
+		e = &t->entries[positions[i]];
+		addr.u64 = __atomic_load_n(&e->addr.u64, __ATOMIC_ACQUIRE);
+		if (!ng_neigh_usable(addr.state))
+			continue;
+
+		macs[i] = addr.mac;
+		ng_neigh_touch(e, addr.state);
+		hits |= 1ULL << i;
+	}
+
+	return hits;
+}
+
+/* Find or add the entry of ip, with the lock held. */
+static int32_t
+ng_neigh_get(struct ng_neigh_table *t, uint32_t ip, int create)
+{
+	struct ng_neigh_entry *e;
+	int32_t pos;
+
+	pos = rte_hash_lookup(t->h, &ip);
+	if (pos >= 0 || !create)
+		return pos;
+
+	pos = rte_hash_add_key(t->h, &ip);
+	if (pos < 0)
+		return -ENOSPC;
+
+	e = &t->entries[pos];
+	e->used = 0;
+	e->ip = ip;
+	e->probes = 0;
+	e->nb_pending = 0;
+	e->updated = e->next = rte_get_timer_cycles();
+	t->count++;
+
+	return pos;
+}
+
+int
+ng_neigh_resolve(struct ng_neigh_table *t, uint32_t ip, struct rte_mbuf *m)
+{
+	struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+	struct rte_mbuf **pending;
+	struct ng_neigh_entry *e;
+	union ng_neigh_addr addr;
+	int32_t pos;
+
+	if (ng_neigh_usable(ng_neigh_lookup(t, ip, &eth->d_addr)))
+		return 0;
+
+	rte_spinlock_lock(&t->lock);
+
+	pos = ng_neigh_get(t, ip, 1);
+	if (pos < 0) {
+		rte_spinlock_unlock(&t->lock);
+		return pos;
+	}
+
+	e = &t->entries[pos];
+	addr = e->addr;
+
+	/* resolved since the lookup */
+	if (ng_neigh_usable(addr.state)) {
+		rte_spinlock_unlock(&t->lock);
+		eth->d_addr = addr.mac;
+		return 0;
+	}
+
+	if (addr.state == NG_NEIGH_NONE) {
+		addr.u64 = 0;
+		addr.state = NG_NEIGH_INCOMPLETE;
+		__atomic_store_n(&e->addr.u64, addr.u64, __ATOMIC_RELEASE);
+
+		t->solicit(t->arg, ip, NULL);
+		e->probes = 1;
+		e->next = rte_get_timer_cycles() + t->retrans;
+	}
+
+	pending = &t->pending[pos * t->max_pending];
+	if (e->nb_pending == t->max_pending) {
+		rte_pktmbuf_free(pending[0]);
+		memmove(pending, pending + 1,
+			sizeof(*pending) * (t->max_pending - 1));
+		e->nb_pending--;
+	}
+	pending[e->nb_pending++] = m;
+
+	rte_spinlock_unlock(&t->lock);
+
+	return 1;
+}
+
+int
+ng_neigh_update(struct ng_neigh_table *t, uint32_t ip,
+	const struct rte_ether_addr *mac, unsigned int flags,
+	struct rte_mbuf **pkts)
+{
+	struct rte_mbuf **pending;
+	struct ng_neigh_entry *e;
+	union ng_neigh_addr addr;
+	uint8_t state;
+	int32_t pos;
+	int same, n;
+
+	rte_spinlock_lock(&t->lock);
+
+	pos = ng_neigh_get(t, ip, flags & NG_NEIGH_F_CREATE);
+	if (pos < 0) {
+		rte_spinlock_unlock(&t->lock);
+		return pos == -ENOSPC ? -ENOSPC : -ENOENT;
+	}
+
+	e = &t->entries[pos];
+	addr = e->addr;
+	same = ng_neigh_usable(addr.state) &&
+		rte_is_same_ether_addr(&addr.mac, mac);
+
+	if (flags & NG_NEIGH_F_PERMANENT)
+		state = NG_NEIGH_PERMANENT;
+	else if (addr.state == NG_NEIGH_PERMANENT)
+		state = NG_NEIGH_NONE;	/* left alone */
+	else if (flags & NG_NEIGH_F_CONFIRMED)
+		state = NG_NEIGH_REACHABLE;
+	else if (!same)
+		state = NG_NEIGH_STALE;
+	else
+		state = NG_NEIGH_NONE;	/* nothing new */
+
+	if (state != NG_NEIGH_NONE) {
+		addr.mac = *mac;
+		addr.state = state;
+		__atomic_store_n(&e->addr.u64, addr.u64, __ATOMIC_RELEASE);
+
+		e->used = 0;
+		e->probes = 0;
+		e->updated = e->next = rte_get_timer_cycles();
+	}
+
+	/* the entry is usable now: release what waited for it */
+	pending = &t->pending[pos * t->max_pending];
+	for (n = 0; n < e->nb_pending; n++) {
+		struct rte_ether_hdr *eth = rte_pktmbuf_mtod(pending[n],
+				struct rte_ether_hdr *);
+
+		eth->d_addr = addr.mac;
+		pkts[n] = pending[n];
+	}
+	e->nb_pending = 0;
+
+	rte_spinlock_unlock(&t->lock);
+
+	return n;
+}
+
+int
+ng_neigh_delete(struct ng_neigh_table *t, uint32_t ip)
+{
+	int32_t pos;
+
+	rte_spinlock_lock(&t->lock);
+
+	pos = ng_neigh_get(t, ip, 0);
+	if (pos >= 0)
+		ng_neigh_remove(t, pos);
+
+	rte_spinlock_unlock(&t->lock);
+
+	return pos >= 0 ? 0 : -ENOENT;
+}
+
+unsigned int
+ng_neigh_age(struct ng_neigh_table *t, unsigned int budget)
+{
+	uint64_t now = rte_get_timer_cycles();
+	unsigned int removed = 0;
+	union ng_neigh_addr addr;
+
+	rte_spinlock_lock(&t->lock);
+
+	budget = RTE_MIN(budget, t->max_entries);
+	while (budget-- != 0 && t->count != 0) {
+		uint32_t pos = t->cursor;
+		struct ng_neigh_entry *e = &t->entries[pos];
+
+		if (++t->cursor == t->max_entries)
+			t->cursor = 0;
+
+		addr = e->addr;
+		switch (addr.state) {
+		case NG_NEIGH_INCOMPLETE:
+			if (now < e->next)
+				break;
+			if (e->probes >= t->max_probes) {
+				ng_neigh_remove(t, pos);
+				removed++;
+				break;
+			}
+			t->solicit(t->arg, e->ip, NULL);
+			e->probes++;
+			e->next = now + t->retrans;
+			break;
+
+		case NG_NEIGH_REACHABLE:
+			if (now - e->updated < t->reachable)
+				break;
+			addr.state = NG_NEIGH_STALE;
+			__atomic_store_n(&e->addr.u64, addr.u64,
+				__ATOMIC_RELEASE);
+			e->used = 0;
+			e->updated = e->next = now;
+			break;
+
+		case NG_NEIGH_STALE:
+			if (!__atomic_load_n(&e->used, __ATOMIC_RELAXED)) {
+				if (now - e->updated >= t->gc) {
+					ng_neigh_remove(t, pos);
+					removed++;
+				}
+				break;
+			}
+			/* in use: confirm the address or give it up */
+			if (now < e->next)
+				break;
+			if (e->probes >= t->max_probes) {
+				ng_neigh_remove(t, pos);
+				removed++;
+				break;
+			}
+			t->solicit(t->arg, e->ip, &addr.mac);
+			e->probes++;
+			e->next = now + t->retrans;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	rte_rcu_qsbr_dq_reclaim(t->dq, t->max_entries, NULL, NULL, NULL);
+
+	rte_spinlock_unlock(&t->lock);
+
+	return removed;
+}
+
+void
+ng_neigh_dump(FILE *f, struct ng_neigh_table *t)
+{
+	static const char * const states[] = {
+		[NG_NEIGH_NONE] = "none",
+		[NG_NEIGH_INCOMPLETE] = "incomplete",
+		[NG_NEIGH_REACHABLE] = "reachable",
+		[NG_NEIGH_STALE] = "stale",
+		[NG_NEIGH_PERMANENT] = "permanent",
+	};
+	char buf[RTE_ETHER_ADDR_FMT_SIZE];
+	union ng_neigh_addr addr;
+	struct in_addr in;
+	uint32_t pos;
+
+	rte_spinlock_lock(&t->lock);
+
+	fprintf(f, "neighbors: %u/%u\n", t->count, t->max_entries);
+	for (pos = 0; pos < t->max_entries; pos++) {
+		struct ng_neigh_entry *e = &t->entries[pos];
+
+		addr = e->addr;
+		if (addr.state == NG_NEIGH_NONE)
+			continue;
+
+		in.s_addr = e->ip;
+		rte_ether_format_addr(buf, sizeof(buf), &addr.mac);
+		fprintf(f, "  %-15s %s %s pending %u\n", inet_ntoa(in),
+			ng_neigh_usable(addr.state) ? buf : "-",
+			states[addr.state], e->nb_pending);
+	}
+
+	rte_spinlock_unlock(&t->lock);
+}
@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#ifndef __NG_NEIGH_H__
+#define __NG_NEIGH_H__
+
+/**
+ * @file
+ *
+ * IPv4 neighbor cache, the ARP table of the examples.
+ *
+ * Entries live in an rte_hash keyed by the neighbor address, created
+ * with RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF, and in an array indexed
+ * by the position of the key. The MAC address and the state of an entry
+ * share one 64-bit word, so the transmit path resolves a next hop with one
+ * hash lookup and one atomic load, without locks and from any lcore:
+ *
+ *  - ng_neigh_lookup() and ng_neigh_lookup_bulk() return the MAC address
+ *    of one next hop or of a burst of them;
+ *  - ng_neigh_resolve() writes the MAC address of the next hop of a packet,
+ *    or keeps the packet on the entry while the address is resolved.
+ *
+ * An entry is INCOMPLETE while its address is being resolved, REACHABLE
+ * for reachable_ms after a confirmation, such as an ARP reply, then STALE.
+ * STALE entries are still used: when used, they are confirmed again with
+ * unicast requests and removed if none is answered, as are INCOMPLETE
+ * entries after max_probes broadcast requests. Unused STALE entries are
+ * removed after gc_ms. PERMANENT entries never change. Requests are sent
+ * by the solicit function given at creation and the state machine is run
+ * by ng_neigh_age(), which must be called regularly.
+ *
+ * Updates are serialized by a lock and should be done from one lcore.
+ * Lookups are RCU protected: all threads looking entries up must report
+ * quiescent states on the QSBR variable given at creation, and the
+ * position of a removed entry is reused only once they all did.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <rte_ether.h>
+#include <rte_mbuf.h>
+#include <rte_rcu_qsbr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of next hops resolved by ng_neigh_lookup_bulk(). */
+#define NG_NEIGH_LOOKUP_BULK_MAX	64
+
+/** Maximum number of packets kept per INCOMPLETE entry. */
+#define NG_NEIGH_MAX_PENDING		16
+
+/** Entry states. */
+enum ng_neigh_state {
+	NG_NEIGH_NONE = 0,	/**< no entry */
+	NG_NEIGH_INCOMPLETE,	/**< address being resolved */
+	NG_NEIGH_REACHABLE,	/**< address recently confirmed */
+	NG_NEIGH_STALE,		/**< address usable, to be confirmed */
+	NG_NEIGH_PERMANENT,	/**< static address */
+};
+
+/** ng_neigh_update() flags. */
+#define NG_NEIGH_F_CREATE	0x1	/**< create the entry if missing */
+#define NG_NEIGH_F_CONFIRMED	0x2	/**< the neighbor is reachable */
+#define NG_NEIGH_F_PERMANENT	0x4	/**< static entry */
+
+/**
+ * Send an ARP request for ip: broadcast if mac is NULL, unicast to mac
+ * otherwise. Called with the update lock held.
+ */
+typedef void (*ng_neigh_solicit_t)(void *arg, uint32_t ip,
+		const struct rte_ether_addr *mac);
+
+/** Cache parameters, zero fields take the default value. */
+struct ng_neigh_conf {
+	uint32_t max_entries;	/**< number of entries */
+	uint32_t max_pending;	/**< packets kept per entry, default 4 */
+	uint32_t reachable_ms;	/**< REACHABLE lifetime, default 30 s */
+	uint32_t gc_ms;		/**< unused STALE lifetime, default 60 s */
+	uint32_t retrans_ms;	/**< interval between requests, default 1 s */
+	uint32_t max_probes;	/**< requests before giving up, default 3 */
+	int socket_id;
+	struct rte_rcu_qsbr *qsv; /**< QSBR variable of the readers */
+	ng_neigh_solicit_t solicit;
+	void *arg;		/**< argument of solicit */
+};
+
+struct ng_neigh_table;
+
+/**
+ * Create a cache.
+ *
+ * @return
+ *   The cache, or NULL with rte_errno set.
+ */
+struct ng_neigh_table *ng_neigh_create(const char *name,
+		const struct ng_neigh_conf *conf);
+
+/**
+ * Release a cache and the packets it keeps. The calling thread must not
+ * be online on the QSBR variable.
+ */
+void ng_neigh_free(struct ng_neigh_table *t);
+
+/**
+ * Look a neighbor up.
+ *
+ * @param mac
+ *   Set to the address of the neighbor if it is usable.
+ * @return
+ *   The state of the entry, NG_NEIGH_NONE if there is none. The address
+ *   is usable in states REACHABLE, STALE and PERMANENT.
+ */
+enum ng_neigh_state ng_neigh_lookup(struct ng_neigh_table *t, uint32_t ip,
+		struct rte_ether_addr *mac);
+
+/**
+ * Look up to NG_NEIGH_LOOKUP_BULK_MAX neighbors with one hash lookup.
+ *
+ * @return
+ *   Bit mask of the neighbors with a usable address, stored in macs.
+ */
+uint64_t ng_neigh_lookup_bulk(struct ng_neigh_table *t, const uint32_t *ips,
+		unsigned int n, struct rte_ether_addr *macs);
+
+/**
+ * Set the destination address of an Ethernet frame sent to next hop ip.
+ * If the address is unknown, create an INCOMPLETE entry, send a request
+ * and keep the frame on the entry until the address is resolved by
+ * ng_neigh_update() or resolution fails. When the entry already keeps
+ * max_pending frames, the oldest one is freed.
+ *
+ * @return
+ *   0 if the address was written, 1 if the frame was kept, -ENOSPC if the
+ *   cache is full, in which case the frame is left to the caller.
+ */
+int ng_neigh_resolve(struct ng_neigh_table *t, uint32_t ip,
+		struct rte_mbuf *m);
+
+/**
+ * Learn the address of a neighbor, from an ARP message or any received
+ * frame.
+ *
+ * @param flags
+ *   NG_NEIGH_F_* flags. Without NG_NEIGH_F_CONFIRMED a new or changed
+ *   address makes the entry STALE, and a REACHABLE entry with the same
+ *   address is left alone.
+ * @param pkts
+ *   Set to the frames kept while the entry was INCOMPLETE, with their
+ *   destination address written, to be sent by the caller. Must have room
+ *   for max_pending frames.
+ * @return
+ *   Number of frames stored in pkts, -ENOSPC if the cache is full, or
+ *   -ENOENT if there is no entry and NG_NEIGH_F_CREATE is not set.
+ */
+int ng_neigh_update(struct ng_neigh_table *t, uint32_t ip,
+		const struct rte_ether_addr *mac, unsigned int flags,
+		struct rte_mbuf **pkts);
+
+/**
+ * Remove the entry of a neighbor, freeing the frames it keeps.
+ *
+ * @return
+ *   0 on success, -ENOENT if there is none.
+ */
+int ng_neigh_delete(struct ng_neigh_table *t, uint32_t ip);
+
+/**
+ * Run the state machine on up to budget entries, continuing where the
+ * previous call stopped, and reuse the positions of the removed entries
+ * readers are done with. A full pass over the cache should take less than
+ * retrans_ms.
+ *
+ * @return
+ *   Number of entries removed.
+ */
+unsigned int ng_neigh_age(struct ng_neigh_table *t, unsigned int budget);
+
+/** Print the entries of a cache. */
+void ng_neigh_dump(FILE *f, struct ng_neigh_table *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
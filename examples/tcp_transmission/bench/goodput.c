@@ -0,0 +1,419 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+/*
+ * Goodput of the ng_tcp stack over a lossy link.
+ *
+ * The link is a ring PMD port looped back on itself: the frames the stack
+ * transmits are received again by the same, single-shard, stack, which
+ * runs both ends of the connection. An RX callback emulates the wire: it
+ * drops frames at random at the requested rate and gathers each remaining
+ * frame in one segment, as a NIC would deliver it.
+ *
+ * For every loss rate, one connection transfers the requested amount of
+ * data, and the goodput is the payload delivered to the receiving
+ * application per second. Both ends share one lcore, so the figures are
+ * the ones of a loopback, not of a real link.
+ *
+ * Usage: goodput [EAL options] -- [-c newreno|cubic] [-S] [-n MB]
+ *        [-r RTO_MIN_MS] [-L LOSS_PERCENT[,LOSS_PERCENT...]]
+ *
+ * e.g.: ./build/goodput -l 0 --no-huge -m 512 --no-pci -- -L 0,0.1,1,5
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_eth_ring.h>
+#include <rte_ethdev.h>
+#include <rte_ip.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_random.h>
+#include <rte_ring.h>
+#include <rte_timer.h>
+
+#include "ng_tcp.h"
+
+#define GOODPUT_SHARD		0
+#define GOODPUT_PORT		5001
+#define GOODPUT_BURST		32
+#define GOODPUT_NB_MBUFS	8191
+#define GOODPUT_LINK_SIZE	1024
+#define GOODPUT_RING_SIZE	256
+#define GOODPUT_CHUNK		(64 * 1024)
+#define GOODPUT_MAX_LOSSES	16
+/* a transfer making no progress for that long is given up */
+#define GOODPUT_STALL_S		30
+
+struct goodput_link {
+	uint64_t loss;		/* drop threshold out of UINT64_MAX */
+	uint64_t frames;
+	uint64_t dropped;
+};
+
+struct goodput_result {
+	uint64_t bytes;
+	uint64_t cycles;
+	struct goodput_link link;
+	struct ng_tcp_stats stats;
+};
+
+static struct rte_mempool *goodput_pool;
+static uint16_t goodput_port;
+static uint32_t goodput_ip;
+static struct goodput_link goodput_link;
+
+static uint8_t tx_buf[GOODPUT_CHUNK];
+static uint8_t rx_buf[GOODPUT_CHUNK];
+
+/* options */
+static enum ng_tcp_cc goodput_cc = NG_TCP_CC_CUBIC;
+static uint8_t goodput_no_sack;
+static uint64_t goodput_bytes = 64ULL << 20;
+static uint32_t goodput_rto_min_ms;
+static double goodput_losses[GOODPUT_MAX_LOSSES] = { 0, 0.1, 1, 5 };
+static unsigned int goodput_nb_losses = 4;
+
+/* Drop frames at random and linearize the others, see the top comment. */
+static uint16_t
+goodput_wire(uint16_t port __rte_unused, uint16_t queue __rte_unused,
+	struct rte_mbuf **pkts, uint16_t nb_pkts,
+	uint16_t max_pkts __rte_unused, void *arg)
+{
+	struct goodput_link *link = arg;
+	uint16_t i, nb = 0;
+
+	for (i = 0; i < nb_pkts; i++) {
+		struct rte_mbuf *m = pkts[i], *copy;
+		uint32_t len = rte_pktmbuf_pkt_len(m);
+		const void *p;
+		char *data;
+
+		link->frames++;
+		if (link->loss != 0 && rte_rand() < link->loss) {
+			link->dropped++;
+			rte_pktmbuf_free(m);
+			continue;
+		}
+
+		if (m->nb_segs > 1) {
+			copy = rte_pktmbuf_alloc(goodput_pool);
+			if (copy == NULL) {
+				link->dropped++;
+				rte_pktmbuf_free(m);
+				continue;
+			}
+			data = rte_pktmbuf_append(copy, len);
+			p = rte_pktmbuf_read(m, 0, len, data);
+			if (p != data)
+				memcpy(data, p, len);
+			rte_pktmbuf_free(m);
+			m = copy;
+		}
+		pkts[nb++] = m;
+	}
+
+	return nb;
+}
+
+static int
+goodput_port_init(void)
+{
+	static const struct rte_eth_conf port_conf;
+	struct rte_ring *ring;
+	int port;
+
+	ring = rte_ring_create("goodput_link", GOODPUT_LINK_SIZE,
+			rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
+	if (ring == NULL)
+		return -rte_errno;
+
+	port = rte_eth_from_ring(ring);
+	if (port < 0)
+		return -ENODEV;
+	goodput_port = port;
+
+	if (rte_eth_dev_configure(goodput_port, 1, 1, &port_conf) < 0 ||
+			rte_eth_rx_queue_setup(goodput_port, 0,
+				GOODPUT_LINK_SIZE, rte_socket_id(), NULL,
+				goodput_pool) < 0 ||
+			rte_eth_tx_queue_setup(goodput_port, 0,
+				GOODPUT_LINK_SIZE, rte_socket_id(), NULL) < 0)
+		return -EINVAL;
+
+	if (rte_eth_add_rx_callback(goodput_port, 0, goodput_wire,
+			&goodput_link) == NULL)
+		return -rte_errno;
+
+	return rte_eth_dev_start(goodput_port);
+}
+
+/* Move frames between the stack and the link, run the timers. */
+static void
+goodput_poll(uint64_t *next_timer)
+{
+	struct rte_mbuf *pkts[GOODPUT_BURST];
+	uint16_t n, sent;
+	uint64_t now;
+
+	n = rte_eth_rx_burst(goodput_port, 0, pkts, GOODPUT_BURST);
+	if (n != 0)
+		ng_tcp_input_burst(GOODPUT_SHARD, pkts, n);
+
+	n = ng_tcp_output_burst(GOODPUT_SHARD, pkts, GOODPUT_BURST);
+	sent = rte_eth_tx_burst(goodput_port, 0, pkts, n);
+	while (sent < n)
+		rte_pktmbuf_free(pkts[sent++]);
+
+	now = rte_get_timer_cycles();
+	if (now >= *next_timer) {
+		rte_timer_manage();
+		*next_timer = now + rte_get_timer_hz() / 1000;
+	}
+}
+
+static int
+goodput_run(struct ng_tcp_stream *listener, double loss,
+	struct goodput_result *res)
+{
+	struct ng_tcp_stream *client, *server = NULL;
+	uint64_t next_timer = 0, start, last_progress;
+	struct ng_tcp_stats before;
+	uint64_t sent = 0, received = 0;
+	ssize_t ret;
+
+	memset(&goodput_link, 0, sizeof(goodput_link));
+	goodput_link.loss = (uint64_t)((double)UINT64_MAX * loss / 100);
+	ng_tcp_stats_get(GOODPUT_SHARD, &before);
+
+	client = ng_tcp_connect(goodput_ip, rte_cpu_to_be_16(GOODPUT_PORT),
+			&(struct rte_ether_addr){ .addr_bytes = { 0x02 } });
+	if (client == NULL)
+		return -rte_errno;
+
+	start = rte_get_timer_cycles();
+	last_progress = start;
+
+	while (received < goodput_bytes) {
+		uint64_t now = rte_get_timer_cycles();
+
+		if (now - last_progress > GOODPUT_STALL_S * rte_get_timer_hz())
+			break;
+
+		if (server == NULL)
+			server = ng_tcp_accept(listener);
+
+		if (sent < goodput_bytes) {
+			ret = ng_tcp_send(client, tx_buf,
+				RTE_MIN(goodput_bytes - sent,
+					(uint64_t)sizeof(tx_buf)));
+			if (ret > 0)
+				sent += ret;
+			else if (ret != -EAGAIN)
+				break;
+		}
+
+		goodput_poll(&next_timer);
+
+		if (server != NULL) {
+			ret = ng_tcp_recv(server, rx_buf, sizeof(rx_buf));
+			if (ret > 0) {
+				received += ret;
+				last_progress = rte_get_timer_cycles();
+			} else if (ret != -EAGAIN) {
+				break;
+			}
+		}
+	}
+
+	res->cycles = rte_get_timer_cycles() - start;
+	res->bytes = received;
+	res->link = goodput_link;
+	ng_tcp_stats_get(GOODPUT_SHARD, &res->stats);
+	res->stats.retransmits -= before.retransmits;
+	res->stats.timeouts -= before.timeouts;
+	res->stats.fast_recoveries -= before.fast_recoveries;
+	res->stats.ooo_segs -= before.ooo_segs;
+
+	/* shut both ends down and let the stack reclaim them */
+	goodput_link.loss = 0;
+	ng_tcp_close(client);
+	if (server != NULL)
+		ng_tcp_close(server);
+	start = rte_get_timer_cycles();
+	while (rte_get_timer_cycles() - start < rte_get_timer_hz() / 10)
+		goodput_poll(&next_timer);
+
+	return received == goodput_bytes ? 0 : -ETIMEDOUT;
+}
+
+static int
+goodput_parse_losses(char *arg)
+{
+	char *tok, *end, *save = NULL;
+
+	goodput_nb_losses = 0;
+	for (tok = strtok_r(arg, ",", &save); tok != NULL;
+			tok = strtok_r(NULL, ",", &save)) {
+		double loss;
+
+		if (goodput_nb_losses == GOODPUT_MAX_LOSSES)
+			return -1;
+		errno = 0;
+		loss = strtod(tok, &end);
+		if (errno != 0 || *end != '\0' || loss < 0 || loss >= 100)
+			return -1;
+		goodput_losses[goodput_nb_losses++] = loss;
+	}
+
+	return goodput_nb_losses != 0 ? 0 : -1;
+}
+
+static void
+goodput_usage(const char *prgname)
+{
+	printf("%s [EAL options] -- [-c newreno|cubic] [-S] [-n MB]\n"
+	       "  [-r RTO_MIN_MS] [-L LOSS_PERCENT[,LOSS_PERCENT...]]\n"
+	       "  -c: congestion control, cubic by default\n"
+	       "  -S: do not negotiate SACK\n"
+	       "  -n: megabytes transferred per loss rate, 64 by default\n"
+	       "  -r: minimum retransmission timeout, 200 ms by default\n"
+	       "  -L: loss rates of the link, 0,0.1,1,5 by default\n",
+	       prgname);
+}
+
+static int
+goodput_parse_args(int argc, char **argv)
+{
+	char *end;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:Sn:r:L:")) != -1) {
+		switch (opt) {
+		case 'c':
+			if (strcmp(optarg, "newreno") == 0)
+				goodput_cc = NG_TCP_CC_NEWRENO;
+			else if (strcmp(optarg, "cubic") == 0)
+				goodput_cc = NG_TCP_CC_CUBIC;
+			else
+				return -1;
+			break;
+		case 'S':
+			goodput_no_sack = 1;
+			break;
+		case 'n':
+			goodput_bytes = strtoull(optarg, &end, 10) << 20;
+			if (*end != '\0' || goodput_bytes == 0)
+				return -1;
+			break;
+		case 'r':
+			goodput_rto_min_ms = strtoul(optarg, &end, 10);
+			if (*end != '\0')
+				return -1;
+			break;
+		case 'L':
+			if (goodput_parse_losses(optarg) != 0)
+				return -1;
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct ng_tcp_conf conf = {
+		.nb_shards = 1,
+		.max_streams = 16,
+		.ring_size = GOODPUT_RING_SIZE,
+		.local_mac = { .addr_bytes = { 0x02 } },
+	};
+	struct ng_tcp_stream *listener;
+	struct goodput_result res;
+	unsigned int i;
+	int ret;
+
+	ret = rte_eal_init(argc, argv);
+	if (ret < 0)
+		rte_exit(EXIT_FAILURE, "Cannot init EAL\n");
+	argc -= ret;
+	argv += ret;
+
+	if (goodput_parse_args(argc, argv) != 0) {
+		goodput_usage(argv[0]);
+		rte_exit(EXIT_FAILURE, "Invalid arguments\n");
+	}
+
+	rte_timer_subsystem_init();
+
+	goodput_pool = rte_pktmbuf_pool_create("goodput_pool",
+			GOODPUT_NB_MBUFS, 256, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+			rte_socket_id());
+	if (goodput_pool == NULL)
+		rte_exit(EXIT_FAILURE, "Cannot create mbuf pool\n");
+
+	ret = goodput_port_init();
+	if (ret != 0)
+		rte_exit(EXIT_FAILURE, "Cannot set up ring port: %s\n",
+			strerror(-ret));
+
+	goodput_ip = rte_cpu_to_be_32(RTE_IPV4(10, 0, 0, 1));
+	conf.local_ip = goodput_ip;
+	conf.pool = goodput_pool;
+	conf.socket_id = rte_socket_id();
+	conf.cc = goodput_cc;
+	conf.no_sack = goodput_no_sack;
+	conf.rto_min_ms = goodput_rto_min_ms;
+	if (ng_tcp_stack_init(&conf) != 0)
+		rte_exit(EXIT_FAILURE, "Cannot init TCP stack\n");
+
+	listener = ng_tcp_socket();
+	if (listener == NULL ||
+			ng_tcp_bind(listener, goodput_ip,
+				rte_cpu_to_be_16(GOODPUT_PORT)) != 0 ||
+			ng_tcp_listen(listener, 4) != 0)
+		rte_exit(EXIT_FAILURE, "Cannot listen\n");
+
+	for (i = 0; i < sizeof(tx_buf); i++)
+		tx_buf[i] = i;
+
+	printf("%s, SACK %s, %" PRIu64 " MB per run\n",
+		goodput_cc == NG_TCP_CC_CUBIC ? "CUBIC" : "NewReno",
+		goodput_no_sack ? "off" : "on", goodput_bytes >> 20);
+	printf("%8s %12s %10s %8s %8s %8s %8s\n", "loss(%)", "goodput(Mb/s)",
+		"dropped", "retrans", "timeouts", "fastrec", "ooo");
+
+	for (i = 0; i < goodput_nb_losses; i++) {
+		double secs;
+
+		ret = goodput_run(listener, goodput_losses[i], &res);
+		secs = (double)res.cycles / rte_get_timer_hz();
+
+		printf("%8.2f %12.1f %10" PRIu64 " %8" PRIu64 " %8" PRIu64
+			" %8" PRIu64 " %8" PRIu64 "%s\n",
+			goodput_losses[i], res.bytes * 8 / secs / 1e6,
+			res.link.dropped, res.stats.retransmits,
+			res.stats.timeouts, res.stats.fast_recoveries,
+			res.stats.ooo_segs,
+			ret != 0 ? " (transfer incomplete)" : "");
+	}
+
+	ng_tcp_close(listener);
+	rte_eth_dev_stop(goodput_port);
+	rte_eal_cleanup();
+
+	return 0;
+}
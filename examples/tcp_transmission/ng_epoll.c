@@ -0,0 +1,312 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <errno.h>
+#include <sys/queue.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_errno.h>
+#include <rte_malloc.h>
+#include <rte_pause.h>
+#include <rte_ring.h>
+
+#include "ng_epoll.h"
+
+/* Registrations handled per ready ring dequeue. */
+#define NG_EPOLL_BURST		32
+
+/* ng_epitem.state */
+#define NG_EPI_QUEUED		0x1	/* on the ready ring */
+#define NG_EPI_DEAD		0x2	/* removed, freed when dequeued */
+
+/* Behaviour flags, the rest of ng_epitem.events is the requested mask. */
+#define NG_EPOLL_FLAGS		(EPOLLET | EPOLLONESHOT)
+
+/* Reported even when not requested, as by epoll(7). */
+#define NG_EPOLL_ALWAYS		(EPOLLERR | EPOLLHUP)
+
+struct ng_epitem {
+	uint32_t state;		/* NG_EPI_*, shared with the producers */
+	uint32_t events;	/* requested events and flags */
+	epoll_data_t data;
+	struct ng_epoll *ep;
+	struct ng_epoll_source *src;
+	ng_epoll_poll_t poll;
+	void *sock;
+	TAILQ_ENTRY(ng_epitem) next;
+};
+
+struct ng_epoll {
+	struct rte_ring *ready;
+	struct rte_rcu_qsbr *qsv;
+	unsigned int size;
+	unsigned int count;
+	TAILQ_HEAD(, ng_epitem) items;
+} __rte_cache_aligned;
+
+/*
+ * Queue a registration on the transition of QUEUED from 0 to 1, the same
+ * way ng_tcp_notify() does for streams.
+ */
+static void
+ng_epoll_queue(struct ng_epitem *epi)
+{
+	uint32_t old;
+
+	old = __atomic_fetch_or(&epi->state, NG_EPI_QUEUED, __ATOMIC_ACQ_REL);
+	if ((old & NG_EPI_QUEUED) == 0)
+		rte_ring_mp_enqueue(epi->ep->ready, epi);
+}
+
+void
+ng_epoll_item_signal(struct ng_epitem *epi, uint32_t events)
+{
+	uint32_t mask = __atomic_load_n(&epi->events, __ATOMIC_RELAXED);
+
+	/*
+	 * Always a read-modify-write, even if already queued: it orders the
+	 * data the event is about before the consumer clears QUEUED.
+	 */
+	if ((events & (mask | NG_EPOLL_ALWAYS)) != 0)
+		ng_epoll_queue(epi);
+}
+
+struct ng_epoll *
+ng_epoll_create(unsigned int size, struct rte_rcu_qsbr *qsv)
+{
+	struct ng_epoll *ep;
+	uint32_t ring_size;
+	ssize_t ring_mem;
+
+	if (size == 0 || size >= RTE_RING_SZ_MASK || qsv == NULL) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	ring_size = rte_align32pow2(size + 1);
+	ring_mem = rte_ring_get_memsize(ring_size);
+	if (ring_mem < 0) {
+		rte_errno = -ring_mem;
+		return NULL;
+	}
+
+	ep = rte_zmalloc("ng_epoll", sizeof(*ep) + ring_mem,
+			RTE_CACHE_LINE_SIZE);
+	if (ep == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	ep->ready = (struct rte_ring *)(ep + 1);
+	rte_ring_init(ep->ready, "ng_epoll", ring_size, RING_F_SC_DEQ);
+	ep->qsv = qsv;
+	ep->size = size;
+	TAILQ_INIT(&ep->items);
+
+	return ep;
+}
+
+/*
+ * Detach a registration from its socket. Once the producers went through
+ * a quiescent state nobody but the consumer can reach it. Returns 1 if the
+ * caller must then free it, 0 if it sits on the ready ring, where
+ * ng_epoll_wait() will find it dead.
+ */
+static int
+ng_epoll_detach(struct ng_epoll *ep, struct ng_epitem *epi)
+{
+	uint32_t old;
+
+	__atomic_store_n(&epi->src->item, NULL, __ATOMIC_RELEASE);
+	TAILQ_REMOVE(&ep->items, epi, next);
+	ep->count--;
+
+	old = __atomic_fetch_or(&epi->state, NG_EPI_DEAD | NG_EPI_QUEUED,
+			__ATOMIC_ACQ_REL);
+	return (old & NG_EPI_QUEUED) == 0;
+}
+
+void
+ng_epoll_free(struct ng_epoll *ep)
+{
+	struct ng_epitem *epi;
+
+	if (ep == NULL)
+		return;
+
+	while ((epi = TAILQ_FIRST(&ep->items)) != NULL)
+		ng_epoll_detach(ep, epi);
+
+	/* every registration is dead now, wherever it is */
+	rte_rcu_qsbr_synchronize(ep->qsv, RTE_QSBR_THRID_INVALID);
+	while (rte_ring_sc_dequeue(ep->ready, (void **)&epi) == 0)
+		rte_free(epi);
+
+	rte_free(ep);
+}
+
+static int
+ng_epoll_add(struct ng_epoll *ep, struct ng_epoll_source *src,
+	ng_epoll_poll_t poll, void *sock, const struct epoll_event *event)
+{
+	struct ng_epitem *epi;
+
+	if (src->item != NULL)
+		return -EEXIST;
+	if (ep->count == ep->size)
+		return -ENOSPC;
+
+	epi = rte_zmalloc("ng_epitem", sizeof(*epi), 0);
+	if (epi == NULL)
+		return -ENOMEM;
+
+	epi->events = event->events;
+	epi->data = event->data;
+	epi->ep = ep;
+	epi->src = src;
+	epi->poll = poll;
+	epi->sock = sock;
+	TAILQ_INSERT_TAIL(&ep->items, epi, next);
+	ep->count++;
+
+	__atomic_store_n(&src->item, epi, __ATOMIC_RELEASE);
+
+	/* events signalled before the registration are not lost */
+	ng_epoll_item_signal(epi, poll(sock));
+
+	return 0;
+}
+
+int
+ng_epoll_ctl(struct ng_epoll *ep, int op, struct ng_epoll_source *src,
+	ng_epoll_poll_t poll, void *sock, const struct epoll_event *event)
+{
+	struct ng_epitem *epi = src->item;
+	int dead;
+
+	switch (op) {
+	case EPOLL_CTL_ADD:
+		if (event == NULL || poll == NULL)
+			return -EINVAL;
+		return ng_epoll_add(ep, src, poll, sock, event);
+
+	case EPOLL_CTL_MOD:
+		if (event == NULL)
+			return -EINVAL;
+		if (epi == NULL || epi->ep != ep)
+			return -ENOENT;
+
+		epi->data = event->data;
+		__atomic_store_n(&epi->events, event->events, __ATOMIC_RELAXED);
+		ng_epoll_item_signal(epi, epi->poll(epi->sock));
+		return 0;
+
+	case EPOLL_CTL_DEL:
+		if (epi == NULL || epi->ep != ep)
+			return -ENOENT;
+
+		dead = ng_epoll_detach(ep, epi);
+		rte_rcu_qsbr_synchronize(ep->qsv, RTE_QSBR_THRID_INVALID);
+		if (dead)
+			rte_free(epi);
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+void
+ng_epoll_source_remove(struct ng_epoll_source *src)
+{
+	struct ng_epitem *epi = src->item;
+
+	if (epi != NULL)
+		ng_epoll_ctl(epi->ep, EPOLL_CTL_DEL, src, NULL, NULL, NULL);
+}
+
+/*
+ * Report the events of the registrations on the ready ring. Only the
+ * ones queued when the call starts are looked at, so level triggered
+ * registrations put back on the ring are not reported twice.
+ */
+static int
+ng_epoll_collect(struct ng_epoll *ep, struct epoll_event *events,
+	int maxevents)
+{
+	struct ng_epitem *items[NG_EPOLL_BURST];
+	unsigned int todo, nb, i;
+	int n = 0;
+
+	todo = rte_ring_count(ep->ready);
+
+	while (todo != 0 && n < maxevents) {
+		nb = RTE_MIN(todo, (unsigned int)NG_EPOLL_BURST);
+		nb = RTE_MIN(nb, (unsigned int)(maxevents - n));
+		nb = rte_ring_sc_dequeue_burst(ep->ready, (void **)items, nb,
+				NULL);
+		if (nb == 0)
+			break;
+		todo -= nb;
+
+		for (i = 0; i < nb; i++) {
+			struct ng_epitem *epi = items[i];
+			uint32_t state, mask, revents;
+
+			/* clear QUEUED before polling: later signals requeue */
+			state = __atomic_exchange_n(&epi->state, 0,
+					__ATOMIC_ACQ_REL);
+			if (state & NG_EPI_DEAD) {
+				rte_free(epi);
+				continue;
+			}
+
+			mask = epi->events & ~NG_EPOLL_FLAGS;
+			if (mask == 0)	/* disabled EPOLLONESHOT */
+				continue;
+
+			revents = epi->poll(epi->sock) &
+				(mask | NG_EPOLL_ALWAYS);
+			if (revents == 0)
+				continue;
+
+			events[n].events = revents;
+			events[n].data = epi->data;
+			n++;
+
+			if (epi->events & EPOLLONESHOT)
+				__atomic_store_n(&epi->events,
+					epi->events & NG_EPOLL_FLAGS,
+					__ATOMIC_RELAXED);
+			else if ((epi->events & EPOLLET) == 0)
+				ng_epoll_queue(epi);
+		}
+	}
+
+	return n;
+}
+
+int
+ng_epoll_wait(struct ng_epoll *ep, struct epoll_event *events, int maxevents,
+	int timeout)
+{
+	uint64_t deadline = 0;
+	int n;
+
+	if (maxevents <= 0)
+		return -EINVAL;
+
+	if (timeout > 0)
+		deadline = rte_get_timer_cycles() +
+			rte_get_timer_hz() * timeout / 1000;
+
+	for (;;) {
+		n = ng_epoll_collect(ep, events, maxevents);
+		if (n != 0 || timeout == 0)
+			return n;
+		if (timeout > 0 && rte_get_timer_cycles() >= deadline)
+			return 0;
+		rte_pause();
+	}
+}
@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#ifndef __NG_EPOLL_H__
+#define __NG_EPOLL_H__
+
+/**
+ * @file
+ *
+ * Event notification for the userspace sockets, modelled on epoll(7).
+ *
+ * An instance keeps the registered sockets and a lock-free MP/SC ready
+ * ring of the ones that may have become readable or writable. The stack
+ * lcores are the producers: ng_epoll_signal() queues a registration on
+ * the transition of its QUEUED bit from 0 to 1, so a registration is never
+ * queued twice and the ring, sized for all registrations, cannot overflow.
+ * The application thread waiting on the instance is the only consumer:
+ * ng_epoll_wait() asks every queued socket for its current state through
+ * the poll function given at registration and reports the requested
+ * events, without locks or system calls.
+ *
+ * Level triggered registrations still ready are queued again after being
+ * reported, edge triggered (EPOLLET) ones are not: they are reported again
+ * on the next signal only. EPOLLONESHOT disables a registration once it
+ * was reported, until it is modified.
+ *
+ * An instance, and the sockets registered to it, must be used by a single
+ * application thread. Stack lcores must report a quiescent state on the
+ * RCU QSBR variable given at creation once per loop: removing a socket
+ * waits for them to be done with its registration before freeing it.
+ */
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#include <rte_rcu_qsbr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ng_epoll;
+struct ng_epitem;
+
+/** Return the events currently true on a socket, EPOLLIN, EPOLLOUT... */
+typedef uint32_t (*ng_epoll_poll_t)(void *sock);
+
+/**
+ * Event source embedded in a socket: the registration of the socket, or
+ * NULL. Written by the application thread only.
+ */
+struct ng_epoll_source {
+	struct ng_epitem *item;
+};
+
+/**
+ * Create an instance for up to size sockets.
+ *
+ * @param qsv
+ *   QSBR variable on which all threads calling ng_epoll_signal() report
+ *   quiescent states.
+ * @return
+ *   The instance, or NULL with rte_errno set.
+ */
+struct ng_epoll *ng_epoll_create(unsigned int size, struct rte_rcu_qsbr *qsv);
+
+/** Remove all the sockets and release an instance. */
+void ng_epoll_free(struct ng_epoll *ep);
+
+/**
+ * Add (EPOLL_CTL_ADD), modify (EPOLL_CTL_MOD) or remove (EPOLL_CTL_DEL)
+ * the registration of a socket. A socket can be registered to one
+ * instance at a time. A socket must be removed before it is closed.
+ *
+ * @param src
+ *   Event source of the socket.
+ * @param poll
+ *   Function returning the current events of sock.
+ * @param event
+ *   Requested events and user data, ignored by EPOLL_CTL_DEL.
+ * @return
+ *   0 on success, -EEXIST, -ENOENT, -ENOSPC, -ENOMEM or -EINVAL otherwise.
+ */
+int ng_epoll_ctl(struct ng_epoll *ep, int op, struct ng_epoll_source *src,
+		ng_epoll_poll_t poll, void *sock,
+		const struct epoll_event *event);
+
+/**
+ * Remove a socket from the instance it is registered to, if any, as
+ * closing a file descriptor does. Called before the socket is closed.
+ */
+void ng_epoll_source_remove(struct ng_epoll_source *src);
+
+/**
+ * Wait for events, busy polling the ready ring.
+ *
+ * @param timeout
+ *   In milliseconds, 0 to return immediately, -1 to wait forever.
+ * @return
+ *   Number of events stored in events, 0 on timeout.
+ */
+int ng_epoll_wait(struct ng_epoll *ep, struct epoll_event *events,
+		int maxevents, int timeout);
+
+/* Slow path of ng_epoll_signal(). */
+void ng_epoll_item_signal(struct ng_epitem *epi, uint32_t events);
+
+/**
+ * Tell the instance a socket is registered to that events may have
+ * become true. Called by the stack lcores, safe from any of them.
+ */
+static inline void
+ng_epoll_signal(struct ng_epoll_source *src, uint32_t events)
+{
+	struct ng_epitem *epi = __atomic_load_n(&src->item, __ATOMIC_ACQUIRE);
+
+	if (epi != NULL)
+		ng_epoll_item_signal(epi, events);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,2432 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <netinet/in.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+#include <rte_byteorder.h>
+#include <rte_cycles.h>
+#include <rte_errno.h>
+#include <rte_hash.h>
+#include <rte_hash_crc.h>
+#include <rte_ip.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_prefetch.h>
+#include <rte_random.h>
+#include <rte_ring.h>
+#include <rte_tcp.h>
+#include <rte_thash.h>
+#include <rte_timer.h>
+
+#include "ng_epoll.h"
+#include "ng_tcp.h"
+
+/* Segments handled per bulk lookup. */
+#define NG_TCP_BURST		RTE_HASH_LOOKUP_BULK_MAX
+
+/* Segments buffered between input, timers and output. */
+#define NG_TCP_TXQ_SIZE		512
+
+/* Largest window without window scaling. */
+#define NG_TCP_MAX_WIN		UINT16_MAX
+
+#define NG_TCP_DEFAULT_BACKLOG	128
+
+#define NG_TCP_NO_SHARD		UINT16_MAX
+
+#define NG_TCP_EPHEMERAL_BASE	49152
+
+/* TCP options, see RFC 793, RFC 2018. */
+#define NG_TCP_OPT_EOL		0
+#define NG_TCP_OPT_NOP		1
+#define NG_TCP_OPT_MSS		2
+#define NG_TCP_OPT_MSS_LEN	4
+#define NG_TCP_OPT_SACK_PERM	4
+#define NG_TCP_OPT_SACK_PERM_LEN 2
+#define NG_TCP_OPT_SACK		5
+#define NG_TCP_OPT_MAX_LEN	40
+
+#define NG_TCP_HDR_LEN	(sizeof(struct rte_ether_hdr) + \
+	sizeof(struct rte_ipv4_hdr) + sizeof(struct rte_tcp_hdr))
+
+/* Retransmission timer, RFC 6298. The minimum is Linux's, not 1 s. */
+#define NG_TCP_RTO_INIT_MS	1000
+#define NG_TCP_RTO_MIN_MS	200
+#define NG_TCP_RTO_MAX_MS	60000
+#define NG_TCP_MAX_RETRIES	12
+#define NG_TCP_SYN_RETRIES	5
+
+/* Initial window in segments, RFC 6928. */
+#define NG_TCP_IW		10
+/* Duplicate ACKs or SACKed segments above a hole declaring it lost. */
+#define NG_TCP_DUPTHRESH	3
+
+/* Out of order blocks kept by the receiver, all fit in one SACK option. */
+#define NG_TCP_OOO_BLOCKS	4
+
+/* CUBIC parameters, RFC 8312. */
+#define NG_TCP_CUBIC_C		0.4
+#define NG_TCP_CUBIC_BETA	0.7
+
+/* Application to stack requests, see ng_tcp_notify(). */
+#define NG_TCP_F_TX_PENDING	0x1
+#define NG_TCP_F_CLOSED		0x2
+#define NG_TCP_F_CONNECT	0x4
+
+/* Retransmission queue entry state. */
+#define NG_TCP_SEG_SACKED	0x1
+#define NG_TCP_SEG_LOST		0x2
+#define NG_TCP_SEG_RETRANS	0x4
+
+#define NG_TCP_RECOVERY_NONE	0
+#define NG_TCP_RECOVERY_FAST	1
+#define NG_TCP_RECOVERY_RTO	2
+
+#define NG_SEQ_LT(a, b)		((int32_t)((a) - (b)) < 0)
+#define NG_SEQ_LEQ(a, b)	((int32_t)((a) - (b)) <= 0)
+#define NG_SEQ_GT(a, b)		((int32_t)((a) - (b)) > 0)
+#define NG_SEQ_GEQ(a, b)	((int32_t)((a) - (b)) >= 0)
+
+/* Connection 4-tuple, as seen on received segments, network order. */
+struct ng_tcp_key {
+	uint32_t sip;	/* remote */
+	uint32_t dip;	/* local */
+	uint16_t sport;	/* remote */
+	uint16_t dport;	/* local */
+};
+
+/*
+ * Sent and not yet acknowledged segment. The payload mbuf stays here and
+ * every transmission chains it behind a fresh header mbuf, so
+ * retransmissions copy nothing. SYN and FIN have no payload.
+ */
+struct ng_tcp_txseg {
+	struct rte_mbuf *m;
+	uint32_t seq;
+	uint16_t len;
+	uint8_t tcp_flags;	/* SYN or FIN */
+	uint8_t state;		/* NG_TCP_SEG_* */
+};
+
+/* Contiguous out of order data, a chain of received segments. */
+struct ng_tcp_ooo {
+	struct rte_mbuf *m;
+	uint32_t seq;
+	uint32_t len;
+};
+
+struct ng_tcp_cubic {
+	uint64_t epoch;		/* start of the avoidance epoch, 0 if none */
+	double k;		/* seconds to reach origin */
+	uint32_t origin;	/* bytes */
+	uint32_t w_max;		/* bytes */
+	uint32_t w_est;		/* bytes, TCP-friendly estimate */
+};
+
+struct ng_tcp_stream {
+
+	struct ng_tcp_key key;
+	struct rte_ether_addr peer_mac;
+	uint16_t shard;
+	NG_TCP_STATUS status;
+
+	/* owning shard only */
+	uint32_t snd_una;
+	uint32_t snd_nxt;
+	uint32_t snd_wnd;
+	uint32_t rcv_nxt;
+	uint16_t mss;
+	uint8_t sack_ok;
+	uint8_t ack_pending;
+	uint8_t probe;
+	uint8_t dupacks;
+	uint8_t recovery;	/* NG_TCP_RECOVERY_* */
+	uint8_t backoff;
+	struct ng_tcp_stream *listener;
+
+	/* congestion control */
+	uint32_t cwnd;
+	uint32_t ssthresh;
+	uint32_t recover;
+	uint32_t bytes_acked;
+	struct ng_tcp_cubic cubic;
+
+	/* RFC 6298, in timer cycles */
+	uint64_t srtt;
+	uint64_t rttvar;
+	uint64_t rto;
+	uint64_t rtt_ts;	/* 0 when no sample is running */
+	uint32_t rtt_seq;
+	uint64_t rto_expire;	/* 0 when the timer is stopped */
+	struct rte_timer timer;
+
+	/* retransmission queue, in sequence order */
+	struct ng_tcp_txseg *rtx;
+	uint32_t rtx_head;
+	uint32_t rtx_tail;
+	uint32_t rtx_mask;
+	struct rte_mbuf *snd_next;	/* taken from sndbuf, not sent yet */
+
+	/* out of order queue, sorted by sequence */
+	uint8_t nb_ooo;
+	uint8_t ooo_last;	/* most recently updated block */
+	struct ng_tcp_ooo ooo[NG_TCP_OOO_BLOCKS];
+
+	/* stack -> application */
+	struct rte_ring *rcvbuf;
+	uint32_t rcv_eof;
+	uint32_t snd_shut;
+	int error;
+	struct ng_epoll_source ev;
+
+	/* application -> stack */
+	struct rte_ring *sndbuf;
+	uint32_t app_flags;
+
+	/* listener */
+	struct rte_ring *accept;
+	unsigned int backlog;
+
+	/* application only */
+	struct rte_mbuf *rcv_head;
+	uint32_t rcv_off;
+
+} __rte_cache_aligned;
+
+/* Parsed received segment. */
+struct ng_tcp_seg {
+	struct rte_mbuf *m;
+	struct rte_ether_hdr *eth;
+	struct rte_ipv4_hdr *ip;
+	struct rte_tcp_hdr *tcp;
+	uint32_t seq;
+	uint32_t ack;
+	uint16_t hlen;	/* eth + ip + tcp with options */
+	uint16_t len;	/* payload */
+	uint8_t flags;
+};
+
+/* Options of a received segment, sequence numbers in host order. */
+struct ng_tcp_opts {
+	uint16_t mss;
+	uint8_t sack_ok;
+	uint8_t nb_sack;
+	uint32_t sack[NG_TCP_OOO_BLOCKS][2];
+};
+
+struct ng_tcp_cc_ops {
+	void (*init)(struct ng_tcp_stream *stream);
+	/* new data acknowledged outside of fast recovery */
+	void (*on_ack)(struct ng_tcp_stream *stream, uint32_t acked,
+		uint64_t now);
+	/* loss detected, return the new slow start threshold */
+	uint32_t (*ssthresh)(struct ng_tcp_stream *stream);
+};
+
+struct ng_tcp_shard {
+	struct rte_hash *table;
+	struct rte_mempool *streams;
+	struct rte_ring *notify;
+	uint16_t id;
+
+	uint16_t nb_txq;
+	struct rte_mbuf *txq[NG_TCP_TXQ_SIZE];
+
+	uint16_t nb_ack;
+	struct ng_tcp_stream *ack[NG_TCP_BURST];
+
+	struct ng_tcp_stats stats;
+} __rte_cache_aligned;
+
+struct ng_tcp_stack {
+	struct ng_tcp_conf conf;
+	const struct ng_tcp_cc_ops *cc;
+	uint64_t hz;
+	uint64_t rto_min;
+	uint64_t rto_max;
+	uint32_t next_port;
+	struct ng_tcp_shard shards[NG_TCP_MAX_SHARDS];
+	/* indexed by local port, host order */
+	struct ng_tcp_stream *listeners[UINT16_MAX + 1];
+};
+
+static struct ng_tcp_stack *ng_stack;
+
+static void ng_tcp_rto_expire(struct rte_timer *timer, void *arg);
+
+/*
+ * Tell the shard owning a connection that it has work to do. A stream is
+ * queued on the notify ring only on the transition of TX_PENDING from 0 to
+ * 1, so it is never queued twice and the ring, sized for all the streams
+ * of the shard, cannot overflow.
+ */
+static void
+ng_tcp_notify(struct ng_tcp_stream *stream, uint32_t flags)
+{
+	struct ng_tcp_shard *shard = &ng_stack->shards[stream->shard];
+	uint32_t old;
+
+	old = __atomic_fetch_or(&stream->app_flags,
+			flags | NG_TCP_F_TX_PENDING, __ATOMIC_ACQ_REL);
+	if ((old & NG_TCP_F_TX_PENDING) == 0)
+		rte_ring_mp_enqueue(shard->notify, stream);
+}
+
+static inline uint32_t
+ng_tcp_seg_end(const struct ng_tcp_txseg *ts)
+{
+	return ts->seq + ts->len + (ts->tcp_flags != 0);
+}
+
+static inline uint32_t
+ng_tcp_rtx_count(const struct ng_tcp_stream *stream)
+{
+	return stream->rtx_tail - stream->rtx_head;
+}
+
+static inline struct ng_tcp_txseg *
+ng_tcp_rtx_at(const struct ng_tcp_stream *stream, uint32_t idx)
+{
+	return &stream->rtx[idx & stream->rtx_mask];
+}
+
+/* Window we can advertise: room left on the receive ring. */
+static uint16_t
+ng_tcp_rcv_wnd(const struct ng_tcp_stream *stream)
+{
+	uint32_t win = rte_ring_free_count(stream->rcvbuf) * NG_TCP_MSS;
+
+	return RTE_MIN(win, (uint32_t)NG_TCP_MAX_WIN);
+}
+
+/*
+ * Prepend Ethernet, IPv4 and TCP headers to m. The TCP checksum is computed
+ * over the whole chain, so m may carry its payload in further segments.
+ */
+static int
+ng_tcp_encode(struct rte_mbuf *m, const struct ng_tcp_key *key,
+	const struct rte_ether_addr *dmac, uint8_t flags, uint32_t seq,
+	uint32_t ack, uint16_t win, const uint8_t *opt, uint16_t optlen)
+{
+	uint32_t paylen = rte_pktmbuf_pkt_len(m);
+	uint16_t l4len = sizeof(struct rte_tcp_hdr) + optlen + paylen;
+	struct rte_ether_hdr *eth;
+	struct rte_ipv4_hdr *ip;
+	struct rte_tcp_hdr *tcp;
+	uint32_t cksum;
+	uint16_t raw;
+
+	eth = (struct rte_ether_hdr *)rte_pktmbuf_prepend(m,
+			NG_TCP_HDR_LEN + optlen);
+	if (eth == NULL)
+		return -ENOSPC;
+
+	rte_ether_addr_copy(dmac, &eth->d_addr);
+	rte_ether_addr_copy(&ng_stack->conf.local_mac, &eth->s_addr);
+	eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+
+	ip = (struct rte_ipv4_hdr *)(eth + 1);
+	ip->version_ihl = 0x45;
+	ip->type_of_service = 0;
+	ip->total_length = rte_cpu_to_be_16(sizeof(*ip) + l4len);
+	ip->packet_id = 0;
+	ip->fragment_offset = rte_cpu_to_be_16(RTE_IPV4_HDR_DF_FLAG);
+	ip->time_to_live = 64;
+	ip->next_proto_id = IPPROTO_TCP;
+	ip->src_addr = key->dip;
+	ip->dst_addr = key->sip;
+	ip->hdr_checksum = 0;
+	ip->hdr_checksum = rte_ipv4_cksum(ip);
+
+	tcp = (struct rte_tcp_hdr *)(ip + 1);
+	tcp->src_port = key->dport;
+	tcp->dst_port = key->sport;
+	tcp->sent_seq = rte_cpu_to_be_32(seq);
+	tcp->recv_ack = rte_cpu_to_be_32(ack);
+	tcp->data_off = ((sizeof(*tcp) + optlen) / 4) << 4;
+	tcp->tcp_flags = flags;
+	tcp->rx_win = rte_cpu_to_be_16(win);
+	tcp->tcp_urp = 0;
+	tcp->cksum = 0;
+
+	if (optlen != 0)
+		memcpy(tcp + 1, opt, optlen);
+
+	if (rte_raw_cksum_mbuf(m, sizeof(*eth) + sizeof(*ip), l4len,
+			&raw) != 0)
+		return -EINVAL;
+
+	cksum = (uint32_t)raw + rte_ipv4_phdr_cksum(ip, 0);
+	cksum = ((cksum & 0xffff0000) >> 16) + (cksum & 0xffff);
+	cksum = (~cksum) & 0xffff;
+	tcp->cksum = cksum == 0 ? 0xffff : cksum;
+
+	return 0;
+}
+
+/* Build a payload-less segment and queue it for ng_tcp_output_burst(). */
+static void
+ng_tcp_send_ctrl(struct ng_tcp_shard *shard, const struct ng_tcp_key *key,
+	const struct rte_ether_addr *dmac, uint8_t flags, uint32_t seq,
+	uint32_t ack, uint16_t win, const uint8_t *opt, uint16_t optlen)
+{
+	struct rte_mbuf *m;
+
+	if (unlikely(shard->nb_txq == NG_TCP_TXQ_SIZE)) {
+		shard->stats.tx_drops++;
+		return;
+	}
+
+	m = rte_pktmbuf_alloc(ng_stack->conf.pool);
+	if (unlikely(m == NULL)) {
+		shard->stats.tx_drops++;
+		return;
+	}
+
+	if (ng_tcp_encode(m, key, dmac, flags, seq, ack, win,
+			opt, optlen) != 0) {
+		rte_pktmbuf_free(m);
+		shard->stats.tx_drops++;
+		return;
+	}
+
+	shard->txq[shard->nb_txq++] = m;
+}
+
+/* Answer a segment no connection wants, as per RFC 793 "Reset Generation". */
+static void
+ng_tcp_send_reset(struct ng_tcp_shard *shard, const struct ng_tcp_seg *seg)
+{
+	struct ng_tcp_key key = {
+		.sip = seg->ip->src_addr,
+		.dip = seg->ip->dst_addr,
+		.sport = seg->tcp->src_port,
+		.dport = seg->tcp->dst_port,
+	};
+	uint32_t ack;
+
+	if (seg->flags & RTE_TCP_RST_FLAG)
+		return;
+
+	if (seg->flags & RTE_TCP_ACK_FLAG) {
+		ng_tcp_send_ctrl(shard, &key, &seg->eth->s_addr,
+			RTE_TCP_RST_FLAG, seg->ack, 0, 0, NULL, 0);
+		return;
+	}
+
+	ack = seg->seq + seg->len;
+	if (seg->flags & RTE_TCP_SYN_FLAG)
+		ack++;
+	if (seg->flags & RTE_TCP_FIN_FLAG)
+		ack++;
+	ng_tcp_send_ctrl(shard, &key, &seg->eth->s_addr,
+		RTE_TCP_RST_FLAG | RTE_TCP_ACK_FLAG, 0, ack, 0, NULL, 0);
+}
+
+/* ACK reporting the out of order blocks, most recent first (RFC 2018). */
+static void
+ng_tcp_send_ack(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream)
+{
+	uint8_t opt[NG_TCP_OPT_MAX_LEN];
+	uint16_t optlen = 0;
+	uint8_t i;
+
+	if (stream->sack_ok && stream->nb_ooo != 0) {
+		opt[optlen++] = NG_TCP_OPT_NOP;
+		opt[optlen++] = NG_TCP_OPT_NOP;
+		opt[optlen++] = NG_TCP_OPT_SACK;
+		opt[optlen++] = 2 + 8 * stream->nb_ooo;
+
+		for (i = 0; i < stream->nb_ooo; i++) {
+			const struct ng_tcp_ooo *b = &stream->ooo[
+				(stream->ooo_last + i) % stream->nb_ooo];
+			uint32_t edge;
+
+			edge = rte_cpu_to_be_32(b->seq);
+			memcpy(&opt[optlen], &edge, sizeof(edge));
+			edge = rte_cpu_to_be_32(b->seq + b->len);
+			memcpy(&opt[optlen + 4], &edge, sizeof(edge));
+			optlen += 8;
+		}
+	}
+
+	ng_tcp_send_ctrl(shard, &stream->key, &stream->peer_mac,
+		RTE_TCP_ACK_FLAG, stream->snd_nxt, stream->rcv_nxt,
+		ng_tcp_rcv_wnd(stream), opt, optlen);
+}
+
+/* Send one ACK per connection for the whole burst. */
+static void
+ng_tcp_ack_later(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream)
+{
+	if (stream->ack_pending)
+		return;
+
+	stream->ack_pending = 1;
+	shard->ack[shard->nb_ack++] = stream;
+}
+
+static void
+ng_tcp_flush_acks(struct ng_tcp_shard *shard)
+{
+	uint16_t i;
+
+	for (i = 0; i < shard->nb_ack; i++) {
+		struct ng_tcp_stream *stream = shard->ack[i];
+
+		stream->ack_pending = 0;
+		ng_tcp_send_ack(shard, stream);
+	}
+	shard->nb_ack = 0;
+}
+
+/*
+ * Transmit an entry of the retransmission queue. The header goes in a new
+ * mbuf and the payload is chained with an extra reference.
+ */
+static int
+ng_tcp_xmit(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream,
+	const struct ng_tcp_txseg *ts)
+{
+	uint8_t opt[NG_TCP_OPT_MSS_LEN + NG_TCP_OPT_SACK_PERM_LEN + 2];
+	uint8_t flags = RTE_TCP_ACK_FLAG;
+	uint16_t optlen = 0;
+	struct rte_mbuf *m;
+
+	if (unlikely(shard->nb_txq == NG_TCP_TXQ_SIZE))
+		return -ENOBUFS;
+
+	m = rte_pktmbuf_alloc(ng_stack->conf.pool);
+	if (unlikely(m == NULL))
+		return -ENOMEM;
+
+	if (ts->m != NULL) {
+		rte_mbuf_refcnt_update(ts->m, 1);
+		if (rte_pktmbuf_chain(m, ts->m) != 0) {
+			rte_mbuf_refcnt_update(ts->m, -1);
+			rte_pktmbuf_free(m);
+			return -EOVERFLOW;
+		}
+		flags |= RTE_TCP_PSH_FLAG;
+	}
+
+	if (ts->tcp_flags & RTE_TCP_SYN_FLAG) {
+		if (stream->status == NG_TCP_STATUS_SYN_SENT)
+			flags = RTE_TCP_SYN_FLAG;
+		else
+			flags |= RTE_TCP_SYN_FLAG;
+
+		opt[optlen++] = NG_TCP_OPT_MSS;
+		opt[optlen++] = NG_TCP_OPT_MSS_LEN;
+		opt[optlen++] = NG_TCP_MSS >> 8;
+		opt[optlen++] = NG_TCP_MSS & 0xff;
+		if (stream->sack_ok) {
+			opt[optlen++] = NG_TCP_OPT_NOP;
+			opt[optlen++] = NG_TCP_OPT_NOP;
+			opt[optlen++] = NG_TCP_OPT_SACK_PERM;
+			opt[optlen++] = NG_TCP_OPT_SACK_PERM_LEN;
+		}
+	}
+	flags |= ts->tcp_flags & RTE_TCP_FIN_FLAG;
+
+	if (ng_tcp_encode(m, &stream->key, &stream->peer_mac, flags, ts->seq,
+			stream->rcv_nxt, ng_tcp_rcv_wnd(stream),
+			opt, optlen) != 0) {
+		rte_pktmbuf_free(m);
+		return -EINVAL;
+	}
+
+	shard->txq[shard->nb_txq++] = m;
+	return 0;
+}
+
+static inline uint64_t
+ng_tcp_rto_cycles(const struct ng_tcp_stream *stream)
+{
+	return RTE_MIN(stream->rto << stream->backoff, ng_stack->rto_max);
+}
+
+/*
+ * (Re)start the retransmission timer. The rte_timer is only moved when it
+ * would fire late: an early expiry just re-arms it for rto_expire, so
+ * restarting the timer on every ACK costs a store.
+ */
+static void
+ng_tcp_timer_start(struct ng_tcp_stream *stream, uint64_t now)
+{
+	uint64_t expire = now + ng_tcp_rto_cycles(stream);
+
+	stream->rto_expire = expire;
+	if (!rte_timer_pending(&stream->timer) ||
+			stream->timer.expire > expire)
+		rte_timer_reset(&stream->timer, expire - now, SINGLE,
+			rte_lcore_id(), ng_tcp_rto_expire, stream);
+}
+
+static inline void
+ng_tcp_timer_stop(struct ng_tcp_stream *stream)
+{
+	stream->rto_expire = 0;
+}
+
+/* Update SRTT, RTTVAR and RTO with a new measurement, RFC 6298 (2). */
+static void
+ng_tcp_rtt_sample(struct ng_tcp_stream *stream, uint64_t r)
+{
+	if (stream->srtt == 0) {
+		stream->srtt = r;
+		stream->rttvar = r / 2;
+	} else {
+		uint64_t delta = stream->srtt > r ? stream->srtt - r :
+			r - stream->srtt;
+
+		stream->rttvar = (3 * stream->rttvar + delta) / 4;
+		stream->srtt = (7 * stream->srtt + r) / 8;
+	}
+
+	stream->rto = stream->srtt + 4 * stream->rttvar;
+	stream->rto = RTE_MAX(stream->rto, ng_stack->rto_min);
+	stream->rto = RTE_MIN(stream->rto, ng_stack->rto_max);
+}
+
+/* Bytes in flight as defined by RFC 6675 "pipe". */
+static uint32_t
+ng_tcp_pipe(const struct ng_tcp_stream *stream)
+{
+	uint32_t i, pipe = 0, dup = 0;
+
+	for (i = stream->rtx_head; i != stream->rtx_tail; i++) {
+		const struct ng_tcp_txseg *ts = ng_tcp_rtx_at(stream, i);
+		uint32_t len = ng_tcp_seg_end(ts) - ts->seq;
+
+		if (ts->state & NG_TCP_SEG_SACKED)
+			continue;
+		if ((ts->state & NG_TCP_SEG_LOST) == 0)
+			pipe += len;
+		if (ts->state & NG_TCP_SEG_RETRANS)
+			pipe += len;
+	}
+
+	/* without SACK, each duplicate ACK is a segment that left */
+	if (!stream->sack_ok)
+		dup = stream->dupacks * stream->mss;
+	return pipe > dup ? pipe - dup : 0;
+}
+
+static void
+ng_tcp_newreno_init(struct ng_tcp_stream *stream)
+{
+	RTE_SET_USED(stream);
+}
+
+/* Slow start with ABC (L = 2), then one MSS per window (RFC 5681). */
+static void
+ng_tcp_newreno_on_ack(struct ng_tcp_stream *stream, uint32_t acked,
+	uint64_t now)
+{
+	RTE_SET_USED(now);
+
+	if (stream->cwnd < stream->ssthresh) {
+		stream->cwnd += RTE_MIN(acked, 2U * stream->mss);
+		return;
+	}
+
+	stream->bytes_acked += acked;
+	if (stream->bytes_acked >= stream->cwnd) {
+		stream->bytes_acked -= stream->cwnd;
+		stream->cwnd += stream->mss;
+	}
+}
+
+static uint32_t
+ng_tcp_newreno_ssthresh(struct ng_tcp_stream *stream)
+{
+	uint32_t flight = stream->snd_nxt - stream->snd_una;
+
+	return RTE_MAX(flight / 2, 2U * stream->mss);
+}
+
+static void
+ng_tcp_cubic_init(struct ng_tcp_stream *stream)
+{
+	memset(&stream->cubic, 0, sizeof(stream->cubic));
+}
+
+static void
+ng_tcp_cubic_on_ack(struct ng_tcp_stream *stream, uint32_t acked,
+	uint64_t now)
+{
+	struct ng_tcp_cubic *c = &stream->cubic;
+	double t, target;
+	uint32_t cwnd = stream->cwnd;
+
+	if (cwnd < stream->ssthresh) {
+		stream->cwnd += RTE_MIN(acked, 2U * stream->mss);
+		return;
+	}
+
+	if (c->epoch == 0) {
+		c->epoch = now;
+		if (cwnd < c->w_max) {
+			c->k = cbrt((double)(c->w_max - cwnd) / stream->mss /
+				NG_TCP_CUBIC_C);
+			c->origin = c->w_max;
+		} else {
+			c->k = 0;
+			c->origin = cwnd;
+		}
+		c->w_est = cwnd;
+	}
+
+	/* where the window should be one RTT from now, in bytes */
+	t = (double)(now - c->epoch + stream->srtt) / ng_stack->hz - c->k;
+	target = c->origin + NG_TCP_CUBIC_C * t * t * t * stream->mss;
+	target = RTE_MIN(target, 1.5 * cwnd);
+
+	/* Reno-friendly region */
+	c->w_est += (uint64_t)acked * stream->mss *
+		(3 * (1 - NG_TCP_CUBIC_BETA) / (1 + NG_TCP_CUBIC_BETA)) / cwnd;
+	if (target < c->w_est)
+		target = c->w_est;
+
+	if (target <= cwnd)
+		return;
+
+	stream->bytes_acked += (uint32_t)((target - cwnd) * acked / cwnd);
+	if (stream->bytes_acked >= stream->mss) {
+		stream->cwnd += stream->bytes_acked;
+		stream->bytes_acked = 0;
+	}
+}
+
+static uint32_t
+ng_tcp_cubic_ssthresh(struct ng_tcp_stream *stream)
+{
+	struct ng_tcp_cubic *c = &stream->cubic;
+	uint32_t cwnd = stream->cwnd;
+
+	/* fast convergence: leave room to newer flows */
+	if (cwnd < c->w_max)
+		c->w_max = cwnd * (1 + NG_TCP_CUBIC_BETA) / 2;
+	else
+		c->w_max = cwnd;
+	c->epoch = 0;
+
+	return RTE_MAX((uint32_t)(cwnd * NG_TCP_CUBIC_BETA),
+		2U * stream->mss);
+}
+
+static const struct ng_tcp_cc_ops ng_tcp_cc[] = {
+	[NG_TCP_CC_NEWRENO] = {
+		.init = ng_tcp_newreno_init,
+		.on_ack = ng_tcp_newreno_on_ack,
+		.ssthresh = ng_tcp_newreno_ssthresh,
+	},
+	[NG_TCP_CC_CUBIC] = {
+		.init = ng_tcp_cubic_init,
+		.on_ack = ng_tcp_cubic_on_ack,
+		.ssthresh = ng_tcp_cubic_ssthresh,
+	},
+};
+
+static int
+ng_tcp_parse(struct rte_mbuf *m, struct ng_tcp_seg *seg)
+{
+	uint16_t iplen, thlen;
+
+	if (unlikely(rte_pktmbuf_data_len(m) < NG_TCP_HDR_LEN))
+		return -EINVAL;
+
+	seg->m = m;
+	seg->eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+	seg->ip = (struct rte_ipv4_hdr *)(seg->eth + 1);
+	seg->tcp = (struct rte_tcp_hdr *)(seg->ip + 1);
+
+	/* IP options and fragments are not supported */
+	if (seg->eth->ether_type != rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4) ||
+			seg->ip->version_ihl != 0x45 ||
+			seg->ip->next_proto_id != IPPROTO_TCP ||
+			seg->ip->dst_addr != ng_stack->conf.local_ip ||
+			(seg->ip->fragment_offset &
+			 rte_cpu_to_be_16(RTE_IPV4_HDR_MF_FLAG |
+				 RTE_IPV4_HDR_OFFSET_MASK)) != 0)
+		return -EINVAL;
+
+	iplen = rte_be_to_cpu_16(seg->ip->total_length);
+	thlen = (seg->tcp->data_off >> 4) * 4;
+	if (unlikely(thlen < sizeof(struct rte_tcp_hdr) ||
+			iplen < sizeof(struct rte_ipv4_hdr) + thlen ||
+			sizeof(struct rte_ether_hdr) + iplen >
+			rte_pktmbuf_data_len(m)))
+		return -EINVAL;
+
+	switch (m->ol_flags & PKT_RX_L4_CKSUM_MASK) {
+	case PKT_RX_L4_CKSUM_GOOD:
+		break;
+	case PKT_RX_L4_CKSUM_BAD:
+		return -EINVAL;
+	default:
+		/* a valid checksum sums up to 0xffff */
+		if (rte_ipv4_udptcp_cksum(seg->ip, seg->tcp) != 0xffff)
+			return -EINVAL;
+	}
+
+	seg->hlen = sizeof(struct rte_ether_hdr) +
+		sizeof(struct rte_ipv4_hdr) + thlen;
+	seg->len = iplen - sizeof(struct rte_ipv4_hdr) - thlen;
+	seg->seq = rte_be_to_cpu_32(seg->tcp->sent_seq);
+	seg->ack = rte_be_to_cpu_32(seg->tcp->recv_ack);
+	seg->flags = seg->tcp->tcp_flags;
+
+	return 0;
+}
+
+static void
+ng_tcp_parse_opts(const struct ng_tcp_seg *seg, struct ng_tcp_opts *opts)
+{
+	const uint8_t *opt = (const uint8_t *)(seg->tcp + 1);
+	uint16_t len = seg->hlen - NG_TCP_HDR_LEN;
+	uint16_t i = 0;
+
+	memset(opts, 0, sizeof(*opts));
+
+	while (i < len) {
+		uint8_t kind = opt[i], olen;
+
+		if (kind == NG_TCP_OPT_EOL)
+			break;
+		if (kind == NG_TCP_OPT_NOP) {
+			i++;
+			continue;
+		}
+		if (i + 1 >= len)
+			break;
+		olen = opt[i + 1];
+		if (olen < 2 || i + olen > len)
+			break;
+
+		switch (kind) {
+		case NG_TCP_OPT_MSS:
+			if (olen == NG_TCP_OPT_MSS_LEN)
+				opts->mss = (opt[i + 2] << 8) | opt[i + 3];
+			break;
+		case NG_TCP_OPT_SACK_PERM:
+			opts->sack_ok = 1;
+			break;
+		case NG_TCP_OPT_SACK: {
+			uint8_t n = RTE_MIN((olen - 2) / 8, NG_TCP_OOO_BLOCKS);
+			uint8_t b;
+
+			for (b = 0; b < n; b++) {
+				uint32_t edge[2];
+
+				memcpy(edge, &opt[i + 2 + 8 * b], sizeof(edge));
+				opts->sack[b][0] = rte_be_to_cpu_32(edge[0]);
+				opts->sack[b][1] = rte_be_to_cpu_32(edge[1]);
+			}
+			opts->nb_sack = n;
+			break;
+		}
+		default:
+			break;
+		}
+		i += olen;
+	}
+}
+
+/* Take the MSS and SACK permission from a SYN. */
+static void
+ng_tcp_syn_options(struct ng_tcp_stream *stream, const struct ng_tcp_seg *seg)
+{
+	struct ng_tcp_opts opts;
+
+	ng_tcp_parse_opts(seg, &opts);
+
+	stream->mss = NG_TCP_MSS;
+	if (opts.mss != 0 && opts.mss < NG_TCP_MSS)
+		stream->mss = opts.mss;
+	stream->sack_ok = opts.sack_ok && !ng_stack->conf.no_sack;
+	stream->snd_wnd = rte_be_to_cpu_16(seg->tcp->rx_win);
+	stream->cwnd = NG_TCP_IW * stream->mss;
+}
+
+static struct ng_tcp_stream *
+ng_tcp_listener_get(uint32_t ip, uint16_t port)
+{
+	struct ng_tcp_stream *listener;
+
+	listener = __atomic_load_n(&ng_stack->listeners[rte_be_to_cpu_16(port)],
+			__ATOMIC_ACQUIRE);
+	if (listener == NULL || (listener->key.dip != INADDR_ANY &&
+			listener->key.dip != ip))
+		return NULL;
+
+	return listener;
+}
+
+/* Shard whose RX queue receives the segments of a connection. */
+static uint16_t
+ng_tcp_shard_of(const struct ng_tcp_key *key)
+{
+	union rte_thash_tuple tuple;
+
+	if (ng_stack->conf.nb_shards == 1)
+		return 0;
+
+	tuple.v4.src_addr = rte_be_to_cpu_32(key->sip);
+	tuple.v4.dst_addr = rte_be_to_cpu_32(key->dip);
+	tuple.v4.sport = rte_be_to_cpu_16(key->sport);
+	tuple.v4.dport = rte_be_to_cpu_16(key->dport);
+
+	return rte_softrss((uint32_t *)&tuple, RTE_THASH_V4_L4_LEN,
+			ng_stack->conf.rss_key) % ng_stack->conf.nb_shards;
+}
+
+/*
+ * Get a stream and its rings from a shard's pool. The stream is not in
+ * the shard's table yet.
+ */
+static struct ng_tcp_stream *
+ng_tcp_stream_alloc(struct ng_tcp_shard *shard, const struct ng_tcp_key *key,
+	const struct rte_ether_addr *peer_mac)
+{
+	uint32_t ring_size = ng_stack->conf.ring_size;
+	struct ng_tcp_stream *stream;
+	void *obj;
+
+	if (rte_mempool_get(shard->streams, &obj) != 0)
+		return NULL;
+
+	stream = obj;
+	memset(stream, 0, sizeof(*stream));
+	stream->rcvbuf = (struct rte_ring *)((uint8_t *)obj +
+			sizeof(struct ng_tcp_stream));
+	stream->sndbuf = (struct rte_ring *)((uint8_t *)stream->rcvbuf +
+			rte_ring_get_memsize(ring_size));
+	stream->rtx = (struct ng_tcp_txseg *)((uint8_t *)stream->sndbuf +
+			rte_ring_get_memsize(ring_size));
+	stream->rtx_mask = 2 * ring_size - 1;
+	rte_ring_init(stream->rcvbuf, "ng_tcp_rcv", ring_size,
+		RING_F_SP_ENQ | RING_F_SC_DEQ);
+	rte_ring_init(stream->sndbuf, "ng_tcp_snd", ring_size,
+		RING_F_SP_ENQ | RING_F_SC_DEQ);
+	rte_timer_init(&stream->timer);
+
+	stream->key = *key;
+	rte_ether_addr_copy(peer_mac, &stream->peer_mac);
+	stream->shard = shard->id;
+	stream->snd_una = (uint32_t)rte_rand();
+	stream->snd_nxt = stream->snd_una;
+	stream->mss = NG_TCP_MSS;
+	stream->sack_ok = !ng_stack->conf.no_sack;
+	stream->snd_wnd = NG_TCP_MSS;
+	stream->cwnd = NG_TCP_IW * NG_TCP_MSS;
+	stream->ssthresh = UINT32_MAX;
+	stream->rto = RTE_MAX(ng_stack->hz * NG_TCP_RTO_INIT_MS / 1000,
+		ng_stack->rto_min);
+	ng_stack->cc->init(stream);
+
+	return stream;
+}
+
+static int
+ng_tcp_stream_insert(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream)
+{
+	/* adding an existing key would replace its data */
+	if (rte_hash_lookup(shard->table, &stream->key) >= 0)
+		return -EADDRINUSE;
+
+	if (rte_hash_add_key_data(shard->table, &stream->key, stream) < 0)
+		return -ENOSPC;
+
+	shard->stats.streams++;
+	return 0;
+}
+
+static void
+ng_tcp_stream_release(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream)
+{
+	struct rte_mbuf *m;
+	uint32_t i;
+
+	if (rte_hash_del_key(shard->table, &stream->key) >= 0)
+		shard->stats.streams--;
+
+	rte_timer_stop(&stream->timer);
+
+	while (rte_ring_sc_dequeue(stream->rcvbuf, (void **)&m) == 0)
+		rte_pktmbuf_free(m);
+	while (rte_ring_sc_dequeue(stream->sndbuf, (void **)&m) == 0)
+		rte_pktmbuf_free(m);
+	rte_pktmbuf_free(stream->snd_next);
+	for (i = stream->rtx_head; i != stream->rtx_tail; i++)
+		rte_pktmbuf_free(ng_tcp_rtx_at(stream, i)->m);
+	for (i = 0; i < stream->nb_ooo; i++)
+		rte_pktmbuf_free(stream->ooo[i].m);
+
+	rte_mempool_put(shard->streams, stream);
+}
+
+/*
+ * Move the connection to CLOSED. The application is told through rcv_eof
+ * and snd_shut; the stream is reclaimed by the output path once the
+ * application closed it too.
+ */
+static void
+ng_tcp_stream_set_closed(struct ng_tcp_stream *stream, int error)
+{
+	stream->status = NG_TCP_STATUS_CLOSED;
+	stream->error = error;
+	ng_tcp_timer_stop(stream);
+	__atomic_store_n(&stream->snd_shut, 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&stream->rcv_eof, 1, __ATOMIC_RELEASE);
+	ng_epoll_signal(&stream->ev, EPOLLIN | EPOLLRDHUP | EPOLLHUP |
+		(error != 0 ? EPOLLERR : 0));
+}
+
+/* Same as above, from input and timers: let the output path reclaim it. */
+static void
+ng_tcp_stream_closed(struct ng_tcp_stream *stream, int error, uint32_t flags)
+{
+	ng_tcp_stream_set_closed(stream, error);
+	ng_tcp_notify(stream, flags);
+}
+
+/* Append SYN, FIN or data to the retransmission queue and send it. */
+static void
+ng_tcp_send_new(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream,
+	struct rte_mbuf *m, uint8_t tcp_flags, uint64_t now)
+{
+	struct ng_tcp_txseg *ts = ng_tcp_rtx_at(stream, stream->rtx_tail++);
+
+	ts->m = m;
+	ts->seq = stream->snd_nxt;
+	ts->len = m != NULL ? rte_pktmbuf_pkt_len(m) : 0;
+	ts->tcp_flags = tcp_flags;
+	ts->state = 0;
+	stream->snd_nxt = ng_tcp_seg_end(ts);
+
+	/* a lost first transmission is recovered by the timer */
+	ng_tcp_xmit(shard, stream, ts);
+
+	if (stream->rtt_ts == 0) {
+		stream->rtt_ts = now;
+		stream->rtt_seq = stream->snd_nxt;
+	}
+	if (stream->rto_expire == 0)
+		ng_tcp_timer_start(stream, now);
+}
+
+static void
+ng_tcp_rto_expire(struct rte_timer *timer, void *arg)
+{
+	struct ng_tcp_stream *stream = arg;
+	struct ng_tcp_shard *shard = &ng_stack->shards[stream->shard];
+	uint64_t now = rte_get_timer_cycles();
+	uint8_t retries;
+	uint32_t i;
+
+	if (stream->rto_expire == 0 ||
+			stream->status == NG_TCP_STATUS_CLOSED)
+		return;
+
+	if (now < stream->rto_expire) {
+		rte_timer_reset(timer, stream->rto_expire - now, SINGLE,
+			rte_lcore_id(), ng_tcp_rto_expire, stream);
+		return;
+	}
+	stream->rto_expire = 0;
+
+	/* window probe: nothing in flight, peer window closed */
+	if (ng_tcp_rtx_count(stream) == 0) {
+		stream->probe = 1;
+		ng_tcp_notify(stream, 0);
+		return;
+	}
+
+	retries = stream->status == NG_TCP_STATUS_SYN_SENT ||
+		stream->status == NG_TCP_STATUS_SYN_RCVD ?
+		NG_TCP_SYN_RETRIES : NG_TCP_MAX_RETRIES;
+	if (stream->backoff >= retries) {
+		ng_tcp_send_ctrl(shard, &stream->key, &stream->peer_mac,
+			RTE_TCP_RST_FLAG, stream->snd_nxt, 0, 0, NULL, 0);
+		ng_tcp_stream_closed(stream, ETIMEDOUT,
+			stream->status == NG_TCP_STATUS_SYN_RCVD ?
+			NG_TCP_F_CLOSED : 0);
+		return;
+	}
+
+	shard->stats.timeouts++;
+
+	/* RFC 5681 (4): only the first timeout of a series lowers ssthresh */
+	if (stream->backoff == 0 &&
+			stream->recovery != NG_TCP_RECOVERY_FAST)
+		stream->ssthresh = ng_stack->cc->ssthresh(stream);
+	stream->backoff++;
+	stream->cwnd = stream->mss;
+	stream->bytes_acked = 0;
+	stream->dupacks = 0;
+	stream->recovery = NG_TCP_RECOVERY_RTO;
+	stream->recover = stream->snd_nxt;
+	/* Karn: no sample from retransmitted segments */
+	stream->rtt_ts = 0;
+
+	for (i = stream->rtx_head; i != stream->rtx_tail; i++) {
+		struct ng_tcp_txseg *ts = ng_tcp_rtx_at(stream, i);
+
+		if ((ts->state & NG_TCP_SEG_SACKED) == 0)
+			ts->state = NG_TCP_SEG_LOST;
+	}
+
+	ng_tcp_notify(stream, 0);
+}
+
+/* Apply the SACK blocks of an ACK to the retransmission queue. */
+static void
+ng_tcp_sack_update(struct ng_tcp_stream *stream, const struct ng_tcp_opts *opts)
+{
+	uint8_t b;
+
+	for (b = 0; b < opts->nb_sack; b++) {
+		uint32_t left = opts->sack[b][0], right = opts->sack[b][1];
+		uint32_t i;
+
+		if (NG_SEQ_LEQ(right, left) ||
+				NG_SEQ_LEQ(right, stream->snd_una) ||
+				NG_SEQ_GT(right, stream->snd_nxt))
+			continue;
+
+		for (i = stream->rtx_head; i != stream->rtx_tail; i++) {
+			struct ng_tcp_txseg *ts = ng_tcp_rtx_at(stream, i);
+
+			if (NG_SEQ_GEQ(ts->seq, right))
+				break;
+			if (NG_SEQ_GEQ(ts->seq, left) &&
+					NG_SEQ_LEQ(ng_tcp_seg_end(ts), right))
+				ts->state |= NG_TCP_SEG_SACKED;
+		}
+	}
+}
+
+/*
+ * RFC 6675 IsLost(): a segment is lost once DupThresh segments above it
+ * were SACKed. Return the number of segments newly marked.
+ */
+static uint32_t
+ng_tcp_sack_mark_lost(struct ng_tcp_stream *stream)
+{
+	uint32_t i, sacked = 0, lost = 0;
+
+	for (i = stream->rtx_tail; i != stream->rtx_head; i--) {
+		struct ng_tcp_txseg *ts = ng_tcp_rtx_at(stream, i - 1);
+
+		if (ts->state & NG_TCP_SEG_SACKED) {
+			sacked++;
+		} else if (sacked >= NG_TCP_DUPTHRESH) {
+			if (ts->state & NG_TCP_SEG_LOST)
+				break;
+			ts->state |= NG_TCP_SEG_LOST;
+			lost++;
+		}
+	}
+
+	return lost;
+}
+
+static void
+ng_tcp_mark_head_lost(struct ng_tcp_stream *stream)
+{
+	struct ng_tcp_txseg *ts;
+
+	if (ng_tcp_rtx_count(stream) == 0)
+		return;
+
+	ts = ng_tcp_rtx_at(stream, stream->rtx_head);
+	if ((ts->state & (NG_TCP_SEG_SACKED | NG_TCP_SEG_LOST)) == 0)
+		ts->state |= NG_TCP_SEG_LOST;
+}
+
+/*
+ * Process the acknowledgment field: free acknowledged segments, sample
+ * the RTT, grow the congestion window and detect losses from duplicate
+ * ACKs or SACK blocks. Return 1 when everything sent was acknowledged.
+ */
+static int
+ng_tcp_handle_ack(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream,
+	const struct ng_tcp_seg *seg)
+{
+	uint32_t wnd = rte_be_to_cpu_16(seg->tcp->rx_win);
+	int wnd_update = wnd != stream->snd_wnd;
+	int kick = wnd > stream->snd_wnd;
+
+	if ((seg->flags & RTE_TCP_ACK_FLAG) == 0 ||
+			NG_SEQ_LT(seg->ack, stream->snd_una) ||
+			NG_SEQ_GT(seg->ack, stream->snd_nxt))
+		return stream->snd_una == stream->snd_nxt;
+
+	if (stream->sack_ok && seg->hlen > NG_TCP_HDR_LEN) {
+		struct ng_tcp_opts opts;
+
+		ng_tcp_parse_opts(seg, &opts);
+		ng_tcp_sack_update(stream, &opts);
+	}
+
+	stream->snd_wnd = wnd;
+
+	if (NG_SEQ_GT(seg->ack, stream->snd_una)) {
+		uint64_t now = rte_get_timer_cycles();
+		uint32_t acked = seg->ack - stream->snd_una;
+
+		if (stream->rtt_ts != 0 &&
+				NG_SEQ_GEQ(seg->ack, stream->rtt_seq)) {
+			ng_tcp_rtt_sample(stream, now - stream->rtt_ts);
+			stream->rtt_ts = 0;
+		}
+
+		while (stream->rtx_head != stream->rtx_tail) {
+			struct ng_tcp_txseg *ts = ng_tcp_rtx_at(stream,
+					stream->rtx_head);
+
+			if (NG_SEQ_GT(ng_tcp_seg_end(ts), seg->ack))
+				break;
+			rte_pktmbuf_free(ts->m);
+			stream->rtx_head++;
+		}
+
+		stream->snd_una = seg->ack;
+		stream->backoff = 0;
+
+		switch (stream->recovery) {
+		case NG_TCP_RECOVERY_FAST:
+			if (NG_SEQ_GEQ(seg->ack, stream->recover)) {
+				stream->recovery = NG_TCP_RECOVERY_NONE;
+				stream->cwnd = stream->ssthresh;
+				stream->dupacks = 0;
+			} else {
+				/*
+				 * Partial ACK, RFC 6582: the next hole is lost.
+				 * Besides the retransmission it acknowledges
+				 * segments the duplicate ACKs already counted.
+				 */
+				uint32_t segs = acked / stream->mss;
+
+				stream->dupacks -= RTE_MIN(stream->dupacks,
+					segs > 0 ? segs - 1 : 0);
+				ng_tcp_mark_head_lost(stream);
+			}
+			break;
+		case NG_TCP_RECOVERY_RTO:
+			if (NG_SEQ_GEQ(seg->ack, stream->recover))
+				stream->recovery = NG_TCP_RECOVERY_NONE;
+			/* fall-through */
+		default:
+			stream->dupacks = 0;
+			ng_stack->cc->on_ack(stream, acked, now);
+			break;
+		}
+
+		if (ng_tcp_rtx_count(stream) == 0)
+			ng_tcp_timer_stop(stream);
+		else
+			ng_tcp_timer_start(stream, now);
+		kick = 1;
+	} else if (seg->len == 0 && ng_tcp_rtx_count(stream) != 0 &&
+			(seg->flags & (RTE_TCP_SYN_FLAG |
+				RTE_TCP_FIN_FLAG)) == 0 && !wnd_update) {
+		if (stream->dupacks < UINT8_MAX)
+			stream->dupacks++;
+		kick = stream->recovery == NG_TCP_RECOVERY_FAST;
+	}
+
+	if (stream->sack_ok)
+		kick |= ng_tcp_sack_mark_lost(stream) != 0 &&
+			stream->recovery == NG_TCP_RECOVERY_FAST;
+
+	if (stream->recovery == NG_TCP_RECOVERY_NONE &&
+			ng_tcp_rtx_count(stream) != 0 &&
+			(stream->dupacks >= NG_TCP_DUPTHRESH ||
+			 (ng_tcp_rtx_at(stream, stream->rtx_head)->state &
+			  NG_TCP_SEG_LOST))) {
+		stream->ssthresh = ng_stack->cc->ssthresh(stream);
+		stream->cwnd = stream->ssthresh;
+		stream->bytes_acked = 0;
+		stream->recovery = NG_TCP_RECOVERY_FAST;
+		stream->recover = stream->snd_nxt;
+		ng_tcp_mark_head_lost(stream);
+		shard->stats.fast_recoveries++;
+		kick = 1;
+	}
+
+	/* something may be sent now */
+	if (kick && (stream->snd_next != NULL ||
+			!rte_ring_empty(stream->sndbuf) ||
+			stream->recovery != NG_TCP_RECOVERY_NONE ||
+			(__atomic_load_n(&stream->app_flags, __ATOMIC_RELAXED) &
+			 NG_TCP_F_CLOSED)))
+		ng_tcp_notify(stream, 0);
+
+	return stream->snd_una == stream->snd_nxt;
+}
+
+static int
+ng_tcp_handle_listen(struct ng_tcp_shard *shard, struct ng_tcp_stream *listener,
+	struct ng_tcp_seg *seg)
+{
+	struct ng_tcp_key key = {
+		.sip = seg->ip->src_addr,
+		.dip = seg->ip->dst_addr,
+		.sport = seg->tcp->src_port,
+		.dport = seg->tcp->dst_port,
+	};
+	struct ng_tcp_stream *syn;
+
+	if ((seg->flags & (RTE_TCP_SYN_FLAG | RTE_TCP_ACK_FLAG |
+			RTE_TCP_RST_FLAG)) != RTE_TCP_SYN_FLAG) {
+		ng_tcp_send_reset(shard, seg);
+		return -EINVAL;
+	}
+
+	if (rte_ring_count(listener->accept) >= listener->backlog) {
+		shard->stats.syn_drops++;
+		return -ENOBUFS;
+	}
+
+	syn = ng_tcp_stream_alloc(shard, &key, &seg->eth->s_addr);
+	if (syn == NULL) {
+		shard->stats.syn_drops++;
+		return -ENOMEM;
+	}
+
+	if (ng_tcp_stream_insert(shard, syn) != 0) {
+		rte_mempool_put(shard->streams, syn);
+		shard->stats.syn_drops++;
+		return -ENOSPC;
+	}
+
+	ng_tcp_syn_options(syn, seg);
+	syn->rcv_nxt = seg->seq + 1;
+	syn->listener = listener;
+	syn->status = NG_TCP_STATUS_SYN_RCVD;
+
+	ng_tcp_send_new(shard, syn, NULL, RTE_TCP_SYN_FLAG,
+		rte_get_timer_cycles());
+
+	return 0;
+}
+
+/* Hand in-order data to the application, mbufs unchanged. */
+static int
+ng_tcp_deliver(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream,
+	struct rte_mbuf *m, uint32_t len)
+{
+	if (rte_ring_sp_enqueue(stream->rcvbuf, m) != 0) {
+		rte_pktmbuf_free(m);
+		shard->stats.rx_drops++;
+		return 0;
+	}
+
+	stream->rcv_nxt += len;
+	ng_epoll_signal(&stream->ev, EPOLLIN);
+	return 1;
+}
+
+/* Deliver out of order blocks the receive point has reached. */
+static void
+ng_tcp_ooo_deliver(struct ng_tcp_stream *stream)
+{
+	while (stream->nb_ooo != 0 && stream->ooo[0].seq == stream->rcv_nxt) {
+		struct ng_tcp_ooo *b = &stream->ooo[0];
+
+		if (rte_ring_sp_enqueue(stream->rcvbuf, b->m) != 0)
+			return;
+		stream->rcv_nxt += b->len;
+		ng_epoll_signal(&stream->ev, EPOLLIN);
+
+		stream->nb_ooo--;
+		memmove(&stream->ooo[0], &stream->ooo[1],
+			stream->nb_ooo * sizeof(stream->ooo[0]));
+		stream->ooo_last = 0;
+	}
+}
+
+/*
+ * Keep a segment beyond rcv_nxt. Overlaps with the neighbours are cut off
+ * the new segment, which is then chained to an adjacent block or stored
+ * as a new one. Blocks are merged when the segment fills the gap between
+ * them.
+ */
+static void
+ng_tcp_ooo_insert(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream,
+	struct rte_mbuf *m, uint32_t seq, uint32_t len)
+{
+	struct ng_tcp_ooo *prev = NULL, *next = NULL;
+	uint32_t end = seq + len;
+	uint8_t i, pos;
+
+	for (pos = 0; pos < stream->nb_ooo; pos++)
+		if (NG_SEQ_GT(stream->ooo[pos].seq, seq))
+			break;
+	if (pos > 0)
+		prev = &stream->ooo[pos - 1];
+	if (pos < stream->nb_ooo)
+		next = &stream->ooo[pos];
+
+	if (prev != NULL && NG_SEQ_GT(prev->seq + prev->len, seq)) {
+		uint32_t cut = prev->seq + prev->len - seq;
+
+		if (cut >= len)
+			goto drop;
+		rte_pktmbuf_adj(m, cut);
+		seq += cut;
+		len -= cut;
+	}
+	if (next != NULL && NG_SEQ_GT(end, next->seq)) {
+		uint32_t cut = end - next->seq;
+
+		if (cut >= len)
+			goto drop;
+		rte_pktmbuf_trim(m, cut);
+		end -= cut;
+		len -= cut;
+	}
+
+	if (prev != NULL && prev->seq + prev->len == seq) {
+		if (rte_pktmbuf_chain(prev->m, m) != 0)
+			goto drop;
+		prev->len += len;
+		stream->ooo_last = pos - 1;
+
+		if (next != NULL && end == next->seq &&
+				rte_pktmbuf_chain(prev->m, next->m) == 0) {
+			prev->len += next->len;
+			stream->nb_ooo--;
+			memmove(next, next + 1,
+				(stream->nb_ooo - pos) * sizeof(*next));
+		}
+		return;
+	}
+
+	if (next != NULL && end == next->seq) {
+		if (rte_pktmbuf_chain(m, next->m) != 0)
+			goto drop;
+		next->m = m;
+		next->seq = seq;
+		next->len += len;
+		stream->ooo_last = pos;
+		return;
+	}
+
+	if (stream->nb_ooo == NG_TCP_OOO_BLOCKS)
+		goto drop;
+
+	for (i = stream->nb_ooo; i > pos; i--)
+		stream->ooo[i] = stream->ooo[i - 1];
+	stream->ooo[pos].m = m;
+	stream->ooo[pos].seq = seq;
+	stream->ooo[pos].len = len;
+	stream->ooo_last = pos;
+	stream->nb_ooo++;
+	return;
+
+drop:
+	rte_pktmbuf_free(m);
+	shard->stats.rx_drops++;
+}
+
+/*
+ * Accept payload. Data is handed to the application without copy: the
+ * mbuf is trimmed to the payload and put on the receive ring. Segments
+ * beyond rcv_nxt go to the out of order queue and are acknowledged at
+ * once, with SACK blocks when negotiated, so the sender sees duplicate
+ * ACKs. Return 1 if the segment reached its final sequence number, i.e.
+ * a FIN it carries can be processed.
+ */
+static int
+ng_tcp_enqueue_recvbuffer(struct ng_tcp_shard *shard,
+	struct ng_tcp_stream *stream, struct ng_tcp_seg *seg, int deliver)
+{
+	struct rte_mbuf *m = seg->m;
+	uint32_t seq = seg->seq, len = seg->len;
+
+	seg->m = NULL;
+
+	if (len == 0) {
+		rte_pktmbuf_free(m);
+		return seq == stream->rcv_nxt;
+	}
+
+	/* blocks left behind by a full receive ring */
+	ng_tcp_ooo_deliver(stream);
+
+	rte_pktmbuf_adj(m, seg->hlen);
+	rte_pktmbuf_trim(m, rte_pktmbuf_pkt_len(m) - len);
+
+	/* keep only what was not received yet */
+	if (NG_SEQ_LT(seq, stream->rcv_nxt)) {
+		uint32_t cut = stream->rcv_nxt - seq;
+
+		if (cut >= len) {
+			rte_pktmbuf_free(m);
+			ng_tcp_ack_later(shard, stream);
+			return seq + len == stream->rcv_nxt;
+		}
+		rte_pktmbuf_adj(m, cut);
+		seq += cut;
+		len -= cut;
+	}
+
+	if (seq != stream->rcv_nxt) {
+		if (deliver &&
+				seq - stream->rcv_nxt < ng_tcp_rcv_wnd(stream)) {
+			ng_tcp_ooo_insert(shard, stream, m, seq, len);
+			shard->stats.ooo_segs++;
+		} else {
+			rte_pktmbuf_free(m);
+			shard->stats.rx_drops++;
+		}
+		ng_tcp_send_ack(shard, stream);
+		return 0;
+	}
+
+	ng_tcp_ack_later(shard, stream);
+
+	if (!deliver) {
+		rte_pktmbuf_free(m);
+		stream->rcv_nxt += len;
+		return 1;
+	}
+
+	if (stream->nb_ooo != 0 &&
+			NG_SEQ_GT(seq + len, stream->ooo[0].seq)) {
+		uint32_t cut = seq + len - stream->ooo[0].seq;
+
+		/* the receive ring is still full */
+		if (cut >= len) {
+			rte_pktmbuf_free(m);
+			shard->stats.rx_drops++;
+			return 0;
+		}
+		rte_pktmbuf_trim(m, cut);
+		len -= cut;
+	}
+
+	if (!ng_tcp_deliver(shard, stream, m, len))
+		return 0;
+
+	ng_tcp_ooo_deliver(stream);
+	return seg->seq + seg->len == stream->rcv_nxt;
+}
+
+static int
+ng_tcp_handle_syn_sent(struct ng_tcp_shard *shard,
+	struct ng_tcp_stream *stream, struct ng_tcp_seg *seg)
+{
+	if ((seg->flags & RTE_TCP_ACK_FLAG) && seg->ack != stream->snd_nxt) {
+		ng_tcp_send_reset(shard, seg);
+		return -EINVAL;
+	}
+
+	if (seg->flags & RTE_TCP_RST_FLAG) {
+		if (seg->flags & RTE_TCP_ACK_FLAG)
+			ng_tcp_stream_closed(stream, ECONNREFUSED, 0);
+		return 0;
+	}
+
+	/* simultaneous open is not supported */
+	if ((seg->flags & (RTE_TCP_SYN_FLAG | RTE_TCP_ACK_FLAG)) !=
+			(RTE_TCP_SYN_FLAG | RTE_TCP_ACK_FLAG))
+		return -EINVAL;
+
+	ng_tcp_syn_options(stream, seg);
+	rte_ether_addr_copy(&seg->eth->s_addr, &stream->peer_mac);
+	stream->rcv_nxt = seg->seq + 1;
+	stream->status = NG_TCP_STATUS_ESTABLISHED;
+	ng_tcp_handle_ack(shard, stream, seg);
+	ng_tcp_ack_later(shard, stream);
+
+	/* data queued before the handshake completed */
+	ng_tcp_notify(stream, 0);
+	ng_epoll_signal(&stream->ev, EPOLLOUT);
+
+	return 1;
+}
+
+static int
+ng_tcp_handle_syn_rcvd(struct ng_tcp_shard *shard,
+	struct ng_tcp_stream *stream, struct ng_tcp_seg *seg)
+{
+	struct ng_tcp_stream *listener = stream->listener;
+
+	if (seg->flags & RTE_TCP_SYN_FLAG) {
+		/* our SYN-ACK was lost, send it again */
+		ng_tcp_xmit(shard, stream,
+			ng_tcp_rtx_at(stream, stream->rtx_head));
+		return 0;
+	}
+
+	if ((seg->flags & RTE_TCP_ACK_FLAG) == 0 ||
+			seg->ack != stream->snd_nxt)
+		return -EINVAL;
+
+	ng_tcp_handle_ack(shard, stream, seg);
+	stream->status = NG_TCP_STATUS_ESTABLISHED;
+	stream->listener = NULL;
+
+	if (__atomic_load_n(&listener->status, __ATOMIC_ACQUIRE) !=
+			NG_TCP_STATUS_LISTEN ||
+			rte_ring_mp_enqueue(listener->accept, stream) != 0) {
+		ng_tcp_send_ctrl(shard, &stream->key, &stream->peer_mac,
+			RTE_TCP_RST_FLAG, stream->snd_nxt, 0, 0, NULL, 0);
+		/* never seen by the application, release it right away */
+		ng_tcp_stream_closed(stream, ECONNRESET, NG_TCP_F_CLOSED);
+		return -ENOBUFS;
+	}
+	ng_epoll_signal(&listener->ev, EPOLLIN);
+
+	return 1;
+}
+
+static int
+ng_tcp_handle_established(struct ng_tcp_shard *shard,
+	struct ng_tcp_stream *stream, struct ng_tcp_seg *seg)
+{
+	uint32_t fin_seq = seg->seq + seg->len;
+
+	ng_tcp_handle_ack(shard, stream, seg);
+
+	if (!ng_tcp_enqueue_recvbuffer(shard, stream, seg, 1) ||
+			(seg->flags & RTE_TCP_FIN_FLAG) == 0 ||
+			fin_seq != stream->rcv_nxt)
+		return 0;
+
+	/* FIN: no more data, wake up the reader */
+	stream->rcv_nxt++;
+	stream->status = NG_TCP_STATUS_CLOSE_WAIT;
+	__atomic_store_n(&stream->rcv_eof, 1, __ATOMIC_RELEASE);
+	ng_epoll_signal(&stream->ev, EPOLLIN | EPOLLRDHUP);
+	ng_tcp_ack_later(shard, stream);
+
+	return 0;
+}
+
+static int
+ng_tcp_handle_close_wait(struct ng_tcp_shard *shard,
+	struct ng_tcp_stream *stream, struct ng_tcp_seg *seg)
+{
+	ng_tcp_handle_ack(shard, stream, seg);
+
+	/* retransmitted FIN or data */
+	if (seg->len != 0 || (seg->flags & RTE_TCP_FIN_FLAG))
+		ng_tcp_ack_later(shard, stream);
+
+	rte_pktmbuf_free(seg->m);
+	seg->m = NULL;
+
+	return 0;
+}
+
+static int
+ng_tcp_handle_last_ack(struct ng_tcp_shard *shard,
+	struct ng_tcp_stream *stream, struct ng_tcp_seg *seg)
+{
+	if (ng_tcp_handle_ack(shard, stream, seg))
+		ng_tcp_stream_closed(stream, 0, 0);
+
+	return 0;
+}
+
+/*
+ * Active close: FIN_WAIT_1, FIN_WAIT_2 and CLOSING. The application
+ * already closed the socket, so in-order data is acknowledged and dropped.
+ * TIME_WAIT is not kept, the connection is released when the peer's FIN
+ * has been acknowledged.
+ */
+static int
+ng_tcp_handle_fin_wait(struct ng_tcp_shard *shard,
+	struct ng_tcp_stream *stream, struct ng_tcp_seg *seg)
+{
+	uint32_t fin_seq = seg->seq + seg->len;
+	int fin_acked = ng_tcp_handle_ack(shard, stream, seg);
+	int fin_rcvd = 0;
+
+	if (stream->status != NG_TCP_STATUS_CLOSING &&
+			ng_tcp_enqueue_recvbuffer(shard, stream, seg, 0) &&
+			(seg->flags & RTE_TCP_FIN_FLAG) &&
+			fin_seq == stream->rcv_nxt) {
+		stream->rcv_nxt++;
+		ng_tcp_ack_later(shard, stream);
+		fin_rcvd = 1;
+	}
+
+	if (seg->m != NULL) {
+		rte_pktmbuf_free(seg->m);
+		seg->m = NULL;
+	}
+
+	switch (stream->status) {
+	case NG_TCP_STATUS_FIN_WAIT_1:
+		if (fin_rcvd && fin_acked)
+			ng_tcp_stream_closed(stream, 0, 0);
+		else if (fin_rcvd)
+			stream->status = NG_TCP_STATUS_CLOSING;
+		else if (fin_acked)
+			stream->status = NG_TCP_STATUS_FIN_WAIT_2;
+		break;
+	case NG_TCP_STATUS_FIN_WAIT_2:
+		if (fin_rcvd)
+			ng_tcp_stream_closed(stream, 0, 0);
+		break;
+	case NG_TCP_STATUS_CLOSING:
+		if (fin_acked)
+			ng_tcp_stream_closed(stream, 0, 0);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static int
+ng_tcp_process(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream,
+	struct ng_tcp_seg *seg)
+{
+	int ret = 0;
+
+	if (stream == NULL) {
+		struct ng_tcp_stream *listener = ng_tcp_listener_get(
+				seg->ip->dst_addr, seg->tcp->dst_port);
+
+		if (listener != NULL)
+			ret = ng_tcp_handle_listen(shard, listener, seg);
+		else
+			ng_tcp_send_reset(shard, seg);
+		rte_pktmbuf_free(seg->m);
+		return listener != NULL && ret == 0;
+	}
+
+	if (stream->status == NG_TCP_STATUS_SYN_SENT) {
+		ret = ng_tcp_handle_syn_sent(shard, stream, seg);
+		rte_pktmbuf_free(seg->m);
+		return ret >= 0;
+	}
+
+	if (seg->flags & RTE_TCP_RST_FLAG) {
+		if (stream->status != NG_TCP_STATUS_CLOSED &&
+				NG_SEQ_GEQ(seg->seq, stream->rcv_nxt) &&
+				NG_SEQ_LT(seg->seq,
+					stream->rcv_nxt + NG_TCP_MAX_WIN))
+			ng_tcp_stream_closed(stream, ECONNRESET,
+				stream->status == NG_TCP_STATUS_SYN_RCVD ?
+				NG_TCP_F_CLOSED : 0);
+		rte_pktmbuf_free(seg->m);
+		return 1;
+	}
+
+	switch (stream->status) {
+	case NG_TCP_STATUS_SYN_RCVD:
+		ret = ng_tcp_handle_syn_rcvd(shard, stream, seg);
+		if (ret <= 0)
+			break;
+		/* the ACK may carry data or a FIN */
+		ret = ng_tcp_handle_established(shard, stream, seg);
+		break;
+
+	case NG_TCP_STATUS_ESTABLISHED:
+		ret = ng_tcp_handle_established(shard, stream, seg);
+		break;
+
+	case NG_TCP_STATUS_CLOSE_WAIT:
+		ret = ng_tcp_handle_close_wait(shard, stream, seg);
+		break;
+
+	case NG_TCP_STATUS_LAST_ACK:
+		ret = ng_tcp_handle_last_ack(shard, stream, seg);
+		break;
+
+	case NG_TCP_STATUS_FIN_WAIT_1:
+	case NG_TCP_STATUS_FIN_WAIT_2:
+	case NG_TCP_STATUS_CLOSING:
+		ret = ng_tcp_handle_fin_wait(shard, stream, seg);
+		break;
+
+	default:
+		/* CLOSED, waiting for the application to close */
+		ret = -EINVAL;
+		break;
+	}
+
+	if (seg->m != NULL)
+		rte_pktmbuf_free(seg->m);
+
+	return ret >= 0;
+}
+
+uint16_t
+ng_tcp_input_burst(uint16_t id, struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	struct ng_tcp_shard *shard = &ng_stack->shards[id];
+	struct ng_tcp_seg segs[NG_TCP_BURST];
+	struct ng_tcp_key keys[NG_TCP_BURST];
+	const void *key_ptrs[NG_TCP_BURST];
+	void *data[NG_TCP_BURST];
+	uint16_t done, delivered = 0;
+
+	shard->stats.rx_pkts += nb_pkts;
+
+	for (done = 0; done < nb_pkts; ) {
+		uint16_t n = RTE_MIN(nb_pkts - done, NG_TCP_BURST);
+		uint32_t nb_streams = shard->stats.streams;
+		uint64_t hits = 0;
+		uint16_t i, nb = 0;
+
+		for (i = 0; i < n; i++) {
+			struct rte_mbuf *m = pkts[done + i];
+
+			if (ng_tcp_parse(m, &segs[nb]) != 0) {
+				rte_pktmbuf_free(m);
+				shard->stats.rx_drops++;
+				continue;
+			}
+
+			keys[nb].sip = segs[nb].ip->src_addr;
+			keys[nb].dip = segs[nb].ip->dst_addr;
+			keys[nb].sport = segs[nb].tcp->src_port;
+			keys[nb].dport = segs[nb].tcp->dst_port;
+			key_ptrs[nb] = &keys[nb];
+			nb++;
+		}
+		done += n;
+
+		if (nb == 0)
+			continue;
+
+		rte_hash_lookup_bulk_data(shard->table, key_ptrs, nb,
+			&hits, data);
+
+		for (i = 0; i < nb; i++) {
+			if (hits & (1ULL << i))
+				rte_prefetch0(data[i]);
+			else
+				data[i] = NULL;
+		}
+
+		for (i = 0; i < nb; i++) {
+			struct ng_tcp_stream *stream = data[i];
+
+			/* created by a SYN earlier in this burst */
+			if (stream == NULL &&
+					shard->stats.streams != nb_streams &&
+					rte_hash_lookup_data(shard->table,
+						&keys[i], &data[i]) >= 0)
+				stream = data[i];
+
+			if (ng_tcp_process(shard, stream, &segs[i]))
+				delivered++;
+			else
+				shard->stats.rx_drops++;
+		}
+
+		ng_tcp_flush_acks(shard);
+	}
+
+	return delivered;
+}
+
+/* Active open requested by ng_tcp_connect(): enter the table, send SYN. */
+static int
+ng_tcp_stream_connect(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream,
+	uint64_t now)
+{
+	int ret;
+
+	ret = ng_tcp_stream_insert(shard, stream);
+	if (ret != 0) {
+		ng_tcp_stream_set_closed(stream, -ret);
+		return ret;
+	}
+
+	ng_tcp_send_new(shard, stream, NULL, RTE_TCP_SYN_FLAG, now);
+	return 0;
+}
+
+/*
+ * Send what congestion control allows: segments marked lost first, then
+ * data queued by the application within min(cwnd, peer window), then the
+ * FIN once the send ring is drained after the application closed.
+ */
+static void
+ng_tcp_stream_output(struct ng_tcp_shard *shard, struct ng_tcp_stream *stream)
+{
+	uint64_t now = rte_get_timer_cycles();
+	uint32_t flags, pipe, i;
+	int blocked = 0, room = 0;
+
+	flags = __atomic_fetch_and(&stream->app_flags,
+			~(NG_TCP_F_TX_PENDING | NG_TCP_F_CONNECT),
+			__ATOMIC_ACQ_REL);
+
+	if (flags & NG_TCP_F_CONNECT)
+		ng_tcp_stream_connect(shard, stream, now);
+
+	if ((flags & NG_TCP_F_CLOSED) &&
+			stream->status == NG_TCP_STATUS_SYN_SENT)
+		ng_tcp_stream_set_closed(stream, ECONNABORTED);
+
+	if (stream->status == NG_TCP_STATUS_CLOSED) {
+		struct rte_mbuf *m;
+
+		while (rte_ring_sc_dequeue(stream->sndbuf, (void **)&m) == 0)
+			rte_pktmbuf_free(m);
+
+		if (flags & NG_TCP_F_CLOSED)
+			ng_tcp_stream_release(shard, stream);
+		return;
+	}
+
+	pipe = ng_tcp_pipe(stream);
+
+	for (i = stream->rtx_head; i != stream->rtx_tail; i++) {
+		struct ng_tcp_txseg *ts = ng_tcp_rtx_at(stream, i);
+		uint32_t len = ng_tcp_seg_end(ts) - ts->seq;
+
+		if ((ts->state & (NG_TCP_SEG_SACKED | NG_TCP_SEG_LOST |
+				NG_TCP_SEG_RETRANS)) != NG_TCP_SEG_LOST)
+			continue;
+		/* the first hole goes out regardless of pipe (RFC 6675) */
+		if (pipe != 0 && pipe + len > stream->cwnd &&
+				i != stream->rtx_head)
+			break;
+		if (ng_tcp_xmit(shard, stream, ts) != 0) {
+			blocked = 1;
+			break;
+		}
+
+		ts->state |= NG_TCP_SEG_RETRANS;
+		pipe += len;
+		stream->rtt_ts = 0;
+		shard->stats.retransmits++;
+		if (stream->rto_expire == 0)
+			ng_tcp_timer_start(stream, now);
+	}
+
+	if (stream->status != NG_TCP_STATUS_ESTABLISHED &&
+			stream->status != NG_TCP_STATUS_CLOSE_WAIT)
+		goto out;
+
+	while (!blocked) {
+		struct rte_mbuf *m = stream->snd_next;
+		uint32_t len;
+
+		if (m == NULL) {
+			if (rte_ring_sc_dequeue(stream->sndbuf,
+					(void **)&m) != 0)
+				break;
+			room = 1;
+		}
+		stream->snd_next = m;
+		len = rte_pktmbuf_pkt_len(m);
+
+		if (ng_tcp_rtx_count(stream) > stream->rtx_mask)
+			break;
+
+		if (!stream->probe &&
+				(pipe + len > stream->cwnd ||
+				 NG_SEQ_GT(stream->snd_nxt + len,
+					 stream->snd_una + stream->snd_wnd))) {
+			/* closed peer window, probe it from the timer */
+			if (ng_tcp_rtx_count(stream) == 0 &&
+					stream->rto_expire == 0)
+				ng_tcp_timer_start(stream, now);
+			break;
+		}
+
+		if (shard->nb_txq == NG_TCP_TXQ_SIZE) {
+			blocked = 1;
+			break;
+		}
+
+		stream->snd_next = NULL;
+		stream->probe = 0;
+		ng_tcp_send_new(shard, stream, m, 0, now);
+		pipe += len;
+	}
+
+	if (stream->snd_next != NULL || !rte_ring_empty(stream->sndbuf) ||
+			(flags & NG_TCP_F_CLOSED) == 0 ||
+			ng_tcp_rtx_count(stream) > stream->rtx_mask)
+		goto out;
+
+	if (shard->nb_txq == NG_TCP_TXQ_SIZE) {
+		blocked = 1;
+		goto out;
+	}
+
+	ng_tcp_send_new(shard, stream, NULL, RTE_TCP_FIN_FLAG, now);
+	stream->status = stream->status == NG_TCP_STATUS_ESTABLISHED ?
+		NG_TCP_STATUS_FIN_WAIT_1 : NG_TCP_STATUS_LAST_ACK;
+	__atomic_store_n(&stream->snd_shut, 1, __ATOMIC_RELEASE);
+
+out:
+	if (room)
+		ng_epoll_signal(&stream->ev, EPOLLOUT);
+	if (blocked)
+		ng_tcp_notify(stream, 0);
+}
+
+static uint16_t
+ng_tcp_txq_drain(struct ng_tcp_shard *shard, struct rte_mbuf **pkts,
+	uint16_t nb_pkts)
+{
+	uint16_t n = RTE_MIN(nb_pkts, shard->nb_txq);
+
+	if (n == 0)
+		return 0;
+
+	memcpy(pkts, shard->txq, n * sizeof(pkts[0]));
+	shard->nb_txq -= n;
+	memmove(shard->txq, shard->txq + n, shard->nb_txq * sizeof(pkts[0]));
+
+	return n;
+}
+
+uint16_t
+ng_tcp_output_burst(uint16_t id, struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	struct ng_tcp_shard *shard = &ng_stack->shards[id];
+	struct ng_tcp_stream *streams[NG_TCP_BURST];
+	unsigned int todo;
+	uint16_t n;
+
+	/* streams notified again while walking are left for the next call */
+	todo = rte_ring_count(shard->notify);
+
+	while (todo != 0 && shard->nb_txq < nb_pkts) {
+		unsigned int i, nb;
+
+		nb = rte_ring_sc_dequeue_burst(shard->notify, (void **)streams,
+				RTE_MIN(todo, (unsigned int)NG_TCP_BURST),
+				NULL);
+		if (nb == 0)
+			break;
+		todo -= nb;
+
+		for (i = 0; i < nb; i++)
+			ng_tcp_stream_output(shard, streams[i]);
+	}
+
+	n = ng_tcp_txq_drain(shard, pkts, nb_pkts);
+	shard->stats.tx_pkts += n;
+	return n;
+}
+
+int
+ng_tcp_stats_get(uint16_t id, struct ng_tcp_stats *stats)
+{
+	if (ng_stack == NULL || id >= ng_stack->conf.nb_shards ||
+			stats == NULL)
+		return -EINVAL;
+
+	*stats = ng_stack->shards[id].stats;
+	return 0;
+}
+
+static void
+ng_tcp_stack_free(void)
+{
+	uint16_t i;
+
+	for (i = 0; i < NG_TCP_MAX_SHARDS; i++) {
+		struct ng_tcp_shard *shard = &ng_stack->shards[i];
+
+		rte_hash_free(shard->table);
+		rte_mempool_free(shard->streams);
+		rte_ring_free(shard->notify);
+	}
+
+	rte_free(ng_stack);
+	ng_stack = NULL;
+}
+
+int
+ng_tcp_stack_init(const struct ng_tcp_conf *conf)
+{
+	char name[RTE_MEMZONE_NAMESIZE];
+	uint32_t elt_size;
+	ssize_t ring_size;
+	uint16_t i;
+
+	if (ng_stack != NULL)
+		return -EEXIST;
+
+	if (conf == NULL || conf->pool == NULL || conf->nb_shards == 0 ||
+			conf->nb_shards > NG_TCP_MAX_SHARDS ||
+			conf->max_streams == 0 ||
+			conf->cc >= RTE_DIM(ng_tcp_cc))
+		return -EINVAL;
+
+	ring_size = rte_ring_get_memsize(conf->ring_size);
+	if (ring_size < 0)
+		return -EINVAL;
+
+	ng_stack = rte_zmalloc_socket("ng_tcp_stack", sizeof(*ng_stack),
+			RTE_CACHE_LINE_SIZE, conf->socket_id);
+	if (ng_stack == NULL)
+		return -ENOMEM;
+
+	ng_stack->conf = *conf;
+	ng_stack->cc = &ng_tcp_cc[conf->cc];
+	ng_stack->hz = rte_get_timer_hz();
+	ng_stack->rto_min = ng_stack->hz * (conf->rto_min_ms != 0 ?
+		conf->rto_min_ms : NG_TCP_RTO_MIN_MS) / 1000;
+	ng_stack->rto_max = ng_stack->hz * NG_TCP_RTO_MAX_MS / 1000;
+	ng_stack->next_port = rte_rand();
+
+	/*
+	 * Stream, its two rings and its retransmission queue in one mempool
+	 * object. The queue holds twice the send ring, as data stays there
+	 * until acknowledged.
+	 */
+	elt_size = sizeof(struct ng_tcp_stream) + 2 * ring_size +
+		2 * conf->ring_size * sizeof(struct ng_tcp_txseg);
+
+	for (i = 0; i < conf->nb_shards; i++) {
+		struct ng_tcp_shard *shard = &ng_stack->shards[i];
+		struct rte_hash_parameters params = {
+			.name = name,
+			.entries = conf->max_streams,
+			.key_len = sizeof(struct ng_tcp_key),
+			.hash_func = rte_hash_crc,
+			.hash_func_init_val = 0,
+			.socket_id = conf->socket_id,
+		};
+
+		shard->id = i;
+
+		snprintf(name, sizeof(name), "ng_tcp_table_%u", i);
+		shard->table = rte_hash_create(&params);
+		if (shard->table == NULL)
+			goto fail;
+
+		snprintf(name, sizeof(name), "ng_tcp_streams_%u", i);
+		/* ng_tcp_connect() allocates from application threads */
+		shard->streams = rte_mempool_create(name, conf->max_streams,
+				elt_size, 0, 0, NULL, NULL, NULL, NULL,
+				conf->socket_id, MEMPOOL_F_SP_PUT);
+		if (shard->streams == NULL)
+			goto fail;
+
+		snprintf(name, sizeof(name), "ng_tcp_notify_%u", i);
+		shard->notify = rte_ring_create(name,
+				rte_align32pow2(conf->max_streams + 1),
+				conf->socket_id, RING_F_SC_DEQ);
+		if (shard->notify == NULL)
+			goto fail;
+	}
+
+	return 0;
+
+fail:
+	ng_tcp_stack_free();
+	return -rte_errno;
+}
+
+struct ng_tcp_stream *
+ng_tcp_socket(void)
+{
+	struct ng_tcp_stream *stream;
+
+	stream = rte_zmalloc("ng_tcp_stream", sizeof(*stream),
+			RTE_CACHE_LINE_SIZE);
+	if (stream == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	stream->shard = NG_TCP_NO_SHARD;
+	stream->status = NG_TCP_STATUS_CLOSED;
+
+	return stream;
+}
+
+int
+ng_tcp_bind(struct ng_tcp_stream *stream, uint32_t ip, uint16_t port)
+{
+	if (stream->shard != NG_TCP_NO_SHARD ||
+			stream->status != NG_TCP_STATUS_CLOSED)
+		return -EINVAL;
+
+	stream->key.dip = ip;
+	stream->key.dport = port;
+
+	return 0;
+}
+
+int
+ng_tcp_listen(struct ng_tcp_stream *stream, unsigned int backlog)
+{
+	uint16_t port = rte_be_to_cpu_16(stream->key.dport);
+	struct ng_tcp_stream *expected = NULL;
+	char name[RTE_RING_NAMESIZE];
+
+	if (stream->shard != NG_TCP_NO_SHARD ||
+			stream->status != NG_TCP_STATUS_CLOSED || port == 0)
+		return -EINVAL;
+
+	if (backlog == 0)
+		backlog = NG_TCP_DEFAULT_BACKLOG;
+
+	snprintf(name, sizeof(name), "ng_tcp_accept_%u", port);
+	stream->accept = rte_ring_create(name, rte_align32pow2(backlog + 1),
+			ng_stack->conf.socket_id, RING_F_SC_DEQ);
+	if (stream->accept == NULL)
+		return -rte_errno;
+
+	stream->backlog = backlog;
+	stream->status = NG_TCP_STATUS_LISTEN;
+
+	if (!__atomic_compare_exchange_n(&ng_stack->listeners[port], &expected,
+			stream, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+		stream->status = NG_TCP_STATUS_CLOSED;
+		rte_ring_free(stream->accept);
+		stream->accept = NULL;
+		return -EADDRINUSE;
+	}
+
+	return 0;
+}
+
+struct ng_tcp_stream *
+ng_tcp_accept(struct ng_tcp_stream *listener)
+{
+	struct ng_tcp_stream *stream;
+
+	if (listener->status != NG_TCP_STATUS_LISTEN) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	if (rte_ring_sc_dequeue(listener->accept, (void **)&stream) != 0) {
+		rte_errno = EAGAIN;
+		return NULL;
+	}
+
+	return stream;
+}
+
+struct ng_tcp_stream *
+ng_tcp_connect(uint32_t ip, uint16_t port,
+	const struct rte_ether_addr *next_hop)
+{
+	struct ng_tcp_stream *stream;
+	struct ng_tcp_shard *shard;
+	struct ng_tcp_key key;
+	uint32_t local_port;
+
+	if (ng_stack->conf.nb_shards > 1 && ng_stack->conf.rss_key == NULL) {
+		rte_errno = ENOTSUP;
+		return NULL;
+	}
+
+	local_port = __atomic_fetch_add(&ng_stack->next_port, 1,
+			__ATOMIC_RELAXED);
+	local_port = NG_TCP_EPHEMERAL_BASE +
+		local_port % (UINT16_MAX + 1 - NG_TCP_EPHEMERAL_BASE);
+
+	key.sip = ip;
+	key.dip = ng_stack->conf.local_ip;
+	key.sport = port;
+	key.dport = rte_cpu_to_be_16(local_port);
+
+	shard = &ng_stack->shards[ng_tcp_shard_of(&key)];
+	stream = ng_tcp_stream_alloc(shard, &key, next_hop);
+	if (stream == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+	stream->status = NG_TCP_STATUS_SYN_SENT;
+
+	/* the owning shard adds it to its table and sends the SYN */
+	ng_tcp_notify(stream, NG_TCP_F_CONNECT);
+	return stream;
+}
+
+void
+ng_tcp_peer(const struct ng_tcp_stream *stream, uint32_t *ip, uint16_t *port)
+{
+	*ip = stream->key.sip;
+	*port = stream->key.sport;
+}
+
+ssize_t
+ng_tcp_send(struct ng_tcp_stream *stream, const void *buf, size_t len)
+{
+	struct rte_mbuf *pkts[NG_TCP_BURST];
+	size_t sent = 0;
+
+	if (stream->shard == NG_TCP_NO_SHARD)
+		return -EPIPE;
+	if (__atomic_load_n(&stream->snd_shut, __ATOMIC_ACQUIRE))
+		return stream->error != 0 ? -stream->error : -EPIPE;
+
+	while (sent < len) {
+		unsigned int nb, i;
+
+		nb = RTE_MIN(rte_ring_free_count(stream->sndbuf),
+			(len - sent + NG_TCP_MSS - 1) / NG_TCP_MSS);
+		nb = RTE_MIN(nb, (unsigned int)NG_TCP_BURST);
+		if (nb == 0 ||
+				rte_pktmbuf_alloc_bulk(ng_stack->conf.pool,
+					pkts, nb) != 0)
+			break;
+
+		for (i = 0; i < nb; i++) {
+			uint16_t chunk = RTE_MIN(len - sent,
+					(size_t)NG_TCP_MSS);
+
+			rte_memcpy(rte_pktmbuf_append(pkts[i], chunk),
+				(const uint8_t *)buf + sent, chunk);
+			sent += chunk;
+		}
+
+		/* single producer, the free count above cannot shrink */
+		rte_ring_sp_enqueue_bulk(stream->sndbuf, (void **)pkts, nb,
+			NULL);
+	}
+
+	if (sent == 0)
+		return -EAGAIN;
+
+	ng_tcp_notify(stream, 0);
+	return sent;
+}
+
+ssize_t
+ng_tcp_recv(struct ng_tcp_stream *stream, void *buf, size_t len)
+{
+	uint32_t eof;
+	size_t copied = 0;
+
+	if (stream->shard == NG_TCP_NO_SHARD)
+		return -ENOTCONN;
+
+	/* everything received before the FIN is on the ring by now */
+	eof = __atomic_load_n(&stream->rcv_eof, __ATOMIC_ACQUIRE);
+
+	while (copied < len) {
+		struct rte_mbuf *m = stream->rcv_head;
+		const void *p;
+		uint32_t n;
+
+		if (m == NULL) {
+			if (rte_ring_sc_dequeue(stream->rcvbuf,
+					(void **)&m) != 0)
+				break;
+			stream->rcv_head = m;
+			stream->rcv_off = 0;
+		}
+
+		n = RTE_MIN(len - copied,
+			(size_t)(rte_pktmbuf_pkt_len(m) - stream->rcv_off));
+		p = rte_pktmbuf_read(m, stream->rcv_off, n,
+			(uint8_t *)buf + copied);
+		if (p != (uint8_t *)buf + copied)
+			rte_memcpy((uint8_t *)buf + copied, p, n);
+
+		copied += n;
+		stream->rcv_off += n;
+		if (stream->rcv_off == rte_pktmbuf_pkt_len(m)) {
+			rte_pktmbuf_free(m);
+			stream->rcv_head = NULL;
+		}
+	}
+
+	if (copied != 0)
+		return copied;
+
+	if (!eof)
+		return -EAGAIN;
+	return stream->error != 0 ? -stream->error : 0;
+}
+
+struct ng_epoll_source *
+ng_tcp_epoll_source(struct ng_tcp_stream *stream)
+{
+	return &stream->ev;
+}
+
+uint32_t
+ng_tcp_poll(const struct ng_tcp_stream *stream)
+{
+	NG_TCP_STATUS status = __atomic_load_n(&stream->status,
+			__ATOMIC_ACQUIRE);
+	uint32_t events = 0;
+
+	if (stream->shard == NG_TCP_NO_SHARD) {
+		if (status != NG_TCP_STATUS_LISTEN)
+			return EPOLLHUP;
+		return rte_ring_empty(stream->accept) ? 0 : EPOLLIN;
+	}
+
+	if (__atomic_load_n(&stream->rcv_eof, __ATOMIC_ACQUIRE)) {
+		events |= EPOLLIN | EPOLLRDHUP;
+		if (stream->error != 0)
+			events |= EPOLLERR;
+	} else if (stream->rcv_head != NULL ||
+			!rte_ring_empty(stream->rcvbuf)) {
+		events |= EPOLLIN;
+	}
+
+	if (__atomic_load_n(&stream->snd_shut, __ATOMIC_ACQUIRE)) {
+		if (events & EPOLLRDHUP)
+			events |= EPOLLHUP;
+	} else if ((status == NG_TCP_STATUS_ESTABLISHED ||
+			status == NG_TCP_STATUS_CLOSE_WAIT) &&
+			rte_ring_free_count(stream->sndbuf) != 0) {
+		events |= EPOLLOUT;
+	}
+
+	return events;
+}
+
+int
+ng_tcp_close(struct ng_tcp_stream *stream)
+{
+	if (stream->shard != NG_TCP_NO_SHARD) {
+		if (stream->rcv_head != NULL) {
+			rte_pktmbuf_free(stream->rcv_head);
+			stream->rcv_head = NULL;
+		}
+		ng_tcp_notify(stream, NG_TCP_F_CLOSED);
+		return 0;
+	}
+
+	if (stream->status == NG_TCP_STATUS_LISTEN) {
+		struct ng_tcp_stream *apt;
+		uint16_t port = rte_be_to_cpu_16(stream->key.dport);
+
+		__atomic_store_n(&stream->status, NG_TCP_STATUS_CLOSED,
+			__ATOMIC_RELEASE);
+		__atomic_store_n(&ng_stack->listeners[port], NULL,
+			__ATOMIC_RELEASE);
+
+		while (rte_ring_sc_dequeue(stream->accept, (void **)&apt) == 0)
+			ng_tcp_close(apt);
+
+		/*
+		 * Shards may still hold the listener from a lookup or a
+		 * pending handshake, so its memory is not given back.
+		 */
+		return 0;
+	}
+
+	rte_free(stream);
+	return 0;
+}
@@ -0,0 +1,244 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#ifndef __NG_TCP_H__
+#define __NG_TCP_H__
+
+/**
+ * @file
+ *
+ * Userspace TCP stack.
+ *
+ * The stack is split in shards, one per stack lcore. Each shard owns one
+ * RX/TX queue pair of the port and the TCP connections whose packets the
+ * NIC RSS function steers to that queue. A shard keeps its connections in
+ * a private rte_hash keyed by the 4-tuple, so the receive path never takes
+ * a lock and never walks a list:
+ *
+ *  - ng_tcp_input_burst() classifies a burst of received segments, looks up
+ *    their connections with one bulk hash lookup and runs the state machine.
+ *    ACKs generated by a burst are coalesced to one per connection.
+ *  - ng_tcp_output_burst() returns the control segments produced by input
+ *    and the data segments the application queued since the last call.
+ *
+ * Both functions must be called from the lcore owning the shard.
+ *
+ * The application talks to the stack through lock-free rings only:
+ *
+ *  - every connection has an SP/SC receive ring (stack -> application)
+ *    and an SP/SC send ring (application -> stack) carrying mbufs, so
+ *    payload is neither copied nor allocated with rte_malloc on the stack
+ *    side;
+ *  - listeners have an MP/SC accept ring fed by all shards;
+ *  - every shard has an MP/SC notify ring the application uses to tell the
+ *    owning shard that a connection has data to send or was closed.
+ *
+ * All application calls are non-blocking and return -EAGAIN when they
+ * cannot make progress. A connection must be used by a single application
+ * thread at a time.
+ *
+ * Sent segments stay on a per-connection retransmission queue until
+ * acknowledged; retransmissions chain the original payload mbuf behind a
+ * new header and copy nothing. Losses are recovered with SACK (RFC 6675)
+ * when the peer supports it, NewReno (RFC 6582) otherwise, and by the
+ * RFC 6298 retransmission timer. Timers are rte_timers armed on the shard
+ * lcore: rte_timer_subsystem_init() must be called before traffic starts
+ * and every shard lcore must call rte_timer_manage() regularly, about
+ * every millisecond. Out of order data is kept
+ * as chains of the received mbufs and reported in SACK blocks.
+ *
+ * A connection or listener can be registered to an ng_epoll instance
+ * through ng_tcp_epoll_source() and ng_tcp_poll(): the shards signal it
+ * when data, a connection or send ring room arrives, and when the
+ * connection is shut down.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <rte_ether.h>
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of stack shards. */
+#define NG_TCP_MAX_SHARDS	16
+
+/** Maximum segment size advertised and used for transmission. */
+#define NG_TCP_MSS		1460
+
+typedef enum _NG_TCP_STATUS {
+
+	NG_TCP_STATUS_CLOSED = 0,
+	NG_TCP_STATUS_LISTEN,
+	NG_TCP_STATUS_SYN_RCVD,
+	NG_TCP_STATUS_SYN_SENT,
+	NG_TCP_STATUS_ESTABLISHED,
+
+	NG_TCP_STATUS_FIN_WAIT_1,
+	NG_TCP_STATUS_FIN_WAIT_2,
+	NG_TCP_STATUS_CLOSING,
+	NG_TCP_STATUS_TIME_WAIT,
+
+	NG_TCP_STATUS_CLOSE_WAIT,
+	NG_TCP_STATUS_LAST_ACK
+
+} NG_TCP_STATUS;
+
+/** Congestion control algorithms. */
+enum ng_tcp_cc {
+	NG_TCP_CC_NEWRENO = 0,	/**< RFC 5681, RFC 6582. */
+	NG_TCP_CC_CUBIC,	/**< RFC 8312. */
+};
+
+/** Stack configuration, see ng_tcp_stack_init(). */
+struct ng_tcp_conf {
+	uint32_t local_ip;		/**< Local IPv4 address, network order. */
+	struct rte_ether_addr local_mac; /**< MAC address of the port. */
+	struct rte_mempool *pool;	/**< Pool for control segments. */
+	uint16_t nb_shards;		/**< Number of shards (RX queues). */
+	uint32_t max_streams;		/**< Connections per shard. */
+	uint32_t ring_size;		/**< Per-connection ring size, pow2. */
+	int socket_id;			/**< NUMA socket for stack memory. */
+	enum ng_tcp_cc cc;		/**< Congestion control algorithm. */
+	uint32_t rto_min_ms;		/**< Minimum RTO, 0 for 200 ms. */
+	uint8_t no_sack;		/**< Do not negotiate SACK. */
+	/**
+	 * 40-byte RSS key of the port, needed by ng_tcp_connect() to find
+	 * the shard of a new connection when there are several. The port
+	 * must use the default, round-robin, redirection table.
+	 */
+	const uint8_t *rss_key;
+};
+
+/** Per-shard counters, see ng_tcp_stats_get(). */
+struct ng_tcp_stats {
+	uint64_t rx_pkts;	/**< Segments handed to ng_tcp_input_burst. */
+	uint64_t rx_drops;	/**< Invalid, unmatched or unqueued segments. */
+	uint64_t tx_pkts;	/**< Segments returned by ng_tcp_output_burst. */
+	uint64_t tx_drops;	/**< Control segments lost on full TX queue. */
+	uint64_t streams;	/**< Connections currently in the table. */
+	uint64_t syn_drops;	/**< SYNs refused (table or backlog full). */
+	uint64_t retransmits;	/**< Segments sent again. */
+	uint64_t timeouts;	/**< Retransmission timer expirations. */
+	uint64_t fast_recoveries; /**< Losses repaired without timeout. */
+	uint64_t ooo_segs;	/**< Segments received out of order. */
+};
+
+struct ng_tcp_stream;
+struct ng_epoll_source;
+
+/**
+ * Create the stack shards. Must be called once, before any other function.
+ *
+ * @return
+ *   0 on success, negative errno otherwise.
+ */
+int ng_tcp_stack_init(const struct ng_tcp_conf *conf);
+
+/**
+ * Process a burst of TCP/IPv4 frames received on a shard's queue.
+ * The mbufs are consumed in all cases.
+ *
+ * @return
+ *   Number of segments delivered to a connection.
+ */
+uint16_t ng_tcp_input_burst(uint16_t shard, struct rte_mbuf **pkts,
+		uint16_t nb_pkts);
+
+/**
+ * Collect up to nb_pkts ready to send frames for a shard.
+ *
+ * @return
+ *   Number of frames stored in pkts.
+ */
+uint16_t ng_tcp_output_burst(uint16_t shard, struct rte_mbuf **pkts,
+		uint16_t nb_pkts);
+
+/** Copy the counters of a shard. */
+int ng_tcp_stats_get(uint16_t shard, struct ng_tcp_stats *stats);
+
+/** Allocate an unbound socket. */
+struct ng_tcp_stream *ng_tcp_socket(void);
+
+/** Bind a socket to a local address and port, both in network order. */
+int ng_tcp_bind(struct ng_tcp_stream *stream, uint32_t ip, uint16_t port);
+
+/** Start accepting connections on a bound socket. */
+int ng_tcp_listen(struct ng_tcp_stream *stream, unsigned int backlog);
+
+/**
+ * Take one established connection from a listener.
+ *
+ * @return
+ *   The connection, or NULL with rte_errno set to EAGAIN if none is ready.
+ */
+struct ng_tcp_stream *ng_tcp_accept(struct ng_tcp_stream *listener);
+
+/**
+ * Open a connection to a remote address and port, in network order. The
+ * handshake runs in the background: data sent before it completes is
+ * queued, and ng_tcp_recv() reports a failure as -ECONNREFUSED or
+ * -ETIMEDOUT.
+ *
+ * @param next_hop
+ *   MAC address of the peer or of the gateway leading to it.
+ * @return
+ *   The connection, or NULL with rte_errno set.
+ */
+struct ng_tcp_stream *ng_tcp_connect(uint32_t ip, uint16_t port,
+		const struct rte_ether_addr *next_hop);
+
+/** Get the remote address and port of a connection, in network order. */
+void ng_tcp_peer(const struct ng_tcp_stream *stream, uint32_t *ip,
+		uint16_t *port);
+
+/**
+ * Queue data for transmission. Data is cut in NG_TCP_MSS sized mbufs
+ * allocated from the pool given at init.
+ *
+ * @return
+ *   Number of bytes queued, -EAGAIN if the send ring is full, -EPIPE if
+ *   the connection can no longer send or the error that closed it.
+ */
+ssize_t ng_tcp_send(struct ng_tcp_stream *stream, const void *buf,
+		size_t len);
+
+/**
+ * Read received data.
+ *
+ * @return
+ *   Number of bytes read, 0 once the peer closed the connection and all
+ *   data was read, -EAGAIN if no data is available, or a negative errno
+ *   if the connection was reset or timed out.
+ */
+ssize_t ng_tcp_recv(struct ng_tcp_stream *stream, void *buf, size_t len);
+
+/** Event source of a socket, to register it to an ng_epoll instance. */
+struct ng_epoll_source *ng_tcp_epoll_source(struct ng_tcp_stream *stream);
+
+/**
+ * Get the events currently true on a socket: EPOLLIN when data, the end
+ * of the stream or a connection to accept is ready, EPOLLOUT when the send
+ * ring has room, EPOLLRDHUP, EPOLLHUP and EPOLLERR once the peer or both
+ * sides shut down or the connection failed.
+ */
+uint32_t ng_tcp_poll(const struct ng_tcp_stream *stream);
+
+/**
+ * Release a socket. Queued data is still sent, then the connection is
+ * shut down and its memory reclaimed by the owning shard. The stream must
+ * not be used after this call.
+ */
+int ng_tcp_close(struct ng_tcp_stream *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
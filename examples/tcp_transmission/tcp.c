@@ -1,16 +1,18 @@
-
-
 #include <rte_eal.h>
 #include <rte_ethdev.h>
 #include <rte_mbuf.h>
 #include <rte_malloc.h>
 #include <rte_timer.h>
+#include <rte_spinlock.h>
+#include <rte_rcu_qsbr.h>
 
 
 #include <stdio.h>
 #include <arpa/inet.h>
 
 #include "arp.h"
+#include "ng_epoll.h"
+#include "ng_tcp.h"
 
 #define ENABLE_SEND		1
 #define ENABLE_ARP		1
@@ -30,14 +32,20 @@
 
 
 
-#define NUM_MBUFS (4096-1)
+#define NUM_MBUFS (65536-1)
 
 #define BURST_SIZE	32
 #define RING_SIZE	1024
 
+// per stack lcore
+#define TCP_MAX_STREAMS		16384
+#define TCP_STREAM_RING_SIZE	64
+
 #define TIMER_RESOLUTION_CYCLES 120000000000ULL // 10ms * 1000 = 10s * 6 
 
 
+
+
 #if ENABLE_SEND
 
 #define MAKE_IPV4_ADDR(a, b, c, d) (a + (b<<8) + (c<<16) + (d<<24))
@@ -54,11 +62,12 @@ static uint8_t gDefaultArpMac[RTE_ETHER_ADDR_LEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xF
 
 #endif
 
+
 #if ENABLE_RINGBUFFER
 
+// arp, icmp and udp replies, sent by the first stack lcore
 struct inout_ring {
 
-	struct rte_ring *in;
 	struct rte_ring *out;
 };
 
@@ -83,131 +92,16 @@ static int udp_process(struct rte_mbuf *udpmbuf);
 static int udp_out(struct rte_mempool *mbuf_pool);
 
 
-#endif
-
-#if ENABLE_TCP_APP
-
-static int ng_tcp_process(struct rte_mbuf *tcpmbuf);
-static int ng_tcp_out(struct rte_mempool *mbuf_pool);
-
-
-#define TCP_OPTION_LENGTH	10
-
-#define TCP_MAX_SEQ		4294967295
-
-#define TCP_INITIAL_WINDOW  14600
-
-typedef enum _NG_TCP_STATUS {
-
-	NG_TCP_STATUS_CLOSED = 0,
-	NG_TCP_STATUS_LISTEN,
-	NG_TCP_STATUS_SYN_RCVD,
-	NG_TCP_STATUS_SYN_SENT,
-	NG_TCP_STATUS_ESTABLISHED,
-
-	NG_TCP_STATUS_FIN_WAIT_1,
-	NG_TCP_STATUS_FIN_WAIT_2,
-	NG_TCP_STATUS_CLOSING,
-	NG_TCP_STATUS_TIME_WAIT,
-
-	NG_TCP_STATUS_CLOSE_WAIT,
-	NG_TCP_STATUS_LAST_ACK
-
-} NG_TCP_STATUS;
-
-
-// tcp socket
-struct ng_tcp_stream { // tcb control block
-
-	int fd; //
-
-	uint32_t dip;
-	uint8_t localmac[RTE_ETHER_ADDR_LEN];
-	uint16_t dport;
-	
-	uint8_t protocol;
-	
-	uint16_t sport;
-	uint32_t sip;
-
-	uint32_t snd_nxt; // seqnum
-	uint32_t rcv_nxt; // acknum
-
-	NG_TCP_STATUS status;
-#if 0
-	union {
-
-		struct {
-			struct ng_tcp_stream *syn_set; //
-			struct ng_tcp_stream *accept_set; //
-		};
-		
-		struct {
-			struct rte_ring *sndbuf;
-			struct rte_ring *rcvbuf;
-		};
-	};
-#else
-	struct rte_ring *sndbuf;
-	struct rte_ring *rcvbuf;
-#endif
-	struct ng_tcp_stream *prev;
-	struct ng_tcp_stream *next;
-
-	pthread_cond_t cond;
-	pthread_mutex_t mutex;
-
-};
-
-struct ng_tcp_table {
-	int count;
-	//struct ng_tcp_stream *listener_set;	//
-	struct ng_tcp_stream *tcb_set;
-};
-
-// 上层tcp 数据的结构体
-struct ng_tcp_fragment { 
-
-	uint16_t sport;  
-	uint16_t dport;  
-	uint32_t seqnum;  
-	uint32_t acknum;  
-	uint8_t  hdrlen_off;  
-	uint8_t  tcp_flags; 
-	uint16_t windows;   
-	uint16_t cksum;     
-	uint16_t tcp_urp;  
-
-	int optlen;
-	uint32_t option[TCP_OPTION_LENGTH];
-
-	unsigned char *data;
-	uint32_t length;
-
-};
-
-
-struct ng_tcp_table *tInst = NULL;
-
-static struct ng_tcp_table *tcpInstance(void) {
-
-	if (tInst == NULL) {
-
-		tInst = rte_malloc("ng_tcp_table", sizeof(struct ng_tcp_table), 0);
-		memset(tInst, 0, sizeof(struct ng_tcp_table));
-		
-	}
-	return tInst;
-}
-
-
-
-
 #endif
 
 
 int gDpdkPortId = 0;
 
+// one stack lcore per rx/tx queue pair
+static uint16_t gNbShards = 1;
+
+// stack lcores report quiescent states here, nepoll frees registrations after them
+static struct rte_rcu_qsbr *gQsbr = NULL;
 
 
 static const struct rte_eth_conf port_conf_default = {
@@ -224,27 +118,48 @@ static void ng_init_port(struct rte_mempool *mbuf_pool) {
 	struct rte_eth_dev_info dev_info;
 	rte_eth_dev_info_get(gDpdkPortId, &dev_info); //
 	
-	const int num_rx_queues = 1;
-	const int num_tx_queues = 1;
 	struct rte_eth_conf port_conf = port_conf_default;
+
+	// rss spreads the tcp connections over the stack lcores
+	gNbShards = RTE_MIN(gNbShards, dev_info.max_rx_queues);
+	gNbShards = RTE_MIN(gNbShards, dev_info.max_tx_queues);
+	uint64_t rss_hf = (ETH_RSS_IP | ETH_RSS_TCP | ETH_RSS_UDP) &
+		dev_info.flow_type_rss_offloads;
+	if (gNbShards > 1 && rss_hf != 0) {
+		port_conf.rxmode.mq_mode = ETH_MQ_RX_RSS;
+		port_conf.rx_adv_conf.rss_conf.rss_key = NULL;
+		port_conf.rx_adv_conf.rss_conf.rss_hf = rss_hf;
+	} else {
+		gNbShards = 1;
+	}
+
+	const int num_rx_queues = gNbShards;
+	const int num_tx_queues = gNbShards;
 	rte_eth_dev_configure(gDpdkPortId, num_rx_queues, num_tx_queues, &port_conf);
 
 
-	if (rte_eth_rx_queue_setup(gDpdkPortId, 0 , 1024, 
-		rte_eth_dev_socket_id(gDpdkPortId),NULL, mbuf_pool) < 0) {
+	uint16_t q;
+	for (q = 0;q < gNbShards;q ++) {
+
+		if (rte_eth_rx_queue_setup(gDpdkPortId, q, 1024, 
+			rte_eth_dev_socket_id(gDpdkPortId),NULL, mbuf_pool) < 0) {
 
-		rte_exit(EXIT_FAILURE, "Could not setup RX queue\n");
+			rte_exit(EXIT_FAILURE, "Could not setup RX queue\n");
 
+		}
 	}
 	
 #if ENABLE_SEND
 	struct rte_eth_txconf txq_conf = dev_info.default_txconf;
 	txq_conf.offloads = port_conf.rxmode.offloads;
-	if (rte_eth_tx_queue_setup(gDpdkPortId, 0 , 1024, 
-		rte_eth_dev_socket_id(gDpdkPortId), &txq_conf) < 0) {
-		
-		rte_exit(EXIT_FAILURE, "Could not setup TX queue\n");
-		
+	for (q = 0;q < gNbShards;q ++) {
+
+		if (rte_eth_tx_queue_setup(gDpdkPortId, q, 1024, 
+			rte_eth_dev_socket_id(gDpdkPortId), &txq_conf) < 0) {
+			
+			rte_exit(EXIT_FAILURE, "Could not setup TX queue\n");
+			
+		}
 	}
 #endif
 
@@ -256,6 +171,7 @@ static void ng_init_port(struct rte_mempool *mbuf_pool) {
 
 }
 
+
 /*
 static int ng_encode_udp_pkt(uint8_t *msg, unsigned char *data, uint16_t total_len) {
 
@@ -535,15 +451,38 @@ arp_request_timer_cb(__attribute__((unused)) struct rte_timer *tim,
 
 
 
+static struct rte_mempool *gMbufPool = NULL;
+
+static void ng_tx_burst(uint16_t queue, struct rte_mbuf **tx, uint16_t nb_tx) {
+
+	uint16_t nb_sent = rte_eth_tx_burst(gDpdkPortId, queue, tx, nb_tx);
+	for ( ;nb_sent < nb_tx;nb_sent ++) {
+		rte_pktmbuf_free(tx[nb_sent]);
+	}
+}
+
+// stack lcore: owns rx/tx queue "shard" and the tcp connections rss puts there
 static int pkt_process(void *arg) {
 
-	struct rte_mempool *mbuf_pool = (struct rte_mempool *)arg;
+	struct rte_mempool *mbuf_pool = gMbufPool;
 	struct inout_ring *ring = ringInstance();
+	uint16_t shard = (uint16_t)(uintptr_t)arg;
+
+	// tcp retransmission timers run on the shard lcore, ~1ms resolution
+	const uint64_t timer_period = rte_get_timer_hz() / 1000;
+	uint64_t timer_tsc = 0;
+
+	rte_rcu_qsbr_thread_register(gQsbr, shard);
+	rte_rcu_qsbr_thread_online(gQsbr, shard);
 
 	while (1) {
 
 		struct rte_mbuf *mbufs[BURST_SIZE];
-		unsigned num_recvd = rte_ring_mc_dequeue_burst(ring->in, (void**)mbufs, BURST_SIZE, NULL);
+		unsigned num_recvd = rte_eth_rx_burst(gDpdkPortId, shard, mbufs, BURST_SIZE);
+
+		// tcp segments are handed to the stack as one burst
+		struct rte_mbuf *tcpmbufs[BURST_SIZE];
+		uint16_t nb_tcp = 0;
 		
 		unsigned i = 0;
 		for (i = 0;i < num_recvd;i ++) {
@@ -615,15 +554,16 @@ static int pkt_process(void *arg) {
 					
 						}
 #endif
-						rte_pktmbuf_free(mbufs[i]);
 					}
 				
+					rte_pktmbuf_free(mbufs[i]);
 					continue;
 				} 
 			}
 #endif
 
 			if (ehdr->ether_type != rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4)) {
+				rte_pktmbuf_free(mbufs[i]);
 				continue;
 			}
 
@@ -633,15 +573,15 @@ static int pkt_process(void *arg) {
 			if (iphdr->next_proto_id == IPPROTO_UDP) {
 
 				udp_process(mbufs[i]);
-				
+				continue;
 			}
 
 #if ENABLE_TCP_APP
 
 			if (iphdr->next_proto_id == IPPROTO_TCP) {
-				printf("ng_tcp_process\n");
-				ng_tcp_process(mbufs[i]);
-				
+
+				tcpmbufs[nb_tcp ++] = mbufs[i];
+				continue;
 			}
 
 #endif
@@ -671,7 +611,6 @@ static int pkt_process(void *arg) {
 					//rte_pktmbuf_free(txbuf);
 					rte_ring_mp_enqueue_burst(ring->out, (void**)&txbuf, 1, NULL);
 
-					rte_pktmbuf_free(mbufs[i]);
 				}
 				
 
@@ -679,22 +618,49 @@ static int pkt_process(void *arg) {
 
 
 #endif
-			
+			rte_pktmbuf_free(mbufs[i]);
 		}
 
-#if ENABLE_UDP_APP
+#if ENABLE_TCP_APP
 
-		udp_out(mbuf_pool);
+		ng_tcp_input_burst(shard, tcpmbufs, nb_tcp);
 
 #endif
 
 
+		struct rte_mbuf *tx[BURST_SIZE];
+		unsigned nb_tx = 0;
+
+		if (shard == 0) {
+
+#if ENABLE_UDP_APP
+
+			udp_out(mbuf_pool);
+
+#endif
+			nb_tx = rte_ring_sc_dequeue_burst(ring->out, (void**)tx, BURST_SIZE, NULL);
+			if (nb_tx > 0) {
+				ng_tx_burst(shard, tx, nb_tx);
+			}
+		}
+
 #if ENABLE_TCP_APP
 
-		ng_tcp_out(mbuf_pool);
+		nb_tx = ng_tcp_output_burst(shard, tx, BURST_SIZE);
+		if (nb_tx > 0) {
+			ng_tx_burst(shard, tx, nb_tx);
+		}
+
+		uint64_t cur_tsc = rte_get_timer_cycles();
+		if (cur_tsc - timer_tsc > timer_period) {
+			rte_timer_manage();
+			timer_tsc = cur_tsc;
+		}
 
 #endif
 
+		// no nepoll registration is held across loops
+		rte_rcu_qsbr_quiescent(gQsbr, shard);
 	}
 
 	return 0;
@@ -704,6 +670,8 @@ static int pkt_process(void *arg) {
 #endif
 
 
+
+
 #if ENABLE_UDP_APP
 
 
@@ -726,8 +694,7 @@ struct localhost { //
 	struct localhost *prev; //
 	struct localhost *next;
 
-	pthread_cond_t cond;
-	pthread_mutex_t mutex;
+	struct ng_epoll_source ev;
 
 };
 
@@ -735,76 +702,120 @@ static struct localhost *lhost = NULL;
 
 #define DEFAULT_FD_NUM	3
 
-#define MAX_FD_COUNT	1024
+#define MAX_FD_COUNT	(1 << 20)
+
+static unsigned char fd_table[MAX_FD_COUNT / 8] = {0};
+
+// not an ip protocol: the fd is a nepoll instance
+#define NG_FD_EPOLL	0xfd
+
+#define NG_FD_NONBLOCK	0x1
+
+// fd --> struct localhost (udp), struct ng_tcp_stream (tcp) or struct ng_epoll
+struct ng_fd {
+	uint8_t protocol;
+	uint8_t flags;
+	void *sock;
+};
+
+static struct ng_fd fd_socks[MAX_FD_COUNT];
+
+static int fd_next = DEFAULT_FD_NUM;
 
-static unsigned char fd_table[MAX_FD_COUNT] = {0};
+static rte_spinlock_t fd_lock = RTE_SPINLOCK_INITIALIZER;
 
 // 获取一个未使用的fd
 // 从位图（bitmap）中分配资源句柄（文件描述符 fd） 的实现
 static int get_fd_frombitmap(void) {
 
-	int fd = DEFAULT_FD_NUM;
-	for ( ;fd < MAX_FD_COUNT;fd ++) {
-		if ((fd_table[fd/8] & (0x1 << (fd % 8))) == 0) {
-			fd_table[fd/8] |= (0x1 << (fd % 8));
-			return fd;
+	int i, fd = -1;
+
+	rte_spinlock_lock(&fd_lock);
+	for (i = DEFAULT_FD_NUM;i < MAX_FD_COUNT;i ++) {
+		int cur = fd_next;
+
+		fd_next = (fd_next + 1 < MAX_FD_COUNT) ? fd_next + 1 : DEFAULT_FD_NUM;
+		if ((fd_table[cur/8] & (0x1 << (cur % 8))) == 0) {
+			fd_table[cur/8] |= (0x1 << (cur % 8));
+			fd = cur;
+			break;
 		}
 	}
+	rte_spinlock_unlock(&fd_lock);
 
-	return -1;
+	return fd;
 	
 }
 
 static int set_fd_frombitmap(int fd) {
 
-	if (fd >= MAX_FD_COUNT) return -1;
+	if (fd < DEFAULT_FD_NUM || fd >= MAX_FD_COUNT) return -1;
+
+	fd_socks[fd].sock = NULL;
+	fd_socks[fd].protocol = 0;
+	fd_socks[fd].flags = 0;
 
+	rte_spinlock_lock(&fd_lock);
 	fd_table[fd/8] &= ~(0x1 << (fd % 8));
+	rte_spinlock_unlock(&fd_lock);
 
 	return 0;
 }
 
-static struct ng_tcp_stream *get_accept_tcb(uint16_t dport) {
+static int set_fd_sock(int fd, uint8_t protocol, void *sock) {
 
-	struct ng_tcp_stream *apt;
-	struct ng_tcp_table *table = tcpInstance();
-	for (apt = table->tcb_set;apt != NULL;apt = apt->next) {
-		if (dport == apt->dport && apt->fd == -1) {
-			return apt;
-		}
+	if (fd < DEFAULT_FD_NUM || fd >= MAX_FD_COUNT) return -1;
+
+	fd_socks[fd].protocol = protocol;
+	fd_socks[fd].flags = 0;
+	fd_socks[fd].sock = sock;
+
+	return 0;
+}
+
+static struct ng_fd *get_fd_sock(int sockfd) {
+
+	if (sockfd < DEFAULT_FD_NUM || sockfd >= MAX_FD_COUNT ||
+		fd_socks[sockfd].sock == NULL) {
+		return NULL;
 	}
 
-	return NULL;
+	return &fd_socks[sockfd];
 }
 
 static void* get_hostinfo_fromfd(int sockfd) {
 
-	struct localhost *host;
+	struct ng_fd *f = get_fd_sock(sockfd);
+	if (f == NULL || f->protocol != IPPROTO_UDP) return NULL;
 
-	for (host = lhost; host != NULL;host = host->next) {
+	return f->sock;
+	
+}
 
-		if (sockfd == host->fd) {
-			return host;
-		}
+#if ENABLE_TCP_APP
 
-	}
+static struct ng_tcp_stream *get_stream_fromfd(int sockfd) {
 
-#if ENABLE_TCP_APP
+	struct ng_fd *f = get_fd_sock(sockfd);
+	if (f == NULL || f->protocol != IPPROTO_TCP) return NULL;
 
-	// TCPU SOCK
-	struct ng_tcp_stream *stream = NULL;
-	struct ng_tcp_table *table = tcpInstance();
-	for (stream = table->tcb_set;stream != NULL;stream = stream->next) {
-		if (sockfd == stream->fd) {
-			return stream;
-		}
-	}
+	return f->sock;
+}
 
 #endif
 
-	
-	return NULL;
-	
+static struct ng_epoll *get_epoll_fromfd(int epfd) {
+
+	struct ng_fd *f = get_fd_sock(epfd);
+	if (f == NULL || f->protocol != NG_FD_EPOLL) return NULL;
+
+	return f->sock;
+}
+
+// blocking calls spin, nobody sleeps on the stack lcores
+static int fd_nonblock(int sockfd, int flags) {
+
+	return (flags & MSG_DONTWAIT) || (fd_socks[sockfd].flags & NG_FD_NONBLOCK);
 }
 
 static struct localhost * get_hostinfo_fromip_port(uint32_t dip, uint16_t port, uint8_t proto) {
@@ -884,11 +895,14 @@ static int udp_process(struct rte_mbuf *udpmbuf) {
 	}
 	rte_memcpy(ol->data, (unsigned char *)(udphdr+1), ol->length - sizeof(struct rte_udp_hdr));
 
-	rte_ring_mp_enqueue(host->rcvbuf, ol); // recv buffer
+	if (rte_ring_mp_enqueue(host->rcvbuf, ol) != 0) { // recv buffer
+		rte_free(ol->data);
+		rte_free(ol);
+		rte_pktmbuf_free(udpmbuf);
+		return -4;
+	}
 
-	pthread_mutex_lock(&host->mutex);
-	pthread_cond_signal(&host->cond);
-	pthread_mutex_unlock(&host->mutex);
+	ng_epoll_signal(&host->ev, EPOLLIN);
 
 	rte_pktmbuf_free(udpmbuf);
 
@@ -1013,11 +1027,16 @@ static int udp_out(struct rte_mempool *mbuf_pool) {
 static int nsocket(__attribute__((unused)) int domain, int type, __attribute__((unused))  int protocol) {
 
 	int fd = get_fd_frombitmap(); //
+	if (fd == -1) return -1;
+
+	uint8_t fd_flags = (type & SOCK_NONBLOCK) ? NG_FD_NONBLOCK : 0;
+	type &= ~(SOCK_NONBLOCK | SOCK_CLOEXEC);
 
 	if (type == SOCK_DGRAM) {
 
 		struct localhost *host = rte_malloc("localhost", sizeof(struct localhost), 0);
 		if (host == NULL) {
+			set_fd_frombitmap(fd);
 			return -1;
 		}
 		memset(host, 0, sizeof(struct localhost));
@@ -1026,264 +1045,167 @@ static int nsocket(__attribute__((unused)) int domain, int type, __attribute__((
 		
 		host->protocol = IPPROTO_UDP;
 
-		host->rcvbuf = rte_ring_create("recv buffer", RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
+		char name[RTE_RING_NAMESIZE];
+		snprintf(name, sizeof(name), "recv buffer %d", fd);
+		// filled by whichever stack lcore rss picked
+		host->rcvbuf = rte_ring_create(name, RING_SIZE, rte_socket_id(), RING_F_SC_DEQ);
 		if (host->rcvbuf == NULL) {
 
 			rte_free(host);
+			set_fd_frombitmap(fd);
 			return -1;
 		}
 
-	
-		host->sndbuf = rte_ring_create("send buffer", RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
+		snprintf(name, sizeof(name), "send buffer %d", fd);
+		host->sndbuf = rte_ring_create(name, RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
 		if (host->sndbuf == NULL) {
 
 			rte_ring_free(host->rcvbuf);
 
 			rte_free(host);
+			set_fd_frombitmap(fd);
 			return -1;
 		}
 
-		pthread_cond_t blank_cond = PTHREAD_COND_INITIALIZER;
-		rte_memcpy(&host->cond, &blank_cond, sizeof(pthread_cond_t));
-
-		pthread_mutex_t blank_mutex = PTHREAD_MUTEX_INITIALIZER;
-		rte_memcpy(&host->mutex, &blank_mutex, sizeof(pthread_mutex_t));
-
 		LL_ADD(host, lhost);
+		set_fd_sock(fd, IPPROTO_UDP, host);
 		
 	} else if (type == SOCK_STREAM) {
 
-
-		struct ng_tcp_stream *stream = rte_malloc("ng_tcp_stream", sizeof(struct ng_tcp_stream), 0);
+#if ENABLE_TCP_APP
+		struct ng_tcp_stream *stream = ng_tcp_socket();
 		if (stream == NULL) {
+			set_fd_frombitmap(fd);
 			return -1;
 		}
-		memset(stream, 0, sizeof(struct ng_tcp_stream));
-
-		stream->fd = fd;
-		stream->protocol = IPPROTO_TCP;
-		stream->next = stream->prev = NULL;
-
-		stream->rcvbuf = rte_ring_create("tcp recv buffer", RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
-		if (stream->rcvbuf == NULL) {
-
-			rte_free(stream);
-			return -1;
-		}
-
-	
-		stream->sndbuf = rte_ring_create("tcp send buffer", RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
-		if (stream->sndbuf == NULL) {
-
-			rte_ring_free(stream->rcvbuf);
-
-			rte_free(stream);
-			return -1;
-		}
-
-		pthread_cond_t blank_cond = PTHREAD_COND_INITIALIZER;
-		rte_memcpy(&stream->cond, &blank_cond, sizeof(pthread_cond_t));
 
-		pthread_mutex_t blank_mutex = PTHREAD_MUTEX_INITIALIZER;
-		rte_memcpy(&stream->mutex, &blank_mutex, sizeof(pthread_mutex_t));
-
-		struct ng_tcp_table *table = tcpInstance();
-		LL_ADD(stream, table->tcb_set);
-		// get_stream_from_fd();
+		set_fd_sock(fd, IPPROTO_TCP, stream);
+#else
+		set_fd_frombitmap(fd);
+		return -1;
+#endif
+	} else {
+		set_fd_frombitmap(fd);
+		return -1;
 	}
 
+	fd_socks[fd].flags = fd_flags;
+
 	return fd;
 }
 
 static int nbind(int sockfd, const struct sockaddr *addr,
                 __attribute__((unused))  socklen_t addrlen) {
 
-	void *hostinfo =  get_hostinfo_fromfd(sockfd);
-	if (hostinfo == NULL) return -1;
+	const struct sockaddr_in *laddr = (const struct sockaddr_in *)addr;
 
-	struct localhost *host = (struct localhost *)hostinfo;
-	if (host->protocol == IPPROTO_UDP) {
+	struct localhost *host = get_hostinfo_fromfd(sockfd);
+	if (host != NULL) {
 		
-		const struct sockaddr_in *laddr = (const struct sockaddr_in *)addr;
 		host->localport = laddr->sin_port;
 		rte_memcpy(&host->localip, &laddr->sin_addr.s_addr, sizeof(uint32_t));
 		rte_memcpy(host->localmac, gSrcMac, RTE_ETHER_ADDR_LEN);
 
-	} else if (host->protocol == IPPROTO_TCP) {
+		return 0;
+	}
 
-		struct ng_tcp_stream *stream = (struct ng_tcp_stream *)hostinfo;
-		
-		const struct sockaddr_in *laddr = (const struct sockaddr_in *)addr;
-		stream->dport = laddr->sin_port;
-		rte_memcpy(&stream->dip, &laddr->sin_addr.s_addr, sizeof(uint32_t));
-		rte_memcpy(stream->localmac, gSrcMac, RTE_ETHER_ADDR_LEN);
+#if ENABLE_TCP_APP
 
-		stream->status = NG_TCP_STATUS_CLOSED;
-		
+	struct ng_tcp_stream *stream = get_stream_fromfd(sockfd);
+	if (stream != NULL) {
+		return ng_tcp_bind(stream, laddr->sin_addr.s_addr, laddr->sin_port);
 	}
 
-	return 0;
+#endif
 
-}
+	return -1;
 
+}
 
-static int nlisten(int sockfd, __attribute__((unused)) int backlog) { //
+#if ENABLE_TCP_APP
 
-	void *hostinfo =  get_hostinfo_fromfd(sockfd);
-	if (hostinfo == NULL) return -1;
+static int nlisten(int sockfd, int backlog) { //
 
-	
-	struct ng_tcp_stream *stream = (struct ng_tcp_stream *)hostinfo;
-	if (stream->protocol == IPPROTO_TCP) {
-		stream->status = NG_TCP_STATUS_LISTEN;
-	}
+	struct ng_tcp_stream *stream = get_stream_fromfd(sockfd);
+	if (stream == NULL) return -1;
 
-	return 0;
+	return ng_tcp_listen(stream, backlog);
 }
 
-
+// the stack never blocks, the shim polls the lock-free rings instead
 static int naccept(int sockfd, struct sockaddr *addr, __attribute__((unused)) socklen_t *addrlen) {
 
-	void *hostinfo =  get_hostinfo_fromfd(sockfd);
-	if (hostinfo == NULL) return -1;
-
-	struct ng_tcp_stream *stream = (struct ng_tcp_stream *)hostinfo;
-	if (stream->protocol == IPPROTO_TCP) {
-
-		struct ng_tcp_stream *apt = NULL;
-
-		// 实现阻塞
-		pthread_mutex_lock(&stream->mutex);
-		// 全连接队列获取sock
-		while((apt = get_accept_tcb(stream->dport)) == NULL) {
-			pthread_cond_wait(&stream->cond, &stream->mutex);
-		} 
-		pthread_mutex_unlock(&stream->mutex);
+	struct ng_tcp_stream *stream = get_stream_fromfd(sockfd);
+	if (stream == NULL) return -1;
 
-		// 绑定fd
-		apt->fd = get_fd_frombitmap();
-
-		struct sockaddr_in *saddr = (struct sockaddr_in *)addr;
-		saddr->sin_port = apt->sport;
-		rte_memcpy(&saddr->sin_addr.s_addr, &apt->sip, sizeof(uint32_t));
-
-		return apt->fd;
+	struct ng_tcp_stream *apt = NULL;
+	while ((apt = ng_tcp_accept(stream)) == NULL) {
+		if (rte_errno != EAGAIN || fd_nonblock(sockfd, 0)) {
+			errno = rte_errno;
+			return -1;
+		}
+		rte_pause();
 	}
 
-	return -1;
-}
-
-
-static ssize_t nsend(int sockfd, const void *buf, size_t len,__attribute__((unused)) int flags) {
-
-	ssize_t length = 0;
-
-	void *hostinfo =  get_hostinfo_fromfd(sockfd);
-	if (hostinfo == NULL) return -1;
-
-	struct ng_tcp_stream *stream = (struct ng_tcp_stream *)hostinfo;
-	if (stream->protocol == IPPROTO_TCP) {
+	// 绑定fd
+	int fd = get_fd_frombitmap();
+	if (fd == -1) {
+		ng_tcp_close(apt);
+		return -1;
+	}
+	set_fd_sock(fd, IPPROTO_TCP, apt);
 
-		struct ng_tcp_fragment *fragment = rte_malloc("ng_tcp_fragment", sizeof(struct ng_tcp_fragment), 0);
-		if (fragment == NULL) {
-			return -2;
-		}
+	struct sockaddr_in *saddr = (struct sockaddr_in *)addr;
+	ng_tcp_peer(apt, &saddr->sin_addr.s_addr, &saddr->sin_port);
 
-		memset(fragment, 0, sizeof(struct ng_tcp_fragment));
+	return fd;
+}
 
-		fragment->dport = stream->sport;
-		fragment->sport = stream->dport;
 
-		fragment->acknum = stream->rcv_nxt;
-		fragment->seqnum = stream->snd_nxt;
+static ssize_t nsend(int sockfd, const void *buf, size_t len, int flags) {
 
-		fragment->tcp_flags = RTE_TCP_ACK_FLAG | RTE_TCP_PSH_FLAG;
-		fragment->windows = TCP_INITIAL_WINDOW;
-		fragment->hdrlen_off = 0x50;
+	struct ng_tcp_stream *stream = get_stream_fromfd(sockfd);
+	if (stream == NULL) return -1;
 
+	size_t sent = 0;
+	while (sent < len) {
 
-		fragment->data = rte_malloc("unsigned char *", len+1, 0);
-		if (fragment->data == NULL) {
-			rte_free(fragment);
+		ssize_t n = ng_tcp_send(stream, (const uint8_t *)buf + sent, len - sent);
+		if (n == -EAGAIN && !fd_nonblock(sockfd, flags)) {
+			rte_pause();
+			continue;
+		} else if (n < 0) {
+			if (sent > 0) break;
+			errno = -n;
 			return -1;
 		}
-		memset(fragment->data, 0, len+1);
-
-		rte_memcpy(fragment->data, buf, len);
-		fragment->length = len;
-		length = fragment->length;
-
-		// int nb_snd = 0;
-		rte_ring_mp_enqueue(stream->sndbuf, fragment);
-
+		sent += n;
 	}
 
-	
-	return length;
+	return sent;
 }
 
-// recv 32
-// recv 
-static ssize_t nrecv(int sockfd, void *buf, size_t len, __attribute__((unused)) int flags) {
+static ssize_t nrecv(int sockfd, void *buf, size_t len, int flags) {
 	
-	ssize_t length = 0;
-
-	void *hostinfo =  get_hostinfo_fromfd(sockfd);
-	if (hostinfo == NULL) return -1;
-
-	struct ng_tcp_stream *stream = (struct ng_tcp_stream *)hostinfo;
-	if (stream->protocol == IPPROTO_TCP) {
-
-		struct ng_tcp_fragment *fragment = NULL;
-		int nb_rcv = 0;
-
-		printf("rte_ring_mc_dequeue before\n");
-		// 阻塞
-		pthread_mutex_lock(&stream->mutex);
-		while ((nb_rcv = rte_ring_mc_dequeue(stream->rcvbuf, (void **)&fragment)) < 0) {
-			pthread_cond_wait(&stream->cond, &stream->mutex);
-		}
-		pthread_mutex_unlock(&stream->mutex);
-		printf("rte_ring_mc_dequeue after\n");
-
-		// 读取一部分数据 只读取一次
-		if (fragment->length > len) {
-
-			rte_memcpy(buf, fragment->data, len);
-
-			uint32_t i = 0;
-			for(i = 0;i < fragment->length-len;i ++) {
-				fragment->data[i] = fragment->data[len+i];
-			}
-			fragment->length = fragment->length-len;
-			length = fragment->length;
-
-			rte_ring_mp_enqueue(stream->rcvbuf, fragment);
-
-		} else if (fragment->length == 0) {
+	struct ng_tcp_stream *stream = get_stream_fromfd(sockfd);
+	if (stream == NULL) return -1;
 
-			rte_free(fragment);
-			return 0;
-		
-		} else {
-
-			rte_memcpy(buf, fragment->data, fragment->length);
-			length = fragment->length;
-
-			rte_free(fragment->data);
-			fragment->data = NULL;
-
-			rte_free(fragment);
-			
-		}
+	ssize_t n;
+	while ((n = ng_tcp_recv(stream, buf, len)) == -EAGAIN && !fd_nonblock(sockfd, flags)) {
+		rte_pause();
+	}
 
+	if (n < 0) {
+		errno = -n;
+		return -1;
 	}
 
-	return length;
+	return n;
 }
 
+#endif
 
-static ssize_t nrecvfrom(int sockfd, void *buf, size_t len, __attribute__((unused))  int flags,
+static ssize_t nrecvfrom(int sockfd, void *buf, size_t len, int flags,
                         struct sockaddr *src_addr, __attribute__((unused))  socklen_t *addrlen) {
 
 	struct localhost *host =  get_hostinfo_fromfd(sockfd);
@@ -1294,13 +1216,14 @@ static ssize_t nrecvfrom(int sockfd, void *buf, size_t len, __attribute__((unuse
 	
 	struct sockaddr_in *saddr = (struct sockaddr_in *)src_addr;
 	
-	int nb = -1;
-	// 阻塞
-	pthread_mutex_lock(&host->mutex);
-	while ((nb = rte_ring_mc_dequeue(host->rcvbuf, (void **)&ol)) < 0) {
-		pthread_cond_wait(&host->cond, &host->mutex);
+	// 阻塞: 轮询 ring, 协议栈不再唤醒线程
+	while (rte_ring_mc_dequeue(host->rcvbuf, (void **)&ol) < 0) {
+		if (fd_nonblock(sockfd, flags)) {
+			errno = EAGAIN;
+			return -1;
+		}
+		rte_pause();
 	}
-	pthread_mutex_unlock(&host->mutex);
 	
 
 	saddr->sin_port = ol->sport;
@@ -1373,13 +1296,10 @@ static ssize_t nsendto(int sockfd, const void *buf, size_t len, __attribute__((u
 
 static int nclose(int fd) {
 
-	
-	void *hostinfo =  get_hostinfo_fromfd(fd);
-	if (hostinfo == NULL) return -1;
-
-	struct localhost *host = (struct localhost*)hostinfo;
-	if (host->protocol == IPPROTO_UDP) {
+	struct localhost *host = get_hostinfo_fromfd(fd);
+	if (host != NULL) {
 
+		ng_epoll_source_remove(&host->ev);
 		LL_REMOVE(host, lhost);
 
 		if (host->rcvbuf) {
@@ -1392,733 +1312,211 @@ static int nclose(int fd) {
 		rte_free(host);
 
 		set_fd_frombitmap(fd);
-		
-	} else if (host->protocol == IPPROTO_TCP) { 
 
-		struct ng_tcp_stream *stream = (struct ng_tcp_stream*)hostinfo;
+		return 0;
+	}
 
-		if (stream->status != NG_TCP_STATUS_LISTEN) {
-			
-			// 发送FIN ACK
-			struct ng_tcp_fragment *fragment = rte_malloc("ng_tcp_fragment", sizeof(struct ng_tcp_fragment), 0);
-			if (fragment == NULL) return -1;
-
-			printf("nclose --> enter last ack\n");
-			fragment->data = NULL;
-			fragment->length = 0;
-			fragment->sport = stream->dport;
-			fragment->dport = stream->sport;
+#if ENABLE_TCP_APP
 
-			fragment->seqnum = stream->snd_nxt;
-			fragment->acknum = stream->rcv_nxt;
+	struct ng_tcp_stream *stream = get_stream_fromfd(fd);
+	if (stream != NULL) {
 
-			fragment->tcp_flags = RTE_TCP_FIN_FLAG | RTE_TCP_ACK_FLAG;
-			fragment->windows = TCP_INITIAL_WINDOW;
-			fragment->hdrlen_off = 0x50;
+		// FIN and memory reclaim are done by the stack lcore
+		ng_epoll_source_remove(ng_tcp_epoll_source(stream));
+		ng_tcp_close(stream);
+		set_fd_frombitmap(fd);
 
-			rte_ring_mp_enqueue(stream->sndbuf, fragment);
-			stream->status = NG_TCP_STATUS_LAST_ACK;
+		return 0;
+	}
 
-			// 回收fd，不回收sock			
-			set_fd_frombitmap(fd);
+#endif
 
-		} else { // nsocket
+	struct ng_epoll *ep = get_epoll_fromfd(fd);
+	if (ep != NULL) {
 
-			struct ng_tcp_table *table = tcpInstance();
-			LL_REMOVE(stream, table->tcb_set);	
-			// 释放sock
-			rte_free(stream);
+		ng_epoll_free(ep);
+		set_fd_frombitmap(fd);
 
-		}
+		return 0;
 	}
 
-	return 0;
+	return -1;
 }
 
+// epoll
+// 协议栈 lcore 把就绪的 socket 放进无锁 ready ring, 一个应用线程轮询即可管理大量连接
 
+static uint32_t udp_poll(void *sock) {
 
+	struct localhost *host = sock;
+	uint32_t events = 0;
 
+	if (!rte_ring_empty(host->rcvbuf)) events |= EPOLLIN;
+	if (rte_ring_free_count(host->sndbuf) != 0) events |= EPOLLOUT;
 
-
-
-#define UDP_APP_RECV_BUFFER_SIZE	128
-
-// 
-static int udp_server_entry(__attribute__((unused))  void *arg) {
-
-	int connfd = nsocket(AF_INET, SOCK_DGRAM, 0);
-	if (connfd == -1) {
-		printf("sockfd failed\n");
-		return -1;
-	} 
-
-	struct sockaddr_in localaddr, clientaddr; // struct sockaddr 
-	memset(&localaddr, 0, sizeof(struct sockaddr_in));
-
-	localaddr.sin_port = htons(8889);
-	localaddr.sin_family = AF_INET;
-	localaddr.sin_addr.s_addr = inet_addr("192.168.0.115"); // 0.0.0.0
-	
-
-	nbind(connfd, (struct sockaddr*)&localaddr, sizeof(localaddr));
-
-	char buffer[UDP_APP_RECV_BUFFER_SIZE] = {0};
-	socklen_t addrlen = sizeof(clientaddr);
-	while (1) {
-
-		if (nrecvfrom(connfd, buffer, UDP_APP_RECV_BUFFER_SIZE, 0, 
-			(struct sockaddr*)&clientaddr, &addrlen) < 0) {
-
-			continue;
-
-		} else {
-
-			printf("recv from %s:%d, data:%s\n", inet_ntoa(clientaddr.sin_addr), 
-				ntohs(clientaddr.sin_port), buffer);
-			nsendto(connfd, buffer, strlen(buffer), 0, 
-				(struct sockaddr*)&clientaddr, sizeof(clientaddr));
-		}
-
-	}
-
-	nclose(connfd);
-
+	return events;
 }
 
+#if ENABLE_TCP_APP
 
+static uint32_t tcp_poll(void *sock) {
 
+	return ng_tcp_poll(sock);
+}
 
 #endif
 
+// unlike epoll_create(), size is the maximum number of sockets registered
+static int nepoll_create(int size) {
 
-#if ENABLE_TCP_APP // ngtcp
-
-
-
-static struct ng_tcp_stream * ng_tcp_stream_search(uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport) { // proto
-
-	struct ng_tcp_table *table = tcpInstance();
-
-	struct ng_tcp_stream *iter;
-	// 五元组匹配
-	for (iter = table->tcb_set;iter != NULL; iter = iter->next) { // established
-
-		if (iter->sip == sip && iter->dip == dip && 
-			iter->sport == sport && iter->dport == dport) {
-			return iter;
-		}
-
+	if (size <= 0) {
+		errno = EINVAL;
+		return -1;
 	}
 
-	// 监听fd匹配
-	for (iter = table->tcb_set;iter != NULL; iter = iter->next) {
-
-		if (iter->dport == dport && iter->status == NG_TCP_STATUS_LISTEN) { // listen
-			return iter;
-		}
-
+	int epfd = get_fd_frombitmap();
+	if (epfd == -1) {
+		errno = EMFILE;
+		return -1;
 	}
 
-	return NULL;
-}
-
-static struct ng_tcp_stream * ng_tcp_stream_create(uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport) { // proto
-
-	// tcp --> status
-	struct ng_tcp_stream *stream = rte_malloc("ng_tcp_stream", sizeof(struct ng_tcp_stream), 0);
-	if (stream == NULL) return NULL;
-
-	stream->sip = sip;
-	stream->dip = dip;
-	stream->sport = sport;
-	stream->dport = dport;
-	stream->protocol = IPPROTO_TCP;
-	stream->fd = -1; //unused
-
-	// 
-	stream->status = NG_TCP_STATUS_LISTEN;
-
-	printf("ng_tcp_stream_create\n");
-	//
-	stream->sndbuf = rte_ring_create("sndbuf", RING_SIZE, rte_socket_id(), 0);
-	stream->rcvbuf = rte_ring_create("rcvbuf", RING_SIZE, rte_socket_id(), 0);
-	
-	// seq num
-	uint32_t next_seed = time(NULL);
-	stream->snd_nxt = rand_r(&next_seed) % TCP_MAX_SEQ;
-	rte_memcpy(stream->localmac, gSrcMac, RTE_ETHER_ADDR_LEN);
-
-	pthread_cond_t blank_cond = PTHREAD_COND_INITIALIZER;
-	rte_memcpy(&stream->cond, &blank_cond, sizeof(pthread_cond_t));
-
-	pthread_mutex_t blank_mutex = PTHREAD_MUTEX_INITIALIZER;
-	rte_memcpy(&stream->mutex, &blank_mutex, sizeof(pthread_mutex_t));
-
-	//struct ng_tcp_table *table = tcpInstance();
-	//LL_ADD(stream, table->tcb_set);
-
-	return stream;
-}
-
-
-
-static int ng_tcp_handle_listen(struct ng_tcp_stream *stream, struct rte_tcp_hdr *tcphdr, struct rte_ipv4_hdr *iphdr) {
-
-	if (tcphdr->tcp_flags & RTE_TCP_SYN_FLAG)  {
-		//stream --> listenfd
-		if (stream->status == NG_TCP_STATUS_LISTEN) {
-
-			struct ng_tcp_table *table = tcpInstance();
-			// 创建一个sock
-			struct ng_tcp_stream *syn = ng_tcp_stream_create(iphdr->src_addr, iphdr->dst_addr, tcphdr->src_port, tcphdr->dst_port);
-			LL_ADD(syn, table->tcb_set);
-
-
-			// 创建一个syn ack包
-			struct ng_tcp_fragment *fragment = rte_malloc("ng_tcp_fragment", sizeof(struct ng_tcp_fragment), 0);
-			if (fragment == NULL) return -1;
-			memset(fragment, 0, sizeof(struct ng_tcp_fragment));
-
-			fragment->sport = tcphdr->dst_port;
-			fragment->dport = tcphdr->src_port;
-
-			struct in_addr addr;
-			addr.s_addr = syn->sip;
-			printf("tcp ---> src: %s:%d ", inet_ntoa(addr), ntohs(tcphdr->src_port));
-
-			
-			addr.s_addr = syn->dip;
-			printf("  ---> dst: %s:%d \n", inet_ntoa(addr), ntohs(tcphdr->dst_port));
-
-			fragment->seqnum = syn->snd_nxt;
-			fragment->acknum = ntohl(tcphdr->sent_seq) + 1;
-			syn->rcv_nxt = fragment->acknum;
-			
-			fragment->tcp_flags = (RTE_TCP_SYN_FLAG | RTE_TCP_ACK_FLAG);
-			fragment->windows = TCP_INITIAL_WINDOW;
-			fragment->hdrlen_off = 0x50;
-			
-			fragment->data = NULL;
-			fragment->length = 0;
-
-			rte_ring_mp_enqueue(syn->sndbuf, fragment);
-			
-			syn->status = NG_TCP_STATUS_SYN_RCVD;
-		}
-
+	struct ng_epoll *ep = ng_epoll_create(size, gQsbr);
+	if (ep == NULL) {
+		errno = rte_errno;
+		set_fd_frombitmap(epfd);
+		return -1;
 	}
+	set_fd_sock(epfd, NG_FD_EPOLL, ep);
 
-	return 0;
+	return epfd;
 }
 
+static int nepoll_ctl(int epfd, int op, int sockfd, struct epoll_event *event) {
 
-static int ng_tcp_handle_syn_rcvd(struct ng_tcp_stream *stream, struct rte_tcp_hdr *tcphdr) {
-
-	if (tcphdr->tcp_flags & RTE_TCP_ACK_FLAG) {
-
-		if (stream->status == NG_TCP_STATUS_SYN_RCVD) {
-
-			uint32_t acknum = ntohl(tcphdr->recv_ack);
-			if (acknum == stream->snd_nxt + 1) {
-				// 
-			}
-
-			// 改变sock状态
-			stream->status = NG_TCP_STATUS_ESTABLISHED;
-
-			// 查找SK
-			struct ng_tcp_stream *listener = ng_tcp_stream_search(0, 0, 0, stream->dport);
-			if (listener == NULL) {
-				rte_exit(EXIT_FAILURE, "ng_tcp_stream_search failed\n");
-			}
-
-			// listenb sock的全连接队列加1
-			// 告诉accept
-			pthread_mutex_lock(&listener->mutex);
-			pthread_cond_signal(&listener->cond);
-			pthread_mutex_unlock(&listener->mutex);
-			
-
-		}
-
+	struct ng_epoll *ep = get_epoll_fromfd(epfd);
+	if (ep == NULL) {
+		errno = EBADF;
+		return -1;
 	}
-	return 0;
-}
-
-static int ng_tcp_enqueue_recvbuffer(struct ng_tcp_stream *stream, struct rte_tcp_hdr *tcphdr, int tcplen) {
-
-	// recv buffer
-	struct ng_tcp_fragment *rfragment = rte_malloc("ng_tcp_fragment", sizeof(struct ng_tcp_fragment), 0);
-	if (rfragment == NULL) return -1;
-	memset(rfragment, 0, sizeof(struct ng_tcp_fragment));
-
-	rfragment->dport = ntohs(tcphdr->dst_port);
-	rfragment->sport = ntohs(tcphdr->src_port);
-
-	uint8_t hdrlen = tcphdr->data_off >> 4;
-	int payloadlen = tcplen - hdrlen * 4; //
-	if (payloadlen > 0) {
-		
-		uint8_t *payload = (uint8_t*)tcphdr + hdrlen * 4;
-
-		rfragment->data = rte_malloc("unsigned char *", payloadlen+1, 0);
-		if (rfragment->data == NULL) {
-			rte_free(rfragment);
-			return -1;
-		}
-		memset(rfragment->data, 0, payloadlen+1);
-
-		rte_memcpy(rfragment->data, payload, payloadlen);
-		rfragment->length = payloadlen;
 
-	} else if (payloadlen == 0) {
-
-		rfragment->length = 0;
-		rfragment->data = NULL;
+	struct ng_epoll_source *src = NULL;
+	ng_epoll_poll_t poll = NULL;
+	void *sock = NULL;
 
+	struct localhost *host = get_hostinfo_fromfd(sockfd);
+	if (host != NULL) {
+		src = &host->ev;
+		poll = udp_poll;
+		sock = host;
 	}
-	rte_ring_mp_enqueue(stream->rcvbuf, rfragment);
-
-	// recv buffer --> notify
-	pthread_mutex_lock(&stream->mutex);
-	pthread_cond_signal(&stream->cond);
-	pthread_mutex_unlock(&stream->mutex);
-
-	return 0;
-}
-
-static int ng_tcp_send_ackpkt(struct ng_tcp_stream *stream, struct rte_tcp_hdr *tcphdr) {
-
-	struct ng_tcp_fragment *ackfrag = rte_malloc("ng_tcp_fragment", sizeof(struct ng_tcp_fragment), 0);
-	if (ackfrag == NULL) return -1;
-	memset(ackfrag, 0, sizeof(struct ng_tcp_fragment));
-
-	ackfrag->dport = tcphdr->src_port;
-	ackfrag->sport = tcphdr->dst_port;
-
-	// remote
-	
-	printf("ng_tcp_send_ackpkt: %d, %d\n", stream->rcv_nxt, ntohs(tcphdr->sent_seq));
-	
-
-	ackfrag->acknum = stream->rcv_nxt;
-	ackfrag->seqnum = stream->snd_nxt;
-
-	ackfrag->tcp_flags = RTE_TCP_ACK_FLAG;
-	ackfrag->windows = TCP_INITIAL_WINDOW;
-	ackfrag->hdrlen_off = 0x50;
-	ackfrag->data = NULL;
-	ackfrag->length = 0;
-	
-	rte_ring_mp_enqueue(stream->sndbuf, ackfrag);
-
-	return 0;
-}
-
-static int ng_tcp_handle_established(struct ng_tcp_stream *stream, struct rte_tcp_hdr *tcphdr, int tcplen) {
-
-	if (tcphdr->tcp_flags & RTE_TCP_SYN_FLAG) {
-		//
-	} 
-	if (tcphdr->tcp_flags & RTE_TCP_PSH_FLAG) { //
-
-		// recv buffer
-#if 0
-		struct ng_tcp_fragment *rfragment = rte_malloc("ng_tcp_fragment", sizeof(struct ng_tcp_fragment), 0);
-		if (rfragment == NULL) return -1;
-		memset(rfragment, 0, sizeof(struct ng_tcp_fragment));
-
-		rfragment->dport = ntohs(tcphdr->dst_port);
-		rfragment->sport = ntohs(tcphdr->src_port);
-
-		uint8_t hdrlen = tcphdr->data_off >> 4;
-		int payloadlen = tcplen - hdrlen * 4;
-		if (payloadlen > 0) {
-			
-			uint8_t *payload = (uint8_t*)tcphdr + hdrlen * 4;
 
-			rfragment->data = rte_malloc("unsigned char *", payloadlen+1, 0);
-			if (rfragment->data == NULL) {
-				rte_free(rfragment);
-				return -1;
-			}
-			memset(rfragment->data, 0, payloadlen+1);
-
-			rte_memcpy(rfragment->data, payload, payloadlen);
-			rfragment->length = payloadlen;
-
-			printf("tcp : %s\n", rfragment->data);
-		}
-		rte_ring_mp_enqueue(stream->rcvbuf, rfragment);
-#else
-
-		ng_tcp_enqueue_recvbuffer(stream, tcphdr, tcplen);
-
-#endif
-
-
-#if 0
-		// ack pkt
-		struct ng_tcp_fragment *ackfrag = rte_malloc("ng_tcp_fragment", sizeof(struct ng_tcp_fragment), 0);
-		if (ackfrag == NULL) return -1;
-		memset(ackfrag, 0, sizeof(struct ng_tcp_fragment));
-
-		ackfrag->dport = tcphdr->src_port;
-		ackfrag->sport = tcphdr->dst_port;
-
-		// remote
-		
-		printf("ng_tcp_handle_established: %d, %d\n", stream->rcv_nxt, ntohs(tcphdr->sent_seq));
-		
-		
-		stream->rcv_nxt = stream->rcv_nxt + payloadlen;
-		// local 
-		stream->snd_nxt = ntohl(tcphdr->recv_ack);
-		//ackfrag->
-
-		ackfrag->acknum = stream->rcv_nxt;
-		ackfrag->seqnum = stream->snd_nxt;
-
-		ackfrag->tcp_flags = RTE_TCP_ACK_FLAG;
-		ackfrag->windows = TCP_INITIAL_WINDOW;
-		ackfrag->hdrlen_off = 0x50;
-		ackfrag->data = NULL;
-		ackfrag->length = 0;
-		// 此处放入sock的sndbuf中
-		// ACK 应该是立即发送的 这里存在问题		
-		rte_ring_mp_enqueue(stream->sndbuf, ackfrag);
-
-#else
-
-		uint8_t hdrlen = tcphdr->data_off >> 4;
-		int payloadlen = tcplen - hdrlen * 4;
-		
-		stream->rcv_nxt = stream->rcv_nxt + payloadlen;
-		stream->snd_nxt = ntohl(tcphdr->recv_ack);
-		
-		ng_tcp_send_ackpkt(stream, tcphdr);
-		
-#endif
-		// echo pkt
-#if 0
-		struct ng_tcp_fragment *echofrag = rte_malloc("ng_tcp_fragment", sizeof(struct ng_tcp_fragment), 0);
-		if (echofrag == NULL) return -1;
-		memset(echofrag, 0, sizeof(struct ng_tcp_fragment));
-
-		echofrag->dport = tcphdr->src_port;
-		echofrag->sport = tcphdr->dst_port;
-
-		echofrag->acknum = stream->rcv_nxt;
-		echofrag->seqnum = stream->snd_nxt;
-
-		echofrag->tcp_flags = RTE_TCP_ACK_FLAG | RTE_TCP_PSH_FLAG;
-		echofrag->windows = TCP_INITIAL_WINDOW;
-		echofrag->hdrlen_off = 0x50;
-
-		uint8_t *payload = (uint8_t*)tcphdr + hdrlen * 4;
-
-		echofrag->data = rte_malloc("unsigned char *", payloadlen, 0);
-		if (echofrag->data == NULL) {
-			rte_free(echofrag);
-			return -1;
-		}
-		memset(echofrag->data, 0, payloadlen);
-
-		rte_memcpy(echofrag->data, payload, payloadlen);
-		echofrag->length = payloadlen;
-
-		rte_ring_mp_enqueue(stream->sndbuf, echofrag);
-#endif
-
-	}
-	if (tcphdr->tcp_flags & RTE_TCP_ACK_FLAG) {
+#if ENABLE_TCP_APP
 
+	struct ng_tcp_stream *stream = get_stream_fromfd(sockfd);
+	if (stream != NULL) {
+		src = ng_tcp_epoll_source(stream);
+		poll = tcp_poll;
+		sock = stream;
 	}
-	// 收到FIN包
-	if (tcphdr->tcp_flags & RTE_TCP_FIN_FLAG) {
-
-		stream->status = NG_TCP_STATUS_CLOSE_WAIT;
-
-#if 0
-
-		struct ng_tcp_fragment *rfragment = rte_malloc("ng_tcp_fragment", sizeof(struct ng_tcp_fragment), 0);
-		if (rfragment == NULL) return -1;
-		memset(rfragment, 0, sizeof(struct ng_tcp_fragment));
-
-		rfragment->dport = ntohs(tcphdr->dst_port);
-		rfragment->sport = ntohs(tcphdr->src_port);
-
-		uint8_t hdrlen = tcphdr->data_off >> 4;
-		int payloadlen = tcplen - hdrlen * 4;
-
-		rfragment->length = 0;
-		rfragment->data = NULL;
-		
-		rte_ring_mp_enqueue(stream->rcvbuf, rfragment);
-		
-#else
-		// 往用户态放入
-		ng_tcp_enqueue_recvbuffer(stream, tcphdr, tcphdr->data_off >> 4);
 
 #endif
-		// send ack ptk
-		stream->rcv_nxt = stream->rcv_nxt + 1;
-		stream->snd_nxt = ntohl(tcphdr->recv_ack);
-		
-		ng_tcp_send_ackpkt(stream, tcphdr);
-
-	}
-
-	return 0;
-}
-
-static int ng_tcp_handle_close_wait(struct ng_tcp_stream *stream, struct rte_tcp_hdr *tcphdr) {
-
-	if (tcphdr->tcp_flags & RTE_TCP_FIN_FLAG) { //
-
-		if (stream->status == NG_TCP_STATUS_CLOSE_WAIT) {
-
-			
-
-		}
 
+	if (src == NULL) {
+		errno = EBADF;
+		return -1;
 	}
 
-	
-	return 0;
-
-}
-
-static int ng_tcp_handle_last_ack(struct ng_tcp_stream *stream, struct rte_tcp_hdr *tcphdr) {
-
-	if (tcphdr->tcp_flags & RTE_TCP_ACK_FLAG) {
-
-		if (stream->status == NG_TCP_STATUS_LAST_ACK) {
-
-			stream->status = NG_TCP_STATUS_CLOSED;
-
-			printf("ng_tcp_handle_last_ack\n");
-			struct ng_tcp_table *table = tcpInstance();
-			LL_REMOVE(stream, table->tcb_set);
-
-			rte_ring_free(stream->sndbuf);
-			rte_ring_free(stream->rcvbuf);
-
-			rte_free(stream);
-
-		}
-
+	int ret = ng_epoll_ctl(ep, op, src, poll, sock, event);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
 	}
 
 	return 0;
 }
 
+// timeout in ms, -1 forever; the calling thread spins, it never sleeps
+static int nepoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout) {
 
-static int ng_tcp_process(struct rte_mbuf *tcpmbuf) {
-
-	struct rte_ipv4_hdr *iphdr =  rte_pktmbuf_mtod_offset(tcpmbuf, struct rte_ipv4_hdr *, 
-				sizeof(struct rte_ether_hdr));
-	struct rte_tcp_hdr *tcphdr = (struct rte_tcp_hdr *)(iphdr + 1);	
-
-	// tcphdr, rte_ipv4_udptcp_cksum
-	uint16_t tcpcksum = tcphdr->cksum;
-	tcphdr->cksum = 0;
-	uint16_t cksum = rte_ipv4_udptcp_cksum(iphdr, tcphdr);
-	
-#if 1 //
-	if (cksum != tcpcksum) {
-		printf("cksum: %x, tcp cksum: %x\n", cksum, tcpcksum);
+	struct ng_epoll *ep = get_epoll_fromfd(epfd);
+	if (ep == NULL) {
+		errno = EBADF;
 		return -1;
 	}
-#endif
 
-	struct ng_tcp_stream *stream = ng_tcp_stream_search(iphdr->src_addr, iphdr->dst_addr, 
-		tcphdr->src_port, tcphdr->dst_port);
-	if (stream == NULL) { 
-		return -2;
+	int n = ng_epoll_wait(ep, events, maxevents, timeout);
+	if (n < 0) {
+		errno = -n;
+		return -1;
 	}
 
-	switch (stream->status) {
-
-		case NG_TCP_STATUS_CLOSED: //client 
-			break;
-			
-		case NG_TCP_STATUS_LISTEN: // server
-			ng_tcp_handle_listen(stream, tcphdr, iphdr);
-			break;
-
-		case NG_TCP_STATUS_SYN_RCVD: // server
-			ng_tcp_handle_syn_rcvd(stream, tcphdr);
-			break;
+	return n;
+}
 
-		case NG_TCP_STATUS_SYN_SENT: // client
-			break;
 
-		case NG_TCP_STATUS_ESTABLISHED: { // server | client
 
-			int tcplen = ntohs(iphdr->total_length) - sizeof(struct rte_ipv4_hdr);
-			
-			ng_tcp_handle_established(stream, tcphdr, tcplen);
-			
-			break;
-		}
-		case NG_TCP_STATUS_FIN_WAIT_1: //  ~client
-			break;
-			
-		case NG_TCP_STATUS_FIN_WAIT_2: // ~client
-			break;
-			
-		case NG_TCP_STATUS_CLOSING: // ~client
-			break;
-			
-		case NG_TCP_STATUS_TIME_WAIT: // ~client
-			break;
 
-		case NG_TCP_STATUS_CLOSE_WAIT: // ~server
-			ng_tcp_handle_close_wait(stream, tcphdr);
-			break;
-			
-		case NG_TCP_STATUS_LAST_ACK:  // ~server
-			ng_tcp_handle_last_ack(stream, tcphdr);
-			break;
 
-	}
 
-	return 0;
-}
 
+#define UDP_APP_RECV_BUFFER_SIZE	128
 
-static int ng_encode_tcp_apppkt(uint8_t *msg, uint32_t sip, uint32_t dip,
-	uint8_t *srcmac, uint8_t *dstmac, struct ng_tcp_fragment *fragment) {
+// 
+static int udp_server_entry(__attribute__((unused))  void *arg) {
 
-	// encode 
-	const unsigned total_len = fragment->length + sizeof(struct rte_ether_hdr) +
-							sizeof(struct rte_ipv4_hdr) + sizeof(struct rte_tcp_hdr) + 
-							fragment->optlen * sizeof(uint32_t);
+	int connfd = nsocket(AF_INET, SOCK_DGRAM, 0);
+	if (connfd == -1) {
+		printf("sockfd failed\n");
+		return -1;
+	} 
 
-	// 1 ethhdr
-	struct rte_ether_hdr *eth = (struct rte_ether_hdr *)msg;
-	rte_memcpy(eth->s_addr.addr_bytes, srcmac, RTE_ETHER_ADDR_LEN);
-	rte_memcpy(eth->d_addr.addr_bytes, dstmac, RTE_ETHER_ADDR_LEN);
-	eth->ether_type = htons(RTE_ETHER_TYPE_IPV4);
-	
+	struct sockaddr_in localaddr, clientaddr; // struct sockaddr 
+	memset(&localaddr, 0, sizeof(struct sockaddr_in));
 
-	// 2 iphdr 
-	struct rte_ipv4_hdr *ip = (struct rte_ipv4_hdr *)(msg + sizeof(struct rte_ether_hdr));
-	ip->version_ihl = 0x45;
-	ip->type_of_service = 0;
-	ip->total_length = htons(total_len - sizeof(struct rte_ether_hdr));
-	ip->packet_id = 0;
-	ip->fragment_offset = 0;
-	ip->time_to_live = 64; // ttl = 64
-	ip->next_proto_id = IPPROTO_TCP;
-	ip->src_addr = sip;
-	ip->dst_addr = dip;
+	localaddr.sin_port = htons(8889);
+	localaddr.sin_family = AF_INET;
+	localaddr.sin_addr.s_addr = inet_addr("192.168.0.115"); // 0.0.0.0
 	
-	ip->hdr_checksum = 0;
-	ip->hdr_checksum = rte_ipv4_cksum(ip);
 
-	// 3 udphdr 
-
-	struct rte_tcp_hdr *tcp = (struct rte_tcp_hdr *)(msg + sizeof(struct rte_ether_hdr) + sizeof(struct rte_ipv4_hdr));
-	tcp->src_port = fragment->sport;
-	tcp->dst_port = fragment->dport;
-	tcp->sent_seq = htonl(fragment->seqnum);
-	tcp->recv_ack = htonl(fragment->acknum);
-
-	tcp->data_off = fragment->hdrlen_off;
-	tcp->rx_win = fragment->windows;
-	tcp->tcp_urp = fragment->tcp_urp;
-	tcp->tcp_flags = fragment->tcp_flags;
-
-	if (fragment->data != NULL) {
-		uint8_t *payload = (uint8_t*)(tcp+1) + fragment->optlen * sizeof(uint32_t);
-		rte_memcpy(payload, fragment->data, fragment->length);
-	}
-
-	tcp->cksum = 0;
-	tcp->cksum = rte_ipv4_udptcp_cksum(ip, tcp);
+	nbind(connfd, (struct sockaddr*)&localaddr, sizeof(localaddr));
 
-	return 0;
-}
+	char buffer[UDP_APP_RECV_BUFFER_SIZE] = {0};
+	socklen_t addrlen = sizeof(clientaddr);
+	while (1) {
 
+		if (nrecvfrom(connfd, buffer, UDP_APP_RECV_BUFFER_SIZE, 0, 
+			(struct sockaddr*)&clientaddr, &addrlen) < 0) {
 
-static struct rte_mbuf * ng_tcp_pkt(struct rte_mempool *mbuf_pool, uint32_t sip, uint32_t dip,
-	uint8_t *srcmac, uint8_t *dstmac, struct ng_tcp_fragment *fragment) {
+			continue;
 
-	// mempool --> mbuf
+		} else {
 
-	const unsigned total_len = fragment->length + sizeof(struct rte_ether_hdr) +
-							sizeof(struct rte_ipv4_hdr) + sizeof(struct rte_tcp_hdr) + 
-							fragment->optlen * sizeof(uint32_t);
+			printf("recv from %s:%d, data:%s\n", inet_ntoa(clientaddr.sin_addr), 
+				ntohs(clientaddr.sin_port), buffer);
+			nsendto(connfd, buffer, strlen(buffer), 0, 
+				(struct sockaddr*)&clientaddr, sizeof(clientaddr));
+		}
 
-	struct rte_mbuf *mbuf = rte_pktmbuf_alloc(mbuf_pool);
-	if (!mbuf) {
-		rte_exit(EXIT_FAILURE, "ng_tcp_pkt rte_pktmbuf_alloc\n");
 	}
-	mbuf->pkt_len = total_len;
-	mbuf->data_len = total_len;
-
-	uint8_t *pktdata = rte_pktmbuf_mtod(mbuf, uint8_t*);
-
-	ng_encode_tcp_apppkt(pktdata, sip, dip, srcmac, dstmac, fragment);
 
-	return mbuf;
+	nclose(connfd);
 
 }
 
 
-// struct localhost , struct tcp_stream
-
-static int ng_tcp_out(struct rte_mempool *mbuf_pool) {
 
-	struct ng_tcp_table *table = tcpInstance();
-	
-	struct ng_tcp_stream *stream;
-	for (stream = table->tcb_set;stream != NULL;stream = stream->next) {
-
-		if (stream->sndbuf == NULL) continue; // listener
-
-		struct ng_tcp_fragment *fragment = NULL;		
-		int nb_snd = rte_ring_mc_dequeue(stream->sndbuf, (void**)&fragment);
-		if (nb_snd < 0) continue;
-
-		uint8_t *dstmac = ng_get_dst_macaddr(stream->sip); // 
-		if (dstmac == NULL) {
 
-			//printf("ng_send_arp\n");
-			struct rte_mbuf *arpbuf = ng_send_arp(mbuf_pool, RTE_ARP_OP_REQUEST, gDefaultArpMac, 
-				stream->dip, stream->sip);
-
-			struct inout_ring *ring = ringInstance();
-			rte_ring_mp_enqueue_burst(ring->out, (void **)&arpbuf, 1, NULL);
-
-			rte_ring_mp_enqueue(stream->sndbuf, fragment);
-
-		} else {
-
-			struct rte_mbuf *tcpbuf = ng_tcp_pkt(mbuf_pool, stream->dip, stream->sip, stream->localmac, dstmac, fragment);
-
-			struct inout_ring *ring = ringInstance();
-			rte_ring_mp_enqueue_burst(ring->out, (void **)&tcpbuf, 1, NULL);
-
-			if (fragment->data != NULL)
-				rte_free(fragment->data);
-			
-			rte_free(fragment);
-		}
-
-	}
+#endif
 
-	return 0;
-}
 
+#if ENABLE_TCP_APP // ngtcp
 
 #define BUFFER_SIZE	1024
-// hook
+#define MAX_EVENTS	64
+// hook: one thread serves all connections through nepoll
 static int tcp_server_entry(__attribute__((unused))  void *arg)  {
 
-	int listenfd = nsocket(AF_INET, SOCK_STREAM, 0);
+	int listenfd = nsocket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
 	if (listenfd == -1) {
 		return -1;
 	}
@@ -2132,30 +1530,59 @@ static int tcp_server_entry(__attribute__((unused))  void *arg)  {
 
 	nlisten(listenfd, 10);
 
+	int epfd = nepoll_create(TCP_MAX_STREAMS);
+	if (epfd == -1) {
+		nclose(listenfd);
+		return -1;
+	}
+
+	struct epoll_event ev, events[MAX_EVENTS];
+	ev.events = EPOLLIN;
+	ev.data.fd = listenfd;
+	nepoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &ev);
+
+	char buff[BUFFER_SIZE] = {0};
 	while (1) {
-		
-		struct sockaddr_in client;
-		socklen_t len = sizeof(client);
-		int connfd = naccept(listenfd, (struct sockaddr*)&client, &len);
 
-		char buff[BUFFER_SIZE] = {0};
-		while (1) {
+		int nready = nepoll_wait(epfd, events, MAX_EVENTS, -1);
 
-			int n = nrecv(connfd, buff, BUFFER_SIZE, 0); //block
-			if (n > 0) {
-				printf("recv: %s\n", buff);
-				nsend(connfd, buff, n, 0);
+		int i = 0;
+		for (i = 0;i < nready;i ++) {
 
-			} else if (n == 0) {
+			int fd = events[i].data.fd;
+			if (fd == listenfd) {
 
-				nclose(connfd);
-				break;
-			} else { //nonblock
+				// level triggered: connections left are reported again
+				struct sockaddr_in client;
+				socklen_t len = sizeof(client);
+				int connfd = naccept(listenfd, (struct sockaddr*)&client, &len);
+				if (connfd == -1) continue;
 
+				ev.events = EPOLLIN | EPOLLET;
+				ev.data.fd = connfd;
+				if (nepoll_ctl(epfd, EPOLL_CTL_ADD, connfd, &ev) == -1) {
+					nclose(connfd);
+				}
+				continue;
+			}
+
+			// edge triggered: read until the receive ring is empty
+			while (1) {
+
+				int n = nrecv(fd, buff, BUFFER_SIZE, MSG_DONTWAIT);
+				if (n > 0) {
+					nsend(fd, buff, n, 0);
+				} else {
+					if (n == 0 || errno != EAGAIN) {
+						nclose(fd);
+					}
+					break;
+				}
 			}
 		}
 
 	}
+	nclose(epfd);
 	nclose(listenfd);
 	
 
@@ -2166,6 +1593,7 @@ static int tcp_server_entry(__attribute__((unused))  void *arg)  {
 
 
 
+
 int main(int argc, char *argv[]) {
 
 	if (rte_eal_init(argc, argv) < 0) {
@@ -2173,27 +1601,54 @@ int main(int argc, char *argv[]) {
 		
 	}
 
+	// master: timer, then one lcore per app, the rest run the stack
+	if (rte_lcore_count() < 4) {
+		rte_exit(EXIT_FAILURE, "At least 4 lcores are needed\n");
+	}
+	gNbShards = RTE_MIN(rte_lcore_count() - 3, (unsigned int)NG_TCP_MAX_SHARDS);
+
 	struct rte_mempool *mbuf_pool = rte_pktmbuf_pool_create("mbuf pool", NUM_MBUFS,
-		0, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+		256, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
 	if (mbuf_pool == NULL) {
 		rte_exit(EXIT_FAILURE, "Could not create mbuf pool\n");
 	}
+	gMbufPool = mbuf_pool;
 
 	ng_init_port(mbuf_pool);
 
+	unsigned lcore_id = rte_lcore_id();
+
 	// 获取mac地址
 	rte_eth_macaddr_get(gDpdkPortId, (struct rte_ether_addr *)gSrcMac);
 
-#if ENABLE_TIMER
-
-	// 定时器 
+	// 定时器: arp 请求和 tcp 重传
 	rte_timer_subsystem_init();
 
+#if ENABLE_TCP_APP
+
+	struct ng_tcp_conf tcp_conf = {
+		.local_ip = gLocalIp,
+		.pool = mbuf_pool,
+		.nb_shards = gNbShards,
+		.max_streams = TCP_MAX_STREAMS,
+		.ring_size = TCP_STREAM_RING_SIZE,
+		.socket_id = rte_socket_id(),
+		.cc = NG_TCP_CC_CUBIC,
+	};
+	rte_memcpy(&tcp_conf.local_mac, gSrcMac, RTE_ETHER_ADDR_LEN);
+
+	if (ng_tcp_stack_init(&tcp_conf) < 0) {
+		rte_exit(EXIT_FAILURE, "tcp stack init failed\n");
+	}
+
+#endif
+
+#if ENABLE_TIMER
+
 	struct rte_timer arp_timer;
 	rte_timer_init(&arp_timer);
 
 	uint64_t hz = rte_get_timer_hz();
-	unsigned lcore_id = rte_lcore_id();
 	rte_timer_reset(&arp_timer, hz, PERIODICAL, lcore_id, arp_request_timer_cb, mbuf_pool);
 
 #endif
@@ -2205,19 +1660,26 @@ int main(int argc, char *argv[]) {
 		rte_exit(EXIT_FAILURE, "ring buffer init failed\n");
 	}
 
-	if (ring->in == NULL) {
-		ring->in = rte_ring_create("in ring", RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
-	}
 	if (ring->out == NULL) {
-		ring->out = rte_ring_create("out ring", RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
+		ring->out = rte_ring_create("out ring", RING_SIZE, rte_socket_id(), RING_F_SC_DEQ);
 	}
 
 #endif
 
 #if ENABLE_MULTHREAD
 
-	lcore_id = rte_get_next_lcore(lcore_id, 1, 0);
-	rte_eal_remote_launch(pkt_process, mbuf_pool, lcore_id);
+	// one qsbr thread id per shard
+	gQsbr = rte_zmalloc("qsbr", rte_rcu_qsbr_get_memsize(gNbShards), RTE_CACHE_LINE_SIZE);
+	if (gQsbr == NULL || rte_rcu_qsbr_init(gQsbr, gNbShards) != 0) {
+		rte_exit(EXIT_FAILURE, "qsbr init failed\n");
+	}
+
+	uint16_t shard;
+	for (shard = 0;shard < gNbShards;shard ++) {
+
+		lcore_id = rte_get_next_lcore(lcore_id, 1, 0);
+		rte_eal_remote_launch(pkt_process, (void *)(uintptr_t)shard, lcore_id);
+	}
 
 #endif
 
@@ -2238,33 +1700,6 @@ int main(int argc, char *argv[]) {
 
 	while (1) {
 
-		// rx
-		struct rte_mbuf *rx[BURST_SIZE];
-		unsigned num_recvd = rte_eth_rx_burst(gDpdkPortId, 0, rx, BURST_SIZE);
-		if (num_recvd > BURST_SIZE) {
-			rte_exit(EXIT_FAILURE, "Error receiving from eth\n");
-		} else if (num_recvd > 0) {
-
-			rte_ring_sp_enqueue_burst(ring->in, (void**)rx, num_recvd, NULL);
-		}
-
-		
-		// tx
-		struct rte_mbuf *tx[BURST_SIZE];
-		unsigned nb_tx = rte_ring_sc_dequeue_burst(ring->out, (void**)tx, BURST_SIZE, NULL);
-		if (nb_tx > 0) {
-
-			rte_eth_tx_burst(gDpdkPortId, 0, tx, nb_tx);
-
-			unsigned i = 0;
-			for (i = 0;i < nb_tx;i ++) {
-				rte_pktmbuf_free(tx[i]);
-			}
-			
-		}
-		
-
-
 #if ENABLE_TIMER
 
 		static uint64_t prev_tsc = 0, cur_tsc;
@@ -2283,7 +1718,3 @@ int main(int argc, char *argv[]) {
 	}
 
 }
-
-
-
-
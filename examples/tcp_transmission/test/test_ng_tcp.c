@@ -0,0 +1,390 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+/*
+ * Unit tests of the ng_tcp stack, without a port: both ends of the
+ * connections live in one single-shard stack, and the frames returned by
+ * ng_tcp_output_burst() are fed back to ng_tcp_input_burst(). Going
+ * through this loopback "wire" lets the tests drop and reorder frames.
+ *
+ * Build it like the example, from this directory, and run it without any
+ * device, e.g.: ./build/test_ng_tcp -l 0 --no-huge -m 256 --no-pci
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_ip.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_tcp.h>
+#include <rte_timer.h>
+
+#include "ng_tcp.h"
+
+#define TEST_SHARD	0
+#define TEST_PORT	8000
+#define TEST_BURST	32
+#define TEST_RING_SIZE	64
+#define TEST_RTO_MIN_MS	10
+/* well above the minimum RTO, far below the initial one */
+#define TEST_RTO_WAIT_MS	500
+#define TEST_OOO_SEGS	4
+
+#define TEST_ASSERT(cond, ...) do {					\
+	if (!(cond)) {							\
+		printf("%s:%d: ", __func__, __LINE__);			\
+		printf(__VA_ARGS__);					\
+		printf("\n");						\
+		return -1;						\
+	}								\
+} while (0)
+
+static struct rte_mempool *test_pool;
+static uint32_t test_ip;
+static struct rte_ether_addr test_mac = {
+	.addr_bytes = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 },
+};
+
+static struct ng_tcp_stream *listener;
+static struct ng_tcp_stream *client;
+static struct ng_tcp_stream *server;
+
+static uint8_t tx_data[TEST_OOO_SEGS * NG_TCP_MSS];
+static uint8_t rx_data[TEST_OOO_SEGS * NG_TCP_MSS];
+
+/*
+ * Get the frames the stack wants to send. Like a NIC would, the wire
+ * gathers each of them, header and chained payload, in one segment.
+ */
+static uint16_t
+wire_collect(struct rte_mbuf **frames)
+{
+	struct rte_mbuf *pkts[TEST_BURST];
+	uint16_t i, n;
+
+	n = ng_tcp_output_burst(TEST_SHARD, pkts, TEST_BURST);
+	for (i = 0; i < n; i++) {
+		uint32_t len = rte_pktmbuf_pkt_len(pkts[i]);
+		const void *p;
+		char *data;
+
+		frames[i] = rte_pktmbuf_alloc(test_pool);
+		if (frames[i] == NULL)
+			rte_exit(EXIT_FAILURE, "Cannot allocate frame\n");
+		data = rte_pktmbuf_append(frames[i], len);
+		p = rte_pktmbuf_read(pkts[i], 0, len, data);
+		if (p != data)
+			memcpy(data, p, len);
+		rte_pktmbuf_free(pkts[i]);
+	}
+
+	return n;
+}
+
+static void
+wire_deliver(struct rte_mbuf **frames, uint16_t n)
+{
+	if (n != 0)
+		ng_tcp_input_burst(TEST_SHARD, frames, n);
+}
+
+static void
+wire_drop(struct rte_mbuf **frames, uint16_t n)
+{
+	uint16_t i;
+
+	for (i = 0; i < n; i++)
+		rte_pktmbuf_free(frames[i]);
+}
+
+/* Exchange frames until both ends have nothing left to send. */
+static void
+wire_pump(void)
+{
+	struct rte_mbuf *frames[TEST_BURST];
+	unsigned int rounds;
+	uint16_t n;
+
+	for (rounds = 0; rounds < 64; rounds++) {
+		n = wire_collect(frames);
+		if (n == 0)
+			break;
+		wire_deliver(frames, n);
+	}
+}
+
+static const struct rte_tcp_hdr *
+frame_tcp(const struct rte_mbuf *m)
+{
+	return rte_pktmbuf_mtod_offset(m, const struct rte_tcp_hdr *,
+		sizeof(struct rte_ether_hdr) + sizeof(struct rte_ipv4_hdr));
+}
+
+static uint16_t
+frame_payload_len(const struct rte_mbuf *m)
+{
+	const struct rte_ipv4_hdr *ip = rte_pktmbuf_mtod_offset(m,
+		const struct rte_ipv4_hdr *, sizeof(struct rte_ether_hdr));
+
+	return rte_be_to_cpu_16(ip->total_length) - sizeof(*ip) -
+		(frame_tcp(m)->data_off >> 4) * 4;
+}
+
+/* Read up to len bytes, -EAGAIN if nothing came. */
+static ssize_t
+test_recv(struct ng_tcp_stream *stream, uint8_t *buf, size_t len)
+{
+	size_t got = 0;
+	ssize_t ret;
+
+	while (got < len) {
+		ret = ng_tcp_recv(stream, buf + got, len - got);
+		if (ret <= 0)
+			return got != 0 ? (ssize_t)got : ret;
+		got += ret;
+	}
+
+	return got;
+}
+
+static int
+test_handshake(void)
+{
+	struct rte_mbuf *frames[TEST_BURST];
+	struct ng_tcp_stats stats;
+	uint16_t n;
+
+	listener = ng_tcp_socket();
+	TEST_ASSERT(listener != NULL, "cannot allocate listener");
+	TEST_ASSERT(ng_tcp_bind(listener, test_ip,
+			rte_cpu_to_be_16(TEST_PORT)) == 0, "bind failed");
+	TEST_ASSERT(ng_tcp_listen(listener, 4) == 0, "listen failed");
+
+	client = ng_tcp_connect(test_ip, rte_cpu_to_be_16(TEST_PORT),
+			&test_mac);
+	TEST_ASSERT(client != NULL, "connect failed");
+
+	n = wire_collect(frames);
+	TEST_ASSERT(n == 1 && frame_tcp(frames[0])->tcp_flags ==
+			RTE_TCP_SYN_FLAG, "expected a SYN");
+	wire_deliver(frames, n);
+
+	n = wire_collect(frames);
+	TEST_ASSERT(n == 1 && frame_tcp(frames[0])->tcp_flags ==
+			(RTE_TCP_SYN_FLAG | RTE_TCP_ACK_FLAG),
+			"expected a SYN-ACK");
+	TEST_ASSERT(ng_tcp_accept(listener) == NULL,
+			"connection accepted before the handshake completed");
+	wire_deliver(frames, n);
+
+	TEST_ASSERT(ng_tcp_poll(client) & EPOLLOUT,
+			"client not writable once established");
+
+	n = wire_collect(frames);
+	TEST_ASSERT(n == 1 && frame_tcp(frames[0])->tcp_flags ==
+			RTE_TCP_ACK_FLAG, "expected the final ACK");
+	wire_deliver(frames, n);
+
+	server = ng_tcp_accept(listener);
+	TEST_ASSERT(server != NULL, "no connection to accept");
+	TEST_ASSERT(ng_tcp_poll(server) & EPOLLOUT,
+			"server not writable once established");
+
+	TEST_ASSERT(ng_tcp_stats_get(TEST_SHARD, &stats) == 0 &&
+			stats.streams == 2, "expected 2 streams");
+
+	return 0;
+}
+
+/*
+ * Send segments 0, 2, 3 then 1: 2 and 3 wait in the out of order queue,
+ * reported in SACK blocks, and are delivered once 1 fills the hole.
+ */
+static int
+test_out_of_order(void)
+{
+	static const uint16_t order[TEST_OOO_SEGS] = { 0, 2, 3, 1 };
+	struct rte_mbuf *frames[TEST_BURST], *acks[TEST_BURST];
+	struct ng_tcp_stats before, after;
+	uint16_t i, n, nb_acks;
+	ssize_t ret;
+
+	for (i = 0; i < sizeof(tx_data); i++)
+		tx_data[i] = rand();
+
+	ng_tcp_stats_get(TEST_SHARD, &before);
+
+	ret = ng_tcp_send(client, tx_data, sizeof(tx_data));
+	TEST_ASSERT(ret == (ssize_t)sizeof(tx_data), "send returned %zd",
+			ret);
+
+	n = wire_collect(frames);
+	TEST_ASSERT(n == TEST_OOO_SEGS, "expected %u segments, got %u",
+			TEST_OOO_SEGS, n);
+	for (i = 0; i < n; i++)
+		TEST_ASSERT(frame_payload_len(frames[i]) == NG_TCP_MSS,
+				"segment %u is not full sized", i);
+
+	for (i = 0; i < TEST_OOO_SEGS; i++) {
+		wire_deliver(&frames[order[i]], 1);
+
+		if (i == 0) {
+			ret = test_recv(server, rx_data, sizeof(rx_data));
+			TEST_ASSERT(ret == NG_TCP_MSS,
+					"in order segment not delivered");
+			/* the cumulative ACK is lost, to keep the hole */
+			wire_drop(acks, wire_collect(acks));
+		} else if (order[i] != 1) {
+			TEST_ASSERT(ng_tcp_recv(server, rx_data + NG_TCP_MSS,
+					sizeof(rx_data)) == -EAGAIN,
+					"data delivered past the hole");
+
+			/* answered at once, with a SACK block */
+			nb_acks = wire_collect(acks);
+			TEST_ASSERT(nb_acks == 1 &&
+					(frame_tcp(acks[0])->data_off >> 4) >
+					sizeof(struct rte_tcp_hdr) / 4,
+					"expected an ACK with SACK");
+			TEST_ASSERT(rte_be_to_cpu_32(
+					frame_tcp(acks[0])->recv_ack) ==
+					rte_be_to_cpu_32(
+					frame_tcp(frames[1])->sent_seq),
+					"ACK not at the hole");
+			wire_drop(acks, nb_acks);
+		}
+	}
+
+	ret = test_recv(server, rx_data + NG_TCP_MSS,
+			sizeof(rx_data) - NG_TCP_MSS);
+	TEST_ASSERT(ret == (ssize_t)(sizeof(rx_data) - NG_TCP_MSS),
+			"reassembled data missing, got %zd", ret);
+	TEST_ASSERT(memcmp(tx_data, rx_data, sizeof(tx_data)) == 0,
+			"reassembled data differs");
+
+	ng_tcp_stats_get(TEST_SHARD, &after);
+	TEST_ASSERT(after.ooo_segs - before.ooo_segs == 2,
+			"expected 2 out of order segments");
+
+	wire_pump();
+
+	return 0;
+}
+
+/* Drop a data segment: the retransmission timer must send it again. */
+static int
+test_retransmit_timeout(void)
+{
+	struct rte_mbuf *frames[TEST_BURST];
+	struct ng_tcp_stats before, after;
+	uint32_t seq;
+	uint64_t deadline;
+	uint16_t n;
+	ssize_t ret;
+
+	ng_tcp_stats_get(TEST_SHARD, &before);
+
+	ret = ng_tcp_send(client, tx_data, 100);
+	TEST_ASSERT(ret == 100, "send returned %zd", ret);
+
+	n = wire_collect(frames);
+	TEST_ASSERT(n == 1 && frame_payload_len(frames[0]) == 100,
+			"expected one data segment");
+	seq = rte_be_to_cpu_32(frame_tcp(frames[0])->sent_seq);
+	wire_drop(frames, n);
+
+	deadline = rte_get_timer_cycles() +
+		rte_get_timer_hz() * TEST_RTO_WAIT_MS / 1000;
+	do {
+		rte_delay_ms(1);
+		rte_timer_manage();
+		n = wire_collect(frames);
+	} while (n == 0 && rte_get_timer_cycles() < deadline);
+
+	TEST_ASSERT(n == 1, "segment not retransmitted within %u ms",
+			TEST_RTO_WAIT_MS);
+	TEST_ASSERT(rte_be_to_cpu_32(frame_tcp(frames[0])->sent_seq) == seq &&
+			frame_payload_len(frames[0]) == 100,
+			"retransmission differs from the lost segment");
+	wire_deliver(frames, n);
+	wire_pump();
+
+	ret = test_recv(server, rx_data, sizeof(rx_data));
+	TEST_ASSERT(ret == 100 && memcmp(tx_data, rx_data, 100) == 0,
+			"retransmitted data not received");
+
+	ng_tcp_stats_get(TEST_SHARD, &after);
+	TEST_ASSERT(after.timeouts - before.timeouts == 1 &&
+			after.retransmits - before.retransmits == 1,
+			"expected one timeout and one retransmission");
+
+	return 0;
+}
+
+static int
+test_close(void)
+{
+	ng_tcp_close(client);
+	wire_pump();
+
+	TEST_ASSERT(test_recv(server, rx_data, sizeof(rx_data)) == 0,
+			"server did not see the end of the stream");
+	ng_tcp_close(server);
+	wire_pump();
+
+	ng_tcp_close(listener);
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct ng_tcp_conf conf = {
+		.nb_shards = 1,
+		.max_streams = 16,
+		.ring_size = TEST_RING_SIZE,
+		.cc = NG_TCP_CC_NEWRENO,
+		.rto_min_ms = TEST_RTO_MIN_MS,
+	};
+	int ret;
+
+	ret = rte_eal_init(argc, argv);
+	if (ret < 0)
+		rte_exit(EXIT_FAILURE, "Cannot init EAL\n");
+
+	rte_timer_subsystem_init();
+
+	test_pool = rte_pktmbuf_pool_create("test_ng_tcp_pool", 1023, 32, 0,
+			RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+	if (test_pool == NULL)
+		rte_exit(EXIT_FAILURE, "Cannot create mbuf pool\n");
+
+	test_ip = rte_cpu_to_be_32(RTE_IPV4(10, 0, 0, 1));
+	conf.local_ip = test_ip;
+	conf.local_mac = test_mac;
+	conf.pool = test_pool;
+	conf.socket_id = rte_socket_id();
+	if (ng_tcp_stack_init(&conf) != 0)
+		rte_exit(EXIT_FAILURE, "Cannot init TCP stack\n");
+
+	ret = test_handshake();
+	if (ret == 0)
+		ret = test_out_of_order();
+	if (ret == 0)
+		ret = test_retransmit_timeout();
+	if (ret == 0)
+		ret = test_close();
+
+	printf("%s\n", ret == 0 ? "Test OK" : "Test Failed");
+
+	rte_eal_cleanup();
+
+	return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -19,12 +19,14 @@
 #include <rte_mbuf.h>
 #include <rte_malloc.h>
 #include <rte_timer.h>
+#include <rte_rcu_qsbr.h>
 
 
 #include <stdio.h>
 #include <arpa/inet.h>
 
 #include "arp.h"
+#include "ng_epoll.h"
 
 #define ENABLE_SEND		1
 #define ENABLE_ARP		1
@@ -107,6 +109,8 @@ static int udp_out(struct rte_mempool *mbuf_pool);
 
 int gDpdkPortId = 0;
 
+// the stack lcore reports quiescent states here, nepoll frees registrations after them
+static struct rte_rcu_qsbr *gQsbr = NULL;
 
 
 static const struct rte_eth_conf port_conf_default = {
@@ -439,6 +443,9 @@ static int pkt_process(void *arg)
 	struct rte_mempool *mbuf_pool = (struct rte_mempool *)arg;
 	struct inout_ring *ring = ringInstance();
 
+	rte_rcu_qsbr_thread_register(gQsbr, 0);
+	rte_rcu_qsbr_thread_online(gQsbr, 0);
+
 	while (1) 
 	{
 
@@ -579,6 +586,8 @@ static int pkt_process(void *arg)
 
 #endif
 
+		// no nepoll registration is held across loops
+		rte_rcu_qsbr_quiescent(gQsbr, 0);
 
 	}
 
@@ -610,8 +619,8 @@ struct localhost { //
 	struct localhost *prev; //
 	struct localhost *next;
 
-	pthread_cond_t cond;
-	pthread_mutex_t mutex;
+	int nonblock;
+	struct ng_epoll_source ev;
 
 };
 
@@ -619,9 +628,11 @@ static struct localhost *lhost = NULL;
 
 #define DEFAULT_FD_NUM	3
 
+static int fd_next = DEFAULT_FD_NUM;
+
 static int get_fd_frombitmap(void) {
 
-	int fd = DEFAULT_FD_NUM;
+	int fd = fd_next ++;
 	return fd;
 	
 }
@@ -721,11 +732,15 @@ static int udp_process(struct rte_mbuf *udpmbuf) {
 	rte_memcpy(ol->data, (unsigned char *)(udphdr+1), ol->length - sizeof(struct rte_udp_hdr));
 
 	// 加入recv ring buffer
-	rte_ring_mp_enqueue(host->rcvbuf, ol); // recv buffer
+	if (rte_ring_mp_enqueue(host->rcvbuf, ol) != 0) { // recv buffer
+		rte_free(ol->data);
+		rte_free(ol);
+		rte_pktmbuf_free(udpmbuf);
+		return -4;
+	}
 
-	pthread_mutex_lock(&host->mutex);
-	pthread_cond_signal(&host->cond); //唤醒一个等待线程
-	pthread_mutex_unlock(&host->mutex);
+	// 通知 epoll, 不再唤醒等待线程
+	ng_epoll_signal(&host->ev, EPOLLIN);
 
 	// 释放mbuf
 	rte_pktmbuf_free(udpmbuf);
@@ -867,12 +882,17 @@ static int nsocket(__attribute__((unused)) int domain, int type, __attribute__((
 	memset(host, 0, sizeof(struct localhost));
 
 	host->fd = fd;
+	host->nonblock = (type & SOCK_NONBLOCK) != 0;
+	type &= ~(SOCK_NONBLOCK | SOCK_CLOEXEC);
 	
 	if (type == SOCK_DGRAM)
 		host->protocol = IPPROTO_UDP;
 	
 
-	host->rcvbuf = rte_ring_create("recv buffer", RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
+	// ring 名字需唯一, 否则第二个 socket 创建失败
+	char name[RTE_RING_NAMESIZE];
+	snprintf(name, sizeof(name), "recv buffer %d", fd);
+	host->rcvbuf = rte_ring_create(name, RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
 	if (host->rcvbuf == NULL) {
 
 		rte_free(host);
@@ -880,7 +900,8 @@ static int nsocket(__attribute__((unused)) int domain, int type, __attribute__((
 	}
 
 	
-	host->sndbuf = rte_ring_create("send buffer", RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
+	snprintf(name, sizeof(name), "send buffer %d", fd);
+	host->sndbuf = rte_ring_create(name, RING_SIZE, rte_socket_id(), RING_F_SP_ENQ | RING_F_SC_DEQ);
 	if (host->sndbuf == NULL) {
 
 		rte_ring_free(host->rcvbuf);
@@ -889,12 +910,6 @@ static int nsocket(__attribute__((unused)) int domain, int type, __attribute__((
 		return -1;
 	}
 
-	pthread_cond_t blank_cond = PTHREAD_COND_INITIALIZER;
-	rte_memcpy(&host->cond, &blank_cond, sizeof(pthread_cond_t));
-
-	pthread_mutex_t blank_mutex = PTHREAD_MUTEX_INITIALIZER;
-	rte_memcpy(&host->mutex, &blank_mutex, sizeof(pthread_mutex_t));
-
 	LL_ADD(host, lhost);
 
 	return fd;
@@ -915,7 +930,7 @@ static int nbind(int sockfd, const struct sockaddr *addr,
 
 }
 
-static ssize_t nrecvfrom(int sockfd, void *buf, size_t len, __attribute__((unused))  int flags,
+static ssize_t nrecvfrom(int sockfd, void *buf, size_t len, int flags,
                         struct sockaddr *src_addr, __attribute__((unused))  socklen_t *addrlen) {
 
 	struct localhost *host =  get_hostinfo_fromfd(sockfd);
@@ -926,15 +941,15 @@ static ssize_t nrecvfrom(int sockfd, void *buf, size_t len, __attribute__((unuse
 	
 	struct sockaddr_in *saddr = (struct sockaddr_in *)src_addr;
 	
-	int nb = -1;
-	// 实现recv阻塞的原理
-	pthread_mutex_lock(&host->mutex);
-	while ((nb = rte_ring_mc_dequeue(host->rcvbuf, (void **)&ol)) < 0) {
-		// 在等待条件变量时，阻塞线程并释放互斥锁。
-		// 当被pthread_cond_signal或pthread_cond_broadcast唤醒时，线程重新获得锁，并继续执行。
-		pthread_cond_wait(&host->cond, &host->mutex);
+	// 实现recv阻塞的原理: 轮询 ring, 不睡眠也不切换线程
+	// 非阻塞 socket 或 MSG_DONTWAIT 立即返回 EAGAIN, 配合 nepoll 使用
+	while (rte_ring_mc_dequeue(host->rcvbuf, (void **)&ol) < 0) {
+		if (host->nonblock || (flags & MSG_DONTWAIT)) {
+			errno = EAGAIN;
+			return -1;
+		}
+		rte_pause();
 	}
-	pthread_mutex_unlock(&host->mutex);
 	
 
 	saddr->sin_port = ol->sport;
@@ -1011,11 +1026,49 @@ static ssize_t nsendto(int sockfd, const void *buf, size_t len, __attribute__((u
 	return len;
 }
 
+// fd --> nepoll instance
+struct ng_epfd {
+
+	int fd;
+	struct ng_epoll *ep;
+
+	struct ng_epfd *prev;
+	struct ng_epfd *next;
+};
+
+static struct ng_epfd *lepfd = NULL;
+
+static struct ng_epfd *get_epfd_fromfd(int epfd) {
+
+	struct ng_epfd *e;
+
+	for (e = lepfd; e != NULL;e = e->next) {
+
+		if (epfd == e->fd) {
+			return e;
+		}
+
+	}
+
+	return NULL;
+}
+
 static int nclose(int fd) {
 
 	struct localhost *host =  get_hostinfo_fromfd(fd);
-	if (host == NULL) return -1;
+	if (host == NULL) {
+
+		struct ng_epfd *e = get_epfd_fromfd(fd);
+		if (e == NULL) return -1;
 
+		LL_REMOVE(e, lepfd);
+		ng_epoll_free(e->ep);
+		rte_free(e);
+
+		return 0;
+	}
+
+	ng_epoll_source_remove(&host->ev);
 	LL_REMOVE(host, lhost);
 
 	if (host->rcvbuf) {
@@ -1027,6 +1080,85 @@ static int nclose(int fd) {
 
 	rte_free(host);
 
+	return 0;
+}
+
+// epoll
+// 协议栈 lcore 把就绪的 socket 放进无锁 ready ring, 一个应用线程轮询即可管理大量 socket
+
+static uint32_t udp_poll(void *sock) {
+
+	struct localhost *host = sock;
+	uint32_t events = 0;
+
+	if (!rte_ring_empty(host->rcvbuf)) events |= EPOLLIN;
+	if (rte_ring_free_count(host->sndbuf) != 0) events |= EPOLLOUT;
+
+	return events;
+}
+
+// unlike epoll_create(), size is the maximum number of sockets registered
+static int nepoll_create(int size) {
+
+	if (size <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	struct ng_epfd *e = rte_malloc("epfd", sizeof(struct ng_epfd), 0);
+	if (e == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	memset(e, 0, sizeof(struct ng_epfd));
+
+	e->ep = ng_epoll_create(size, gQsbr);
+	if (e->ep == NULL) {
+		errno = rte_errno;
+		rte_free(e);
+		return -1;
+	}
+	e->fd = get_fd_frombitmap();
+
+	LL_ADD(e, lepfd);
+
+	return e->fd;
+}
+
+static int nepoll_ctl(int epfd, int op, int sockfd, struct epoll_event *event) {
+
+	struct ng_epfd *e = get_epfd_fromfd(epfd);
+	struct localhost *host = get_hostinfo_fromfd(sockfd);
+	if (e == NULL || host == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	int ret = ng_epoll_ctl(e->ep, op, &host->ev, udp_poll, host, event);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return 0;
+}
+
+// timeout in ms, -1 forever; the calling thread spins, it never sleeps
+static int nepoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout) {
+
+	struct ng_epfd *e = get_epfd_fromfd(epfd);
+	if (e == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	int n = ng_epoll_wait(e->ep, events, maxevents, timeout);
+	if (n < 0) {
+		errno = -n;
+		return -1;
+	}
+
+	return n;
 }
 
 
@@ -1036,46 +1168,72 @@ static int nclose(int fd) {
 
 
 #define UDP_APP_RECV_BUFFER_SIZE	128
+#define UDP_APP_NB_PORTS		4
+#define UDP_APP_MAX_EVENTS		16
 
-// 
+// 一个线程通过 nepoll 服务多个端口
 static int udp_server_entry(__attribute__((unused))  void *arg) {
 
-	int connfd = nsocket(AF_INET, SOCK_DGRAM, 0);
-	if (connfd == -1) {
-		printf("sockfd failed\n");
+	int epfd = nepoll_create(UDP_APP_NB_PORTS);
+	if (epfd == -1) {
+		printf("nepoll_create failed\n");
 		return -1;
-	} 
+	}
 
-	struct sockaddr_in localaddr, clientaddr; // struct sockaddr 
-	memset(&localaddr, 0, sizeof(struct sockaddr_in));
+	int i = 0;
+	for (i = 0;i < UDP_APP_NB_PORTS;i ++) {
 
-	localaddr.sin_port = htons(8889);
-	localaddr.sin_family = AF_INET;
-	localaddr.sin_addr.s_addr = inet_addr("192.168.0.115"); // 0.0.0.0
-	
+		int connfd = nsocket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+		if (connfd == -1) {
+			printf("sockfd failed\n");
+			return -1;
+		} 
+
+		struct sockaddr_in localaddr; // struct sockaddr 
+		memset(&localaddr, 0, sizeof(struct sockaddr_in));
+
+		localaddr.sin_port = htons(8889 + i);
+		localaddr.sin_family = AF_INET;
+		localaddr.sin_addr.s_addr = inet_addr("192.168.0.115"); // 0.0.0.0
 
-	nbind(connfd, (struct sockaddr*)&localaddr, sizeof(localaddr));
+		nbind(connfd, (struct sockaddr*)&localaddr, sizeof(localaddr));
 
+		// level triggered: 未读完的数据下次 nepoll_wait 仍会返回
+		struct epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.fd = connfd;
+		nepoll_ctl(epfd, EPOLL_CTL_ADD, connfd, &ev);
+	}
+
+	struct sockaddr_in clientaddr;
 	char buffer[UDP_APP_RECV_BUFFER_SIZE] = {0};
 	socklen_t addrlen = sizeof(clientaddr);
+	struct epoll_event events[UDP_APP_MAX_EVENTS];
 	while (1) {
 
-		if (nrecvfrom(connfd, buffer, UDP_APP_RECV_BUFFER_SIZE, 0, 
-			(struct sockaddr*)&clientaddr, &addrlen) < 0) {
+		int nready = nepoll_wait(epfd, events, UDP_APP_MAX_EVENTS, -1);
 
-			continue;
+		for (i = 0;i < nready;i ++) {
 
-		} else {
+			int connfd = events[i].data.fd;
+
+			if (nrecvfrom(connfd, buffer, UDP_APP_RECV_BUFFER_SIZE, 0, 
+				(struct sockaddr*)&clientaddr, &addrlen) < 0) {
+
+				continue;
+
+			} else {
 
-			printf("recv from %s:%d, data:%s\n", inet_ntoa(clientaddr.sin_addr), 
-				ntohs(clientaddr.sin_port), buffer);
-			nsendto(connfd, buffer, strlen(buffer), 0, 
-				(struct sockaddr*)&clientaddr, sizeof(clientaddr));
+				printf("recv from %s:%d, data:%s\n", inet_ntoa(clientaddr.sin_addr), 
+					ntohs(clientaddr.sin_port), buffer);
+				nsendto(connfd, buffer, strlen(buffer), 0, 
+					(struct sockaddr*)&clientaddr, sizeof(clientaddr));
+			}
 		}
 
 	}
 
-	nclose(connfd);
+	nclose(epfd);
 
 }
 
@@ -1133,6 +1291,12 @@ int main(int argc, char *argv[]) {
 
 #if ENABLE_MULTHREAD
 
+	// 协议栈 lcore 是唯一的 qsbr 线程
+	gQsbr = rte_zmalloc("qsbr", rte_rcu_qsbr_get_memsize(1), RTE_CACHE_LINE_SIZE);
+	if (gQsbr == NULL || rte_rcu_qsbr_init(gQsbr, 1) != 0) {
+		rte_exit(EXIT_FAILURE, "qsbr init failed\n");
+	}
+
 	// 协议栈处理流程
 	lcore_id = rte_get_next_lcore(lcore_id, 1, 0);
 	rte_eal_remote_launch(pkt_process, mbuf_pool, lcore_id);
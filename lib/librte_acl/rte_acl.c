@@ -159,7 +159,7 @@ rte_acl_find_existing(const char *name)
 	acl_list = RTE_TAILQ_CAST(rte_acl_tailq.head, rte_acl_list);
 
 	rte_mcfg_tailq_read_lock();
-	TAILQ_FOREACH(te, acl_list, next) {
+	RTE_TAILQ_FOREACH(te, acl_list, next) {
 		ctx = (struct rte_acl_ctx *) te->data;
 		if (strncmp(name, ctx->name, sizeof(ctx->name)) == 0)
 			break;
@@ -187,7 +187,7 @@ rte_acl_free(struct rte_acl_ctx *ctx)
 	rte_mcfg_tailq_write_lock();
 
 	/* find our tailq entry */
-	TAILQ_FOREACH(te, acl_list, next) {
+	RTE_TAILQ_FOREACH(te, acl_list, next) {
 		if (te->data == (void *) ctx)
 			break;
 	}
@@ -196,7 +196,7 @@ rte_acl_free(struct rte_acl_ctx *ctx)
 		return;
 	}
 
-	TAILQ_REMOVE(acl_list, te, next);
+	RTE_TAILQ_REMOVE(acl_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
@@ -231,7 +231,7 @@ rte_acl_create(const struct rte_acl_param *param)
 	rte_mcfg_tailq_write_lock();
 
 	/* if we already have one with that name */
-	TAILQ_FOREACH(te, acl_list, next) {
+	RTE_TAILQ_FOREACH(te, acl_list, next) {
 		ctx = (struct rte_acl_ctx *) te->data;
 		if (strncmp(param->name, ctx->name, sizeof(ctx->name)) == 0)
 			break;
@@ -266,7 +266,7 @@ rte_acl_create(const struct rte_acl_param *param)
 
 		te->data = (void *) ctx;
 
-		TAILQ_INSERT_TAIL(acl_list, te, next);
+		RTE_TAILQ_INSERT_TAIL(acl_list, te, next);
 	}
 
 exit:
@@ -380,7 +380,7 @@ rte_acl_list_dump(void)
 	acl_list = RTE_TAILQ_CAST(rte_acl_tailq.head, rte_acl_list);
 
 	rte_mcfg_tailq_read_lock();
-	TAILQ_FOREACH(te, acl_list, next) {
+	RTE_TAILQ_FOREACH(te, acl_list, next) {
 		ctx = (struct rte_acl_ctx *) te->data;
 		rte_acl_dump(ctx);
 	}
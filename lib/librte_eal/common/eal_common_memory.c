@@ -518,6 +518,28 @@ rte_mem_set_dma_mask(uint8_t maskbits)
 			     RTE_MIN(mcfg->dma_maskbits, maskbits);
 }
 
+int
+rte_mem_attach(const void *addr, size_t len)
+{
+	int ret;
+
+	if (addr == NULL || len == 0) {
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	/* everything is mapped at startup */
+	if (!internal_config.lazy_mem_attach)
+		return 0;
+
+	/* the primary process cannot free pages while we map them */
+	rte_mcfg_mem_read_lock();
+	ret = eal_memalloc_attach(addr, len);
+	rte_mcfg_mem_read_unlock();
+
+	return ret;
+}
+
 /* return the number of memory channels */
 unsigned rte_memory_get_nchannel(void)
 {
@@ -25,6 +25,21 @@
 #include "malloc_elem.h"
 #include "eal_private.h"
 #include "eal_memcfg.h"
+#include "eal_internal_cfg.h"
+#include "eal_memalloc.h"
+
+/*
+ * in a secondary process started with --lazy-mem-attach, map the memory of a
+ * zone before handing it to the application. the memzone lock must be held,
+ * so that the zone cannot be freed meanwhile.
+ */
+static int
+memzone_attach(const struct rte_memzone *mz)
+{
+	if (!internal_config.lazy_mem_attach)
+		return 0;
+	return eal_memalloc_attach(mz->addr, mz->len);
+}
 
 static inline const struct rte_memzone *
 memzone_lookup_thread_unsafe(const char *name)
@@ -296,6 +311,8 @@ rte_memzone_lookup(const char *name)
 	rte_rwlock_read_lock(&mcfg->mlock);
 
 	memzone = memzone_lookup_thread_unsafe(name);
+	if (memzone != NULL && memzone_attach(memzone) < 0)
+		memzone = NULL;
 
 	rte_rwlock_read_unlock(&mcfg->mlock);
 
@@ -352,13 +369,6 @@ dump_memzone(const struct rte_memzone *mz, void *arg)
 	} while (cur_addr < mz_end);
 }
 
-/* Dump all reserved memory zones on console */
-void
-rte_memzone_dump(FILE *f)
-{
-	rte_memzone_walk(dump_memzone, f);
-}
-
 /*
  * Init the memzone subsystem
  */
@@ -389,9 +399,9 @@ rte_eal_memzone_init(void)
 	return ret;
 }
 
-/* Walk all reserved memory zones */
-void rte_memzone_walk(void (*func)(const struct rte_memzone *, void *),
-		      void *arg)
+static void
+memzone_walk(void (*func)(const struct rte_memzone *, void *), void *arg,
+		bool attach)
 {
 	struct rte_mem_config *mcfg;
 	struct rte_fbarray *arr;
@@ -404,8 +414,28 @@ void rte_memzone_walk(void (*func)(const struct rte_memzone *, void *),
 	i = rte_fbarray_find_next_used(arr, 0);
 	while (i >= 0) {
 		struct rte_memzone *mz = rte_fbarray_get(arr, i);
-		(*func)(mz, arg);
+
+		if (attach && memzone_attach(mz) < 0)
+			RTE_LOG(ERR, EAL, "%s(): cannot map memzone %s\n",
+				__func__, mz->name);
+		else
+			(*func)(mz, arg);
 		i = rte_fbarray_find_next_used(arr, i + 1);
 	}
 	rte_rwlock_read_unlock(&mcfg->mlock);
 }
+
+/* Dump all reserved memory zones on console */
+void
+rte_memzone_dump(FILE *f)
+{
+	/* only the descriptors are read, do not map the zones */
+	memzone_walk(dump_memzone, f, false);
+}
+
+/* Walk all reserved memory zones */
+void rte_memzone_walk(void (*func)(const struct rte_memzone *, void *),
+		      void *arg)
+{
+	memzone_walk(func, arg, true);
+}
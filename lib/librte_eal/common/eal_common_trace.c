@@ -0,0 +1,490 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#include <fnmatch.h>
+#include <inttypes.h>
+#include <regex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/queue.h>
+
+#include <rte_common.h>
+#include <rte_eal.h>
+#include <rte_errno.h>
+#include <rte_lcore.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+#include <rte_per_lcore.h>
+#include <rte_string_fns.h>
+
+#include "eal_trace.h"
+
+RTE_DEFINE_PER_LCORE(void *, _rte_trace_mem);
+
+static struct trace_point_head tp_list = STAILQ_HEAD_INITIALIZER(tp_list);
+static struct trace trace = {
+	.mode = RTE_TRACE_MODE_OVERWRITE,
+	.buff_len = TRACE_DEFAULT_BUFF_LEN,
+	.args = STAILQ_HEAD_INITIALIZER(trace.args),
+	.lock = RTE_SPINLOCK_INITIALIZER,
+};
+
+/* Trace point being registered, filled by __rte_trace_point_emit_field() */
+static struct trace_point *tp_cur;
+static size_t tp_cur_sz;
+static int tp_cur_errno;
+
+struct trace *
+trace_obj_get(void)
+{
+	return &trace;
+}
+
+struct trace_point_head *
+trace_list_head_get(void)
+{
+	return &tp_list;
+}
+
+int
+eal_trace_init(void)
+{
+	struct trace_arg *arg;
+
+	/* Trace memory should start with 8B aligned for natural alignment */
+	RTE_BUILD_BUG_ON((offsetof(struct __rte_trace_header, mem) % 8) != 0);
+
+	/* One of the trace point registration failed */
+	if (trace.register_errno) {
+		rte_errno = trace.register_errno;
+		goto fail;
+	}
+
+	if (trace_has_duplicate_entry())
+		goto fail;
+
+	/* Generate UUID ver 4, identifying this trace session */
+	trace_uuid_generate();
+
+	/* Save current epoch timestamp for future use */
+	if (trace_epoch_time_save() < 0)
+		goto fail;
+
+	/* Apply global configurations */
+	STAILQ_FOREACH(arg, &trace.args, next) {
+		if (trace_args_apply(arg->val) < 0)
+			goto fail;
+	}
+
+	rte_trace_mode_set(trace.mode);
+
+	return 0;
+
+fail:
+	trace_err("failed to initialize trace [%s]", rte_strerror(rte_errno));
+	return -rte_errno;
+}
+
+void
+eal_trace_fini(void)
+{
+	if (rte_trace_is_enabled())
+		rte_trace_save();
+	trace_mem_free();
+	trace_metadata_destroy();
+	eal_trace_args_free();
+}
+
+bool
+rte_trace_is_enabled(void)
+{
+	return __atomic_load_n(&trace.status, __ATOMIC_ACQUIRE) != 0;
+}
+
+static void
+trace_mode_set(rte_trace_point_t *t, enum rte_trace_mode mode)
+{
+	if (mode == RTE_TRACE_MODE_OVERWRITE)
+		__atomic_and_fetch(t, ~__RTE_TRACE_FIELD_ENABLE_DISCARD,
+			__ATOMIC_RELEASE);
+	else
+		__atomic_or_fetch(t, __RTE_TRACE_FIELD_ENABLE_DISCARD,
+			__ATOMIC_RELEASE);
+}
+
+void
+rte_trace_mode_set(enum rte_trace_mode mode)
+{
+	struct trace_point *tp;
+
+	STAILQ_FOREACH(tp, &tp_list, next)
+		trace_mode_set(tp->handle, mode);
+
+	trace.mode = mode;
+}
+
+enum
+rte_trace_mode rte_trace_mode_get(void)
+{
+	return trace.mode;
+}
+
+static bool
+trace_point_is_invalid(rte_trace_point_t *t)
+{
+	struct trace_point *tp;
+
+	if (t == NULL)
+		return true;
+
+	STAILQ_FOREACH(tp, &tp_list, next) {
+		if (tp->handle == t)
+			return false;
+	}
+
+	return true;
+}
+
+int
+rte_trace_point_is_enabled(rte_trace_point_t *t)
+{
+	uint64_t val;
+
+	if (trace_point_is_invalid(t))
+		return 0;
+
+	val = __atomic_load_n(t, __ATOMIC_ACQUIRE);
+	return (val & __RTE_TRACE_FIELD_ENABLE_MASK) != 0;
+}
+
+int
+rte_trace_point_enable(rte_trace_point_t *t)
+{
+	uint64_t prev;
+
+	if (trace_point_is_invalid(t))
+		return -ERANGE;
+
+	prev = __atomic_fetch_or(t, __RTE_TRACE_FIELD_ENABLE_MASK,
+		__ATOMIC_RELEASE);
+	if ((prev & __RTE_TRACE_FIELD_ENABLE_MASK) == 0)
+		__atomic_add_fetch(&trace.status, 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int
+rte_trace_point_disable(rte_trace_point_t *t)
+{
+	uint64_t prev;
+
+	if (trace_point_is_invalid(t))
+		return -ERANGE;
+
+	prev = __atomic_fetch_and(t, ~__RTE_TRACE_FIELD_ENABLE_MASK,
+		__ATOMIC_RELEASE);
+	if ((prev & __RTE_TRACE_FIELD_ENABLE_MASK) != 0)
+		__atomic_sub_fetch(&trace.status, 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int
+rte_trace_pattern(const char *pattern, bool enable)
+{
+	struct trace_point *tp;
+	int rc = 0, found = 0;
+
+	STAILQ_FOREACH(tp, &tp_list, next) {
+		if (fnmatch(pattern, tp->name, 0) != 0)
+			continue;
+
+		if (enable)
+			rc = rte_trace_point_enable(tp->handle);
+		else
+			rc = rte_trace_point_disable(tp->handle);
+		if (rc < 0)
+			return rc;
+		found = 1;
+	}
+
+	return found;
+}
+
+int
+rte_trace_regexp(const char *regex, bool enable)
+{
+	struct trace_point *tp;
+	int rc = 0, found = 0;
+	regex_t r;
+
+	if (regcomp(&r, regex, 0) != 0)
+		return -EINVAL;
+
+	STAILQ_FOREACH(tp, &tp_list, next) {
+		if (regexec(&r, tp->name, 0, NULL, 0) != 0)
+			continue;
+
+		if (enable)
+			rc = rte_trace_point_enable(tp->handle);
+		else
+			rc = rte_trace_point_disable(tp->handle);
+		if (rc < 0)
+			break;
+		found = 1;
+	}
+	regfree(&r);
+
+	return rc < 0 ? rc : found;
+}
+
+rte_trace_point_t *
+rte_trace_point_lookup(const char *name)
+{
+	struct trace_point *tp;
+
+	if (name == NULL)
+		return NULL;
+
+	STAILQ_FOREACH(tp, &tp_list, next) {
+		if (strncmp(tp->name, name, TRACE_POINT_NAME_SIZE) == 0)
+			return tp->handle;
+	}
+
+	return NULL;
+}
+
+static void
+trace_point_dump(FILE *f, struct trace_point *tp)
+{
+	rte_trace_point_t *handle = tp->handle;
+
+	fprintf(f, "\tid %d, %s, size is %d, %s\n",
+		trace_id_get(handle), tp->name,
+		(uint16_t)(*handle & __RTE_TRACE_FIELD_SIZE_MASK),
+		rte_trace_point_is_enabled(handle) ? "enabled" : "disabled");
+}
+
+static void
+trace_lcore_mem_dump(FILE *f)
+{
+	struct __rte_trace_header *header;
+	uint32_t count;
+
+	if (trace.nb_trace_mem_list == 0)
+		return;
+
+	rte_spinlock_lock(&trace.lock);
+	fprintf(f, "nb_trace_mem_list = %d\n", trace.nb_trace_mem_list);
+	fprintf(f, "\nTrace mem info\n--------------\n");
+	for (count = 0; count < trace.nb_trace_mem_list; count++) {
+		header = trace.lcore_meta[count].mem;
+		fprintf(f, "\tid %d, mem=%p, area=%s, lcore_id=%d, name=%s\n",
+			count, header,
+			trace_area_to_string(trace.lcore_meta[count].area),
+			header->stream_header.lcore_id,
+			header->stream_header.thread_name);
+		fprintf(f, "\t\toffset=0x%x, len=0x%x\n",
+			header->offset, header->len);
+	}
+	rte_spinlock_unlock(&trace.lock);
+}
+
+void
+rte_trace_dump(FILE *f)
+{
+	struct trace_point *tp;
+
+	fprintf(f, "\nGlobal info\n-----------\n");
+	fprintf(f, "status = %s\n",
+		rte_trace_is_enabled() ? "enabled" : "disabled");
+	fprintf(f, "mode = %s\n",
+		trace_mode_to_string(rte_trace_mode_get()));
+	fprintf(f, "dir = %s\n", trace.dir);
+	fprintf(f, "buffer len = %d\n", trace.buff_len);
+	fprintf(f, "number of trace points = %d\n", trace.nb_trace_points);
+
+	trace_lcore_mem_dump(f);
+	fprintf(f, "\nTrace point info\n----------------\n");
+	STAILQ_FOREACH(tp, &tp_list, next)
+		trace_point_dump(f, tp);
+}
+
+void
+__rte_trace_mem_per_thread_alloc(void)
+{
+	struct __rte_trace_header *header = NULL;
+	struct thread_mem_meta *meta;
+	unsigned int lcore_id;
+	uint32_t count;
+
+	if (RTE_PER_LCORE(_rte_trace_mem))
+		return;
+
+	rte_spinlock_lock(&trace.lock);
+
+	count = trace.nb_trace_mem_list;
+
+	/* Allocate room for storing the thread trace mem meta */
+	meta = realloc(trace.lcore_meta, sizeof(*meta) * (count + 1));
+	if (meta == NULL) {
+		trace_crit("trace mem meta memory realloc failed");
+		goto fail;
+	}
+	trace.lcore_meta = meta;
+
+	/* First attempt from huge page */
+	header = rte_malloc(NULL, trace_mem_sz(trace.buff_len), 8);
+	if (header != NULL) {
+		meta[count].area = TRACE_AREA_HUGEPAGE;
+		goto found;
+	}
+
+	/* Second attempt from heap */
+	header = malloc(trace_mem_sz(trace.buff_len));
+	if (header == NULL) {
+		trace_crit("trace mem malloc attempt failed");
+		goto fail;
+	}
+	meta[count].area = TRACE_AREA_HEAP;
+
+found:
+	header->offset = 0;
+	header->len = trace.buff_len;
+	header->stream_header.magic = TRACE_CTF_MAGIC;
+	rte_uuid_copy(header->stream_header.uuid, trace.uuid);
+
+	/* Store the thread name, the lcore id or the system thread id */
+	lcore_id = rte_lcore_id();
+	header->stream_header.lcore_id = lcore_id;
+	memset(header->stream_header.thread_name, 0,
+		sizeof(header->stream_header.thread_name));
+	if (lcore_id != LCORE_ID_ANY)
+		snprintf(header->stream_header.thread_name,
+			sizeof(header->stream_header.thread_name),
+			"lcore-%u", lcore_id);
+	else
+		snprintf(header->stream_header.thread_name,
+			sizeof(header->stream_header.thread_name),
+			"thread-%d", rte_gettid());
+
+	meta[count].mem = header;
+	trace.nb_trace_mem_list++;
+fail:
+	RTE_PER_LCORE(_rte_trace_mem) = header;
+	rte_spinlock_unlock(&trace.lock);
+}
+
+void
+trace_mem_free(void)
+{
+	uint32_t count;
+
+	rte_spinlock_lock(&trace.lock);
+	for (count = 0; count < trace.nb_trace_mem_list; count++) {
+		if (trace.lcore_meta[count].area == TRACE_AREA_HUGEPAGE)
+			rte_free(trace.lcore_meta[count].mem);
+		else
+			free(trace.lcore_meta[count].mem);
+	}
+	free(trace.lcore_meta);
+	trace.lcore_meta = NULL;
+	trace.nb_trace_mem_list = 0;
+	RTE_PER_LCORE(_rte_trace_mem) = NULL;
+	rte_spinlock_unlock(&trace.lock);
+}
+
+void
+__rte_trace_point_emit_field(size_t sz, const char *in, const char *datatype)
+{
+	char *field;
+	size_t len;
+	int rc;
+
+	if (tp_cur == NULL)
+		return;
+
+	field = tp_cur->ctf_field;
+	len = strlen(field);
+	rc = snprintf(field + len, TRACE_CTF_FIELD_SIZE - len,
+		"%s %s;", datatype, in);
+	if (rc < 0 || (size_t)rc >= TRACE_CTF_FIELD_SIZE - len)
+		tp_cur_errno = ENOSPC;
+	tp_cur_sz += sz;
+}
+
+int
+__rte_trace_point_register(rte_trace_point_t *handle, const char *name,
+		void (*register_fn)(void))
+{
+	struct trace_point *tp;
+
+	/* Sanity checks of arguments */
+	if (name == NULL || register_fn == NULL || handle == NULL) {
+		trace_err("invalid arguments");
+		rte_errno = EINVAL;
+		goto fail;
+	}
+
+	/* Are we running out of space to store trace points? */
+	if (trace.nb_trace_points >
+			(__RTE_TRACE_FIELD_ID_MASK >> __RTE_TRACE_FIELD_ID_SHIFT)) {
+		trace_err("trace point exceeds the max count");
+		rte_errno = ENOSPC;
+		goto fail;
+	}
+
+	/* Get the size of the trace point and the description of its fields */
+	tp = calloc(1, sizeof(struct trace_point));
+	if (tp == NULL) {
+		trace_err("fail to allocate trace point memory");
+		rte_errno = ENOMEM;
+		goto fail;
+	}
+
+	tp_cur = tp;
+	tp_cur_sz = __RTE_TRACE_EVENT_HEADER_SZ;
+	tp_cur_errno = 0;
+	register_fn();
+	tp_cur = NULL;
+
+	if (tp_cur_errno != 0) {
+		trace_err("CTF field description is too long for %s", name);
+		rte_errno = tp_cur_errno;
+		goto free;
+	}
+
+	if (tp_cur_sz > __RTE_TRACE_FIELD_SIZE_MASK) {
+		trace_err("trace point size overflowed for %s", name);
+		rte_errno = E2BIG;
+		goto free;
+	}
+
+	/* Initialize the trace point */
+	if (strlcpy(tp->name, name, TRACE_POINT_NAME_SIZE) >=
+			TRACE_POINT_NAME_SIZE) {
+		trace_err("name is too long");
+		rte_errno = E2BIG;
+		goto free;
+	}
+
+	/* Form the trace handle: event size and id */
+	*handle = tp_cur_sz;
+	*handle |= (uint64_t)trace.nb_trace_points <<
+		__RTE_TRACE_FIELD_ID_SHIFT;
+
+	trace.nb_trace_points++;
+	tp->handle = handle;
+
+	/* Add the trace point at tail */
+	STAILQ_INSERT_TAIL(&tp_list, tp, next);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	return 0;
+free:
+	free(tp);
+fail:
+	if (trace.register_errno == 0)
+		trace.register_errno = rte_errno;
+
+	return -rte_errno;
+}
@@ -0,0 +1,218 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rte_byteorder.h>
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_errno.h>
+#include <rte_time.h>
+#include <rte_uuid.h>
+#include <rte_version.h>
+
+#include "eal_trace.h"
+
+/*
+ * The Common Trace Format metadata is written in the Trace Stream
+ * Description Language (TSDL). It describes the layout of the per thread
+ * streams saved by rte_trace_save(): a packet header and context made of
+ * struct __rte_trace_stream_header, followed by the events. Each event is
+ * aligned on 8 bytes and starts with a 48 bits timestamp and a 16 bits id,
+ * followed by the fields of its trace point, without padding.
+ */
+
+static void
+meta_header_emit(FILE *f)
+{
+	fprintf(f,
+		"/* CTF 1.8 */\n"
+		"typealias integer {size = 8; base = x;} uint8_t;\n"
+		"typealias integer {size = 16; base = x;} uint16_t;\n"
+		"typealias integer {size = 32; base = x;} uint32_t;\n"
+		"typealias integer {size = 64; base = x;} uint64_t;\n"
+		"typealias integer {size = 8; signed = true;} int8_t;\n"
+		"typealias integer {size = 16; signed = true;} int16_t;\n"
+		"typealias integer {size = 32; signed = true;} int32_t;\n"
+		"typealias integer {size = 64; signed = true;} int64_t;\n"
+		"typealias integer {size = %u; base = x;} uintptr_t;\n"
+		"typealias floating_point {\n"
+		"    exp_dig = 8;\n"
+		"    mant_dig = 24;\n"
+		"} float;\n"
+		"typealias floating_point {\n"
+		"    exp_dig = 11;\n"
+		"    mant_dig = 53;\n"
+		"} double;\n"
+		"typealias integer {size = 8; base = x; encoding = ASCII;} "
+		"string_bounded_t;\n\n",
+		(unsigned int)(sizeof(void *) * CHAR_BIT));
+}
+
+static void
+meta_trace_emit(FILE *f, struct trace *trace)
+{
+	char uuid_str[RTE_UUID_STRLEN];
+
+	rte_uuid_unparse(trace->uuid, uuid_str, sizeof(uuid_str));
+	fprintf(f,
+		"trace {\n"
+		"    major = 1;\n"
+		"    minor = 8;\n"
+		"    uuid = \"%s\";\n"
+		"    byte_order = %s;\n"
+		"    packet.header := struct {\n"
+		"        uint32_t magic;\n"
+		"        uint8_t uuid[16];\n"
+		"    };\n"
+		"};\n\n",
+		uuid_str,
+		RTE_BYTE_ORDER == RTE_LITTLE_ENDIAN ? "le" : "be");
+}
+
+static void
+meta_env_emit(FILE *f)
+{
+	fprintf(f,
+		"env {\n"
+		"    dpdk_version = \"%s\";\n"
+		"    tracer_name = \"dpdk\";\n"
+		"};\n\n",
+		rte_version());
+}
+
+static void
+meta_clock_emit(FILE *f, struct trace *trace)
+{
+	const uint64_t ts_mask =
+		(1ULL << __RTE_TRACE_EVENT_HEADER_TS_BITS) - 1;
+	uint64_t freq = rte_get_tsc_hz();
+	uint64_t ticks, ticks_sec, ticks_rem;
+	uint64_t offset_s, offset;
+
+	/*
+	 * The clock value of an event is its 48 bits timestamp. Its time
+	 * since the epoch is offset_s + (offset + value) / freq, so that the
+	 * timestamp of the trace initialization matches the epoch saved at
+	 * the same time.
+	 */
+	ticks = trace->uptime_ticks & ts_mask;
+	ticks_sec = ticks / freq;
+	ticks_rem = ticks % freq;
+	offset_s = trace->epoch_sec - ticks_sec;
+	offset = (trace->epoch_nsec * freq) / NSEC_PER_SEC;
+	if (offset < ticks_rem) {
+		offset_s--;
+		offset += freq;
+	}
+	offset -= ticks_rem;
+
+	fprintf(f,
+		"clock {\n"
+		"    name = \"dpdk\";\n"
+		"    freq = %" PRIu64 ";\n"
+		"    offset_s = %" PRIu64 ";\n"
+		"    offset = %" PRIu64 ";\n"
+		"};\n\n"
+		"typealias integer {\n"
+		"    size = %d; align = 1; signed = false;\n"
+		"    map = clock.dpdk.value;\n"
+		"} uint48_clock_dpdk_t;\n\n",
+		freq, offset_s, offset, __RTE_TRACE_EVENT_HEADER_TS_BITS);
+}
+
+static void
+meta_stream_emit(FILE *f)
+{
+	fprintf(f,
+		"stream {\n"
+		"    packet.context := struct {\n"
+		"        uint32_t cpu_id;\n"
+		"        string_bounded_t name[%d];\n"
+		"    };\n"
+		"    event.header := struct {\n"
+		"        uint48_clock_dpdk_t timestamp;\n"
+		"        uint16_t id;\n"
+		"    } align(64);\n"
+		"};\n\n",
+		__RTE_TRACE_EMIT_STRING_LEN_MAX);
+}
+
+static void
+meta_events_emit(FILE *f)
+{
+	struct trace_point_head *tp_list = trace_list_head_get();
+	struct trace_point *tp;
+
+	STAILQ_FOREACH(tp, tp_list, next) {
+		fprintf(f,
+			"event {\n"
+			"    id = %d;\n"
+			"    name = \"%s\";\n"
+			"    fields := struct {\n"
+			"        %s\n"
+			"    };\n"
+			"};\n\n",
+			trace_id_get(tp->handle), tp->name, tp->ctf_field);
+	}
+}
+
+int
+trace_metadata_create(void)
+{
+	struct trace *trace = trace_obj_get();
+	size_t size;
+	char *meta;
+	FILE *f;
+
+	f = open_memstream(&meta, &size);
+	if (f == NULL) {
+		rte_errno = ENOMEM;
+		return -ENOMEM;
+	}
+
+	meta_header_emit(f);
+	meta_trace_emit(f, trace);
+	meta_env_emit(f);
+	meta_clock_emit(f, trace);
+	meta_stream_emit(f);
+	meta_events_emit(f);
+
+	if (fclose(f) != 0) {
+		free(meta);
+		rte_errno = ENOMEM;
+		return -ENOMEM;
+	}
+
+	free(trace->ctf_meta);
+	trace->ctf_meta = meta;
+	return 0;
+}
+
+void
+trace_metadata_destroy(void)
+{
+	struct trace *trace = trace_obj_get();
+
+	free(trace->ctf_meta);
+	trace->ctf_meta = NULL;
+}
+
+int
+rte_trace_metadata_dump(FILE *f)
+{
+	struct trace *trace = trace_obj_get();
+	int rc;
+
+	/* Describe the trace points registered so far */
+	rc = trace_metadata_create();
+	if (rc < 0)
+		return rc;
+
+	rc = fprintf(f, "%s", trace->ctf_meta);
+	return rc < 0 ? rc : 0;
+}
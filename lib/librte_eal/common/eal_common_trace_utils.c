@@ -0,0 +1,396 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_errno.h>
+#include <rte_log.h>
+#include <rte_random.h>
+#include <rte_string_fns.h>
+
+#include "eal_trace.h"
+
+const char *
+trace_mode_to_string(enum rte_trace_mode mode)
+{
+	switch (mode) {
+	case RTE_TRACE_MODE_OVERWRITE: return "overwrite";
+	case RTE_TRACE_MODE_DISCARD: return "discard";
+	default: return "unknown";
+	}
+}
+
+const char *
+trace_area_to_string(enum trace_area_e area)
+{
+	switch (area) {
+	case TRACE_AREA_HEAP: return "heap";
+	case TRACE_AREA_HUGEPAGE: return "hugepage";
+	default: return "unknown";
+	}
+}
+
+bool
+trace_has_duplicate_entry(void)
+{
+	struct trace_point_head *tp_list = trace_list_head_get();
+	struct trace_point *tp, *tmp;
+	int count;
+
+	/* Do a sanity check for duplicate trace point name */
+	STAILQ_FOREACH(tp, tp_list, next) {
+		count = 0;
+		STAILQ_FOREACH(tmp, tp_list, next) {
+			if (strncmp(tp->name, tmp->name,
+					TRACE_POINT_NAME_SIZE) == 0)
+				count++;
+			if (count > 1) {
+				trace_err("found duplicate entry %s", tp->name);
+				rte_errno = EEXIST;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void
+trace_uuid_generate(void)
+{
+	struct trace *trace = trace_obj_get();
+	uint64_t rnd;
+	unsigned int i;
+
+	/* Random UUID, as described in RFC 4122 section 4.4 */
+	for (i = 0; i < sizeof(trace->uuid); i += sizeof(rnd)) {
+		rnd = rte_rand();
+		memcpy(&trace->uuid[i], &rnd, sizeof(rnd));
+	}
+	trace->uuid[6] = (trace->uuid[6] & 0x0f) | 0x40;
+	trace->uuid[8] = (trace->uuid[8] & 0x3f) | 0x80;
+}
+
+static int
+trace_session_name_generate(char *trace_dir)
+{
+	struct trace *trace = trace_obj_get();
+	time_t tm = trace->epoch_sec;
+	struct tm *tm_result;
+	int rc;
+
+	tm_result = localtime(&tm);
+	if (tm_result == NULL)
+		return -EFAULT;
+
+	rc = rte_strscpy(trace_dir, "rte-", TRACE_PREFIX_LEN);
+	if (rc < 0)
+		return rc;
+
+	rc = strftime(trace_dir + rc, TRACE_DIR_STR_LEN - rc,
+			"%Y-%m-%d-%p-%I-%M-%S", tm_result);
+	if (rc == 0)
+		return -EINVAL;
+
+	return 0;
+}
+
+int
+eal_trace_args_save(const char *val)
+{
+	struct trace *trace = trace_obj_get();
+	struct trace_arg *arg;
+	size_t len;
+
+	len = strlen(val);
+	if (len == 0) {
+		trace_err("empty trace argument");
+		return -EINVAL;
+	}
+
+	arg = malloc(sizeof(*arg) + len + 1);
+	if (arg == NULL) {
+		trace_err("failed to allocate memory for %s", val);
+		return -ENOMEM;
+	}
+
+	memcpy(arg->val, val, len + 1);
+	STAILQ_INSERT_TAIL(&trace->args, arg, next);
+	return 0;
+}
+
+void
+eal_trace_args_free(void)
+{
+	struct trace *trace = trace_obj_get();
+	struct trace_arg *arg;
+
+	while (!STAILQ_EMPTY(&trace->args)) {
+		arg = STAILQ_FIRST(&trace->args);
+		STAILQ_REMOVE_HEAD(&trace->args, next);
+		free(arg);
+	}
+}
+
+int
+trace_args_apply(const char *arg)
+{
+	if (rte_trace_regexp(arg, true) < 0) {
+		trace_err("cannot enable trace for %s", arg);
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+int
+eal_trace_bufsz_args_save(const char *val)
+{
+	struct trace *trace = trace_obj_get();
+	uint64_t bufsz;
+
+	bufsz = rte_str_to_size(val);
+	if (bufsz == 0) {
+		trace_err("buffer size cannot be zero");
+		return -EINVAL;
+	}
+
+	if (bufsz > UINT32_MAX - sizeof(struct __rte_trace_header)) {
+		trace_err("buffer size %s is too large", val);
+		return -EINVAL;
+	}
+
+	trace->buff_len = bufsz;
+	return 0;
+}
+
+int
+eal_trace_mode_args_save(const char *val)
+{
+	struct trace *trace = trace_obj_get();
+	size_t len = strlen(val);
+
+	if (len == 0) {
+		trace_err("value is not provided with option");
+		return -EINVAL;
+	}
+
+	if (strncmp(val, "overwrite", len) == 0)
+		trace->mode = RTE_TRACE_MODE_OVERWRITE;
+	else if (strncmp(val, "discard", len) == 0)
+		trace->mode = RTE_TRACE_MODE_DISCARD;
+	else {
+		trace_err("invalid value %s for trace mode", val);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int
+eal_trace_dir_args_save(const char *val)
+{
+	struct trace *trace = trace_obj_get();
+	size_t len = strlen(val);
+
+	if (len == 0) {
+		trace_err("value is not provided with option");
+		return -EINVAL;
+	}
+
+	if (len >= sizeof(trace->dir) - TRACE_DIR_STR_LEN - 1) {
+		trace_err("input string is too big");
+		return -ENAMETOOLONG;
+	}
+
+	/* The session directory is appended when the trace is saved */
+	snprintf(trace->dir, sizeof(trace->dir), "%s/", val);
+	trace->dir_offset = strlen(trace->dir);
+	return 0;
+}
+
+int
+trace_epoch_time_save(void)
+{
+	struct trace *trace = trace_obj_get();
+	struct timespec epoch = { 0, 0 };
+	uint64_t avg, start, end;
+
+	start = rte_get_tsc_cycles();
+	if (clock_gettime(CLOCK_REALTIME, &epoch) < 0) {
+		trace_err("failed to get the epoch time");
+		rte_errno = errno;
+		return -1;
+	}
+	end = rte_get_tsc_cycles();
+	avg = (start + end) >> 1;
+
+	trace->epoch_sec = (uint64_t)epoch.tv_sec;
+	trace->epoch_nsec = (uint64_t)epoch.tv_nsec;
+	trace->uptime_ticks = avg;
+
+	return 0;
+}
+
+static int
+trace_dir_default_path_get(char *dir_path)
+{
+	const char *home_dir = getenv("HOME");
+
+	/* Use the home directory, or the runtime directory as fallback */
+	if (home_dir == NULL)
+		home_dir = rte_eal_get_runtime_dir();
+
+	snprintf(dir_path, PATH_MAX, "%s/dpdk-traces/", home_dir);
+	return 0;
+}
+
+static int
+trace_mkdir_p(char *path)
+{
+	char *p;
+
+	for (p = path + 1; *p != '\0'; p++) {
+		if (*p != '/')
+			continue;
+		*p = '\0';
+		if (mkdir(path, 0700) < 0 && errno != EEXIST) {
+			trace_err("mkdir %s failed [%s]", path,
+				strerror(errno));
+			*p = '/';
+			return -errno;
+		}
+		*p = '/';
+	}
+
+	return 0;
+}
+
+int
+trace_mkdir(void)
+{
+	struct trace *trace = trace_obj_get();
+	char session[TRACE_DIR_STR_LEN];
+	static bool already_done;
+	int rc;
+
+	if (already_done)
+		return 0;
+
+	if (!trace->dir_offset) {
+		rc = trace_dir_default_path_get(trace->dir);
+		if (rc < 0)
+			return rc;
+		trace->dir_offset = strlen(trace->dir);
+	}
+
+	/* Create the path if it does not exist */
+	rc = trace_mkdir_p(trace->dir);
+	if (rc < 0)
+		return rc;
+
+	rc = trace_session_name_generate(session);
+	if (rc < 0)
+		return rc;
+
+	snprintf(trace->dir + trace->dir_offset,
+		sizeof(trace->dir) - trace->dir_offset, "%s", session);
+
+	/* Sessions started in the same second share the directory */
+	if (mkdir(trace->dir, 0700) < 0 && errno != EEXIST) {
+		trace_err("mkdir %s failed [%s]", trace->dir, strerror(errno));
+		return -errno;
+	}
+
+	RTE_LOG(INFO, EAL, "Trace dir: %s\n", trace->dir);
+	already_done = true;
+	return 0;
+}
+
+static int
+trace_meta_save(struct trace *trace)
+{
+	char file_name[PATH_MAX];
+	FILE *f;
+	int rc;
+
+	if (snprintf(file_name, PATH_MAX, "%s/metadata", trace->dir) >=
+			PATH_MAX)
+		return -ENAMETOOLONG;
+
+	f = fopen(file_name, "w");
+	if (f == NULL)
+		return -errno;
+
+	rc = rte_trace_metadata_dump(f);
+
+	if (fclose(f))
+		rc = -errno;
+
+	return rc;
+}
+
+static int
+trace_mem_save(struct trace *trace, struct __rte_trace_header *hdr,
+		uint32_t cnt)
+{
+	char file_name[PATH_MAX];
+	size_t len;
+	FILE *f;
+	int rc;
+
+	if (snprintf(file_name, PATH_MAX, "%s/channel0_%d", trace->dir,
+			cnt) >= PATH_MAX)
+		return -ENAMETOOLONG;
+
+	f = fopen(file_name, "w");
+	if (f == NULL)
+		return -errno;
+
+	/* The CTF packet header and context are followed by the events */
+	len = sizeof(hdr->stream_header) + hdr->offset;
+	rc = 0;
+	if (fwrite(&hdr->stream_header, len, 1, f) != 1)
+		rc = -EIO;
+	if (fclose(f))
+		rc = -errno;
+
+	return rc;
+}
+
+int
+rte_trace_save(void)
+{
+	struct trace *trace = trace_obj_get();
+	uint32_t count;
+	int rc = 0;
+
+	if (trace->nb_trace_mem_list == 0)
+		return rc;
+
+	rc = trace_mkdir();
+	if (rc < 0)
+		return rc;
+
+	rc = trace_meta_save(trace);
+	if (rc)
+		return rc;
+
+	rte_spinlock_lock(&trace->lock);
+	for (count = 0; count < trace->nb_trace_mem_list; count++) {
+		rc = trace_mem_save(trace, trace->lcore_meta[count].mem,
+			count);
+		if (rc)
+			break;
+	}
+	rte_spinlock_unlock(&trace->lock);
+	return rc;
+}
@@ -69,6 +69,14 @@ struct internal_config {
 	/**< true if storing all pages within single files (per-page-size,
 	 * per-node) non-legacy mode only.
 	 */
+	volatile unsigned int huge_worker_threads;
+	/**< number of threads mapping hugepages of a socket, 0 for one per
+	 * CPU of the socket.
+	 */
+	volatile unsigned int lazy_mem_attach;
+	/**< true if a secondary process maps pages of the primary process
+	 * when they are looked up, non-legacy mode only.
+	 */
 	volatile int syslog_facility;	  /**< facility passed to openlog() */
 	/** default interrupt mode for VFIO */
 	volatile enum rte_intr_mode vfio_intr_mode;
@@ -55,6 +55,14 @@ eal_memalloc_is_contig(const struct rte_memseg_list *msl, void *start,
 int
 eal_memalloc_sync_with_primary(void);
 
+/* make the memory of the primary process inaccessible until it is attached */
+int
+eal_memalloc_lazy_attach_init(void);
+
+/* map pages of the primary process in a memory area */
+int
+eal_memalloc_attach(const void *addr, size_t len);
+
 int
 eal_memalloc_mem_event_callback_register(const char *name,
 		rte_mem_event_callback_t clb, void *arg);
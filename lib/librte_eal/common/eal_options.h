@@ -29,6 +29,10 @@ enum {
 	OPT_HUGE_DIR_NUM,
 #define OPT_HUGE_UNLINK       "huge-unlink"
 	OPT_HUGE_UNLINK_NUM,
+#define OPT_HUGE_WORKER_THREADS "huge-worker-threads"
+	OPT_HUGE_WORKER_THREADS_NUM,
+#define OPT_LAZY_MEM_ATTACH   "lazy-mem-attach"
+	OPT_LAZY_MEM_ATTACH_NUM,
 #define OPT_LCORES            "lcores"
 	OPT_LCORES_NUM,
 #define OPT_LOG_LEVEL         "log-level"
@@ -69,6 +73,14 @@ enum {
 	OPT_IOVA_MODE_NUM,
 #define OPT_MATCH_ALLOCATIONS  "match-allocations"
 	OPT_MATCH_ALLOCATIONS_NUM,
+#define OPT_TRACE              "trace"
+	OPT_TRACE_NUM,
+#define OPT_TRACE_DIR          "trace-dir"
+	OPT_TRACE_DIR_NUM,
+#define OPT_TRACE_BUF_SIZE     "trace-bufsz"
+	OPT_TRACE_BUF_SIZE_NUM,
+#define OPT_TRACE_MODE         "trace-mode"
+	OPT_TRACE_MODE_NUM,
 	OPT_LONG_MAX_NUM
 };
 
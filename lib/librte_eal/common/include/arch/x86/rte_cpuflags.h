@@ -113,6 +113,9 @@ enum rte_cpu_flag_t {
 	/* (EAX 80000007h) EDX features */
 	RTE_CPUFLAG_INVTSC,                 /**< INVTSC */
 
+	/* (EAX 07h, ECX 0h) EBX features, kept last for ABI compatibility */
+	RTE_CPUFLAG_AVX512BW,               /**< AVX512BW */
+
 	/* The last item */
 	RTE_CPUFLAG_NUMFLAGS,               /**< This should always be the last! */
 };
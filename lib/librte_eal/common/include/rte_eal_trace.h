@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#ifndef _RTE_EAL_TRACE_H_
+#define _RTE_EAL_TRACE_H_
+
+/**
+ * @file
+ *
+ * API for EAL trace support
+ *
+ * The generic trace points can be used by applications to trace their
+ * own events without registering trace points.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rte_trace_point.h>
+
+RTE_TRACE_POINT(
+	rte_eal_trace_generic_void,
+	RTE_TRACE_POINT_ARGS(void),
+)
+
+RTE_TRACE_POINT(
+	rte_eal_trace_generic_u64,
+	RTE_TRACE_POINT_ARGS(uint64_t in),
+	rte_trace_point_emit_u64(in);
+)
+
+RTE_TRACE_POINT(
+	rte_eal_trace_generic_ptr,
+	RTE_TRACE_POINT_ARGS(const void *ptr),
+	rte_trace_point_emit_ptr(ptr);
+)
+
+RTE_TRACE_POINT(
+	rte_eal_trace_generic_str,
+	RTE_TRACE_POINT_ARGS(const char *str),
+	rte_trace_point_emit_string(str);
+)
+
+/**
+ * Emit a generic trace event with the name of the calling function.
+ */
+#define RTE_EAL_TRACE_GENERIC_FUNC rte_eal_trace_generic_str(__func__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_EAL_TRACE_H_ */
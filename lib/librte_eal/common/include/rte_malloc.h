@@ -274,6 +274,45 @@ rte_free(void *ptr);
 int
 rte_malloc_validate(const void *ptr, size_t *size);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Map a memory block allocated by the primary process in a secondary process
+ * started with --lazy-mem-attach.
+ *
+ * This is rte_mem_attach() for a block whose size is not known, like the
+ * private data of a device. The whole block is mapped if ptr is its start,
+ * nothing otherwise. It does nothing in other processes.
+ *
+ * @param ptr
+ *   Pointer to the start of a block returned by rte_malloc() and the like,
+ *   or to the start of a memory zone. NULL or any other pointer is ignored.
+ * @return
+ *   0 on success, -1 on failure, with rte_errno set to ENOMEM if a page
+ *   could not be mapped.
+ */
+__rte_experimental
+int
+rte_malloc_attach(const void *ptr);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Return the small elements held in the cache of the calling lcore to their
+ * heap.
+ *
+ * Small allocations of an EAL thread are served from a per-lcore cache, and
+ * small elements freed by an EAL thread go back to this cache. The cached
+ * elements are accounted as free memory by rte_malloc_get_socket_stats(), but
+ * their memory cannot be merged or released to the system before they are
+ * flushed. The function does nothing in a non-EAL thread.
+ */
+__rte_experimental
+void
+rte_malloc_cache_flush(void);
+
 /**
  * Get heap statistics for the specified heap.
  *
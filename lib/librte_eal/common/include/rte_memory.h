@@ -663,6 +663,35 @@ int rte_mem_check_dma_mask_thread_unsafe(uint8_t maskbits);
 __rte_experimental
 void rte_mem_set_dma_mask(uint8_t maskbits);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Map the pages of a memory area in a secondary process started with
+ * --lazy-mem-attach.
+ *
+ * Such a process only maps a page allocated by the primary process when it
+ * is looked up through the memzone, malloc or library lookup functions.
+ * Memory reached otherwise, e.g. through a pointer stored in shared memory,
+ * must be mapped with this function, or with rte_malloc_attach(), before it
+ * is accessed. It does nothing in other processes, where all pages are mapped
+ * when they are allocated.
+ *
+ * @note The memory event callbacks are not called for the pages mapped.
+ * @note This function must not be called from a memory event callback.
+ *
+ * @param addr
+ *   Start of the memory area.
+ * @param len
+ *   Length of the memory area.
+ * @return
+ *   0 on success, -1 on failure, with rte_errno set to:
+ *     - EINVAL - invalid parameters
+ *     - ENOMEM - a page could not be mapped
+ */
+__rte_experimental
+int rte_mem_attach(const void *addr, size_t len);
+
 /**
  * Drivers based on uio will not load unless physical
  * addresses are obtainable. It is only possible to get
@@ -18,6 +18,7 @@ extern "C" {
 #include <sys/queue.h>
 #include <stdio.h>
 #include <rte_debug.h>
+#include <rte_malloc.h>
 
 /** dummy structure type used by the rte_tailq APIs */
 struct rte_tailq_entry {
@@ -133,6 +134,46 @@ RTE_INIT(tailqinitfn_ ##t) \
 	    (var) = (tvar))
 #endif
 
+/*
+ * The entries of the shared tail queues, and the objects they reference, are
+ * allocated from the heap by any process. A secondary process started with
+ * --lazy-mem-attach must map them before reading or updating them, so the
+ * libraries walk and update these tail queues with the macros below. The walk
+ * stops at an entry which cannot be mapped. In other processes, they are the
+ * TAILQ_*() macros.
+ */
+
+/** @internal Map a tail queue entry and the object it references. */
+#define __RTE_TAILQ_ENTRY_ATTACH(te) \
+	(rte_malloc_attach(te) == 0 && rte_malloc_attach((te)->data) == 0)
+
+/** TAILQ_FOREACH() on a shared tail queue. */
+#define RTE_TAILQ_FOREACH(var, head, field)			\
+	for ((var) = TAILQ_FIRST((head));			\
+	    (var) && (__RTE_TAILQ_ENTRY_ATTACH(var) || ((var) = NULL)); \
+	    (var) = TAILQ_NEXT((var), field))
+
+/** TAILQ_FOREACH_SAFE() on a shared tail queue. */
+#define RTE_TAILQ_FOREACH_SAFE(var, head, field, tvar)		\
+	for ((var) = TAILQ_FIRST((head));			\
+	    (var) && (__RTE_TAILQ_ENTRY_ATTACH(var) || ((var) = NULL)) && \
+	    ((tvar) = TAILQ_NEXT((var), field), 1);		\
+	    (var) = (tvar))
+
+/** TAILQ_INSERT_TAIL() on a shared tail queue, which updates the last entry. */
+#define RTE_TAILQ_INSERT_TAIL(head, elm, field) do {		\
+	if (!TAILQ_EMPTY((head)))				\
+		rte_malloc_attach(container_of((head)->tqh_last, \
+			struct rte_tailq_entry, field.tqe_next)); \
+	TAILQ_INSERT_TAIL((head), (elm), field);		\
+} while (0)
+
+/** TAILQ_REMOVE() on a shared tail queue, which updates the next entry. */
+#define RTE_TAILQ_REMOVE(head, elm, field) do {			\
+	rte_malloc_attach(TAILQ_NEXT((elm), field));		\
+	TAILQ_REMOVE((head), (elm), field);			\
+} while (0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#ifndef _RTE_TRACE_H_
+#define _RTE_TRACE_H_
+
+/**
+ * @file
+ *
+ * RTE Trace API
+ *
+ * This file provides the trace API to control the trace points and to save
+ * the trace buffers.
+ *
+ * The trace points are defined with the macros of rte_trace_point.h and
+ * registered at constructor time. Each thread emitting a trace event gets
+ * its own trace buffer, so that the fast path neither takes a lock nor
+ * issues an atomic operation. Each event is stamped with the TSC.
+ *
+ * The trace buffers are saved in the Common Trace Format (CTF), so that
+ * they can be read by tools such as babeltrace or Trace Compass.
+ *
+ * The trace is controlled at startup with the EAL options --trace,
+ * --trace-dir, --trace-bufsz and --trace-mode, or at runtime with the
+ * functions below.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <rte_compat.h>
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Test if tracing is enabled.
+ *
+ * @return
+ *   true if at least one trace point is enabled.
+ */
+__rte_experimental
+bool rte_trace_is_enabled(void);
+
+/**
+ * Enumerate trace mode operation.
+ */
+enum rte_trace_mode {
+	/**
+	 * In this mode, when no space is left in the trace buffer, the
+	 * subsequent events overwrite the old events in the trace buffer.
+	 */
+	RTE_TRACE_MODE_OVERWRITE,
+	/**
+	 * In this mode, when no space is left in the trace buffer, the
+	 * subsequent events shall not be recorded.
+	 */
+	RTE_TRACE_MODE_DISCARD,
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Set the trace mode.
+ *
+ * @param mode
+ *   Trace mode.
+ */
+__rte_experimental
+void rte_trace_mode_set(enum rte_trace_mode mode);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the trace mode.
+ *
+ * @return
+ *   The current trace mode.
+ */
+__rte_experimental
+enum rte_trace_mode rte_trace_mode_get(void);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enable/Disable a set of trace points based on globbing pattern.
+ *
+ * @param pattern
+ *   The globbing pattern identifying the trace points.
+ * @param enable
+ *   true to enable the trace points, false to disable them.
+ * @return
+ *   - 0: Success and no pattern match.
+ *   - 1: Success and found pattern match.
+ *   - (-ERANGE): Trace point object is not registered.
+ */
+__rte_experimental
+int rte_trace_pattern(const char *pattern, bool enable);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enable/Disable a set of trace points based on regular expression.
+ *
+ * @param regex
+ *   A regular expression identifying the trace points.
+ * @param enable
+ *   true to enable the trace points, false to disable them.
+ * @return
+ *   - 0: Success and no pattern match.
+ *   - 1: Success and found pattern match.
+ *   - (-ERANGE): Trace point object is not registered.
+ *   - (-EINVAL): Invalid regular expression.
+ */
+__rte_experimental
+int rte_trace_regexp(const char *regex, bool enable);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Save the trace buffers and the trace metadata in the trace directory.
+ *
+ * The trace buffers of all the threads that emitted an event are saved,
+ * along with the CTF metadata describing the registered trace points.
+ *
+ * @return
+ *   - 0: Success.
+ *   - <0 : Failure.
+ */
+__rte_experimental
+int rte_trace_save(void);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dump the trace metadata to a file.
+ *
+ * @param f
+ *   A pointer to a file for output.
+ * @return
+ *   - 0: Success.
+ *   - <0 : Failure.
+ */
+__rte_experimental
+int rte_trace_metadata_dump(FILE *f);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dump the trace subsystem status to a file.
+ *
+ * @param f
+ *   A pointer to a file for output.
+ */
+__rte_experimental
+void rte_trace_dump(FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_TRACE_H_ */
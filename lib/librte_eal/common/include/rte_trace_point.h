@@ -0,0 +1,468 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#ifndef _RTE_TRACE_POINT_H_
+#define _RTE_TRACE_POINT_H_
+
+/**
+ * @file
+ *
+ * RTE Tracepoint API
+ *
+ * This file provides the tracepoint API to RTE applications and libraries.
+ *
+ * A trace point is defined in a header file with RTE_TRACE_POINT() or
+ * RTE_TRACE_POINT_FP(), which create an inline function emitting the
+ * arguments of the trace point. It is registered in exactly one C file,
+ * which includes <rte_trace_point_register.h> before the header defining
+ * the trace point, with RTE_TRACE_POINT_REGISTER().
+ *
+ * When a trace point is disabled, the cost of the inline function is a
+ * load and a not taken branch. The fast path trace points, defined with
+ * RTE_TRACE_POINT_FP(), are compiled out unless RTE_ENABLE_TRACE_FP is
+ * defined.
+ *
+ * The tracepoints are experimental: they emit nothing when called from code
+ * built without ALLOW_EXPERIMENTAL_API.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * This file is included by the fast path headers of the libraries, so it
+ * does not use <stdbool.h>, which conflicts with the bool typedef of some
+ * driver base codes.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include <rte_branch_prediction.h>
+#include <rte_byteorder.h>
+#include <rte_common.h>
+#include <rte_compat.h>
+#include <rte_cycles.h>
+#include <rte_per_lcore.h>
+
+/** The tracepoint object. */
+typedef uint64_t rte_trace_point_t;
+
+/**
+ * Macro to define the tracepoint arguments in RTE_TRACE_POINT macro.
+ *
+ * @see RTE_TRACE_POINT, RTE_TRACE_POINT_FP
+ */
+#define RTE_TRACE_POINT_ARGS
+
+/** @internal Helper macro to support RTE_TRACE_POINT and RTE_TRACE_POINT_FP */
+#define __RTE_TRACE_POINT(_mode, _tp, _args, ...) \
+extern rte_trace_point_t __##_tp; \
+static __rte_always_inline void \
+_tp _args \
+{ \
+	__rte_trace_point_emit_header_##_mode(&__##_tp); \
+	__VA_ARGS__ \
+}
+
+/**
+ * Create a tracepoint.
+ *
+ * A tracepoint is defined by specifying:
+ * - its input arguments: they are the C function style parameters to define
+ *   the arguments of tracepoint function. These input arguments are embedded
+ *   using the RTE_TRACE_POINT_ARGS macro.
+ * - its output event fields: they are the sources of trace event fields,
+ *   emitted with the rte_trace_point_emit_* macros, in the order of the
+ *   event payload. The emitted arguments must be plain identifiers, as
+ *   they name the fields of the event.
+ *
+ * @param tp
+ *   Tracepoint object. Before using the tracepoint, an application needs to
+ *   define the tracepoint using RTE_TRACE_POINT_REGISTER macro.
+ * @param args
+ *   C function style input arguments to define the arguments to tracepoint
+ *   function.
+ * @param ...
+ *   Define the payload of trace function. The payload will be formed using
+ *   rte_trace_point_emit_* macros. Use ";" delimiter between two payloads.
+ *
+ * @see RTE_TRACE_POINT_ARGS, RTE_TRACE_POINT_REGISTER, rte_trace_point_emit_*
+ */
+#define RTE_TRACE_POINT(tp, args, ...) \
+	__RTE_TRACE_POINT(generic, tp, args, __VA_ARGS__)
+
+/**
+ * Create a tracepoint for fast path.
+ *
+ * Similar to RTE_TRACE_POINT, except that it is removed at compilation time
+ * unless the RTE_ENABLE_TRACE_FP configuration parameter is set.
+ *
+ * @param tp
+ *   Tracepoint object. Before using the tracepoint, an application needs to
+ *   define the tracepoint using RTE_TRACE_POINT_REGISTER macro.
+ * @param args
+ *   C function style input arguments to define the arguments to tracepoint.
+ *   function.
+ * @param ...
+ *   Define the payload of trace function. The payload will be formed using
+ *   rte_trace_point_emit_* macros, Use ";" delimiter between two payloads.
+ *
+ * @see RTE_TRACE_POINT
+ */
+#define RTE_TRACE_POINT_FP(tp, args, ...) \
+	__RTE_TRACE_POINT(fp, tp, args, __VA_ARGS__)
+
+#ifdef __DOXYGEN__
+
+/**
+ * Register a tracepoint.
+ *
+ * @param trace
+ *   The tracepoint object created using RTE_TRACE_POINT.
+ * @param name
+ *   The name of the tracepoint object.
+ *
+ * @see RTE_TRACE_POINT
+ */
+#define RTE_TRACE_POINT_REGISTER(trace, name)
+
+/** Tracepoint function payload for uint64_t datatype */
+#define rte_trace_point_emit_u64(val)
+/** Tracepoint function payload for int64_t datatype */
+#define rte_trace_point_emit_i64(val)
+/** Tracepoint function payload for uint32_t datatype */
+#define rte_trace_point_emit_u32(val)
+/** Tracepoint function payload for int32_t datatype */
+#define rte_trace_point_emit_i32(val)
+/** Tracepoint function payload for uint16_t datatype */
+#define rte_trace_point_emit_u16(val)
+/** Tracepoint function payload for int16_t datatype */
+#define rte_trace_point_emit_i16(val)
+/** Tracepoint function payload for uint8_t datatype */
+#define rte_trace_point_emit_u8(val)
+/** Tracepoint function payload for int8_t datatype */
+#define rte_trace_point_emit_i8(val)
+/** Tracepoint function payload for pointer datatype */
+#define rte_trace_point_emit_ptr(val)
+/** Tracepoint function payload for float datatype */
+#define rte_trace_point_emit_float(val)
+/** Tracepoint function payload for double datatype */
+#define rte_trace_point_emit_double(val)
+/**
+ * Tracepoint function payload for string datatype. The string is
+ * truncated to 31 characters.
+ */
+#define rte_trace_point_emit_string(val)
+
+#endif /* __DOXYGEN__ */
+
+/** @internal Macro to define maximum emit length of string datatype. */
+#define __RTE_TRACE_EMIT_STRING_LEN_MAX 32
+/** @internal Macro to define event header size. */
+#define __RTE_TRACE_EVENT_HEADER_SZ sizeof(uint64_t)
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enable recording events of the given tracepoint in the trace buffer.
+ *
+ * @param tp
+ *   The tracepoint object to enable.
+ * @return
+ *   - 0: Success.
+ *   - (-ERANGE): Trace object is not registered.
+ */
+__rte_experimental
+int rte_trace_point_enable(rte_trace_point_t *tp);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Disable recording events of the given tracepoint in the trace buffer.
+ *
+ * @param tp
+ *   The tracepoint object to disable.
+ * @return
+ *   - 0: Success.
+ *   - (-ERANGE): Trace object is not registered.
+ */
+__rte_experimental
+int rte_trace_point_disable(rte_trace_point_t *tp);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Test if recording events from the given tracepoint is enabled.
+ *
+ * @param tp
+ *    The tracepoint object.
+ * @return
+ *    1 if tracepoint is enabled, 0 otherwise.
+ */
+__rte_experimental
+int rte_trace_point_is_enabled(rte_trace_point_t *tp);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Lookup a tracepoint object from its name.
+ *
+ * @param name
+ *   The name of the tracepoint.
+ * @return
+ *   The tracepoint object or NULL if not found.
+ */
+__rte_experimental
+rte_trace_point_t *rte_trace_point_lookup(const char *name);
+
+/**
+ * @internal
+ *
+ * Register a tracepoint. The registration function runs the tracepoint
+ * function in registration mode, to compute the size of its events and
+ * record the description of its fields.
+ *
+ * @param trace
+ *   The tracepoint object created using RTE_TRACE_POINT.
+ * @param name
+ *   The name of the tracepoint object.
+ * @param register_fn
+ *   Trace registration function.
+ * @return
+ *   - 0: Successfully registered the tracepoint.
+ *   - <0: Failure to register the tracepoint.
+ */
+__rte_experimental
+int __rte_trace_point_register(rte_trace_point_t *trace, const char *name,
+	void (*register_fn)(void));
+
+/**
+ * @internal
+ *
+ * Describe a field of the tracepoint being registered.
+ *
+ * @param sz
+ *   The size of the field.
+ * @param field
+ *   The name of the field.
+ * @param type
+ *   The CTF type of the field.
+ */
+__rte_experimental
+void __rte_trace_point_emit_field(size_t sz, const char *field,
+	const char *type);
+
+#ifdef RTE_TRACE_POINT_REGISTER_SELECT
+
+/* Registration mode: describe the fields of the events. */
+
+#define __rte_trace_point_emit_header_generic(t) \
+	RTE_SET_USED(t)
+
+#define __rte_trace_point_emit_header_fp(t) \
+	__rte_trace_point_emit_header_generic(t)
+
+#define __rte_trace_point_emit(in, type) \
+do { \
+	RTE_SET_USED(in); \
+	__rte_trace_point_emit_field(sizeof(type), RTE_STR(in), \
+		RTE_STR(type)); \
+} while (0)
+
+#define rte_trace_point_emit_string(in) \
+do { \
+	RTE_SET_USED(in); \
+	__rte_trace_point_emit_field(__RTE_TRACE_EMIT_STRING_LEN_MAX, \
+		RTE_STR(in)"[" RTE_STR(__RTE_TRACE_EMIT_STRING_LEN_MAX)"]", \
+		"string_bounded_t"); \
+} while (0)
+
+#else /* !RTE_TRACE_POINT_REGISTER_SELECT */
+
+/* Emit mode: record the events in the trace buffer of the thread. */
+
+/** @internal Macro to define event size mask in the tracepoint object. */
+#define __RTE_TRACE_FIELD_SIZE_MASK (0xffffULL)
+/** @internal Macro to define event id shift in the tracepoint object. */
+#define __RTE_TRACE_FIELD_ID_SHIFT (16)
+/** @internal Macro to define event id mask in the tracepoint object. */
+#define __RTE_TRACE_FIELD_ID_MASK (0xffffULL << __RTE_TRACE_FIELD_ID_SHIFT)
+/** @internal Macro to define the enable bit in the tracepoint object. */
+#define __RTE_TRACE_FIELD_ENABLE_MASK (1ULL << 63)
+/** @internal Macro to define the discard bit in the tracepoint object. */
+#define __RTE_TRACE_FIELD_ENABLE_DISCARD (1ULL << 62)
+/** @internal Macro to define the timestamp width in the event header. */
+#define __RTE_TRACE_EVENT_HEADER_TS_BITS (48)
+
+/** @internal Magic number of the CTF packet header. */
+#define __RTE_TRACE_CTF_MAGIC 0xC1FC1FC1
+
+/** @internal CTF packet header and context, saved with the events. */
+struct __rte_trace_stream_header {
+	uint32_t magic;
+	uint8_t uuid[16];
+	uint32_t lcore_id;
+	char thread_name[__RTE_TRACE_EMIT_STRING_LEN_MAX];
+} __rte_packed;
+
+/** @internal Per thread trace buffer. */
+struct __rte_trace_header {
+	uint32_t offset;
+	uint32_t len;
+	struct __rte_trace_stream_header stream_header;
+	uint8_t mem[];
+};
+
+/** @internal Trace buffer of the thread, allocated on first event. */
+RTE_DECLARE_PER_LCORE(void *, _rte_trace_mem);
+
+/**
+ * @internal
+ *
+ * Allocate the trace buffer of the calling thread.
+ */
+__rte_experimental
+void __rte_trace_mem_per_thread_alloc(void);
+
+static __rte_always_inline int
+__rte_trace_point_fp_is_enabled(void)
+{
+#ifdef RTE_ENABLE_TRACE_FP
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+#ifdef ALLOW_EXPERIMENTAL_API
+
+static __rte_always_inline void *
+__rte_trace_mem_get(uint64_t in)
+{
+	struct __rte_trace_header *trace = RTE_PER_LCORE(_rte_trace_mem);
+	const uint16_t sz = in & __RTE_TRACE_FIELD_SIZE_MASK;
+	uint32_t offset;
+	void *mem;
+
+	/* Trace memory is not initialized for this thread */
+	if (unlikely(trace == NULL)) {
+		__rte_trace_mem_per_thread_alloc();
+		trace = RTE_PER_LCORE(_rte_trace_mem);
+		if (unlikely(trace == NULL))
+			return NULL;
+	}
+
+	/* Events are aligned on the size of the event header */
+	offset = RTE_ALIGN_CEIL(trace->offset, __RTE_TRACE_EVENT_HEADER_SZ);
+
+	/* Check the wrap around case */
+	if (unlikely(offset + sz > trace->len)) {
+		/* Drop the event in discard mode, or if it cannot fit */
+		if ((in & __RTE_TRACE_FIELD_ENABLE_DISCARD) || sz > trace->len)
+			return NULL;
+		offset = 0;
+	}
+
+	mem = RTE_PTR_ADD(&trace->mem[0], offset);
+	trace->offset = offset + sz;
+
+	return mem;
+}
+
+static __rte_always_inline void *
+__rte_trace_point_emit_ev_header(void *mem, uint64_t in)
+{
+	const uint64_t ts_mask =
+		(1ULL << __RTE_TRACE_EVENT_HEADER_TS_BITS) - 1;
+	uint64_t id, ts;
+
+	/* The CTF event header is a 48 bits timestamp and a 16 bits id. */
+	id = (in & __RTE_TRACE_FIELD_ID_MASK) >> __RTE_TRACE_FIELD_ID_SHIFT;
+	ts = rte_get_tsc_cycles() & ts_mask;
+#if RTE_BYTE_ORDER == RTE_LITTLE_ENDIAN
+	*(uint64_t *)mem = ts | (id << __RTE_TRACE_EVENT_HEADER_TS_BITS);
+#else
+	*(uint64_t *)mem = (ts << (64 - __RTE_TRACE_EVENT_HEADER_TS_BITS)) | id;
+#endif
+
+	return RTE_PTR_ADD(mem, __RTE_TRACE_EVENT_HEADER_SZ);
+}
+
+#define __rte_trace_point_emit_header(t, fp) \
+void *__tp_mem; \
+do { \
+	uint64_t __tp_val; \
+	if (!(fp)) \
+		return; \
+	__tp_val = __atomic_load_n(t, __ATOMIC_RELAXED); \
+	if (likely(!(__tp_val & __RTE_TRACE_FIELD_ENABLE_MASK))) \
+		return; \
+	__tp_mem = __rte_trace_mem_get(__tp_val); \
+	if (unlikely(__tp_mem == NULL)) \
+		return; \
+	__tp_mem = __rte_trace_point_emit_ev_header(__tp_mem, __tp_val); \
+	RTE_SET_USED(__tp_mem); \
+} while (0)
+
+#else /* !ALLOW_EXPERIMENTAL_API */
+
+/* Do not reference the experimental trace functions, emit nothing. */
+#define __rte_trace_point_emit_header(t, fp) \
+void *__tp_mem; \
+do { \
+	RTE_SET_USED(t); \
+	return; \
+} while (0)
+
+#endif /* ALLOW_EXPERIMENTAL_API */
+
+#define __rte_trace_point_emit_header_generic(t) \
+	__rte_trace_point_emit_header(t, 1)
+
+#define __rte_trace_point_emit_header_fp(t) \
+	__rte_trace_point_emit_header(t, __rte_trace_point_fp_is_enabled())
+
+#define __rte_trace_point_emit(in, type) \
+do { \
+	type __tp_in = (type)(in); \
+	memcpy(__tp_mem, &__tp_in, sizeof(__tp_in)); \
+	__tp_mem = RTE_PTR_ADD(__tp_mem, sizeof(__tp_in)); \
+} while (0)
+
+#define rte_trace_point_emit_string(in) \
+do { \
+	size_t __tp_len = 0; \
+	if ((in) != NULL) { \
+		__tp_len = strnlen(in, __RTE_TRACE_EMIT_STRING_LEN_MAX - 1); \
+		memcpy(__tp_mem, in, __tp_len); \
+	} \
+	memset(RTE_PTR_ADD(__tp_mem, __tp_len), 0, \
+		__RTE_TRACE_EMIT_STRING_LEN_MAX - __tp_len); \
+	__tp_mem = RTE_PTR_ADD(__tp_mem, __RTE_TRACE_EMIT_STRING_LEN_MAX); \
+} while (0)
+
+#endif /* RTE_TRACE_POINT_REGISTER_SELECT */
+
+#define rte_trace_point_emit_u64(in) __rte_trace_point_emit(in, uint64_t)
+#define rte_trace_point_emit_i64(in) __rte_trace_point_emit(in, int64_t)
+#define rte_trace_point_emit_u32(in) __rte_trace_point_emit(in, uint32_t)
+#define rte_trace_point_emit_i32(in) __rte_trace_point_emit(in, int32_t)
+#define rte_trace_point_emit_u16(in) __rte_trace_point_emit(in, uint16_t)
+#define rte_trace_point_emit_i16(in) __rte_trace_point_emit(in, int16_t)
+#define rte_trace_point_emit_u8(in) __rte_trace_point_emit(in, uint8_t)
+#define rte_trace_point_emit_i8(in) __rte_trace_point_emit(in, int8_t)
+#define rte_trace_point_emit_ptr(in) __rte_trace_point_emit(in, uintptr_t)
+#define rte_trace_point_emit_float(in) __rte_trace_point_emit(in, float)
+#define rte_trace_point_emit_double(in) __rte_trace_point_emit(in, double)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_TRACE_POINT_H_ */
@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#ifndef _RTE_TRACE_POINT_REGISTER_H_
+#define _RTE_TRACE_POINT_REGISTER_H_
+
+/**
+ * @file
+ *
+ * RTE Tracepoint registration
+ *
+ * This file must be included, before any header defining trace points, in
+ * the C file registering them with RTE_TRACE_POINT_REGISTER(). The trace
+ * point functions are then compiled in registration mode, where they
+ * describe their fields instead of emitting events.
+ */
+
+#ifdef _RTE_TRACE_POINT_H_
+#error for registration, include this file first before <rte_trace_point.h>
+#endif
+
+#define RTE_TRACE_POINT_REGISTER_SELECT
+
+#include <rte_trace_point.h>
+
+#define RTE_TRACE_POINT_REGISTER(trace, name) \
+rte_trace_point_t __##trace; \
+RTE_INIT(trace##_init) \
+{ \
+	__rte_trace_point_register(&__##trace, RTE_STR(name), \
+		(void (*)(void)) trace); \
+}
+
+#endif /* _RTE_TRACE_POINT_REGISTER_H_ */
@@ -17,7 +17,8 @@ struct malloc_heap;
 enum elem_state {
 	ELEM_FREE = 0,
 	ELEM_BUSY,
-	ELEM_PAD  /* element is a padding-only header */
+	ELEM_PAD,  /* element is a padding-only header */
+	ELEM_CACHED /* element is held in a per-lcore cache of rte_malloc */
 };
 
 struct malloc_elem {
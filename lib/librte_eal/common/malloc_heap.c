@@ -143,6 +143,91 @@ malloc_add_seg(const struct rte_memseg_list *msl,
 	return 0;
 }
 
+/*
+ * With --lazy-mem-attach, the pages of the primary process are mapped on
+ * demand. The primary process may have split or merged elements in pages this
+ * process has not mapped yet, so map the header of every element of a heap,
+ * and the trailer of the one before, before walking it. Heap lock must be held.
+ */
+static int
+heap_attach_elems(struct malloc_heap *heap)
+{
+	const void *mapped_start = NULL, *mapped_end = NULL;
+	struct malloc_elem *elem;
+
+	if (!internal_config.lazy_mem_attach)
+		return 0;
+
+	for (elem = heap->first; elem != NULL; elem = elem->next) {
+		const void *start = RTE_PTR_SUB(elem, MALLOC_ELEM_TRAILER_LEN);
+		const void *end = RTE_PTR_ADD(elem, MALLOC_ELEM_HEADER_LEN);
+		size_t page_sz;
+
+		/* most elements share their page with the previous one */
+		if (start >= mapped_start && end <= mapped_end)
+			continue;
+		if (eal_memalloc_attach(start, RTE_PTR_DIFF(end, start)) < 0)
+			return -1;
+		page_sz = (size_t)elem->msl->page_sz;
+		mapped_start = RTE_PTR_ALIGN_FLOOR(start, page_sz);
+		mapped_end = RTE_PTR_ALIGN_CEIL(end, page_sz);
+	}
+	return 0;
+}
+
+/* map the whole of a busy element, once its header is mapped */
+static int
+elem_attach(const struct malloc_elem *elem)
+{
+	if (!internal_config.lazy_mem_attach)
+		return 0;
+	return eal_memalloc_attach(elem, elem->size);
+}
+
+int
+malloc_heap_attach_data(const void *data)
+{
+	const struct rte_memseg_list *msl;
+	const struct malloc_elem *elem;
+	const void *msl_end;
+
+	if (!internal_config.lazy_mem_attach)
+		return 0;
+
+	/* only the memory of the heaps is mapped on demand, and nothing may
+	 * be read in front of a pointer outside of them
+	 */
+	msl = rte_mem_virt2memseg_list(data);
+	if (msl == NULL || msl->external)
+		return 0;
+	msl_end = RTE_PTR_ADD(msl->base_va, msl->len);
+
+	/* the header, which may be a padding header, comes first, as it has
+	 * to be read to find the element. malloc_elem_from_data() cannot be
+	 * used, as it checks the trailer cookie in debug mode.
+	 */
+	elem = RTE_PTR_SUB(data, MALLOC_ELEM_HEADER_LEN);
+	if ((const void *)elem < msl->base_va)
+		return 0;
+	if (eal_memalloc_attach(elem, MALLOC_ELEM_HEADER_LEN) < 0)
+		return -1;
+	if (elem->state == ELEM_PAD) {
+		if (elem->pad > RTE_PTR_DIFF(elem, msl->base_va))
+			return 0;
+		elem = RTE_PTR_SUB(elem, elem->pad);
+		if (eal_memalloc_attach(elem, MALLOC_ELEM_HEADER_LEN) < 0)
+			return -1;
+	}
+	/* not the start of an allocation, leave it to the caller to check.
+	 * The header is only trusted to be one if it is consistent.
+	 */
+	if (elem->msl != msl || elem->state != ELEM_BUSY ||
+			RTE_PTR_ADD(elem, elem->size) <= data ||
+			RTE_PTR_ADD(elem, elem->size) > msl_end)
+		return 0;
+	return elem_attach(elem);
+}
+
 /*
  * Iterates through the freelist for a heap to find a free element
  * which can store data of the required size and with the requested alignment.
@@ -240,12 +325,21 @@ heap_alloc(struct malloc_heap *heap, const char *type __rte_unused, size_t size,
 	size = RTE_CACHE_LINE_ROUNDUP(size);
 	align = RTE_CACHE_LINE_ROUNDUP(align);
 
+	if (heap_attach_elems(heap) < 0)
+		return NULL;
+
 	elem = find_suitable_element(heap, size, flags, align, bound, contig);
 	if (elem != NULL) {
 		elem = malloc_elem_alloc(elem, size, align, bound, contig);
 
 		/* increase heap's count of allocated elements */
 		heap->alloc_count++;
+
+		/* the element is leaked, freeing it would poison its data */
+		if (elem_attach(elem) < 0) {
+			RTE_LOG(ERR, EAL, "Cannot map allocated element\n");
+			return NULL;
+		}
 	}
 
 	return elem == NULL ? NULL : (void *)(&elem[1]);
@@ -260,12 +354,21 @@ heap_alloc_biggest(struct malloc_heap *heap, const char *type __rte_unused,
 
 	align = RTE_CACHE_LINE_ROUNDUP(align);
 
+	if (heap_attach_elems(heap) < 0)
+		return NULL;
+
 	elem = find_biggest_element(heap, &size, flags, align, contig);
 	if (elem != NULL) {
 		elem = malloc_elem_alloc(elem, size, align, 0, contig);
 
 		/* increase heap's count of allocated elements */
 		heap->alloc_count++;
+
+		/* the element is leaked, freeing it would poison its data */
+		if (elem_attach(elem) < 0) {
+			RTE_LOG(ERR, EAL, "Cannot map allocated element\n");
+			return NULL;
+		}
 	}
 
 	return elem == NULL ? NULL : (void *)(&elem[1]);
@@ -731,6 +834,29 @@ malloc_heap_alloc(const char *type, size_t size, int socket_arg,
 	return NULL;
 }
 
+/*
+ * Allocate up to n elements of the same size from a heap, taking the heap lock
+ * once. The heap is not expanded, so fewer elements may be returned.
+ */
+unsigned int
+malloc_heap_alloc_bulk(struct malloc_heap *heap, size_t size,
+		struct malloc_elem **elems, unsigned int n)
+{
+	unsigned int i;
+	void *data;
+
+	rte_spinlock_lock(&(heap->lock));
+	for (i = 0; i < n; i++) {
+		data = heap_alloc(heap, NULL, size, 0, 1, 0, false);
+		if (data == NULL)
+			break;
+		elems[i] = malloc_elem_from_data(data);
+	}
+	rte_spinlock_unlock(&(heap->lock));
+
+	return i;
+}
+
 static void *
 heap_alloc_biggest_on_heap_id(const char *type, unsigned int heap_id,
 		unsigned int flags, size_t align, bool contig)
@@ -819,50 +945,47 @@ malloc_heap_free_pages(void *aligned_start, size_t aligned_len)
 	return 0;
 }
 
-int
-malloc_heap_free(struct malloc_elem *elem)
+/*
+ * Return an element to its heap, and release the pages it spans back to the
+ * system if possible. Heap lock must be held.
+ */
+static void
+heap_free(struct malloc_elem *elem)
 {
 	struct malloc_heap *heap;
 	void *start, *aligned_start, *end, *aligned_end;
 	size_t len, aligned_len, page_sz;
 	struct rte_memseg_list *msl;
 	unsigned int i, n_segs, before_space, after_space;
-	int ret;
-
-	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
-		return -1;
 
 	/* elem may be merged with previous element, so keep heap address */
 	heap = elem->heap;
 	msl = elem->msl;
 	page_sz = (size_t)msl->page_sz;
 
-	rte_spinlock_lock(&(heap->lock));
-
 	/* mark element as free */
 	elem->state = ELEM_FREE;
 
 	elem = malloc_elem_free(elem);
 
 	/* anything after this is a bonus */
-	ret = 0;
 
 	/* ...of which we can't avail if we are in legacy mode, or if this is an
 	 * externally allocated segment.
 	 */
 	if (internal_config.legacy_mem || (msl->external > 0))
-		goto free_unlock;
+		return;
 
 	/* check if we can free any memory back to the system */
 	if (elem->size < page_sz)
-		goto free_unlock;
+		return;
 
 	/* if user requested to match allocations, the sizes must match - if not,
 	 * we will defer freeing these hugepages until the entire original allocation
 	 * can be freed
 	 */
 	if (internal_config.match_allocations && elem->size != elem->orig_size)
-		goto free_unlock;
+		return;
 
 	/* probably, but let's make sure, as we may not be using up full page */
 	start = elem;
@@ -875,7 +998,7 @@ malloc_heap_free(struct malloc_elem *elem)
 
 	/* can't free anything */
 	if (aligned_len < page_sz)
-		goto free_unlock;
+		return;
 
 	/* we can free something. however, some of these pages may be marked as
 	 * unfreeable, so also check that as well
@@ -897,7 +1020,7 @@ malloc_heap_free(struct malloc_elem *elem)
 
 	/* check if we can still free some pages */
 	if (n_segs == 0)
-		goto free_unlock;
+		return;
 
 	/* We're not done yet. We also have to check if by freeing space we will
 	 * be leaving free elements that are too small to store new elements.
@@ -912,7 +1035,7 @@ malloc_heap_free(struct malloc_elem *elem)
 		 * move the start forward by one page.
 		 */
 		if (n_segs == 1)
-			goto free_unlock;
+			return;
 
 		/* move start */
 		aligned_start = RTE_PTR_ADD(aligned_start, page_sz);
@@ -925,7 +1048,7 @@ malloc_heap_free(struct malloc_elem *elem)
 		 * move the end backwards by one page.
 		 */
 		if (n_segs == 1)
-			goto free_unlock;
+			return;
 
 		/* move end */
 		aligned_end = RTE_PTR_SUB(aligned_end, page_sz);
@@ -946,6 +1069,18 @@ malloc_heap_free(struct malloc_elem *elem)
 	 * to deliver allocation message to every single running process.
 	 */
 
+	/* the region is split from the element around it by writing headers
+	 * to pages this process may not have mapped yet.
+	 */
+	if (internal_config.lazy_mem_attach &&
+			(eal_memalloc_attach(aligned_start,
+				MALLOC_ELEM_HEADER_LEN) < 0 ||
+			eal_memalloc_attach(aligned_end,
+				MALLOC_ELEM_HEADER_LEN) < 0)) {
+		rte_mcfg_mem_write_unlock();
+		return;
+	}
+
 	malloc_elem_free_list_remove(elem);
 
 	malloc_elem_hide_region(elem, (void *) aligned_start, aligned_len);
@@ -991,9 +1126,48 @@ malloc_heap_free(struct malloc_elem *elem)
 		msl->socket_id, aligned_len >> 20ULL);
 
 	rte_mcfg_mem_write_unlock();
-free_unlock:
+}
+
+int
+malloc_heap_free(struct malloc_elem *elem)
+{
+	struct malloc_heap *heap;
+
+	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
+		return -1;
+
+	heap = elem->heap;
+
+	rte_spinlock_lock(&(heap->lock));
+	if (heap_attach_elems(heap) < 0) {
+		rte_spinlock_unlock(&(heap->lock));
+		return -1;
+	}
+	heap_free(elem);
+	rte_spinlock_unlock(&(heap->lock));
+
+	return 0;
+}
+
+/*
+ * Return a batch of elements to a heap, taking the heap lock once. All
+ * elements must belong to this heap and must have been checked by the caller.
+ */
+void
+malloc_heap_free_bulk(struct malloc_heap *heap, struct malloc_elem **elems,
+		unsigned int n)
+{
+	unsigned int i;
+
+	rte_spinlock_lock(&(heap->lock));
+	if (heap_attach_elems(heap) < 0) {
+		RTE_LOG(ERR, EAL, "Cannot map heap, %u elements leaked\n", n);
+		rte_spinlock_unlock(&(heap->lock));
+		return;
+	}
+	for (i = 0; i < n; i++)
+		heap_free(elems[i]);
 	rte_spinlock_unlock(&(heap->lock));
-	return ret;
 }
 
 int
@@ -1006,7 +1180,12 @@ malloc_heap_resize(struct malloc_elem *elem, size_t size)
 
 	rte_spinlock_lock(&(elem->heap->lock));
 
-	ret = malloc_elem_resize(elem, size);
+	ret = heap_attach_elems(elem->heap);
+	if (ret == 0)
+		ret = malloc_elem_resize(elem, size);
+	/* the element may have grown into pages not mapped yet */
+	if (ret == 0)
+		ret = elem_attach(elem);
 
 	rte_spinlock_unlock(&(elem->heap->lock));
 
@@ -1025,6 +1204,11 @@ malloc_heap_get_stats(struct malloc_heap *heap,
 
 	rte_spinlock_lock(&heap->lock);
 
+	if (heap_attach_elems(heap) < 0) {
+		rte_spinlock_unlock(&heap->lock);
+		return -1;
+	}
+
 	/* Initialise variables for heap */
 	socket_stats->free_count = 0;
 	socket_stats->heap_freesz_bytes = 0;
@@ -1064,6 +1248,12 @@ malloc_heap_dump(struct malloc_heap *heap, FILE *f)
 	fprintf(f, "Heap size: 0x%zx\n", heap->total_size);
 	fprintf(f, "Heap alloc count: %u\n", heap->alloc_count);
 
+	if (heap_attach_elems(heap) < 0) {
+		fprintf(f, "Heap elements cannot be mapped\n");
+		rte_spinlock_unlock(&heap->lock);
+		return;
+	}
+
 	elem = heap->first;
 	while (elem) {
 		malloc_elem_dump(elem, f);
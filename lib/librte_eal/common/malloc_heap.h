@@ -33,6 +33,10 @@ void *
 malloc_heap_alloc_biggest(const char *type, int socket, unsigned int flags,
 		size_t align, bool contig);
 
+unsigned int
+malloc_heap_alloc_bulk(struct malloc_heap *heap, size_t size,
+		struct malloc_elem **elems, unsigned int n);
+
 int
 malloc_heap_create(struct malloc_heap *heap, const char *heap_name);
 
@@ -58,9 +62,16 @@ int
 malloc_heap_remove_external_memory(struct malloc_heap *heap, void *va_addr,
 		size_t len);
 
+int
+malloc_heap_attach_data(const void *data);
+
 int
 malloc_heap_free(struct malloc_elem *elem);
 
+void
+malloc_heap_free_bulk(struct malloc_heap *heap, struct malloc_elem **elems,
+		unsigned int n);
+
 int
 malloc_heap_resize(struct malloc_elem *elem, size_t size);
 
@@ -27,26 +27,250 @@
 #include "eal_memalloc.h"
 #include "eal_memcfg.h"
 
+/*
+ * Per-lcore caches of small elements. Requests of up to 4 KiB from an EAL
+ * thread on its local heap are rounded up to a power-of-two size class and
+ * served from the cache of the calling lcore, without taking the heap lock.
+ * A size class is cached only after the lcore made MALLOC_CACHE_WARMUP
+ * requests of this class, so that one-off allocations keep their exact size
+ * and placement. The caches are refilled from and flushed to the heap in
+ * batches. Cached elements stay allocated from the heap point of view, in
+ * ELEM_CACHED state. The caches are disabled in debug mode, so that every
+ * free is checked.
+ */
+#if defined(RTE_MALLOC_LCORE_CACHE) && !defined(RTE_MALLOC_DEBUG)
+#define MALLOC_CACHE_ENABLED
+#endif
+
+#define MALLOC_CACHE_MIN_SHIFT 6U  /**< smallest class: 64 bytes */
+#define MALLOC_CACHE_MAX_SHIFT 12U /**< biggest class: 4 KiB */
+#define MALLOC_CACHE_NUM_CLASSES \
+	(MALLOC_CACHE_MAX_SHIFT - MALLOC_CACHE_MIN_SHIFT + 1)
+#define MALLOC_CACHE_SIZE 32  /**< max elements per class */
+#define MALLOC_CACHE_BATCH 16 /**< elements moved on refill or flush */
+#define MALLOC_CACHE_WARMUP 64 /**< requests before a class is cached */
+
+struct malloc_cache_class {
+	unsigned int len;
+	unsigned int requests; /**< requests seen, up to MALLOC_CACHE_WARMUP */
+	struct malloc_elem *elems[MALLOC_CACHE_SIZE];
+};
+
+struct malloc_lcore_cache {
+	int heap_id;  /**< index of the local heap, -1 if not resolved */
+	unsigned int len; /**< number of cached elements */
+	size_t size;  /**< total size of cached elements */
+	struct malloc_cache_class classes[MALLOC_CACHE_NUM_CLASSES];
+} __rte_cache_aligned;
+
+static struct malloc_lcore_cache lcore_caches[RTE_MAX_LCORE];
+
+RTE_INIT(malloc_cache_init)
+{
+	unsigned int i;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++)
+		lcore_caches[i].heap_id = -1;
+}
+
+/* get the cache of the calling lcore, NULL if it cannot be used */
+static inline struct malloc_lcore_cache *
+malloc_cache_get_local(void)
+{
+#ifdef MALLOC_CACHE_ENABLED
+	struct malloc_lcore_cache *cache;
+	unsigned int lcore_id = rte_lcore_id();
+
+	if (lcore_id >= RTE_MAX_LCORE)
+		return NULL;
+
+	cache = &lcore_caches[lcore_id];
+	if (unlikely(cache->heap_id < 0))
+		cache->heap_id =
+			malloc_socket_to_heap_id(malloc_get_numa_socket());
+	return cache->heap_id < 0 ? NULL : cache;
+#else
+	return NULL;
+#endif
+}
+
+static void
+malloc_cache_flush_class(struct malloc_lcore_cache *cache,
+		struct malloc_cache_class *cls, unsigned int n)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	unsigned int i;
+
+	/* the oldest elements go back to the heap */
+	for (i = 0; i < n; i++)
+		cache->size -= cls->elems[i]->size;
+	cache->len -= n;
+	malloc_heap_free_bulk(&mcfg->malloc_heaps[cache->heap_id],
+			cls->elems, n);
+	cls->len -= n;
+	memmove(cls->elems, &cls->elems[n], cls->len * sizeof(cls->elems[0]));
+}
+
+/* allocate from the local cache, NULL if the request cannot be cached */
+static void *
+malloc_cache_alloc(size_t size, unsigned int align, int socket_arg,
+		bool zero)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct malloc_lcore_cache *cache;
+	struct malloc_cache_class *cls;
+	struct malloc_elem *elem;
+	unsigned int shift, i;
+
+	if (size > (1U << MALLOC_CACHE_MAX_SHIFT) ||
+			align > RTE_CACHE_LINE_SIZE)
+		return NULL;
+
+	cache = malloc_cache_get_local();
+	if (cache == NULL)
+		return NULL;
+	if (socket_arg != SOCKET_ID_ANY &&
+			socket_arg != (int)malloc_get_numa_socket())
+		return NULL;
+
+	shift = RTE_MAX(rte_log2_u32(size), MALLOC_CACHE_MIN_SHIFT);
+	cls = &cache->classes[shift - MALLOC_CACHE_MIN_SHIFT];
+	if (unlikely(cls->requests < MALLOC_CACHE_WARMUP)) {
+		cls->requests++;
+		return NULL;
+	}
+	if (cls->len == 0) {
+		cls->len = malloc_heap_alloc_bulk(
+				&mcfg->malloc_heaps[cache->heap_id],
+				1U << shift, cls->elems, MALLOC_CACHE_BATCH);
+		if (cls->len == 0)
+			return NULL;
+		for (i = 0; i < cls->len; i++) {
+			cls->elems[i]->state = ELEM_CACHED;
+			cache->size += cls->elems[i]->size;
+		}
+		cache->len += cls->len;
+	}
+
+	elem = cls->elems[--cls->len];
+	cache->len--;
+	cache->size -= elem->size;
+	elem->state = ELEM_BUSY;
+
+	/* unlike the heap, the cache does not clear freed elements */
+	if (zero)
+		memset(&elem[1], 0, size);
+
+	return &elem[1];
+}
+
+/* return an element to the local cache, -1 if it cannot be cached */
+static int
+malloc_cache_free(struct malloc_elem *elem)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct malloc_lcore_cache *cache;
+	struct malloc_cache_class *cls;
+	size_t data_size;
+
+	if (elem == NULL || elem->state != ELEM_BUSY || elem->pad != 0)
+		return -1;
+
+	data_size = elem->size - MALLOC_ELEM_OVERHEAD;
+	if (data_size < (1U << MALLOC_CACHE_MIN_SHIFT) ||
+			data_size > (1U << MALLOC_CACHE_MAX_SHIFT))
+		return -1;
+
+	cache = malloc_cache_get_local();
+	if (cache == NULL ||
+			elem->heap != &mcfg->malloc_heaps[cache->heap_id])
+		return -1;
+
+	/* an element fits in the biggest class not exceeding its size */
+	cls = &cache->classes[rte_bsf32(rte_align32prevpow2(data_size)) -
+			MALLOC_CACHE_MIN_SHIFT];
+	if (cls->requests < MALLOC_CACHE_WARMUP)
+		return -1;
+	if (cls->len == MALLOC_CACHE_SIZE)
+		malloc_cache_flush_class(cache, cls, MALLOC_CACHE_BATCH);
+
+	elem->state = ELEM_CACHED;
+	cls->elems[cls->len++] = elem;
+	cache->len++;
+	cache->size += elem->size;
+
+	return 0;
+}
+
+/* account elements held in the caches of this process as free memory */
+static void
+malloc_cache_adjust_stats(int heap_id,
+		struct rte_malloc_socket_stats *socket_stats)
+{
+	unsigned int lcore_id, len = 0;
+	size_t size = 0;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		const struct malloc_lcore_cache *cache = &lcore_caches[lcore_id];
+
+		if (cache->heap_id != heap_id)
+			continue;
+		len += cache->len;
+		size += cache->size;
+	}
+	socket_stats->alloc_count -= len;
+	socket_stats->heap_freesz_bytes += size;
+	socket_stats->heap_allocsz_bytes -= size;
+}
+
+void
+rte_malloc_cache_flush(void)
+{
+	struct malloc_lcore_cache *cache = malloc_cache_get_local();
+	unsigned int i;
+
+	if (cache == NULL)
+		return;
+
+	for (i = 0; i < MALLOC_CACHE_NUM_CLASSES; i++) {
+		struct malloc_cache_class *cls = &cache->classes[i];
+
+		if (cls->len != 0)
+			malloc_cache_flush_class(cache, cls, cls->len);
+	}
+}
 
 /* Free the memory space back to heap */
 void rte_free(void *addr)
 {
+	struct malloc_elem *elem;
+
 	if (addr == NULL) return;
-	if (malloc_heap_free(malloc_elem_from_data(addr)) < 0)
+	if (malloc_heap_attach_data(addr) < 0) {
+		RTE_LOG(ERR, EAL, "Error: cannot map memory to free\n");
+		return;
+	}
+	elem = malloc_elem_from_data(addr);
+	if (malloc_cache_free(elem) == 0)
+		return;
+	if (malloc_heap_free(elem) < 0)
 		RTE_LOG(ERR, EAL, "Error: Invalid memory\n");
 }
 
-/*
- * Allocate memory on specified heap.
- */
-void *
-rte_malloc_socket(const char *type, size_t size, unsigned int align,
-		int socket_arg)
+static void *
+malloc_socket(const char *type, size_t size, unsigned int align,
+		int socket_arg, bool zero)
 {
+	void *ptr;
+
 	/* return NULL if size is 0 or alignment is not power-of-2 */
 	if (size == 0 || (align && !rte_is_power_of_2(align)))
 		return NULL;
 
+	ptr = malloc_cache_alloc(size, align, socket_arg, zero);
+	if (ptr != NULL)
+		return ptr;
+
 	/* if there are no hugepages and if we are not allocating from an
 	 * external heap, use memory from any socket available. checking for
 	 * socket being external may return -1 in case of invalid socket, but
@@ -60,6 +284,16 @@ rte_malloc_socket(const char *type, size_t size, unsigned int align,
 			align == 0 ? 1 : align, 0, false);
 }
 
+/*
+ * Allocate memory on specified heap.
+ */
+void *
+rte_malloc_socket(const char *type, size_t size, unsigned int align,
+		int socket_arg)
+{
+	return malloc_socket(type, size, align, socket_arg, false);
+}
+
 /*
  * Allocate memory on default heap.
  */
@@ -75,7 +309,7 @@ rte_malloc(const char *type, size_t size, unsigned align)
 void *
 rte_zmalloc_socket(const char *type, size_t size, unsigned align, int socket)
 {
-	void *ptr = rte_malloc_socket(type, size, align, socket);
+	void *ptr = malloc_socket(type, size, align, socket, true);
 
 #ifdef RTE_MALLOC_DEBUG
 	/*
@@ -125,6 +359,9 @@ rte_realloc_socket(void *ptr, size_t size, unsigned int align, int socket)
 	if (ptr == NULL)
 		return rte_malloc_socket(NULL, size, align, socket);
 
+	if (malloc_heap_attach_data(ptr) < 0)
+		return NULL;
+
 	struct malloc_elem *elem = malloc_elem_from_data(ptr);
 	if (elem == NULL) {
 		RTE_LOG(ERR, EAL, "Error: memory corruption detected\n");
@@ -168,14 +405,30 @@ rte_realloc(void *ptr, size_t size, unsigned int align)
 int
 rte_malloc_validate(const void *ptr, size_t *size)
 {
-	const struct malloc_elem *elem = malloc_elem_from_data(ptr);
-	if (!malloc_elem_cookies_ok(elem))
+	const struct malloc_elem *elem;
+
+	if (malloc_heap_attach_data(ptr) < 0)
+		return -1;
+	elem = malloc_elem_from_data(ptr);
+	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
 		return -1;
 	if (size != NULL)
 		*size = elem->size - elem->pad - MALLOC_ELEM_OVERHEAD;
 	return 0;
 }
 
+int
+rte_malloc_attach(const void *ptr)
+{
+	if (ptr == NULL)
+		return 0;
+	if (malloc_heap_attach_data(ptr) < 0) {
+		rte_errno = ENOMEM;
+		return -1;
+	}
+	return 0;
+}
+
 /*
  * Function to retrieve data for heap on given socket
  */
@@ -190,8 +443,10 @@ rte_malloc_get_socket_stats(int socket,
 	if (heap_idx < 0)
 		return -1;
 
-	return malloc_heap_get_stats(&mcfg->malloc_heaps[heap_idx],
-			socket_stats);
+	malloc_heap_get_stats(&mcfg->malloc_heaps[heap_idx], socket_stats);
+	malloc_cache_adjust_stats(heap_idx, socket_stats);
+
+	return 0;
 }
 
 /*
@@ -285,6 +540,7 @@ rte_malloc_dump_stats(FILE *f, __rte_unused const char *type)
 		struct malloc_heap *heap = &mcfg->malloc_heaps[heap_id];
 
 		malloc_heap_get_stats(heap, &sock_stats);
+		malloc_cache_adjust_stats(heap_id, &sock_stats);
 
 		fprintf(f, "Heap id:%u\n", heap_id);
 		fprintf(f, "\tHeap name:%s\n", heap->name);
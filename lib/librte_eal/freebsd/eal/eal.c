@@ -53,6 +53,7 @@
 #include "eal_hugepages.h"
 #include "eal_options.h"
 #include "eal_memcfg.h"
+#include "eal_trace.h"
 
 #define MEMSIZE_IF_NO_HUGE_PAGE (64ULL * 1024ULL * 1024ULL)
 
@@ -852,6 +853,12 @@ rte_eal_init(int argc, char **argv)
 		return -1;
 	}
 
+	if (eal_trace_init() < 0) {
+		rte_eal_init_alert("Cannot init trace");
+		rte_errno = EFAULT;
+		return -1;
+	}
+
 	eal_check_mem_on_local_socket();
 
 	eal_thread_init_master(rte_config.master_lcore);
@@ -945,6 +952,7 @@ int
 rte_eal_cleanup(void)
 {
 	rte_service_finalize();
+	eal_trace_fini();
 	rte_mp_channel_cleanup();
 	eal_cleanup_config(&internal_config);
 	return 0;
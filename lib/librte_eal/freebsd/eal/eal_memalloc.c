@@ -48,6 +48,20 @@ eal_memalloc_sync_with_primary(void)
 	return -1;
 }
 
+int
+eal_memalloc_lazy_attach_init(void)
+{
+	RTE_LOG(ERR, EAL, "Memory hotplug not supported on FreeBSD\n");
+	return -1;
+}
+
+int
+eal_memalloc_attach(const void *addr __rte_unused, size_t len __rte_unused)
+{
+	rte_errno = ENOTSUP;
+	return -1;
+}
+
 int
 eal_memalloc_get_seg_fd(int list_idx __rte_unused, int seg_idx __rte_unused)
 {
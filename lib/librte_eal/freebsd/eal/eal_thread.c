@@ -20,6 +20,7 @@
 #include <rte_per_lcore.h>
 #include <rte_eal.h>
 #include <rte_lcore.h>
+#include <rte_malloc.h>
 
 #include "eal_private.h"
 #include "eal_thread.h"
@@ -151,6 +152,10 @@ eal_thread_loop(__attribute__((unused)) void *arg)
 		/* call the function and store the return value */
 		fct_arg = lcore_config[lcore_id].arg;
 		ret = lcore_config[lcore_id].f(fct_arg);
+
+		/* give the memory cached by this lcore back to the heap */
+		rte_malloc_cache_flush();
+
 		lcore_config[lcore_id].ret = ret;
 		rte_wmb();
 		lcore_config[lcore_id].state = FINISHED;
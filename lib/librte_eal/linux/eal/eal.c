@@ -6,8 +6,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdarg.h>
+#include <time.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <syslog.h>
@@ -60,6 +62,7 @@
 #include "eal_memcfg.h"
 #include "eal_options.h"
 #include "eal_vfio.h"
+#include "eal_trace.h"
 #include "hotplug_mp.h"
 
 #define MEMSIZE_IF_NO_HUGE_PAGE (64ULL * 1024ULL * 1024ULL)
@@ -553,6 +556,10 @@ eal_usage(const char *prgname)
 	       "  --"OPT_LEGACY_MEM"        Legacy memory mode (no dynamic allocation, contiguous segments)\n"
 	       "  --"OPT_SINGLE_FILE_SEGMENTS" Put all hugepage memory in single files\n"
 	       "  --"OPT_MATCH_ALLOCATIONS" Free hugepages exactly as allocated\n"
+	       "  --"OPT_HUGE_WORKER_THREADS" Number of threads mapping hugepages of a socket\n"
+	       "                      (default: one per CPU of the socket)\n"
+	       "  --"OPT_LAZY_MEM_ATTACH"   Map memory of the primary process on lookup\n"
+	       "                      (secondary process only)\n"
 	       "\n");
 	/* Allow the application to print its usage message too if hook is set */
 	if ( rte_application_usage_hook ) {
@@ -648,6 +655,25 @@ eal_parse_base_virtaddr(const char *arg)
 	return 0;
 }
 
+static int
+eal_parse_huge_worker_threads(const char *arg)
+{
+	char *end;
+	unsigned long n;
+
+	errno = 0;
+	n = strtoul(arg, &end, 10);
+
+	/* check for errors */
+	if ((errno != 0) || (arg[0] == '\0') || end == NULL ||
+			(*end != '\0') || n == 0 || n > RTE_MAX_LCORE)
+		return -1;
+
+	internal_config.huge_worker_threads = n;
+
+	return 0;
+}
+
 static int
 eal_parse_vfio_intr(const char *mode)
 {
@@ -850,6 +876,20 @@ eal_parse_args(int argc, char **argv)
 			internal_config.match_allocations = 1;
 			break;
 
+		case OPT_LAZY_MEM_ATTACH_NUM:
+			internal_config.lazy_mem_attach = 1;
+			break;
+
+		case OPT_HUGE_WORKER_THREADS_NUM:
+			if (eal_parse_huge_worker_threads(optarg) < 0) {
+				RTE_LOG(ERR, EAL, "invalid parameter for --"
+						OPT_HUGE_WORKER_THREADS "\n");
+				eal_usage(prgname);
+				ret = -1;
+				goto out;
+			}
+			break;
+
 		default:
 			if (opt < OPT_LONG_MIN_NUM && isprint(opt)) {
 				RTE_LOG(ERR, EAL, "Option %c is not supported "
@@ -988,6 +1028,20 @@ is_iommu_enabled(void)
 	return n > 2;
 }
 
+/* log how long an init phase took, the TSC is not calibrated yet */
+static void
+eal_init_phase_done(const char *phase, const struct timespec *start)
+{
+	struct timespec now;
+	uint64_t ns;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ns = (uint64_t)(now.tv_sec - start->tv_sec) * NS_PER_S +
+		now.tv_nsec - start->tv_nsec;
+	RTE_LOG(DEBUG, EAL, "%s took %" PRIu64 ".%03" PRIu64 " ms\n",
+		phase, ns / 1000000, ns / 1000 % 1000);
+}
+
 /* Launch threads, called at application init(). */
 int
 rte_eal_init(int argc, char **argv)
@@ -1000,6 +1054,9 @@ rte_eal_init(int argc, char **argv)
 	char cpuset[RTE_CPU_AFFINITY_STR_LEN];
 	char thread_name[RTE_MAX_THREAD_NAME_LEN];
 	bool phys_addrs;
+	struct timespec init_start, phase_start;
+
+	clock_gettime(CLOCK_MONOTONIC, &init_start);
 
 	/* checks if the machine is adequate */
 	if (!rte_cpu_is_supported()) {
@@ -1060,6 +1117,14 @@ rte_eal_init(int argc, char **argv)
 		return -1;
 	}
 
+	/* the memory mode of a secondary process is known from here */
+	if (internal_config.lazy_mem_attach &&
+			(rte_eal_process_type() == RTE_PROC_PRIMARY ||
+			 internal_config.legacy_mem)) {
+		RTE_LOG(WARNING, EAL, "Option --"OPT_LAZY_MEM_ATTACH" is only supported by secondary processes in non-legacy mode, ignoring\n");
+		internal_config.lazy_mem_attach = 0;
+	}
+
 	// 中断处理线程的初始化
 	if (rte_eal_intr_init() < 0) {
 		rte_eal_init_alert("Cannot init interrupt-handling thread");
@@ -1163,6 +1228,7 @@ rte_eal_init(int argc, char **argv)
 		// 大页内存初始化
 		// PRIMARY 初始化
 	if (internal_config.no_hugetlbfs == 0) {
+		clock_gettime(CLOCK_MONOTONIC, &phase_start);
 		/* rte_config isn't initialized yet */
 		ret = internal_config.process_type == RTE_PROC_PRIMARY ?
 				eal_hugepage_info_init() :
@@ -1173,6 +1239,7 @@ rte_eal_init(int argc, char **argv)
 			rte_atomic32_clear(&run_once);
 			return -1;
 		}
+		eal_init_phase_done("Hugepage info init", &phase_start);
 	}
 
 	if (internal_config.memory == 0 && internal_config.force_sockets == 0) {
@@ -1212,6 +1279,7 @@ rte_eal_init(int argc, char **argv)
 	 * not present in primary processes, so to avoid any potential issues,
 	 * initialize memzones first.
 	 */
+	clock_gettime(CLOCK_MONOTONIC, &phase_start);
 	// 初始化的是rte_config中的mem_config下的memzones成员
 	if (rte_eal_memzone_init() < 0) {
 		rte_eal_init_alert("Cannot init memzone");
@@ -1225,16 +1293,20 @@ rte_eal_init(int argc, char **argv)
 		rte_errno = ENOMEM;
 		return -1;
 	}
+	eal_init_phase_done("Memory init", &phase_start);
 
 	/* the directories are locked during eal_hugepage_info_init */
 	eal_hugedirs_unlock();
 
+	clock_gettime(CLOCK_MONOTONIC, &phase_start);
+
 	// 内存堆初始化
 	if (rte_eal_malloc_heap_init() < 0) {
 		rte_eal_init_alert("Cannot init malloc heap");
 		rte_errno = ENODEV;
 		return -1;
 	}
+	eal_init_phase_done("Malloc heap init", &phase_start);
 
 	if (rte_eal_tailqs_init() < 0) {
 		rte_eal_init_alert("Cannot init tail queues for objects");
@@ -1249,6 +1321,12 @@ rte_eal_init(int argc, char **argv)
 		return -1;
 	}
 
+	if (eal_trace_init() < 0) {
+		rte_eal_init_alert("Cannot init trace");
+		rte_errno = EFAULT;
+		return -1;
+	}
+
 	// 检查main_lcore所在socket上的内存配置
 	eal_check_mem_on_local_socket();
 
@@ -1355,6 +1433,8 @@ rte_eal_init(int argc, char **argv)
 	/* Call each registered callback, if enabled */
 	rte_option_init();
 
+	eal_init_phase_done("EAL init", &init_start);
+
 	return fctret;
 }
 
@@ -1384,6 +1464,7 @@ rte_eal_cleanup(void)
 	if (rte_eal_process_type() == RTE_PROC_PRIMARY)
 		rte_memseg_walk(mark_freeable, NULL);
 	rte_service_finalize();
+	eal_trace_fini();
 	rte_mp_channel_cleanup();
 	eal_cleanup_config(&internal_config);
 	return 0;
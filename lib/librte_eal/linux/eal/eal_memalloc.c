@@ -18,6 +18,8 @@
 #include <unistd.h>
 #include <limits.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
 #include <signal.h>
@@ -38,7 +40,9 @@
 #include <rte_eal_memconfig.h>
 #include <rte_eal.h>
 #include <rte_errno.h>
+#include <rte_lcore.h>
 #include <rte_memory.h>
+#include <rte_per_lcore.h>
 #include <rte_spinlock.h>
 
 #include "eal_filesystem.h"
@@ -106,11 +110,28 @@ static struct {
 /** local copy of a memory map, used to synchronize memory hotplug in MP */
 static struct rte_memseg_list local_memsegs[RTE_MAX_MEMSEG_LISTS];
 
-static sigjmp_buf huge_jmpenv;
+/*
+ * with --lazy-mem-attach, a secondary process does not map the pages of the
+ * primary process at startup, but on demand: through rte_mem_attach(), and
+ * when memory is looked up through the memzone, malloc and tailq APIs. the
+ * VA space of the memseg lists is reserved without any access rights, so
+ * that accessing a page which is not mapped yet faults deterministically.
+ *
+ * the lock serializes changes to the local memory map. it is recursive, as
+ * a mem event callback run while synchronizing with the primary process may
+ * look up memory which is not mapped yet. in that case, the hugepage
+ * directory is already locked by this thread.
+ */
+static rte_spinlock_recursive_t local_memsegs_lock =
+		RTE_SPINLOCK_RECURSIVE_INITIALIZER;
+static bool local_memsegs_dir_locked;
+
+/* per-thread, as pages may be mapped by several threads at once */
+static RTE_DEFINE_PER_LCORE(sigjmp_buf, huge_jmpenv);
 
 static void __rte_unused huge_sigbus_handler(int signo __rte_unused)
 {
-	siglongjmp(huge_jmpenv, 1);
+	siglongjmp(RTE_PER_LCORE(huge_jmpenv), 1);
 }
 
 /* Put setjmp into a wrap method to avoid compiling error. Any non-volatile,
@@ -119,7 +140,7 @@ static void __rte_unused huge_sigbus_handler(int signo __rte_unused)
  */
 static int __rte_unused huge_wrap_sigsetjmp(void)
 {
-	return sigsetjmp(huge_jmpenv, 1);
+	return sigsetjmp(RTE_PER_LCORE(huge_jmpenv), 1);
 }
 
 static struct sigaction huge_action_old;
@@ -678,10 +699,17 @@ free_seg(struct rte_memseg *ms, struct hugepage_info *hi,
 	int fd, ret = 0;
 	bool exit_early;
 
-	/* erase page data */
-	memset(ms->addr, 0, ms->len);
-
-	if (mmap(ms->addr, ms->len, PROT_READ,
+	/* erase page data, unless the page goes back to the kernel: nobody
+	 * else can map it then, and the kernel zeroes it before reusing it.
+	 */
+	if (internal_config.single_file_segments ||
+			(!internal_config.in_memory &&
+			 !internal_config.hugepage_unlink))
+		memset(ms->addr, 0, ms->len);
+
+	/* with lazy attach, a next access to the page has to fault */
+	if (mmap(ms->addr, ms->len,
+			internal_config.lazy_mem_attach ? PROT_NONE : PROT_READ,
 			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) ==
 				MAP_FAILED) {
 		RTE_LOG(DEBUG, EAL, "couldn't unmap page\n");
@@ -751,13 +779,205 @@ struct alloc_walk_param {
 	int socket;
 	bool exact;
 };
+
+/*
+ * mapping a hugepage is dominated by the kernel zeroing it on first fault,
+ * so big requests are split between several threads, running on the CPUs
+ * of the socket the memory comes from. a thread is only worth starting for
+ * at least this much memory. this is only done during EAL init, before the
+ * lcores run: later, the threads would compete with them for their CPUs.
+ */
+#define ALLOC_WORKER_MIN_LEN (64ULL << 20)
+#define ALLOC_WORKERS_MAX 64
+
+/* CPUs this process may run on, per socket, set by eal_memalloc_init() */
+static struct {
+	rte_cpuset_t cpuset;
+	unsigned int n_cpus;
+} socket_cpus[RTE_MAX_NUMA_NODES];
+
+struct alloc_worker {
+	pthread_t tid;
+	const struct alloc_walk_param *wa;
+	struct rte_memseg_list *msl;
+	unsigned int msl_idx;
+	int start_idx; /**< first segment mapped by this worker */
+	unsigned int n_segs; /**< number of segments to map */
+	unsigned int n_done; /**< number of segments mapped, from start_idx */
+};
+
+static void
+init_socket_cpus(void)
+{
+	rte_cpuset_t allowed;
+	unsigned int cpu, socket_id;
+
+	/* the master thread is not pinned to its lcore yet, so this is the
+	 * affinity of the process.
+	 */
+	if (pthread_getaffinity_np(pthread_self(), sizeof(allowed),
+			&allowed) != 0)
+		return;
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, &allowed) || !eal_cpu_detected(cpu))
+			continue;
+		socket_id = eal_cpu_socket_id(cpu);
+		if (socket_id >= RTE_MAX_NUMA_NODES)
+			continue;
+		CPU_SET(cpu, &socket_cpus[socket_id].cpuset);
+		socket_cpus[socket_id].n_cpus++;
+	}
+}
+
+static unsigned int
+alloc_worker_count(int socket_id, size_t page_sz, unsigned int n_segs)
+{
+	unsigned int n;
+
+	/* pages of a single file share a reference count */
+	if (internal_config.single_file_segments ||
+			internal_config.init_complete)
+		return 1;
+
+	n = internal_config.huge_worker_threads;
+	if (n == 0)
+		n = socket_cpus[socket_id].n_cpus;
+
+	n = RTE_MIN(n, (unsigned int)RTE_MIN((uint64_t)ALLOC_WORKERS_MAX,
+			(uint64_t)page_sz * n_segs / ALLOC_WORKER_MIN_LEN));
+	n = RTE_MIN(n, n_segs);
+
+	return RTE_MAX(n, 1U);
+}
+
+static void
+alloc_worker_map(struct alloc_worker *w)
+{
+	const struct alloc_walk_param *wa = w->wa;
+	unsigned int i;
+
+	for (i = 0; i < w->n_segs; i++) {
+		int seg_idx = w->start_idx + i;
+		struct rte_memseg *cur;
+		void *map_addr;
+
+		cur = rte_fbarray_get(&w->msl->memseg_arr, seg_idx);
+		map_addr = RTE_PTR_ADD(w->msl->base_va,
+				(size_t)seg_idx * w->msl->page_sz);
+
+		if (alloc_seg(cur, map_addr, wa->socket, wa->hi,
+				w->msl_idx, seg_idx))
+			break;
+	}
+	w->n_done = i;
+}
+
+static void *
+alloc_worker_main(void *arg)
+{
+	struct alloc_worker *w = arg;
+	int socket_id = w->wa->socket;
+
+	/* the memory policy is inherited from the thread which started us,
+	 * run close to the memory so that the kernel zeroes it locally.
+	 */
+	if (socket_cpus[socket_id].n_cpus != 0 &&
+			pthread_setaffinity_np(pthread_self(),
+				sizeof(rte_cpuset_t),
+				&socket_cpus[socket_id].cpuset) != 0)
+		RTE_LOG(DEBUG, EAL, "%s(): cannot set affinity\n", __func__);
+
+	alloc_worker_map(w);
+
+	return NULL;
+}
+
+/*
+ * map segments [start_idx, start_idx + n_segs) of a list, and return how
+ * many of them were mapped, from start_idx on. segments mapped past the
+ * first failure are unmapped.
+ */
+static unsigned int
+alloc_seg_range(const struct alloc_walk_param *wa, struct rte_memseg_list *msl,
+		unsigned int msl_idx, int start_idx, unsigned int n_segs)
+{
+	struct alloc_worker single, *workers = &single;
+	unsigned int n_workers, i, j, n_mapped;
+	int ret;
+
+	memset(&single, 0, sizeof(single));
+	n_workers = alloc_worker_count(wa->socket, msl->page_sz, n_segs);
+	if (n_workers > 1) {
+		workers = calloc(n_workers, sizeof(*workers));
+		if (workers == NULL) {
+			workers = &single;
+			n_workers = 1;
+		}
+	}
+
+	RTE_LOG(DEBUG, EAL, "Mapping %u pages of size %" PRIu64 "M on socket %i with %u thread(s)\n",
+		n_segs, msl->page_sz >> 20, wa->socket, n_workers);
+
+	for (i = 0; i < n_workers; i++) {
+		struct alloc_worker *w = &workers[i];
+
+		w->wa = wa;
+		w->msl = msl;
+		w->msl_idx = msl_idx;
+		w->n_segs = n_segs / n_workers + (i < n_segs % n_workers);
+		w->start_idx = i == 0 ? start_idx :
+				workers[i - 1].start_idx +
+				(int)workers[i - 1].n_segs;
+	}
+
+	/* the calling thread maps the first chunk itself */
+	for (i = 1; i < n_workers; i++) {
+		ret = pthread_create(&workers[i].tid, NULL, alloc_worker_main,
+				&workers[i]);
+		if (ret != 0) {
+			RTE_LOG(DEBUG, EAL, "%s(): cannot create thread: %s\n",
+				__func__, strerror(ret));
+			/* map the remaining chunks here */
+			break;
+		}
+	}
+	alloc_worker_map(&workers[0]);
+	for (j = i; j < n_workers; j++)
+		alloc_worker_map(&workers[j]);
+	for (j = 1; j < i; j++)
+		pthread_join(workers[j].tid, NULL);
+
+	/* keep what was mapped contiguously from the start of the range */
+	n_mapped = 0;
+	for (i = 0; i < n_workers; i++) {
+		n_mapped += workers[i].n_done;
+		if (workers[i].n_done < workers[i].n_segs)
+			break;
+	}
+	for (i++; i < n_workers; i++) {
+		for (j = 0; j < workers[i].n_done; j++) {
+			int seg_idx = workers[i].start_idx + j;
+			struct rte_memseg *tmp;
+
+			tmp = rte_fbarray_get(&msl->memseg_arr, seg_idx);
+			if (free_seg(tmp, wa->hi, msl_idx, seg_idx))
+				RTE_LOG(DEBUG, EAL, "Cannot free page\n");
+		}
+	}
+
+	if (workers != &single)
+		free(workers);
+
+	return n_mapped;
+}
+
 static int
 alloc_seg_walk(const struct rte_memseg_list *msl, void *arg)
 {
 	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
 	struct alloc_walk_param *wa = arg;
 	struct rte_memseg_list *cur_msl;
-	size_t page_sz;
 	int cur_idx, start_idx, j, dir_fd = -1;
 	unsigned int msl_idx, need, i;
 
@@ -766,8 +986,6 @@ alloc_seg_walk(const struct rte_memseg_list *msl, void *arg)
 	if (msl->socket_id != wa->socket)
 		return 0;
 
-	page_sz = (size_t)msl->page_sz;
-
 	msl_idx = msl - mcfg->memsegs;
 	cur_msl = &mcfg->memsegs[msl_idx];
 
@@ -825,31 +1043,18 @@ alloc_seg_walk(const struct rte_memseg_list *msl, void *arg)
 		}
 	}
 
-	for (i = 0; i < need; i++, cur_idx++) {
-		struct rte_memseg *cur;
-		void *map_addr;
-
-		cur = rte_fbarray_get(&cur_msl->memseg_arr, cur_idx);
-		map_addr = RTE_PTR_ADD(cur_msl->base_va,
-				cur_idx * page_sz);
-
-		if (alloc_seg(cur, map_addr, wa->socket, wa->hi,
-				msl_idx, cur_idx)) {
-			RTE_LOG(DEBUG, EAL, "attempted to allocate %i segments, but only %i were allocated\n",
-				need, i);
-
-			/* if exact number wasn't requested, stop */
-			if (!wa->exact)
-				goto out;
+	i = alloc_seg_range(wa, cur_msl, msl_idx, start_idx, need);
+	if (i < need) {
+		RTE_LOG(DEBUG, EAL, "attempted to allocate %i segments, but only %i were allocated\n",
+			need, i);
 
+		/* if exact number wasn't requested, keep what we have */
+		if (wa->exact) {
 			/* clean up */
-			for (j = start_idx; j < cur_idx; j++) {
+			for (j = start_idx; j < start_idx + (int)i; j++) {
 				struct rte_memseg *tmp;
-				struct rte_fbarray *arr =
-						&cur_msl->memseg_arr;
 
-				tmp = rte_fbarray_get(arr, j);
-				rte_fbarray_set_free(arr, j);
+				tmp = rte_fbarray_get(&cur_msl->memseg_arr, j);
 
 				/* free_seg may attempt to create a file, which
 				 * may fail.
@@ -865,12 +1070,16 @@ alloc_seg_walk(const struct rte_memseg_list *msl, void *arg)
 				close(dir_fd);
 			return -1;
 		}
-		if (wa->ms)
-			wa->ms[i] = cur;
+	}
 
+	for (j = 0; j < (int)i; j++) {
+		cur_idx = start_idx + j;
+		if (wa->ms)
+			wa->ms[j] = rte_fbarray_get(&cur_msl->memseg_arr,
+					cur_idx);
 		rte_fbarray_set_used(&cur_msl->memseg_arr, cur_idx);
 	}
-out:
+
 	wa->segs_allocated = i;
 	if (i > 0)
 		cur_msl->version++;
@@ -1267,6 +1476,8 @@ sync_existing(struct rte_memseg_list *primary_msl,
 {
 	int ret, dir_fd;
 
+	rte_spinlock_recursive_lock(&local_memsegs_lock);
+
 	/* do not allow any page allocations during the time we're allocating,
 	 * because file creation and locking operations are not atomic,
 	 * and we might be the first or the last ones to use a particular page,
@@ -1276,6 +1487,7 @@ sync_existing(struct rte_memseg_list *primary_msl,
 	if (dir_fd < 0) {
 		RTE_LOG(ERR, EAL, "%s(): Cannot open '%s': %s\n", __func__,
 			hi->hugedir, strerror(errno));
+		rte_spinlock_recursive_unlock(&local_memsegs_lock);
 		return -1;
 	}
 	/* blocking writelock */
@@ -1283,13 +1495,19 @@ sync_existing(struct rte_memseg_list *primary_msl,
 		RTE_LOG(ERR, EAL, "%s(): Cannot lock '%s': %s\n", __func__,
 			hi->hugedir, strerror(errno));
 		close(dir_fd);
+		rte_spinlock_recursive_unlock(&local_memsegs_lock);
 		return -1;
 	}
+	local_memsegs_dir_locked = true;
 
-	/* ensure all allocated space is the same in both lists */
-	ret = sync_status(primary_msl, local_msl, hi, msl_idx, true);
-	if (ret < 0)
-		goto fail;
+	/* ensure all allocated space is the same in both lists, unless pages
+	 * are attached when they are accessed.
+	 */
+	if (!internal_config.lazy_mem_attach) {
+		ret = sync_status(primary_msl, local_msl, hi, msl_idx, true);
+		if (ret < 0)
+			goto fail;
+	}
 
 	/* ensure all unallocated space is the same in both lists */
 	ret = sync_status(primary_msl, local_msl, hi, msl_idx, false);
@@ -1299,21 +1517,36 @@ sync_existing(struct rte_memseg_list *primary_msl,
 	/* update version number */
 	local_msl->version = primary_msl->version;
 
+	local_memsegs_dir_locked = false;
 	close(dir_fd);
+	rte_spinlock_recursive_unlock(&local_memsegs_lock);
 
 	return 0;
 fail:
+	local_memsegs_dir_locked = false;
 	close(dir_fd);
+	rte_spinlock_recursive_unlock(&local_memsegs_lock);
 	return -1;
 }
 
+static struct hugepage_info *
+get_hugepage_info(uint64_t page_sz)
+{
+	unsigned int i;
+
+	for (i = 0; i < RTE_DIM(internal_config.hugepage_info); i++) {
+		if (internal_config.hugepage_info[i].hugepage_sz == page_sz)
+			return &internal_config.hugepage_info[i];
+	}
+	return NULL;
+}
+
 static int
 sync_walk(const struct rte_memseg_list *msl, void *arg __rte_unused)
 {
 	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
 	struct rte_memseg_list *primary_msl, *local_msl;
-	struct hugepage_info *hi = NULL;
-	unsigned int i;
+	struct hugepage_info *hi;
 	int msl_idx;
 
 	if (msl->external)
@@ -1323,15 +1556,7 @@ sync_walk(const struct rte_memseg_list *msl, void *arg __rte_unused)
 	primary_msl = &mcfg->memsegs[msl_idx];
 	local_msl = &local_memsegs[msl_idx];
 
-	for (i = 0; i < RTE_DIM(internal_config.hugepage_info); i++) {
-		uint64_t cur_sz =
-			internal_config.hugepage_info[i].hugepage_sz;
-		uint64_t msl_sz = primary_msl->page_sz;
-		if (msl_sz == cur_sz) {
-			hi = &internal_config.hugepage_info[i];
-			break;
-		}
-	}
+	hi = get_hugepage_info(primary_msl->page_sz);
 	if (!hi) {
 		RTE_LOG(ERR, EAL, "Can't find relevant hugepage_info entry\n");
 		return -1;
@@ -1358,6 +1583,146 @@ eal_memalloc_sync_with_primary(void)
 	return 0;
 }
 
+/* check whether a segment is allocated in the primary process only */
+static int
+lazy_seg_unattached(unsigned int msl_idx, int seg_idx)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+
+	return rte_fbarray_is_used(&mcfg->memsegs[msl_idx].memseg_arr,
+			seg_idx) == 1 &&
+		rte_fbarray_is_used(&local_memsegs[msl_idx].memseg_arr,
+			seg_idx) == 0;
+}
+
+/*
+ * map the segments of a list in [start_idx, end_idx) which are allocated in
+ * the primary process but not mapped here yet. returns -1 if one of them
+ * could not be mapped.
+ */
+static int
+lazy_attach_segs(unsigned int msl_idx, int start_idx, int end_idx)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct rte_memseg_list *primary_msl, *local_msl;
+	struct hugepage_info *hi;
+	int seg_idx, dir_fd = -1, ret = 0;
+
+	primary_msl = &mcfg->memsegs[msl_idx];
+	local_msl = &local_memsegs[msl_idx];
+
+	/* most lookups hit pages which are already mapped, do not lock the
+	 * hugepage directory for those.
+	 */
+	for (seg_idx = start_idx; seg_idx < end_idx; seg_idx++)
+		if (lazy_seg_unattached(msl_idx, seg_idx))
+			break;
+	if (seg_idx == end_idx)
+		return 0;
+	start_idx = seg_idx;
+
+	hi = get_hugepage_info(primary_msl->page_sz);
+	if (hi == NULL)
+		return -1;
+
+	rte_spinlock_recursive_lock(&local_memsegs_lock);
+
+	/* the primary process allocates and frees pages with the hugepage
+	 * directory locked, so lock it as well, unless this thread already
+	 * holds it while synchronizing.
+	 */
+	if (!local_memsegs_dir_locked) {
+		dir_fd = open(hi->hugedir, O_RDONLY);
+		if (dir_fd < 0 || flock(dir_fd, LOCK_EX)) {
+			RTE_LOG(ERR, EAL, "%s(): Cannot lock '%s': %s\n",
+				__func__, hi->hugedir, strerror(errno));
+			if (dir_fd >= 0)
+				close(dir_fd);
+			rte_spinlock_recursive_unlock(&local_memsegs_lock);
+			return -1;
+		}
+	}
+
+	for (seg_idx = start_idx; seg_idx < end_idx; seg_idx++) {
+		struct rte_memseg *p_ms, *l_ms;
+
+		if (!lazy_seg_unattached(msl_idx, seg_idx))
+			continue;
+
+		p_ms = rte_fbarray_get(&primary_msl->memseg_arr, seg_idx);
+		l_ms = rte_fbarray_get(&local_msl->memseg_arr, seg_idx);
+
+		if (alloc_seg(l_ms, p_ms->addr, p_ms->socket_id, hi, msl_idx,
+				seg_idx) < 0) {
+			/* the VA space was reserved again, readable */
+			mprotect(p_ms->addr, p_ms->len, PROT_NONE);
+			ret = -1;
+			break;
+		}
+		rte_fbarray_set_used(&local_msl->memseg_arr, seg_idx);
+	}
+
+	if (dir_fd >= 0)
+		close(dir_fd);
+	rte_spinlock_recursive_unlock(&local_memsegs_lock);
+
+	return ret;
+}
+
+int
+eal_memalloc_lazy_attach_init(void)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	unsigned int i;
+
+	/* make any access to the memory of the primary process fault */
+	for (i = 0; i < RTE_MAX_MEMSEG_LISTS; i++) {
+		struct rte_memseg_list *msl = &mcfg->memsegs[i];
+
+		if (msl->base_va == NULL || msl->external)
+			continue;
+		if (mprotect(msl->base_va, msl->len, PROT_NONE) < 0) {
+			RTE_LOG(ERR, EAL, "%s(): mprotect() failed: %s\n",
+				__func__, strerror(errno));
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int
+eal_memalloc_attach(const void *addr, size_t len)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	const void *end = RTE_PTR_ADD(addr, len);
+	unsigned int i;
+
+	for (i = 0; i < RTE_MAX_MEMSEG_LISTS; i++) {
+		const struct rte_memseg_list *msl = &mcfg->memsegs[i];
+		const void *msl_end;
+		int start_idx, end_idx;
+
+		if (msl->base_va == NULL || msl->external)
+			continue;
+		msl_end = RTE_PTR_ADD(msl->base_va, msl->len);
+		if (end <= msl->base_va || addr >= msl_end)
+			continue;
+
+		start_idx = addr <= msl->base_va ? 0 :
+			RTE_PTR_DIFF(addr, msl->base_va) / msl->page_sz;
+		end_idx = end >= msl_end ? msl->memseg_arr.len :
+			RTE_PTR_DIFF(RTE_PTR_ALIGN_CEIL(end, msl->page_sz),
+				msl->base_va) / msl->page_sz;
+
+		if (lazy_attach_segs(i, start_idx, end_idx) < 0) {
+			rte_errno = ENOMEM;
+			return -1;
+		}
+	}
+	return 0;
+}
+
 static int
 secondary_msl_create_walk(const struct rte_memseg_list *msl,
 		void *arg __rte_unused)
@@ -1566,6 +1931,8 @@ eal_memalloc_get_seg_fd_offset(int list_idx, int seg_idx, size_t *offset)
 int
 eal_memalloc_init(void)
 {
+	init_socket_cpus();
+
 	if (rte_eal_process_type() == RTE_PROC_SECONDARY)
 		if (rte_memseg_list_walk(secondary_msl_create_walk, NULL) < 0)
 			return -1;
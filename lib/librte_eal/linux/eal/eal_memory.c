@@ -1962,6 +1962,13 @@ error:
 static int
 eal_hugepage_attach(void)
 {
+	if (internal_config.lazy_mem_attach) {
+		if (eal_memalloc_lazy_attach_init()) {
+			RTE_LOG(ERR, EAL, "Could not set up lazy attach of primary process memory\n");
+			return -1;
+		}
+		return 0;
+	}
 	if (eal_memalloc_sync_with_primary()) {
 		RTE_LOG(ERR, EAL, "Could not map memory from primary process\n");
 		if (aslr_enabled() > 0)
@@ -539,7 +539,7 @@ rte_efd_create(const char *name, uint32_t max_num_rules, uint32_t key_len,
 	 * Guarantee there's no existing: this is normally already checked
 	 * by ring creation above
 	 */
-	TAILQ_FOREACH(te, efd_list, next)
+	RTE_TAILQ_FOREACH(te, efd_list, next)
 	{
 		table = (struct rte_efd_table *) te->data;
 		if (strncmp(name, table->name, RTE_EFD_NAMESIZE) == 0)
@@ -685,7 +685,7 @@ rte_efd_create(const char *name, uint32_t max_num_rules, uint32_t key_len,
 			offline_cpu_socket);
 
 	te->data = (void *) table;
-	TAILQ_INSERT_TAIL(efd_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(efd_list, te, next);
 	rte_mcfg_tailq_write_unlock();
 
 	snprintf(ring_name, sizeof(ring_name), "HT_%s", table->name);
@@ -723,7 +723,7 @@ rte_efd_find_existing(const char *name)
 
 	rte_mcfg_tailq_read_lock();
 
-	TAILQ_FOREACH(te, efd_list, next)
+	RTE_TAILQ_FOREACH(te, efd_list, next)
 	{
 		table = (struct rte_efd_table *) te->data;
 		if (strncmp(name, table->name, RTE_EFD_NAMESIZE) == 0)
@@ -754,9 +754,9 @@ rte_efd_free(struct rte_efd_table *table)
 	efd_list = RTE_TAILQ_CAST(rte_efd_tailq.head, rte_efd_list);
 	rte_mcfg_tailq_write_lock();
 
-	TAILQ_FOREACH_SAFE(te, efd_list, next, temp) {
+	RTE_TAILQ_FOREACH_SAFE(te, efd_list, next, temp) {
 		if (te->data == (void *) table) {
-			TAILQ_REMOVE(efd_list, te, next);
+			RTE_TAILQ_REMOVE(efd_list, te, next);
 			rte_free(te);
 			break;
 		}
@@ -0,0 +1,12 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#include <rte_trace_point_register.h>
+
+#include <rte_ethdev_trace_fp.h>
+
+RTE_TRACE_POINT_REGISTER(rte_ethdev_trace_rx_burst,
+	lib.ethdev.rx.burst)
+RTE_TRACE_POINT_REGISTER(rte_ethdev_trace_tx_burst,
+	lib.ethdev.tx.burst)
@@ -508,6 +508,31 @@ unlock:
 	return eth_dev;
 }
 
+/*
+ * In a secondary process started with --lazy-mem-attach, map the private data,
+ * the MAC addresses and the queues allocated by the primary process for a
+ * port, which the drivers read when probing the port in a secondary process.
+ */
+static int
+eth_dev_attach_secondary_data(const struct rte_eth_dev_data *data)
+{
+	uint16_t i;
+
+	if (rte_malloc_attach(data->dev_private) < 0 ||
+			rte_malloc_attach(data->mac_addrs) < 0 ||
+			rte_malloc_attach(data->hash_mac_addrs) < 0 ||
+			rte_malloc_attach(data->rx_queues) < 0 ||
+			rte_malloc_attach(data->tx_queues) < 0)
+		return -1;
+	for (i = 0; data->rx_queues != NULL && i < data->nb_rx_queues; i++)
+		if (rte_malloc_attach(data->rx_queues[i]) < 0)
+			return -1;
+	for (i = 0; data->tx_queues != NULL && i < data->nb_tx_queues; i++)
+		if (rte_malloc_attach(data->tx_queues[i]) < 0)
+			return -1;
+	return 0;
+}
+
 /*
  * Attach to a port already registered by the primary process, which
  * makes sure that the same device would have the same port id both
@@ -532,6 +557,10 @@ rte_eth_dev_attach_secondary(const char *name)
 		RTE_ETHDEV_LOG(ERR,
 			"Device %s is not driven by the primary process\n",
 			name);
+	} else if (eth_dev_attach_secondary_data(
+			&rte_eth_dev_shared_data->data[i]) < 0) {
+		RTE_ETHDEV_LOG(ERR,
+			"Cannot map the data of device %s\n", name);
 	} else {
 		eth_dev = eth_dev_get(i);
 		RTE_ASSERT(eth_dev->data->port_id == i);
@@ -1795,10 +1824,7 @@ void
 rte_eth_tx_buffer_drop_callback(struct rte_mbuf **pkts, uint16_t unsent,
 		void *userdata __rte_unused)
 {
-	unsigned i;
-
-	for (i = 0; i < unsent; i++)
-		rte_pktmbuf_free(pkts[i]);
+	rte_pktmbuf_free_bulk(pkts, unsent);
 }
 
 void
@@ -1806,11 +1832,8 @@ rte_eth_tx_buffer_count_callback(struct rte_mbuf **pkts, uint16_t unsent,
 		void *userdata)
 {
 	uint64_t *count = userdata;
-	unsigned i;
-
-	for (i = 0; i < unsent; i++)
-		rte_pktmbuf_free(pkts[i]);
 
+	rte_pktmbuf_free_bulk(pkts, unsent);
 	*count += unsent;
 }
 
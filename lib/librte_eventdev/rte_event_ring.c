@@ -26,6 +26,11 @@ rte_event_ring_init(struct rte_event_ring *r, const char *name,
 	RTE_BUILD_BUG_ON((sizeof(struct rte_event_ring) &
 			  RTE_CACHE_LINE_MASK) != 0);
 
+	/* event rings only support the MP/MC and SP/SC sync modes */
+	if (flags & (RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ |
+			RING_F_MP_HTS_ENQ | RING_F_MC_HTS_DEQ))
+		return -EINVAL;
+
 	/* init the ring structure */
 	return rte_ring_init(&r->r, name, count, flags);
 }
@@ -96,7 +101,7 @@ rte_event_ring_create(const char *name, unsigned int count, int socket_id,
 		te->data = (void *) r;
 		r->r.memzone = mz;
 
-		TAILQ_INSERT_TAIL(ring_list, te, next);
+		RTE_TAILQ_INSERT_TAIL(ring_list, te, next);
 	} else {
 		r = NULL;
 		RTE_LOG(ERR, RING, "Cannot reserve memory\n");
@@ -120,7 +125,7 @@ rte_event_ring_lookup(const char *name)
 
 	rte_mcfg_tailq_read_lock();
 
-	TAILQ_FOREACH(te, ring_list, next) {
+	RTE_TAILQ_FOREACH(te, ring_list, next) {
 		r = (struct rte_event_ring *) te->data;
 		if (strncmp(name, r->r.name, RTE_RING_NAMESIZE) == 0)
 			break;
@@ -166,7 +171,7 @@ rte_event_ring_free(struct rte_event_ring *r)
 	rte_mcfg_tailq_write_lock();
 
 	/* find out tailq entry */
-	TAILQ_FOREACH(te, ring_list, next) {
+	RTE_TAILQ_FOREACH(te, ring_list, next) {
 		if (te->data == (void *) r)
 			break;
 	}
@@ -176,7 +181,7 @@ rte_event_ring_free(struct rte_event_ring *r)
 		return;
 	}
 
-	TAILQ_REMOVE(ring_list, te, next);
+	RTE_TAILQ_REMOVE(ring_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
@@ -91,7 +91,8 @@ rte_event_ring_enqueue_burst(struct rte_event_ring *r,
 	uint32_t prod_head, prod_next;
 	uint32_t free_entries;
 
-	n = __rte_ring_move_prod_head(&r->r, r->r.prod.single, n,
+	n = __rte_ring_move_prod_head(&r->r, rte_ring_is_prod_single(&r->r),
+			n,
 			RTE_RING_QUEUE_VARIABLE,
 			&prod_head, &prod_next, &free_entries);
 	if (n == 0)
@@ -99,7 +100,8 @@ rte_event_ring_enqueue_burst(struct rte_event_ring *r,
 
 	ENQUEUE_PTRS(&r->r, &r[1], prod_head, events, n, struct rte_event);
 
-	update_tail(&r->r.prod, prod_head, prod_next, r->r.prod.single, 1);
+	update_tail(&r->r.prod, prod_head, prod_next,
+			rte_ring_is_prod_single(&r->r), 1);
 end:
 	if (free_space != NULL)
 		*free_space = free_entries - n;
@@ -132,7 +134,8 @@ rte_event_ring_dequeue_burst(struct rte_event_ring *r,
 	uint32_t cons_head, cons_next;
 	uint32_t entries;
 
-	n = __rte_ring_move_cons_head(&r->r, r->r.cons.single, n,
+	n = __rte_ring_move_cons_head(&r->r, rte_ring_is_cons_single(&r->r),
+			n,
 			RTE_RING_QUEUE_VARIABLE,
 			&cons_head, &cons_next, &entries);
 	if (n == 0)
@@ -140,7 +143,8 @@ rte_event_ring_dequeue_burst(struct rte_event_ring *r,
 
 	DEQUEUE_PTRS(&r->r, &r[1], cons_head, events, n, struct rte_event);
 
-	update_tail(&r->r.cons, cons_head, cons_next, r->r.cons.single, 0);
+	update_tail(&r->r.cons, cons_head, cons_next,
+			rte_ring_is_cons_single(&r->r), 0);
 
 end:
 	if (available != NULL)
@@ -173,6 +177,7 @@ end:
  *      be taken as the exact usable size of the ring, and as such does not
  *      need to be a power of 2. The underlying ring memory should be a
  *      power-of-2 size greater than the count value.
+ *   The RTS and HTS sync modes aren't supported by event rings.
  * @return
  *   0 on success, or a negative value on error.
  */
@@ -210,6 +215,7 @@ rte_event_ring_init(struct rte_event_ring *r, const char *name,
  *      be taken as the exact usable size of the ring, and as such does not
  *      need to be a power of 2. The underlying ring memory should be a
  *      power-of-2 size greater than the count value.
+ *   The RTS and HTS sync modes aren't supported by event rings.
  * @return
  *   On success, the pointer to the new allocated ring. NULL on error with
  *    rte_errno set appropriately. Possible errno values include:
@@ -0,0 +1,546 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_atomic.h>
+#include <rte_debug.h>
+#include <rte_malloc.h>
+#include <rte_errno.h>
+#include <rte_memory.h>
+#include <rte_cpuflags.h>
+
+#include <rte_rib.h>
+#include <rte_fib.h>
+#include "dir24_8.h"
+
+#ifdef CC_DIR24_8_AVX2_SUPPORT
+#include "dir24_8_avx2.h"
+#endif
+#ifdef CC_DIR24_8_AVX512_SUPPORT
+#include "dir24_8_avx512.h"
+#endif
+
+#define DIR24_8_NAMESIZE	64
+
+static inline rte_fib_lookup_fn_t
+get_scalar_fn(enum rte_fib_dir24_8_nh_sz nh_sz)
+{
+	switch (nh_sz) {
+	case RTE_FIB_DIR24_8_1B:
+		return dir24_8_lookup_bulk_1b;
+	case RTE_FIB_DIR24_8_2B:
+		return dir24_8_lookup_bulk_2b;
+	case RTE_FIB_DIR24_8_4B:
+		return dir24_8_lookup_bulk_4b;
+	case RTE_FIB_DIR24_8_8B:
+		return dir24_8_lookup_bulk_8b;
+	default:
+		return NULL;
+	}
+}
+
+static inline rte_fib_lookup_fn_t
+get_vector_avx2_fn(struct dir24_8_tbl *dp)
+{
+#ifdef CC_DIR24_8_AVX2_SUPPORT
+	if ((rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2) <= 0) ||
+			(dp->number_tbl8s >= DIR24_8_VEC_MAX_TBL8))
+		return NULL;
+
+	switch (dp->nh_sz) {
+	case RTE_FIB_DIR24_8_1B:
+		return dir24_8_avx2_lookup_bulk_1b;
+	case RTE_FIB_DIR24_8_2B:
+		return dir24_8_avx2_lookup_bulk_2b;
+	case RTE_FIB_DIR24_8_4B:
+		return dir24_8_avx2_lookup_bulk_4b;
+	case RTE_FIB_DIR24_8_8B:
+		return dir24_8_avx2_lookup_bulk_8b;
+	default:
+		return NULL;
+	}
+#else
+	RTE_SET_USED(dp);
+	return NULL;
+#endif
+}
+
+static inline rte_fib_lookup_fn_t
+get_vector_avx512_fn(struct dir24_8_tbl *dp)
+{
+#ifdef CC_DIR24_8_AVX512_SUPPORT
+	if ((rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) <= 0) ||
+			(dp->number_tbl8s >= DIR24_8_VEC_MAX_TBL8))
+		return NULL;
+
+	switch (dp->nh_sz) {
+	case RTE_FIB_DIR24_8_1B:
+		return dir24_8_avx512_lookup_bulk_1b;
+	case RTE_FIB_DIR24_8_2B:
+		return dir24_8_avx512_lookup_bulk_2b;
+	case RTE_FIB_DIR24_8_4B:
+		return dir24_8_avx512_lookup_bulk_4b;
+	case RTE_FIB_DIR24_8_8B:
+		return dir24_8_avx512_lookup_bulk_8b;
+	default:
+		return NULL;
+	}
+#else
+	RTE_SET_USED(dp);
+	return NULL;
+#endif
+}
+
+rte_fib_lookup_fn_t
+dir24_8_get_lookup_fn(void *p, enum rte_fib_lookup_type type)
+{
+	struct dir24_8_tbl *dp = p;
+	rte_fib_lookup_fn_t ret_fn;
+
+	if (dp == NULL)
+		return NULL;
+
+	switch (type) {
+	case RTE_FIB_LOOKUP_DIR24_8_SCALAR:
+		return get_scalar_fn(dp->nh_sz);
+	case RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX2:
+		return get_vector_avx2_fn(dp);
+	case RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512:
+		return get_vector_avx512_fn(dp);
+	case RTE_FIB_LOOKUP_DEFAULT:
+		ret_fn = get_vector_avx512_fn(dp);
+		if (ret_fn == NULL)
+			ret_fn = get_vector_avx2_fn(dp);
+		if (ret_fn == NULL)
+			ret_fn = get_scalar_fn(dp->nh_sz);
+		return ret_fn;
+	default:
+		return NULL;
+	}
+}
+
+static void
+write_to_fib(void *ptr, uint64_t val, enum rte_fib_dir24_8_nh_sz size, int n)
+{
+	int i;
+	uint8_t *ptr8 = (uint8_t *)ptr;
+	uint16_t *ptr16 = (uint16_t *)ptr;
+	uint32_t *ptr32 = (uint32_t *)ptr;
+	uint64_t *ptr64 = (uint64_t *)ptr;
+
+	switch (size) {
+	case RTE_FIB_DIR24_8_1B:
+		for (i = 0; i < n; i++)
+			ptr8[i] = (uint8_t)val;
+		break;
+	case RTE_FIB_DIR24_8_2B:
+		for (i = 0; i < n; i++)
+			ptr16[i] = (uint16_t)val;
+		break;
+	case RTE_FIB_DIR24_8_4B:
+		for (i = 0; i < n; i++)
+			ptr32[i] = (uint32_t)val;
+		break;
+	case RTE_FIB_DIR24_8_8B:
+		for (i = 0; i < n; i++)
+			ptr64[i] = (uint64_t)val;
+		break;
+	}
+}
+
+static uint64_t
+read_from_fib(const void *ptr, enum rte_fib_dir24_8_nh_sz size, uint32_t idx)
+{
+	switch (size) {
+	case RTE_FIB_DIR24_8_1B:
+		return ((const uint8_t *)ptr)[idx];
+	case RTE_FIB_DIR24_8_2B:
+		return ((const uint16_t *)ptr)[idx];
+	case RTE_FIB_DIR24_8_4B:
+		return ((const uint32_t *)ptr)[idx];
+	case RTE_FIB_DIR24_8_8B:
+		return ((const uint64_t *)ptr)[idx];
+	}
+	return 0;
+}
+
+static int
+tbl8_get_idx(struct dir24_8_tbl *dp)
+{
+	uint32_t i;
+	int bit_idx;
+
+	for (i = 0; (i < (dp->number_tbl8s >> BITMAP_SLAB_BIT_SIZE_LOG2)) &&
+			(dp->tbl8_idxes[i] == UINT64_MAX); i++)
+		;
+	if (i < (dp->number_tbl8s >> BITMAP_SLAB_BIT_SIZE_LOG2)) {
+		bit_idx = __builtin_ctzll(~dp->tbl8_idxes[i]);
+		dp->tbl8_idxes[i] |= (1ULL << bit_idx);
+		return (i << BITMAP_SLAB_BIT_SIZE_LOG2) + bit_idx;
+	}
+	return -ENOSPC;
+}
+
+static inline void
+tbl8_free_idx(struct dir24_8_tbl *dp, int idx)
+{
+	dp->tbl8_idxes[idx >> BITMAP_SLAB_BIT_SIZE_LOG2] &=
+		~(1ULL << (idx & BITMAP_SLAB_BITMASK));
+	dp->cur_tbl8s--;
+}
+
+static int
+tbl8_alloc(struct dir24_8_tbl *dp, uint64_t nh)
+{
+	int64_t	tbl8_idx;
+	uint8_t	*tbl8_ptr;
+
+	tbl8_idx = tbl8_get_idx(dp);
+	if (tbl8_idx < 0)
+		return tbl8_idx;
+	tbl8_ptr = (uint8_t *)dp->tbl8 +
+		((tbl8_idx * DIR24_8_TBL8_GRP_NUM_ENT) <<
+		dp->nh_sz);
+	/*Init tbl8 entries with nexthop from tbl24*/
+	write_to_fib((void *)tbl8_ptr, nh, dp->nh_sz,
+		DIR24_8_TBL8_GRP_NUM_ENT);
+	dp->cur_tbl8s++;
+	return tbl8_idx;
+}
+
+/*
+ * Collapse a tbl8 group back into its tbl24 entry
+ * once all of its entries hold the same next hop.
+ */
+static void
+tbl8_recycle(struct dir24_8_tbl *dp, uint32_t ip, uint64_t tbl8_idx)
+{
+	uint32_t i;
+	uint64_t nh;
+	uint8_t *tbl8_ptr;
+
+	tbl8_ptr = (uint8_t *)dp->tbl8 +
+		((tbl8_idx * DIR24_8_TBL8_GRP_NUM_ENT) << dp->nh_sz);
+	nh = read_from_fib(tbl8_ptr, dp->nh_sz, 0);
+	for (i = 1; i < DIR24_8_TBL8_GRP_NUM_ENT; i++) {
+		if (nh != read_from_fib(tbl8_ptr, dp->nh_sz, i))
+			return;
+	}
+	write_to_fib(get_tbl24_p(dp, ip, dp->nh_sz), nh, dp->nh_sz, 1);
+	tbl8_free_idx(dp, tbl8_idx);
+}
+
+/*
+ * Write next_hop into n consecutive tbl8 entries starting from ip.
+ * The range must not cross a /24 boundary.
+ */
+static int
+install_to_tbl8(struct dir24_8_tbl *dp, uint32_t ip, uint32_t n,
+	uint64_t next_hop)
+{
+	uint64_t tbl24_tmp;
+	int64_t tbl8_idx;
+	uint8_t *tbl8_ptr;
+
+	tbl24_tmp = get_tbl24(dp, ip, dp->nh_sz);
+	if (!is_entry_extended(tbl24_tmp)) {
+		tbl8_idx = tbl8_alloc(dp, tbl24_tmp);
+		if (tbl8_idx < 0)
+			return tbl8_idx;
+		/* make the new tbl8 visible before linking it into tbl24 */
+		rte_smp_wmb();
+		/*update dir24 entry with tbl8 index*/
+		write_to_fib(get_tbl24_p(dp, ip, dp->nh_sz),
+			(tbl8_idx << 1) | DIR24_8_EXT_ENT, dp->nh_sz, 1);
+	} else
+		tbl8_idx = tbl24_tmp >> 1;
+
+	tbl8_ptr = (uint8_t *)dp->tbl8 +
+		(((tbl8_idx * DIR24_8_TBL8_GRP_NUM_ENT) +
+		(ip & ~DIR24_8_TBL24_MASK)) << dp->nh_sz);
+	/*update tbl8 with new next hop*/
+	write_to_fib((void *)tbl8_ptr, next_hop << 1, dp->nh_sz, n);
+	tbl8_recycle(dp, ip, tbl8_idx);
+
+	return 0;
+}
+
+/*
+ * Write next_hop into n consecutive tbl24 entries starting from idx,
+ * releasing tbl8 groups that become unreachable.
+ */
+static void
+install_to_tbl24(struct dir24_8_tbl *dp, uint32_t idx, uint32_t n,
+	uint64_t next_hop)
+{
+	uint64_t tbl24_tmp;
+	uint32_t i;
+
+	for (i = idx; i < idx + n; i++) {
+		tbl24_tmp = read_from_fib(dp->tbl24, dp->nh_sz, i);
+		if (is_entry_extended(tbl24_tmp)) {
+			write_to_fib(get_tbl24_p(dp, i << 8, dp->nh_sz),
+				next_hop << 1, dp->nh_sz, 1);
+			tbl8_free_idx(dp, tbl24_tmp >> 1);
+		}
+	}
+	write_to_fib(get_tbl24_p(dp, idx << 8, dp->nh_sz), next_hop << 1,
+		dp->nh_sz, n);
+}
+
+/*
+ * Install next_hop for the [ledge, redge) address range.
+ * Edges are 64 bit wide so that the end of the address space
+ * can be represented.
+ */
+static int
+install_to_fib(struct dir24_8_tbl *dp, uint64_t ledge, uint64_t redge,
+	uint64_t next_hop)
+{
+	uint64_t first24, last24;
+	int ret;
+
+	first24 = RTE_ALIGN_CEIL(ledge, (uint64_t)DIR24_8_TBL8_GRP_NUM_ENT);
+	last24 = RTE_ALIGN_FLOOR(redge, (uint64_t)DIR24_8_TBL8_GRP_NUM_ENT);
+
+	/* whole range is inside a single /24 */
+	if (first24 > last24)
+		return install_to_tbl8(dp, ledge, redge - ledge, next_hop);
+
+	if (ledge != first24) {
+		ret = install_to_tbl8(dp, ledge, first24 - ledge, next_hop);
+		if (ret != 0)
+			return ret;
+	}
+	if (last24 != first24)
+		install_to_tbl24(dp, first24 >> 8, (last24 - first24) >> 8,
+			next_hop);
+	if (redge != last24)
+		return install_to_tbl8(dp, last24, redge - last24, next_hop);
+
+	return 0;
+}
+
+/*
+ * Install next_hop for ip/depth leaving the address ranges
+ * of the more specific routes untouched.
+ */
+static int
+modify_fib(struct dir24_8_tbl *dp, struct rte_rib *rib, uint32_t ip,
+	uint8_t depth, uint64_t next_hop)
+{
+	struct rte_rib_node *tmp = NULL;
+	uint64_t ledge, redge;
+	uint32_t tmp_ip;
+	uint8_t tmp_depth = 0;
+	int ret;
+
+	ledge = ip;
+	do {
+		tmp = rte_rib_get_nxt(rib, ip, depth, tmp,
+			RTE_RIB_GET_NXT_COVER);
+		if (tmp != NULL) {
+			rte_rib_get_depth(tmp, &tmp_depth);
+			rte_rib_get_ip(tmp, &tmp_ip);
+			redge = tmp_ip;
+		} else
+			redge = (uint64_t)ip + (1ULL << (32 - depth));
+
+		if (ledge != redge) {
+			ret = install_to_fib(dp, ledge, redge, next_hop);
+			if (ret != 0)
+				return ret;
+		}
+		if (tmp != NULL)
+			ledge = redge + (1ULL << (32 - tmp_depth));
+	} while (tmp != NULL);
+
+	return 0;
+}
+
+int
+dir24_8_modify(struct rte_fib *fib, uint32_t ip, uint8_t depth,
+	uint64_t next_hop, int op)
+{
+	struct dir24_8_tbl *dp;
+	struct rte_rib *rib;
+	struct rte_rib_node *tmp = NULL;
+	struct rte_rib_node *node;
+	struct rte_rib_node *parent;
+	int ret = 0;
+	uint64_t par_nh, node_nh;
+
+	if ((fib == NULL) || (depth > RTE_FIB_MAXDEPTH))
+		return -EINVAL;
+
+	dp = rte_fib_get_dp(fib);
+	rib = rte_fib_get_rib(fib);
+	RTE_ASSERT((dp != NULL) && (rib != NULL));
+
+	if (next_hop > get_max_nh(dp->nh_sz))
+		return -EINVAL;
+
+	ip &= rte_rib_depth_to_mask(depth);
+
+	node = rte_rib_lookup_exact(rib, ip, depth);
+	switch (op) {
+	case RTE_FIB_ADD:
+		if (node != NULL) {
+			rte_rib_get_nh(node, &node_nh);
+			if (node_nh == next_hop)
+				return 0;
+			ret = modify_fib(dp, rib, ip, depth, next_hop);
+			if (ret == 0)
+				rte_rib_set_nh(node, next_hop);
+			return ret;
+		}
+		/*
+		 * Every /24 that holds a route longer than 24 needs
+		 * a tbl8 group, reserve it up front so that the dataplane
+		 * update below can not run out of groups half way.
+		 */
+		if (depth > 24) {
+			tmp = rte_rib_get_nxt(rib, ip, 24, NULL,
+				RTE_RIB_GET_NXT_COVER);
+			if ((tmp == NULL) &&
+					(dp->rsvd_tbl8s >= dp->number_tbl8s))
+				return -ENOSPC;
+		}
+		node = rte_rib_insert(rib, ip, depth);
+		if (node == NULL)
+			return -rte_errno;
+		rte_rib_set_nh(node, next_hop);
+		if ((depth > 24) && (tmp == NULL))
+			dp->rsvd_tbl8s++;
+
+		parent = rte_rib_lookup_parent(node);
+		if (parent != NULL)
+			rte_rib_get_nh(parent, &par_nh);
+		else
+			par_nh = dp->def_nh;
+		if (par_nh == next_hop)
+			return 0;
+
+		ret = modify_fib(dp, rib, ip, depth, next_hop);
+		if (ret != 0) {
+			rte_rib_remove(rib, ip, depth);
+			if ((depth > 24) && (tmp == NULL))
+				dp->rsvd_tbl8s--;
+		}
+		return ret;
+	case RTE_FIB_DEL:
+		if (node == NULL)
+			return -ENOENT;
+
+		parent = rte_rib_lookup_parent(node);
+		if (parent != NULL)
+			rte_rib_get_nh(parent, &par_nh);
+		else
+			par_nh = dp->def_nh;
+		rte_rib_get_nh(node, &node_nh);
+		if (par_nh != node_nh)
+			ret = modify_fib(dp, rib, ip, depth, par_nh);
+		if (ret == 0) {
+			rte_rib_remove(rib, ip, depth);
+			if (depth > 24) {
+				tmp = rte_rib_get_nxt(rib, ip, 24, NULL,
+					RTE_RIB_GET_NXT_COVER);
+				if (tmp == NULL)
+					dp->rsvd_tbl8s--;
+			}
+		}
+		return ret;
+	default:
+		break;
+	}
+	return -EINVAL;
+}
+
+void *
+dir24_8_create(const char *name, int socket_id, struct rte_fib_conf *fib_conf)
+{
+	char mem_name[DIR24_8_NAMESIZE];
+	struct dir24_8_tbl *dp;
+	uint64_t	def_nh;
+	uint64_t	tbl8_sz;
+	uint32_t	num_tbl8;
+	enum rte_fib_dir24_8_nh_sz	nh_sz;
+
+	if ((name == NULL) || (fib_conf == NULL) ||
+			(fib_conf->dir24_8.nh_sz < RTE_FIB_DIR24_8_1B) ||
+			(fib_conf->dir24_8.nh_sz > RTE_FIB_DIR24_8_8B) ||
+			(fib_conf->dir24_8.num_tbl8 >
+			get_max_nh(fib_conf->dir24_8.nh_sz)) ||
+			(fib_conf->dir24_8.num_tbl8 == 0) ||
+			(fib_conf->default_nh >
+			get_max_nh(fib_conf->dir24_8.nh_sz))) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	def_nh = fib_conf->default_nh;
+	nh_sz = fib_conf->dir24_8.nh_sz;
+	num_tbl8 = RTE_ALIGN_CEIL(fib_conf->dir24_8.num_tbl8,
+			BITMAP_SLAB_BIT_SIZE);
+
+	/*
+	 * Reserve an extra 32-bit word after tbl24 and an extra tbl8 group
+	 * so that the vector lookups may gather 4 bytes at the last entry.
+	 */
+	snprintf(mem_name, sizeof(mem_name), "DP_%s", name);
+	dp = rte_zmalloc_socket(mem_name, sizeof(struct dir24_8_tbl) +
+		DIR24_8_TBL24_NUM_ENT * (1 << nh_sz) + sizeof(uint32_t),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	/* Init table with default value */
+	write_to_fib(dp->tbl24, (def_nh << 1), nh_sz, 1 << 24);
+
+	snprintf(mem_name, sizeof(mem_name), "TBL8_%p", dp);
+	tbl8_sz = DIR24_8_TBL8_GRP_NUM_ENT * (1ULL << nh_sz) *
+			(num_tbl8 + 1);
+	dp->tbl8 = rte_zmalloc_socket(mem_name, tbl8_sz,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp->tbl8 == NULL) {
+		rte_errno = ENOMEM;
+		rte_free(dp);
+		return NULL;
+	}
+	dp->def_nh = def_nh;
+	dp->nh_sz = nh_sz;
+	dp->number_tbl8s = num_tbl8;
+
+	snprintf(mem_name, sizeof(mem_name), "TBL8_idxes_%p", dp);
+	dp->tbl8_idxes = rte_zmalloc_socket(mem_name,
+			RTE_ALIGN_CEIL(dp->number_tbl8s, 64) >> 3,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp->tbl8_idxes == NULL) {
+		rte_errno = ENOMEM;
+		rte_free(dp->tbl8);
+		rte_free(dp);
+		return NULL;
+	}
+
+	return dp;
+}
+
+void
+dir24_8_free(void *p)
+{
+	struct dir24_8_tbl *dp = (struct dir24_8_tbl *)p;
+
+	if (dp == NULL)
+		return;
+
+	rte_free(dp->tbl8_idxes);
+	rte_free(dp->tbl8);
+	rte_free(dp);
+}
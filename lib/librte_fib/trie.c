@@ -0,0 +1,468 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_atomic.h>
+#include <rte_debug.h>
+#include <rte_malloc.h>
+#include <rte_errno.h>
+#include <rte_memory.h>
+#include <rte_cpuflags.h>
+
+#include <rte_rib6.h>
+#include <rte_fib6.h>
+#include "trie.h"
+
+#ifdef CC_TRIE_AVX512_SUPPORT
+#include "trie_avx512.h"
+#endif
+
+#define TRIE_NAMESIZE		64
+
+static inline rte_fib6_lookup_fn_t
+get_scalar_fn(enum rte_fib6_trie_nh_sz nh_sz)
+{
+	switch (nh_sz) {
+	case RTE_FIB6_TRIE_2B:
+		return rte_trie_lookup_bulk_2b;
+	case RTE_FIB6_TRIE_4B:
+		return rte_trie_lookup_bulk_4b;
+	case RTE_FIB6_TRIE_8B:
+		return rte_trie_lookup_bulk_8b;
+	default:
+		return NULL;
+	}
+}
+
+static inline rte_fib6_lookup_fn_t
+get_vector_fn(struct rte_trie_tbl *dp)
+{
+#ifdef CC_TRIE_AVX512_SUPPORT
+	if ((rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) <= 0) ||
+			((dp->nh_sz != RTE_FIB6_TRIE_8B) &&
+			(dp->number_tbl8s >= TRIE_VEC_MAX_TBL8)))
+		return NULL;
+
+	switch (dp->nh_sz) {
+	case RTE_FIB6_TRIE_2B:
+		return trie_avx512_lookup_bulk_2b;
+	case RTE_FIB6_TRIE_4B:
+		return trie_avx512_lookup_bulk_4b;
+	case RTE_FIB6_TRIE_8B:
+		return trie_avx512_lookup_bulk_8b;
+	default:
+		return NULL;
+	}
+#else
+	RTE_SET_USED(dp);
+	return NULL;
+#endif
+}
+
+rte_fib6_lookup_fn_t
+trie_get_lookup_fn(void *p, enum rte_fib6_lookup_type type)
+{
+	struct rte_trie_tbl *dp = p;
+	rte_fib6_lookup_fn_t ret_fn;
+
+	if (dp == NULL)
+		return NULL;
+
+	switch (type) {
+	case RTE_FIB6_LOOKUP_TRIE_SCALAR:
+		return get_scalar_fn(dp->nh_sz);
+	case RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512:
+		return get_vector_fn(dp);
+	case RTE_FIB6_LOOKUP_DEFAULT:
+		ret_fn = get_vector_fn(dp);
+		if (ret_fn == NULL)
+			ret_fn = get_scalar_fn(dp->nh_sz);
+		return ret_fn;
+	default:
+		return NULL;
+	}
+}
+
+static void
+write_to_dp(void *ptr, uint64_t val, enum rte_fib6_trie_nh_sz size, int n)
+{
+	int i;
+	uint16_t *ptr16 = (uint16_t *)ptr;
+	uint32_t *ptr32 = (uint32_t *)ptr;
+	uint64_t *ptr64 = (uint64_t *)ptr;
+
+	switch (size) {
+	case RTE_FIB6_TRIE_2B:
+		for (i = 0; i < n; i++)
+			ptr16[i] = (uint16_t)val;
+		break;
+	case RTE_FIB6_TRIE_4B:
+		for (i = 0; i < n; i++)
+			ptr32[i] = (uint32_t)val;
+		break;
+	case RTE_FIB6_TRIE_8B:
+		for (i = 0; i < n; i++)
+			ptr64[i] = (uint64_t)val;
+		break;
+	}
+}
+
+static uint64_t
+read_from_dp(const void *ptr, enum rte_fib6_trie_nh_sz size, uint32_t idx)
+{
+	switch (size) {
+	case RTE_FIB6_TRIE_2B:
+		return ((const uint16_t *)ptr)[idx];
+	case RTE_FIB6_TRIE_4B:
+		return ((const uint32_t *)ptr)[idx];
+	case RTE_FIB6_TRIE_8B:
+		return ((const uint64_t *)ptr)[idx];
+	}
+	return 0;
+}
+
+static inline void *
+get_tbl8_p(struct rte_trie_tbl *dp, uint32_t tbl8_idx, uint8_t byte)
+{
+	return (uint8_t *)dp->tbl8 +
+		((tbl8_idx * TRIE_TBL8_GRP_NUM_ENT + byte) << dp->nh_sz);
+}
+
+static int32_t
+tbl8_alloc(struct rte_trie_tbl *dp, uint64_t nh)
+{
+	uint32_t tbl8_idx;
+
+	if (dp->tbl8_pool_pos == dp->number_tbl8s)
+		return -ENOSPC;
+
+	tbl8_idx = dp->tbl8_pool[dp->tbl8_pool_pos++];
+	/* Init tbl8 entries with the value of the parent entry */
+	write_to_dp(get_tbl8_p(dp, tbl8_idx, 0), nh, dp->nh_sz,
+		TRIE_TBL8_GRP_NUM_ENT);
+	return tbl8_idx;
+}
+
+static void
+tbl8_free(struct rte_trie_tbl *dp, uint32_t tbl8_idx)
+{
+	uint64_t val;
+	uint32_t i;
+
+	/* release the groups below this one first */
+	for (i = 0; i < TRIE_TBL8_GRP_NUM_ENT; i++) {
+		val = read_from_dp(get_tbl8_p(dp, tbl8_idx, 0), dp->nh_sz, i);
+		if (is_entry_extended(val))
+			tbl8_free(dp, val >> 1);
+	}
+	dp->tbl8_pool[--dp->tbl8_pool_pos] = tbl8_idx;
+}
+
+/*
+ * Check whether all entries of a tbl8 group hold the same value,
+ * in which case the group may be collapsed into its parent entry.
+ */
+static int
+tbl8_is_uniform(struct rte_trie_tbl *dp, uint32_t tbl8_idx, uint64_t *val)
+{
+	void *ptr = get_tbl8_p(dp, tbl8_idx, 0);
+	uint32_t i;
+
+	*val = read_from_dp(ptr, dp->nh_sz, 0);
+	for (i = 1; i < TRIE_TBL8_GRP_NUM_ENT; i++) {
+		if (*val != read_from_dp(ptr, dp->nh_sz, i))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Write next_hop over the whole ip/depth block, dropping whatever
+ * lies below it. The levels down to the one holding the block are
+ * expanded as needed and collapsed back afterwards if they became
+ * uniform.
+ */
+static int
+write_block(struct rte_trie_tbl *dp, const uint8_t *ip, uint8_t depth,
+	uint64_t next_hop)
+{
+	void *ent[TRIE_MAX_LEVELS];
+	uint32_t grp[TRIE_MAX_LEVELS];
+	uint64_t val, tmp;
+	int32_t tbl8_idx;
+	uint32_t i, n;
+	int lvl, last_lvl;
+
+	last_lvl = (depth <= 24) ? 0 : (depth - 24 + 7) / 8;
+
+	ent[0] = get_tbl24_p(dp, ip, dp->nh_sz);
+	for (lvl = 0; lvl < last_lvl; lvl++) {
+		tmp = read_from_dp(ent[lvl], dp->nh_sz, 0);
+		if (!is_entry_extended(tmp)) {
+			tbl8_idx = tbl8_alloc(dp, tmp);
+			if (tbl8_idx < 0)
+				return tbl8_idx;
+			/* make the new tbl8 visible before linking it */
+			rte_smp_wmb();
+			write_to_dp(ent[lvl], ((uint64_t)tbl8_idx << 1) |
+				TRIE_EXT_ENT, dp->nh_sz, 1);
+		} else
+			tbl8_idx = tmp >> 1;
+		grp[lvl + 1] = tbl8_idx;
+		ent[lvl + 1] = get_tbl8_p(dp, tbl8_idx, ip[lvl + 3]);
+	}
+
+	val = next_hop << 1;
+	n = 1U << (24 + 8 * last_lvl - depth);
+	for (i = 0; i < n; i++) {
+		tmp = read_from_dp(ent[last_lvl], dp->nh_sz, i);
+		if (is_entry_extended(tmp)) {
+			write_to_dp((uint8_t *)ent[last_lvl] +
+				(i << dp->nh_sz), val, dp->nh_sz, 1);
+			tbl8_free(dp, tmp >> 1);
+		}
+	}
+	write_to_dp(ent[last_lvl], val, dp->nh_sz, n);
+
+	for (lvl = last_lvl; lvl > 0; lvl--) {
+		if (!tbl8_is_uniform(dp, grp[lvl], &tmp))
+			break;
+		write_to_dp(ent[lvl - 1], tmp, dp->nh_sz, 1);
+		dp->tbl8_pool[--dp->tbl8_pool_pos] = grp[lvl];
+	}
+
+	return 0;
+}
+
+/*
+ * Install next_hop for the ip/depth block leaving the address ranges
+ * of the more specific routes untouched. Blocks containing more
+ * specific routes are split in halves until they are either free of
+ * them or are a route on their own. ip must be masked to depth.
+ */
+static int
+install_to_dp(struct rte_trie_tbl *dp, struct rte_rib6 *rib, uint8_t *ip,
+	uint8_t depth, uint8_t orig_depth, uint64_t next_hop)
+{
+	uint8_t byte, bit;
+	int ret;
+
+	if ((depth > orig_depth) &&
+			(rte_rib6_lookup_exact(rib, ip, depth) != NULL))
+		return 0;
+
+	if (rte_rib6_get_nxt(rib, ip, depth, NULL,
+			RTE_RIB6_GET_NXT_COVER) == NULL)
+		return write_block(dp, ip, depth, next_hop);
+
+	byte = depth / 8;
+	bit = 1 << (7 - depth % 8);
+	ret = install_to_dp(dp, rib, ip, depth + 1, orig_depth, next_hop);
+	if (ret != 0)
+		return ret;
+	ip[byte] |= bit;
+	ret = install_to_dp(dp, rib, ip, depth + 1, orig_depth, next_hop);
+	ip[byte] &= ~bit;
+
+	return ret;
+}
+
+/*
+ * Number of tbl8 groups the dataplane needs for ip/depth in addition
+ * to the groups already needed by the other routes: one for every
+ * 8 bit level boundary above depth that no other route crosses yet.
+ */
+static uint32_t
+count_tbl8s(struct rte_rib6 *rib, const uint8_t *ip, uint8_t depth)
+{
+	uint32_t cnt = 0;
+	int b;
+
+	for (b = 24; b < depth; b += 8) {
+		if (rte_rib6_get_nxt(rib, ip, b, NULL,
+				RTE_RIB6_GET_NXT_COVER) == NULL)
+			cnt++;
+	}
+	return cnt;
+}
+
+int
+trie_modify(struct rte_fib6 *fib, const uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE],
+	uint8_t depth, uint64_t next_hop, int op)
+{
+	struct rte_trie_tbl *dp;
+	struct rte_rib6 *rib;
+	struct rte_rib6_node *node;
+	struct rte_rib6_node *parent;
+	uint8_t ip_masked[RTE_FIB6_IPV6_ADDR_SIZE];
+	uint64_t par_nh, node_nh;
+	uint32_t new_tbl8s;
+	int i, ret = 0;
+
+	if ((fib == NULL) || (ip == NULL) || (depth > RTE_FIB6_MAXDEPTH))
+		return -EINVAL;
+
+	dp = rte_fib6_get_dp(fib);
+	rib = rte_fib6_get_rib(fib);
+	RTE_ASSERT((dp != NULL) && (rib != NULL));
+
+	if (next_hop > get_max_nh(dp->nh_sz))
+		return -EINVAL;
+
+	for (i = 0; i < RTE_FIB6_IPV6_ADDR_SIZE; i++)
+		ip_masked[i] = ip[i] & rte_rib6_get_msk_part(depth, i);
+
+	node = rte_rib6_lookup_exact(rib, ip_masked, depth);
+	switch (op) {
+	case RTE_FIB6_ADD:
+		if (node != NULL) {
+			rte_rib6_get_nh(node, &node_nh);
+			if (node_nh == next_hop)
+				return 0;
+			ret = install_to_dp(dp, rib, ip_masked, depth, depth,
+				next_hop);
+			if (ret == 0)
+				rte_rib6_set_nh(node, next_hop);
+			return ret;
+		}
+		/*
+		 * Reserve the tbl8 groups the new route may need up front
+		 * so that the dataplane update below can not run out
+		 * of groups half way.
+		 */
+		new_tbl8s = count_tbl8s(rib, ip_masked, depth);
+		if (dp->rsvd_tbl8s + new_tbl8s > dp->number_tbl8s)
+			return -ENOSPC;
+		node = rte_rib6_insert(rib, ip_masked, depth);
+		if (node == NULL)
+			return -rte_errno;
+		rte_rib6_set_nh(node, next_hop);
+		dp->rsvd_tbl8s += new_tbl8s;
+
+		parent = rte_rib6_lookup_parent(node);
+		if (parent != NULL)
+			rte_rib6_get_nh(parent, &par_nh);
+		else
+			par_nh = dp->def_nh;
+		if (par_nh == next_hop)
+			return 0;
+
+		ret = install_to_dp(dp, rib, ip_masked, depth, depth,
+			next_hop);
+		if (ret != 0) {
+			rte_rib6_remove(rib, ip_masked, depth);
+			dp->rsvd_tbl8s -= new_tbl8s;
+		}
+		return ret;
+	case RTE_FIB6_DEL:
+		if (node == NULL)
+			return -ENOENT;
+
+		parent = rte_rib6_lookup_parent(node);
+		if (parent != NULL)
+			rte_rib6_get_nh(parent, &par_nh);
+		else
+			par_nh = dp->def_nh;
+		rte_rib6_get_nh(node, &node_nh);
+		if (par_nh != node_nh)
+			ret = install_to_dp(dp, rib, ip_masked, depth, depth,
+				par_nh);
+		if (ret == 0) {
+			rte_rib6_remove(rib, ip_masked, depth);
+			dp->rsvd_tbl8s -= count_tbl8s(rib, ip_masked, depth);
+		}
+		return ret;
+	default:
+		break;
+	}
+	return -EINVAL;
+}
+
+void *
+trie_create(const char *name, int socket_id, struct rte_fib6_conf *conf)
+{
+	char mem_name[TRIE_NAMESIZE];
+	struct rte_trie_tbl *dp = NULL;
+	uint64_t def_nh;
+	uint32_t num_tbl8;
+	uint32_t i;
+	enum rte_fib6_trie_nh_sz nh_sz;
+
+	if ((name == NULL) || (conf == NULL) ||
+			(conf->trie.nh_sz < RTE_FIB6_TRIE_2B) ||
+			(conf->trie.nh_sz > RTE_FIB6_TRIE_8B) ||
+			(conf->trie.num_tbl8 >
+			get_max_nh(conf->trie.nh_sz)) ||
+			(conf->trie.num_tbl8 == 0) ||
+			(conf->default_nh >
+			get_max_nh(conf->trie.nh_sz))) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	def_nh = conf->default_nh;
+	nh_sz = conf->trie.nh_sz;
+	num_tbl8 = conf->trie.num_tbl8;
+
+	/*
+	 * Reserve an extra 32-bit word after tbl24 and an extra tbl8 group
+	 * so that the vector lookups may gather 4 bytes at the last entry.
+	 */
+	snprintf(mem_name, sizeof(mem_name), "DP_%s", name);
+	dp = rte_zmalloc_socket(mem_name, sizeof(struct rte_trie_tbl) +
+		TRIE_TBL24_NUM_ENT * (1 << nh_sz) + sizeof(uint32_t),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp == NULL) {
+		rte_errno = ENOMEM;
+		return dp;
+	}
+
+	write_to_dp(&dp->tbl24, (def_nh << 1), nh_sz, 1 << 24);
+
+	snprintf(mem_name, sizeof(mem_name), "TBL8_%p", dp);
+	dp->tbl8 = rte_zmalloc_socket(mem_name, TRIE_TBL8_GRP_NUM_ENT *
+			(1ll << nh_sz) * (num_tbl8 + 1),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp->tbl8 == NULL) {
+		rte_errno = ENOMEM;
+		rte_free(dp);
+		return NULL;
+	}
+	dp->def_nh = def_nh;
+	dp->nh_sz = nh_sz;
+	dp->number_tbl8s = num_tbl8;
+
+	snprintf(mem_name, sizeof(mem_name), "TBL8_idxes_%p", dp);
+	dp->tbl8_pool = rte_zmalloc_socket(mem_name,
+			sizeof(uint32_t) * dp->number_tbl8s,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp->tbl8_pool == NULL) {
+		rte_errno = ENOMEM;
+		rte_free(dp->tbl8);
+		rte_free(dp);
+		return NULL;
+	}
+
+	for (i = 0; i < dp->number_tbl8s; i++)
+		dp->tbl8_pool[i] = i;
+
+	return dp;
+}
+
+void
+trie_free(void *p)
+{
+	struct rte_trie_tbl *dp = (struct rte_trie_tbl *)p;
+
+	if (dp == NULL)
+		return;
+
+	rte_free(dp->tbl8_pool);
+	rte_free(dp->tbl8);
+	rte_free(dp);
+}
@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <rte_vect.h>
+#include <rte_fib6.h>
+
+#include "trie.h"
+#include "trie_avx512.h"
+
+static __rte_always_inline void
+trie_vec_lookup_x16(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, int size)
+{
+	struct rte_trie_tbl *dp = (struct rte_trie_tbl *)p;
+	const __m512i zero = _mm512_set1_epi32(0);
+	const __m512i lsb = _mm512_set1_epi32(1);
+	const __m512i lsbyte_msk = _mm512_set1_epi32(0xff);
+	const __m512i byte1_msk = _mm512_set1_epi32(0xff00);
+	const __m512i res_msk = _mm512_set1_epi32(UINT16_MAX);
+	/* offsets of the 16 addresses from ips */
+	const __m512i addr_off = _mm512_set_epi32(
+		15 * 16, 14 * 16, 13 * 16, 12 * 16,
+		11 * 16, 10 * 16, 9 * 16, 8 * 16,
+		7 * 16, 6 * 16, 5 * 16, 4 * 16,
+		3 * 16, 2 * 16, 1 * 16, 0);
+	__m512i first, idxes, res, bytes;
+	__mmask16 msk_ext;
+	int i;
+
+	/* first 4 bytes of every address, tbl24 index is the top 3 of them */
+	first = _mm512_i32gather_epi32(addr_off, (const void *)ips, 1);
+	idxes = _mm512_slli_epi32(_mm512_and_epi32(first, lsbyte_msk), 16);
+	idxes = _mm512_or_epi32(idxes, _mm512_and_epi32(first, byte1_msk));
+	idxes = _mm512_or_epi32(idxes,
+		_mm512_and_epi32(_mm512_srli_epi32(first, 16), lsbyte_msk));
+
+	/**
+	 * lookup in tbl24
+	 * Put it inside branch to make compiler happy with -O0
+	 */
+	if (size == sizeof(uint16_t)) {
+		res = _mm512_i32gather_epi32(idxes, (const int *)dp->tbl24, 2);
+		res = _mm512_and_epi32(res, res_msk);
+	} else
+		res = _mm512_i32gather_epi32(idxes, (const int *)dp->tbl24, 4);
+
+	msk_ext = _mm512_test_epi32_mask(res, lsb);
+
+	/* walk down tbl8 levels while some of the lanes are extended */
+	for (i = 3; (msk_ext != 0) && (i < RTE_FIB6_IPV6_ADDR_SIZE); i++) {
+		/*
+		 * Byte i is taken as the top byte of the 4 bytes ending
+		 * with it, so the gather never reads past the address.
+		 */
+		bytes = _mm512_mask_i32gather_epi32(zero, msk_ext,
+			_mm512_add_epi32(addr_off, _mm512_set1_epi32(i - 3)),
+			(const void *)ips, 1);
+		bytes = _mm512_srli_epi32(bytes, 24);
+		idxes = _mm512_srli_epi32(res, 1);
+		idxes = _mm512_slli_epi32(idxes, 8);
+		idxes = _mm512_maskz_add_epi32(msk_ext, idxes, bytes);
+		if (size == sizeof(uint16_t)) {
+			res = _mm512_mask_i32gather_epi32(res, msk_ext,
+				idxes, (const int *)dp->tbl8, 2);
+			res = _mm512_and_epi32(res, res_msk);
+		} else
+			res = _mm512_mask_i32gather_epi32(res, msk_ext,
+				idxes, (const int *)dp->tbl8, 4);
+		msk_ext = _mm512_test_epi32_mask(res, lsb);
+	}
+
+	res = _mm512_srli_epi32(res, 1);
+	_mm512_storeu_si512(next_hops,
+		_mm512_cvtepu32_epi64(_mm512_castsi512_si256(res)));
+	_mm512_storeu_si512(next_hops + 8,
+		_mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(res, 1)));
+}
+
+static __rte_always_inline void
+trie_vec_lookup_x8_8b(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops)
+{
+	struct rte_trie_tbl *dp = (struct rte_trie_tbl *)p;
+	const __m512i lsb = _mm512_set1_epi64(1);
+	const __m512i lsbyte_msk = _mm512_set1_epi64(0xff);
+	const __m512i byte1_msk = _mm512_set1_epi64(0xff00);
+	/* offsets of the 8 addresses from ips */
+	const __m512i addr_off = _mm512_set_epi64(7 * 16, 6 * 16, 5 * 16,
+		4 * 16, 3 * 16, 2 * 16, 1 * 16, 0);
+	__m512i addr_lo, addr_hi, idxes, res, bytes;
+	__mmask8 msk_ext;
+	int i;
+
+	/* both halves of every address */
+	addr_lo = _mm512_i64gather_epi64(addr_off, (const void *)ips, 1);
+	addr_hi = _mm512_i64gather_epi64(
+		_mm512_add_epi64(addr_off, _mm512_set1_epi64(8)),
+		(const void *)ips, 1);
+
+	idxes = _mm512_slli_epi64(_mm512_and_epi64(addr_lo, lsbyte_msk), 16);
+	idxes = _mm512_or_epi64(idxes, _mm512_and_epi64(addr_lo, byte1_msk));
+	idxes = _mm512_or_epi64(idxes,
+		_mm512_and_epi64(_mm512_srli_epi64(addr_lo, 16), lsbyte_msk));
+
+	/* lookup in tbl24 */
+	res = _mm512_i64gather_epi64(idxes, (const void *)dp->tbl24, 8);
+	msk_ext = _mm512_test_epi64_mask(res, lsb);
+
+	/* walk down tbl8 levels while some of the lanes are extended */
+	for (i = 3; (msk_ext != 0) && (i < RTE_FIB6_IPV6_ADDR_SIZE); i++) {
+		bytes = _mm512_srlv_epi64((i < 8) ? addr_lo : addr_hi,
+			_mm512_set1_epi64((i & 7) * 8));
+		bytes = _mm512_and_epi64(bytes, lsbyte_msk);
+		idxes = _mm512_srli_epi64(res, 1);
+		idxes = _mm512_slli_epi64(idxes, 8);
+		idxes = _mm512_maskz_add_epi64(msk_ext, idxes, bytes);
+		res = _mm512_mask_i64gather_epi64(res, msk_ext, idxes,
+			(const void *)dp->tbl8, 8);
+		msk_ext = _mm512_test_epi64_mask(res, lsb);
+	}
+
+	res = _mm512_srli_epi64(res, 1);
+	_mm512_storeu_si512(next_hops, res);
+}
+
+void
+trie_avx512_lookup_bulk_2b(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+
+	for (i = 0; i < (n / 16); i++)
+		trie_vec_lookup_x16(p, ips + i * 16, next_hops + i * 16,
+			sizeof(uint16_t));
+
+	rte_trie_lookup_bulk_2b(p, ips + i * 16, next_hops + i * 16,
+		n - i * 16);
+}
+
+void
+trie_avx512_lookup_bulk_4b(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+
+	for (i = 0; i < (n / 16); i++)
+		trie_vec_lookup_x16(p, ips + i * 16, next_hops + i * 16,
+			sizeof(uint32_t));
+
+	rte_trie_lookup_bulk_4b(p, ips + i * 16, next_hops + i * 16,
+		n - i * 16);
+}
+
+void
+trie_avx512_lookup_bulk_8b(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, const unsigned int n)
+{
+	uint32_t i;
+
+	for (i = 0; i < (n / 8); i++)
+		trie_vec_lookup_x8_8b(p, ips + i * 8, next_hops + i * 8);
+
+	rte_trie_lookup_bulk_8b(p, ips + i * 8, next_hops + i * 8, n - i * 8);
+}
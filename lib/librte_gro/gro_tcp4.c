@@ -16,7 +16,7 @@ gro_tcp4_tbl_create(uint16_t socket_id,
 {
 	struct gro_tcp4_tbl *tbl;
 	size_t size;
-	uint32_t entries_num, i;
+	uint32_t entries_num, bucket_num;
 
 	entries_num = max_flow_num * max_item_per_flow;
 	entries_num = RTE_MIN(entries_num, GRO_TCP4_TBL_MAX_ITEM_NUM);
@@ -41,6 +41,7 @@ gro_tcp4_tbl_create(uint16_t socket_id,
 		return NULL;
 	}
 	tbl->max_item_num = entries_num;
+	tbl->free_item_idx = INVALID_ARRAY_INDEX;
 
 	size = sizeof(struct gro_tcp4_flow) * entries_num;
 	tbl->flows = rte_zmalloc_socket(__func__,
@@ -52,11 +53,24 @@ gro_tcp4_tbl_create(uint16_t socket_id,
 		rte_free(tbl);
 		return NULL;
 	}
-	/* INVALID_ARRAY_INDEX indicates an empty flow */
-	for (i = 0; i < entries_num; i++)
-		tbl->flows[i].start_index = INVALID_ARRAY_INDEX;
 	tbl->max_flow_num = entries_num;
 
+	bucket_num = rte_align32pow2(entries_num);
+	size = sizeof(uint32_t) * bucket_num;
+	tbl->flow_buckets = rte_malloc_socket(__func__,
+			size,
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (tbl->flow_buckets == NULL) {
+		rte_free(tbl->flows);
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
+	/* INVALID_ARRAY_INDEX indicates an empty bucket */
+	memset(tbl->flow_buckets, 0xff, size);
+	tbl->bucket_mask = bucket_num - 1;
+
 	return tbl;
 }
 
@@ -68,6 +82,7 @@ gro_tcp4_tbl_destroy(void *tbl)
 	if (tcp_tbl) {
 		rte_free(tcp_tbl->items);
 		rte_free(tcp_tbl->flows);
+		rte_free(tcp_tbl->flow_buckets);
 	}
 	rte_free(tcp_tbl);
 }
@@ -75,27 +90,51 @@ gro_tcp4_tbl_destroy(void *tbl)
 static inline uint32_t
 find_an_empty_item(struct gro_tcp4_tbl *tbl)
 {
-	uint32_t i;
-	uint32_t max_item_num = tbl->max_item_num;
+	uint32_t item_idx = tbl->free_item_idx;
 
-	for (i = 0; i < max_item_num; i++)
-		if (tbl->items[i].firstseg == NULL)
-			return i;
+	/* Reuse a released item first, then a never used one. */
+	if (item_idx != INVALID_ARRAY_INDEX) {
+		tbl->free_item_idx = tbl->items[item_idx].next_pkt_idx;
+		return item_idx;
+	}
+	if (tbl->item_watermark < tbl->max_item_num)
+		return tbl->item_watermark++;
 	return INVALID_ARRAY_INDEX;
 }
 
 static inline uint32_t
-find_an_empty_flow(struct gro_tcp4_tbl *tbl)
+find_a_flow(struct gro_tcp4_tbl *tbl,
+		struct tcp4_flow_key *key,
+		uint32_t hash)
 {
-	uint32_t i;
-	uint32_t max_flow_num = tbl->max_flow_num;
-
-	for (i = 0; i < max_flow_num; i++)
-		if (tbl->flows[i].start_index == INVALID_ARRAY_INDEX)
-			return i;
+	uint32_t flow_idx = tbl->flow_buckets[hash & tbl->bucket_mask];
+
+	while (flow_idx != INVALID_ARRAY_INDEX) {
+		if (tbl->flows[flow_idx].hash == hash &&
+				is_same_tcp4_flow(tbl->flows[flow_idx].key,
+					*key))
+			return flow_idx;
+		flow_idx = tbl->flows[flow_idx].next_flow_idx;
+	}
 	return INVALID_ARRAY_INDEX;
 }
 
+/*
+ * Return the location which keeps the index of the given flow, i.e.
+ * either its hash bucket or the previous flow in the bucket.
+ */
+static inline uint32_t *
+find_flow_link(struct gro_tcp4_tbl *tbl, uint32_t flow_idx)
+{
+	uint32_t *link;
+
+	link = &tbl->flow_buckets[tbl->flows[flow_idx].hash &
+		tbl->bucket_mask];
+	while (*link != flow_idx)
+		link = &tbl->flows[*link].next_flow_idx;
+	return link;
+}
+
 static inline uint32_t
 insert_new_item(struct gro_tcp4_tbl *tbl,
 		struct rte_mbuf *pkt,
@@ -139,6 +178,8 @@ delete_item(struct gro_tcp4_tbl *tbl, uint32_t item_idx,
 
 	/* NULL indicates an empty item */
 	tbl->items[item_idx].firstseg = NULL;
+	tbl->items[item_idx].next_pkt_idx = tbl->free_item_idx;
+	tbl->free_item_idx = item_idx;
 	tbl->item_num--;
 	if (prev_item_idx != INVALID_ARRAY_INDEX)
 		tbl->items[prev_item_idx].next_pkt_idx = next_idx;
@@ -149,13 +190,15 @@ delete_item(struct gro_tcp4_tbl *tbl, uint32_t item_idx,
 static inline uint32_t
 insert_new_flow(struct gro_tcp4_tbl *tbl,
 		struct tcp4_flow_key *src,
+		uint32_t hash,
 		uint32_t item_idx)
 {
 	struct tcp4_flow_key *dst;
-	uint32_t flow_idx;
+	uint32_t flow_idx, *bucket;
 
-	flow_idx = find_an_empty_flow(tbl);
-	if (unlikely(flow_idx == INVALID_ARRAY_INDEX))
+	/* The used flows are kept at the beginning of the array. */
+	flow_idx = tbl->flow_num;
+	if (unlikely(flow_idx == tbl->max_flow_num))
 		return INVALID_ARRAY_INDEX;
 
 	dst = &(tbl->flows[flow_idx].key);
@@ -169,11 +212,37 @@ insert_new_flow(struct gro_tcp4_tbl *tbl,
 	dst->dst_port = src->dst_port;
 
 	tbl->flows[flow_idx].start_index = item_idx;
+	tbl->flows[flow_idx].hash = hash;
+
+	bucket = &tbl->flow_buckets[hash & tbl->bucket_mask];
+	tbl->flows[flow_idx].next_flow_idx = *bucket;
+	*bucket = flow_idx;
 	tbl->flow_num++;
 
 	return flow_idx;
 }
 
+/*
+ * Delete an empty flow. The last flow in the array is moved into its
+ * place, to keep the used flows contiguous.
+ */
+static inline void
+delete_flow(struct gro_tcp4_tbl *tbl, uint32_t flow_idx)
+{
+	uint32_t last_idx = tbl->flow_num - 1;
+	uint32_t *link;
+
+	link = find_flow_link(tbl, flow_idx);
+	*link = tbl->flows[flow_idx].next_flow_idx;
+
+	if (flow_idx != last_idx) {
+		link = find_flow_link(tbl, last_idx);
+		*link = flow_idx;
+		tbl->flows[flow_idx] = tbl->flows[last_idx];
+	}
+	tbl->flow_num--;
+}
+
 /*
  * update the packet length for the flushed packet.
  */
@@ -204,9 +273,8 @@ gro_tcp4_reassemble(struct rte_mbuf *pkt,
 
 	struct tcp4_flow_key key;
 	uint32_t cur_idx, prev_idx, item_idx;
-	uint32_t i, max_flow_num, remaining_flow_num;
+	uint32_t flow_idx, hash;
 	int cmp;
-	uint8_t find;
 
 	/*
 	 * Don't process the packet whose TCP header length is greater
@@ -252,30 +320,20 @@ gro_tcp4_reassemble(struct rte_mbuf *pkt,
 	key.recv_ack = tcp_hdr->recv_ack;
 
 	/* Search for a matched flow. */
-	max_flow_num = tbl->max_flow_num;
-	remaining_flow_num = tbl->flow_num;
-	find = 0;
-	for (i = 0; i < max_flow_num && remaining_flow_num; i++) {
-		if (tbl->flows[i].start_index != INVALID_ARRAY_INDEX) {
-			if (is_same_tcp4_flow(tbl->flows[i].key, key)) {
-				find = 1;
-				break;
-			}
-			remaining_flow_num--;
-		}
-	}
+	hash = rte_hash_crc(&key, sizeof(key), 0);
+	flow_idx = find_a_flow(tbl, &key, hash);
 
 	/*
 	 * Fail to find a matched flow. Insert a new flow and store the
 	 * packet into the flow.
 	 */
-	if (find == 0) {
+	if (flow_idx == INVALID_ARRAY_INDEX) {
 		item_idx = insert_new_item(tbl, pkt, start_time,
 				INVALID_ARRAY_INDEX, sent_seq, ip_id,
 				is_atomic);
 		if (item_idx == INVALID_ARRAY_INDEX)
 			return -1;
-		if (insert_new_flow(tbl, &key, item_idx) ==
+		if (insert_new_flow(tbl, &key, hash, item_idx) ==
 				INVALID_ARRAY_INDEX) {
 			/*
 			 * Fail to insert a new flow, so delete the
@@ -291,7 +349,7 @@ gro_tcp4_reassemble(struct rte_mbuf *pkt,
 	 * Check all packets in the flow and try to find a neighbor for
 	 * the input packet.
 	 */
-	cur_idx = tbl->flows[i].start_index;
+	cur_idx = tbl->flows[flow_idx].start_index;
 	prev_idx = cur_idx;
 	do {
 		cmp = check_seq_option(&(tbl->items[cur_idx]), tcp_hdr,
@@ -331,37 +389,35 @@ gro_tcp4_tbl_timeout_flush(struct gro_tcp4_tbl *tbl,
 		uint16_t nb_out)
 {
 	uint16_t k = 0;
-	uint32_t i, j;
-	uint32_t max_flow_num = tbl->max_flow_num;
-
-	for (i = 0; i < max_flow_num; i++) {
-		if (unlikely(tbl->flow_num == 0))
-			return k;
+	uint32_t i = 0, j;
 
+	while (i < tbl->flow_num && k < nb_out) {
 		j = tbl->flows[i].start_index;
-		while (j != INVALID_ARRAY_INDEX) {
-			if (tbl->items[j].start_time <= flush_timestamp) {
-				out[k++] = tbl->items[j].firstseg;
-				if (tbl->items[j].nb_merged > 1)
-					update_header(&(tbl->items[j]));
-				/*
-				 * Delete the packet and get the next
-				 * packet in the flow.
-				 */
-				j = delete_item(tbl, j, INVALID_ARRAY_INDEX);
-				tbl->flows[i].start_index = j;
-				if (j == INVALID_ARRAY_INDEX)
-					tbl->flow_num--;
-
-				if (unlikely(k == nb_out))
-					return k;
-			} else
-				/*
-				 * The left packets in this flow won't be
-				 * timeout. Go to check other flows.
-				 */
-				break;
+		/*
+		 * Packets in a flow are checked in order and the left
+		 * packets won't be timeout once a packet isn't.
+		 */
+		while (j != INVALID_ARRAY_INDEX && k < nb_out &&
+				tbl->items[j].start_time <= flush_timestamp) {
+			out[k++] = tbl->items[j].firstseg;
+			if (tbl->items[j].nb_merged > 1)
+				update_header(&(tbl->items[j]));
+			/*
+			 * Delete the packet and get the next
+			 * packet in the flow.
+			 */
+			j = delete_item(tbl, j, INVALID_ARRAY_INDEX);
 		}
+		tbl->flows[i].start_index = j;
+
+		/*
+		 * The last flow is moved into the place of a deleted
+		 * flow, so check the same index again.
+		 */
+		if (j == INVALID_ARRAY_INDEX)
+			delete_flow(tbl, i);
+		else
+			i++;
 	}
 	return k;
 }
@@ -7,6 +7,7 @@
 
 #include <rte_ip.h>
 #include <rte_tcp.h>
+#include <rte_hash_crc.h>
 
 #define INVALID_ARRAY_INDEX 0xffffffffUL
 #define GRO_TCP4_TBL_MAX_ITEM_NUM (1024UL * 1024UL)
@@ -36,11 +37,12 @@ struct tcp4_flow_key {
 
 struct gro_tcp4_flow {
 	struct tcp4_flow_key key;
-	/*
-	 * The index of the first packet in the flow.
-	 * INVALID_ARRAY_INDEX indicates an empty flow.
-	 */
+	/* The index of the first packet in the flow. */
 	uint32_t start_index;
+	/* The hash value of the flow key */
+	uint32_t hash;
+	/* The index of the next flow in the same hash bucket */
+	uint32_t next_flow_idx;
 };
 
 struct gro_tcp4_item {
@@ -75,12 +77,25 @@ struct gro_tcp4_item {
 
 /*
  * TCP/IPv4 reassembly table structure.
+ *
+ * Flows are indexed by the hash of their key, so looking a packet's
+ * flow up doesn't depend on the number of flows in the table. The
+ * used flows are kept at the beginning of the flow array, so that
+ * flushing only walks the flows which hold packets.
  */
 struct gro_tcp4_tbl {
 	/* item array */
 	struct gro_tcp4_item *items;
 	/* flow array */
 	struct gro_tcp4_flow *flows;
+	/* hash buckets, each keeping the index of its first flow */
+	uint32_t *flow_buckets;
+	/* the number of buckets minus 1. It's a power of 2 minus 1. */
+	uint32_t bucket_mask;
+	/* the first free item, the free items are chained by next_pkt_idx */
+	uint32_t free_item_idx;
+	/* the items from this index on have never been used */
+	uint32_t item_watermark;
 	/* current item number */
 	uint32_t item_num;
 	/* current flow num */
@@ -0,0 +1,430 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <rte_malloc.h>
+#include <rte_mbuf.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+
+#include "gro_tcp6.h"
+
+void *
+gro_tcp6_tbl_create(uint16_t socket_id,
+		uint16_t max_flow_num,
+		uint16_t max_item_per_flow)
+{
+	struct gro_tcp6_tbl *tbl;
+	size_t size;
+	uint32_t entries_num, bucket_num;
+
+	entries_num = max_flow_num * max_item_per_flow;
+	entries_num = RTE_MIN(entries_num, GRO_TCP6_TBL_MAX_ITEM_NUM);
+
+	if (entries_num == 0)
+		return NULL;
+
+	tbl = rte_zmalloc_socket(__func__,
+			sizeof(struct gro_tcp6_tbl),
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (tbl == NULL)
+		return NULL;
+
+	size = sizeof(struct gro_tcp4_item) * entries_num;
+	tbl->items = rte_zmalloc_socket(__func__,
+			size,
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (tbl->items == NULL) {
+		rte_free(tbl);
+		return NULL;
+	}
+	tbl->max_item_num = entries_num;
+	tbl->free_item_idx = INVALID_ARRAY_INDEX;
+
+	size = sizeof(struct gro_tcp6_flow) * entries_num;
+	tbl->flows = rte_zmalloc_socket(__func__,
+			size,
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (tbl->flows == NULL) {
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
+	tbl->max_flow_num = entries_num;
+
+	bucket_num = rte_align32pow2(entries_num);
+	size = sizeof(uint32_t) * bucket_num;
+	tbl->flow_buckets = rte_malloc_socket(__func__,
+			size,
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (tbl->flow_buckets == NULL) {
+		rte_free(tbl->flows);
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
+	/* INVALID_ARRAY_INDEX indicates an empty bucket */
+	memset(tbl->flow_buckets, 0xff, size);
+	tbl->bucket_mask = bucket_num - 1;
+
+	return tbl;
+}
+
+void
+gro_tcp6_tbl_destroy(void *tbl)
+{
+	struct gro_tcp6_tbl *tcp_tbl = tbl;
+
+	if (tcp_tbl) {
+		rte_free(tcp_tbl->items);
+		rte_free(tcp_tbl->flows);
+		rte_free(tcp_tbl->flow_buckets);
+	}
+	rte_free(tcp_tbl);
+}
+
+static inline uint32_t
+find_an_empty_item(struct gro_tcp6_tbl *tbl)
+{
+	uint32_t item_idx = tbl->free_item_idx;
+
+	/* Reuse a released item first, then a never used one. */
+	if (item_idx != INVALID_ARRAY_INDEX) {
+		tbl->free_item_idx = tbl->items[item_idx].next_pkt_idx;
+		return item_idx;
+	}
+	if (tbl->item_watermark < tbl->max_item_num)
+		return tbl->item_watermark++;
+	return INVALID_ARRAY_INDEX;
+}
+
+static inline uint32_t
+find_a_flow(struct gro_tcp6_tbl *tbl,
+		struct tcp6_flow_key *key,
+		uint32_t hash)
+{
+	uint32_t flow_idx = tbl->flow_buckets[hash & tbl->bucket_mask];
+
+	while (flow_idx != INVALID_ARRAY_INDEX) {
+		if (tbl->flows[flow_idx].hash == hash &&
+				is_same_tcp6_flow(tbl->flows[flow_idx].key,
+					*key))
+			return flow_idx;
+		flow_idx = tbl->flows[flow_idx].next_flow_idx;
+	}
+	return INVALID_ARRAY_INDEX;
+}
+
+/*
+ * Return the location which keeps the index of the given flow, i.e.
+ * either its hash bucket or the previous flow in the bucket.
+ */
+static inline uint32_t *
+find_flow_link(struct gro_tcp6_tbl *tbl, uint32_t flow_idx)
+{
+	uint32_t *link;
+
+	link = &tbl->flow_buckets[tbl->flows[flow_idx].hash &
+		tbl->bucket_mask];
+	while (*link != flow_idx)
+		link = &tbl->flows[*link].next_flow_idx;
+	return link;
+}
+
+static inline uint32_t
+insert_new_item(struct gro_tcp6_tbl *tbl,
+		struct rte_mbuf *pkt,
+		uint64_t start_time,
+		uint32_t prev_idx,
+		uint32_t sent_seq)
+{
+	uint32_t item_idx;
+
+	item_idx = find_an_empty_item(tbl);
+	if (item_idx == INVALID_ARRAY_INDEX)
+		return INVALID_ARRAY_INDEX;
+
+	tbl->items[item_idx].firstseg = pkt;
+	tbl->items[item_idx].lastseg = rte_pktmbuf_lastseg(pkt);
+	tbl->items[item_idx].start_time = start_time;
+	tbl->items[item_idx].next_pkt_idx = INVALID_ARRAY_INDEX;
+	tbl->items[item_idx].sent_seq = sent_seq;
+	/* IPv6 has no ID field, so it's always ignored */
+	tbl->items[item_idx].ip_id = 0;
+	tbl->items[item_idx].nb_merged = 1;
+	tbl->items[item_idx].is_atomic = 1;
+	tbl->item_num++;
+
+	/* if the previous packet exists, chain them together. */
+	if (prev_idx != INVALID_ARRAY_INDEX) {
+		tbl->items[item_idx].next_pkt_idx =
+			tbl->items[prev_idx].next_pkt_idx;
+		tbl->items[prev_idx].next_pkt_idx = item_idx;
+	}
+
+	return item_idx;
+}
+
+static inline uint32_t
+delete_item(struct gro_tcp6_tbl *tbl, uint32_t item_idx,
+		uint32_t prev_item_idx)
+{
+	uint32_t next_idx = tbl->items[item_idx].next_pkt_idx;
+
+	/* NULL indicates an empty item */
+	tbl->items[item_idx].firstseg = NULL;
+	tbl->items[item_idx].next_pkt_idx = tbl->free_item_idx;
+	tbl->free_item_idx = item_idx;
+	tbl->item_num--;
+	if (prev_item_idx != INVALID_ARRAY_INDEX)
+		tbl->items[prev_item_idx].next_pkt_idx = next_idx;
+
+	return next_idx;
+}
+
+static inline uint32_t
+insert_new_flow(struct gro_tcp6_tbl *tbl,
+		struct tcp6_flow_key *src,
+		uint32_t hash,
+		uint32_t item_idx)
+{
+	struct tcp6_flow_key *dst;
+	uint32_t flow_idx, *bucket;
+
+	/* The used flows are kept at the beginning of the array. */
+	flow_idx = tbl->flow_num;
+	if (unlikely(flow_idx == tbl->max_flow_num))
+		return INVALID_ARRAY_INDEX;
+
+	dst = &(tbl->flows[flow_idx].key);
+
+	rte_ether_addr_copy(&(src->eth_saddr), &(dst->eth_saddr));
+	rte_ether_addr_copy(&(src->eth_daddr), &(dst->eth_daddr));
+	memcpy(dst->ip_src_addr, src->ip_src_addr, sizeof(dst->ip_src_addr));
+	memcpy(dst->ip_dst_addr, src->ip_dst_addr, sizeof(dst->ip_dst_addr));
+	dst->vtc_flow = src->vtc_flow;
+	dst->recv_ack = src->recv_ack;
+	dst->src_port = src->src_port;
+	dst->dst_port = src->dst_port;
+
+	tbl->flows[flow_idx].start_index = item_idx;
+	tbl->flows[flow_idx].hash = hash;
+
+	bucket = &tbl->flow_buckets[hash & tbl->bucket_mask];
+	tbl->flows[flow_idx].next_flow_idx = *bucket;
+	*bucket = flow_idx;
+	tbl->flow_num++;
+
+	return flow_idx;
+}
+
+/*
+ * Delete an empty flow. The last flow in the array is moved into its
+ * place, to keep the used flows contiguous.
+ */
+static inline void
+delete_flow(struct gro_tcp6_tbl *tbl, uint32_t flow_idx)
+{
+	uint32_t last_idx = tbl->flow_num - 1;
+	uint32_t *link;
+
+	link = find_flow_link(tbl, flow_idx);
+	*link = tbl->flows[flow_idx].next_flow_idx;
+
+	if (flow_idx != last_idx) {
+		link = find_flow_link(tbl, last_idx);
+		*link = flow_idx;
+		tbl->flows[flow_idx] = tbl->flows[last_idx];
+	}
+	tbl->flow_num--;
+}
+
+/*
+ * update the packet length for the flushed packet.
+ */
+static inline void
+update_header(struct gro_tcp4_item *item)
+{
+	struct rte_ipv6_hdr *ipv6_hdr;
+	struct rte_mbuf *pkt = item->firstseg;
+
+	/* The payload length includes the extension headers, if any. */
+	ipv6_hdr = (struct rte_ipv6_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+			pkt->l2_len);
+	ipv6_hdr->payload_len = rte_cpu_to_be_16(pkt->pkt_len -
+			pkt->l2_len - sizeof(struct rte_ipv6_hdr));
+}
+
+int32_t
+gro_tcp6_reassemble(struct rte_mbuf *pkt,
+		struct gro_tcp6_tbl *tbl,
+		uint64_t start_time)
+{
+	struct rte_ether_hdr *eth_hdr;
+	struct rte_ipv6_hdr *ipv6_hdr;
+	struct rte_tcp_hdr *tcp_hdr;
+	uint32_t sent_seq;
+	int32_t tcp_dl;
+	uint16_t hdr_len;
+
+	struct tcp6_flow_key key;
+	uint32_t cur_idx, prev_idx, item_idx;
+	uint32_t flow_idx, hash;
+	int cmp;
+
+	/*
+	 * Don't process the packet whose TCP header length is greater
+	 * than 60 bytes or less than 20 bytes.
+	 */
+	if (unlikely(INVALID_TCP_HDRLEN(pkt->l4_len)))
+		return -1;
+
+	eth_hdr = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
+	ipv6_hdr = (struct rte_ipv6_hdr *)((char *)eth_hdr + pkt->l2_len);
+	tcp_hdr = (struct rte_tcp_hdr *)((char *)ipv6_hdr + pkt->l3_len);
+	hdr_len = pkt->l2_len + pkt->l3_len + pkt->l4_len;
+
+	/* Don't process the packet which has IPv6 extension headers. */
+	if (pkt->l3_len != sizeof(struct rte_ipv6_hdr) ||
+			ipv6_hdr->proto != IPPROTO_TCP)
+		return -1;
+
+	/*
+	 * Don't process the packet which has FIN, SYN, RST, PSH, URG, ECE
+	 * or CWR set.
+	 */
+	if (tcp_hdr->tcp_flags != RTE_TCP_ACK_FLAG)
+		return -1;
+	/*
+	 * Don't process the packet whose payload length is less than or
+	 * equal to 0.
+	 */
+	tcp_dl = pkt->pkt_len - hdr_len;
+	if (tcp_dl <= 0)
+		return -1;
+
+	sent_seq = rte_be_to_cpu_32(tcp_hdr->sent_seq);
+
+	rte_ether_addr_copy(&(eth_hdr->s_addr), &(key.eth_saddr));
+	rte_ether_addr_copy(&(eth_hdr->d_addr), &(key.eth_daddr));
+	memcpy(key.ip_src_addr, ipv6_hdr->src_addr, sizeof(key.ip_src_addr));
+	memcpy(key.ip_dst_addr, ipv6_hdr->dst_addr, sizeof(key.ip_dst_addr));
+	key.vtc_flow = ipv6_hdr->vtc_flow;
+	key.src_port = tcp_hdr->src_port;
+	key.dst_port = tcp_hdr->dst_port;
+	key.recv_ack = tcp_hdr->recv_ack;
+
+	/* Search for a matched flow. */
+	hash = rte_hash_crc(&key, sizeof(key), 0);
+	flow_idx = find_a_flow(tbl, &key, hash);
+
+	/*
+	 * Fail to find a matched flow. Insert a new flow and store the
+	 * packet into the flow.
+	 */
+	if (flow_idx == INVALID_ARRAY_INDEX) {
+		item_idx = insert_new_item(tbl, pkt, start_time,
+				INVALID_ARRAY_INDEX, sent_seq);
+		if (item_idx == INVALID_ARRAY_INDEX)
+			return -1;
+		if (insert_new_flow(tbl, &key, hash, item_idx) ==
+				INVALID_ARRAY_INDEX) {
+			/*
+			 * Fail to insert a new flow, so delete the
+			 * stored packet.
+			 */
+			delete_item(tbl, item_idx, INVALID_ARRAY_INDEX);
+			return -1;
+		}
+		return 0;
+	}
+
+	/*
+	 * Check all packets in the flow and try to find a neighbor for
+	 * the input packet.
+	 */
+	cur_idx = tbl->flows[flow_idx].start_index;
+	prev_idx = cur_idx;
+	do {
+		cmp = check_seq_option(&(tbl->items[cur_idx]), tcp_hdr,
+				sent_seq, 0, pkt->l4_len, tcp_dl, 0, 1);
+		if (cmp) {
+			if (merge_two_tcp4_packets(&(tbl->items[cur_idx]),
+						pkt, cmp, sent_seq, 0, 0))
+				return 1;
+			/*
+			 * Fail to merge the two packets, as the packet
+			 * length is greater than the max value. Store
+			 * the packet into the flow.
+			 */
+			if (insert_new_item(tbl, pkt, start_time, prev_idx,
+						sent_seq) == INVALID_ARRAY_INDEX)
+				return -1;
+			return 0;
+		}
+		prev_idx = cur_idx;
+		cur_idx = tbl->items[cur_idx].next_pkt_idx;
+	} while (cur_idx != INVALID_ARRAY_INDEX);
+
+	/* Fail to find a neighbor, so store the packet into the flow. */
+	if (insert_new_item(tbl, pkt, start_time, prev_idx, sent_seq) ==
+			INVALID_ARRAY_INDEX)
+		return -1;
+
+	return 0;
+}
+
+uint16_t
+gro_tcp6_tbl_timeout_flush(struct gro_tcp6_tbl *tbl,
+		uint64_t flush_timestamp,
+		struct rte_mbuf **out,
+		uint16_t nb_out)
+{
+	uint16_t k = 0;
+	uint32_t i = 0, j;
+
+	while (i < tbl->flow_num && k < nb_out) {
+		j = tbl->flows[i].start_index;
+		/*
+		 * Packets in a flow are checked in order and the left
+		 * packets won't be timeout once a packet isn't.
+		 */
+		while (j != INVALID_ARRAY_INDEX && k < nb_out &&
+				tbl->items[j].start_time <= flush_timestamp) {
+			out[k++] = tbl->items[j].firstseg;
+			if (tbl->items[j].nb_merged > 1)
+				update_header(&(tbl->items[j]));
+			/*
+			 * Delete the packet and get the next
+			 * packet in the flow.
+			 */
+			j = delete_item(tbl, j, INVALID_ARRAY_INDEX);
+		}
+		tbl->flows[i].start_index = j;
+
+		/*
+		 * The last flow is moved into the place of a deleted
+		 * flow, so check the same index again.
+		 */
+		if (j == INVALID_ARRAY_INDEX)
+			delete_flow(tbl, i);
+		else
+			i++;
+	}
+	return k;
+}
+
+uint32_t
+gro_tcp6_tbl_pkt_count(void *tbl)
+{
+	struct gro_tcp6_tbl *gro_tbl = tbl;
+
+	if (gro_tbl)
+		return gro_tbl->item_num;
+
+	return 0;
+}
@@ -0,0 +1,483 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <rte_malloc.h>
+#include <rte_mbuf.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+
+#include "gro_udp4.h"
+
+void *
+gro_udp4_tbl_create(uint16_t socket_id,
+		uint16_t max_flow_num,
+		uint16_t max_item_per_flow)
+{
+	struct gro_udp4_tbl *tbl;
+	size_t size;
+	uint32_t entries_num, bucket_num;
+
+	entries_num = max_flow_num * max_item_per_flow;
+	entries_num = RTE_MIN(entries_num, GRO_UDP4_TBL_MAX_ITEM_NUM);
+
+	if (entries_num == 0)
+		return NULL;
+
+	tbl = rte_zmalloc_socket(__func__,
+			sizeof(struct gro_udp4_tbl),
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (tbl == NULL)
+		return NULL;
+
+	size = sizeof(struct gro_udp4_item) * entries_num;
+	tbl->items = rte_zmalloc_socket(__func__,
+			size,
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (tbl->items == NULL) {
+		rte_free(tbl);
+		return NULL;
+	}
+	tbl->max_item_num = entries_num;
+	tbl->free_item_idx = INVALID_ARRAY_INDEX;
+
+	size = sizeof(struct gro_udp4_flow) * entries_num;
+	tbl->flows = rte_zmalloc_socket(__func__,
+			size,
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (tbl->flows == NULL) {
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
+	tbl->max_flow_num = entries_num;
+
+	bucket_num = rte_align32pow2(entries_num);
+	size = sizeof(uint32_t) * bucket_num;
+	tbl->flow_buckets = rte_malloc_socket(__func__,
+			size,
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (tbl->flow_buckets == NULL) {
+		rte_free(tbl->flows);
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
+	/* INVALID_ARRAY_INDEX indicates an empty bucket */
+	memset(tbl->flow_buckets, 0xff, size);
+	tbl->bucket_mask = bucket_num - 1;
+
+	return tbl;
+}
+
+void
+gro_udp4_tbl_destroy(void *tbl)
+{
+	struct gro_udp4_tbl *udp_tbl = tbl;
+
+	if (udp_tbl) {
+		rte_free(udp_tbl->items);
+		rte_free(udp_tbl->flows);
+		rte_free(udp_tbl->flow_buckets);
+	}
+	rte_free(udp_tbl);
+}
+
+static inline uint32_t
+find_an_empty_item(struct gro_udp4_tbl *tbl)
+{
+	uint32_t item_idx = tbl->free_item_idx;
+
+	/* Reuse a released item first, then a never used one. */
+	if (item_idx != INVALID_ARRAY_INDEX) {
+		tbl->free_item_idx = tbl->items[item_idx].next_pkt_idx;
+		return item_idx;
+	}
+	if (tbl->item_watermark < tbl->max_item_num)
+		return tbl->item_watermark++;
+	return INVALID_ARRAY_INDEX;
+}
+
+static inline uint32_t
+find_a_flow(struct gro_udp4_tbl *tbl,
+		struct udp4_flow_key *key,
+		uint32_t hash)
+{
+	uint32_t flow_idx = tbl->flow_buckets[hash & tbl->bucket_mask];
+
+	while (flow_idx != INVALID_ARRAY_INDEX) {
+		if (tbl->flows[flow_idx].hash == hash &&
+				is_same_udp4_flow(tbl->flows[flow_idx].key,
+					*key))
+			return flow_idx;
+		flow_idx = tbl->flows[flow_idx].next_flow_idx;
+	}
+	return INVALID_ARRAY_INDEX;
+}
+
+/*
+ * Return the location which keeps the index of the given flow, i.e.
+ * either its hash bucket or the previous flow in the bucket.
+ */
+static inline uint32_t *
+find_flow_link(struct gro_udp4_tbl *tbl, uint32_t flow_idx)
+{
+	uint32_t *link;
+
+	link = &tbl->flow_buckets[tbl->flows[flow_idx].hash &
+		tbl->bucket_mask];
+	while (*link != flow_idx)
+		link = &tbl->flows[*link].next_flow_idx;
+	return link;
+}
+
+static inline uint32_t
+insert_new_item(struct gro_udp4_tbl *tbl,
+		struct rte_mbuf *pkt,
+		uint64_t start_time,
+		uint32_t prev_idx,
+		uint16_t frag_offset,
+		uint8_t is_last_frag)
+{
+	uint32_t item_idx;
+
+	item_idx = find_an_empty_item(tbl);
+	if (item_idx == INVALID_ARRAY_INDEX)
+		return INVALID_ARRAY_INDEX;
+
+	tbl->items[item_idx].firstseg = pkt;
+	tbl->items[item_idx].lastseg = rte_pktmbuf_lastseg(pkt);
+	tbl->items[item_idx].start_time = start_time;
+	tbl->items[item_idx].next_pkt_idx = INVALID_ARRAY_INDEX;
+	tbl->items[item_idx].frag_offset = frag_offset;
+	tbl->items[item_idx].nb_merged = 1;
+	tbl->items[item_idx].is_last_frag = is_last_frag;
+	tbl->item_num++;
+
+	/* if the previous packet exists, chain them together. */
+	if (prev_idx != INVALID_ARRAY_INDEX) {
+		tbl->items[item_idx].next_pkt_idx =
+			tbl->items[prev_idx].next_pkt_idx;
+		tbl->items[prev_idx].next_pkt_idx = item_idx;
+	}
+
+	return item_idx;
+}
+
+static inline uint32_t
+delete_item(struct gro_udp4_tbl *tbl, uint32_t item_idx,
+		uint32_t prev_item_idx)
+{
+	uint32_t next_idx = tbl->items[item_idx].next_pkt_idx;
+
+	/* NULL indicates an empty item */
+	tbl->items[item_idx].firstseg = NULL;
+	tbl->items[item_idx].next_pkt_idx = tbl->free_item_idx;
+	tbl->free_item_idx = item_idx;
+	tbl->item_num--;
+	if (prev_item_idx != INVALID_ARRAY_INDEX)
+		tbl->items[prev_item_idx].next_pkt_idx = next_idx;
+
+	return next_idx;
+}
+
+static inline uint32_t
+insert_new_flow(struct gro_udp4_tbl *tbl,
+		struct udp4_flow_key *src,
+		uint32_t hash,
+		uint32_t item_idx)
+{
+	struct udp4_flow_key *dst;
+	uint32_t flow_idx, *bucket;
+
+	/* The used flows are kept at the beginning of the array. */
+	flow_idx = tbl->flow_num;
+	if (unlikely(flow_idx == tbl->max_flow_num))
+		return INVALID_ARRAY_INDEX;
+
+	dst = &(tbl->flows[flow_idx].key);
+
+	rte_ether_addr_copy(&(src->eth_saddr), &(dst->eth_saddr));
+	rte_ether_addr_copy(&(src->eth_daddr), &(dst->eth_daddr));
+	dst->ip_src_addr = src->ip_src_addr;
+	dst->ip_dst_addr = src->ip_dst_addr;
+	dst->ip_id = src->ip_id;
+	dst->reserved = 0;
+
+	tbl->flows[flow_idx].start_index = item_idx;
+	tbl->flows[flow_idx].hash = hash;
+
+	bucket = &tbl->flow_buckets[hash & tbl->bucket_mask];
+	tbl->flows[flow_idx].next_flow_idx = *bucket;
+	*bucket = flow_idx;
+	tbl->flow_num++;
+
+	return flow_idx;
+}
+
+/*
+ * Delete an empty flow. The last flow in the array is moved into its
+ * place, to keep the used flows contiguous.
+ */
+static inline void
+delete_flow(struct gro_udp4_tbl *tbl, uint32_t flow_idx)
+{
+	uint32_t last_idx = tbl->flow_num - 1;
+	uint32_t *link;
+
+	link = find_flow_link(tbl, flow_idx);
+	*link = tbl->flows[flow_idx].next_flow_idx;
+
+	if (flow_idx != last_idx) {
+		link = find_flow_link(tbl, last_idx);
+		*link = flow_idx;
+		tbl->flows[flow_idx] = tbl->flows[last_idx];
+	}
+	tbl->flow_num--;
+}
+
+/*
+ * A fragment merged into an item may fill the gap between the item and
+ * another item of the flow. If so, merge the second item into the
+ * first one, so that a datagram whose fragments arrive out of order
+ * still ends up in a single packet.
+ */
+static inline void
+merge_adjacent_items(struct gro_udp4_tbl *tbl,
+		uint32_t flow_idx,
+		uint32_t item_idx)
+{
+	struct gro_udp4_item *head, *tail;
+	struct rte_mbuf *pkt;
+	uint32_t cur_idx, prev_idx, item_prev_idx = INVALID_ARRAY_INDEX;
+	uint32_t head_idx = INVALID_ARRAY_INDEX, tail_idx, tail_prev_idx;
+	uint16_t ip_dl;
+	int cmp;
+
+	cur_idx = tbl->flows[flow_idx].start_index;
+	prev_idx = INVALID_ARRAY_INDEX;
+	tail_idx = tail_prev_idx = INVALID_ARRAY_INDEX;
+	while (cur_idx != INVALID_ARRAY_INDEX) {
+		if (cur_idx == item_idx) {
+			item_prev_idx = prev_idx;
+		} else if (head_idx == INVALID_ARRAY_INDEX) {
+			pkt = tbl->items[cur_idx].firstseg;
+			ip_dl = pkt->pkt_len - pkt->l2_len - pkt->l3_len;
+			cmp = check_udp4_frag_offset(&(tbl->items[item_idx]),
+					tbl->items[cur_idx].frag_offset, ip_dl,
+					tbl->items[cur_idx].is_last_frag, 0);
+			if (cmp > 0) {
+				head_idx = item_idx;
+				tail_idx = cur_idx;
+				tail_prev_idx = prev_idx;
+			} else if (cmp < 0) {
+				head_idx = cur_idx;
+				tail_idx = item_idx;
+			}
+		}
+		prev_idx = cur_idx;
+		cur_idx = tbl->items[cur_idx].next_pkt_idx;
+	}
+	if (head_idx == INVALID_ARRAY_INDEX)
+		return;
+	if (tail_idx == item_idx)
+		tail_prev_idx = item_prev_idx;
+
+	head = &(tbl->items[head_idx]);
+	tail = &(tbl->items[tail_idx]);
+	if (merge_two_udp4_packets(head, tail->firstseg, 1, 0,
+				tail->is_last_frag, 0) == 0)
+		return;
+	head->nb_merged += tail->nb_merged - 1;
+
+	cur_idx = delete_item(tbl, tail_idx, tail_prev_idx);
+	if (tail_prev_idx == INVALID_ARRAY_INDEX)
+		tbl->flows[flow_idx].start_index = cur_idx;
+}
+
+/*
+ * update the packet length and the fragment offset for the flushed
+ * packet.
+ */
+static inline void
+update_header(struct gro_udp4_item *item)
+{
+	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_mbuf *pkt = item->firstseg;
+	uint16_t frag_offset;
+
+	ipv4_hdr = (struct rte_ipv4_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+			pkt->l2_len);
+	ipv4_hdr->total_length = rte_cpu_to_be_16(pkt->pkt_len -
+			pkt->l2_len);
+
+	/* a complete datagram has neither MF bit nor offset */
+	frag_offset = item->frag_offset >> 3;
+	if (!item->is_last_frag)
+		frag_offset |= RTE_IPV4_HDR_MF_FLAG;
+	ipv4_hdr->fragment_offset = rte_cpu_to_be_16(frag_offset);
+}
+
+int32_t
+gro_udp4_reassemble(struct rte_mbuf *pkt,
+		struct gro_udp4_tbl *tbl,
+		uint64_t start_time)
+{
+	struct rte_ether_hdr *eth_hdr;
+	struct rte_ipv4_hdr *ipv4_hdr;
+	int32_t ip_dl;
+	uint16_t hdr_len, frag_offset;
+	uint8_t is_last_frag;
+
+	struct udp4_flow_key key;
+	uint32_t cur_idx, prev_idx, item_idx;
+	uint32_t flow_idx, hash;
+	int cmp;
+
+	eth_hdr = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
+	ipv4_hdr = (struct rte_ipv4_hdr *)((char *)eth_hdr + pkt->l2_len);
+	hdr_len = pkt->l2_len + pkt->l3_len;
+
+	/* Don't process the packet which isn't a UDP/IPv4 fragment. */
+	if (!is_ipv4_fragment(ipv4_hdr) ||
+			ipv4_hdr->next_proto_id != IPPROTO_UDP)
+		return -1;
+
+	/*
+	 * Don't process the packet whose payload length is less than or
+	 * equal to 0.
+	 */
+	ip_dl = pkt->pkt_len - hdr_len;
+	if (ip_dl <= 0)
+		return -1;
+
+	frag_offset = rte_be_to_cpu_16(ipv4_hdr->fragment_offset);
+	is_last_frag = (frag_offset & RTE_IPV4_HDR_MF_FLAG) == 0;
+	frag_offset = (frag_offset & RTE_IPV4_HDR_OFFSET_MASK) << 3;
+
+	rte_ether_addr_copy(&(eth_hdr->s_addr), &(key.eth_saddr));
+	rte_ether_addr_copy(&(eth_hdr->d_addr), &(key.eth_daddr));
+	key.ip_src_addr = ipv4_hdr->src_addr;
+	key.ip_dst_addr = ipv4_hdr->dst_addr;
+	key.ip_id = ipv4_hdr->packet_id;
+	key.reserved = 0;
+
+	/* Search for a matched flow. */
+	hash = rte_hash_crc(&key, sizeof(key), 0);
+	flow_idx = find_a_flow(tbl, &key, hash);
+
+	/*
+	 * Fail to find a matched flow. Insert a new flow and store the
+	 * packet into the flow.
+	 */
+	if (flow_idx == INVALID_ARRAY_INDEX) {
+		item_idx = insert_new_item(tbl, pkt, start_time,
+				INVALID_ARRAY_INDEX, frag_offset,
+				is_last_frag);
+		if (item_idx == INVALID_ARRAY_INDEX)
+			return -1;
+		if (insert_new_flow(tbl, &key, hash, item_idx) ==
+				INVALID_ARRAY_INDEX) {
+			/*
+			 * Fail to insert a new flow, so delete the
+			 * stored packet.
+			 */
+			delete_item(tbl, item_idx, INVALID_ARRAY_INDEX);
+			return -1;
+		}
+		return 0;
+	}
+
+	/*
+	 * Check all fragments in the flow and try to find a neighbor for
+	 * the input fragment.
+	 */
+	cur_idx = tbl->flows[flow_idx].start_index;
+	prev_idx = cur_idx;
+	do {
+		cmp = check_udp4_frag_offset(&(tbl->items[cur_idx]),
+				frag_offset, ip_dl, is_last_frag, 0);
+		if (cmp) {
+			if (merge_two_udp4_packets(&(tbl->items[cur_idx]),
+						pkt, cmp, frag_offset,
+						is_last_frag, 0)) {
+				merge_adjacent_items(tbl, flow_idx, cur_idx);
+				return 1;
+			}
+			/*
+			 * Fail to merge the two packets, as the packet
+			 * length is greater than the max value. Store
+			 * the packet into the flow.
+			 */
+			if (insert_new_item(tbl, pkt, start_time, prev_idx,
+						frag_offset, is_last_frag) ==
+					INVALID_ARRAY_INDEX)
+				return -1;
+			return 0;
+		}
+		prev_idx = cur_idx;
+		cur_idx = tbl->items[cur_idx].next_pkt_idx;
+	} while (cur_idx != INVALID_ARRAY_INDEX);
+
+	/* Fail to find a neighbor, so store the packet into the flow. */
+	if (insert_new_item(tbl, pkt, start_time, prev_idx, frag_offset,
+				is_last_frag) == INVALID_ARRAY_INDEX)
+		return -1;
+
+	return 0;
+}
+
+uint16_t
+gro_udp4_tbl_timeout_flush(struct gro_udp4_tbl *tbl,
+		uint64_t flush_timestamp,
+		struct rte_mbuf **out,
+		uint16_t nb_out)
+{
+	uint16_t k = 0;
+	uint32_t i = 0, j;
+
+	while (i < tbl->flow_num && k < nb_out) {
+		j = tbl->flows[i].start_index;
+		/*
+		 * Packets in a flow are checked in order and the left
+		 * packets won't be timeout once a packet isn't.
+		 */
+		while (j != INVALID_ARRAY_INDEX && k < nb_out &&
+				tbl->items[j].start_time <= flush_timestamp) {
+			out[k++] = tbl->items[j].firstseg;
+			if (tbl->items[j].nb_merged > 1)
+				update_header(&(tbl->items[j]));
+			/*
+			 * Delete the packet and get the next
+			 * packet in the flow.
+			 */
+			j = delete_item(tbl, j, INVALID_ARRAY_INDEX);
+		}
+		tbl->flows[i].start_index = j;
+
+		/*
+		 * The last flow is moved into the place of a deleted
+		 * flow, so check the same index again.
+		 */
+		if (j == INVALID_ARRAY_INDEX)
+			delete_flow(tbl, i);
+		else
+			i++;
+	}
+	return k;
+}
+
+uint32_t
+gro_udp4_tbl_pkt_count(void *tbl)
+{
+	struct gro_udp4_tbl *gro_tbl = tbl;
+
+	if (gro_tbl)
+		return gro_tbl->item_num;
+
+	return 0;
+}
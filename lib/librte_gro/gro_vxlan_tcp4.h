@@ -28,11 +28,12 @@ struct vxlan_tcp4_flow_key {
 
 struct gro_vxlan_tcp4_flow {
 	struct vxlan_tcp4_flow_key key;
-	/*
-	 * The index of the first packet in the flow. INVALID_ARRAY_INDEX
-	 * indicates an empty flow.
-	 */
+	/* The index of the first packet in the flow. */
 	uint32_t start_index;
+	/* The hash value of the flow key */
+	uint32_t hash;
+	/* The index of the next flow in the same hash bucket */
+	uint32_t next_flow_idx;
 };
 
 struct gro_vxlan_tcp4_item {
@@ -45,13 +46,22 @@ struct gro_vxlan_tcp4_item {
 
 /*
  * VxLAN (with an outer IPv4 header and an inner TCP/IPv4 packet)
- * reassembly table structure
+ * reassembly table structure. Flows are indexed by hash and kept
+ * contiguous, like in the TCP/IPv4 reassembly table.
  */
 struct gro_vxlan_tcp4_tbl {
 	/* item array */
 	struct gro_vxlan_tcp4_item *items;
 	/* flow array */
 	struct gro_vxlan_tcp4_flow *flows;
+	/* hash buckets, each keeping the index of its first flow */
+	uint32_t *flow_buckets;
+	/* the number of buckets minus 1. It's a power of 2 minus 1. */
+	uint32_t bucket_mask;
+	/* the first free item, the free items are chained by next_pkt_idx */
+	uint32_t free_item_idx;
+	/* the items from this index on have never been used */
+	uint32_t item_watermark;
 	/* current item number */
 	uint32_t item_num;
 	/* current flow number */
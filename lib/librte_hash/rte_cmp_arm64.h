@@ -32,6 +32,36 @@ rte_hash_k32_cmp_eq(const void *key1, const void *key2, size_t key_len)
 				(const char *) key2 + 16, key_len);
 }
 
+/* Functions to compare the common 5-tuple key sizes, with overlapping loads */
+static int
+rte_hash_k13_cmp_eq(const void *key1, const void *key2,
+		    size_t key_len __rte_unused)
+{
+	const uint64_t x0 = *(const unaligned_uint64_t *)key1 ^
+		*(const unaligned_uint64_t *)key2;
+	const uint64_t x1 = *(const unaligned_uint64_t *)
+			((const char *) key1 + 5) ^
+		*(const unaligned_uint64_t *)((const char *) key2 + 5);
+
+	return (x0 | x1) != 0;
+}
+
+static int
+rte_hash_k36_cmp_eq(const void *key1, const void *key2, size_t key_len)
+{
+	return rte_hash_k32_cmp_eq(key1, key2, key_len) ||
+		rte_hash_k16_cmp_eq((const char *) key1 + 20,
+				(const char *) key2 + 20, key_len);
+}
+
+static int
+rte_hash_k40_cmp_eq(const void *key1, const void *key2, size_t key_len)
+{
+	return rte_hash_k32_cmp_eq(key1, key2, key_len) ||
+		rte_hash_k16_cmp_eq((const char *) key1 + 24,
+				(const char *) key2 + 24, key_len);
+}
+
 static int
 rte_hash_k48_cmp_eq(const void *key1, const void *key2, size_t key_len)
 {
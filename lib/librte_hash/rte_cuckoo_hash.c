@@ -28,9 +28,13 @@
 #include <rte_compat.h>
 #include <rte_vect.h>
 #include <rte_tailq.h>
+#include <rte_cycles.h>
 
 #include "rte_hash.h"
 #include "rte_cuckoo_hash.h"
+#ifdef CC_CUCKOO_HASH_AVX512_SUPPORT
+#include "rte_cuckoo_hash_avx512.h"
+#endif
 
 #define FOR_EACH_BUCKET(CURRENT_BKT, START_BUCKET)                            \
 	for (CURRENT_BKT = START_BUCKET;                                      \
@@ -54,7 +58,7 @@ rte_hash_find_existing(const char *name)
 	hash_list = RTE_TAILQ_CAST(rte_hash_tailq.head, rte_hash_list);
 
 	rte_mcfg_tailq_read_lock();
-	TAILQ_FOREACH(te, hash_list, next) {
+	RTE_TAILQ_FOREACH(te, hash_list, next) {
 		h = (struct rte_hash *) te->data;
 		if (strncmp(name, h->name, RTE_HASH_NAMESIZE) == 0)
 			break;
@@ -121,8 +125,113 @@ get_alt_bucket_index(const struct rte_hash *h,
 	return (cur_bkt_idx ^ sig) & h->bucket_bitmask;
 }
 
-struct rte_hash *
-rte_hash_create(const struct rte_hash_parameters *params)
+/*
+ * Get the key store slot of a key index. The key store of a resizable
+ * table is made of the slots allocated at creation, followed by the ones
+ * added by each growth, in segments twice as large as the previous one.
+ */
+static inline struct rte_hash_key *
+get_key_slot(const struct rte_hash *h, uint32_t key_idx)
+{
+	uint32_t seg;
+
+	if (likely(key_idx < h->key_seg_base))
+		return RTE_PTR_ADD(h->key_store,
+				(uintptr_t)key_idx * h->key_entry_size);
+
+	key_idx -= h->key_seg_base;
+	seg = 31 - __builtin_clz((key_idx >> h->key_seg_shift) + 1);
+	key_idx -= ((1 << seg) - 1) << h->key_seg_shift;
+	return RTE_PTR_ADD(h->key_segs[seg],
+			(uintptr_t)key_idx * h->key_entry_size);
+}
+
+/* Get the inline keys and data of a bucket */
+static inline struct rte_hash_inline_bkt *
+get_inline_bkt(const struct rte_hash *h, const struct rte_hash_bucket *bkt)
+{
+	return &h->inline_bkts[bkt - h->buckets];
+}
+
+/* Copy a key into a buffer of RTE_HASH_INLINE_KEY_LEN bytes, zero padded */
+static inline void
+inline_key_pad(const struct rte_hash *h, const void *key, uint8_t *key16)
+{
+	memcpy(key16, key, h->key_len);
+	memset(key16 + h->key_len, 0, RTE_HASH_INLINE_KEY_LEN - h->key_len);
+}
+
+/* Compare a key, also given padded in @key16, with an inline key */
+static inline int
+inline_key_cmp_eq(const struct rte_hash *h, const void *key,
+		const uint8_t *key16, const uint8_t *inline_key)
+{
+	if (unlikely(h->cmp_jump_table_idx == KEY_CUSTOM))
+		return h->rte_hash_custom_cmp_eq(key, inline_key, h->key_len);
+#if defined(RTE_ARCH_X86) || defined(RTE_ARCH_ARM64)
+	return rte_hash_k16_cmp_eq(key16, inline_key, RTE_HASH_INLINE_KEY_LEN);
+#else
+	return memcmp(key16, inline_key, RTE_HASH_INLINE_KEY_LEN);
+#endif
+}
+
+/* Store the key and data of a bucket entry inline. The writer stores the
+ * key index of the entry after it, to release them to the readers.
+ */
+static inline void
+inline_entry_set(const struct rte_hash *h, struct rte_hash_bucket *bkt,
+		unsigned int i, const void *key, void *data)
+{
+	struct rte_hash_inline_bkt *il = get_inline_bkt(h, bkt);
+
+	inline_key_pad(h, key, il->key[i]);
+	__atomic_store_n(&il->pdata[i], data, __ATOMIC_RELAXED);
+}
+
+/* Allocate a bucket array of a resizable table */
+static struct rte_hash_gen *
+rte_hash_gen_alloc(uint32_t num_buckets, int socket_id)
+{
+	struct rte_hash_gen *gen;
+
+	gen = rte_zmalloc_socket(NULL, sizeof(*gen) +
+			(size_t)num_buckets * sizeof(struct rte_hash_bucket),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (gen == NULL)
+		return NULL;
+
+	gen->buckets = (struct rte_hash_bucket *)(gen + 1);
+	gen->num_buckets = num_buckets;
+	gen->bucket_bitmask = num_buckets - 1;
+	return gen;
+}
+
+/*
+ * Allocate the free slots ring of a resizable table. It is replaced by a
+ * larger one when the table grows, so it is not registered as a named ring.
+ */
+static struct rte_ring *
+rte_hash_resize_ring_alloc(const char *name, uint32_t count, int socket_id)
+{
+	struct rte_ring *r;
+	ssize_t ring_size;
+
+	ring_size = rte_ring_get_memsize(rte_align32pow2(count));
+	if (ring_size < 0)
+		return NULL;
+
+	r = rte_zmalloc_socket(NULL, ring_size, RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (r == NULL)
+		return NULL;
+
+	rte_ring_init(r, name, rte_align32pow2(count), 0);
+	return r;
+}
+
+static struct rte_hash *
+__rte_hash_create(const struct rte_hash_parameters *params,
+		const struct rte_hash_resize_params *rparams)
 {
 	struct rte_hash *h = NULL;
 	struct rte_tailq_entry *te = NULL;
@@ -133,17 +242,24 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	void *k = NULL;
 	void *buckets = NULL;
 	void *buckets_ext = NULL;
+	struct rte_hash_inline_bkt *inline_bkts = NULL;
 	char ring_name[RTE_RING_NAMESIZE];
 	char ext_ring_name[RTE_RING_NAMESIZE];
 	unsigned num_key_slots;
+	uint32_t num_bkt_locks;
 	unsigned i;
 	unsigned int hw_trans_mem_support = 0, use_local_cache = 0;
 	unsigned int ext_table_support = 0;
 	unsigned int readwrite_concur_support = 0;
 	unsigned int writer_takes_lock = 0;
+	unsigned int bkt_lock_support = 0;
 	unsigned int no_free_on_del = 0;
 	uint32_t *ext_bkt_to_free = NULL;
 	uint32_t *tbl_chng_cnt = NULL;
+	uint64_t *key_ts = NULL;
+	struct rte_hash_resize *rs = NULL;
+	struct rte_hash_gen *gen = NULL;
+	uint32_t entries;
 	unsigned int readwrite_concur_lf_support = 0;
 
 	rte_hash_function default_hash_func = (rte_hash_function)rte_jhash;
@@ -173,6 +289,45 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		return NULL;
 	}
 
+	if (rparams != NULL && ((params->extra_flag &
+			(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY |
+			 RTE_HASH_EXTRA_FLAGS_EXT_TABLE |
+			 RTE_HASH_EXTRA_FLAGS_AGING)) ||
+			rparams->max_entries > RTE_HASH_ENTRIES_MAX ||
+			rparams->max_entries < params->entries ||
+			rparams->grow_load > 100)) {
+		rte_errno = EINVAL;
+		RTE_LOG(ERR, HASH, "rte_hash_create: invalid resize "
+			"parameters\n");
+		return NULL;
+	}
+
+	if ((params->extra_flag2 & RTE_HASH_EXTRA_FLAGS2_INLINE_KEY) &&
+			(params->key_len > RTE_HASH_INLINE_KEY_LEN ||
+			 (params->extra_flag & RTE_HASH_EXTRA_FLAGS_EXT_TABLE) ||
+			 rparams != NULL)) {
+		rte_errno = EINVAL;
+		RTE_LOG(ERR, HASH, "rte_hash_create: inline keys are limited "
+			"to %u bytes, without ext table or resize\n",
+			RTE_HASH_INLINE_KEY_LEN);
+		return NULL;
+	}
+
+	if ((params->extra_flag2 & RTE_HASH_EXTRA_FLAGS2_BKT_LOCK) &&
+			(!(params->extra_flag &
+			   RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD) ||
+			 (params->extra_flag &
+			  (RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY |
+			   RTE_HASH_EXTRA_FLAGS_EXT_TABLE |
+			   RTE_HASH_EXTRA_FLAGS_TRANS_MEM_SUPPORT)) ||
+			 rparams != NULL)) {
+		rte_errno = EINVAL;
+		RTE_LOG(ERR, HASH, "rte_hash_create: bucket locks need "
+			"multi writer add, without rw concurrency, ext table, "
+			"transactional memory or resize\n");
+		return NULL;
+	}
+
 	/* Check extra flags field to check extra options. */
 	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_TRANS_MEM_SUPPORT)
 		hw_trans_mem_support = 1;
@@ -199,6 +354,27 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		no_free_on_del = 1;
 	}
 
+	/* Multiple writers lock the buckets they change rather than the
+	 * table.
+	 */
+	if (params->extra_flag2 & RTE_HASH_EXTRA_FLAGS2_BKT_LOCK) {
+		bkt_lock_support = 1;
+		writer_takes_lock = 0;
+	}
+
+	/* A resizable table doubles its entries, starting from a power of 2.
+	 * Its writers share one lock, taken by the resize functions, and
+	 * allocate the key store slots from the ring only, which is
+	 * replaced when the table grows.
+	 */
+	entries = params->entries;
+	if (rparams != NULL) {
+		entries = rte_align32pow2(params->entries);
+		hw_trans_mem_support = 0;
+		use_local_cache = 0;
+		writer_takes_lock = 0;
+	}
+
 	/* Store all keys and leave the first entry as a dummy entry for lookup_bulk */
 	if (use_local_cache)
 		/*
@@ -209,12 +385,16 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		num_key_slots = params->entries + (RTE_MAX_LCORE - 1) *
 					(LCORE_CACHE_SIZE - 1) + 1;
 	else
-		num_key_slots = params->entries + 1;
+		num_key_slots = entries + 1;
 
 	snprintf(ring_name, sizeof(ring_name), "HT_%s", params->name);
 	/* Create ring (Dummy slot index is not enqueued) */
-	r = rte_ring_create(ring_name, rte_align32pow2(num_key_slots),
-			params->socket_id, 0);
+	if (rparams != NULL)
+		r = rte_hash_resize_ring_alloc(ring_name, num_key_slots,
+				params->socket_id);
+	else
+		r = rte_ring_create(ring_name, rte_align32pow2(num_key_slots),
+				params->socket_id, 0);
 	if (r == NULL) {
 		RTE_LOG(ERR, HASH, "memory allocation failed\n");
 		goto err;
@@ -244,7 +424,7 @@ rte_hash_create(const struct rte_hash_parameters *params)
 
 	/* guarantee there's no existing: this is normally already checked
 	 * by ring creation above */
-	TAILQ_FOREACH(te, hash_list, next) {
+	RTE_TAILQ_FOREACH(te, hash_list, next) {
 		h = (struct rte_hash *) te->data;
 		if (strncmp(params->name, h->name, RTE_HASH_NAMESIZE) == 0)
 			break;
@@ -270,13 +450,36 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		goto err_unlock;
 	}
 
-	buckets = rte_zmalloc_socket(NULL,
+	if (rparams != NULL) {
+		rs = rte_zmalloc_socket(NULL, sizeof(*rs), RTE_CACHE_LINE_SIZE,
+				params->socket_id);
+		gen = rte_hash_gen_alloc(num_buckets, params->socket_id);
+		if (rs == NULL || gen == NULL) {
+			RTE_LOG(ERR, HASH, "buckets memory allocation "
+							"failed\n");
+			goto err_unlock;
+		}
+	} else {
+		buckets = rte_zmalloc_socket(NULL,
 				num_buckets * sizeof(struct rte_hash_bucket),
 				RTE_CACHE_LINE_SIZE, params->socket_id);
 
-	if (buckets == NULL) {
-		RTE_LOG(ERR, HASH, "buckets memory allocation failed\n");
-		goto err_unlock;
+		if (buckets == NULL) {
+			RTE_LOG(ERR, HASH, "buckets memory allocation "
+							"failed\n");
+			goto err_unlock;
+		}
+	}
+
+	if (params->extra_flag2 & RTE_HASH_EXTRA_FLAGS2_INLINE_KEY) {
+		inline_bkts = rte_zmalloc_socket(NULL,
+				num_buckets * sizeof(struct rte_hash_inline_bkt),
+				RTE_CACHE_LINE_SIZE, params->socket_id);
+		if (inline_bkts == NULL) {
+			RTE_LOG(ERR, HASH, "inline keys memory allocation "
+							"failed\n");
+			goto err_unlock;
+		}
 	}
 
 	/* Allocate same number of extendable buckets */
@@ -329,6 +532,17 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		goto err_unlock;
 	}
 
+	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_AGING) {
+		key_ts = rte_zmalloc_socket(NULL,
+				sizeof(uint64_t) * num_key_slots,
+				RTE_CACHE_LINE_SIZE, params->socket_id);
+		if (key_ts == NULL) {
+			RTE_LOG(ERR, HASH, "key time memory allocation "
+							"failed\n");
+			goto err_unlock;
+		}
+	}
+
 /*
  * If x86 architecture is used, select appropriate compare function,
  * which may use x86 intrinsics, otherwise use memcmp
@@ -336,12 +550,21 @@ rte_hash_create(const struct rte_hash_parameters *params)
 #if defined(RTE_ARCH_X86) || defined(RTE_ARCH_ARM64)
 	/* Select function to compare keys */
 	switch (params->key_len) {
+	case 13:
+		h->cmp_jump_table_idx = KEY_13_BYTES;
+		break;
 	case 16:
 		h->cmp_jump_table_idx = KEY_16_BYTES;
 		break;
 	case 32:
 		h->cmp_jump_table_idx = KEY_32_BYTES;
 		break;
+	case 36:
+		h->cmp_jump_table_idx = KEY_36_BYTES;
+		break;
+	case 40:
+		h->cmp_jump_table_idx = KEY_40_BYTES;
+		break;
 	case 48:
 		h->cmp_jump_table_idx = KEY_48_BYTES;
 		break;
@@ -361,7 +584,7 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		h->cmp_jump_table_idx = KEY_128_BYTES;
 		break;
 	default:
-		/* If key is not multiple of 16, use generic memcmp */
+		/* Other key sizes use generic memcmp */
 		h->cmp_jump_table_idx = KEY_OTHER_BYTES;
 	}
 #else
@@ -383,7 +606,7 @@ rte_hash_create(const struct rte_hash_parameters *params)
 #endif
 	/* Setup hash context */
 	strlcpy(h->name, params->name, sizeof(h->name));
-	h->entries = params->entries;
+	h->entries = entries;
 	h->key_len = params->key_len;
 	h->key_entry_size = key_entry_size;
 	h->hash_func_init_val = params->hash_func_init_val;
@@ -392,14 +615,18 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	h->bucket_bitmask = h->num_buckets - 1;
 	h->buckets = buckets;
 	h->buckets_ext = buckets_ext;
+	h->inline_bkts = inline_bkts;
 	h->free_ext_bkts = r_ext;
 	h->hash_func = (params->hash_func == NULL) ?
 		default_hash_func : params->hash_func;
 	h->key_store = k;
+	h->key_seg_base = UINT32_MAX;
 	h->free_slots = r;
 	h->ext_bkt_to_free = ext_bkt_to_free;
 	h->tbl_chng_cnt = tbl_chng_cnt;
 	*h->tbl_chng_cnt = 0;
+	h->key_ts = key_ts;
+	h->age_next_bkt = 0;
 	h->hw_trans_mem_support = hw_trans_mem_support;
 	h->use_local_cache = use_local_cache;
 	h->readwrite_concur_support = readwrite_concur_support;
@@ -408,7 +635,35 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	h->no_free_on_del = no_free_on_del;
 	h->readwrite_concur_lf_support = readwrite_concur_lf_support;
 
+	if (rparams != NULL) {
+		rs->cur = gen;
+		rs->max_entries = rparams->max_entries;
+		rs->grow_load = rparams->grow_load != 0 ?
+			rparams->grow_load : RTE_HASH_RESIZE_GROW_LOAD;
+		rs->grow_thresh = (uint64_t)entries * rs->grow_load / 100;
+		rs->migrate_budget = rparams->migrate_budget != 0 ?
+			rparams->migrate_budget :
+			RTE_HASH_RESIZE_MIGRATE_BUDGET;
+		rs->socket_id = params->socket_id;
+		rs->multi_writer = !!(params->extra_flag &
+				RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD);
+		rte_spinlock_init(&rs->lock);
+		rs->v = rparams->v;
+		h->buckets = gen->buckets;
+		h->key_seg_base = num_key_slots;
+		h->key_seg_shift = rte_bsf32(entries);
+		h->key_segs = rs->key_chunks;
+		h->resize = rs;
+	}
+
 #if defined(RTE_ARCH_X86)
+#ifdef CC_CUCKOO_HASH_AVX512_SUPPORT
+	if (!(params->extra_flag & RTE_HASH_EXTRA_FLAGS_NO_AVX512) &&
+			rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) > 0 &&
+			rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512BW) > 0)
+		h->sig_cmp_fn = RTE_HASH_COMPARE_AVX512;
+	else
+#endif
 	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_SSE2))
 		h->sig_cmp_fn = RTE_HASH_COMPARE_SSE;
 	else
@@ -432,30 +687,90 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		rte_rwlock_init(h->readwrite_lock);
 	}
 
+	if (bkt_lock_support) {
+		num_bkt_locks = RTE_MIN(num_buckets, RTE_HASH_BKT_LOCKS_MAX);
+		h->bkt_locks = rte_zmalloc_socket(NULL,
+				num_bkt_locks * sizeof(struct rte_hash_bkt_lock),
+				RTE_CACHE_LINE_SIZE, params->socket_id);
+		if (h->bkt_locks == NULL)
+			goto err_unlock;
+
+		for (i = 0; i < num_bkt_locks; i++)
+			rte_spinlock_init(&h->bkt_locks[i].lock);
+		h->bkt_lock_mask = num_bkt_locks - 1;
+	}
+
 	/* Populate free slots ring. Entry zero is reserved for key misses. */
 	for (i = 1; i < num_key_slots; i++)
 		rte_ring_sp_enqueue(r, (void *)((uintptr_t) i));
 
 	te->data = (void *) h;
-	TAILQ_INSERT_TAIL(hash_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(hash_list, te, next);
 	rte_mcfg_tailq_write_unlock();
 
 	return h;
 err_unlock:
 	rte_mcfg_tailq_write_unlock();
 err:
-	rte_ring_free(r);
+	if (rparams != NULL)
+		rte_free(r);
+	else
+		rte_ring_free(r);
 	rte_ring_free(r_ext);
 	rte_free(te);
 	rte_free(h);
 	rte_free(buckets);
+	rte_free(gen);
+	rte_free(rs);
 	rte_free(buckets_ext);
+	rte_free(inline_bkts);
 	rte_free(k);
 	rte_free(tbl_chng_cnt);
 	rte_free(ext_bkt_to_free);
+	rte_free(key_ts);
 	return NULL;
 }
 
+struct rte_hash *
+rte_hash_create(const struct rte_hash_parameters *params)
+{
+	return __rte_hash_create(params, NULL);
+}
+
+struct rte_hash *
+rte_hash_create_resizable(const struct rte_hash_parameters *params,
+		const struct rte_hash_resize_params *rparams)
+{
+	if (params == NULL || rparams == NULL) {
+		rte_errno = EINVAL;
+		RTE_LOG(ERR, HASH, "rte_hash_create_resizable has no "
+			"parameters\n");
+		return NULL;
+	}
+	return __rte_hash_create(params, rparams);
+}
+
+/* Free all the memory of a resizable table, but the hash structure */
+static void
+rte_hash_resize_free(struct rte_hash *h)
+{
+	struct rte_hash_resize *rs = h->resize;
+	uint32_t i;
+
+	for (i = 0; i < rs->nb_retired; i++)
+		rte_free(rs->retired[i].gen);
+	for (i = 0; i < rs->nb_key_chunks; i++)
+		rte_free(rs->key_chunks[i]);
+	rte_free(rs->old);
+	rte_free(rs->cur);
+	rte_free(h->free_slots);
+	rte_free(rs);
+
+	h->buckets = NULL;
+	h->free_slots = NULL;
+	h->resize = NULL;
+}
+
 void
 rte_hash_free(struct rte_hash *h)
 {
@@ -470,7 +785,7 @@ rte_hash_free(struct rte_hash *h)
 	rte_mcfg_tailq_write_lock();
 
 	/* find out tailq entry */
-	TAILQ_FOREACH(te, hash_list, next) {
+	RTE_TAILQ_FOREACH(te, hash_list, next) {
 		if (te->data == (void *) h)
 			break;
 	}
@@ -480,21 +795,26 @@ rte_hash_free(struct rte_hash *h)
 		return;
 	}
 
-	TAILQ_REMOVE(hash_list, te, next);
+	RTE_TAILQ_REMOVE(hash_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
+	if (h->resize != NULL)
+		rte_hash_resize_free(h);
 	if (h->use_local_cache)
 		rte_free(h->local_free_slots);
 	if (h->writer_takes_lock)
 		rte_free(h->readwrite_lock);
+	rte_free(h->bkt_locks);
 	rte_ring_free(h->free_slots);
 	rte_ring_free(h->free_ext_bkts);
 	rte_free(h->key_store);
 	rte_free(h->buckets);
 	rte_free(h->buckets_ext);
+	rte_free(h->inline_bkts);
 	rte_free(h->tbl_chng_cnt);
 	rte_free(h->ext_bkt_to_free);
+	rte_free(h->key_ts);
 	rte_free(h);
 	rte_free(te);
 }
@@ -567,6 +887,172 @@ __hash_rw_reader_unlock(const struct rte_hash *h)
 		rte_rwlock_read_unlock(h->readwrite_lock);
 }
 
+/* Bucket locks, taken by the writers of a multi-writer table in the order
+ * of the lock indexes, so that writers changing different buckets proceed
+ * in parallel. The table lock is taken instead if there are none.
+ */
+static inline void
+__hash_bkt_writer_lock(const struct rte_hash *h,
+		const struct rte_hash_bucket *prim_bkt,
+		const struct rte_hash_bucket *sec_bkt)
+{
+	uint32_t prim_lock, sec_lock;
+
+	if (h->bkt_locks == NULL) {
+		__hash_rw_writer_lock(h);
+		return;
+	}
+
+	prim_lock = (prim_bkt - h->buckets) & h->bkt_lock_mask;
+	sec_lock = (sec_bkt - h->buckets) & h->bkt_lock_mask;
+	rte_spinlock_lock(&h->bkt_locks[RTE_MIN(prim_lock, sec_lock)].lock);
+	if (prim_lock != sec_lock)
+		rte_spinlock_lock(
+			&h->bkt_locks[RTE_MAX(prim_lock, sec_lock)].lock);
+}
+
+static inline void
+__hash_bkt_writer_unlock(const struct rte_hash *h,
+		const struct rte_hash_bucket *prim_bkt,
+		const struct rte_hash_bucket *sec_bkt)
+{
+	uint32_t prim_lock, sec_lock;
+
+	if (h->bkt_locks == NULL) {
+		__hash_rw_writer_unlock(h);
+		return;
+	}
+
+	prim_lock = (prim_bkt - h->buckets) & h->bkt_lock_mask;
+	sec_lock = (sec_bkt - h->buckets) & h->bkt_lock_mask;
+	rte_spinlock_unlock(&h->bkt_locks[prim_lock].lock);
+	if (prim_lock != sec_lock)
+		rte_spinlock_unlock(&h->bkt_locks[sec_lock].lock);
+}
+
+/* Number of locks returned by __hash_bkt_path_lock() when it takes them
+ * all, as the table lock of the bucket locked writers.
+ */
+#define BKT_PATH_ALL_LOCKS	UINT32_MAX
+
+/* Lock all the buckets of a cuckoo path ending at @leaf, and @alt_bkt.
+ * Return the number of locks taken, stored in @locks, or
+ * BKT_PATH_ALL_LOCKS if there are too many of them and every bucket lock
+ * was taken instead.
+ */
+static inline unsigned int
+__hash_bkt_path_lock(const struct rte_hash *h, const struct queue_node *leaf,
+		const struct rte_hash_bucket *alt_bkt, uint32_t *locks)
+{
+	const struct queue_node *node;
+	unsigned int i, j, n = 0;
+	uint32_t lock;
+
+	if (h->bkt_locks == NULL) {
+		__hash_rw_writer_lock(h);
+		return 1;
+	}
+
+	locks[n++] = (alt_bkt - h->buckets) & h->bkt_lock_mask;
+	for (node = leaf; node != NULL; node = node->prev) {
+		if (n == RTE_HASH_BKT_PATH_MAX) {
+			/* In index order too, like rte_hash_reset() */
+			for (i = 0; i <= h->bkt_lock_mask; i++)
+				rte_spinlock_lock(&h->bkt_locks[i].lock);
+			return BKT_PATH_ALL_LOCKS;
+		}
+		locks[n++] = node->cur_bkt_idx & h->bkt_lock_mask;
+	}
+
+	/* Sort the locks and drop the duplicates */
+	for (i = 1; i < n; i++) {
+		lock = locks[i];
+		for (j = i; j > 0 && locks[j - 1] > lock; j--)
+			locks[j] = locks[j - 1];
+		locks[j] = lock;
+	}
+	for (i = 1, j = 1; i < n; i++)
+		if (locks[i] != locks[j - 1])
+			locks[j++] = locks[i];
+	n = j;
+
+	for (i = 0; i < n; i++)
+		rte_spinlock_lock(&h->bkt_locks[locks[i]].lock);
+
+	return n;
+}
+
+static inline void
+__hash_bkt_path_unlock(const struct rte_hash *h, const uint32_t *locks,
+		unsigned int n)
+{
+	unsigned int i;
+
+	if (h->bkt_locks == NULL) {
+		__hash_rw_writer_unlock(h);
+		return;
+	}
+
+	if (n == BKT_PATH_ALL_LOCKS) {
+		for (i = 0; i <= h->bkt_lock_mask; i++)
+			rte_spinlock_unlock(&h->bkt_locks[i].lock);
+		return;
+	}
+
+	for (i = 0; i < n; i++)
+		rte_spinlock_unlock(&h->bkt_locks[locks[i]].lock);
+}
+
+/* Inform the lock-free readers that a key is moving */
+static inline void
+__hash_tbl_chng_cnt_inc(const struct rte_hash *h)
+{
+	if (h->bkt_locks != NULL)
+		/* Writers moving keys in other buckets may do the same */
+		__atomic_fetch_add(h->tbl_chng_cnt, 1, __ATOMIC_RELEASE);
+	else
+		/* Since there is one writer, load acquire on
+		 * tbl_chng_cnt is not required.
+		 */
+		__atomic_store_n(h->tbl_chng_cnt, *h->tbl_chng_cnt + 1,
+				__ATOMIC_RELEASE);
+}
+
+/* Lock of the writers of a resizable table */
+static inline void
+__hash_resize_lock(const struct rte_hash *h)
+{
+	if (h->resize->multi_writer)
+		rte_spinlock_lock(&h->resize->lock);
+}
+
+static inline void
+__hash_resize_unlock(const struct rte_hash *h)
+{
+	if (h->resize->multi_writer)
+		rte_spinlock_unlock(&h->resize->lock);
+}
+
+/* Empty the key store memory added by the resizes, and drop the bucket
+ * arrays being replaced: there are no readers during a reset.
+ */
+static void
+rte_hash_resize_reset(struct rte_hash *h)
+{
+	struct rte_hash_resize *rs = h->resize;
+	uint32_t i, seg_entries = 1 << h->key_seg_shift;
+
+	for (i = 0; i < rs->nb_key_chunks; i++)
+		memset(rs->key_chunks[i], 0,
+			(size_t)h->key_entry_size * (seg_entries << i));
+	for (i = 0; i < rs->nb_retired; i++)
+		rte_free(rs->retired[i].gen);
+	rs->nb_retired = 0;
+	rte_free(rs->old);
+	rs->old = NULL;
+	rs->migrate_next = 0;
+}
+
 void
 rte_hash_reset(struct rte_hash *h)
 {
@@ -576,9 +1062,18 @@ rte_hash_reset(struct rte_hash *h)
 		return;
 
 	__hash_rw_writer_lock(h);
+	for (i = 0; h->bkt_locks != NULL && i <= h->bkt_lock_mask; i++)
+		rte_spinlock_lock(&h->bkt_locks[i].lock);
+	if (h->resize != NULL)
+		rte_hash_resize_reset(h);
 	memset(h->buckets, 0, h->num_buckets * sizeof(struct rte_hash_bucket));
-	memset(h->key_store, 0, h->key_entry_size * (h->entries + 1));
+	if (h->inline_bkts != NULL)
+		memset(h->inline_bkts, 0, h->num_buckets *
+				sizeof(struct rte_hash_inline_bkt));
+	memset(h->key_store, 0, h->key_entry_size *
+			RTE_MIN(h->entries + 1, h->key_seg_base));
 	*h->tbl_chng_cnt = 0;
+	h->age_next_bkt = 0;
 
 	/* reset the free ring */
 	rte_ring_reset(h->free_slots);
@@ -612,6 +1107,8 @@ rte_hash_reset(struct rte_hash *h)
 		for (i = 0; i < RTE_MAX_LCORE; i++)
 			h->local_free_slots[i].len = 0;
 	}
+	for (i = 0; h->bkt_locks != NULL && i <= h->bkt_lock_mask; i++)
+		rte_spinlock_unlock(&h->bkt_locks[i].lock);
 	__hash_rw_writer_unlock(h);
 }
 
@@ -640,13 +1137,16 @@ search_and_update(const struct rte_hash *h, void *data, const void *key,
 	struct rte_hash_bucket *bkt, uint16_t sig)
 {
 	int i;
-	struct rte_hash_key *k, *keys = h->key_store;
+	struct rte_hash_key *k;
 
 	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
 		if (bkt->sig_current[i] == sig) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					bkt->key_idx[i] * h->key_entry_size);
+			k = get_key_slot(h, bkt->key_idx[i]);
 			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
+				if (h->key_ts != NULL)
+					__atomic_store_n(
+						&h->key_ts[bkt->key_idx[i]],
+						rte_rdtsc(), __ATOMIC_RELAXED);
 				/* The store to application data at *data
 				 * should not leak after the store to pdata
 				 * in the key store. i.e. pdata is the guard
@@ -656,6 +1156,10 @@ search_and_update(const struct rte_hash *h, void *data, const void *key,
 				__atomic_store_n(&k->pdata,
 					data,
 					__ATOMIC_RELEASE);
+				if (h->inline_bkts != NULL)
+					__atomic_store_n(
+						&get_inline_bkt(h, bkt)->pdata[i],
+						data, __ATOMIC_RELEASE);
 				/*
 				 * Return index where key is stored,
 				 * subtracting the first dummy index
@@ -684,13 +1188,13 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 	struct rte_hash_bucket *cur_bkt;
 	int32_t ret;
 
-	__hash_rw_writer_lock(h);
+	__hash_bkt_writer_lock(h, prim_bkt, sec_bkt);
 	/* Check if key was inserted after last check but before this
 	 * protected region in case of inserting duplicated keys.
 	 */
 	ret = search_and_update(h, data, key, prim_bkt, sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_bkt_writer_unlock(h, prim_bkt, sec_bkt);
 		*ret_val = ret;
 		return 1;
 	}
@@ -698,7 +1202,7 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_bkt_writer_unlock(h, prim_bkt, sec_bkt);
 			*ret_val = ret;
 			return 1;
 		}
@@ -711,6 +1215,8 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 		/* Check if slot is available */
 		if (likely(prim_bkt->key_idx[i] == EMPTY_SLOT)) {
 			prim_bkt->sig_current[i] = sig;
+			if (h->inline_bkts != NULL)
+				inline_entry_set(h, prim_bkt, i, key, data);
 			/* Store to signature and key should not
 			 * leak after the store to key_idx. i.e.
 			 * key_idx is the guard variable for signature
@@ -722,7 +1228,7 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 			break;
 		}
 	}
-	__hash_rw_writer_unlock(h);
+	__hash_bkt_writer_unlock(h, prim_bkt, sec_bkt);
 
 	if (i != RTE_HASH_BUCKET_ENTRIES)
 		return 0;
@@ -750,13 +1256,15 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	struct queue_node *prev_node, *curr_node = leaf;
 	struct rte_hash_bucket *prev_bkt, *curr_bkt = leaf->bkt;
 	uint32_t prev_slot, curr_slot = leaf_slot;
+	uint32_t locks[RTE_HASH_BKT_PATH_MAX];
+	unsigned int nb_locks;
 	int32_t ret;
 
-	__hash_rw_writer_lock(h);
+	nb_locks = __hash_bkt_path_lock(h, leaf, alt_bkt, locks);
 
 	/* In case empty slot was gone before entering protected region */
 	if (curr_bkt->key_idx[curr_slot] != EMPTY_SLOT) {
-		__hash_rw_writer_unlock(h);
+		__hash_bkt_path_unlock(h, locks, nb_locks);
 		return -1;
 	}
 
@@ -765,7 +1273,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	 */
 	ret = search_and_update(h, data, key, bkt, sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_bkt_path_unlock(h, locks, nb_locks);
 		*ret_val = ret;
 		return 1;
 	}
@@ -773,7 +1281,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	FOR_EACH_BUCKET(cur_bkt, alt_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_bkt_path_unlock(h, locks, nb_locks);
 			*ret_val = ret;
 			return 1;
 		}
@@ -794,7 +1302,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			__atomic_store_n(&curr_bkt->key_idx[curr_slot],
 				EMPTY_SLOT,
 				__ATOMIC_RELEASE);
-			__hash_rw_writer_unlock(h);
+			__hash_bkt_path_unlock(h, locks, nb_locks);
 			return -1;
 		}
 
@@ -802,12 +1310,8 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			/* Inform the previous move. The current move need
 			 * not be informed now as the current bucket entry
 			 * is present in both primary and secondary.
-			 * Since there is one writer, load acquires on
-			 * tbl_chng_cnt are not required.
 			 */
-			__atomic_store_n(h->tbl_chng_cnt,
-					 *h->tbl_chng_cnt + 1,
-					 __ATOMIC_RELEASE);
+			__hash_tbl_chng_cnt_inc(h);
 			/* The store to sig_current should not
 			 * move above the store to tbl_chng_cnt.
 			 */
@@ -820,6 +1324,10 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 		 */
 		curr_bkt->sig_current[curr_slot] =
 			prev_bkt->sig_current[prev_slot];
+		if (h->inline_bkts != NULL)
+			inline_entry_set(h, curr_bkt, curr_slot,
+				get_inline_bkt(h, prev_bkt)->key[prev_slot],
+				get_inline_bkt(h, prev_bkt)->pdata[prev_slot]);
 		/* Release the updated bucket entry */
 		__atomic_store_n(&curr_bkt->key_idx[curr_slot],
 			prev_bkt->key_idx[prev_slot],
@@ -834,12 +1342,8 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 		/* Inform the previous move. The current move need
 		 * not be informed now as the current bucket entry
 		 * is present in both primary and secondary.
-		 * Since there is one writer, load acquires on
-		 * tbl_chng_cnt are not required.
 		 */
-		__atomic_store_n(h->tbl_chng_cnt,
-				 *h->tbl_chng_cnt + 1,
-				 __ATOMIC_RELEASE);
+		__hash_tbl_chng_cnt_inc(h);
 		/* The store to sig_current should not
 		 * move above the store to tbl_chng_cnt.
 		 */
@@ -847,12 +1351,14 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	}
 
 	curr_bkt->sig_current[curr_slot] = sig;
+	if (h->inline_bkts != NULL)
+		inline_entry_set(h, curr_bkt, curr_slot, key, data);
 	/* Release the new bucket entry */
 	__atomic_store_n(&curr_bkt->key_idx[curr_slot],
 			 new_idx,
 			 __ATOMIC_RELEASE);
 
-	__hash_rw_writer_unlock(h);
+	__hash_bkt_path_unlock(h, locks, nb_locks);
 
 	return 0;
 
@@ -916,13 +1422,13 @@ rte_hash_cuckoo_make_space_mw(const struct rte_hash *h,
 }
 
 static inline int32_t
-__rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
+__rte_hash_add_key_with_hash_main(const struct rte_hash *h, const void *key,
 						hash_sig_t sig, void *data)
 {
 	uint16_t short_sig;
 	uint32_t prim_bucket_idx, sec_bucket_idx;
 	struct rte_hash_bucket *prim_bkt, *sec_bkt, *cur_bkt;
-	struct rte_hash_key *new_k, *keys = h->key_store;
+	struct rte_hash_key *new_k;
 	void *slot_id = NULL;
 	void *ext_bkt_id = NULL;
 	uint32_t new_idx, bkt_id;
@@ -943,10 +1449,10 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	rte_prefetch0(sec_bkt);
 
 	/* Check if key is already inserted in primary location */
-	__hash_rw_writer_lock(h);
+	__hash_bkt_writer_lock(h, prim_bkt, sec_bkt);
 	ret = search_and_update(h, data, key, prim_bkt, short_sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_bkt_writer_unlock(h, prim_bkt, sec_bkt);
 		return ret;
 	}
 
@@ -954,12 +1460,12 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, short_sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_bkt_writer_unlock(h, prim_bkt, sec_bkt);
 			return ret;
 		}
 	}
 
-	__hash_rw_writer_unlock(h);
+	__hash_bkt_writer_unlock(h, prim_bkt, sec_bkt);
 
 	/* Did not find a match, so get a new slot for storing the new key */
 	if (h->use_local_cache) {
@@ -987,8 +1493,8 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 		}
 	}
 
-	new_k = RTE_PTR_ADD(keys, (uintptr_t)slot_id * h->key_entry_size);
 	new_idx = (uint32_t)((uintptr_t) slot_id);
+	new_k = get_key_slot(h, new_idx);
 	/* The store to application data (by the application) at *data should
 	 * not leak after the store of pdata in the key store. i.e. pdata is
 	 * the guard variable. Release the application data to the readers.
@@ -998,6 +1504,9 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 		__ATOMIC_RELEASE);
 	/* Copy key */
 	memcpy(new_k->key, key, h->key_len);
+	if (h->key_ts != NULL)
+		__atomic_store_n(&h->key_ts[new_idx], rte_rdtsc(),
+				__ATOMIC_RELAXED);
 
 	/* Find an empty slot and insert */
 	ret = rte_hash_cuckoo_insert_mw(h, prim_bkt, sec_bkt, key, data,
@@ -1105,70 +1614,338 @@ failure:
 
 }
 
-int32_t
-rte_hash_add_key_with_hash(const struct rte_hash *h,
-			const void *key, hash_sig_t sig)
+/* Get the primary and secondary buckets of a hash in a bucket array */
+static inline void
+get_gen_buckets(const struct rte_hash_gen *gen, hash_sig_t sig,
+		struct rte_hash_bucket **prim_bkt,
+		struct rte_hash_bucket **sec_bkt)
 {
-	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_add_key_with_hash(h, key, sig, 0);
-}
+	uint32_t prim_bucket_idx = sig & gen->bucket_bitmask;
 
-int32_t
-rte_hash_add_key(const struct rte_hash *h, const void *key)
-{
-	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_add_key_with_hash(h, key, rte_hash_hash(h, key), 0);
+	*prim_bkt = &gen->buckets[prim_bucket_idx];
+	*sec_bkt = &gen->buckets[(prim_bucket_idx ^ get_short_sig(sig)) &
+			gen->bucket_bitmask];
 }
 
-int
-rte_hash_add_key_with_hash_data(const struct rte_hash *h,
-			const void *key, hash_sig_t sig, void *data)
+/* Free the replaced bucket arrays the readers are done with */
+static void
+rte_hash_resize_reclaim(struct rte_hash_resize *rs)
 {
-	int ret;
+	uint32_t i, n = 0;
 
-	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	ret = __rte_hash_add_key_with_hash(h, key, sig, data);
-	if (ret >= 0)
-		return 0;
-	else
-		return ret;
+	if (rs->v == NULL)
+		return;
+
+	for (i = 0; i < rs->nb_retired; i++) {
+		if (rte_rcu_qsbr_check(rs->v, rs->retired[i].token, false))
+			rte_free(rs->retired[i].gen);
+		else
+			rs->retired[n++] = rs->retired[i];
+	}
+	rs->nb_retired = n;
 }
 
-int
-rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data)
+/*
+ * Double the entries of a resizable table. The current bucket array
+ * becomes the old one, to be migrated to a new array twice as large.
+ * The table fields describing the buckets and the free slots are those
+ * of the writers, which hold the lock: they follow the current array.
+ */
+static int
+rte_hash_resize_grow(const struct rte_hash *h)
 {
-	int ret;
-
-	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	struct rte_hash *wh = (struct rte_hash *)(uintptr_t)h;
+	struct rte_hash_resize *rs = h->resize;
+	uint32_t entries = h->entries << 1;
+	struct rte_hash_gen *gen;
+	struct rte_ring *r;
+	void *chunk, *slot_id;
+	uint32_t i;
+
+	if (rs->old != NULL || entries > rs->max_entries ||
+			rs->nb_key_chunks == RTE_HASH_RESIZE_MAX_GROW)
+		return -ENOSPC;
+
+	gen = rte_hash_gen_alloc(entries / RTE_HASH_BUCKET_ENTRIES,
+			rs->socket_id);
+	chunk = rte_zmalloc_socket(NULL,
+			(size_t)h->entries * h->key_entry_size,
+			RTE_CACHE_LINE_SIZE, rs->socket_id);
+	r = rte_hash_resize_ring_alloc(h->free_slots->name, entries + 1,
+			rs->socket_id);
+	if (gen == NULL || chunk == NULL || r == NULL) {
+		RTE_LOG(ERR, HASH, "%s: memory allocation failed\n",
+			__func__);
+		rte_free(gen);
+		rte_free(chunk);
+		rte_free(r);
+		return -ENOMEM;
+	}
+
+	/* The key slots of the new entries follow the existing ones. The
+	 * segment is visible to the readers before any of its slots is
+	 * given to a key, through the ring and the key index release.
+	 */
+	rs->key_chunks[rs->nb_key_chunks++] = chunk;
+	while (rte_ring_sc_dequeue(h->free_slots, &slot_id) == 0)
+		rte_ring_sp_enqueue(r, slot_id);
+	for (i = h->entries + 1; i <= entries; i++)
+		rte_ring_sp_enqueue(r, (void *)((uintptr_t)i));
+	rte_free(h->free_slots);
+	wh->free_slots = r;
+	wh->entries = entries;
+	rs->grow_thresh = (uint64_t)entries * rs->grow_load / 100;
+
+	/* Readers load cur before old: when they see the new array, they
+	 * also see the old one, until all its keys are migrated.
+	 */
+	__atomic_store_n(&rs->old, rs->cur, __ATOMIC_RELEASE);
+	__atomic_store_n(&rs->cur, gen, __ATOMIC_RELEASE);
+	rs->migrate_next = 0;
+	wh->buckets = gen->buckets;
+	wh->num_buckets = gen->num_buckets;
+	wh->bucket_bitmask = gen->bucket_bitmask;
 
-	ret = __rte_hash_add_key_with_hash(h, key, rte_hash_hash(h, key), data);
-	if (ret >= 0)
-		return 0;
-	else
-		return ret;
+	return 0;
 }
 
-/* Search one bucket to find the match key - uses rw lock */
-static inline int32_t
-search_one_bucket_l(const struct rte_hash *h, const void *key,
-		uint16_t sig, void **data,
-		const struct rte_hash_bucket *bkt)
+/* Move the keys of a bucket of the old array to the current one. */
+static int
+rte_hash_resize_migrate_bucket(const struct rte_hash *h,
+		struct rte_hash_bucket *bkt)
 {
-	int i;
-	struct rte_hash_key *k, *keys = h->key_store;
+	uint32_t prim_bucket_idx, sec_bucket_idx;
+	struct rte_hash_bucket *prim_bkt, *sec_bkt;
+	struct rte_hash_key *k;
+	const void *key;
+	uint32_t key_idx, moved = 0;
+	uint16_t short_sig;
+	hash_sig_t sig;
+	int32_t ret_val;
+	unsigned int i;
+	int ret = 0;
 
 	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
-		if (bkt->sig_current[i] == sig &&
-				bkt->key_idx[i] != EMPTY_SLOT) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					bkt->key_idx[i] * h->key_entry_size);
+		key_idx = bkt->key_idx[i];
+		if (key_idx == EMPTY_SLOT)
+			continue;
 
-			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
-				if (data != NULL)
-					*data = k->pdata;
-				/*
-				 * Return index where key is stored,
-				 * subtracting the first dummy index
+		k = get_key_slot(h, key_idx);
+		key = k->key;
+		sig = rte_hash_hash(h, key);
+		short_sig = get_short_sig(sig);
+		prim_bucket_idx = get_prim_bucket_index(h, sig);
+		sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx,
+				short_sig);
+		prim_bkt = &h->buckets[prim_bucket_idx];
+		sec_bkt = &h->buckets[sec_bucket_idx];
+
+		/* The key keeps its index, so its position */
+		ret = rte_hash_cuckoo_insert_mw(h, prim_bkt, sec_bkt, key,
+				k->pdata, short_sig, key_idx, &ret_val);
+		if (ret == -1)
+			ret = rte_hash_cuckoo_make_space_mw(h, prim_bkt,
+					sec_bkt, key, k->pdata, short_sig,
+					prim_bucket_idx, key_idx, &ret_val);
+		if (ret == -ENOSPC)
+			ret = rte_hash_cuckoo_make_space_mw(h, sec_bkt,
+					prim_bkt, key, k->pdata, short_sig,
+					sec_bucket_idx, key_idx, &ret_val);
+		if (ret < 0)
+			break;
+		moved |= 1 << i;
+	}
+
+	if (moved == 0)
+		return ret < 0 ? -ENOSPC : 0;
+
+	if (h->readwrite_concur_lf_support) {
+		/* Inform the readers that the keys are moving out of
+		 * the old array. Since there is one writer, load acquire
+		 * on tbl_chng_cnt is not required.
+		 */
+		__atomic_store_n(h->tbl_chng_cnt,
+				 *h->tbl_chng_cnt + 1,
+				 __ATOMIC_RELEASE);
+		/* The store to sig_current should not
+		 * move above the store to tbl_chng_cnt.
+		 */
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+	}
+
+	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+		if ((moved & (1 << i)) == 0)
+			continue;
+		bkt->sig_current[i] = NULL_SIGNATURE;
+		__atomic_store_n(&bkt->key_idx[i], EMPTY_SLOT,
+				__ATOMIC_RELEASE);
+	}
+
+	return ret < 0 ? -ENOSPC : 0;
+}
+
+/*
+ * Migrate up to budget buckets of the old array, and retire it when it is
+ * empty. Returns the number of buckets left to migrate, or -ENOSPC if a
+ * key could not be inserted in the current array.
+ */
+static int32_t
+rte_hash_resize_migrate(const struct rte_hash *h, uint32_t budget)
+{
+	struct rte_hash_resize *rs = h->resize;
+	struct rte_hash_gen *old = rs->old;
+	int ret;
+
+	if (old == NULL)
+		return 0;
+
+	while (budget != 0 && rs->migrate_next < old->num_buckets) {
+		ret = rte_hash_resize_migrate_bucket(h,
+				&old->buckets[rs->migrate_next]);
+		if (ret != 0)
+			return ret;
+		rs->migrate_next++;
+		budget--;
+	}
+	if (rs->migrate_next < old->num_buckets)
+		return old->num_buckets - rs->migrate_next;
+
+	__atomic_store_n(&rs->old, NULL, __ATOMIC_RELEASE);
+
+	/* Without lock free readers, nobody can be using the array. */
+	if (!h->readwrite_concur_lf_support) {
+		rte_free(old);
+		return 0;
+	}
+	rs->retired[rs->nb_retired].gen = old;
+	rs->retired[rs->nb_retired].token =
+		rs->v != NULL ? rte_rcu_qsbr_start(rs->v) : 0;
+	rs->nb_retired++;
+	rte_hash_resize_reclaim(rs);
+
+	return 0;
+}
+
+/* Search a key in a bucket array and update its data */
+static inline int32_t
+search_gen_and_update(const struct rte_hash *h, const struct rte_hash_gen *gen,
+		void *data, const void *key, hash_sig_t sig)
+{
+	struct rte_hash_bucket *prim_bkt, *sec_bkt;
+	int32_t ret;
+
+	get_gen_buckets(gen, sig, &prim_bkt, &sec_bkt);
+	ret = search_and_update(h, data, key, prim_bkt, get_short_sig(sig));
+	if (ret != -1)
+		return ret;
+	return search_and_update(h, data, key, sec_bkt, get_short_sig(sig));
+}
+
+static inline int32_t
+__rte_hash_add_key_with_hash_rs(const struct rte_hash *h, const void *key,
+						hash_sig_t sig, void *data)
+{
+	struct rte_hash_resize *rs = h->resize;
+	int32_t ret;
+
+	__hash_resize_lock(h);
+
+	if (rs->old != NULL)
+		rte_hash_resize_migrate(h, rs->migrate_budget);
+	else if (rte_hash_count(h) >= (int32_t)rs->grow_thresh)
+		rte_hash_resize_grow(h);
+
+	/* Keys not migrated yet are updated in the old array */
+	if (rs->old != NULL) {
+		ret = search_gen_and_update(h, rs->old, data, key, sig);
+		if (ret != -1)
+			goto out;
+	}
+
+	ret = __rte_hash_add_key_with_hash_main(h, key, sig, data);
+
+	/* No key slot or no bucket space left: grow now */
+	if (ret == -ENOSPC && rte_hash_resize_migrate(h, UINT32_MAX) == 0 &&
+			rte_hash_resize_grow(h) == 0)
+		ret = __rte_hash_add_key_with_hash_main(h, key, sig, data);
+out:
+	__hash_resize_unlock(h);
+	return ret;
+}
+
+static inline int32_t
+__rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
+						hash_sig_t sig, void *data)
+{
+	if (h->resize != NULL)
+		return __rte_hash_add_key_with_hash_rs(h, key, sig, data);
+	else
+		return __rte_hash_add_key_with_hash_main(h, key, sig, data);
+}
+
+int32_t
+rte_hash_add_key_with_hash(const struct rte_hash *h,
+			const void *key, hash_sig_t sig)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	return __rte_hash_add_key_with_hash(h, key, sig, 0);
+}
+
+int32_t
+rte_hash_add_key(const struct rte_hash *h, const void *key)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	return __rte_hash_add_key_with_hash(h, key, rte_hash_hash(h, key), 0);
+}
+
+int
+rte_hash_add_key_with_hash_data(const struct rte_hash *h,
+			const void *key, hash_sig_t sig, void *data)
+{
+	int ret;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	ret = __rte_hash_add_key_with_hash(h, key, sig, data);
+	if (ret >= 0)
+		return 0;
+	else
+		return ret;
+}
+
+int
+rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data)
+{
+	int ret;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+
+	ret = __rte_hash_add_key_with_hash(h, key, rte_hash_hash(h, key), data);
+	if (ret >= 0)
+		return 0;
+	else
+		return ret;
+}
+
+/* Search one bucket to find the match key - uses rw lock */
+static inline int32_t
+search_one_bucket_l(const struct rte_hash *h, const void *key,
+		uint16_t sig, void **data,
+		const struct rte_hash_bucket *bkt)
+{
+	int i;
+	struct rte_hash_key *k;
+
+	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+		if (bkt->sig_current[i] == sig &&
+				bkt->key_idx[i] != EMPTY_SLOT) {
+			k = get_key_slot(h, bkt->key_idx[i]);
+
+			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
+				if (data != NULL)
+					*data = k->pdata;
+				/*
+				 * Return index where key is stored,
+				 * subtracting the first dummy index
 				 */
 				return bkt->key_idx[i] - 1;
 			}
@@ -1184,7 +1961,7 @@ search_one_bucket_lf(const struct rte_hash *h, const void *key, uint16_t sig,
 {
 	int i;
 	uint32_t key_idx;
-	struct rte_hash_key *k, *keys = h->key_store;
+	struct rte_hash_key *k;
 
 	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
 		/* Signature comparison is done before the acquire-load
@@ -1198,8 +1975,7 @@ search_one_bucket_lf(const struct rte_hash *h, const void *key, uint16_t sig,
 			key_idx = __atomic_load_n(&bkt->key_idx[i],
 					  __ATOMIC_ACQUIRE);
 			if (key_idx != EMPTY_SLOT) {
-				k = (struct rte_hash_key *) ((char *)keys +
-						key_idx * h->key_entry_size);
+				k = get_key_slot(h, key_idx);
 
 				if (rte_hash_cmp_eq(key, k->key, h) == 0) {
 					if (data != NULL) {
@@ -1321,11 +2097,179 @@ __rte_hash_lookup_with_hash_lf(const struct rte_hash *h, const void *key,
 	return -ENOENT;
 }
 
+static inline int32_t
+__rte_hash_lookup_with_hash_rs(const struct rte_hash *h, const void *key,
+					hash_sig_t sig, void **data)
+{
+	const struct rte_hash_resize *rs = h->resize;
+	struct rte_hash_bucket *prim_bkt, *sec_bkt;
+	const struct rte_hash_gen *gen[2];
+	uint32_t cnt_b, cnt_a;
+	unsigned int g;
+	int ret;
+	uint16_t short_sig;
+
+	short_sig = get_short_sig(sig);
+
+	do {
+		cnt_b = __atomic_load_n(h->tbl_chng_cnt,
+				__ATOMIC_ACQUIRE);
+
+		/* Keys move from the old array to the current one: load
+		 * the current array first, then search the old one first.
+		 */
+		gen[1] = __atomic_load_n(&rs->cur, __ATOMIC_ACQUIRE);
+		gen[0] = __atomic_load_n(&rs->old, __ATOMIC_ACQUIRE);
+
+		for (g = 0; g < RTE_DIM(gen); g++) {
+			if (gen[g] == NULL)
+				continue;
+			get_gen_buckets(gen[g], sig, &prim_bkt, &sec_bkt);
+			ret = search_one_bucket_lf(h, key, short_sig, data,
+					prim_bkt);
+			if (ret != -1)
+				return ret;
+			ret = search_one_bucket_lf(h, key, short_sig, data,
+					sec_bkt);
+			if (ret != -1)
+				return ret;
+		}
+
+		/* The loads of sig_current in search_one_bucket
+		 * should not move below the load from tbl_chng_cnt.
+		 */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		cnt_a = __atomic_load_n(h->tbl_chng_cnt,
+					__ATOMIC_ACQUIRE);
+	} while (cnt_b != cnt_a);
+
+	return -ENOENT;
+}
+
+/* Check if entry @i of a bucket is the key, for the tables storing the
+ * keys inline. Return its key index, EMPTY_SLOT if it is not.
+ */
+static inline uint32_t
+inline_entry_match(const struct rte_hash *h,
+		const struct rte_hash_bucket *bkt, unsigned int i,
+		const void *key, const uint8_t *key16, void **data)
+{
+	const struct rte_hash_inline_bkt *il = get_inline_bkt(h, bkt);
+	uint32_t key_idx;
+	void *pdata;
+
+	key_idx = __atomic_load_n(&bkt->key_idx[i], __ATOMIC_ACQUIRE);
+	if (key_idx == EMPTY_SLOT ||
+			inline_key_cmp_eq(h, key, key16, il->key[i]) != 0)
+		return EMPTY_SLOT;
+
+	pdata = __atomic_load_n(&il->pdata[i], __ATOMIC_ACQUIRE);
+	/* Unlike the key store slot, the inline key and data are
+	 * overwritten when another entry takes the place of this one:
+	 * check they were read while the entry was still there.
+	 * The loads above should not move below the load of key_idx.
+	 */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&bkt->key_idx[i], __ATOMIC_RELAXED) != key_idx)
+		return EMPTY_SLOT;
+
+	if (data != NULL)
+		*data = pdata;
+	return key_idx;
+}
+
+/* Search one bucket storing the keys inline to find the match key */
+static inline int32_t
+search_one_bucket_il(const struct rte_hash *h, const void *key,
+		const uint8_t *key16, uint16_t sig, void **data,
+		const struct rte_hash_bucket *bkt)
+{
+	unsigned int i;
+	uint32_t key_idx;
+
+	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+		if (bkt->sig_current[i] != sig)
+			continue;
+		key_idx = inline_entry_match(h, bkt, i, key, key16, data);
+		if (key_idx != EMPTY_SLOT)
+			/*
+			 * Return index where key is stored,
+			 * subtracting the first dummy index
+			 */
+			return key_idx - 1;
+	}
+	return -1;
+}
+
+/* Prefetch the inline keys and data of a bucket */
+static inline void
+inline_bkt_prefetch(const struct rte_hash *h,
+		const struct rte_hash_bucket *bkt)
+{
+	const struct rte_hash_inline_bkt *il = get_inline_bkt(h, bkt);
+
+	rte_prefetch0(il->key[0]);
+	rte_prefetch0(il->key[RTE_HASH_BUCKET_ENTRIES / 2]);
+	rte_prefetch0(il->pdata);
+}
+
+static inline int32_t
+__rte_hash_lookup_with_hash_il(const struct rte_hash *h, const void *key,
+					hash_sig_t sig, void **data)
+{
+	uint8_t key16[RTE_HASH_INLINE_KEY_LEN];
+	uint32_t prim_bucket_idx, sec_bucket_idx;
+	const struct rte_hash_bucket *prim_bkt, *sec_bkt;
+	uint32_t cnt_b, cnt_a;
+	int32_t ret;
+	uint16_t short_sig;
+
+	short_sig = get_short_sig(sig);
+	prim_bucket_idx = get_prim_bucket_index(h, sig);
+	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
+	prim_bkt = &h->buckets[prim_bucket_idx];
+	sec_bkt = &h->buckets[sec_bucket_idx];
+
+	/* The inline keys only depend on the hash, unlike the key store
+	 * slot: fetch them with the bucket rather than after it.
+	 */
+	rte_prefetch0(prim_bkt);
+	inline_bkt_prefetch(h, prim_bkt);
+	inline_key_pad(h, key, key16);
+
+	__hash_rw_reader_lock(h);
+	do {
+		/* Restart if keys moved during the search, as in
+		 * __rte_hash_lookup_with_hash_lf(). Hits are checked too,
+		 * the inline copy of a key being moved with it.
+		 */
+		cnt_b = __atomic_load_n(h->tbl_chng_cnt,
+				__ATOMIC_ACQUIRE);
+
+		ret = search_one_bucket_il(h, key, key16, short_sig, data,
+				prim_bkt);
+		if (ret == -1)
+			ret = search_one_bucket_il(h, key, key16, short_sig,
+					data, sec_bkt);
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		cnt_a = __atomic_load_n(h->tbl_chng_cnt,
+				__ATOMIC_ACQUIRE);
+	} while (cnt_b != cnt_a);
+	__hash_rw_reader_unlock(h);
+
+	return ret != -1 ? ret : -ENOENT;
+}
+
 static inline int32_t
 __rte_hash_lookup_with_hash(const struct rte_hash *h, const void *key,
 					hash_sig_t sig, void **data)
 {
-	if (h->readwrite_concur_lf_support)
+	if (h->resize != NULL)
+		return __rte_hash_lookup_with_hash_rs(h, key, sig, data);
+	else if (h->inline_bkts != NULL)
+		return __rte_hash_lookup_with_hash_il(h, key, sig, data);
+	else if (h->readwrite_concur_lf_support)
 		return __rte_hash_lookup_with_hash_lf(h, key, sig, data);
 	else
 		return __rte_hash_lookup_with_hash_l(h, key, sig, data);
@@ -1433,15 +2377,35 @@ __rte_hash_compact_ll(const struct rte_hash *h,
 	}
 }
 
+/* A key has expired if it wasn't touched for timeout cycles. The
+ * difference is signed, as the key may have been touched by another
+ * lcore after now was sampled.
+ */
+static inline int
+key_is_expired(const struct rte_hash *h, uint32_t key_idx, uint64_t now,
+		uint64_t timeout)
+{
+	uint64_t ts = __atomic_load_n(&h->key_ts[key_idx], __ATOMIC_RELAXED);
+
+	return (int64_t)(now - ts) >= (int64_t)timeout;
+}
+
+/* Expiry condition of a delete, NULL for a regular delete */
+struct hash_age_check {
+	uint64_t now;
+	uint64_t timeout;
+};
+
 /* Search one bucket and remove the matched key.
  * Writer is expected to hold the lock while calling this
  * function.
  */
 static inline int32_t
 search_and_remove(const struct rte_hash *h, const void *key,
-			struct rte_hash_bucket *bkt, uint16_t sig, int *pos)
+			struct rte_hash_bucket *bkt, uint16_t sig, int *pos,
+			const struct hash_age_check *age)
 {
-	struct rte_hash_key *k, *keys = h->key_store;
+	struct rte_hash_key *k;
 	unsigned int i;
 	uint32_t key_idx;
 
@@ -1450,9 +2414,15 @@ search_and_remove(const struct rte_hash *h, const void *key,
 		key_idx = __atomic_load_n(&bkt->key_idx[i],
 					  __ATOMIC_ACQUIRE);
 		if (bkt->sig_current[i] == sig && key_idx != EMPTY_SLOT) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					key_idx * h->key_entry_size);
+			k = get_key_slot(h, key_idx);
 			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
+				/* The key was touched since it was found
+				 * expired, keep it.
+				 */
+				if (age != NULL && !key_is_expired(h,
+						key_idx, age->now,
+						age->timeout))
+					return -1;
 				bkt->sig_current[i] = NULL_SIGNATURE;
 				/* Free the key store index if
 				 * no_free_on_del is disabled.
@@ -1477,8 +2447,8 @@ search_and_remove(const struct rte_hash *h, const void *key,
 }
 
 static inline int32_t
-__rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
-						hash_sig_t sig)
+__rte_hash_del_key_with_hash_main(const struct rte_hash *h, const void *key,
+			hash_sig_t sig, const struct hash_age_check *age)
 {
 	uint32_t prim_bucket_idx, sec_bucket_idx;
 	struct rte_hash_bucket *prim_bkt, *sec_bkt, *prev_bkt, *last_bkt;
@@ -1491,10 +2461,11 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 	prim_bucket_idx = get_prim_bucket_index(h, sig);
 	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
 	prim_bkt = &h->buckets[prim_bucket_idx];
+	sec_bkt = &h->buckets[sec_bucket_idx];
 
-	__hash_rw_writer_lock(h);
+	__hash_bkt_writer_lock(h, prim_bkt, sec_bkt);
 	/* look for key in primary bucket */
-	ret = search_and_remove(h, key, prim_bkt, short_sig, &pos);
+	ret = search_and_remove(h, key, prim_bkt, short_sig, &pos, age);
 	if (ret != -1) {
 		__rte_hash_compact_ll(h, prim_bkt, pos);
 		last_bkt = prim_bkt->next;
@@ -1502,11 +2473,9 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 		goto return_bkt;
 	}
 
-	/* Calculate secondary hash */
-	sec_bkt = &h->buckets[sec_bucket_idx];
-
 	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
-		ret = search_and_remove(h, key, cur_bkt, short_sig, &pos);
+		ret = search_and_remove(h, key, cur_bkt, short_sig, &pos,
+				age);
 		if (ret != -1) {
 			__rte_hash_compact_ll(h, cur_bkt, pos);
 			last_bkt = sec_bkt->next;
@@ -1515,13 +2484,13 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 		}
 	}
 
-	__hash_rw_writer_unlock(h);
+	__hash_bkt_writer_unlock(h, prim_bkt, sec_bkt);
 	return -ENOENT;
 
 /* Search last bucket to see if empty to be recycled */
 return_bkt:
 	if (!last_bkt) {
-		__hash_rw_writer_unlock(h);
+		__hash_bkt_writer_unlock(h, prim_bkt, sec_bkt);
 		return ret;
 	}
 	while (last_bkt->next) {
@@ -1553,10 +2522,50 @@ return_bkt:
 		else
 			rte_ring_sp_enqueue(h->free_ext_bkts, (void *)(uintptr_t)index);
 	}
-	__hash_rw_writer_unlock(h);
+	__hash_bkt_writer_unlock(h, prim_bkt, sec_bkt);
+	return ret;
+}
+
+static inline int32_t
+__rte_hash_del_key_with_hash_rs(const struct rte_hash *h, const void *key,
+						hash_sig_t sig)
+{
+	struct rte_hash_bucket *prim_bkt, *sec_bkt;
+	const struct rte_hash_gen *old;
+	int32_t ret;
+	int pos;
+
+	__hash_resize_lock(h);
+
+	/* Keys not migrated yet are removed from the old array */
+	old = h->resize->old;
+	if (old != NULL) {
+		get_gen_buckets(old, sig, &prim_bkt, &sec_bkt);
+		ret = search_and_remove(h, key, prim_bkt, get_short_sig(sig),
+				&pos, NULL);
+		if (ret == -1)
+			ret = search_and_remove(h, key, sec_bkt,
+					get_short_sig(sig), &pos, NULL);
+		if (ret != -1)
+			goto out;
+	}
+
+	ret = __rte_hash_del_key_with_hash_main(h, key, sig, NULL);
+out:
+	__hash_resize_unlock(h);
 	return ret;
 }
 
+static inline int32_t
+__rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
+						hash_sig_t sig)
+{
+	if (h->resize != NULL)
+		return __rte_hash_del_key_with_hash_rs(h, key, sig);
+	else
+		return __rte_hash_del_key_with_hash_main(h, key, sig, NULL);
+}
+
 int32_t
 rte_hash_del_key_with_hash(const struct rte_hash *h,
 			const void *key, hash_sig_t sig)
@@ -1578,9 +2587,8 @@ rte_hash_get_key_with_position(const struct rte_hash *h, const int32_t position,
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
 
-	struct rte_hash_key *k, *keys = h->key_store;
-	k = (struct rte_hash_key *) ((char *) keys + (position + 1) *
-				     h->key_entry_size);
+	struct rte_hash_key *k;
+	k = get_key_slot(h, position + 1);
 	*key = k->key;
 
 	if (position !=
@@ -1610,6 +2618,14 @@ rte_hash_free_key_with_position(const struct rte_hash *h,
 	/* Out of bounds */
 	if (key_idx >= total_entries)
 		return -EINVAL;
+	if (h->resize != NULL) {
+		/* The ring is replaced when the table grows */
+		__hash_resize_lock(h);
+		rte_ring_sp_enqueue(h->free_slots,
+				(void *)((uintptr_t)key_idx));
+		__hash_resize_unlock(h);
+		return 0;
+	}
 	if (h->ext_table_support && h->readwrite_concur_lf_support) {
 		uint32_t index = h->ext_bkt_to_free[position];
 		if (index) {
@@ -1696,6 +2712,32 @@ compare_signatures(uint32_t *prim_hash_matches, uint32_t *sec_hash_matches,
 	}
 }
 
+/* Compare the signatures of all the keys of a bulk lookup */
+static inline void
+compare_signatures_bulk(const struct rte_hash *h, uint32_t *prim_hash_matches,
+			uint32_t *sec_hash_matches,
+			const struct rte_hash_bucket **prim_bkt,
+			const struct rte_hash_bucket **sec_bkt,
+			uint16_t *sig, int32_t num_keys)
+{
+	int32_t i;
+
+#ifdef CC_CUCKOO_HASH_AVX512_SUPPORT
+	if (h->sig_cmp_fn == RTE_HASH_COMPARE_AVX512) {
+		/* The AVX512 function loads the signatures at bucket start */
+		RTE_BUILD_BUG_ON(offsetof(struct rte_hash_bucket,
+				sig_current) != 0);
+		rte_hash_compare_signatures_avx512(prim_hash_matches,
+				sec_hash_matches, (const void **)prim_bkt,
+				(const void **)sec_bkt, sig, num_keys);
+		return;
+	}
+#endif
+	for (i = 0; i < num_keys; i++)
+		compare_signatures(&prim_hash_matches[i], &sec_hash_matches[i],
+			prim_bkt[i], sec_bkt[i], sig[i], h->sig_cmp_fn);
+}
+
 #define PREFETCH_OFFSET 4
 static inline void
 __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
@@ -1756,12 +2798,12 @@ __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
 
 	__hash_rw_reader_lock(h);
 
-	/* Compare signatures and prefetch key slot of first hit */
-	for (i = 0; i < num_keys; i++) {
-		compare_signatures(&prim_hitmask[i], &sec_hitmask[i],
-			primary_bkt[i], secondary_bkt[i],
-			sig[i], h->sig_cmp_fn);
+	/* Compare signatures */
+	compare_signatures_bulk(h, prim_hitmask, sec_hitmask,
+		primary_bkt, secondary_bkt, sig, num_keys);
 
+	/* Prefetch key slot of first hit */
+	for (i = 0; i < num_keys; i++) {
 		if (prim_hitmask[i]) {
 			uint32_t first_hit =
 					__builtin_ctzl(prim_hitmask[i])
@@ -1769,9 +2811,7 @@ __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
 			uint32_t key_idx =
 				primary_bkt[i]->key_idx[first_hit];
 			const struct rte_hash_key *key_slot =
-				(const struct rte_hash_key *)(
-				(const char *)h->key_store +
-				key_idx * h->key_entry_size);
+				get_key_slot(h, key_idx);
 			rte_prefetch0(key_slot);
 			continue;
 		}
@@ -1783,9 +2823,7 @@ __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
 			uint32_t key_idx =
 				secondary_bkt[i]->key_idx[first_hit];
 			const struct rte_hash_key *key_slot =
-				(const struct rte_hash_key *)(
-				(const char *)h->key_store +
-				key_idx * h->key_entry_size);
+				get_key_slot(h, key_idx);
 			rte_prefetch0(key_slot);
 		}
 	}
@@ -1800,9 +2838,7 @@ __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
 			uint32_t key_idx =
 				primary_bkt[i]->key_idx[hit_index];
 			const struct rte_hash_key *key_slot =
-				(const struct rte_hash_key *)(
-				(const char *)h->key_store +
-				key_idx * h->key_entry_size);
+				get_key_slot(h, key_idx);
 
 			/*
 			 * If key index is 0, do not compare key,
@@ -1828,9 +2864,7 @@ __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
 			uint32_t key_idx =
 				secondary_bkt[i]->key_idx[hit_index];
 			const struct rte_hash_key *key_slot =
-				(const struct rte_hash_key *)(
-				(const char *)h->key_store +
-				key_idx * h->key_entry_size);
+				get_key_slot(h, key_idx);
 
 			/*
 			 * If key index is 0, do not compare key,
@@ -1887,6 +2921,115 @@ next_key:
 		*hit_mask = hits;
 }
 
+/* Compare the keys of a bulk lookup with the keys of the entries whose
+ * signature matched, first hits in primary first. Returns the updated
+ * hit mask.
+ */
+static inline uint64_t
+compare_keys_bulk_lf(const struct rte_hash *h, const void **keys,
+			int32_t num_keys, int32_t *positions, void *data[],
+			const struct rte_hash_bucket **primary_bkt,
+			const struct rte_hash_bucket **secondary_bkt,
+			uint32_t *prim_hitmask, uint32_t *sec_hitmask,
+			uint64_t hits)
+{
+	int32_t i;
+
+	/* Prefetch key slot of first hit */
+	for (i = 0; i < num_keys; i++) {
+		if (prim_hitmask[i]) {
+			uint32_t first_hit =
+					__builtin_ctzl(prim_hitmask[i])
+					>> 1;
+			uint32_t key_idx =
+				primary_bkt[i]->key_idx[first_hit];
+			const struct rte_hash_key *key_slot =
+				get_key_slot(h, key_idx);
+			rte_prefetch0(key_slot);
+			continue;
+		}
+
+		if (sec_hitmask[i]) {
+			uint32_t first_hit =
+					__builtin_ctzl(sec_hitmask[i])
+					>> 1;
+			uint32_t key_idx =
+				secondary_bkt[i]->key_idx[first_hit];
+			const struct rte_hash_key *key_slot =
+				get_key_slot(h, key_idx);
+			rte_prefetch0(key_slot);
+		}
+	}
+
+	/* Compare keys, first hits in primary first */
+	for (i = 0; i < num_keys; i++) {
+		while (prim_hitmask[i]) {
+			uint32_t hit_index =
+					__builtin_ctzl(prim_hitmask[i])
+					>> 1;
+			uint32_t key_idx =
+			__atomic_load_n(
+				&primary_bkt[i]->key_idx[hit_index],
+				__ATOMIC_ACQUIRE);
+			const struct rte_hash_key *key_slot =
+				get_key_slot(h, key_idx);
+
+			/*
+			 * If key index is 0, do not compare key,
+			 * as it is checking the dummy slot
+			 */
+			if (!!key_idx &
+				!rte_hash_cmp_eq(
+					key_slot->key, keys[i], h)) {
+				if (data != NULL)
+					data[i] = __atomic_load_n(
+						&key_slot->pdata,
+						__ATOMIC_ACQUIRE);
+
+				hits |= 1ULL << i;
+				positions[i] = key_idx - 1;
+				goto next_key;
+			}
+			prim_hitmask[i] &= ~(3ULL << (hit_index << 1));
+		}
+
+		while (sec_hitmask[i]) {
+			uint32_t hit_index =
+					__builtin_ctzl(sec_hitmask[i])
+					>> 1;
+			uint32_t key_idx =
+			__atomic_load_n(
+				&secondary_bkt[i]->key_idx[hit_index],
+				__ATOMIC_ACQUIRE);
+			const struct rte_hash_key *key_slot =
+				get_key_slot(h, key_idx);
+
+			/*
+			 * If key index is 0, do not compare key,
+			 * as it is checking the dummy slot
+			 */
+
+			if (!!key_idx &
+				!rte_hash_cmp_eq(
+					key_slot->key, keys[i], h)) {
+				if (data != NULL)
+					data[i] = __atomic_load_n(
+						&key_slot->pdata,
+						__ATOMIC_ACQUIRE);
+
+				hits |= 1ULL << i;
+				positions[i] = key_idx - 1;
+				goto next_key;
+			}
+			sec_hitmask[i] &= ~(3ULL << (hit_index << 1));
+		}
+next_key:
+		continue;
+	}
+
+	return hits;
+}
+
 static inline void
 __rte_hash_lookup_bulk_lf(const struct rte_hash *h, const void **keys,
 			int32_t num_keys, int32_t *positions,
@@ -1956,109 +3099,13 @@ __rte_hash_lookup_bulk_lf(const struct rte_hash *h, const void **keys,
 		cnt_b = __atomic_load_n(h->tbl_chng_cnt,
 					__ATOMIC_ACQUIRE);
 
-		/* Compare signatures and prefetch key slot of first hit */
-		for (i = 0; i < num_keys; i++) {
-			compare_signatures(&prim_hitmask[i], &sec_hitmask[i],
-				primary_bkt[i], secondary_bkt[i],
-				sig[i], h->sig_cmp_fn);
-
-			if (prim_hitmask[i]) {
-				uint32_t first_hit =
-						__builtin_ctzl(prim_hitmask[i])
-						>> 1;
-				uint32_t key_idx =
-					primary_bkt[i]->key_idx[first_hit];
-				const struct rte_hash_key *key_slot =
-					(const struct rte_hash_key *)(
-					(const char *)h->key_store +
-					key_idx * h->key_entry_size);
-				rte_prefetch0(key_slot);
-				continue;
-			}
-
-			if (sec_hitmask[i]) {
-				uint32_t first_hit =
-						__builtin_ctzl(sec_hitmask[i])
-						>> 1;
-				uint32_t key_idx =
-					secondary_bkt[i]->key_idx[first_hit];
-				const struct rte_hash_key *key_slot =
-					(const struct rte_hash_key *)(
-					(const char *)h->key_store +
-					key_idx * h->key_entry_size);
-				rte_prefetch0(key_slot);
-			}
-		}
-
-		/* Compare keys, first hits in primary first */
-		for (i = 0; i < num_keys; i++) {
-			while (prim_hitmask[i]) {
-				uint32_t hit_index =
-						__builtin_ctzl(prim_hitmask[i])
-						>> 1;
-				uint32_t key_idx =
-				__atomic_load_n(
-					&primary_bkt[i]->key_idx[hit_index],
-					__ATOMIC_ACQUIRE);
-				const struct rte_hash_key *key_slot =
-					(const struct rte_hash_key *)(
-					(const char *)h->key_store +
-					key_idx * h->key_entry_size);
-
-				/*
-				 * If key index is 0, do not compare key,
-				 * as it is checking the dummy slot
-				 */
-				if (!!key_idx &
-					!rte_hash_cmp_eq(
-						key_slot->key, keys[i], h)) {
-					if (data != NULL)
-						data[i] = __atomic_load_n(
-							&key_slot->pdata,
-							__ATOMIC_ACQUIRE);
-
-					hits |= 1ULL << i;
-					positions[i] = key_idx - 1;
-					goto next_key;
-				}
-				prim_hitmask[i] &= ~(3ULL << (hit_index << 1));
-			}
-
-			while (sec_hitmask[i]) {
-				uint32_t hit_index =
-						__builtin_ctzl(sec_hitmask[i])
-						>> 1;
-				uint32_t key_idx =
-				__atomic_load_n(
-					&secondary_bkt[i]->key_idx[hit_index],
-					__ATOMIC_ACQUIRE);
-				const struct rte_hash_key *key_slot =
-					(const struct rte_hash_key *)(
-					(const char *)h->key_store +
-					key_idx * h->key_entry_size);
-
-				/*
-				 * If key index is 0, do not compare key,
-				 * as it is checking the dummy slot
-				 */
+		/* Compare signatures */
+		compare_signatures_bulk(h, prim_hitmask, sec_hitmask,
+			primary_bkt, secondary_bkt, sig, num_keys);
 
-				if (!!key_idx &
-					!rte_hash_cmp_eq(
-						key_slot->key, keys[i], h)) {
-					if (data != NULL)
-						data[i] = __atomic_load_n(
-							&key_slot->pdata,
-							__ATOMIC_ACQUIRE);
-
-					hits |= 1ULL << i;
-					positions[i] = key_idx - 1;
-					goto next_key;
-				}
-				sec_hitmask[i] &= ~(3ULL << (hit_index << 1));
-			}
-next_key:
-			continue;
-		}
+		hits = compare_keys_bulk_lf(h, keys, num_keys, positions, data,
+				primary_bkt, secondary_bkt, prim_hitmask,
+				sec_hitmask, hits);
 
 		/* all found, do not need to go through ext bkt */
 		if (hits == ((1ULL << num_keys) - 1)) {
@@ -2109,12 +3156,205 @@ next_key:
 		*hit_mask = hits;
 }
 
+static inline void
+__rte_hash_lookup_bulk_rs(const struct rte_hash *h, const void **keys,
+			int32_t num_keys, int32_t *positions,
+			uint64_t *hit_mask, void *data[])
+{
+	const struct rte_hash_resize *rs = h->resize;
+	const struct rte_hash_gen *gen[2];
+	uint64_t hits;
+	int32_t i;
+	unsigned int g;
+	uint32_t prim_hash[RTE_HASH_LOOKUP_BULK_MAX];
+	uint16_t sig[RTE_HASH_LOOKUP_BULK_MAX];
+	const struct rte_hash_bucket *primary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	const struct rte_hash_bucket *secondary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t prim_hitmask[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t sec_hitmask[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t prim_index, cnt_b, cnt_a;
+
+	/* Prefetch first keys */
+	for (i = 0; i < PREFETCH_OFFSET && i < num_keys; i++)
+		rte_prefetch0(keys[i]);
+
+	/* Hash the keys once, the buckets depend on the array */
+	for (i = 0; i < num_keys; i++) {
+		if (i + PREFETCH_OFFSET < num_keys)
+			rte_prefetch0(keys[i + PREFETCH_OFFSET]);
+		prim_hash[i] = rte_hash_hash(h, keys[i]);
+		sig[i] = get_short_sig(prim_hash[i]);
+	}
+
+	do {
+		hits = 0;
+		for (i = 0; i < num_keys; i++)
+			positions[i] = -ENOENT;
+
+		cnt_b = __atomic_load_n(h->tbl_chng_cnt,
+					__ATOMIC_ACQUIRE);
+
+		/* Same order as __rte_hash_lookup_with_hash_rs() */
+		gen[1] = __atomic_load_n(&rs->cur, __ATOMIC_ACQUIRE);
+		gen[0] = __atomic_load_n(&rs->old, __ATOMIC_ACQUIRE);
+
+		for (g = 0; g < RTE_DIM(gen); g++) {
+			if (gen[g] == NULL)
+				continue;
+
+			for (i = 0; i < num_keys; i++) {
+				prim_index = prim_hash[i] &
+					gen[g]->bucket_bitmask;
+				primary_bkt[i] = &gen[g]->buckets[prim_index];
+				secondary_bkt[i] = &gen[g]->buckets[
+					(prim_index ^ sig[i]) &
+					gen[g]->bucket_bitmask];
+				rte_prefetch0(primary_bkt[i]);
+				rte_prefetch0(secondary_bkt[i]);
+				prim_hitmask[i] = 0;
+				sec_hitmask[i] = 0;
+			}
+
+			compare_signatures_bulk(h, prim_hitmask, sec_hitmask,
+				primary_bkt, secondary_bkt, sig, num_keys);
+
+			/* Keys found in the old array are not searched again */
+			for (i = 0; i < num_keys; i++) {
+				if ((hits & (1ULL << i)) != 0) {
+					prim_hitmask[i] = 0;
+					sec_hitmask[i] = 0;
+				}
+			}
+
+			hits = compare_keys_bulk_lf(h, keys, num_keys,
+					positions, data, primary_bkt,
+					secondary_bkt, prim_hitmask,
+					sec_hitmask, hits);
+		}
+
+		/* The loads of sig_current in compare_signatures
+		 * should not move below the load from tbl_chng_cnt.
+		 */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		cnt_a = __atomic_load_n(h->tbl_chng_cnt,
+					__ATOMIC_ACQUIRE);
+	} while (cnt_b != cnt_a);
+
+	if (hit_mask != NULL)
+		*hit_mask = hits;
+}
+
+/* Bulk lookup of the tables storing the keys inline */
+static inline void
+__rte_hash_lookup_bulk_il(const struct rte_hash *h, const void **keys,
+			int32_t num_keys, int32_t *positions,
+			uint64_t *hit_mask, void *data[])
+{
+	uint64_t hits;
+	int32_t i;
+	uint32_t prim_hash, prim_index, sec_index;
+	uint32_t key_idx, hit_index, cnt_b, cnt_a;
+	uint16_t sig[RTE_HASH_LOOKUP_BULK_MAX];
+	uint8_t keys16[RTE_HASH_LOOKUP_BULK_MAX][RTE_HASH_INLINE_KEY_LEN];
+	const struct rte_hash_bucket *primary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	const struct rte_hash_bucket *secondary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t prim_hitmask[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t sec_hitmask[RTE_HASH_LOOKUP_BULK_MAX];
+
+	/* Prefetch first keys */
+	for (i = 0; i < PREFETCH_OFFSET && i < num_keys; i++)
+		rte_prefetch0(keys[i]);
+
+	/* Calculate the buckets and prefetch them with the inline keys of
+	 * the primary ones, which do not depend on the bucket contents.
+	 */
+	for (i = 0; i < num_keys; i++) {
+		if (i + PREFETCH_OFFSET < num_keys)
+			rte_prefetch0(keys[i + PREFETCH_OFFSET]);
+
+		prim_hash = rte_hash_hash(h, keys[i]);
+		sig[i] = get_short_sig(prim_hash);
+		prim_index = get_prim_bucket_index(h, prim_hash);
+		sec_index = get_alt_bucket_index(h, prim_index, sig[i]);
+
+		primary_bkt[i] = &h->buckets[prim_index];
+		secondary_bkt[i] = &h->buckets[sec_index];
+
+		rte_prefetch0(primary_bkt[i]);
+		rte_prefetch0(secondary_bkt[i]);
+		inline_bkt_prefetch(h, primary_bkt[i]);
+
+		inline_key_pad(h, keys[i], keys16[i]);
+	}
+
+	__hash_rw_reader_lock(h);
+	do {
+		hits = 0;
+
+		/* Same as __rte_hash_lookup_with_hash_il() */
+		cnt_b = __atomic_load_n(h->tbl_chng_cnt,
+					__ATOMIC_ACQUIRE);
+
+		for (i = 0; i < num_keys; i++) {
+			prim_hitmask[i] = 0;
+			sec_hitmask[i] = 0;
+		}
+		compare_signatures_bulk(h, prim_hitmask, sec_hitmask,
+			primary_bkt, secondary_bkt, sig, num_keys);
+
+		/* Prefetch the inline keys of the secondary hits */
+		for (i = 0; i < num_keys; i++)
+			if (prim_hitmask[i] == 0 && sec_hitmask[i] != 0)
+				inline_bkt_prefetch(h, secondary_bkt[i]);
+
+		/* Compare keys, first hits in primary first */
+		for (i = 0; i < num_keys; i++) {
+			key_idx = EMPTY_SLOT;
+			while (prim_hitmask[i] != 0 && key_idx == EMPTY_SLOT) {
+				hit_index = __builtin_ctzl(prim_hitmask[i]) >> 1;
+				key_idx = inline_entry_match(h, primary_bkt[i],
+					hit_index, keys[i], keys16[i],
+					data != NULL ? &data[i] : NULL);
+				prim_hitmask[i] &= ~(3U << (hit_index << 1));
+			}
+			while (sec_hitmask[i] != 0 && key_idx == EMPTY_SLOT) {
+				hit_index = __builtin_ctzl(sec_hitmask[i]) >> 1;
+				key_idx = inline_entry_match(h,
+					secondary_bkt[i], hit_index, keys[i],
+					keys16[i],
+					data != NULL ? &data[i] : NULL);
+				sec_hitmask[i] &= ~(3U << (hit_index << 1));
+			}
+
+			if (key_idx != EMPTY_SLOT) {
+				positions[i] = key_idx - 1;
+				hits |= 1ULL << i;
+			} else
+				positions[i] = -ENOENT;
+		}
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		cnt_a = __atomic_load_n(h->tbl_chng_cnt,
+					__ATOMIC_ACQUIRE);
+	} while (cnt_b != cnt_a);
+	__hash_rw_reader_unlock(h);
+
+	if (hit_mask != NULL)
+		*hit_mask = hits;
+}
+
 static inline void
 __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 			int32_t num_keys, int32_t *positions,
 			uint64_t *hit_mask, void *data[])
 {
-	if (h->readwrite_concur_lf_support)
+	if (h->resize != NULL)
+		__rte_hash_lookup_bulk_rs(h, keys, num_keys, positions,
+					  hit_mask, data);
+	else if (h->inline_bkts != NULL)
+		__rte_hash_lookup_bulk_il(h, keys, num_keys, positions,
+					  hit_mask, data);
+	else if (h->readwrite_concur_lf_support)
 		__rte_hash_lookup_bulk_lf(h, keys, num_keys, positions,
 					  hit_mask, data);
 	else
@@ -2150,6 +3390,43 @@ rte_hash_lookup_bulk_data(const struct rte_hash *h, const void **keys,
 	return __builtin_popcountl(*hit_mask);
 }
 
+/* Iterate the current bucket array of a resizable table, then the old one */
+static int32_t
+rte_hash_iterate_rs(const struct rte_hash *h, const void **key, void **data,
+		uint32_t *next)
+{
+	const struct rte_hash_gen *gen[2];
+	uint32_t bucket_idx, idx, position, total_entries, base = 0;
+	struct rte_hash_key *next_key;
+	unsigned int g;
+
+	gen[0] = __atomic_load_n(&h->resize->cur, __ATOMIC_ACQUIRE);
+	gen[1] = __atomic_load_n(&h->resize->old, __ATOMIC_ACQUIRE);
+
+	for (g = 0; g < RTE_DIM(gen) && gen[g] != NULL; g++) {
+		total_entries = gen[g]->num_buckets * RTE_HASH_BUCKET_ENTRIES;
+		while (*next - base < total_entries) {
+			bucket_idx = (*next - base) / RTE_HASH_BUCKET_ENTRIES;
+			idx = (*next - base) % RTE_HASH_BUCKET_ENTRIES;
+			position = __atomic_load_n(
+					&gen[g]->buckets[bucket_idx].key_idx[idx],
+					__ATOMIC_ACQUIRE);
+			(*next)++;
+			if (position == EMPTY_SLOT)
+				continue;
+
+			next_key = get_key_slot(h, position);
+			/* Return key and data */
+			*key = next_key->key;
+			*data = next_key->pdata;
+			return position - 1;
+		}
+		base += total_entries;
+	}
+
+	return -ENOENT;
+}
+
 int32_t
 rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32_t *next)
 {
@@ -2158,6 +3435,9 @@ rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32
 
 	RETURN_IF_TRUE(((h == NULL) || (next == NULL)), -EINVAL);
 
+	if (h->resize != NULL)
+		return rte_hash_iterate_rs(h, key, data, next);
+
 	const uint32_t total_entries_main = h->num_buckets *
 							RTE_HASH_BUCKET_ENTRIES;
 	const uint32_t total_entries = total_entries_main << 1;
@@ -2182,8 +3462,7 @@ rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32
 	}
 
 	__hash_rw_reader_lock(h);
-	next_key = (struct rte_hash_key *) ((char *)h->key_store +
-				position * h->key_entry_size);
+	next_key = get_key_slot(h, position);
 	/* Return key and data */
 	*key = next_key->key;
 	*data = next_key->pdata;
@@ -2213,8 +3492,7 @@ extend_table:
 		idx = (*next - total_entries_main) % RTE_HASH_BUCKET_ENTRIES;
 	}
 	__hash_rw_reader_lock(h);
-	next_key = (struct rte_hash_key *) ((char *)h->key_store +
-				position * h->key_entry_size);
+	next_key = get_key_slot(h, position);
 	/* Return key and data */
 	*key = next_key->key;
 	*data = next_key->pdata;
@@ -2225,3 +3503,145 @@ extend_table:
 	(*next)++;
 	return position - 1;
 }
+
+int
+rte_hash_age_touch(const struct rte_hash *h, const int32_t position)
+{
+	/* Key index where key is stored, adding the first dummy index */
+	uint32_t key_idx = position + 1;
+
+	RETURN_IF_TRUE((h == NULL), -EINVAL);
+
+	if (position < 0 || h->key_ts == NULL)
+		return -EINVAL;
+
+	/* Out of bounds, aging tables aren't resizable */
+	const uint32_t total_entries = h->use_local_cache ?
+		h->entries + (RTE_MAX_LCORE - 1) * (LCORE_CACHE_SIZE - 1) + 1
+							: h->entries + 1;
+	if (key_idx >= total_entries)
+		return -EINVAL;
+
+	__atomic_store_n(&h->key_ts[key_idx], rte_rdtsc(), __ATOMIC_RELAXED);
+	return 0;
+}
+
+/* Collect the expired keys of a bucket and of its extendable buckets.
+ * Returns the number of keys collected, and sets more if some expired keys
+ * were left out because the output is full.
+ */
+static inline unsigned int
+collect_expired(const struct rte_hash *h, const struct rte_hash_bucket *bkt,
+		uint64_t now, uint64_t timeout, uint32_t *key_idx,
+		unsigned int max, int *more)
+{
+	const struct rte_hash_bucket *cur_bkt;
+	unsigned int i, n = 0;
+	uint32_t idx;
+
+	*more = 0;
+	FOR_EACH_BUCKET(cur_bkt, bkt) {
+		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+			idx = __atomic_load_n(&cur_bkt->key_idx[i],
+					__ATOMIC_ACQUIRE);
+			if (idx == EMPTY_SLOT ||
+					!key_is_expired(h, idx, now, timeout))
+				continue;
+			if (n == max) {
+				*more = 1;
+				return n;
+			}
+			key_idx[n++] = idx;
+		}
+	}
+	return n;
+}
+
+int32_t
+rte_hash_age_scan(struct rte_hash *h, uint64_t timeout, uint32_t budget,
+		const void **keys, void **data, int32_t *positions,
+		uint32_t max)
+{
+	uint32_t key_idx[RTE_HASH_BUCKET_ENTRIES];
+	struct hash_age_check age;
+	struct rte_hash_key *k;
+	uint32_t bkt_idx, i, n, num = 0;
+	int32_t pos;
+	void *pdata;
+	int more;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL)), -EINVAL);
+
+	if (h->key_ts == NULL)
+		return -EINVAL;
+
+	age.now = rte_rdtsc();
+	age.timeout = RTE_MIN(timeout, (uint64_t)INT64_MAX);
+	bkt_idx = h->age_next_bkt;
+	while (budget != 0 && num < max) {
+		__hash_rw_reader_lock(h);
+		n = collect_expired(h, &h->buckets[bkt_idx], age.now,
+				age.timeout,
+				key_idx, RTE_MIN(max - num, RTE_DIM(key_idx)),
+				&more);
+		__hash_rw_reader_unlock(h);
+
+		for (i = 0; i < n; i++) {
+			k = get_key_slot(h, key_idx[i]);
+			pdata = k->pdata;
+			/* The key may have been deleted, moved or touched
+			 * since it was collected. Deleting it by value
+			 * handles the first two cases, and its time is
+			 * checked again under the writer lock.
+			 */
+			pos = __rte_hash_del_key_with_hash_main(h, k->key,
+					rte_hash_hash(h, k->key), &age);
+			if (pos < 0)
+				continue;
+			keys[num] = k->key;
+			if (data != NULL)
+				data[num] = pdata;
+			if (positions != NULL)
+				positions[num] = pos;
+			num++;
+		}
+
+		/* Check the same bucket again if some keys were left out,
+		 * they are found first now that the collected ones are gone.
+		 */
+		if (more)
+			continue;
+
+		bkt_idx = (bkt_idx + 1) & h->bucket_bitmask;
+		budget--;
+	}
+	h->age_next_bkt = bkt_idx;
+
+	return num;
+}
+
+int32_t
+rte_hash_resize_step(const struct rte_hash *h, uint32_t budget)
+{
+	struct rte_hash_resize *rs;
+	int32_t ret = 0;
+
+	if (h == NULL || h->resize == NULL)
+		return -EINVAL;
+
+	rs = h->resize;
+	__hash_resize_lock(h);
+	rte_hash_resize_reclaim(rs);
+	if (rs->old == NULL &&
+			rte_hash_count(h) >= (int32_t)rs->grow_thresh) {
+		ret = rte_hash_resize_grow(h);
+		/* Already at its maximum size */
+		if (ret == -ENOSPC)
+			ret = 0;
+	}
+	if (ret == 0)
+		ret = rte_hash_resize_migrate(h, budget);
+	__hash_resize_unlock(h);
+
+	return ret;
+}
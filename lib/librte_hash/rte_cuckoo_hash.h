@@ -50,8 +50,11 @@
  */
 enum cmp_jump_table_case {
 	KEY_CUSTOM = 0,
+	KEY_13_BYTES,
 	KEY_16_BYTES,
 	KEY_32_BYTES,
+	KEY_36_BYTES,
+	KEY_40_BYTES,
 	KEY_48_BYTES,
 	KEY_64_BYTES,
 	KEY_80_BYTES,
@@ -68,8 +71,11 @@ enum cmp_jump_table_case {
  */
 const rte_hash_cmp_eq_t cmp_jump_table[NUM_KEY_CMP_CASES] = {
 	NULL,
+	rte_hash_k13_cmp_eq,
 	rte_hash_k16_cmp_eq,
 	rte_hash_k32_cmp_eq,
+	rte_hash_k36_cmp_eq,
+	rte_hash_k40_cmp_eq,
 	rte_hash_k48_cmp_eq,
 	rte_hash_k64_cmp_eq,
 	rte_hash_k80_cmp_eq,
@@ -142,6 +148,7 @@ enum rte_hash_sig_compare_function {
 	RTE_HASH_COMPARE_SCALAR = 0,
 	RTE_HASH_COMPARE_SSE,
 	RTE_HASH_COMPARE_NEON,
+	RTE_HASH_COMPARE_AVX512,
 	RTE_HASH_COMPARE_NUM
 };
 
@@ -156,6 +163,68 @@ struct rte_hash_bucket {
 	void *next;
 } __rte_cache_aligned;
 
+/** Keys and data of the entries of a bucket, in the same order, for the
+ * tables storing them inline. The keys are padded with zeros.
+ */
+struct rte_hash_inline_bkt {
+	uint8_t key[RTE_HASH_BUCKET_ENTRIES][RTE_HASH_INLINE_KEY_LEN];
+	void *pdata[RTE_HASH_BUCKET_ENTRIES];
+} __rte_cache_aligned;
+
+/** Maximum number of bucket locks of a multi-writer table. */
+#define RTE_HASH_BKT_LOCKS_MAX		1024U
+
+/** Maximum number of buckets locked one by one to move keys along a cuckoo
+ * path: the buckets of the path and the alternative bucket of the new key.
+ * All the bucket locks are taken for longer paths.
+ */
+#define RTE_HASH_BKT_PATH_MAX		8
+
+/** Lock of the buckets whose index is the same modulo the lock count. */
+struct rte_hash_bkt_lock {
+	rte_spinlock_t lock;
+} __rte_cache_aligned;
+
+/** Maximum number of times a resizable table doubles. */
+#define RTE_HASH_RESIZE_MAX_GROW	32
+
+/** Bucket array of a resizable table, replaced when the table grows. */
+struct rte_hash_gen {
+	struct rte_hash_bucket *buckets; /**< Buckets, following the header. */
+	uint32_t num_buckets;            /**< Number of buckets. */
+	uint32_t bucket_bitmask;
+	/**< Bitmask for getting bucket index from hash signature. */
+} __rte_cache_aligned;
+
+/** Bucket array replaced by a resize, freed once the readers are done. */
+struct rte_hash_retired {
+	struct rte_hash_gen *gen;
+	uint64_t token;                  /**< QSBR token of the replacement. */
+};
+
+/** Resize state of a resizable table, only written by the writers. */
+struct rte_hash_resize {
+	struct rte_hash_gen *cur;
+	/**< Bucket array new keys are added to. */
+	struct rte_hash_gen *old;
+	/**< Bucket array being migrated to cur, NULL if none. */
+	uint32_t migrate_next;           /**< Next bucket of old to migrate. */
+	uint32_t max_entries;            /**< Entries the table can grow to. */
+	uint32_t grow_load;              /**< Load making the table grow, %. */
+	uint32_t grow_thresh;            /**< Keys in use making it grow. */
+	uint32_t migrate_budget;         /**< Buckets migrated by an add. */
+	int socket_id;                   /**< NUMA socket of the memory. */
+	uint8_t multi_writer;            /**< If the writers take the lock. */
+	rte_spinlock_t lock;             /**< Lock of the writers. */
+	struct rte_rcu_qsbr *v;          /**< QSBR variable of the readers. */
+	uint32_t nb_retired;
+	struct rte_hash_retired retired[RTE_HASH_RESIZE_MAX_GROW];
+	/**< Bucket arrays waiting for the readers. */
+	uint32_t nb_key_chunks;
+	void *key_chunks[RTE_HASH_RESIZE_MAX_GROW];
+	/**< Key store memory added by each growth. */
+};
+
 /** A hash table structure. */
 struct rte_hash {
 	char name[RTE_HASH_NAMESIZE];   /**< Name of the hash. */
@@ -204,11 +273,31 @@ struct rte_hash {
 	uint32_t key_entry_size;         /**< Size of each key entry. */
 
 	void *key_store;                /**< Table storing all keys and data */
+	uint32_t key_seg_base;
+	/**< Key indexes from this one are stored in key_segs, UINT32_MAX
+	 * unless the table is resizable.
+	 */
+	uint32_t key_seg_shift;
+	/**< Log2 of the number of keys in the first of key_segs. */
+	void **key_segs;
+	/**< Key store memory added by the resizes, each twice the size of
+	 * the previous one.
+	 */
+	struct rte_hash_resize *resize;
+	/**< Resize state, NULL unless the table is resizable. */
 	struct rte_hash_bucket *buckets;
 	/**< Table with buckets storing all the	hash values and key indexes
 	 * to the key table.
 	 */
+	struct rte_hash_inline_bkt *inline_bkts;
+	/**< Keys and data of each bucket, NULL unless they are inline. */
 	rte_rwlock_t *readwrite_lock; /**< Read-write lock thread-safety. */
+	struct rte_hash_bkt_lock *bkt_locks;
+	/**< Bucket locks of the writers, used instead of readwrite_lock
+	 * by multi-writer tables when the readers take no lock.
+	 */
+	uint32_t bkt_lock_mask;
+	/**< Bitmask for getting the lock index from a bucket index. */
 	struct rte_hash_bucket *buckets_ext; /**< Extra buckets array */
 	struct rte_ring *free_ext_bkts; /**< Ring of indexes of free buckets */
 	/* Stores index of an empty ext bkt to be recycled on calling
@@ -220,6 +309,10 @@ struct rte_hash {
 	uint32_t *ext_bkt_to_free;
 	uint32_t *tbl_chng_cnt;
 	/**< Indicates if the hash table changed from last read. */
+	uint64_t *key_ts;
+	/**< Last use time of each key slot, if aging is enabled. */
+	uint32_t age_next_bkt;
+	/**< Next bucket to be checked for expired keys. */
 } __rte_cache_aligned;
 
 struct queue_node {
@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_vect.h>
+
+#include "rte_cuckoo_hash_avx512.h"
+
+/* Index of the signature of each key, one per bucket entry */
+static const uint16_t sig_idx[32] __rte_aligned(64) = {
+	0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 1, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2,
+	3, 3, 3, 3, 3, 3, 3, 3,
+};
+
+/* Load the 8 signatures of 4 buckets, one bucket per 128-bit lane */
+static __rte_always_inline __m512i
+load_bucket_sigs_x4(const void **bkt)
+{
+	__m512i sigs;
+
+	sigs = _mm512_castsi128_si512(_mm_load_si128(bkt[0]));
+	sigs = _mm512_inserti32x4(sigs, _mm_load_si128(bkt[1]), 1);
+	sigs = _mm512_inserti32x4(sigs, _mm_load_si128(bkt[2]), 2);
+	return _mm512_inserti32x4(sigs, _mm_load_si128(bkt[3]), 3);
+}
+
+/* Turn a mask of 32 words into a mask of 64 bytes, 2 bits per word */
+static __rte_always_inline uint64_t
+word_to_byte_mask(__mmask32 mask)
+{
+	return _mm512_movepi8_mask(_mm512_movm_epi16(mask));
+}
+
+void
+rte_hash_compare_signatures_avx512(uint32_t *prim_hash_matches,
+		uint32_t *sec_hash_matches,
+		const void **prim_bkt, const void **sec_bkt,
+		uint16_t *sig, int32_t num_keys)
+{
+	const __m512i idx = _mm512_load_si512(sig_idx);
+	__m512i sigs, prim, sec;
+	uint64_t prim_mask, sec_mask;
+	__m128i sig1;
+	int32_t i, j;
+
+	for (i = 0; i + 4 <= num_keys; i += 4) {
+		/* Broadcast the signature of key j to the 128-bit lane j */
+		sigs = _mm512_permutexvar_epi16(idx, _mm512_castsi128_si512(
+				_mm_loadl_epi64((const __m128i *)&sig[i])));
+		prim = load_bucket_sigs_x4(&prim_bkt[i]);
+		sec = load_bucket_sigs_x4(&sec_bkt[i]);
+
+		prim_mask = word_to_byte_mask(
+				_mm512_cmpeq_epi16_mask(prim, sigs));
+		sec_mask = word_to_byte_mask(
+				_mm512_cmpeq_epi16_mask(sec, sigs));
+
+		for (j = 0; j < 4; j++) {
+			prim_hash_matches[i + j] = (uint16_t)(prim_mask >> (j << 4));
+			sec_hash_matches[i + j] = (uint16_t)(sec_mask >> (j << 4));
+		}
+	}
+
+	/* Remaining keys, one at a time */
+	for (; i < num_keys; i++) {
+		sig1 = _mm_set1_epi16(sig[i]);
+		prim_hash_matches[i] = _mm_movemask_epi8(_mm_cmpeq_epi16(
+				_mm_load_si128(prim_bkt[i]), sig1));
+		sec_hash_matches[i] = _mm_movemask_epi8(_mm_cmpeq_epi16(
+				_mm_load_si128(sec_bkt[i]), sig1));
+	}
+}
@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2026 agent
+ */
+
+#ifndef _RTE_CUCKOO_HASH_AVX512_H_
+#define _RTE_CUCKOO_HASH_AVX512_H_
+
+/*
+ * Compare the signatures of the primary and secondary buckets of a burst
+ * of keys, four keys at a time. The buckets are passed as pointers to their
+ * signature array, which is the first field of struct rte_hash_bucket.
+ * The match masks have the same layout as the SSE ones: two bits per
+ * entry, the first one indicating the match.
+ */
+void
+rte_hash_compare_signatures_avx512(uint32_t *prim_hash_matches,
+		uint32_t *sec_hash_matches,
+		const void **prim_bkt, const void **sec_bkt,
+		uint16_t *sig, int32_t num_keys);
+
+#endif /* _RTE_CUCKOO_HASH_AVX512_H_ */
@@ -52,7 +52,7 @@ rte_fbk_hash_find_existing(const char *name)
 				       rte_fbk_hash_list);
 
 	rte_mcfg_tailq_read_lock();
-	TAILQ_FOREACH(te, fbk_hash_list, next) {
+	RTE_TAILQ_FOREACH(te, fbk_hash_list, next) {
 		h = (struct rte_fbk_hash_table *) te->data;
 		if (strncmp(name, h->name, RTE_FBK_HASH_NAMESIZE) == 0)
 			break;
@@ -107,7 +107,7 @@ rte_fbk_hash_create(const struct rte_fbk_hash_params *params)
 	rte_mcfg_tailq_write_lock();
 
 	/* guarantee there's no existing */
-	TAILQ_FOREACH(te, fbk_hash_list, next) {
+	RTE_TAILQ_FOREACH(te, fbk_hash_list, next) {
 		ht = (struct rte_fbk_hash_table *) te->data;
 		if (strncmp(params->name, ht->name, RTE_FBK_HASH_NAMESIZE) == 0)
 			break;
@@ -163,7 +163,7 @@ rte_fbk_hash_create(const struct rte_fbk_hash_params *params)
 
 	te->data = (void *) ht;
 
-	TAILQ_INSERT_TAIL(fbk_hash_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(fbk_hash_list, te, next);
 
 exit:
 	rte_mcfg_tailq_write_unlock();
@@ -192,7 +192,7 @@ rte_fbk_hash_free(struct rte_fbk_hash_table *ht)
 	rte_mcfg_tailq_write_lock();
 
 	/* find out tailq entry */
-	TAILQ_FOREACH(te, fbk_hash_list, next) {
+	RTE_TAILQ_FOREACH(te, fbk_hash_list, next) {
 		if (te->data == (void *) ht)
 			break;
 	}
@@ -202,7 +202,7 @@ rte_fbk_hash_free(struct rte_fbk_hash_table *ht)
 		return;
 	}
 
-	TAILQ_REMOVE(fbk_hash_list, te, next);
+	RTE_TAILQ_REMOVE(fbk_hash_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
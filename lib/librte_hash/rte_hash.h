@@ -14,7 +14,9 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <rte_common.h>
 #include <rte_compat.h>
+#include <rte_rcu_qsbr.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -56,6 +58,41 @@ extern "C" {
  */
 #define RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF 0x20
 
+/** Flag to keep the last use time of each key, so that the keys which have
+ * not been used for a given time can be removed with rte_hash_age_scan().
+ */
+#define RTE_HASH_EXTRA_FLAGS_AGING 0x40
+
+/** Flag to disable the AVX512 signature compare of the bulk lookups,
+ * e.g. to avoid the frequency drop of AVX512 code on some CPUs.
+ * The SSE compare is used instead.
+ */
+#define RTE_HASH_EXTRA_FLAGS_NO_AVX512 0x80
+
+/** Flag, in extra_flag2, to store the keys, of up to RTE_HASH_INLINE_KEY_LEN
+ * bytes, and their data in the buckets as well as in the key store, so that
+ * lookups do not read the key store: the bucket and key lines are read in
+ * parallel, as they only depend on the hash, and the keys are compared with
+ * one 16-byte vector compare. It costs 24 more bytes per table entry.
+ * Currently, the extendable bucket table and the resizable tables are not
+ * supported with this feature.
+ */
+#define RTE_HASH_EXTRA_FLAGS2_INLINE_KEY 0x01
+
+/** Flag, in extra_flag2, to make the writers of a
+ * RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD table lock only the buckets they
+ * change, rather than the whole table, so that writers adding or deleting
+ * keys in different buckets do not wait for each other. The buckets share
+ * up to 1024 cache line sized locks.
+ * Currently, read/write concurrency with locks, the extendable bucket
+ * table, transactional memory and the resizable tables are not supported
+ * with this feature.
+ */
+#define RTE_HASH_EXTRA_FLAGS2_BKT_LOCK 0x02
+
+/** Maximum key length with RTE_HASH_EXTRA_FLAGS2_INLINE_KEY. */
+#define RTE_HASH_INLINE_KEY_LEN 16
+
 /**
  * The type of hash value of a key.
  * It should be a value of at least 32bit with fully random pattern.
@@ -75,7 +112,15 @@ typedef int (*rte_hash_cmp_eq_t)(const void *key1, const void *key2, size_t key_
 struct rte_hash_parameters {
 	const char *name;		/**< Name of the hash. */
 	uint32_t entries;		/**< Total hash table entries. */
-	uint32_t reserved;		/**< Unused field. Should be set to 0 */
+	RTE_STD_C11
+	union {
+		uint32_t reserved;	/**< Unused field. Should be set to 0 */
+		/** More flags, RTE_HASH_EXTRA_FLAGS2_*, as extra_flag is full.
+		 * It overlays the reserved field, which had to be 0, to keep
+		 * the layout of the structure.
+		 */
+		uint32_t extra_flag2;
+	};
 	uint32_t key_len;		/**< Length of hash key. */
 	rte_hash_function hash_func;	/**< Primary Hash function used to calculate hash. */
 	uint32_t hash_func_init_val;	/**< Init value used by hash_func. */
@@ -545,6 +590,168 @@ rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
  */
 int32_t
 rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32_t *next);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Refresh the last use time of a key, given its position.
+ * The time of a key is set when it is added (or its data updated),
+ * lookups do not change it. The application is expected to call this
+ * function with the position returned by a lookup when the key is used.
+ * The table must have been created with RTE_HASH_EXTRA_FLAGS_AGING.
+ * This operation is multi-thread safe.
+ *
+ * @param h
+ *   Hash table the key belongs to.
+ * @param position
+ *   Position returned when the key was added or looked up.
+ * @return
+ *   - 0 if the time is refreshed successfully
+ *   - -EINVAL if the parameters are invalid or aging is not enabled.
+ */
+__rte_experimental
+int
+rte_hash_age_touch(const struct rte_hash *h, const int32_t position);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Remove the keys which have not been used for a given time.
+ * The scan is incremental: each call walks at most @p budget buckets,
+ * starting where the previous call stopped and wrapping around at the end
+ * of the table, so that the cost of a call is bounded whatever the table
+ * size. Calling it periodically with a budget of num_buckets * period /
+ * timeout is enough to check all the keys within the timeout.
+ * The expired keys are deleted as with rte_hash_del_key(), and returned
+ * to the caller in bulk. The key pointers refer to the key store: they stay
+ * valid until the slot is reused by a new key, i.e. until
+ * rte_hash_free_key_with_position() is called on the returned position if
+ * RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL or
+ * RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF is enabled, or until the next add
+ * otherwise.
+ * The table must have been created with RTE_HASH_EXTRA_FLAGS_AGING.
+ * This operation has the same thread safety as rte_hash_del_key(),
+ * and must not be called from several threads at the same time.
+ * Keys touched by other threads during the scan are not removed: their
+ * time is checked again under the writer lock before they are deleted.
+ *
+ * @param h
+ *   Hash table to scan.
+ * @param timeout
+ *   Time, in TSC cycles, after which an unused key expires. Values larger
+ *   than INT64_MAX are handled as INT64_MAX.
+ * @param budget
+ *   Maximum number of buckets to scan.
+ * @param keys
+ *   Output with the pointers to the expired keys.
+ * @param data
+ *   Output with the data of the expired keys. Can be NULL.
+ * @param positions
+ *   Output with the positions of the expired keys. Can be NULL.
+ * @param max
+ *   Size of the output arrays. The scan stops early when they are full.
+ * @return
+ *   - Number of expired keys removed from the table.
+ *   - -EINVAL if the parameters are invalid or aging is not enabled.
+ */
+__rte_experimental
+int32_t
+rte_hash_age_scan(struct rte_hash *h, uint64_t timeout, uint32_t budget,
+		const void **keys, void **data, int32_t *positions,
+		uint32_t max);
+
+/** Default load, in percent of the entries, making a resizable table grow. */
+#define RTE_HASH_RESIZE_GROW_LOAD		80
+
+/** Default number of buckets migrated by each add while a table grows. */
+#define RTE_HASH_RESIZE_MIGRATE_BUDGET		8
+
+/**
+ * Parameters of a resizable hash table, see rte_hash_create_resizable().
+ */
+struct rte_hash_resize_params {
+	uint32_t max_entries;
+	/**< Number of entries the table can grow to. */
+	uint32_t grow_load;
+	/**< Percentage of the entries in use making the table grow,
+	 * 0 for RTE_HASH_RESIZE_GROW_LOAD.
+	 */
+	uint32_t migrate_budget;
+	/**< Number of buckets migrated by each add while the table grows,
+	 * 0 for RTE_HASH_RESIZE_MIGRATE_BUDGET.
+	 */
+	struct rte_rcu_qsbr *v;
+	/**< RCU QSBR variable of the lock free readers, used to free the
+	 * bucket arrays replaced by a resize. If NULL, they are freed with
+	 * the table.
+	 */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a hash table which grows with the number of keys it holds.
+ *
+ * The table starts with params->entries entries, rounded up to a power
+ * of two. When the keys in use reach the grow load, or an add finds no
+ * space, the number of entries is doubled up to rparams->max_entries:
+ * a bucket array twice as large is allocated, and key store memory is
+ * added for the new entries. The keys are then migrated from the old
+ * bucket array to the new one incrementally, a bounded number of buckets
+ * at a time, by the following adds or by rte_hash_resize_step(). In the
+ * meantime, lookups search both arrays, so their cost is bounded as well.
+ * The lock free reader writer concurrency of
+ * RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF is kept through the resizes.
+ *
+ * Keys keep their position when migrated, positions range from 0 to the
+ * current number of entries. Keys migrated while the table is iterated
+ * with rte_hash_iterate() may be skipped or returned twice.
+ *
+ * RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY, RTE_HASH_EXTRA_FLAGS_EXT_TABLE and
+ * RTE_HASH_EXTRA_FLAGS_AGING are not supported. With
+ * RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD, the writers take a lock and the
+ * key store slots are not cached per lcore.
+ *
+ * @param params
+ *   Parameters used to create and initialise the hash table.
+ * @param rparams
+ *   Resize parameters.
+ * @return
+ *   Pointer to hash table structure, or NULL on error with error code set
+ *   in rte_errno, as for rte_hash_create().
+ */
+__rte_experimental
+struct rte_hash *
+rte_hash_create_resizable(const struct rte_hash_parameters *params,
+		const struct rte_hash_resize_params *rparams);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Make progress on the resize of a resizable table: grow the table if
+ * the keys in use reached the grow load, migrate up to @p budget buckets
+ * to the new bucket array, and free the bucket arrays the readers are no
+ * longer using. Calling it periodically, e.g. from a control thread,
+ * keeps the migration work out of the adds.
+ * This operation has the same thread safety as rte_hash_add_key().
+ *
+ * @param h
+ *   Resizable hash table.
+ * @param budget
+ *   Maximum number of buckets to migrate.
+ * @return
+ *   - Number of buckets still to migrate, 0 when the table is not resizing.
+ *   - -EINVAL if the parameters are invalid or the table is not resizable.
+ *   - -ENOMEM if the table could not grow.
+ *   - -ENOSPC if a key could not be migrated.
+ */
+__rte_experimental
+int32_t
+rte_hash_resize_step(const struct rte_hash *h, uint32_t budget);
 #ifdef __cplusplus
 }
 #endif
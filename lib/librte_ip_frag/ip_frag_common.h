@@ -5,6 +5,8 @@
 #ifndef _IP_FRAG_COMMON_H_
 #define _IP_FRAG_COMMON_H_
 
+#include <rte_vect.h>
+
 #include "rte_ip_frag.h"
 
 /* logging macros. */
@@ -44,6 +46,9 @@ struct ip_frag_pkt * ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 	const struct ip_frag_key *key, uint64_t tms,
 	struct ip_frag_pkt **free, struct ip_frag_pkt **stale);
 
+uint32_t ip_frag_del_expired(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms, uint32_t max_num);
+
 /* these functions need to be declared here as ip_frag_process relies on them */
 struct rte_mbuf *ipv4_frag_reassemble(struct ip_frag_pkt *fp);
 struct rte_mbuf *ipv6_frag_reassemble(struct ip_frag_pkt *fp);
@@ -68,15 +73,51 @@ ip_frag_key_invalidate(struct ip_frag_key * key)
 	key->key_len = 0;
 }
 
-/* compare two keys */
+/*
+ * compare two keys, k1 being a valid key. IPv6 addresses are compared
+ * with two 16B vector loads per key where available.
+ */
 static inline uint64_t
 ip_frag_key_cmp(const struct ip_frag_key * k1, const struct ip_frag_key * k2)
 {
-	uint32_t i;
 	uint64_t val;
+
 	val = k1->id_key_len ^ k2->id_key_len;
-	for (i = 0; i < k1->key_len; i++)
-		val |= k1->src_dst[i] ^ k2->src_dst[i];
+	if (k1->key_len == IPV4_KEYLEN)
+		return val | (k1->src_dst[0] ^ k2->src_dst[0]);
+
+#if defined(RTE_ARCH_X86)
+	{
+		__m128i x, y;
+
+		x = _mm_xor_si128(
+			_mm_loadu_si128((const __m128i *)&k1->src_dst[0]),
+			_mm_loadu_si128((const __m128i *)&k2->src_dst[0]));
+		y = _mm_xor_si128(
+			_mm_loadu_si128((const __m128i *)&k1->src_dst[2]),
+			_mm_loadu_si128((const __m128i *)&k2->src_dst[2]));
+		x = _mm_or_si128(x, y);
+		val |= (_mm_movemask_epi8(_mm_cmpeq_epi8(x,
+				_mm_setzero_si128())) != 0xffff);
+	}
+#elif defined(RTE_ARCH_ARM64)
+	{
+		uint64x2_t x;
+
+		x = vorrq_u64(veorq_u64(vld1q_u64(&k1->src_dst[0]),
+					vld1q_u64(&k2->src_dst[0])),
+				veorq_u64(vld1q_u64(&k1->src_dst[2]),
+					vld1q_u64(&k2->src_dst[2])));
+		val |= vgetq_lane_u64(x, 0) | vgetq_lane_u64(x, 1);
+	}
+#else
+	{
+		uint32_t i;
+
+		for (i = 0; i < k1->key_len; i++)
+			val |= k1->src_dst[i] ^ k2->src_dst[i];
+	}
+#endif
 	return val;
 }
 
@@ -122,13 +163,23 @@ ip_frag_free_immediate(struct ip_frag_pkt *fp)
 	fp->last_idx = 0;
 }
 
-/* if key is empty, mark key as in use */
+/*
+ * if key is empty, the packet was either reassembled (mb != NULL) or
+ * dropped, so release the entry.
+ */
 static inline void
-ip_frag_inuse(struct rte_ip_frag_tbl *tbl, const struct  ip_frag_pkt *fp)
+ip_frag_inuse(struct rte_ip_frag_tbl *tbl, const struct  ip_frag_pkt *fp,
+	const struct rte_mbuf *mb)
 {
+	RTE_SET_USED(mb);
+
 	if (ip_frag_key_is_empty(&fp->key)) {
 		TAILQ_REMOVE(&tbl->lru, fp, lru);
 		tbl->use_entries--;
+		tbl->src_entries[fp->src_idx]--;
+		IP_FRAG_TBL_STAT_UPDATE(&tbl->stat, reassembled_num,
+			(mb != NULL));
+		IP_FRAG_TBL_STAT_UPDATE(&tbl->stat, invalid_num, (mb == NULL));
 	}
 }
 
@@ -159,6 +210,7 @@ ip_frag_tbl_del(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
 	ip_frag_key_invalidate(&fp->key);
 	TAILQ_REMOVE(&tbl->lru, fp, lru);
 	tbl->use_entries--;
+	tbl->src_entries[fp->src_idx]--;
 	IP_FRAG_TBL_STAT_UPDATE(&tbl->stat, del_num, 1);
 }
 
@@ -16,12 +16,14 @@
 
 static inline void
 ip_frag_tbl_add(struct rte_ip_frag_tbl *tbl,  struct ip_frag_pkt *fp,
-	const struct ip_frag_key *key, uint64_t tms)
+	const struct ip_frag_key *key, uint64_t tms, uint32_t src_idx)
 {
 	fp->key = key[0];
+	fp->src_idx = src_idx;
 	ip_frag_reset(fp, tms);
 	TAILQ_INSERT_TAIL(&tbl->lru, fp, lru);
 	tbl->use_entries++;
+	tbl->src_entries[src_idx]++;
 	IP_FRAG_TBL_STAT_UPDATE(&tbl->stat, add_num, 1);
 }
 
@@ -87,6 +89,38 @@ ipv6_frag_hash(const struct ip_frag_key *key, uint32_t *v1, uint32_t *v2)
 	*v2 = (v << 7) + (v >> 14);
 }
 
+/* index of the counter of the entries used by the source of a key */
+static inline uint32_t
+ip_frag_src_idx(const struct rte_ip_frag_tbl *tbl,
+	const struct ip_frag_key *key)
+{
+	uint32_t v;
+	const uint32_t *p;
+
+	/* the source address is at the beginning of the key */
+	p = (const uint32_t *)&key->src_dst;
+
+	if (key->key_len == IPV4_KEYLEN) {
+#ifdef RTE_ARCH_X86
+		v = rte_hash_crc_4byte(p[0], PRIME_VALUE);
+#else
+		v = rte_jhash_1word(p[0], PRIME_VALUE);
+#endif /* RTE_ARCH_X86 */
+	} else {
+#ifdef RTE_ARCH_X86
+		v = rte_hash_crc_4byte(p[0], PRIME_VALUE);
+		v = rte_hash_crc_4byte(p[1], v);
+		v = rte_hash_crc_4byte(p[2], v);
+		v = rte_hash_crc_4byte(p[3], v);
+#else
+		v = rte_jhash_2words(p[0], p[1], PRIME_VALUE);
+		v = rte_jhash_2words(p[2], p[3], v);
+#endif /* RTE_ARCH_X86 */
+	}
+
+	return v & tbl->src_mask;
+}
+
 struct rte_mbuf *
 ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
 	struct rte_mbuf *mb, uint16_t ofs, uint16_t len, uint16_t more_frags)
@@ -225,6 +259,7 @@ ip_frag_find(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
 {
 	struct ip_frag_pkt *pkt, *free, *stale, *lru;
 	uint64_t max_cycles;
+	uint32_t src_idx;
 
 	/*
 	 * Actually the two line below are totally redundant.
@@ -260,9 +295,24 @@ ip_frag_find(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
 			}
 		}
 
+		/*
+		 * check that the source of the packet doesn't use more
+		 * entries than allowed.
+		 */
+		if (free != NULL) {
+			src_idx = ip_frag_src_idx(tbl, key);
+			if (tbl->max_src_entries != 0 &&
+					tbl->src_entries[src_idx] >=
+					tbl->max_src_entries) {
+				free = NULL;
+				IP_FRAG_TBL_STAT_UPDATE(&tbl->stat,
+					fail_src_limit, 1);
+			}
+		}
+
 		/* found a free entry to reuse. */
 		if (free != NULL) {
-			ip_frag_tbl_add(tbl,  free, key, tms);
+			ip_frag_tbl_add(tbl,  free, key, tms, src_idx);
 			pkt = free;
 		}
 
@@ -367,3 +417,30 @@ ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 	*stale = old;
 	return NULL;
 }
+
+/*
+ * Delete up to max_num expired entries. The LRU list is sorted by
+ * creation time, so stop at the first entry which isn't expired.
+ */
+uint32_t
+ip_frag_del_expired(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms, uint32_t max_num)
+{
+	struct ip_frag_pkt *fp;
+	uint64_t max_cycles;
+	uint32_t n;
+
+	max_cycles = tbl->max_cycles;
+
+	for (n = 0; n != max_num; n++) {
+		fp = TAILQ_FIRST(&tbl->lru);
+		if (fp == NULL || max_cycles + fp->start >= tms)
+			break;
+		/* check that death row has enough space */
+		if (IP_FRAG_DEATH_ROW_MBUF_LEN - dr->cnt < fp->last_idx)
+			break;
+		ip_frag_tbl_del(tbl, dr, fp);
+	}
+
+	return n;
+}
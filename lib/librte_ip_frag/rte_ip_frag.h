@@ -68,6 +68,7 @@ struct ip_frag_pkt {
 	uint32_t             total_size;  /**< expected reassembled size */
 	uint32_t             frag_size;   /**< size of fragments received */
 	uint32_t             last_idx;    /**< index of next entry to fill */
+	uint32_t             src_idx;     /**< index of the source counter */
 	struct ip_frag       frags[IP_MAX_FRAG_NUM]; /**< fragments */
 } __rte_cache_aligned;
 
@@ -93,6 +94,9 @@ struct ip_frag_tbl_stat {
 	uint64_t reuse_num;     /**< # of reuse (del/add) ops. */
 	uint64_t fail_total;    /**< total # of add failures. */
 	uint64_t fail_nospace;  /**< # of 'no space' add failures. */
+	uint64_t fail_src_limit; /**< # of 'source limit' add failures. */
+	uint64_t reassembled_num; /**< # of reassembled packets. */
+	uint64_t invalid_num;   /**< # of invalid fragmented packets. */
 } __rte_cache_aligned;
 
 /** fragmentation table */
@@ -104,6 +108,9 @@ struct rte_ip_frag_tbl {
 	uint32_t             bucket_entries;  /**< hash associativity. */
 	uint32_t             nb_entries;      /**< total size of the table. */
 	uint32_t             nb_buckets;      /**< num of associativity lines. */
+	uint32_t             max_src_entries; /**< max entries per source. */
+	uint32_t             src_mask;        /**< source hash value mask. */
+	uint32_t            *src_entries;     /**< entries in use per source. */
 	struct ip_frag_pkt *last;         /**< last used entry. */
 	struct ip_pkt_list lru;           /**< LRU list for table entries. */
 	struct ip_frag_tbl_stat stat;     /**< statistics counters. */
@@ -353,6 +360,57 @@ void
 rte_frag_table_del_expired_entries(struct rte_ip_frag_tbl *tbl,
 	struct rte_ip_frag_death_row *dr, uint64_t tms);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Delete at most max_num expired fragmented packets, oldest first.
+ * Unlike rte_frag_table_del_expired_entries(), the time spent is bounded
+ * by max_num, so it can be called from the idle loop of an lcore to
+ * release the entries of datagrams which will never complete, instead of
+ * waiting for their entries to be looked up again.
+ *
+ * @param tbl
+ *   Table to delete expired fragments from
+ * @param dr
+ *   Death row to free buffers to. Deletion stops when it is full.
+ * @param tms
+ *   Current timestamp
+ * @param max_num
+ *   Maximum number of fragmented packets to delete
+ * @return
+ *   The number of deleted fragmented packets
+ */
+__rte_experimental
+uint32_t
+rte_ip_frag_table_del_expired_bulk(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms, uint32_t max_num);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Limit the number of table entries used by fragmented packets from a
+ * single source address, so that a flood of fragments which never
+ * complete can't take the entries of other sources. The fragments of a
+ * new packet from a source over its limit are dropped.
+ *
+ * Sources are counted by the hash of their address in an array as large
+ * as the table, so a few sources may share the same limit.
+ *
+ * @param tbl
+ *   Fragmentation table
+ * @param max_src_entries
+ *   Maximum number of entries per source address, 0 for no limit
+ *   (the default).
+ * @return
+ *   0 on success, -EINVAL for invalid parameters.
+ */
+__rte_experimental
+int
+rte_ip_frag_table_set_src_limit(struct rte_ip_frag_tbl *tbl,
+	uint32_t max_src_entries);
+
 #ifdef __cplusplus
 }
 #endif
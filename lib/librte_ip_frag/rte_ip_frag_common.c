@@ -4,6 +4,7 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#include <errno.h>
 
 #include <rte_memory.h>
 #include <rte_log.h>
@@ -57,7 +58,9 @@ rte_ip_frag_table_create(uint32_t bucket_num, uint32_t bucket_entries,
 		return NULL;
 	}
 
-	sz = sizeof (*tbl) + nb_entries * sizeof (tbl->pkt[0]);
+	/* the per source counters follow the hash table */
+	sz = sizeof (*tbl) + nb_entries * sizeof (tbl->pkt[0]) +
+		nb_entries * sizeof (tbl->src_entries[0]);
 	if ((tbl = rte_zmalloc_socket(__func__, sz, RTE_CACHE_LINE_SIZE,
 			socket_id)) == NULL) {
 		RTE_LOG(ERR, USER1,
@@ -75,6 +78,8 @@ rte_ip_frag_table_create(uint32_t bucket_num, uint32_t bucket_entries,
 	tbl->nb_buckets = bucket_num;
 	tbl->bucket_entries = bucket_entries;
 	tbl->entry_mask = (tbl->nb_entries - 1) & ~(tbl->bucket_entries  - 1);
+	tbl->src_entries = (uint32_t *)(tbl->pkt + nb_entries);
+	tbl->src_mask = tbl->nb_entries - 1;
 
 	TAILQ_INIT(&(tbl->lru));
 	return tbl;
@@ -97,10 +102,11 @@ rte_ip_frag_table_destroy(struct rte_ip_frag_tbl *tbl)
 void
 rte_ip_frag_table_statistics_dump(FILE *f, const struct rte_ip_frag_tbl *tbl)
 {
-	uint64_t fail_total, fail_nospace;
+	uint64_t fail_total, fail_nospace, fail_src_limit;
 
 	fail_total = tbl->stat.fail_total;
 	fail_nospace = tbl->stat.fail_nospace;
+	fail_src_limit = tbl->stat.fail_src_limit;
 
 	fprintf(f, "max entries:\t%u;\n"
 		"entries in use:\t%u;\n"
@@ -110,7 +116,10 @@ rte_ip_frag_table_statistics_dump(FILE *f, const struct rte_ip_frag_tbl *tbl)
 		"entries reused by timeout:\t%" PRIu64 ";\n"
 		"total add failures:\t%" PRIu64 ";\n"
 		"add no-space failures:\t%" PRIu64 ";\n"
-		"add hash-collisions failures:\t%" PRIu64 ";\n",
+		"add source limit failures:\t%" PRIu64 ";\n"
+		"add hash-collisions failures:\t%" PRIu64 ";\n"
+		"packets reassembled:\t%" PRIu64 ";\n"
+		"invalid packets dropped:\t%" PRIu64 ";\n",
 		tbl->max_entries,
 		tbl->use_entries,
 		tbl->stat.find_num,
@@ -119,7 +128,10 @@ rte_ip_frag_table_statistics_dump(FILE *f, const struct rte_ip_frag_tbl *tbl)
 		tbl->stat.reuse_num,
 		fail_total,
 		fail_nospace,
-		fail_total - fail_nospace);
+		fail_src_limit,
+		fail_total - fail_nospace - fail_src_limit,
+		tbl->stat.reassembled_num,
+		tbl->stat.invalid_num);
 }
 
 /* Delete expired fragments */
@@ -127,18 +139,25 @@ void
 rte_frag_table_del_expired_entries(struct rte_ip_frag_tbl *tbl,
 	struct rte_ip_frag_death_row *dr, uint64_t tms)
 {
-	uint64_t max_cycles;
-	struct ip_frag_pkt *fp;
+	ip_frag_del_expired(tbl, dr, tms, UINT32_MAX);
+}
+
+/* Delete a bounded number of expired fragments */
+uint32_t
+rte_ip_frag_table_del_expired_bulk(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms, uint32_t max_num)
+{
+	return ip_frag_del_expired(tbl, dr, tms, max_num);
+}
+
+/* Limit the number of entries per source address */
+int
+rte_ip_frag_table_set_src_limit(struct rte_ip_frag_tbl *tbl,
+	uint32_t max_src_entries)
+{
+	if (tbl == NULL)
+		return -EINVAL;
 
-	max_cycles = tbl->max_cycles;
-
-	TAILQ_FOREACH(fp, &tbl->lru, lru)
-		if (max_cycles + fp->start < tms) {
-			/* check that death row has enough space */
-			if (IP_FRAG_DEATH_ROW_MBUF_LEN - dr->cnt >= fp->last_idx)
-				ip_frag_tbl_del(tbl, dr, fp);
-			else
-				return;
-		} else
-			return;
+	tbl->max_src_entries = max_src_entries;
+	return 0;
 }
@@ -124,7 +124,7 @@ __rte_kni_get(const char *name)
 
 	kni_list = RTE_TAILQ_CAST(rte_kni_tailq.head, rte_kni_list);
 
-	TAILQ_FOREACH(te, kni_list, next) {
+	RTE_TAILQ_FOREACH(te, kni_list, next) {
 		kni = te->data;
 		if (strncmp(name, kni->name, RTE_KNI_NAMESIZE) == 0)
 			break;
@@ -309,7 +309,7 @@ rte_kni_alloc(struct rte_mempool *pktmbuf_pool,
 	te->data = kni;
 
 	kni_list = RTE_TAILQ_CAST(rte_kni_tailq.head, rte_kni_list);
-	TAILQ_INSERT_TAIL(kni_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(kni_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
@@ -403,7 +403,7 @@ rte_kni_release(struct rte_kni *kni)
 
 	rte_mcfg_tailq_write_lock();
 
-	TAILQ_FOREACH(te, kni_list, next) {
+	RTE_TAILQ_FOREACH(te, kni_list, next) {
 		if (te->data == kni)
 			break;
 	}
@@ -417,7 +417,7 @@ rte_kni_release(struct rte_kni *kni)
 		goto unlock;
 	}
 
-	TAILQ_REMOVE(kni_list, te, next);
+	RTE_TAILQ_REMOVE(kni_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
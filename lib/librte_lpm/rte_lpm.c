@@ -99,7 +99,7 @@ rte_lpm_find_existing_v20(const char *name)
 	lpm_list = RTE_TAILQ_CAST(rte_lpm_tailq.head, rte_lpm_list);
 
 	rte_mcfg_tailq_read_lock();
-	TAILQ_FOREACH(te, lpm_list, next) {
+	RTE_TAILQ_FOREACH(te, lpm_list, next) {
 		l = te->data;
 		if (strncmp(name, l->name, RTE_LPM_NAMESIZE) == 0)
 			break;
@@ -125,7 +125,7 @@ rte_lpm_find_existing_v1604(const char *name)
 	lpm_list = RTE_TAILQ_CAST(rte_lpm_tailq.head, rte_lpm_list);
 
 	rte_mcfg_tailq_read_lock();
-	TAILQ_FOREACH(te, lpm_list, next) {
+	RTE_TAILQ_FOREACH(te, lpm_list, next) {
 		l = te->data;
 		if (strncmp(name, l->name, RTE_LPM_NAMESIZE) == 0)
 			break;
@@ -174,7 +174,7 @@ rte_lpm_create_v20(const char *name, int socket_id, int max_rules,
 	rte_mcfg_tailq_write_lock();
 
 	/* guarantee there's no existing */
-	TAILQ_FOREACH(te, lpm_list, next) {
+	RTE_TAILQ_FOREACH(te, lpm_list, next) {
 		lpm = te->data;
 		if (strncmp(name, lpm->name, RTE_LPM_NAMESIZE) == 0)
 			break;
@@ -210,7 +210,7 @@ rte_lpm_create_v20(const char *name, int socket_id, int max_rules,
 
 	te->data = lpm;
 
-	TAILQ_INSERT_TAIL(lpm_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(lpm_list, te, next);
 
 exit:
 	rte_mcfg_tailq_write_unlock();
@@ -251,7 +251,7 @@ rte_lpm_create_v1604(const char *name, int socket_id,
 	rte_mcfg_tailq_write_lock();
 
 	/* guarantee there's no existing */
-	TAILQ_FOREACH(te, lpm_list, next) {
+	RTE_TAILQ_FOREACH(te, lpm_list, next) {
 		lpm = te->data;
 		if (strncmp(name, lpm->name, RTE_LPM_NAMESIZE) == 0)
 			break;
@@ -313,7 +313,7 @@ rte_lpm_create_v1604(const char *name, int socket_id,
 
 	te->data = lpm;
 
-	TAILQ_INSERT_TAIL(lpm_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(lpm_list, te, next);
 
 exit:
 	rte_mcfg_tailq_write_unlock();
@@ -343,12 +343,12 @@ rte_lpm_free_v20(struct rte_lpm_v20 *lpm)
 	rte_mcfg_tailq_write_lock();
 
 	/* find our tailq entry */
-	TAILQ_FOREACH(te, lpm_list, next) {
+	RTE_TAILQ_FOREACH(te, lpm_list, next) {
 		if (te->data == (void *) lpm)
 			break;
 	}
 	if (te != NULL)
-		TAILQ_REMOVE(lpm_list, te, next);
+		RTE_TAILQ_REMOVE(lpm_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
@@ -372,15 +372,20 @@ rte_lpm_free_v1604(struct rte_lpm *lpm)
 	rte_mcfg_tailq_write_lock();
 
 	/* find our tailq entry */
-	TAILQ_FOREACH(te, lpm_list, next) {
+	RTE_TAILQ_FOREACH(te, lpm_list, next) {
 		if (te->data == (void *) lpm)
 			break;
 	}
 	if (te != NULL)
-		TAILQ_REMOVE(lpm_list, te, next);
+		RTE_TAILQ_REMOVE(lpm_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
+	if (lpm->dq != NULL) {
+		/* Wait for the readers so that nothing is left pending */
+		rte_rcu_qsbr_synchronize(lpm->v, RTE_QSBR_THRID_INVALID);
+		rte_rcu_qsbr_dq_delete(lpm->dq);
+	}
 	rte_free(lpm->tbl8);
 	rte_free(lpm->rules_tbl);
 	rte_free(lpm);
@@ -390,6 +395,72 @@ BIND_DEFAULT_SYMBOL(rte_lpm_free, _v1604, 16.04);
 MAP_STATIC_SYMBOL(void rte_lpm_free(struct rte_lpm *lpm),
 		rte_lpm_free_v1604);
 
+/*
+ * Called by the RCU defer queue once no reader can reference the
+ * tbl8 group any more.
+ */
+static void
+__lpm_rcu_qsbr_free_resource(void *p, void *data, unsigned int n)
+{
+	struct rte_lpm_tbl_entry zero_tbl8_entry = {0};
+	struct rte_lpm_tbl_entry *tbl8 = (struct rte_lpm_tbl_entry *)p;
+	uint32_t tbl8_group_start = *(uint32_t *)data;
+
+	RTE_SET_USED(n);
+	/* Set tbl8 group invalid */
+	__atomic_store(&tbl8[tbl8_group_start], &zero_tbl8_entry,
+			__ATOMIC_RELAXED);
+}
+
+/* Associate QSBR variable with an LPM object.
+ */
+int
+rte_lpm_rcu_qsbr_add(struct rte_lpm *lpm, struct rte_lpm_rcu_config *cfg,
+	struct rte_rcu_qsbr_dq **dq)
+{
+	char rcu_dq_name[RTE_RCU_QSBR_DQ_NAMESIZE];
+	struct rte_rcu_qsbr_dq_parameters params = {0};
+
+	if ((lpm == NULL) || (cfg == NULL) || (cfg->v == NULL))
+		return -EINVAL;
+
+	if (lpm->v != NULL)
+		return -EEXIST;
+
+	if (cfg->mode == RTE_LPM_QSBR_MODE_DQ) {
+		/* Init QSBR defer queue. */
+		snprintf(rcu_dq_name, sizeof(rcu_dq_name),
+				"LPM_RCU_%s", lpm->name);
+		params.name = rcu_dq_name;
+		params.flags = RTE_RCU_QSBR_DQ_MT_UNSAFE;
+		params.size = cfg->dq_size;
+		if (params.size == 0)
+			params.size = lpm->number_tbl8s;
+		params.trigger_reclaim_limit = cfg->reclaim_thd;
+		params.max_reclaim_size = cfg->reclaim_max;
+		if (params.max_reclaim_size == 0)
+			params.max_reclaim_size = RTE_LPM_RCU_DQ_RECLAIM_MAX;
+		params.esize = sizeof(uint32_t);	/* tbl8 group start */
+		params.free_fn = __lpm_rcu_qsbr_free_resource;
+		params.p = lpm->tbl8;
+		params.v = cfg->v;
+		lpm->dq = rte_rcu_qsbr_dq_create(&params);
+		if (lpm->dq == NULL) {
+			RTE_LOG(ERR, LPM, "LPM defer queue creation failed\n");
+			return -ENOMEM;
+		}
+		if (dq != NULL)
+			*dq = lpm->dq;
+	} else if (cfg->mode != RTE_LPM_QSBR_MODE_SYNC) {
+		return -EINVAL;
+	}
+
+	lpm->rcu_mode = cfg->mode;
+	lpm->v = cfg->v;
+
+	return 0;
+}
+
 /*
  * Adds a rule to the rule table.
  *
@@ -679,7 +750,7 @@ tbl8_alloc_v20(struct rte_lpm_tbl_entry_v20 *tbl8)
 }
 
 static int32_t
-tbl8_alloc_v1604(struct rte_lpm_tbl_entry *tbl8, uint32_t number_tbl8s)
+_tbl8_alloc_v1604(struct rte_lpm_tbl_entry *tbl8, uint32_t number_tbl8s)
 {
 	uint32_t group_idx; /* tbl8 group index. */
 	struct rte_lpm_tbl_entry *tbl8_entry;
@@ -727,13 +798,42 @@ tbl8_free_v20(struct rte_lpm_tbl_entry_v20 *tbl8, uint32_t tbl8_group_start)
 			__ATOMIC_RELAXED);
 }
 
+static int32_t
+tbl8_alloc_v1604(struct rte_lpm *lpm)
+{
+	int32_t group_idx; /* tbl8 group index. */
+
+	group_idx = _tbl8_alloc_v1604(lpm->tbl8, lpm->number_tbl8s);
+	if (group_idx == -ENOSPC && lpm->dq != NULL) {
+		/* If there are no tbl8 groups try to reclaim some. */
+		if (rte_rcu_qsbr_dq_reclaim(lpm->dq, lpm->number_tbl8s,
+				NULL, NULL, NULL) == 0)
+			group_idx = _tbl8_alloc_v1604(lpm->tbl8,
+					lpm->number_tbl8s);
+	}
+
+	return group_idx;
+}
+
 static void
-tbl8_free_v1604(struct rte_lpm_tbl_entry *tbl8, uint32_t tbl8_group_start)
+tbl8_free_v1604(struct rte_lpm *lpm, uint32_t tbl8_group_start)
 {
 	/* Set tbl8 group invalid*/
 	struct rte_lpm_tbl_entry zero_tbl8_entry = {0};
 
-	__atomic_store(&tbl8[tbl8_group_start], &zero_tbl8_entry,
+	if (lpm->v != NULL && lpm->rcu_mode == RTE_LPM_QSBR_MODE_DQ) {
+		/* Push into QSBR defer queue. */
+		if (rte_rcu_qsbr_dq_enqueue(lpm->dq,
+				(void *)&tbl8_group_start) == 0)
+			return;
+		/* Defer queue is full, fall back to blocking reclaim. */
+	}
+	if (lpm->v != NULL) {
+		/* Wait for quiescent state change. */
+		rte_rcu_qsbr_synchronize(lpm->v, RTE_QSBR_THRID_INVALID);
+	}
+
+	__atomic_store(&lpm->tbl8[tbl8_group_start], &zero_tbl8_entry,
 			__ATOMIC_RELAXED);
 }
 
@@ -1037,7 +1137,7 @@ add_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 
 	if (!lpm->tbl24[tbl24_index].valid) {
 		/* Search for a free tbl8 group. */
-		tbl8_group_index = tbl8_alloc_v1604(lpm->tbl8, lpm->number_tbl8s);
+		tbl8_group_index = tbl8_alloc_v1604(lpm);
 
 		/* Check tbl8 allocation was successful. */
 		if (tbl8_group_index < 0) {
@@ -1083,7 +1183,7 @@ add_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 	} /* If valid entry but not extended calculate the index into Table8. */
 	else if (lpm->tbl24[tbl24_index].valid_group == 0) {
 		/* Search for free tbl8 group. */
-		tbl8_group_index = tbl8_alloc_v1604(lpm->tbl8, lpm->number_tbl8s);
+		tbl8_group_index = tbl8_alloc_v1604(lpm);
 
 		if (tbl8_group_index < 0) {
 			return tbl8_group_index;
@@ -1818,7 +1918,7 @@ delete_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked,
 		 */
 		lpm->tbl24[tbl24_index].valid = 0;
 		__atomic_thread_fence(__ATOMIC_RELEASE);
-		tbl8_free_v1604(lpm->tbl8, tbl8_group_start);
+		tbl8_free_v1604(lpm, tbl8_group_start);
 	} else if (tbl8_recycle_index > -1) {
 		/* Update tbl24 entry. */
 		struct rte_lpm_tbl_entry new_tbl24_entry = {
@@ -1834,7 +1934,7 @@ delete_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked,
 		__atomic_store(&lpm->tbl24[tbl24_index], &new_tbl24_entry,
 				__ATOMIC_RELAXED);
 		__atomic_thread_fence(__ATOMIC_RELEASE);
-		tbl8_free_v1604(lpm->tbl8, tbl8_group_start);
+		tbl8_free_v1604(lpm, tbl8_group_start);
 	}
 #undef group_idx
 	return 0;
@@ -1976,6 +2076,15 @@ VERSION_SYMBOL(rte_lpm_delete_all, _v20, 2.0);
 void
 rte_lpm_delete_all_v1604(struct rte_lpm *lpm)
 {
+	/* Drain the defer queue so that no pending reclamation touches
+	 * a tbl8 group after it has been reused.
+	 */
+	if (lpm->dq != NULL) {
+		rte_rcu_qsbr_synchronize(lpm->v, RTE_QSBR_THRID_INVALID);
+		rte_rcu_qsbr_dq_reclaim(lpm->dq, lpm->number_tbl8s,
+				NULL, NULL, NULL);
+	}
+
 	/* Zero rule information. */
 	memset(lpm->rule_info, 0, sizeof(lpm->rule_info));
 
@@ -112,6 +112,11 @@ struct rte_lpm6 {
 
 	struct rte_lpm_tbl8_hdr *tbl8_hdrs; /* array of tbl8 headers */
 
+	/* RCU config. */
+	struct rte_rcu_qsbr *v;		/**< RCU QSBR variable. */
+	enum rte_lpm6_qsbr_mode rcu_mode;/**< Blocking, defer queue. */
+	struct rte_rcu_qsbr_dq *dq;	/**< RCU QSBR defer queue. */
+
 	struct rte_lpm6_tbl_entry tbl8[0]
 			__rte_cache_aligned; /**< LPM tbl8 table. */
 };
@@ -213,6 +218,55 @@ tbl8_available(struct rte_lpm6 *lpm)
 	return lpm->number_tbl8s - lpm->tbl8_pool_pos;
 }
 
+/*
+ * Release a tbl8 unlinked from the tree. With RCU the tbl8 only goes
+ * back to the pool once the readers can no longer reference it.
+ */
+static void
+tbl8_release(struct rte_lpm6 *lpm, uint32_t tbl8_ind)
+{
+	if (lpm->v != NULL && lpm->rcu_mode == RTE_LPM6_QSBR_MODE_DQ) {
+		/* Push into QSBR defer queue. */
+		if (rte_rcu_qsbr_dq_enqueue(lpm->dq, (void *)&tbl8_ind) == 0)
+			return;
+		/* Defer queue is full, fall back to blocking reclaim. */
+	}
+	if (lpm->v != NULL) {
+		/* Wait for quiescent state change. */
+		rte_rcu_qsbr_synchronize(lpm->v, RTE_QSBR_THRID_INVALID);
+	}
+
+	tbl8_put(lpm, tbl8_ind);
+}
+
+/*
+ * Return tbl8s parked on the defer queue to the pool. With 'wait'
+ * set, all of them are returned, which is needed before the pool
+ * is reinitialized.
+ */
+static void
+tbl8_reclaim(struct rte_lpm6 *lpm, int wait)
+{
+	if (lpm->dq == NULL)
+		return;
+
+	if (wait)
+		rte_rcu_qsbr_synchronize(lpm->v, RTE_QSBR_THRID_INVALID);
+	rte_rcu_qsbr_dq_reclaim(lpm->dq, lpm->number_tbl8s, NULL, NULL, NULL);
+}
+
+/*
+ * Called by the RCU defer queue once no reader can reference the tbl8.
+ */
+static void
+__lpm6_rcu_qsbr_free_resource(void *p, void *data, unsigned int n)
+{
+	struct rte_lpm6 *lpm = (struct rte_lpm6 *)p;
+
+	RTE_SET_USED(n);
+	tbl8_put(lpm, *(uint32_t *)data);
+}
+
 /*
  * Init a rule key.
  *	  note that ip must be already masked
@@ -320,7 +374,7 @@ rte_lpm6_create(const char *name, int socket_id,
 	rte_mcfg_tailq_write_lock();
 
 	/* Guarantee there's no existing */
-	TAILQ_FOREACH(te, lpm_list, next) {
+	RTE_TAILQ_FOREACH(te, lpm_list, next) {
 		lpm = (struct rte_lpm6 *) te->data;
 		if (strncmp(name, lpm->name, RTE_LPM6_NAMESIZE) == 0)
 			break;
@@ -363,7 +417,7 @@ rte_lpm6_create(const char *name, int socket_id,
 
 	te->data = (void *) lpm;
 
-	TAILQ_INSERT_TAIL(lpm_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(lpm_list, te, next);
 	rte_mcfg_tailq_write_unlock();
 	return lpm;
 
@@ -391,7 +445,7 @@ rte_lpm6_find_existing(const char *name)
 	lpm_list = RTE_TAILQ_CAST(rte_lpm6_tailq.head, rte_lpm6_list);
 
 	rte_mcfg_tailq_read_lock();
-	TAILQ_FOREACH(te, lpm_list, next) {
+	RTE_TAILQ_FOREACH(te, lpm_list, next) {
 		l = (struct rte_lpm6 *) te->data;
 		if (strncmp(name, l->name, RTE_LPM6_NAMESIZE) == 0)
 			break;
@@ -424,16 +478,20 @@ rte_lpm6_free(struct rte_lpm6 *lpm)
 	rte_mcfg_tailq_write_lock();
 
 	/* find our tailq entry */
-	TAILQ_FOREACH(te, lpm_list, next) {
+	RTE_TAILQ_FOREACH(te, lpm_list, next) {
 		if (te->data == (void *) lpm)
 			break;
 	}
 
 	if (te != NULL)
-		TAILQ_REMOVE(lpm_list, te, next);
+		RTE_TAILQ_REMOVE(lpm_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
+	if (lpm->dq != NULL) {
+		tbl8_reclaim(lpm, 1);
+		rte_rcu_qsbr_dq_delete(lpm->dq);
+	}
 	rte_free(lpm->tbl8_hdrs);
 	rte_free(lpm->tbl8_pool);
 	rte_hash_free(lpm->rules_tbl);
@@ -441,6 +499,56 @@ rte_lpm6_free(struct rte_lpm6 *lpm)
 	rte_free(te);
 }
 
+/*
+ * Associate QSBR variable with an LPM6 object.
+ */
+int
+rte_lpm6_rcu_qsbr_add(struct rte_lpm6 *lpm, struct rte_lpm6_rcu_config *cfg,
+	struct rte_rcu_qsbr_dq **dq)
+{
+	char rcu_dq_name[RTE_RCU_QSBR_DQ_NAMESIZE];
+	struct rte_rcu_qsbr_dq_parameters params = {0};
+
+	if ((lpm == NULL) || (cfg == NULL) || (cfg->v == NULL))
+		return -EINVAL;
+
+	if (lpm->v != NULL)
+		return -EEXIST;
+
+	if (cfg->mode == RTE_LPM6_QSBR_MODE_DQ) {
+		/* Init QSBR defer queue. */
+		snprintf(rcu_dq_name, sizeof(rcu_dq_name),
+				"LPM6_RCU_%s", lpm->name);
+		params.name = rcu_dq_name;
+		params.flags = RTE_RCU_QSBR_DQ_MT_UNSAFE;
+		params.size = cfg->dq_size;
+		if (params.size == 0)
+			params.size = lpm->number_tbl8s;
+		params.trigger_reclaim_limit = cfg->reclaim_thd;
+		params.max_reclaim_size = cfg->reclaim_max;
+		if (params.max_reclaim_size == 0)
+			params.max_reclaim_size = RTE_LPM6_RCU_DQ_RECLAIM_MAX;
+		params.esize = sizeof(uint32_t);	/* tbl8 index */
+		params.free_fn = __lpm6_rcu_qsbr_free_resource;
+		params.p = lpm;
+		params.v = cfg->v;
+		lpm->dq = rte_rcu_qsbr_dq_create(&params);
+		if (lpm->dq == NULL) {
+			RTE_LOG(ERR, LPM, "LPM6 defer queue creation failed\n");
+			return -ENOMEM;
+		}
+		if (dq != NULL)
+			*dq = lpm->dq;
+	} else if (cfg->mode != RTE_LPM6_QSBR_MODE_SYNC) {
+		return -EINVAL;
+	}
+
+	lpm->rcu_mode = cfg->mode;
+	lpm->v = cfg->v;
+
+	return 0;
+}
+
 /* Find a rule */
 static inline int
 rule_find_with_key(struct rte_lpm6 *lpm,
@@ -854,6 +962,10 @@ simulate_add(struct rte_lpm6 *lpm, const uint8_t *masked_ip, uint8_t depth)
 		total_need_tbl_nb += need_tbl_nb;
 	}
 
+	if (tbl8_available(lpm) < total_need_tbl_nb)
+		/* try to get back the tbl8s waiting for the readers */
+		tbl8_reclaim(lpm, 0);
+
 	if (tbl8_available(lpm) < total_need_tbl_nb)
 		/* not enought tbl8 to add a rule */
 		return -ENOSPC;
@@ -1189,6 +1301,11 @@ rte_lpm6_delete_bulk_func(struct rte_lpm6 *lpm,
 		rule_delete(lpm, masked_ip, depths[i]);
 	}
 
+	/* tbl8s parked on the defer queue must not be put back to the
+	 * pool after it is reinitialized
+	 */
+	tbl8_reclaim(lpm, 1);
+
 	/*
 	 * Set all the table entries to 0 (ie delete every rule
 	 * from the data structure.
@@ -1213,6 +1330,11 @@ rte_lpm6_delete_bulk_func(struct rte_lpm6 *lpm,
 void
 rte_lpm6_delete_all(struct rte_lpm6 *lpm)
 {
+	/* Return the tbl8s waiting for the readers before
+	 * reinitializing the pool
+	 */
+	tbl8_reclaim(lpm, 1);
+
 	/* Zero used rules counter. */
 	lpm->used_rules = 0;
 
@@ -1387,7 +1509,7 @@ remove_tbl(struct rte_lpm6 *lpm, struct rte_lpm_tbl8_hdr *tbl_hdr,
 	}
 
 	/* return the table to the pool */
-	tbl8_put(lpm, tbl_ind);
+	tbl8_release(lpm, tbl_ind);
 }
 
 /*
@@ -277,6 +277,132 @@ rte_pktmbuf_dump(FILE *f, const struct rte_mbuf *m, unsigned dump_len)
 	}
 }
 
+/* number of segments kept before returning them to their pool */
+#define RTE_PKTMBUF_FREE_PENDING_SZ 64
+
+/*
+ * Mask and value of the rearm_data word of a direct mbuf segment that
+ * can be put back in its pool as is: refcnt == 1 and nb_segs == 1.
+ * Checking both fields takes a single 64-bit compare.
+ */
+#if RTE_BYTE_ORDER == RTE_LITTLE_ENDIAN
+#define MBUF_REARM_SHIFT(field) \
+	(8 * (offsetof(struct rte_mbuf, field) - \
+	      offsetof(struct rte_mbuf, rearm_data)))
+#else
+#define MBUF_REARM_SHIFT(field) \
+	(8 * (sizeof(uint64_t) - sizeof(uint16_t) - \
+	      (offsetof(struct rte_mbuf, field) - \
+	       offsetof(struct rte_mbuf, rearm_data))))
+#endif
+#define MBUF_REARM_FREE_MASK \
+	((UINT64_C(0xffff) << MBUF_REARM_SHIFT(refcnt)) | \
+	 (UINT64_C(0xffff) << MBUF_REARM_SHIFT(nb_segs)))
+#define MBUF_REARM_FREE_VALUE \
+	((UINT64_C(1) << MBUF_REARM_SHIFT(refcnt)) | \
+	 (UINT64_C(1) << MBUF_REARM_SHIFT(nb_segs)))
+#define MBUF_FREE_ATTACHED (IND_ATTACHED_MBUF | EXT_ATTACHED_MBUF)
+
+/* non-zero if the mbuf is not a direct, unshared, single segment mbuf */
+static __rte_always_inline uint64_t
+mbuf_free_slow(const struct rte_mbuf *m)
+{
+	uint64_t rearm = *(const uint64_t *)RTE_PTR_ADD(m,
+			offsetof(struct rte_mbuf, rearm_data));
+
+	return ((rearm & MBUF_REARM_FREE_MASK) ^ MBUF_REARM_FREE_VALUE) |
+		(m->ol_flags & MBUF_FREE_ATTACHED);
+}
+
+/* add a segment to the pending array, flush it on pool change or when full */
+static __rte_always_inline void
+mbuf_free_pending(struct rte_mbuf *m, struct rte_mbuf **pending,
+		  unsigned int *nb_pending)
+{
+	if (*nb_pending == RTE_PKTMBUF_FREE_PENDING_SZ ||
+	    (*nb_pending > 0 && m->pool != pending[0]->pool)) {
+		rte_mempool_put_bulk(pending[0]->pool, (void **)pending,
+				     *nb_pending);
+		*nb_pending = 0;
+	}
+
+	pending[(*nb_pending)++] = m;
+}
+
+/* free a bulk of packet mbufs into their original mempools */
+void
+rte_pktmbuf_free_bulk(struct rte_mbuf **mbufs, unsigned int count)
+{
+	struct rte_mbuf *pending[RTE_PKTMBUF_FREE_PENDING_SZ];
+	struct rte_mbuf *m, *m_next;
+	unsigned int idx = 0, nb_pending = 0;
+
+	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, refcnt) -
+			 offsetof(struct rte_mbuf, rearm_data) >
+			 sizeof(uint64_t) - sizeof(uint16_t));
+	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, nb_segs) -
+			 offsetof(struct rte_mbuf, rearm_data) >
+			 sizeof(uint64_t) - sizeof(uint16_t));
+
+	while (idx < count) {
+		struct rte_mbuf **m4 = &mbufs[idx];
+
+		/*
+		 * Fast path: four direct, unshared, single segment mbufs
+		 * of the same pool are checked with a single branch, and
+		 * queued without touching refcnt or next.
+		 */
+		if (idx + 4 <= count && m4[0] != NULL && m4[1] != NULL &&
+		    m4[2] != NULL && m4[3] != NULL &&
+		    (mbuf_free_slow(m4[0]) | mbuf_free_slow(m4[1]) |
+		     mbuf_free_slow(m4[2]) | mbuf_free_slow(m4[3])) == 0 &&
+		    m4[1]->pool == m4[0]->pool &&
+		    m4[2]->pool == m4[0]->pool &&
+		    m4[3]->pool == m4[0]->pool) {
+			__rte_mbuf_sanity_check(m4[0], 1);
+			__rte_mbuf_sanity_check(m4[1], 1);
+			__rte_mbuf_sanity_check(m4[2], 1);
+			__rte_mbuf_sanity_check(m4[3], 1);
+			if (nb_pending > RTE_PKTMBUF_FREE_PENDING_SZ - 4 ||
+			    (nb_pending > 0 &&
+			     m4[0]->pool != pending[0]->pool)) {
+				rte_mempool_put_bulk(pending[0]->pool,
+					(void **)pending, nb_pending);
+				nb_pending = 0;
+			}
+			pending[nb_pending++] = m4[0];
+			pending[nb_pending++] = m4[1];
+			pending[nb_pending++] = m4[2];
+			pending[nb_pending++] = m4[3];
+			idx += 4;
+			continue;
+		}
+
+		m = mbufs[idx++];
+		if (unlikely(m == NULL))
+			continue;
+
+		__rte_mbuf_sanity_check(m, 1);
+
+		if (likely(mbuf_free_slow(m) == 0)) {
+			mbuf_free_pending(m, pending, &nb_pending);
+			continue;
+		}
+
+		do {
+			m_next = m->next;
+			m = rte_pktmbuf_prefree_seg(m);
+			if (likely(m != NULL))
+				mbuf_free_pending(m, pending, &nb_pending);
+			m = m_next;
+		} while (m != NULL);
+	}
+
+	if (nb_pending > 0)
+		rte_mempool_put_bulk(pending[0]->pool, (void **)pending,
+				     nb_pending);
+}
+
 /* read len data bytes in a mbuf at specified offset (internal) */
 const void *__rte_pktmbuf_read(const struct rte_mbuf *m, uint32_t off,
 	uint32_t len, void *buf)
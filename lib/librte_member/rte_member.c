@@ -34,7 +34,7 @@ rte_member_find_existing(const char *name)
 	member_list = RTE_TAILQ_CAST(rte_member_tailq.head, rte_member_list);
 
 	rte_mcfg_tailq_read_lock();
-	TAILQ_FOREACH(te, member_list, next) {
+	RTE_TAILQ_FOREACH(te, member_list, next) {
 		setsum = (struct rte_member_setsum *) te->data;
 		if (strncmp(name, setsum->name, RTE_MEMBER_NAMESIZE) == 0)
 			break;
@@ -58,7 +58,7 @@ rte_member_free(struct rte_member_setsum *setsum)
 		return;
 	member_list = RTE_TAILQ_CAST(rte_member_tailq.head, rte_member_list);
 	rte_mcfg_tailq_write_lock();
-	TAILQ_FOREACH(te, member_list, next) {
+	RTE_TAILQ_FOREACH(te, member_list, next) {
 		if (te->data == (void *)setsum)
 			break;
 	}
@@ -66,7 +66,7 @@ rte_member_free(struct rte_member_setsum *setsum)
 		rte_mcfg_tailq_write_unlock();
 		return;
 	}
-	TAILQ_REMOVE(member_list, te, next);
+	RTE_TAILQ_REMOVE(member_list, te, next);
 	rte_mcfg_tailq_write_unlock();
 
 	switch (setsum->type) {
@@ -108,7 +108,7 @@ rte_member_create(const struct rte_member_parameters *params)
 
 	rte_mcfg_tailq_write_lock();
 
-	TAILQ_FOREACH(te, member_list, next) {
+	RTE_TAILQ_FOREACH(te, member_list, next) {
 		setsum = te->data;
 		if (strncmp(params->name, setsum->name,
 				RTE_MEMBER_NAMESIZE) == 0)
@@ -159,7 +159,7 @@ rte_member_create(const struct rte_member_parameters *params)
 			"mode %u\n", setsum->type);
 
 	te->data = (void *)setsum;
-	TAILQ_INSERT_TAIL(member_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(member_list, te, next);
 	rte_mcfg_tailq_write_unlock();
 	return setsum;
 
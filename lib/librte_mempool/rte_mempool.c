@@ -45,6 +45,11 @@ EAL_REGISTER_TAILQ(rte_mempool_tailq)
 #define CALC_CACHE_FLUSHTHRESH(c)	\
 	((typeof(c))((c) * CACHE_FLUSHTHRESH_MULTIPLIER))
 
+/* Minimum number of requests between two adaptations of a cache. */
+#define CACHE_ADAPT_WINDOW 64
+/* Put/get imbalance from which an adaptive cache is retuned. */
+#define CACHE_ADAPT_RATIO 4
+
 /*
  * return the greatest common divisor between a and b (fast algorithm)
  *
@@ -701,6 +706,21 @@ rte_mempool_populate_anon(struct rte_mempool *mp)
 	return 0;
 }
 
+/* free the rings of a MEMPOOL_F_CACHE_ADAPTIVE mempool */
+static void
+mempool_cache_xfer_free(struct rte_mempool *mp)
+{
+	unsigned int lcore_id;
+
+	if (mp->local_cache == NULL || mp->cache_size == 0)
+		return;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		rte_free(mp->local_cache[lcore_id].xfer);
+		mp->local_cache[lcore_id].xfer = NULL;
+	}
+}
+
 /* free a mempool */
 void
 rte_mempool_free(struct rte_mempool *mp)
@@ -714,19 +734,20 @@ rte_mempool_free(struct rte_mempool *mp)
 	mempool_list = RTE_TAILQ_CAST(rte_mempool_tailq.head, rte_mempool_list);
 	rte_mcfg_tailq_write_lock();
 	/* find out tailq entry */
-	TAILQ_FOREACH(te, mempool_list, next) {
+	RTE_TAILQ_FOREACH(te, mempool_list, next) {
 		if (te->data == (void *)mp)
 			break;
 	}
 
 	if (te != NULL) {
-		TAILQ_REMOVE(mempool_list, te, next);
+		RTE_TAILQ_REMOVE(mempool_list, te, next);
 		rte_free(te);
 	}
 	rte_mcfg_tailq_write_unlock();
 
 	rte_mempool_free_memchunks(mp);
 	rte_mempool_ops_free(mp);
+	mempool_cache_xfer_free(mp);
 	rte_memzone_free(mp->mz);
 }
 
@@ -738,6 +759,174 @@ mempool_cache_init(struct rte_mempool_cache *cache, uint32_t size)
 	cache->len = 0;
 }
 
+/*
+ * Allocate the rings through which lcores return objects to the caches
+ * of enabled lcores, for a mempool created with MEMPOOL_F_CACHE_ADAPTIVE.
+ */
+static int
+mempool_cache_xfer_init(struct rte_mempool *mp)
+{
+	struct rte_mempool_cache *cache;
+	unsigned int lcore_id, count;
+	ssize_t ring_size;
+	int ret;
+
+	count = rte_align32pow2(mp->cache_size * 2);
+	ring_size = rte_ring_get_memsize(count);
+	if (ring_size < 0)
+		return ring_size;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		cache = &mp->local_cache[lcore_id];
+		cache->adaptive = 1;
+		cache->base_size = mp->cache_size;
+
+		if (!rte_lcore_is_enabled(lcore_id))
+			continue;
+
+		cache->xfer = rte_zmalloc_socket("MEMPOOL_CACHE_XFER",
+			ring_size, RTE_CACHE_LINE_SIZE, mp->socket_id);
+		if (cache->xfer == NULL)
+			return -ENOMEM;
+
+		ret = rte_ring_init(cache->xfer, mp->name, count,
+				    RING_F_SC_DEQ);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Tune the size and flush threshold of an adaptive cache from the ratio
+ * of get and put requests seen since the last adaptation:
+ * - an lcore that mostly puts keeps few objects and flushes them in
+ *   large batches,
+ * - an lcore that mostly gets refills in large batches, and receives
+ *   the objects flushed by the other lcores,
+ * - otherwise the cache gets back its configured size.
+ */
+static void
+mempool_cache_adapt(struct rte_mempool *mp, struct rte_mempool_cache *cache)
+{
+	const struct rte_mempool_cache_stats *stats = &cache->stats;
+	uint32_t lcore_id = cache - mp->local_cache;
+	uint32_t base = cache->base_size;
+	uint32_t big = RTE_MIN(base * 2, (uint32_t)RTE_MEMPOOL_CACHE_MAX_SIZE);
+	uint64_t gets, puts;
+
+	gets = stats->get_hit + stats->get_miss - cache->adapt_gets;
+	puts = stats->put_hit + stats->put_miss - cache->adapt_puts;
+	if (gets + puts < CACHE_ADAPT_WINDOW)
+		return;
+	cache->adapt_gets += gets;
+	cache->adapt_puts += puts;
+
+	if (puts > gets * CACHE_ADAPT_RATIO) {
+		cache->size = RTE_MAX(base / 4, 1U);
+		cache->flushthresh = RTE_MIN(base * 2, mp->size);
+	} else if (gets > puts * CACHE_ADAPT_RATIO &&
+			CALC_CACHE_FLUSHTHRESH(big) <= mp->size) {
+		cache->size = big;
+		cache->flushthresh = CALC_CACHE_FLUSHTHRESH(big);
+		if (cache->xfer != NULL)
+			mp->xfer_lcore = lcore_id;
+	} else {
+		cache->size = base;
+		cache->flushthresh = CALC_CACHE_FLUSHTHRESH(base);
+	}
+
+	if (cache->size != big && mp->xfer_lcore == lcore_id)
+		mp->xfer_lcore = RTE_MAX_LCORE;
+
+	/* the cache may hold more objects than its new threshold */
+	if (cache->len > cache->flushthresh) {
+		rte_mempool_ops_enqueue_bulk(mp, &cache->objs[cache->size],
+				cache->len - cache->size);
+		cache->len = cache->size;
+	}
+}
+
+/* flush the excess objects of an adaptive cache (internal) */
+void
+rte_mempool_cache_adaptive_flush(struct rte_mempool *mp,
+				 struct rte_mempool_cache *cache)
+{
+	struct rte_mempool_cache *dst;
+	uint32_t lcore_id, n, sent = 0;
+	void **objs;
+
+	mempool_cache_adapt(mp, cache);
+	if (cache->len <= cache->size)
+		return;
+
+	n = cache->len - cache->size;
+	objs = &cache->objs[cache->size];
+
+	/* hand the objects directly to an lcore that is short of them */
+	lcore_id = mp->xfer_lcore;
+	if (lcore_id < RTE_MAX_LCORE) {
+		dst = &mp->local_cache[lcore_id];
+		if (dst != cache && dst->xfer != NULL) {
+			sent = rte_ring_mp_enqueue_burst(dst->xfer, objs, n,
+							 NULL);
+			cache->stats.xfer_out += sent;
+		}
+	}
+
+	if (sent < n)
+		rte_mempool_ops_enqueue_bulk(mp, objs + sent, n - sent);
+	cache->len = cache->size;
+}
+
+/* get objects through an adaptive cache on a miss (internal) */
+int
+rte_mempool_cache_adaptive_get(struct rte_mempool *mp, void **obj_table,
+			       unsigned int n, struct rte_mempool_cache *cache)
+{
+	uint32_t index, len, req, got;
+	int ret;
+
+	mempool_cache_adapt(mp, cache);
+
+	if (n < cache->size) {
+		if (cache->len < n) {
+			req = n + (cache->size - cache->len);
+
+			/* objects returned by other lcores come first */
+			if (cache->xfer != NULL) {
+				got = rte_ring_sc_dequeue_burst(cache->xfer,
+					&cache->objs[cache->len], req, NULL);
+				cache->stats.xfer_in += got;
+				cache->len += got;
+				req -= got;
+			}
+
+			if (req != 0 && rte_mempool_ops_dequeue_bulk(mp,
+					&cache->objs[cache->len], req) == 0)
+				cache->len += req;
+		}
+
+		if (cache->len >= n) {
+			for (index = 0, len = cache->len - 1; index < n;
+					++index, len--, obj_table++)
+				*obj_table = cache->objs[len];
+			cache->len -= n;
+			__MEMPOOL_STAT_ADD(mp, get_success, n);
+			return 0;
+		}
+	}
+
+	ret = rte_mempool_ops_dequeue_bulk(mp, obj_table, n);
+	if (ret < 0)
+		__MEMPOOL_STAT_ADD(mp, get_fail, n);
+	else
+		__MEMPOOL_STAT_ADD(mp, get_success, n);
+
+	return ret;
+}
+
 /*
  * Create and initialize a cache for objects that are retrieved from and
  * returned to an underlying mempool. This structure is identical to the
@@ -890,17 +1079,27 @@ rte_mempool_create_empty(const char *name, unsigned n, unsigned elt_size,
 	mp->local_cache = (struct rte_mempool_cache *)
 		RTE_PTR_ADD(mp, MEMPOOL_HEADER_SIZE(mp, 0));
 
+	mp->xfer_lcore = RTE_MAX_LCORE;
+
 	/* Init all default caches. */
 	if (cache_size != 0) {
 		for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
 			mempool_cache_init(&mp->local_cache[lcore_id],
 					   cache_size);
+
+		if (flags & MEMPOOL_F_CACHE_ADAPTIVE) {
+			ret = mempool_cache_xfer_init(mp);
+			if (ret < 0) {
+				rte_errno = -ret;
+				goto exit_unlock;
+			}
+		}
 	}
 
 	te->data = mp;
 
 	rte_mcfg_tailq_write_lock();
-	TAILQ_INSERT_TAIL(mempool_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(mempool_list, te, next);
 	rte_mcfg_tailq_write_unlock();
 	rte_mcfg_mempool_write_unlock();
 
@@ -975,8 +1174,11 @@ rte_mempool_avail_count(const struct rte_mempool *mp)
 	if (mp->cache_size == 0)
 		return count;
 
-	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
 		count += mp->local_cache[lcore_id].len;
+		if (mp->local_cache[lcore_id].xfer != NULL)
+			count += rte_ring_count(mp->local_cache[lcore_id].xfer);
+	}
 
 	/*
 	 * due to race condition (access to len is not locked), the
@@ -1015,6 +1217,32 @@ rte_mempool_dump_cache(FILE *f, const struct rte_mempool *mp)
 		count += cache_count;
 	}
 	fprintf(f, "    total_cache_count=%u\n", count);
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		const struct rte_mempool_cache *cache;
+
+		cache = &mp->local_cache[lcore_id];
+		if (cache->stats.get_hit + cache->stats.get_miss +
+				cache->stats.put_hit +
+				cache->stats.put_miss == 0)
+			continue;
+		fprintf(f, "    cache_stats[%u]: get_hit=%"PRIu64
+			" get_miss=%"PRIu64" put_hit=%"PRIu64
+			" put_miss=%"PRIu64" xfer_in=%"PRIu64
+			" xfer_out=%"PRIu64"\n", lcore_id,
+			cache->stats.get_hit, cache->stats.get_miss,
+			cache->stats.put_hit, cache->stats.put_miss,
+			cache->stats.xfer_in, cache->stats.xfer_out);
+		if (cache->adaptive)
+			fprintf(f, "    cache_adaptive[%u]: size=%"PRIu32
+				" flushthresh=%"PRIu32" xfer_count=%u\n",
+				lcore_id, cache->size, cache->flushthresh,
+				cache->xfer != NULL ?
+					rte_ring_count(cache->xfer) : 0);
+	}
+	if (mp->flags & MEMPOOL_F_CACHE_ADAPTIVE)
+		fprintf(f, "    xfer_lcore=%"PRIu32"\n", mp->xfer_lcore);
+
 	return count;
 }
 
@@ -1259,6 +1487,30 @@ rte_mempool_dump(FILE *f, struct rte_mempool *mp)
 	rte_mempool_audit(mp);
 }
 
+/*
+ * In a secondary process started with --lazy-mem-attach, map the pool data
+ * and the memory chunks holding the objects of a mempool found in the tailq,
+ * which only maps the mempool header and caches.
+ */
+static int
+mempool_attach(const struct rte_mempool *mp)
+{
+	const struct rte_mempool_memhdr *memhdr;
+
+	if (rte_malloc_attach(mp->pool_data) < 0)
+		goto fail;
+	STAILQ_FOREACH(memhdr, &mp->mem_list, next) {
+		if (rte_malloc_attach(memhdr) < 0 ||
+				rte_mem_attach(memhdr->addr, memhdr->len) < 0)
+			goto fail;
+	}
+	return 0;
+
+fail:
+	RTE_LOG(ERR, MEMPOOL, "Cannot map mempool %s\n", mp->name);
+	return -1;
+}
+
 /* dump the status of all mempools on the console */
 void
 rte_mempool_list_dump(FILE *f)
@@ -1271,9 +1523,10 @@ rte_mempool_list_dump(FILE *f)
 
 	rte_mcfg_mempool_read_lock();
 
-	TAILQ_FOREACH(te, mempool_list, next) {
+	RTE_TAILQ_FOREACH(te, mempool_list, next) {
 		mp = (struct rte_mempool *) te->data;
-		rte_mempool_dump(f, mp);
+		if (mempool_attach(mp) == 0)
+			rte_mempool_dump(f, mp);
 	}
 
 	rte_mcfg_mempool_read_unlock();
@@ -1291,7 +1544,7 @@ rte_mempool_lookup(const char *name)
 
 	rte_mcfg_mempool_read_lock();
 
-	TAILQ_FOREACH(te, mempool_list, next) {
+	RTE_TAILQ_FOREACH(te, mempool_list, next) {
 		mp = (struct rte_mempool *) te->data;
 		if (strncmp(name, mp->name, RTE_MEMPOOL_NAMESIZE) == 0)
 			break;
@@ -1303,6 +1556,8 @@ rte_mempool_lookup(const char *name)
 		rte_errno = ENOENT;
 		return NULL;
 	}
+	if (mempool_attach(mp) < 0)
+		return NULL;
 
 	return mp;
 }
@@ -1318,8 +1573,9 @@ void rte_mempool_walk(void (*func)(struct rte_mempool *, void *),
 
 	rte_mcfg_mempool_read_lock();
 
-	TAILQ_FOREACH_SAFE(te, mempool_list, next, tmp_te) {
-		(*func)((struct rte_mempool *) te->data, arg);
+	RTE_TAILQ_FOREACH_SAFE(te, mempool_list, next, tmp_te) {
+		if (mempool_attach(te->data) == 0)
+			(*func)((struct rte_mempool *) te->data, arg);
 	}
 
 	rte_mcfg_mempool_read_unlock();
@@ -50,6 +50,7 @@
 #include <rte_ring.h>
 #include <rte_memcpy.h>
 #include <rte_common.h>
+#include <rte_mempool_trace_fp.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -77,6 +78,22 @@ struct rte_mempool_debug_stats {
 } __rte_cache_aligned;
 #endif
 
+/**
+ * A structure that stores the hit/miss counters of a mempool cache.
+ *
+ * These counters are maintained by adaptive caches, and by all the
+ * caches when debug is enabled; they are only written by the lcore
+ * owning the cache.
+ */
+struct rte_mempool_cache_stats {
+	uint64_t get_hit;  /**< Gets served from the cache. */
+	uint64_t get_miss; /**< Gets that had to access the pool. */
+	uint64_t put_hit;  /**< Puts absorbed by the cache. */
+	uint64_t put_miss; /**< Puts that had to flush to the pool. */
+	uint64_t xfer_in;  /**< Objects received from other lcores. */
+	uint64_t xfer_out; /**< Objects returned to other lcores. */
+};
+
 /**
  * A structure that stores a per-core object cache.
  */
@@ -84,11 +101,26 @@ struct rte_mempool_cache {
 	uint32_t size;	      /**< Size of the cache */
 	uint32_t flushthresh; /**< Threshold before we flush excess elements */
 	uint32_t len;	      /**< Current cache count */
+	/**
+	 * Size and threshold are tuned at runtime. It fills the padding
+	 * before objs, next to the fields read on every get and put.
+	 */
+	uint32_t adaptive;
 	/*
 	 * Cache is allocated to this size to allow it to overflow in certain
 	 * cases to avoid needless emptying of cache.
 	 */
 	void *objs[RTE_MEMPOOL_CACHE_MAX_SIZE * 3]; /**< Cache objects */
+	struct rte_mempool_cache_stats stats; /**< Hit/miss counters */
+	/*
+	 * Adaptive mode (MEMPOOL_F_CACHE_ADAPTIVE) state, only accessed on
+	 * misses.
+	 */
+	uint32_t base_size;   /**< Configured size of the cache */
+	uint64_t adapt_gets;  /**< Get requests at last adaptation */
+	uint64_t adapt_puts;  /**< Put requests at last adaptation */
+	/** Objects returned by other lcores, dequeued on get misses. */
+	struct rte_ring *xfer;
 } __rte_cache_aligned;
 
 /**
@@ -255,6 +287,11 @@ struct rte_mempool {
 	/** Per-lcore statistics. */
 	struct rte_mempool_debug_stats stats[RTE_MAX_LCORE];
 #endif
+	/**
+	 * Lcore whose cache receives the objects flushed by other lcores
+	 * (MEMPOOL_F_CACHE_ADAPTIVE), RTE_MAX_LCORE if none.
+	 */
+	volatile uint32_t xfer_lcore;
 }  __rte_cache_aligned;
 
 #define MEMPOOL_F_NO_SPREAD      0x0001 /**< Do not spread among memory channels. */
@@ -264,6 +301,7 @@ struct rte_mempool {
 #define MEMPOOL_F_POOL_CREATED   0x0010 /**< Internal: pool is created. */
 #define MEMPOOL_F_NO_IOVA_CONTIG 0x0020 /**< Don't need IOVA contiguous objs. */
 #define MEMPOOL_F_NO_PHYS_CONTIG MEMPOOL_F_NO_IOVA_CONTIG /* deprecated */
+#define MEMPOOL_F_CACHE_ADAPTIVE 0x0040 /**< Tune per-lcore caches at runtime. */
 
 /**
  * @internal When debug is enabled, store some statistics.
@@ -295,6 +333,25 @@ struct rte_mempool {
 #define __MEMPOOL_CONTIG_BLOCKS_STAT_ADD(mp, name, n) do {} while (0)
 #endif
 
+/**
+ * @internal Increment a hit/miss counter of a cache, when they are
+ * maintained: always when debug is enabled, otherwise in adaptive mode
+ * only, so that the other caches do not pay for them.
+ *
+ * @param cache
+ *   Pointer to the mempool cache.
+ * @param name
+ *   Name of the counter to increment in the cache statistics.
+ */
+#ifdef RTE_LIBRTE_MEMPOOL_DEBUG
+#define __MEMPOOL_CACHE_STAT_INC(cache, name) ((cache)->stats.name++)
+#else
+#define __MEMPOOL_CACHE_STAT_INC(cache, name) do {                 \
+		if ((cache)->adaptive)                          \
+			(cache)->stats.name++;                  \
+	} while (0)
+#endif
+
 /**
  * Calculate the size of the mempool header.
  *
@@ -933,6 +990,13 @@ typedef void (rte_mempool_ctor_t)(struct rte_mempool *, void *);
  *     "single-consumer". Otherwise, it is "multi-consumers".
  *   - MEMPOOL_F_NO_IOVA_CONTIG: If set, allocated objects won't
  *     necessarily be contiguous in IO memory.
+ *   - MEMPOOL_F_CACHE_ADAPTIVE: If set, the size and flush threshold of
+ *     each per-lcore cache are tuned from the ratio of get and put
+ *     requests observed on that lcore. Objects flushed by lcores that
+ *     mostly put are handed directly to an lcore that mostly gets,
+ *     bypassing the common pool. Ignored if *cache_size* is 0.
+ *     Experimental: the gets and puts of code built without
+ *     ALLOW_EXPERIMENTAL_API use these caches as regular caches.
  * @return
  *   The pointer to the new allocated mempool, on success. NULL on error
  *   with rte_errno set appropriately. Possible rte_errno values include:
@@ -1205,6 +1269,55 @@ rte_mempool_cache_flush(struct rte_mempool_cache *cache,
 	cache->len = 0;
 }
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * @internal Flush the excess objects of an adaptive cache; used internally.
+ *
+ * Called when a put on a cache in adaptive mode crosses its flush
+ * threshold. The cache size and threshold are tuned first, then the
+ * objects above the cache size are returned to the lcore designated by
+ * mp->xfer_lcore, or to the pool.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param cache
+ *   A pointer to a mempool cache structure in adaptive mode.
+ */
+__rte_experimental
+void
+rte_mempool_cache_adaptive_flush(struct rte_mempool *mp,
+				 struct rte_mempool_cache *cache);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * @internal Get objects through an adaptive cache on a miss; used internally.
+ *
+ * Called when a get on a cache in adaptive mode cannot be served from
+ * the cache. The cache size and threshold are tuned first, then the
+ * cache is refilled from the objects returned by other lcores and from
+ * the pool.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param obj_table
+ *   A pointer to a table of void * pointers (objects) that will be filled.
+ * @param n
+ *   The number of objects to get, must be strictly positive.
+ * @param cache
+ *   A pointer to a mempool cache structure in adaptive mode.
+ * @return
+ *   - 0: Success; objects taken.
+ *   - <0: Error; code of the pool dequeue function.
+ */
+__rte_experimental
+int
+rte_mempool_cache_adaptive_get(struct rte_mempool *mp, void **obj_table,
+			       unsigned int n, struct rte_mempool_cache *cache);
+
 /**
  * @internal Put several objects back in the mempool; used internally.
  * @param mp
@@ -1245,15 +1358,27 @@ __mempool_generic_put(struct rte_mempool *mp, void * const *obj_table,
 	cache->len += n;
 
 	if (cache->len >= cache->flushthresh) {
+		__MEMPOOL_CACHE_STAT_INC(cache, put_miss);
+#ifdef ALLOW_EXPERIMENTAL_API
+		if (cache->adaptive) {
+			rte_mempool_cache_adaptive_flush(mp, cache);
+			return;
+		}
+#endif
 		rte_mempool_ops_enqueue_bulk(mp, &cache->objs[cache->size],
 				cache->len - cache->size);
 		cache->len = cache->size;
+	} else {
+		__MEMPOOL_CACHE_STAT_INC(cache, put_hit);
 	}
 
 	return;
 
 ring_enqueue:
 
+	if (cache != NULL)
+		__MEMPOOL_CACHE_STAT_INC(cache, put_miss);
+
 	/* push remaining objects in ring */
 #ifdef RTE_LIBRTE_MEMPOOL_DEBUG
 	if (rte_mempool_ops_enqueue_bulk(mp, obj_table, n) < 0)
@@ -1280,6 +1405,7 @@ static __rte_always_inline void
 rte_mempool_generic_put(struct rte_mempool *mp, void * const *obj_table,
 			unsigned int n, struct rte_mempool_cache *cache)
 {
+	rte_mempool_trace_generic_put(mp, obj_table, n, cache);
 	__mempool_check_cookies(mp, obj_table, n, 0);
 	__mempool_generic_put(mp, obj_table, n, cache);
 }
@@ -1347,10 +1473,24 @@ __mempool_generic_get(struct rte_mempool *mp, void **obj_table,
 	uint32_t index, len;
 	void **cache_objs;
 
-	/* No cache provided or cannot be satisfied from cache */
-	if (unlikely(cache == NULL || n >= cache->size))
+	/* No cache provided */
+	if (unlikely(cache == NULL))
 		goto ring_dequeue;
 
+	if (unlikely(n >= cache->size || cache->len < n)) {
+		__MEMPOOL_CACHE_STAT_INC(cache, get_miss);
+#ifdef ALLOW_EXPERIMENTAL_API
+		if (cache->adaptive)
+			return rte_mempool_cache_adaptive_get(mp, obj_table,
+							      n, cache);
+#endif
+		/* Cannot be satisfied from cache */
+		if (n >= cache->size)
+			goto ring_dequeue;
+	} else {
+		__MEMPOOL_CACHE_STAT_INC(cache, get_hit);
+	}
+
 	cache_objs = cache->objs;
 
 	/* Can this be satisfied from the cache? */
@@ -1425,6 +1565,7 @@ rte_mempool_generic_get(struct rte_mempool *mp, void **obj_table,
 	ret = __mempool_generic_get(mp, obj_table, n, cache);
 	if (ret == 0)
 		__mempool_check_cookies(mp, obj_table, n, 1);
+	rte_mempool_trace_generic_get(mp, obj_table, n, cache, ret);
 	return ret;
 }
 
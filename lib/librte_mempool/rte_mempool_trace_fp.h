@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#ifndef _RTE_MEMPOOL_TRACE_FP_H_
+#define _RTE_MEMPOOL_TRACE_FP_H_
+
+/**
+ * @file
+ *
+ * API for mempool fast path trace support
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rte_trace_point.h>
+
+RTE_TRACE_POINT_FP(
+	rte_mempool_trace_generic_put,
+	RTE_TRACE_POINT_ARGS(const void *mp, void * const *obj_table,
+		unsigned int nb_objs, const void *cache),
+	rte_trace_point_emit_ptr(mp);
+	rte_trace_point_emit_ptr(obj_table);
+	rte_trace_point_emit_u32(nb_objs);
+	rte_trace_point_emit_ptr(cache);
+)
+
+RTE_TRACE_POINT_FP(
+	rte_mempool_trace_generic_get,
+	RTE_TRACE_POINT_ARGS(const void *mp, void * const *obj_table,
+		unsigned int nb_objs, const void *cache, int ret),
+	rte_trace_point_emit_ptr(mp);
+	rte_trace_point_emit_ptr(obj_table);
+	rte_trace_point_emit_u32(nb_objs);
+	rte_trace_point_emit_ptr(cache);
+	rte_trace_point_emit_i32(ret);
+)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_MEMPOOL_TRACE_FP_H_ */
@@ -0,0 +1,12 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#include <rte_trace_point_register.h>
+
+#include <rte_mempool_trace_fp.h>
+
+RTE_TRACE_POINT_REGISTER(rte_mempool_trace_generic_put,
+	lib.mempool.generic.put)
+RTE_TRACE_POINT_REGISTER(rte_mempool_trace_generic_get,
+	lib.mempool.generic.get)
@@ -19,6 +19,8 @@
 #include <rte_per_lcore.h>
 #include <rte_lcore.h>
 #include <rte_errno.h>
+#include <rte_spinlock.h>
+#include <rte_string_fns.h>
 
 #include "rte_rcu_qsbr.h"
 
@@ -267,6 +269,265 @@ rte_rcu_qsbr_dump(FILE *f, struct rte_rcu_qsbr *v)
 	return 0;
 }
 
+/* Defer queue entry. The token is followed by 'esize' bytes of
+ * resource data provided by the application.
+ */
+struct __rte_rcu_qsbr_dq_elem {
+	uint64_t token;
+	/**< Token returned by rte_rcu_qsbr_start for this resource */
+	uint8_t elem[0];
+	/**< Resource data */
+};
+
+/* RCU defer queue structure. The entries are stored in a circular
+ * array following the structure.
+ */
+struct rte_rcu_qsbr_dq {
+	struct rte_rcu_qsbr *v; /**< RCU QSBR variable used by this queue */
+	rte_rcu_qsbr_free_resource_t free_fn; /**< Function to free resource */
+	void *p; /**< Pointer passed to the free function */
+	uint32_t flags; /**< Flags passed at creation time */
+	uint32_t size; /**< Usable number of entries */
+	uint32_t mask; /**< Mask for the circular array index */
+	uint32_t esize; /**< Size of resource data */
+	uint32_t stride; /**< Size of one entry including the token */
+	uint32_t trigger_reclaim_limit; /**< Auto reclaim threshold */
+	uint32_t max_reclaim_size; /**< Max resources freed on auto reclaim */
+	uint32_t head; /**< Index of the oldest entry */
+	uint32_t tail; /**< Index of the next free entry */
+	rte_spinlock_t lock; /**< Taken unless RTE_RCU_QSBR_DQ_MT_UNSAFE */
+	char name[RTE_RCU_QSBR_DQ_NAMESIZE]; /**< Name of the defer queue */
+	uint8_t elems[0] __rte_cache_aligned; /**< Defer queue entries */
+};
+
+#define __RTE_QSBR_DQ_ELEM(dq, i) ((struct __rte_rcu_qsbr_dq_elem *) \
+	&(dq)->elems[(size_t)((i) & (dq)->mask) * (dq)->stride])
+
+static inline void
+__rte_rcu_qsbr_dq_lock(struct rte_rcu_qsbr_dq *dq)
+{
+	if (!(dq->flags & RTE_RCU_QSBR_DQ_MT_UNSAFE))
+		rte_spinlock_lock(&dq->lock);
+}
+
+static inline void
+__rte_rcu_qsbr_dq_unlock(struct rte_rcu_qsbr_dq *dq)
+{
+	if (!(dq->flags & RTE_RCU_QSBR_DQ_MT_UNSAFE))
+		rte_spinlock_unlock(&dq->lock);
+}
+
+/* Free up to 'n' resources whose grace period is over.
+ * Must be called with the defer queue lock held.
+ */
+static unsigned int
+__rte_rcu_qsbr_dq_reclaim(struct rte_rcu_qsbr_dq *dq, unsigned int n)
+{
+	struct __rte_rcu_qsbr_dq_elem *dq_elem;
+	unsigned int cnt = 0;
+
+	while (cnt < n && dq->head != dq->tail) {
+		dq_elem = __RTE_QSBR_DQ_ELEM(dq, dq->head);
+
+		/* The entries are in the order of their tokens. Stop at
+		 * the first one that is still within its grace period.
+		 */
+		if (rte_rcu_qsbr_check(dq->v, dq_elem->token, false) != 1)
+			break;
+
+		dq->free_fn(dq->p, dq_elem->elem, 1);
+		dq->head++;
+		cnt++;
+	}
+
+	return cnt;
+}
+
+/* Create a queue used to store the data structure elements that can
+ * be freed later.
+ */
+struct rte_rcu_qsbr_dq *
+rte_rcu_qsbr_dq_create(const struct rte_rcu_qsbr_dq_parameters *params)
+{
+	struct rte_rcu_qsbr_dq *dq;
+	uint32_t qs_fifo_size, stride;
+	size_t sz;
+
+	if (params == NULL || params->free_fn == NULL ||
+		params->v == NULL || params->name == NULL ||
+		params->size == 0 || params->esize == 0 ||
+		(params->esize % 4 != 0)) {
+		rte_log(RTE_LOG_ERR, rte_rcu_log_type,
+			"%s(): Invalid input parameter\n", __func__);
+		rte_errno = EINVAL;
+
+		return NULL;
+	}
+	/* If auto reclamation is configured, reclaim limit
+	 * should be a valid value.
+	 */
+	if ((params->trigger_reclaim_limit != 0) &&
+	    (params->max_reclaim_size == 0)) {
+		rte_log(RTE_LOG_ERR, rte_rcu_log_type,
+			"%s(): Invalid input parameter, size = %u, trigger_reclaim_limit = %u, max_reclaim_size = %u\n",
+			__func__, params->size, params->trigger_reclaim_limit,
+			params->max_reclaim_size);
+		rte_errno = EINVAL;
+
+		return NULL;
+	}
+
+	/* Each entry stores the token followed by the resource data */
+	stride = RTE_ALIGN_CEIL(sizeof(struct __rte_rcu_qsbr_dq_elem) +
+				params->esize, sizeof(uint64_t));
+	qs_fifo_size = rte_align32pow2(params->size);
+	if (qs_fifo_size == 0) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	sz = sizeof(struct rte_rcu_qsbr_dq) + (size_t)qs_fifo_size * stride;
+	dq = rte_zmalloc(NULL, sz, RTE_CACHE_LINE_SIZE);
+	if (dq == NULL) {
+		rte_errno = ENOMEM;
+
+		return NULL;
+	}
+
+	strlcpy(dq->name, params->name, sizeof(dq->name));
+	dq->v = params->v;
+	dq->free_fn = params->free_fn;
+	dq->p = params->p;
+	dq->flags = params->flags;
+	dq->size = params->size;
+	dq->mask = qs_fifo_size - 1;
+	dq->esize = params->esize;
+	dq->stride = stride;
+	dq->trigger_reclaim_limit = params->trigger_reclaim_limit;
+	dq->max_reclaim_size = params->max_reclaim_size;
+	rte_spinlock_init(&dq->lock);
+
+	return dq;
+}
+
+/* Enqueue one resource to the defer queue to free after the grace
+ * period is over.
+ */
+int
+rte_rcu_qsbr_dq_enqueue(struct rte_rcu_qsbr_dq *dq, void *e)
+{
+	struct __rte_rcu_qsbr_dq_elem *dq_elem;
+	uint64_t token;
+
+	if (dq == NULL || e == NULL) {
+		rte_log(RTE_LOG_ERR, rte_rcu_log_type,
+			"%s(): Invalid input parameter\n", __func__);
+		rte_errno = EINVAL;
+
+		return 1;
+	}
+
+	/* Start the grace period */
+	token = rte_rcu_qsbr_start(dq->v);
+
+	__rte_rcu_qsbr_dq_lock(dq);
+
+	/* Reclaim resources if the queue size has hit the reclaim
+	 * limit. This helps the queue from growing too large and
+	 * allows time for reader threads to report their quiescent state.
+	 */
+	if (dq->trigger_reclaim_limit != 0 &&
+			dq->tail - dq->head >= dq->trigger_reclaim_limit) {
+		__RTE_RCU_DP_LOG(DEBUG,
+			"Triggering reclamation, queue size = %u",
+			dq->tail - dq->head);
+		__rte_rcu_qsbr_dq_reclaim(dq, dq->max_reclaim_size);
+	}
+
+	/* Attempt to free one resource if the queue is full */
+	if (dq->tail - dq->head >= dq->size)
+		__rte_rcu_qsbr_dq_reclaim(dq, 1);
+
+	if (dq->tail - dq->head >= dq->size) {
+		__rte_rcu_qsbr_dq_unlock(dq);
+		rte_log(RTE_LOG_INFO, rte_rcu_log_type,
+			"%s(): Defer queue %s is full\n", __func__, dq->name);
+		rte_errno = ENOSPC;
+
+		return 1;
+	}
+
+	/* With multiple writers an older token may be queued after a
+	 * newer one. This only delays the reclamation of the newer one.
+	 */
+	dq_elem = __RTE_QSBR_DQ_ELEM(dq, dq->tail);
+	dq_elem->token = token;
+	memcpy(dq_elem->elem, e, dq->esize);
+	dq->tail++;
+
+	__rte_rcu_qsbr_dq_unlock(dq);
+
+	return 0;
+}
+
+/* Reclaim resources from the defer queue. */
+int
+rte_rcu_qsbr_dq_reclaim(struct rte_rcu_qsbr_dq *dq, unsigned int n,
+	unsigned int *freed, unsigned int *pending, unsigned int *available)
+{
+	unsigned int cnt, cur_size;
+
+	if (dq == NULL || n == 0) {
+		rte_log(RTE_LOG_ERR, rte_rcu_log_type,
+			"%s(): Invalid input parameter\n", __func__);
+		rte_errno = EINVAL;
+
+		return 1;
+	}
+
+	__rte_rcu_qsbr_dq_lock(dq);
+	cnt = __rte_rcu_qsbr_dq_reclaim(dq, n);
+	cur_size = dq->tail - dq->head;
+	__rte_rcu_qsbr_dq_unlock(dq);
+
+	__RTE_RCU_DP_LOG(DEBUG, "Reclaimed %u resources", cnt);
+
+	if (freed != NULL)
+		*freed = cnt;
+	if (pending != NULL)
+		*pending = cur_size;
+	if (available != NULL)
+		*available = dq->size - cur_size;
+
+	return 0;
+}
+
+/* Delete a defer queue. */
+int
+rte_rcu_qsbr_dq_delete(struct rte_rcu_qsbr_dq *dq)
+{
+	unsigned int pending;
+
+	if (dq == NULL) {
+		rte_log(RTE_LOG_DEBUG, rte_rcu_log_type,
+			"%s(): Invalid input parameter\n", __func__);
+
+		return 0;
+	}
+
+	/* Reclaim all the resources */
+	rte_rcu_qsbr_dq_reclaim(dq, ~0, NULL, &pending, NULL);
+	if (pending != 0) {
+		rte_errno = EAGAIN;
+
+		return 1;
+	}
+
+	rte_free(dq);
+
+	return 0;
+}
+
 int rte_rcu_log_type;
 
 RTE_INIT(rte_rcu_register)
@@ -123,7 +123,7 @@ rte_reorder_create(const char *name, unsigned socket_id, unsigned int size)
 	rte_mcfg_tailq_write_lock();
 
 	/* guarantee there's no existing */
-	TAILQ_FOREACH(te, reorder_list, next) {
+	RTE_TAILQ_FOREACH(te, reorder_list, next) {
 		b = (struct rte_reorder_buffer *) te->data;
 		if (strncmp(name, b->name, RTE_REORDER_NAMESIZE) == 0)
 			break;
@@ -149,7 +149,7 @@ rte_reorder_create(const char *name, unsigned socket_id, unsigned int size)
 	} else {
 		rte_reorder_init(b, bufsize, name, size);
 		te->data = (void *)b;
-		TAILQ_INSERT_TAIL(reorder_list, te, next);
+		RTE_TAILQ_INSERT_TAIL(reorder_list, te, next);
 	}
 
 exit:
@@ -197,7 +197,7 @@ rte_reorder_free(struct rte_reorder_buffer *b)
 	rte_mcfg_tailq_write_lock();
 
 	/* find our tailq entry */
-	TAILQ_FOREACH(te, reorder_list, next) {
+	RTE_TAILQ_FOREACH(te, reorder_list, next) {
 		if (te->data == (void *) b)
 			break;
 	}
@@ -206,7 +206,7 @@ rte_reorder_free(struct rte_reorder_buffer *b)
 		return;
 	}
 
-	TAILQ_REMOVE(reorder_list, te, next);
+	RTE_TAILQ_REMOVE(reorder_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
@@ -231,7 +231,7 @@ rte_reorder_find_existing(const char *name)
 	reorder_list = RTE_TAILQ_CAST(rte_reorder_tailq.head, rte_reorder_list);
 
 	rte_mcfg_tailq_read_lock();
-	TAILQ_FOREACH(te, reorder_list, next) {
+	RTE_TAILQ_FOREACH(te, reorder_list, next) {
 		b = (struct rte_reorder_buffer *) te->data;
 		if (strncmp(name, b->name, RTE_REORDER_NAMESIZE) == 0)
 			break;
@@ -44,6 +44,9 @@ EAL_REGISTER_TAILQ(rte_ring_tailq)
 /* true if x is a power of 2 */
 #define POWEROF2(x) ((((x)-1) & (x)) == 0)
 
+/* by default set head/tail distance as 1/8 of ring capacity */
+#define HTD_MAX_DEF	8
+
 /* return the size of memory occupied by a ring */
 ssize_t
 rte_ring_get_memsize(unsigned count)
@@ -63,11 +66,93 @@ rte_ring_get_memsize(unsigned count)
 	return sz;
 }
 
+/* reset the head and tail of prod/cons, whatever their sync type is */
+static void
+reset_headtail(void *p)
+{
+	struct rte_ring_headtail *ht;
+	struct rte_ring_hts_headtail *ht_hts;
+	struct rte_ring_rts_headtail *ht_rts;
+
+	ht = p;
+	ht_hts = p;
+	ht_rts = p;
+
+	switch (ht->sync_type) {
+	case RTE_RING_SYNC_MT:
+	case RTE_RING_SYNC_ST:
+		ht->head = 0;
+		ht->tail = 0;
+		break;
+	case RTE_RING_SYNC_MT_RTS:
+		ht_rts->head.raw = 0;
+		ht_rts->tail.raw = 0;
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		ht_hts->ht.raw = 0;
+		break;
+	default:
+		/* unknown sync mode */
+		RTE_ASSERT(0);
+	}
+}
+
 void
 rte_ring_reset(struct rte_ring *r)
 {
-	r->prod.head = r->cons.head = 0;
-	r->prod.tail = r->cons.tail = 0;
+	reset_headtail(&r->prod);
+	reset_headtail(&r->cons);
+}
+
+/*
+ * helper function, calculates sync_type values for prod and cons
+ * based on input flags. Returns zero at success or negative
+ * errno value otherwise.
+ */
+static int
+get_sync_type(uint32_t flags, enum rte_ring_sync_type *prod_st,
+	enum rte_ring_sync_type *cons_st)
+{
+	static const uint32_t prod_st_flags =
+		(RING_F_SP_ENQ | RING_F_MP_RTS_ENQ | RING_F_MP_HTS_ENQ);
+	static const uint32_t cons_st_flags =
+		(RING_F_SC_DEQ | RING_F_MC_RTS_DEQ | RING_F_MC_HTS_DEQ);
+
+	switch (flags & prod_st_flags) {
+	case 0:
+		*prod_st = RTE_RING_SYNC_MT;
+		break;
+	case RING_F_SP_ENQ:
+		*prod_st = RTE_RING_SYNC_ST;
+		break;
+	case RING_F_MP_RTS_ENQ:
+		*prod_st = RTE_RING_SYNC_MT_RTS;
+		break;
+	case RING_F_MP_HTS_ENQ:
+		*prod_st = RTE_RING_SYNC_MT_HTS;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	switch (flags & cons_st_flags) {
+	case 0:
+		*cons_st = RTE_RING_SYNC_MT;
+		break;
+	case RING_F_SC_DEQ:
+		*cons_st = RTE_RING_SYNC_ST;
+		break;
+	case RING_F_MC_RTS_DEQ:
+		*cons_st = RTE_RING_SYNC_MT_RTS;
+		break;
+	case RING_F_MC_HTS_DEQ:
+		*cons_st = RTE_RING_SYNC_MT_HTS;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
 }
 
 int
@@ -84,14 +169,28 @@ rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
 	RTE_BUILD_BUG_ON((offsetof(struct rte_ring, prod) &
 			  RTE_CACHE_LINE_MASK) != 0);
 
+	/* the sync type and the tail are at the same place in all modes */
+	RTE_BUILD_BUG_ON(offsetof(struct rte_ring_headtail, sync_type) !=
+		offsetof(struct rte_ring_hts_headtail, sync_type));
+	RTE_BUILD_BUG_ON(offsetof(struct rte_ring_headtail, tail) !=
+		offsetof(struct rte_ring_hts_headtail, ht.pos.tail));
+	RTE_BUILD_BUG_ON(offsetof(struct rte_ring_headtail, sync_type) !=
+		offsetof(struct rte_ring_rts_headtail, sync_type));
+	RTE_BUILD_BUG_ON(offsetof(struct rte_ring_headtail, tail) !=
+		offsetof(struct rte_ring_rts_headtail, tail.val.pos));
+
 	/* init the ring structure */
 	memset(r, 0, sizeof(*r));
 	ret = strlcpy(r->name, name, sizeof(r->name));
 	if (ret < 0 || ret >= (int)sizeof(r->name))
 		return -ENAMETOOLONG;
 	r->flags = flags;
-	r->prod.single = (flags & RING_F_SP_ENQ) ? __IS_SP : __IS_MP;
-	r->cons.single = (flags & RING_F_SC_DEQ) ? __IS_SC : __IS_MC;
+	ret = get_sync_type(flags, &r->prod.sync_type, &r->cons.sync_type);
+	if (ret != 0) {
+		RTE_LOG(ERR, RING,
+			"Only one producer and one consumer sync mode can be requested\n");
+		return ret;
+	}
 
 	if (flags & RING_F_EXACT_SZ) {
 		r->size = rte_align32pow2(count + 1);
@@ -108,8 +207,12 @@ rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
 		r->mask = count - 1;
 		r->capacity = r->mask;
 	}
-	r->prod.head = r->cons.head = 0;
-	r->prod.tail = r->cons.tail = 0;
+
+	/* set default values for head-tail distance */
+	if (flags & RING_F_MP_RTS_ENQ)
+		r->rts_prod.htd_max = r->capacity / HTD_MAX_DEF;
+	if (flags & RING_F_MC_RTS_DEQ)
+		r->rts_cons.htd_max = r->capacity / HTD_MAX_DEF;
 
 	return 0;
 }
@@ -164,14 +267,20 @@ rte_ring_create(const char *name, unsigned count, int socket_id,
 					 mz_flags, __alignof__(*r));
 	if (mz != NULL) {
 		r = mz->addr;
-		/* no need to check return value here, we already checked the
-		 * arguments above */
-		rte_ring_init(r, name, requested_count, flags);
+		/* the size was checked above, only the sync flags can fail */
+		ret = rte_ring_init(r, name, requested_count, flags);
+		if (ret != 0) {
+			rte_memzone_free(mz);
+			rte_free(te);
+			rte_mcfg_tailq_write_unlock();
+			rte_errno = -ret;
+			return NULL;
+		}
 
 		te->data = (void *) r;
 		r->memzone = mz;
 
-		TAILQ_INSERT_TAIL(ring_list, te, next);
+		RTE_TAILQ_INSERT_TAIL(ring_list, te, next);
 	} else {
 		r = NULL;
 		RTE_LOG(ERR, RING, "Cannot reserve memory\n");
@@ -211,7 +320,7 @@ rte_ring_free(struct rte_ring *r)
 	rte_mcfg_tailq_write_lock();
 
 	/* find out tailq entry */
-	TAILQ_FOREACH(te, ring_list, next) {
+	RTE_TAILQ_FOREACH(te, ring_list, next) {
 		if (te->data == (void *) r)
 			break;
 	}
@@ -221,13 +330,25 @@ rte_ring_free(struct rte_ring *r)
 		return;
 	}
 
-	TAILQ_REMOVE(ring_list, te, next);
+	RTE_TAILQ_REMOVE(ring_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
 	rte_free(te);
 }
 
+/* return the head of prod/cons, whatever their sync type is */
+static uint32_t
+get_head(const void *p)
+{
+	const struct rte_ring_headtail *ht = p;
+	const struct rte_ring_rts_headtail *ht_rts = p;
+
+	if (ht->sync_type == RTE_RING_SYNC_MT_RTS)
+		return ht_rts->head.val.pos;
+	return ht->head;
+}
+
 /* dump the status of the ring on the console */
 void
 rte_ring_dump(FILE *f, const struct rte_ring *r)
@@ -237,9 +358,11 @@ rte_ring_dump(FILE *f, const struct rte_ring *r)
 	fprintf(f, "  size=%"PRIu32"\n", r->size);
 	fprintf(f, "  capacity=%"PRIu32"\n", r->capacity);
 	fprintf(f, "  ct=%"PRIu32"\n", r->cons.tail);
-	fprintf(f, "  ch=%"PRIu32"\n", r->cons.head);
+	fprintf(f, "  ch=%"PRIu32"\n", get_head(&r->cons));
+	fprintf(f, "  cons_sync=%d\n", r->cons.sync_type);
 	fprintf(f, "  pt=%"PRIu32"\n", r->prod.tail);
-	fprintf(f, "  ph=%"PRIu32"\n", r->prod.head);
+	fprintf(f, "  ph=%"PRIu32"\n", get_head(&r->prod));
+	fprintf(f, "  prod_sync=%d\n", r->prod.sync_type);
 	fprintf(f, "  used=%u\n", rte_ring_count(r));
 	fprintf(f, "  avail=%u\n", rte_ring_free_count(r));
 }
@@ -255,7 +378,7 @@ rte_ring_list_dump(FILE *f)
 
 	rte_mcfg_tailq_read_lock();
 
-	TAILQ_FOREACH(te, ring_list, next) {
+	RTE_TAILQ_FOREACH(te, ring_list, next) {
 		rte_ring_dump(f, (struct rte_ring *) te->data);
 	}
 
@@ -274,7 +397,7 @@ rte_ring_lookup(const char *name)
 
 	rte_mcfg_tailq_read_lock();
 
-	TAILQ_FOREACH(te, ring_list, next) {
+	RTE_TAILQ_FOREACH(te, ring_list, next) {
 		r = (struct rte_ring *) te->data;
 		if (strncmp(name, r->name, RTE_RING_NAMESIZE) == 0)
 			break;
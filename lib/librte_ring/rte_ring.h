@@ -25,10 +25,13 @@
  * - Multi- or single-producer enqueue.
  * - Bulk dequeue.
  * - Bulk enqueue.
+ * - Zero-copy enqueue/dequeue in place of the ring slots.
  *
- * Note: the ring implementation is not preemptible. Refer to Programmer's
- * guide/Environment Abstraction Layer/Multiple pthread/Known Issues/rte_ring
- * for more information.
+ * Note: the default MP/MC ring implementation is not preemptible. Refer to
+ * Programmer's guide/Environment Abstraction Layer/Multiple pthread/Known
+ * Issues/rte_ring for more information. The RTS and HTS sync modes
+ * (see RING_F_MP_RTS_ENQ and RING_F_MP_HTS_ENQ) are more tolerant to
+ * preemption of the ring users.
  *
  */
 
@@ -46,8 +49,10 @@ extern "C" {
 #include <rte_lcore.h>
 #include <rte_atomic.h>
 #include <rte_branch_prediction.h>
+#include <rte_debug.h>
 #include <rte_memzone.h>
 #include <rte_pause.h>
+#include <rte_ring_trace_fp.h>
 
 #define RTE_TAILQ_RING_NAME "RTE_RING"
 
@@ -61,11 +66,62 @@ enum rte_ring_queue_behavior {
 #define RTE_RING_NAMESIZE (RTE_MEMZONE_NAMESIZE - \
 			   sizeof(RTE_RING_MZ_PREFIX) + 1)
 
+/** prod/cons sync types */
+enum rte_ring_sync_type {
+	RTE_RING_SYNC_MT,     /**< multi-thread safe (default mode) */
+	RTE_RING_SYNC_ST,     /**< single thread only */
+	RTE_RING_SYNC_MT_RTS, /**< multi-thread relaxed tail sync */
+	RTE_RING_SYNC_MT_HTS, /**< multi-thread head/tail sync */
+};
+
 /* structure to hold a pair of head/tail values and other metadata */
 struct rte_ring_headtail {
 	volatile uint32_t head;  /**< Prod/consumer head. */
 	volatile uint32_t tail;  /**< Prod/consumer tail. */
-	uint32_t single;         /**< True if single prod/cons */
+	RTE_STD_C11
+	union {
+		/** sync type of prod/cons */
+		enum rte_ring_sync_type sync_type;
+		/** deprecated -  True if single prod/cons */
+		uint32_t single;
+	};
+};
+
+union __rte_ring_rts_poscnt {
+	/** raw 8B value to read/write *cnt* and *pos* as one atomic op */
+	uint64_t raw __rte_aligned(8);
+	struct {
+		uint32_t cnt; /**< head/tail reference counter */
+		uint32_t pos; /**< head/tail position */
+	} val;
+};
+
+/**
+ * Relaxed tail sync (RTS) head/tail: tail is moved by the last of the
+ * concurrent enqueues/dequeues only.
+ */
+struct rte_ring_rts_headtail {
+	volatile union __rte_ring_rts_poscnt tail;
+	enum rte_ring_sync_type sync_type;  /**< sync type of prod/cons */
+	uint32_t htd_max;   /**< max allowed distance between head/tail */
+	volatile union __rte_ring_rts_poscnt head;
+};
+
+union __rte_ring_hts_pos {
+	/** raw 8B value to read/write *head* and *tail* as one atomic op */
+	uint64_t raw __rte_aligned(8);
+	struct {
+		uint32_t head; /**< head position */
+		uint32_t tail; /**< tail position */
+	} pos;
+};
+
+/**
+ * Head/tail sync (HTS) head/tail: both are updated as one 64-bit value.
+ */
+struct rte_ring_hts_headtail {
+	volatile union __rte_ring_hts_pos ht;
+	enum rte_ring_sync_type sync_type;  /**< sync type of prod/cons */
 };
 
 /**
@@ -95,11 +151,23 @@ struct rte_ring {
 	char pad0 __rte_cache_aligned; /**< empty cache line */
 
 	/** Ring producer status. */
-	struct rte_ring_headtail prod __rte_cache_aligned;
+	RTE_STD_C11
+	union {
+		struct rte_ring_headtail prod;
+		struct rte_ring_hts_headtail hts_prod;
+		struct rte_ring_rts_headtail rts_prod;
+	}  __rte_cache_aligned;
+
 	char pad1 __rte_cache_aligned; /**< empty cache line */
 
 	/** Ring consumer status. */
-	struct rte_ring_headtail cons __rte_cache_aligned;
+	RTE_STD_C11
+	union {
+		struct rte_ring_headtail cons;
+		struct rte_ring_hts_headtail hts_cons;
+		struct rte_ring_rts_headtail rts_cons;
+	}  __rte_cache_aligned;
+
 	char pad2 __rte_cache_aligned; /**< empty cache line */
 };
 
@@ -114,6 +182,12 @@ struct rte_ring {
  * ring space will be wasted.
  */
 #define RING_F_EXACT_SZ 0x0004
+
+#define RING_F_MP_RTS_ENQ 0x0008 /**< The default enqueue is "MP RTS". */
+#define RING_F_MC_RTS_DEQ 0x0010 /**< The default dequeue is "MC RTS". */
+
+#define RING_F_MP_HTS_ENQ 0x0020 /**< The default enqueue is "MP HTS". */
+#define RING_F_MC_HTS_DEQ 0x0040 /**< The default dequeue is "MC HTS". */
 #define RTE_RING_SZ_MASK  (0x7fffffffU) /**< Ring size mask */
 
 /* @internal defines for passing to the enqueue dequeue worker functions */
@@ -169,6 +243,25 @@ ssize_t rte_ring_get_memsize(unsigned count);
  *    - RING_F_SC_DEQ: If this flag is set, the default behavior when
  *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
  *      is "single-consumer". Otherwise, it is "multi-consumers".
+ *    - RING_F_MP_RTS_ENQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_enqueue()`` or ``rte_ring_enqueue_bulk()``
+ *      is "multi-producer RTS mode".
+ *    - RING_F_MP_HTS_ENQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_enqueue()`` or ``rte_ring_enqueue_bulk()``
+ *      is "multi-producer HTS mode".
+ *    - RING_F_MC_RTS_DEQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
+ *      is "multi-consumer RTS mode".
+ *    - RING_F_MC_HTS_DEQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
+ *      is "multi-consumer HTS mode".
+ *    At most one of the producer flags (RING_F_SP_ENQ, RING_F_MP_RTS_ENQ,
+ *    RING_F_MP_HTS_ENQ) and one of the consumer flags (RING_F_SC_DEQ,
+ *    RING_F_MC_RTS_DEQ, RING_F_MC_HTS_DEQ) can be set.
+ *    The RTS and HTS modes are meant for the cases where the ring users
+ *    may be preempted, e.g. when there are more lcores than CPUs:
+ *    in the default multi-thread mode a preempted producer (consumer)
+ *    stalls all the others until it gets the CPU back.
  * @return
  *   0 on success, or a negative value on error.
  */
@@ -204,12 +297,32 @@ int rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
  *    - RING_F_SC_DEQ: If this flag is set, the default behavior when
  *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
  *      is "single-consumer". Otherwise, it is "multi-consumers".
+ *    - RING_F_MP_RTS_ENQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_enqueue()`` or ``rte_ring_enqueue_bulk()``
+ *      is "multi-producer RTS mode".
+ *    - RING_F_MP_HTS_ENQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_enqueue()`` or ``rte_ring_enqueue_bulk()``
+ *      is "multi-producer HTS mode".
+ *    - RING_F_MC_RTS_DEQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
+ *      is "multi-consumer RTS mode".
+ *    - RING_F_MC_HTS_DEQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
+ *      is "multi-consumer HTS mode".
+ *    At most one of the producer flags (RING_F_SP_ENQ, RING_F_MP_RTS_ENQ,
+ *    RING_F_MP_HTS_ENQ) and one of the consumer flags (RING_F_SC_DEQ,
+ *    RING_F_MC_RTS_DEQ, RING_F_MC_HTS_DEQ) can be set.
+ *    The RTS and HTS modes are meant for the cases where the ring users
+ *    may be preempted, e.g. when there are more lcores than CPUs:
+ *    in the default multi-thread mode a preempted producer (consumer)
+ *    stalls all the others until it gets the CPU back.
  * @return
  *   On success, the pointer to the new allocated ring. NULL on error with
  *    rte_errno set appropriately. Possible errno values include:
  *    - E_RTE_NO_CONFIG - function could not get pointer to rte_config structure
  *    - E_RTE_SECONDARY - function was called from a secondary process instance
- *    - EINVAL - count provided is not a power of 2
+ *    - EINVAL - count provided is not a power of 2, or conflicting
+ *      sync mode flags
  *    - ENOSPC - the maximum number of memzones has already been allocated
  *    - EEXIST - a memzone with the same name already exists
  *    - ENOMEM - no appropriate memory area found in which to create memzone
@@ -350,6 +463,7 @@ __rte_ring_do_enqueue(struct rte_ring *r, void * const *obj_table,
 end:
 	if (free_space != NULL)
 		*free_space = free_entries - n;
+	rte_ring_trace_enqueue(r, obj_table, n);
 	return n;
 }
 
@@ -393,9 +507,71 @@ __rte_ring_do_dequeue(struct rte_ring *r, void **obj_table,
 end:
 	if (available != NULL)
 		*available = entries - n;
+	rte_ring_trace_dequeue(r, obj_table, n);
 	return n;
 }
 
+#include "rte_ring_hts.h"
+#include "rte_ring_rts.h"
+
+/**
+ * @internal Enqueue several objects on the ring, using the producer
+ * sync mode specified at ring creation time.
+ */
+static __rte_always_inline unsigned int
+__rte_ring_do_enqueue_default(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, enum rte_ring_queue_behavior behavior,
+		unsigned int *free_space)
+{
+	switch (r->prod.sync_type) {
+	case RTE_RING_SYNC_MT:
+		return __rte_ring_do_enqueue(r, obj_table, n, behavior,
+				__IS_MP, free_space);
+	case RTE_RING_SYNC_ST:
+		return __rte_ring_do_enqueue(r, obj_table, n, behavior,
+				__IS_SP, free_space);
+	case RTE_RING_SYNC_MT_RTS:
+		return __rte_ring_do_rts_enqueue(r, obj_table, n, behavior,
+				free_space);
+	case RTE_RING_SYNC_MT_HTS:
+		return __rte_ring_do_hts_enqueue(r, obj_table, n, behavior,
+				free_space);
+	}
+
+	/* valid ring should never reach this point */
+	RTE_ASSERT(0);
+	return 0;
+}
+
+/**
+ * @internal Dequeue several objects from the ring, using the consumer
+ * sync mode specified at ring creation time.
+ */
+static __rte_always_inline unsigned int
+__rte_ring_do_dequeue_default(struct rte_ring *r, void **obj_table,
+		unsigned int n, enum rte_ring_queue_behavior behavior,
+		unsigned int *available)
+{
+	switch (r->cons.sync_type) {
+	case RTE_RING_SYNC_MT:
+		return __rte_ring_do_dequeue(r, obj_table, n, behavior,
+				__IS_MC, available);
+	case RTE_RING_SYNC_ST:
+		return __rte_ring_do_dequeue(r, obj_table, n, behavior,
+				__IS_SC, available);
+	case RTE_RING_SYNC_MT_RTS:
+		return __rte_ring_do_rts_dequeue(r, obj_table, n, behavior,
+				available);
+	case RTE_RING_SYNC_MT_HTS:
+		return __rte_ring_do_hts_dequeue(r, obj_table, n, behavior,
+				available);
+	}
+
+	/* valid ring should never reach this point */
+	RTE_ASSERT(0);
+	return 0;
+}
+
 /**
  * Enqueue several objects on the ring (multi-producers safe).
  *
@@ -468,8 +644,8 @@ static __rte_always_inline unsigned int
 rte_ring_enqueue_bulk(struct rte_ring *r, void * const *obj_table,
 		      unsigned int n, unsigned int *free_space)
 {
-	return __rte_ring_do_enqueue(r, obj_table, n, RTE_RING_QUEUE_FIXED,
-			r->prod.single, free_space);
+	return __rte_ring_do_enqueue_default(r, obj_table, n,
+			RTE_RING_QUEUE_FIXED, free_space);
 }
 
 /**
@@ -603,8 +779,8 @@ static __rte_always_inline unsigned int
 rte_ring_dequeue_bulk(struct rte_ring *r, void **obj_table, unsigned int n,
 		unsigned int *available)
 {
-	return __rte_ring_do_dequeue(r, obj_table, n, RTE_RING_QUEUE_FIXED,
-				r->cons.single, available);
+	return __rte_ring_do_dequeue_default(r, obj_table, n,
+			RTE_RING_QUEUE_FIXED, available);
 }
 
 /**
@@ -776,6 +952,62 @@ rte_ring_get_capacity(const struct rte_ring *r)
 	return r->capacity;
 }
 
+/**
+ * Return sync type used by producer in the ring.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @return
+ *   Producer sync type value.
+ */
+static inline enum rte_ring_sync_type
+rte_ring_get_prod_sync_type(const struct rte_ring *r)
+{
+	return r->prod.sync_type;
+}
+
+/**
+ * Check is the ring for single producer.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @return
+ *   true if ring is SP, zero otherwise.
+ */
+static inline int
+rte_ring_is_prod_single(const struct rte_ring *r)
+{
+	return (rte_ring_get_prod_sync_type(r) == RTE_RING_SYNC_ST);
+}
+
+/**
+ * Return sync type used by consumer in the ring.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @return
+ *   Consumer sync type value.
+ */
+static inline enum rte_ring_sync_type
+rte_ring_get_cons_sync_type(const struct rte_ring *r)
+{
+	return r->cons.sync_type;
+}
+
+/**
+ * Check is the ring for single consumer.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @return
+ *   true if ring is SC, zero otherwise.
+ */
+static inline int
+rte_ring_is_cons_single(const struct rte_ring *r)
+{
+	return (rte_ring_get_cons_sync_type(r) == RTE_RING_SYNC_ST);
+}
+
 /**
  * Dump the status of all rings on the console
  *
@@ -868,8 +1100,8 @@ static __rte_always_inline unsigned
 rte_ring_enqueue_burst(struct rte_ring *r, void * const *obj_table,
 		      unsigned int n, unsigned int *free_space)
 {
-	return __rte_ring_do_enqueue(r, obj_table, n, RTE_RING_QUEUE_VARIABLE,
-			r->prod.single, free_space);
+	return __rte_ring_do_enqueue_default(r, obj_table, n,
+			RTE_RING_QUEUE_VARIABLE, free_space);
 }
 
 /**
@@ -948,9 +1180,349 @@ static __rte_always_inline unsigned
 rte_ring_dequeue_burst(struct rte_ring *r, void **obj_table,
 		unsigned int n, unsigned int *available)
 {
-	return __rte_ring_do_dequeue(r, obj_table, n,
-				RTE_RING_QUEUE_VARIABLE,
-				r->cons.single, available);
+	return __rte_ring_do_dequeue_default(r, obj_table, n,
+			RTE_RING_QUEUE_VARIABLE, available);
+}
+
+/**
+ * Ring zero-copy information structure.
+ *
+ * This structure describes the ring slots reserved by one of the
+ * zero-copy start functions. As the reserved area may wrap around the end
+ * of the ring storage, it is made of up to two contiguous parts.
+ */
+struct rte_ring_zc_data {
+	/** Pointer to the first reserved slot in the ring */
+	void **ptr1;
+	/** Pointer to the second part of the reserved slots if the area
+	 * wraps around the end of the ring, NULL otherwise.
+	 */
+	void **ptr2;
+	/** Number of slots available at ptr1. Subtracting n1 from the
+	 * number of reserved slots gives the number of slots at ptr2.
+	 */
+	unsigned int n1;
+	/** @internal Ring index of the first reserved slot */
+	uint32_t head;
+	/** @internal Number of reserved slots */
+	uint32_t n;
+};
+
+/**
+ * @internal Fill the zero-copy structure for n slots starting at head
+ */
+static __rte_always_inline void
+__rte_ring_get_zc_data(struct rte_ring *r, uint32_t head, unsigned int n,
+		struct rte_ring_zc_data *zcd)
+{
+	void **ring = (void **)&r[1];
+	uint32_t idx = head & r->mask;
+
+	zcd->head = head;
+	zcd->n = n;
+	if (n == 0) {
+		zcd->ptr1 = NULL;
+		zcd->ptr2 = NULL;
+		zcd->n1 = 0;
+	} else if (likely(idx + n <= r->size)) {
+		zcd->ptr1 = &ring[idx];
+		zcd->ptr2 = NULL;
+		zcd->n1 = n;
+	} else {
+		zcd->ptr1 = &ring[idx];
+		zcd->ptr2 = &ring[0];
+		zcd->n1 = r->size - idx;
+	}
+}
+
+/**
+ * @internal Reserve slots on the ring for a zero-copy enqueue
+ */
+static __rte_always_inline unsigned int
+__rte_ring_do_enqueue_zc_start(struct rte_ring *r, unsigned int n,
+		enum rte_ring_queue_behavior behavior,
+		struct rte_ring_zc_data *zcd, unsigned int *free_space)
+{
+	uint32_t prod_head, prod_next;
+	uint32_t free_entries;
+
+	switch (r->prod.sync_type) {
+	case RTE_RING_SYNC_MT_RTS:
+		n = __rte_ring_rts_move_prod_head(r, n, behavior,
+				&prod_head, &free_entries);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		n = __rte_ring_hts_move_prod_head(r, n, behavior,
+				&prod_head, &free_entries);
+		break;
+	default:
+		n = __rte_ring_move_prod_head(r,
+				r->prod.sync_type == RTE_RING_SYNC_ST, n,
+				behavior, &prod_head, &prod_next,
+				&free_entries);
+		break;
+	}
+	__rte_ring_get_zc_data(r, prod_head, n, zcd);
+
+	if (free_space != NULL)
+		*free_space = free_entries - n;
+	return n;
+}
+
+/**
+ * @internal Reserve objects on the ring for a zero-copy dequeue
+ */
+static __rte_always_inline unsigned int
+__rte_ring_do_dequeue_zc_start(struct rte_ring *r, unsigned int n,
+		enum rte_ring_queue_behavior behavior,
+		struct rte_ring_zc_data *zcd, unsigned int *available)
+{
+	uint32_t cons_head, cons_next;
+	uint32_t entries;
+
+	switch (r->cons.sync_type) {
+	case RTE_RING_SYNC_MT_RTS:
+		n = __rte_ring_rts_move_cons_head(r, n, behavior,
+				&cons_head, &entries);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		n = __rte_ring_hts_move_cons_head(r, n, behavior,
+				&cons_head, &entries);
+		break;
+	default:
+		n = __rte_ring_move_cons_head(r,
+				r->cons.sync_type == RTE_RING_SYNC_ST, n,
+				behavior, &cons_head, &cons_next, &entries);
+		break;
+	}
+	__rte_ring_get_zc_data(r, cons_head, n, zcd);
+
+	if (available != NULL)
+		*available = entries - n;
+	return n;
+}
+
+/**
+ * Start to enqueue several objects on the ring without copying them.
+ *
+ * Reserve exactly n slots on the ring, or none of them, and return their
+ * location in *zcd*. The caller writes the object pointers directly into
+ * the reserved slots and then calls rte_ring_enqueue_zc_finish() to make
+ * them visible to the consumers. This avoids staging the objects in an
+ * intermediate array, e.g. rte_eth_rx_burst() can fill the ring directly.
+ *
+ * This function calls the multi-producer or the single-producer
+ * version depending on the default behavior that was specified at
+ * ring creation time (see flags).
+ *
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The number of slots to reserve in the ring.
+ * @param zcd
+ *   Structure filled with the location of the reserved slots.
+ * @param free_space
+ *   if non-NULL, returns the amount of space in the ring after the
+ *   reservation operation has finished.
+ * @return
+ *   The number of slots reserved, either 0 or n
+ */
+__rte_experimental
+static __rte_always_inline unsigned int
+rte_ring_enqueue_zc_bulk_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_zc_start(r, n, RTE_RING_QUEUE_FIXED,
+			zcd, free_space);
+}
+
+/**
+ * Start to enqueue up to n objects on the ring without copying them.
+ *
+ * Same as rte_ring_enqueue_zc_bulk_start(), but reserves as many slots
+ * as are available, up to n.
+ *
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The maximum number of slots to reserve in the ring.
+ * @param zcd
+ *   Structure filled with the location of the reserved slots.
+ * @param free_space
+ *   if non-NULL, returns the amount of space in the ring after the
+ *   reservation operation has finished.
+ * @return
+ *   - n: Actual number of slots reserved.
+ */
+__rte_experimental
+static __rte_always_inline unsigned int
+rte_ring_enqueue_zc_burst_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_zc_start(r, n, RTE_RING_QUEUE_VARIABLE,
+			zcd, free_space);
+}
+
+/**
+ * Complete a zero-copy enqueue started with
+ * rte_ring_enqueue_zc_bulk_start() or rte_ring_enqueue_zc_burst_start().
+ *
+ * On a single-producer or HTS ring, fewer objects than reserved may be
+ * committed: the remaining slots are given back to the ring. On the other
+ * multi-producer rings the following producers may already own the slots
+ * after ours, so all the reserved slots must be filled and committed.
+ *
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param zcd
+ *   The structure filled by the start function.
+ * @param n
+ *   The number of objects written to the reserved slots.
+ */
+__rte_experimental
+static __rte_always_inline void
+rte_ring_enqueue_zc_finish(struct rte_ring *r,
+		const struct rte_ring_zc_data *zcd, unsigned int n)
+{
+	if (zcd->n == 0)
+		return;
+
+	switch (r->prod.sync_type) {
+	case RTE_RING_SYNC_ST:
+		RTE_ASSERT(n <= zcd->n);
+		r->prod.head = zcd->head + n;
+		update_tail(&r->prod, zcd->head, zcd->head + n, __IS_SP, 1);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		RTE_ASSERT(n <= zcd->n);
+		__rte_ring_hts_set_head_tail(&r->hts_prod, zcd->head, n, 1);
+		break;
+	case RTE_RING_SYNC_MT_RTS:
+		RTE_ASSERT(n == zcd->n);
+		__rte_ring_rts_update_tail(&r->rts_prod);
+		break;
+	default:
+		RTE_ASSERT(n == zcd->n);
+		update_tail(&r->prod, zcd->head, zcd->head + n, __IS_MP, 1);
+		break;
+	}
+}
+
+/**
+ * Start to dequeue several objects from the ring without copying them.
+ *
+ * Reserve exactly n objects on the ring, or none of them, and return their
+ * location in *zcd*. The caller reads the object pointers directly from
+ * the ring and then calls rte_ring_dequeue_zc_finish() to give the slots
+ * back to the producers.
+ *
+ * This function calls the multi-consumers or the single-consumer
+ * version depending on the default behavior that was specified at
+ * ring creation time (see flags).
+ *
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The number of objects to reserve in the ring.
+ * @param zcd
+ *   Structure filled with the location of the reserved objects.
+ * @param available
+ *   If non-NULL, returns the number of remaining ring entries after the
+ *   reservation has finished.
+ * @return
+ *   The number of objects reserved, either 0 or n
+ */
+__rte_experimental
+static __rte_always_inline unsigned int
+rte_ring_dequeue_zc_bulk_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_zc_start(r, n, RTE_RING_QUEUE_FIXED,
+			zcd, available);
+}
+
+/**
+ * Start to dequeue up to n objects from the ring without copying them.
+ *
+ * Same as rte_ring_dequeue_zc_bulk_start(), but reserves as many objects
+ * as are available, up to n.
+ *
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The maximum number of objects to reserve in the ring.
+ * @param zcd
+ *   Structure filled with the location of the reserved objects.
+ * @param available
+ *   If non-NULL, returns the number of remaining ring entries after the
+ *   reservation has finished.
+ * @return
+ *   - n: Actual number of objects reserved, 0 if ring is empty
+ */
+__rte_experimental
+static __rte_always_inline unsigned int
+rte_ring_dequeue_zc_burst_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_zc_start(r, n, RTE_RING_QUEUE_VARIABLE,
+			zcd, available);
+}
+
+/**
+ * Complete a zero-copy dequeue started with
+ * rte_ring_dequeue_zc_bulk_start() or rte_ring_dequeue_zc_burst_start().
+ *
+ * On a single-consumer or HTS ring, fewer objects than reserved may be
+ * consumed: the remaining ones stay in the ring, so finishing with n = 0
+ * turns the operation into a peek. On the other multi-consumer rings all
+ * the reserved objects must be consumed.
+ *
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param zcd
+ *   The structure filled by the start function.
+ * @param n
+ *   The number of objects consumed from the reserved slots.
+ */
+__rte_experimental
+static __rte_always_inline void
+rte_ring_dequeue_zc_finish(struct rte_ring *r,
+		const struct rte_ring_zc_data *zcd, unsigned int n)
+{
+	if (zcd->n == 0)
+		return;
+
+	switch (r->cons.sync_type) {
+	case RTE_RING_SYNC_ST:
+		RTE_ASSERT(n <= zcd->n);
+		r->cons.head = zcd->head + n;
+		update_tail(&r->cons, zcd->head, zcd->head + n, __IS_SC, 0);
+		break;
+	case RTE_RING_SYNC_MT_HTS:
+		RTE_ASSERT(n <= zcd->n);
+		__rte_ring_hts_set_head_tail(&r->hts_cons, zcd->head, n, 0);
+		break;
+	case RTE_RING_SYNC_MT_RTS:
+		RTE_ASSERT(n == zcd->n);
+		__rte_ring_rts_update_tail(&r->rts_cons);
+		break;
+	default:
+		RTE_ASSERT(n == zcd->n);
+		update_tail(&r->cons, zcd->head, zcd->head + n, __IS_MC, 0);
+		break;
+	}
 }
 
 #ifdef __cplusplus
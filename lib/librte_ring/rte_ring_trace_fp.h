@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#ifndef _RTE_RING_TRACE_FP_H_
+#define _RTE_RING_TRACE_FP_H_
+
+/**
+ * @file
+ *
+ * API for ring fast path trace support
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rte_trace_point.h>
+
+RTE_TRACE_POINT_FP(
+	rte_ring_trace_enqueue,
+	RTE_TRACE_POINT_ARGS(const void *r, void * const *obj_table,
+		unsigned int n),
+	rte_trace_point_emit_ptr(r);
+	rte_trace_point_emit_ptr(obj_table);
+	rte_trace_point_emit_u32(n);
+)
+
+RTE_TRACE_POINT_FP(
+	rte_ring_trace_dequeue,
+	RTE_TRACE_POINT_ARGS(const void *r, void * const *obj_table,
+		unsigned int n),
+	rte_trace_point_emit_ptr(r);
+	rte_trace_point_emit_ptr(obj_table);
+	rte_trace_point_emit_u32(n);
+)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_RING_TRACE_FP_H_ */
@@ -0,0 +1,12 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Marvell International Ltd.
+ */
+
+#include <rte_trace_point_register.h>
+
+#include <rte_ring_trace_fp.h>
+
+RTE_TRACE_POINT_REGISTER(rte_ring_trace_enqueue,
+	lib.ring.enqueue)
+RTE_TRACE_POINT_REGISTER(rte_ring_trace_dequeue,
+	lib.ring.dequeue)
@@ -118,7 +118,7 @@ rte_stack_create(const char *name, unsigned int count, int socket_id,
 
 	stack_list = RTE_TAILQ_CAST(rte_stack_tailq.head, rte_stack_list);
 
-	TAILQ_INSERT_TAIL(stack_list, te, next);
+	RTE_TAILQ_INSERT_TAIL(stack_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
@@ -138,7 +138,7 @@ rte_stack_free(struct rte_stack *s)
 	rte_mcfg_tailq_write_lock();
 
 	/* find out tailq entry */
-	TAILQ_FOREACH(te, stack_list, next) {
+	RTE_TAILQ_FOREACH(te, stack_list, next) {
 		if (te->data == s)
 			break;
 	}
@@ -148,7 +148,7 @@ rte_stack_free(struct rte_stack *s)
 		return;
 	}
 
-	TAILQ_REMOVE(stack_list, te, next);
+	RTE_TAILQ_REMOVE(stack_list, te, next);
 
 	rte_mcfg_tailq_write_unlock();
 
@@ -173,7 +173,7 @@ rte_stack_lookup(const char *name)
 
 	rte_mcfg_tailq_read_lock();
 
-	TAILQ_FOREACH(te, stack_list, next) {
+	RTE_TAILQ_FOREACH(te, stack_list, next) {
 		r = (struct rte_stack *) te->data;
 		if (strncmp(name, r->name, RTE_STACK_NAMESIZE) == 0)
 			break;